@@ -1,4 +1,19 @@
 @echo off
 
 c:\VulkanSDK\1.2.170.0\Bin32\glslc.exe triangle.frag -o frag.spv
-c:\VulkanSDK\1.2.170.0\Bin32\glslc.exe triangle.vert -o vert.spv
\ No newline at end of file
+c:\VulkanSDK\1.2.170.0\Bin32\glslc.exe triangle.vert -o vert.spv
+c:\VulkanSDK\1.2.170.0\Bin32\glslc.exe gbuffer.vert -o gbuffer_vert.spv
+c:\VulkanSDK\1.2.170.0\Bin32\glslc.exe gbuffer.frag -o gbuffer_frag.spv
+c:\VulkanSDK\1.2.170.0\Bin32\glslc.exe fullscreen.vert -o fullscreen_vert.spv
+c:\VulkanSDK\1.2.170.0\Bin32\glslc.exe deferred_lighting.frag -o deferred_lighting_frag.spv
+c:\VulkanSDK\1.2.170.0\Bin32\glslc.exe skinning.comp -o skinning_comp.spv
+c:\VulkanSDK\1.2.170.0\Bin32\glslc.exe particle_control.comp -o particle_control_comp.spv
+c:\VulkanSDK\1.2.170.0\Bin32\glslc.exe particle_emit.comp -o particle_emit_comp.spv
+c:\VulkanSDK\1.2.170.0\Bin32\glslc.exe particle_simulate.comp -o particle_simulate_comp.spv
+c:\VulkanSDK\1.2.170.0\Bin32\glslc.exe particle_sort.comp -o particle_sort_comp.spv
+c:\VulkanSDK\1.2.170.0\Bin32\glslc.exe particle.vert -o particle_vert.spv
+c:\VulkanSDK\1.2.170.0\Bin32\glslc.exe particle.frag -o particle_frag.spv
+c:\VulkanSDK\1.2.170.0\Bin32\glslc.exe impostor.vert -o impostor_vert.spv
+c:\VulkanSDK\1.2.170.0\Bin32\glslc.exe impostor.frag -o impostor_frag.spv
+c:\VulkanSDK\1.2.170.0\Bin32\glslc.exe hud.vert -o hud_vert.spv
+c:\VulkanSDK\1.2.170.0\Bin32\glslc.exe hud.frag -o hud_frag.spv
\ No newline at end of file
@@ -0,0 +1,28 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive : require
+
+#include "irradiance.glsl"
+
+layout(input_attachment_index = 0, binding = 0) uniform subpassInput inAlbedo;
+layout(input_attachment_index = 1, binding = 1) uniform subpassInput inNormal;
+
+layout(std140, binding = 2) uniform Environment {
+    vec4 irradiance[9];
+};
+
+layout(location = 0) out vec4 outColor;
+
+const vec3 LIGHT_DIR = normalize(vec3(1.0, 1.0, 2.0));
+const float AMBIENT = 0.3;
+
+void main() {
+    vec3 albedo = subpassLoad(inAlbedo).rgb;
+    vec4 packedNormal = subpassLoad(inNormal);
+    vec3 normal = normalize(packedNormal.xyz * 2.0 - 1.0);
+
+    // unlit materials and the cleared background keep their albedo
+    float diffuse = max(dot(normal, LIGHT_DIR), 0.0);
+    vec3 lighting = mix(vec3(1.0), evaluateIrradiance(irradiance, normal) + (1.0 - AMBIENT) * diffuse, packedNormal.w);
+    outColor = vec4(albedo * lighting, 1.0);
+}
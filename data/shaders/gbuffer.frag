@@ -0,0 +1,55 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+const uint SHADING_MODEL_UNLIT = 0u;
+const uint SHADING_MODEL_LAMBERT = 1u;
+const uint SHADING_MODEL_LIGHTMAPPED = 2u;
+
+// the pipeline of every shading model is specialized from this shader, the texture table is sized to the device
+layout(constant_id = 0) const uint SHADING_MODEL = SHADING_MODEL_LAMBERT;
+layout(constant_id = 1) const uint TEXTURE_COUNT = 1u;
+
+struct Material {
+    vec4 baseColor;
+    uint baseColorTexture;
+    uint shadingModel;
+    uint lightmapTexture;
+    uint padding;
+};
+
+layout(std430, binding = 2) readonly buffer Materials {
+    Material materials[];
+};
+
+layout(binding = 1) uniform sampler2D textures[TEXTURE_COUNT];
+
+// the lightmap baker divides irradiance / pi by this before encoding it
+const float LIGHTMAP_RANGE = 2.0;
+
+layout(location = 0) flat in uint fragMaterial;
+layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) in vec3 fragWorldPos;
+layout(location = 3) flat in uint fragObjectId;
+layout(location = 4) flat in uint fragTriangle;
+
+layout(location = 0) out vec4 outAlbedo;
+layout(location = 1) out vec4 outNormal;
+layout(location = 2) out uvec2 outObjectId;
+
+void main() {
+    Material material = materials[fragMaterial];
+
+    // the vertex format has no normals, derive the face normal from the position derivatives
+    vec3 normal = normalize(cross(dFdx(fragWorldPos), dFdy(fragWorldPos)));
+
+    vec3 albedo = material.baseColor.rgb * texture(textures[material.baseColorTexture], fragTexCoord).rgb;
+    if (SHADING_MODEL == SHADING_MODEL_LIGHTMAPPED) {
+        // lit already, the lighting pass passes it through like an unlit pixel
+        albedo *= texture(textures[material.lightmapTexture], fragTexCoord).rgb * LIGHTMAP_RANGE;
+    }
+
+    outAlbedo = vec4(albedo, 1.0);
+    // w tells the lighting pass whether to light the pixel at all
+    outNormal = vec4(normal * 0.5 + 0.5, SHADING_MODEL == SHADING_MODEL_LAMBERT ? 1.0 : 0.0);
+    outObjectId = uvec2(fragObjectId, fragTriangle);
+}
@@ -0,0 +1,33 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+// material index per object id, looked up once per vertex instead of once per fragment
+layout(std430, binding = 3) readonly buffer ObjectMaterials {
+    uint objectMaterials[];
+};
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec2 inTexCoord;
+
+layout(location = 0) flat out uint fragMaterial;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) out vec3 fragWorldPos;
+layout(location = 3) flat out uint fragObjectId;
+layout(location = 4) flat out uint fragTriangle;
+
+void main() {
+    vec4 worldPos = ubo.model * vec4(inPosition, 1.0);
+    gl_Position = ubo.proj * ubo.view * worldPos;
+    fragMaterial = objectMaterials[gl_InstanceIndex];
+    fragTexCoord = inTexCoord;
+    fragWorldPos = worldPos.xyz;
+    // the scene is drawn with its object id as first instance, the index buffer holds no shared vertices
+    fragObjectId = uint(gl_InstanceIndex);
+    fragTriangle = uint(gl_VertexIndex) / 3u;
+}
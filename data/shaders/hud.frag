@@ -0,0 +1,22 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(binding = 0) uniform sampler2D fontAtlas;
+
+layout(location = 0) in vec2 fragTexCoord;
+layout(location = 1) in vec4 fragColor;
+
+// the id attachment, when there is one, is masked off by the pipeline
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    // 0.5 is the outline, smoothed over about a pixel whatever the scale of the glyph. Rectangles sample a texel deep
+    // inside, so they come out solid
+    float distance = texture(fontAtlas, fragTexCoord).r;
+    float width = max(fwidth(distance) * 0.5, 1e-4);
+    float coverage = smoothstep(0.5 - width, 0.5 + width, distance);
+
+    // premultiplied for the blend state
+    float alpha = fragColor.a * coverage;
+    outColor = vec4(fragColor.rgb * alpha, alpha);
+}
@@ -0,0 +1,18 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec2 inTexCoord;
+layout(location = 2) in vec4 inColor;
+
+layout(location = 0) out vec2 fragTexCoord;
+layout(location = 1) out vec4 fragColor;
+
+void main() {
+    // already in clip space, written by the cpu every frame
+    gl_Position = vec4(inPosition, 0.0, 1.0);
+
+    // the colors are picked in srgb, the swap chain converts back
+    fragTexCoord = inTexCoord;
+    fragColor = vec4(pow(inColor.rgb, vec3(2.2)), inColor.a);
+}
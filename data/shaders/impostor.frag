@@ -0,0 +1,34 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(binding = 1) uniform sampler2D albedoAtlas;
+layout(binding = 2) uniform sampler2D normalAtlas;
+
+layout(location = 0) in vec2 fragTexCoord;
+layout(location = 1) flat in uint fragObjectId;
+layout(location = 2) flat in mat3 fragNormalMatrix;
+
+layout(location = 0) out vec4 outColor;
+layout(location = 1) out uvec2 outObjectId;
+
+// coverage below this is outside the silhouette, the mips average it so distant copies keep their outline
+const float ALPHA_THRESHOLD = 0.5;
+
+// the light of the scene shaders, so near and far copies shade alike
+const vec3 LIGHT_DIR = normalize(vec3(1.0, 1.0, 2.0));
+const float AMBIENT = 0.3;
+
+void main() {
+    vec4 albedo = texture(albedoAtlas, fragTexCoord);
+    if (albedo.a < ALPHA_THRESHOLD) {
+        discard;
+    }
+
+    // baked in mesh space, turned with the copy and the scene
+    vec3 normal = normalize(fragNormalMatrix * (texture(normalAtlas, fragTexCoord).xyz * 2.0 - 1.0));
+    float diffuse = max(dot(normal, LIGHT_DIR), 0.0);
+
+    outColor = vec4(albedo.rgb * (AMBIENT + (1.0 - AMBIENT) * diffuse), 1.0);
+    // an impostor has no triangles to pick
+    outObjectId = uvec2(fragObjectId, 0u);
+}
@@ -0,0 +1,78 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// views per side of the atlas, specialized from the baked atlas
+layout(constant_id = 0) const uint FRAMES_PER_SIDE = 8u;
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+// one instance per copy, xyz of the first input is the center of its bounding sphere and w the radius
+layout(location = 0) in vec4 inCenterRadius;
+layout(location = 1) in float inYaw;
+layout(location = 2) in uint inObjectId;
+
+layout(location = 0) out vec2 fragTexCoord;
+layout(location = 1) flat out uint fragObjectId;
+layout(location = 2) flat out mat3 fragNormalMatrix;
+
+// two triangles per copy, no vertex buffer
+const vec2 CORNERS[6] = vec2[](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+                               vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
+
+// ImpostorBaker::getViewBasis swaps the up axis this close to the poles
+const float POLE_THRESHOLD = 0.999;
+
+// the same octahedral map as ImpostorBaker::encodeOctahedral and decodeOctahedral
+vec2 encodeOctahedral(vec3 direction) {
+    vec3 octahedron = direction / (abs(direction.x) + abs(direction.y) + abs(direction.z));
+    vec2 coord = octahedron.xy;
+    if (octahedron.z < 0.0) {
+        coord = (1.0 - abs(coord.yx)) * vec2(coord.x >= 0.0 ? 1.0 : -1.0, coord.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return coord * 0.5 + 0.5;
+}
+
+vec3 decodeOctahedral(vec2 coord) {
+    vec2 folded = coord * 2.0 - 1.0;
+    vec3 direction = vec3(folded, 1.0 - abs(folded.x) - abs(folded.y));
+    float unfold = max(-direction.z, 0.0);
+    direction.x += direction.x >= 0.0 ? -unfold : unfold;
+    direction.y += direction.y >= 0.0 ? -unfold : unfold;
+    return normalize(direction);
+}
+
+void main() {
+    vec3 center = inCenterRadius.xyz;
+    float radius = inCenterRadius.w;
+
+    // the atlas was baked around the mesh before the copy was turned, so the eye is turned back into that space
+    float cosYaw = cos(inYaw);
+    float sinYaw = sin(inYaw);
+    mat3 yaw = mat3(cosYaw, sinYaw, 0.0, -sinYaw, cosYaw, 0.0, 0.0, 0.0, 1.0);
+
+    // the copies live in the space of the scene model matrix, like the eye taken out of the inverse view
+    vec3 eye = inverse(ubo.view * ubo.model)[3].xyz;
+    vec3 direction = transpose(yaw) * normalize(eye - center);
+
+    // the baked view closest to the direction the copy is seen from
+    uvec2 frame = min(uvec2(encodeOctahedral(direction) * float(FRAMES_PER_SIDE)), uvec2(FRAMES_PER_SIDE - 1u));
+    vec3 frameDirection = decodeOctahedral((vec2(frame) + 0.5) / float(FRAMES_PER_SIDE));
+
+    vec3 worldUp = abs(frameDirection.z) > POLE_THRESHOLD ? vec3(1.0, 0.0, 0.0) : vec3(0.0, 0.0, 1.0);
+    vec3 right = normalize(cross(worldUp, frameDirection));
+    vec3 up = cross(frameDirection, right);
+
+    // the quad covers the bounding sphere in the plane of that view, so the silhouette lands where it was baked
+    vec2 corner = CORNERS[gl_VertexIndex];
+    vec3 position = center + yaw * (corner.x * right + corner.y * up) * radius;
+    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(position, 1.0);
+
+    // rows of a view grow downwards while its up axis points up
+    fragTexCoord = (vec2(frame) + vec2(corner.x, -corner.y) * 0.5 + 0.5) / float(FRAMES_PER_SIDE);
+    fragObjectId = inObjectId;
+    fragNormalMatrix = mat3(ubo.model) * yaw;
+}
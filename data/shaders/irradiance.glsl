@@ -0,0 +1,16 @@
+// shared by the lit shaders, the coefficients match EnvironmentUniforms
+
+// irradiance / pi arriving at a surface facing normal, the l2 spherical harmonics come with the cosine convolution and
+// the basis constants already folded in
+vec3 evaluateIrradiance(vec4 coefficients[9], vec3 normal) {
+    vec3 irradiance = coefficients[0].rgb
+        + coefficients[1].rgb * normal.y
+        + coefficients[2].rgb * normal.z
+        + coefficients[3].rgb * normal.x
+        + coefficients[4].rgb * (normal.x * normal.y)
+        + coefficients[5].rgb * (normal.y * normal.z)
+        + coefficients[6].rgb * (3.0 * normal.z * normal.z - 1.0)
+        + coefficients[7].rgb * (normal.x * normal.z)
+        + coefficients[8].rgb * (normal.x * normal.x - normal.y * normal.y);
+    return max(irradiance, vec3(0.0));
+}
@@ -0,0 +1,19 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec2 fragCorner;
+layout(location = 1) in vec4 fragColor;
+
+// the id attachment, when there is one, is masked off by the pipeline
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    // soft round sprite, premultiplied for the blend state
+    float falloff = 1.0 - dot(fragCorner, fragCorner);
+    if (falloff <= 0.0) {
+        discard;
+    }
+
+    float alpha = fragColor.a * falloff * falloff;
+    outColor = vec4(fragColor.rgb * alpha, alpha);
+}
@@ -0,0 +1,27 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive : require
+
+#include "particle_common.glsl"
+
+layout(location = 0) out vec2 fragCorner;
+layout(location = 1) out vec4 fragColor;
+
+// two triangles per particle, no vertex buffer
+const vec2 CORNERS[6] = vec2[](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+                               vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
+
+void main() {
+    // instances come in sorted order, the pair points at the particle
+    Particle particle = particles[sortPairs[gl_InstanceIndex].y];
+    float age = clamp(particle.positionAge.w / particle.velocityLifetime.w, 0.0, 1.0);
+
+    // expanded in view space so the quad always faces the camera
+    vec2 corner = CORNERS[gl_VertexIndex];
+    vec4 viewPos = params.view * vec4(particle.positionAge.xyz, 1.0);
+    viewPos.xy += corner * params.particleSize * (1.0 - 0.5 * age);
+    gl_Position = params.proj * viewPos;
+
+    fragCorner = corner;
+    fragColor = mix(params.startColor, params.endColor, age);
+}
@@ -0,0 +1,54 @@
+// shared by the particle shaders, the blocks match ParticleFrameParams and ParticleCounters
+
+struct Particle {
+    vec4 positionAge;      // age in seconds
+    vec4 velocityLifetime; // dies once the age reaches the lifetime
+};
+
+layout(std140, binding = 0) uniform FrameParams {
+    mat4 view;
+    mat4 proj;
+    vec4 emitterPosition; // w is the spawn radius
+    vec4 gravity;         // w is the drag per second
+    vec4 startColor;
+    vec4 endColor;
+    float deltaTime;
+    uint emitCount;
+    uint seed;
+    float particleSize;
+    float emitSpeed;
+    float minLifetime;
+    float maxLifetime;
+    uint capacity;
+} params;
+
+layout(std430, binding = 1) buffer Particles {
+    Particle particles[];
+};
+
+// two lists of capacity slots, counters.current selects the one holding the particles of the last frame
+layout(std430, binding = 2) buffer AliveLists {
+    uint aliveList[];
+};
+
+layout(std430, binding = 3) buffer DeadList {
+    uint deadList[];
+};
+
+layout(std430, binding = 4) buffer Counters {
+    uint aliveCount[2];
+    uint deadCount;
+    uint current;
+    uint spawnedCount; // slots handed out so far, the dead list only holds returned ones
+    uint emitCount;
+    uint emitFromDead;
+    uint padding0;
+    uvec4 emitDispatch;
+    uvec4 simulateDispatch;
+    uvec4 drawArgs;
+} counters;
+
+// sort key and particle slot, the first alive count entries are drawn in order
+layout(std430, binding = 5) buffer SortPairs {
+    uvec2 sortPairs[];
+};
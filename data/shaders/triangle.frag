@@ -1,12 +1,65 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive : require
 
-layout(location = 0) in vec3 fragColor;
+#include "irradiance.glsl"
+
+const uint SHADING_MODEL_UNLIT = 0u;
+const uint SHADING_MODEL_LAMBERT = 1u;
+const uint SHADING_MODEL_LIGHTMAPPED = 2u;
+
+// the pipeline of every shading model is specialized from this shader, the texture table is sized to the device
+layout(constant_id = 0) const uint SHADING_MODEL = SHADING_MODEL_UNLIT;
+layout(constant_id = 1) const uint TEXTURE_COUNT = 1u;
+
+struct Material {
+    vec4 baseColor;
+    uint baseColorTexture;
+    uint shadingModel;
+    uint lightmapTexture;
+    uint padding;
+};
+
+layout(std430, binding = 2) readonly buffer Materials {
+    Material materials[];
+};
+
+layout(binding = 1) uniform sampler2D textures[TEXTURE_COUNT];
+
+// the ambient term, a constant until the environment is loaded
+layout(std140, binding = 4) uniform Environment {
+    vec4 irradiance[9];
+};
+
+// the lightmap baker divides irradiance / pi by this before encoding it
+const float LIGHTMAP_RANGE = 2.0;
+
+layout(location = 0) flat in uint fragMaterial;
 layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) in vec3 fragWorldPos;
+layout(location = 3) flat in uint fragObjectId;
+layout(location = 4) flat in uint fragTriangle;
 
 layout(location = 0) out vec4 outColor;
-layout(binding = 1) uniform sampler2D texSampler;
+layout(location = 1) out uvec2 outObjectId;
+
+const vec3 LIGHT_DIR = normalize(vec3(1.0, 1.0, 2.0));
+const float AMBIENT = 0.3;
 
 void main() {
-    outColor = vec4(fragColor * texture(texSampler, fragTexCoord).rgb, 1.0);
+    Material material = materials[fragMaterial];
+    vec3 color = material.baseColor.rgb * texture(textures[material.baseColorTexture], fragTexCoord).rgb;
+
+    if (SHADING_MODEL == SHADING_MODEL_LAMBERT) {
+        // the vertex format has no normals, derive the face normal from the position derivatives
+        vec3 normal = normalize(cross(dFdx(fragWorldPos), dFdy(fragWorldPos)));
+        float diffuse = max(dot(normal, LIGHT_DIR), 0.0);
+        color *= evaluateIrradiance(irradiance, normal) + (1.0 - AMBIENT) * diffuse;
+    }
+    else if (SHADING_MODEL == SHADING_MODEL_LIGHTMAPPED) {
+        color *= texture(textures[material.lightmapTexture], fragTexCoord).rgb * LIGHTMAP_RANGE;
+    }
+
+    outColor = vec4(color, 1.0);
+    outObjectId = uvec2(fragObjectId, fragTriangle);
 }
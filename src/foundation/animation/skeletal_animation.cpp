@@ -0,0 +1,180 @@
+#include "foundation/animation/skeletal_animation.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define ANIMATION_SSE 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define ANIMATION_NEON 1
+#endif
+
+namespace
+{
+// instances evaluated by one job, a skeleton is small so a single instance is not worth a chunk of its own
+constexpr uint32_t INSTANCE_CHUNK_SIZE = 16;
+
+glm::mat4 composeMatrix(const JointPose& pose)
+{
+    glm::mat4 matrix = glm::mat4_cast(pose.rotation);
+    matrix[0] *= pose.scale.x;
+    matrix[1] *= pose.scale.y;
+    matrix[2] *= pose.scale.z;
+    matrix[3] = glm::vec4(pose.translation, 1.0F);
+    return matrix;
+}
+
+// column major a * b, the hot loop of the hierarchy walk
+void multiplyMatrices(const glm::mat4& a, const glm::mat4& b, glm::mat4& result)
+{
+#if defined(ANIMATION_SSE)
+    const __m128 a0 = _mm_loadu_ps(&a[0][0]);
+    const __m128 a1 = _mm_loadu_ps(&a[1][0]);
+    const __m128 a2 = _mm_loadu_ps(&a[2][0]);
+    const __m128 a3 = _mm_loadu_ps(&a[3][0]);
+
+    for (int column = 0; column < 4; column++)
+    {
+        const __m128 x = _mm_set1_ps(b[column][0]);
+        const __m128 y = _mm_set1_ps(b[column][1]);
+        const __m128 z = _mm_set1_ps(b[column][2]);
+        const __m128 w = _mm_set1_ps(b[column][3]);
+
+        const __m128 sum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, x), _mm_mul_ps(a1, y)),
+                                      _mm_add_ps(_mm_mul_ps(a2, z), _mm_mul_ps(a3, w)));
+        _mm_storeu_ps(&result[column][0], sum);
+    }
+#elif defined(ANIMATION_NEON)
+    const float32x4_t a0 = vld1q_f32(&a[0][0]);
+    const float32x4_t a1 = vld1q_f32(&a[1][0]);
+    const float32x4_t a2 = vld1q_f32(&a[2][0]);
+    const float32x4_t a3 = vld1q_f32(&a[3][0]);
+
+    for (int column = 0; column < 4; column++)
+    {
+        float32x4_t sum = vmulq_n_f32(a0, b[column][0]);
+        sum             = vmlaq_n_f32(sum, a1, b[column][1]);
+        sum             = vmlaq_n_f32(sum, a2, b[column][2]);
+        sum             = vmlaq_n_f32(sum, a3, b[column][3]);
+        vst1q_f32(&result[column][0], sum);
+    }
+#else
+    result = a * b;
+#endif
+}
+
+// the first three rows of a column major matrix
+void storeRows(const glm::mat4& matrix, SkinningMatrix& skinningMatrix)
+{
+#if defined(ANIMATION_SSE)
+    __m128 column0 = _mm_loadu_ps(&matrix[0][0]);
+    __m128 column1 = _mm_loadu_ps(&matrix[1][0]);
+    __m128 column2 = _mm_loadu_ps(&matrix[2][0]);
+    __m128 column3 = _mm_loadu_ps(&matrix[3][0]);
+    _MM_TRANSPOSE4_PS(column0, column1, column2, column3);
+
+    _mm_storeu_ps(&skinningMatrix.rows[0][0], column0);
+    _mm_storeu_ps(&skinningMatrix.rows[1][0], column1);
+    _mm_storeu_ps(&skinningMatrix.rows[2][0], column2);
+#else
+    for (int row = 0; row < 3; row++)
+    {
+        skinningMatrix.rows[row] = glm::vec4(matrix[0][row], matrix[1][row], matrix[2][row], matrix[3][row]);
+    }
+#endif
+}
+} // namespace
+
+namespace SkeletalAnimation
+{
+void samplePose(const Skeleton& skeleton, const AnimationClip& clip, float time, JointPose* pose)
+{
+    if (clip.duration > 0.0F)
+    {
+        time = std::fmod(time, clip.duration);
+        if (time < 0.0F)
+        {
+            time += clip.duration;
+        }
+    }
+
+    for (uint32_t joint = 0; joint < skeleton.getJointCount(); joint++)
+    {
+        pose[joint] = skeleton.bindPose[joint];
+        if (joint >= clip.tracks.size() || clip.tracks[joint].times.empty())
+            continue;
+
+        const JointTrack& track = clip.tracks[joint];
+
+        // the key at or after the time, times outside the keys hold the nearest one
+        const auto   next     = std::upper_bound(track.times.begin(), track.times.end(), time);
+        const size_t nextKey  = std::min(static_cast<size_t>(next - track.times.begin()), track.times.size() - 1);
+        const size_t firstKey = nextKey > 0 ? nextKey - 1 : 0;
+
+        const float span   = track.times[nextKey] - track.times[firstKey];
+        const float weight = span > 0.0F ? std::clamp((time - track.times[firstKey]) / span, 0.0F, 1.0F) : 0.0F;
+
+        pose[joint].translation = glm::mix(track.translations[firstKey], track.translations[nextKey], weight);
+        pose[joint].rotation    = glm::slerp(track.rotations[firstKey], track.rotations[nextKey], weight);
+    }
+}
+
+void computeSkinningMatrices(const Skeleton&  skeleton,
+                             const JointPose* pose,
+                             const glm::mat4& transform,
+                             SkinningMatrix*  skinningMatrices)
+{
+    const uint32_t jointCount = skeleton.getJointCount();
+
+    // instance transform folded into the world matrices, the shader skins straight into model space
+    thread_local std::vector<glm::mat4> worldMatrices;
+    worldMatrices.resize(jointCount);
+
+    glm::mat4 skinMatrix;
+    for (uint32_t joint = 0; joint < jointCount; joint++)
+    {
+        const int32_t    parent = skeleton.parents[joint];
+        const glm::mat4& base   = parent >= 0 ? worldMatrices[parent] : transform;
+        multiplyMatrices(base, composeMatrix(pose[joint]), worldMatrices[joint]);
+
+        multiplyMatrices(worldMatrices[joint], skeleton.inverseBindMatrices[joint], skinMatrix);
+        storeRows(skinMatrix, skinningMatrices[joint]);
+    }
+}
+
+void evaluatePoses(JobSystem*                            jobSystem,
+                   const Skeleton&                       skeleton,
+                   const std::vector<AnimationInstance>& instances,
+                   SkinningMatrix*                       skinningMatrices)
+{
+    const uint32_t jointCount = skeleton.getJointCount();
+
+    const auto evaluateRange = [&](uint32_t begin, uint32_t end) {
+        std::vector<JointPose> pose(jointCount);
+        for (uint32_t instance = begin; instance < end; instance++)
+        {
+            const AnimationInstance& animation = instances[instance];
+            if (animation.clip != nullptr)
+            {
+                samplePose(skeleton, *animation.clip, animation.time, pose.data());
+            }
+            else
+            {
+                std::copy(skeleton.bindPose.begin(), skeleton.bindPose.end(), pose.begin());
+            }
+            SkinningMatrix* palette = skinningMatrices + static_cast<size_t>(instance) * jointCount;
+            computeSkinningMatrices(skeleton, pose.data(), animation.transform, palette);
+        }
+    };
+
+    const auto instanceCount = static_cast<uint32_t>(instances.size());
+    if (jobSystem == nullptr || instanceCount <= INSTANCE_CHUNK_SIZE)
+    {
+        evaluateRange(0, instanceCount);
+        return;
+    }
+    jobSystem->parallelFor(instanceCount, INSTANCE_CHUNK_SIZE, evaluateRange);
+}
+} // namespace SkeletalAnimation
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "foundation/job/job_system.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+#include <vector>
+
+struct JointPose
+{
+    glm::vec3 translation {0.0F};
+    glm::quat rotation {1.0F, 0.0F, 0.0F, 0.0F};
+    glm::vec3 scale {1.0F};
+};
+
+// Joints are sorted so every parent comes before its children, the world transforms resolve in one forward pass.
+struct Skeleton
+{
+    std::vector<int32_t>   parents; // -1 for roots
+    std::vector<JointPose> bindPose;
+    std::vector<glm::mat4> inverseBindMatrices;
+
+    [[nodiscard]] uint32_t getJointCount() const { return static_cast<uint32_t>(parents.size()); }
+};
+
+// Keyframes of one joint, translation and rotation share the key times. A joint without keys keeps its bind pose.
+struct JointTrack
+{
+    std::vector<float>     times; // ascending, within the clip duration
+    std::vector<glm::vec3> translations;
+    std::vector<glm::quat> rotations;
+};
+
+struct AnimationClip
+{
+    float                   duration {0.0F};
+    std::vector<JointTrack> tracks; // one per joint
+};
+
+// Affine skinning matrix as three rows, a vertex is skinned with dot products against them. std430 compatible, the
+// skinning shader reads it as mat3x4.
+struct SkinningMatrix
+{
+    glm::vec4 rows[3];
+};
+
+static_assert(sizeof(SkinningMatrix) == 48, "SkinningMatrix must match the std430 shader layout");
+
+// one animated skeleton, placed in model space by its transform
+struct AnimationInstance
+{
+    const AnimationClip* clip {nullptr};
+    float                time {0.0F}; // wraps around the clip duration
+    glm::mat4            transform {1.0F};
+};
+
+namespace SkeletalAnimation
+{
+// local joint poses of the clip at the time, pose must hold one entry per joint
+void samplePose(const Skeleton& skeleton, const AnimationClip& clip, float time, JointPose* pose);
+
+// transform * world joint transform * inverse bind matrix for every joint
+void computeSkinningMatrices(const Skeleton&  skeleton,
+                             const JointPose* pose,
+                             const glm::mat4& transform,
+                             SkinningMatrix*  skinningMatrices);
+
+// Samples and resolves every instance, the palettes are written back to back, jointCount entries per instance. The
+// instances are split across the job system, the destination may be mapped gpu memory since it is only written.
+void evaluatePoses(JobSystem*                            jobSystem,
+                   const Skeleton&                       skeleton,
+                   const std::vector<AnimationInstance>& instances,
+                   SkinningMatrix*                       skinningMatrices);
+} // namespace SkeletalAnimation
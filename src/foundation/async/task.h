@@ -0,0 +1,338 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+template<typename T = void>
+class Task;
+
+namespace TaskDetail
+{
+class PromiseBase {
+public:
+    struct FinalAwaiter
+    {
+        [[nodiscard]] bool await_ready() const noexcept { return false; }
+
+        // symmetric transfer, the awaiting coroutine continues on this thread without growing the stack
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) const noexcept
+        {
+            const std::coroutine_handle<> continuation = handle.promise().getContinuation();
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    [[nodiscard]] std::suspend_always initial_suspend() const noexcept { return {}; }
+    [[nodiscard]] FinalAwaiter        final_suspend() const noexcept { return {}; }
+    void                              unhandled_exception() noexcept { exception_ = std::current_exception(); }
+
+    // resumed once the task finished
+    void setContinuation(std::coroutine_handle<> continuation) { continuation_ = continuation; }
+
+    [[nodiscard]] std::coroutine_handle<> getContinuation() const { return continuation_; }
+
+protected:
+    void rethrowException() const
+    {
+        if (exception_)
+        {
+            std::rethrow_exception(exception_);
+        }
+    }
+
+private:
+    std::coroutine_handle<> continuation_;
+    std::exception_ptr      exception_;
+};
+
+template<typename T>
+class Promise : public PromiseBase {
+public:
+    Task<T> get_return_object() noexcept;
+
+    template<typename U>
+    void return_value(U&& value)
+    {
+        value_.emplace(std::forward<U>(value));
+    }
+
+    T takeResult()
+    {
+        rethrowException();
+        return std::move(*value_);
+    }
+
+private:
+    std::optional<T> value_;
+};
+
+template<>
+class Promise<void> : public PromiseBase {
+public:
+    Task<void> get_return_object() noexcept;
+
+    void return_void() const noexcept {}
+    void takeResult() const { rethrowException(); }
+};
+} // namespace TaskDetail
+
+// Lazily started coroutine. Nothing runs until the task is awaited, then it runs on the awaiting thread until it
+// suspends itself, for example on TaskExecutor::schedule(), and the awaiting coroutine resumes wherever the task
+// finished. The result or exception is handed to the awaiting coroutine. A task can only be awaited once.
+template<typename T>
+class Task {
+public:
+    using promise_type = TaskDetail::Promise<T>;
+    using Handle       = std::coroutine_handle<promise_type>;
+
+    Task() = default;
+    explicit Task(Handle handle) :
+        handle_(handle)
+    {
+    }
+
+    ~Task() { destroy(); }
+
+    Task(const Task&)            = delete;
+    Task& operator=(const Task&) = delete;
+
+    Task(Task&& other) noexcept :
+        handle_(std::exchange(other.handle_, {}))
+    {
+    }
+
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+
+    auto operator co_await() && noexcept
+    {
+        struct Awaiter
+        {
+            Handle handle;
+
+            [[nodiscard]] bool await_ready() const noexcept { return handle.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) const noexcept
+            {
+                handle.promise().setContinuation(awaiting);
+                return handle;
+            }
+
+            T await_resume() const { return handle.promise().takeResult(); }
+        };
+        return Awaiter {handle_};
+    }
+
+private:
+    void destroy()
+    {
+        if (handle_)
+        {
+            handle_.destroy();
+            handle_ = {};
+        }
+    }
+
+    Handle handle_;
+};
+
+namespace TaskDetail
+{
+template<typename T>
+Task<T> Promise<T>::get_return_object() noexcept
+{
+    return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() noexcept
+{
+    return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+// starts right away and frees itself at the end, drives the tasks of whenAll and syncWait
+struct DetachedTask
+{
+    struct promise_type
+    {
+        DetachedTask       get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void               return_void() const noexcept {}
+        void               unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+struct WhenAllState
+{
+    std::atomic<size_t>     remaining {0};
+    std::coroutine_handle<> continuation;
+    std::mutex              mutex;
+    std::exception_ptr      exception;
+
+    // true for the last arrival, which resumes the awaiting coroutine
+    bool arrive() { return remaining.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+};
+
+inline DetachedTask runWhenAllTask(Task<void> task, WhenAllState& state)
+{
+    try
+    {
+        co_await std::move(task);
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (!state.exception)
+        {
+            state.exception = std::current_exception();
+        }
+    }
+
+    if (state.arrive())
+    {
+        state.continuation.resume();
+    }
+}
+
+class WhenAllAwaiter {
+public:
+    explicit WhenAllAwaiter(std::vector<Task<void>>& tasks) :
+        tasks_(tasks)
+    {
+    }
+
+    [[nodiscard]] bool await_ready() const noexcept { return tasks_.empty(); }
+
+    // the extra count keeps tasks finishing during the loop from resuming the awaiting coroutine too early
+    bool await_suspend(std::coroutine_handle<> awaiting)
+    {
+        state_.continuation = awaiting;
+        state_.remaining.store(tasks_.size() + 1, std::memory_order_relaxed);
+        for (Task<void>& task : tasks_)
+        {
+            runWhenAllTask(std::move(task), state_);
+        }
+        return !state_.arrive();
+    }
+
+    void await_resume() const
+    {
+        if (state_.exception)
+        {
+            std::rethrow_exception(state_.exception);
+        }
+    }
+
+private:
+    std::vector<Task<void>>& tasks_;
+    WhenAllState             state_;
+};
+
+class SyncWaitEvent {
+public:
+    // notifies while locked, the waiting thread destroys the event as soon as it saw the flag
+    void set()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_ = true;
+        condition_.notify_all();
+    }
+
+    bool waitFor(std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return condition_.wait_for(lock, timeout, [this]() { return done_; });
+    }
+
+private:
+    std::mutex              mutex_;
+    std::condition_variable condition_;
+    bool                    done_ {false};
+};
+
+inline DetachedTask runSyncWaitTask(Task<void> task, SyncWaitEvent& event, std::exception_ptr& exception)
+{
+    try
+    {
+        co_await std::move(task);
+    }
+    catch (...)
+    {
+        exception = std::current_exception();
+    }
+    event.set();
+}
+
+template<typename T>
+Task<void> storeResult(Task<T> task, std::optional<T>& result)
+{
+    result.emplace(co_await std::move(task));
+}
+
+inline DetachedTask runSpawnedTask(Task<void> task)
+{
+    co_await std::move(task);
+}
+} // namespace TaskDetail
+
+// Runs the tasks concurrently and finishes once all of them did, rethrowing the first exception. Every task starts on
+// the awaiting thread, the ones that should run in parallel move to an executor with co_await schedule() first.
+inline Task<void> whenAll(std::vector<Task<void>> tasks)
+{
+    co_await TaskDetail::WhenAllAwaiter(tasks);
+}
+
+// Blocks until the task finished and rethrows its exception. Meanwhile poll is called about every millisecond, so the
+// waiting thread can keep serving work the task depends on, like submitting the uploads only it may submit.
+inline void syncWait(Task<void> task, const std::function<void()>& poll = {})
+{
+    TaskDetail::SyncWaitEvent event;
+    std::exception_ptr        exception;
+    TaskDetail::runSyncWaitTask(std::move(task), event, exception);
+
+    while (!event.waitFor(std::chrono::milliseconds(1)))
+    {
+        if (poll)
+        {
+            poll();
+        }
+    }
+
+    if (exception)
+    {
+        std::rethrow_exception(exception);
+    }
+}
+
+template<typename T>
+T syncWait(Task<T> task, const std::function<void()>& poll = {})
+{
+    std::optional<T> result;
+    syncWait(TaskDetail::storeResult(std::move(task), result), poll);
+    return std::move(*result);
+}
+
+// Starts the task on the calling thread without waiting for it, nothing is left to observe its end. The task has to
+// hand its result over by itself and may not throw, an escaping exception terminates the program.
+inline void spawn(Task<void> task)
+{
+    TaskDetail::runSpawnedTask(std::move(task));
+}
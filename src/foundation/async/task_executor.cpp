@@ -0,0 +1,58 @@
+#include "foundation/async/task_executor.h"
+
+#include <algorithm>
+
+TaskExecutor::TaskExecutor(uint32_t workerCount)
+{
+    workerCount = std::max(1U, workerCount);
+
+    workers_.reserve(workerCount);
+    for (uint32_t index = 0; index < workerCount; index++)
+    {
+        workers_.emplace_back(&TaskExecutor::workerLoop, this);
+    }
+}
+
+TaskExecutor::~TaskExecutor()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wakeCondition_.notify_all();
+
+    for (auto& worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+void TaskExecutor::post(std::coroutine_handle<> handle)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        handles_.push_back(handle);
+    }
+    wakeCondition_.notify_one();
+}
+
+void TaskExecutor::workerLoop()
+{
+    while (true)
+    {
+        std::coroutine_handle<> handle;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wakeCondition_.wait(lock, [this] { return stopping_ || !handles_.empty(); });
+
+            if (handles_.empty())
+                return;
+
+            handle = handles_.front();
+            handles_.pop_front();
+        }
+
+        // exceptions stay inside the coroutine, its task rethrows them where it is awaited
+        handle.resume();
+    }
+}
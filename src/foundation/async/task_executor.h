@@ -0,0 +1,53 @@
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker threads that resume coroutines, the asynchronous counterpart of the fork-join JobSystem. Meant for work that
+// blocks on the disk or waits for the gpu, a coroutine that wants to split a large loop still calls parallelFor.
+class TaskExecutor {
+public:
+    class ScheduleAwaiter {
+    public:
+        explicit ScheduleAwaiter(TaskExecutor& executor) :
+            executor_(executor)
+        {
+        }
+
+        [[nodiscard]] bool await_ready() const noexcept { return false; }
+        void               await_suspend(std::coroutine_handle<> handle) const { executor_.post(handle); }
+        void               await_resume() const noexcept {}
+
+    private:
+        TaskExecutor& executor_;
+    };
+
+    explicit TaskExecutor(uint32_t workerCount = 1);
+
+    // resumes everything queued before the workers stop
+    ~TaskExecutor();
+
+    TaskExecutor(const TaskExecutor&)            = delete;
+    TaskExecutor& operator=(const TaskExecutor&) = delete;
+
+    // co_await executor.schedule() continues the coroutine on one of the workers
+    [[nodiscard]] ScheduleAwaiter schedule() { return ScheduleAwaiter(*this); }
+
+    // any thread
+    void post(std::coroutine_handle<> handle);
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> workers_;
+
+    std::mutex                          mutex_;
+    std::condition_variable             wakeCondition_;
+    std::deque<std::coroutine_handle<>> handles_;
+    bool                                stopping_ {false};
+};
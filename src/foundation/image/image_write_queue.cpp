@@ -0,0 +1,100 @@
+#include "foundation/image/image_write_queue.h"
+
+#include "foundation/log/log_system.h"
+
+#include <algorithm>
+#include <chrono>
+
+ImageWriteQueue::ImageWriteQueue(uint32_t workerCount)
+{
+    workerCount = std::max(1U, workerCount);
+
+    workers_.reserve(workerCount);
+    for (uint32_t index = 0; index < workerCount; index++)
+    {
+        workers_.emplace_back(&ImageWriteQueue::workerLoop, this);
+    }
+}
+
+ImageWriteQueue::~ImageWriteQueue()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wakeCondition_.notify_all();
+
+    for (auto& worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+void ImageWriteQueue::push(ImageWriteRequest request)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        requests_.push_back(std::move(request));
+    }
+    wakeCondition_.notify_one();
+}
+
+uint32_t ImageWriteQueue::getPendingCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<uint32_t>(requests_.size()) + busyWorkers_;
+}
+
+void ImageWriteQueue::waitIdle()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    idleCondition_.wait(lock, [this] { return requests_.empty() && busyWorkers_ == 0; });
+}
+
+void ImageWriteQueue::workerLoop()
+{
+    std::vector<uint8_t> rgb;
+    std::vector<uint8_t> png;
+
+    while (true)
+    {
+        ImageWriteRequest request;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wakeCondition_.wait(lock, [this] { return stopping_ || !requests_.empty(); });
+
+            // the queue is drained before stopping, a capture in progress still ends up on disk
+            if (requests_.empty())
+                return;
+
+            request = std::move(requests_.front());
+            requests_.pop_front();
+            busyWorkers_++;
+        }
+
+        const auto start = std::chrono::high_resolution_clock::now();
+
+        ImageWriter::convertToRgb(request.pixels.data(), request.width, request.height, request.layout, rgb);
+        ImageWriter::encodePng(rgb.data(), request.width, request.height, 3, png);
+
+        if (ImageWriter::writeFile(request.path, png))
+        {
+            LOG_INFO("Wrote {}x{} image to {} in {:.1f} ms",
+                     request.width,
+                     request.height,
+                     request.path,
+                     std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start)
+                         .count());
+        }
+        else
+        {
+            LOG_ERROR("Failed to write image {}", request.path);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            busyWorkers_--;
+        }
+        idleCondition_.notify_all();
+    }
+}
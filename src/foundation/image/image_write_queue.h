@@ -0,0 +1,53 @@
+#pragma once
+
+#include "foundation/image/image_writer.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Four channel pixels to be written as a PNG file, rows tightly packed.
+struct ImageWriteRequest
+{
+    std::string          path;
+    uint32_t             width {0};
+    uint32_t             height {0};
+    ImagePixelLayout     layout {ImagePixelLayout::RGBA8};
+    std::vector<uint8_t> pixels;
+};
+
+// Worker threads that convert, encode and write images. Pushing never blocks, the queue grows instead, so capturing
+// every frame of a sequence cannot stall the thread producing them.
+class ImageWriteQueue {
+public:
+    explicit ImageWriteQueue(uint32_t workerCount = 1);
+
+    // finishes everything queued before the workers stop
+    ~ImageWriteQueue();
+
+    ImageWriteQueue(const ImageWriteQueue&)            = delete;
+    ImageWriteQueue& operator=(const ImageWriteQueue&) = delete;
+
+    void push(ImageWriteRequest request);
+
+    // queued or being written
+    [[nodiscard]] uint32_t getPendingCount() const;
+
+    void waitIdle();
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> workers_;
+
+    mutable std::mutex            mutex_;
+    std::condition_variable       wakeCondition_;
+    std::condition_variable       idleCondition_;
+    std::deque<ImageWriteRequest> requests_;
+    uint32_t                      busyWorkers_ {0};
+    bool                          stopping_ {false};
+};
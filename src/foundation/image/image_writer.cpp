@@ -0,0 +1,169 @@
+#include "foundation/image/image_writer.h"
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+// largest payload of a stored deflate block
+constexpr uint32_t STORED_BLOCK_SIZE = 65535;
+
+constexpr uint32_t ADLER_MODULO = 65521;
+
+// zlib limits the adler sums to 5552 bytes between reductions so the 32 bit accumulators never overflow
+constexpr size_t ADLER_RUN_LENGTH = 5552;
+
+std::array<uint32_t, 256> makeCrcTable()
+{
+    std::array<uint32_t, 256> table {};
+    for (uint32_t index = 0; index < 256; index++)
+    {
+        uint32_t crc = index;
+        for (uint32_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 1U) != 0 ? 0xEDB88320U ^ (crc >> 1U) : crc >> 1U;
+        }
+        table[index] = crc;
+    }
+    return table;
+}
+
+uint32_t updateCrc(uint32_t crc, const uint8_t* data, size_t size)
+{
+    static const std::array<uint32_t, 256> CRC_TABLE = makeCrcTable();
+
+    for (size_t index = 0; index < size; index++)
+    {
+        crc = CRC_TABLE[(crc ^ data[index]) & 0xFFU] ^ (crc >> 8U);
+    }
+    return crc;
+}
+
+void appendBigEndian(std::vector<uint8_t>& output, uint32_t value)
+{
+    output.push_back(static_cast<uint8_t>(value >> 24U));
+    output.push_back(static_cast<uint8_t>(value >> 16U));
+    output.push_back(static_cast<uint8_t>(value >> 8U));
+    output.push_back(static_cast<uint8_t>(value));
+}
+
+// the crc covers the chunk type and data, not the length
+void appendChunk(std::vector<uint8_t>& output, const char* type, const std::vector<uint8_t>& data)
+{
+    appendBigEndian(output, static_cast<uint32_t>(data.size()));
+
+    const size_t typeOffset = output.size();
+    output.insert(output.end(), type, type + 4);
+    output.insert(output.end(), data.begin(), data.end());
+
+    const uint32_t crc = updateCrc(0xFFFFFFFFU, output.data() + typeOffset, output.size() - typeOffset);
+    appendBigEndian(output, crc ^ 0xFFFFFFFFU);
+}
+} // namespace
+
+namespace ImageWriter
+{
+void convertToRgb(const uint8_t*        pixels,
+                  uint32_t              width,
+                  uint32_t              height,
+                  ImagePixelLayout      layout,
+                  std::vector<uint8_t>& rgb)
+{
+    const size_t pixelCount = static_cast<size_t>(width) * height;
+    const size_t red        = layout == ImagePixelLayout::BGRA8 ? 2 : 0;
+    const size_t blue       = 2 - red;
+
+    rgb.resize(pixelCount * 3);
+    for (size_t pixel = 0; pixel < pixelCount; pixel++)
+    {
+        const uint8_t* source = pixels + pixel * 4;
+        uint8_t*       target = rgb.data() + pixel * 3;
+        target[0]             = source[red];
+        target[1]             = source[1];
+        target[2]             = source[blue];
+    }
+}
+
+void encodePng(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels, std::vector<uint8_t>& png)
+{
+    // every row starts with filter type 0, the bytes are stored as they are
+    const size_t         rowSize = static_cast<size_t>(width) * channels;
+    std::vector<uint8_t> filtered((rowSize + 1) * height);
+    for (uint32_t row = 0; row < height; row++)
+    {
+        uint8_t* target = filtered.data() + row * (rowSize + 1);
+        target[0]       = 0;
+        std::copy_n(pixels + row * rowSize, rowSize, target + 1);
+    }
+
+    // zlib header without preset dictionary, then stored blocks and the adler32 of the uncompressed bytes
+    std::vector<uint8_t> compressed;
+    compressed.reserve(filtered.size() + filtered.size() / STORED_BLOCK_SIZE * 5 + 16);
+    compressed.push_back(0x78);
+    compressed.push_back(0x01);
+
+    size_t offset = 0;
+    do
+    {
+        const auto    blockSize = static_cast<uint32_t>(std::min<size_t>(STORED_BLOCK_SIZE, filtered.size() - offset));
+        const uint8_t last      = offset + blockSize == filtered.size() ? 1 : 0;
+        compressed.push_back(last);
+        compressed.push_back(static_cast<uint8_t>(blockSize));
+        compressed.push_back(static_cast<uint8_t>(blockSize >> 8U));
+        compressed.push_back(static_cast<uint8_t>(~blockSize));
+        compressed.push_back(static_cast<uint8_t>(~blockSize >> 8U));
+        compressed.insert(compressed.end(), filtered.begin() + offset, filtered.begin() + offset + blockSize);
+        offset += blockSize;
+    } while (offset < filtered.size());
+
+    uint32_t adlerLow  = 1;
+    uint32_t adlerHigh = 0;
+    for (size_t run = 0; run < filtered.size(); run += ADLER_RUN_LENGTH)
+    {
+        const size_t runEnd = std::min(filtered.size(), run + ADLER_RUN_LENGTH);
+        for (size_t index = run; index < runEnd; index++)
+        {
+            adlerLow += filtered[index];
+            adlerHigh += adlerLow;
+        }
+        adlerLow %= ADLER_MODULO;
+        adlerHigh %= ADLER_MODULO;
+    }
+    appendBigEndian(compressed, (adlerHigh << 16U) | adlerLow);
+
+    std::vector<uint8_t> header;
+    appendBigEndian(header, width);
+    appendBigEndian(header, height);
+    header.push_back(8);                     // bit depth
+    header.push_back(channels == 4 ? 6 : 2); // truecolor with or without alpha
+    header.push_back(0);                     // deflate
+    header.push_back(0);                     // adaptive filtering
+    header.push_back(0);                     // no interlace
+
+    static const uint8_t SIGNATURE[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+    png.assign(std::begin(SIGNATURE), std::end(SIGNATURE));
+    appendChunk(png, "IHDR", header);
+    appendChunk(png, "IDAT", compressed);
+    appendChunk(png, "IEND", {});
+}
+
+bool writeFile(const std::string& path, const std::vector<uint8_t>& data)
+{
+    const std::filesystem::path filePath(path);
+    if (filePath.has_parent_path())
+    {
+        std::error_code error;
+        std::filesystem::create_directories(filePath.parent_path(), error);
+    }
+
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+
+    file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    return static_cast<bool>(file);
+}
+} // namespace ImageWriter
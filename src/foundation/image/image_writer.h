@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Byte order of 8 bit per channel pixels handed to the writers
+enum class ImagePixelLayout : uint8_t
+{
+    RGBA8,
+    BGRA8,
+};
+
+namespace ImageWriter
+{
+// Packs rows of four channel pixels into tightly packed RGB, swapping red and blue for BGRA input. Alpha is dropped,
+// the swap chain is presented opaque and its alpha holds whatever the blend state left behind.
+void convertToRgb(const uint8_t*        pixels,
+                  uint32_t              width,
+                  uint32_t              height,
+                  ImagePixelLayout      layout,
+                  std::vector<uint8_t>& rgb);
+
+// Encodes tightly packed 3 or 4 channel pixels as PNG. The deflate stream only uses stored blocks, so encoding costs
+// about as much as a copy and the files are as large as the raw pixels.
+void encodePng(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels, std::vector<uint8_t>& png);
+
+// creates missing parent directories, returns false when the file could not be written
+bool writeFile(const std::string& path, const std::vector<uint8_t>& data);
+} // namespace ImageWriter
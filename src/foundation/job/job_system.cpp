@@ -0,0 +1,135 @@
+#include "foundation/job/job_system.h"
+
+#include <algorithm>
+
+JobSystem::JobSystem(uint32_t workerCount)
+{
+    if (workerCount == 0)
+    {
+        const uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        workerCount                    = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+
+    workers_.reserve(workerCount);
+    for (uint32_t index = 0; index < workerCount; index++)
+    {
+        workers_.emplace_back(&JobSystem::workerLoop, this);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wakeCondition_.notify_all();
+
+    for (auto& worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+uint32_t JobSystem::getThreadCount() const
+{
+    return static_cast<uint32_t>(workers_.size()) + 1;
+}
+
+void JobSystem::parallelFor(uint32_t count, uint32_t chunkSize, const std::function<void(uint32_t, uint32_t)>& job)
+{
+    if (count == 0)
+        return;
+
+    if (chunkSize == 0)
+    {
+        chunkSize = std::max(1U, (count + getThreadCount() - 1) / getThreadCount());
+    }
+
+    // a single chunk or no workers, not worth waking anybody up
+    if (workers_.empty() || chunkSize >= count)
+    {
+        job(0, count);
+        return;
+    }
+
+    std::lock_guard<std::mutex> dispatchLock(dispatchMutex_);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job_         = &job;
+        count_       = count;
+        chunkSize_   = chunkSize;
+        error_       = nullptr;
+        busyWorkers_ = static_cast<uint32_t>(workers_.size());
+        nextChunk_.store(0, std::memory_order_relaxed);
+        generation_++;
+    }
+    wakeCondition_.notify_all();
+
+    runChunks();
+
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        doneCondition_.wait(lock, [this]() { return busyWorkers_ == 0; });
+        job_  = nullptr;
+        error = error_;
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+void JobSystem::workerLoop()
+{
+    uint64_t seenGeneration = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wakeCondition_.wait(lock, [this, seenGeneration]() { return stopping_ || generation_ != seenGeneration; });
+            if (stopping_)
+                return;
+
+            seenGeneration = generation_;
+        }
+
+        runChunks();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            busyWorkers_--;
+        }
+        doneCondition_.notify_one();
+    }
+}
+
+void JobSystem::runChunks()
+{
+    const uint32_t chunkCount = (count_ + chunkSize_ - 1) / chunkSize_;
+    while (true)
+    {
+        const uint32_t chunk = nextChunk_.fetch_add(1, std::memory_order_relaxed);
+        if (chunk >= chunkCount)
+            return;
+
+        const uint32_t begin = chunk * chunkSize_;
+        const uint32_t end   = std::min(begin + chunkSize_, count_);
+
+        try
+        {
+            (*job_)(begin, end);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!error_)
+            {
+                error_ = std::current_exception();
+            }
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed pool of worker threads for fork-join loops. parallelFor splits a range into chunks that the workers and the
+// calling thread pull from a shared counter, and only returns once every chunk ran. One loop runs at a time, a job
+// must not start another parallelFor on the same system.
+class JobSystem {
+public:
+    // 0 uses one worker per hardware thread besides the caller
+    explicit JobSystem(uint32_t workerCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&)            = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // workers plus the calling thread
+    [[nodiscard]] uint32_t getThreadCount() const;
+
+    // calls job(begin, end) for consecutive chunks of [0, count), a chunk size of 0 makes one chunk per thread.
+    // The first exception thrown by a job is rethrown on the caller once all chunks finished
+    void parallelFor(uint32_t count, uint32_t chunkSize, const std::function<void(uint32_t, uint32_t)>& job);
+
+private:
+    void workerLoop();
+    void runChunks();
+
+    std::vector<std::thread> workers_;
+
+    std::mutex              dispatchMutex_;
+    std::mutex              mutex_;
+    std::condition_variable wakeCondition_;
+    std::condition_variable doneCondition_;
+    uint64_t                generation_ {0};
+    uint32_t                busyWorkers_ {0};
+    bool                    stopping_ {false};
+
+    // the loop being executed, only valid while a parallelFor is running
+    const std::function<void(uint32_t, uint32_t)>* job_ {nullptr};
+    uint32_t                                       count_ {0};
+    uint32_t                                       chunkSize_ {1};
+    std::atomic<uint32_t>                          nextChunk_ {0};
+    std::exception_ptr                             error_;
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <limits>
+
+// Axis aligned bounding box, default constructed empty so that expanding it by the first point yields that point.
+struct Aabb
+{
+    glm::vec3 min {std::numeric_limits<float>::max()};
+    glm::vec3 max {std::numeric_limits<float>::lowest()};
+
+    [[nodiscard]] bool isEmpty() const
+    {
+        return min.x > max.x || min.y > max.y || min.z > max.z;
+    }
+
+    void expand(const glm::vec3& point)
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    void expand(const Aabb& other)
+    {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    [[nodiscard]] glm::vec3 getCenter() const
+    {
+        return (min + max) * 0.5F;
+    }
+
+    [[nodiscard]] glm::vec3 getExtent() const
+    {
+        return max - min;
+    }
+
+    [[nodiscard]] float getSurfaceArea() const
+    {
+        if (isEmpty())
+            return 0.0F;
+
+        const glm::vec3 extent = getExtent();
+        return 2.0F * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+    }
+
+    [[nodiscard]] bool intersects(const Aabb& other) const
+    {
+        return min.x <= other.max.x && max.x >= other.min.x && min.y <= other.max.y && max.y >= other.min.y &&
+               min.z <= other.max.z && max.z >= other.min.z;
+    }
+
+    [[nodiscard]] bool contains(const Aabb& other) const
+    {
+        return min.x <= other.min.x && max.x >= other.max.x && min.y <= other.min.y && max.y >= other.max.y &&
+               min.z <= other.min.z && max.z >= other.max.z;
+    }
+
+    // the corner with bit 0 = x, bit 1 = y, bit 2 = z selecting max over min
+    [[nodiscard]] glm::vec3 getCorner(uint32_t index) const
+    {
+        return {(index & 1U) != 0 ? max.x : min.x,
+                (index & 2U) != 0 ? max.y : min.y,
+                (index & 4U) != 0 ? max.z : min.z};
+    }
+
+    // bounds of the box after an affine transform, still axis aligned and therefore possibly larger
+    [[nodiscard]] Aabb transformed(const glm::mat4& transform) const
+    {
+        Aabb result {};
+        for (uint32_t corner = 0; corner < 8; corner++)
+        {
+            result.expand(glm::vec3(transform * glm::vec4(getCorner(corner), 1.0F)));
+        }
+        return result;
+    }
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "foundation/math/aabb.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+enum class FrustumTest : uint8_t
+{
+    OUTSIDE,
+    INTERSECTING,
+    INSIDE,
+};
+
+// Six normalized planes facing inwards, left, right, bottom, top, near, far.
+struct Frustum
+{
+    glm::vec4 planes[6];
+
+    // Gribb-Hartmann extraction. The near plane is taken from the minus-one-to-one convention, for zero-to-one
+    // projections that plane lies slightly behind the real one, which only makes the tests more conservative
+    [[nodiscard]] static Frustum fromViewProjection(const glm::mat4& viewProjection)
+    {
+        const glm::vec4 row0 {viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]};
+        const glm::vec4 row1 {viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]};
+        const glm::vec4 row2 {viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]};
+        const glm::vec4 row3 {viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]};
+
+        Frustum frustum {};
+        frustum.planes[0] = row3 + row0;
+        frustum.planes[1] = row3 - row0;
+        frustum.planes[2] = row3 + row1;
+        frustum.planes[3] = row3 - row1;
+        frustum.planes[4] = row3 + row2;
+        frustum.planes[5] = row3 - row2;
+
+        for (auto& plane : frustum.planes)
+        {
+            plane /= glm::length(glm::vec3(plane));
+        }
+        return frustum;
+    }
+
+    // OUTSIDE is exact for a single plane only, boxes near the frustum corners may report INTERSECTING
+    [[nodiscard]] FrustumTest test(const Aabb& bounds) const
+    {
+        const glm::vec3 center = bounds.getCenter();
+        const glm::vec3 extent = bounds.getExtent() * 0.5F;
+
+        FrustumTest result = FrustumTest::INSIDE;
+        for (const auto& plane : planes)
+        {
+            const glm::vec3 normal   = glm::vec3(plane);
+            const float     distance = glm::dot(normal, center) + plane.w;
+            const float     radius   = glm::dot(glm::abs(normal), extent);
+            if (distance < -radius)
+                return FrustumTest::OUTSIDE;
+            if (distance < radius)
+            {
+                result = FrustumTest::INTERSECTING;
+            }
+        }
+        return result;
+    }
+
+    [[nodiscard]] bool intersects(const Aabb& bounds) const
+    {
+        const glm::vec3 center = bounds.getCenter();
+        const glm::vec3 extent = bounds.getExtent() * 0.5F;
+
+        for (const auto& plane : planes)
+        {
+            const glm::vec3 normal = glm::vec3(plane);
+            if (glm::dot(normal, center) + plane.w < -glm::dot(glm::abs(normal), extent))
+                return false;
+        }
+        return true;
+    }
+};
@@ -0,0 +1,859 @@
+#include "foundation/spatial/bvh.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BVH_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define BVH_NEON 1
+#endif
+
+namespace
+{
+constexpr uint32_t MAX_BIN_COUNT = 32;
+
+// deeper ranges become leaves whatever their size, keeps the traversal stack bounded
+constexpr uint32_t MAX_BUILD_DEPTH = 64;
+
+// primitives binned by one job of a parallel binning pass
+constexpr uint32_t BINNING_CHUNK_SIZE = 8192;
+
+struct BuildNode
+{
+    Aabb     bounds;
+    uint32_t left {0};
+    uint32_t right {0};
+    uint32_t first {0};
+    // 0 for inner nodes
+    uint32_t count {0};
+};
+
+// primitives [first, first + count) of the index array that end up below node
+struct BuildRange
+{
+    uint32_t node {0};
+    uint32_t first {0};
+    uint32_t count {0};
+    uint32_t depth {0};
+    Aabb     bounds;
+    Aabb     centroidBounds;
+};
+
+// bounds travel with the index, so every pass over a range reads memory front to back
+struct BuildPrimitive
+{
+    Aabb      bounds;
+    glm::vec3 centroid;
+    uint32_t  index;
+};
+
+struct Bin
+{
+    Aabb     bounds;
+    uint32_t count {0};
+};
+
+using BinSet = std::array<std::array<Bin, MAX_BIN_COUNT>, 3>;
+
+// maps centroids of a range to bins, axes without extent get no bins at all
+struct BinMapping
+{
+    glm::vec3 origin;
+    glm::vec3 scale;
+    uint32_t  binCount;
+};
+
+class BvhBuilder {
+public:
+    BvhBuilder(const std::vector<Aabb>& primitiveBounds,
+               std::vector<uint32_t>&   indices,
+               const BvhBuildSettings&  settings)
+        : primitiveBounds_(primitiveBounds),
+          indices_(indices),
+          binCount_(std::clamp(settings.binCount, 2U, MAX_BIN_COUNT)),
+          maxLeafSize_(std::max(1U, settings.maxLeafSize)),
+          parallelThreshold_(settings.parallelThreshold),
+          traversalCost_(settings.traversalCost)
+    {
+        primitives_.resize(primitiveBounds.size());
+    }
+
+    std::vector<BuildNode> build(JobSystem* jobSystem, uint32_t& subtreeCount);
+
+private:
+    void gatherPrimitives(JobSystem* jobSystem, BuildRange& root);
+    void binRange(uint32_t first, uint32_t count, const BinMapping& mapping, BinSet& bins) const;
+
+    // false when the range should stay a leaf, otherwise partitions it and fills both halves. bins is scratch memory
+    bool splitRange(const BuildRange& range, JobSystem* jobSystem, BinSet& bins, BuildRange& left, BuildRange& right);
+
+    void buildSubtree(const BuildRange& range, std::vector<BuildNode>& nodes);
+
+    // small ranges near the leaves get fewer bins, most splits happen down there and sweeping empty bins dominates
+    [[nodiscard]] BinMapping getBinMapping(const BuildRange& range) const
+    {
+        const glm::vec3 extent = range.centroidBounds.getExtent();
+
+        BinMapping mapping {range.centroidBounds.min, glm::vec3(0.0F), std::clamp(range.count, 2U, binCount_)};
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            mapping.scale[axis] = extent[axis] > 0.0F ? static_cast<float>(mapping.binCount) / extent[axis] : 0.0F;
+        }
+        return mapping;
+    }
+
+    [[nodiscard]] static uint32_t getBin(const glm::vec3& centroid, uint32_t axis, const BinMapping& mapping)
+    {
+        const auto bin = static_cast<int32_t>((centroid[axis] - mapping.origin[axis]) * mapping.scale[axis]);
+        return static_cast<uint32_t>(std::clamp(bin, 0, static_cast<int32_t>(mapping.binCount) - 1));
+    }
+
+    const std::vector<Aabb>& primitiveBounds_;
+    std::vector<uint32_t>&      indices_;
+    std::vector<BuildPrimitive> primitives_;
+
+    uint32_t binCount_;
+    uint32_t maxLeafSize_;
+    uint32_t parallelThreshold_;
+    float    traversalCost_;
+};
+
+std::vector<BuildNode> BvhBuilder::build(JobSystem* jobSystem, uint32_t& subtreeCount)
+{
+    std::vector<BuildNode> nodes(1);
+
+    BuildRange root {};
+    root.count = static_cast<uint32_t>(indices_.size());
+    gatherPrimitives(jobSystem, root);
+    nodes[0].bounds = root.bounds;
+
+    // the upper levels split one range at a time with every thread binning, until the ranges are small enough to
+    // hand a whole range to a single thread
+    BinSet                  bins;
+    std::vector<BuildRange> pending {root};
+    std::vector<BuildRange> subtrees;
+    while (!pending.empty())
+    {
+        const BuildRange range = pending.back();
+        pending.pop_back();
+
+        if (jobSystem == nullptr || range.count <= parallelThreshold_)
+        {
+            subtrees.push_back(range);
+            continue;
+        }
+
+        BuildRange left {};
+        BuildRange right {};
+        if (!splitRange(range, jobSystem, bins, left, right))
+        {
+            nodes[range.node].first = range.first;
+            nodes[range.node].count = range.count;
+            continue;
+        }
+
+        left.node  = static_cast<uint32_t>(nodes.size());
+        right.node = left.node + 1;
+        nodes.resize(nodes.size() + 2);
+        nodes[left.node].bounds  = left.bounds;
+        nodes[right.node].bounds = right.bounds;
+        nodes[range.node].left   = left.node;
+        nodes[range.node].right  = right.node;
+
+        pending.push_back(left);
+        pending.push_back(right);
+    }
+
+    // largest first so no big subtree starts last
+    std::sort(subtrees.begin(), subtrees.end(), [](const BuildRange& a, const BuildRange& b) {
+        return a.count > b.count;
+    });
+
+    std::vector<std::vector<BuildNode>> subtreeNodes(subtrees.size());
+    const auto buildSubtrees = [&](uint32_t begin, uint32_t end) {
+        for (uint32_t subtree = begin; subtree < end; subtree++)
+        {
+            buildSubtree(subtrees[subtree], subtreeNodes[subtree]);
+        }
+    };
+
+    if (jobSystem != nullptr)
+    {
+        jobSystem->parallelFor(static_cast<uint32_t>(subtrees.size()), 1, buildSubtrees);
+    }
+    else
+    {
+        buildSubtrees(0, static_cast<uint32_t>(subtrees.size()));
+    }
+
+    // stitch the subtrees in, their local root replaces the node the range was meant for
+    for (size_t subtree = 0; subtree < subtrees.size(); subtree++)
+    {
+        const std::vector<BuildNode>& local = subtreeNodes[subtree];
+
+        const uint32_t rootNode = subtrees[subtree].node;
+        const uint32_t base     = static_cast<uint32_t>(nodes.size()) - 1;
+        const auto     remap    = [&](uint32_t index) { return index == 0 ? rootNode : base + index; };
+
+        nodes.resize(nodes.size() + local.size() - 1);
+        for (uint32_t index = 0; index < local.size(); index++)
+        {
+            BuildNode node = local[index];
+            if (node.count == 0)
+            {
+                node.left  = remap(node.left);
+                node.right = remap(node.right);
+            }
+            nodes[remap(index)] = node;
+        }
+    }
+
+    for (size_t primitive = 0; primitive < primitives_.size(); primitive++)
+    {
+        indices_[primitive] = primitives_[primitive].index;
+    }
+
+    subtreeCount = static_cast<uint32_t>(subtrees.size());
+    return nodes;
+}
+
+void BvhBuilder::gatherPrimitives(JobSystem* jobSystem, BuildRange& root)
+{
+    const uint32_t chunkCount = (root.count + BINNING_CHUNK_SIZE - 1) / BINNING_CHUNK_SIZE;
+
+    std::vector<Aabb> chunkBounds(chunkCount);
+    std::vector<Aabb> chunkCentroidBounds(chunkCount);
+
+    const auto computeChunk = [&](uint32_t begin, uint32_t end) {
+        const uint32_t chunk = begin / BINNING_CHUNK_SIZE;
+        for (uint32_t primitive = begin; primitive < end; primitive++)
+        {
+            const Aabb& bounds     = primitiveBounds_[primitive];
+            primitives_[primitive] = {bounds, bounds.getCenter(), primitive};
+            chunkBounds[chunk].expand(bounds);
+            chunkCentroidBounds[chunk].expand(primitives_[primitive].centroid);
+        }
+    };
+
+    if (jobSystem != nullptr)
+    {
+        jobSystem->parallelFor(root.count, BINNING_CHUNK_SIZE, computeChunk);
+    }
+    else
+    {
+        for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+        {
+            computeChunk(chunk * BINNING_CHUNK_SIZE, std::min(root.count, (chunk + 1) * BINNING_CHUNK_SIZE));
+        }
+    }
+
+    for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+    {
+        root.bounds.expand(chunkBounds[chunk]);
+        root.centroidBounds.expand(chunkCentroidBounds[chunk]);
+    }
+}
+
+void BvhBuilder::binRange(uint32_t first, uint32_t count, const BinMapping& mapping, BinSet& bins) const
+{
+    for (uint32_t index = first; index < first + count; index++)
+    {
+        const BuildPrimitive& primitive = primitives_[index];
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            if (mapping.scale[axis] == 0.0F)
+                continue;
+
+            Bin& bin = bins[axis][getBin(primitive.centroid, axis, mapping)];
+            bin.bounds.expand(primitive.bounds);
+            bin.count++;
+        }
+    }
+}
+
+bool BvhBuilder::splitRange(const BuildRange& range,
+                            JobSystem*        jobSystem,
+                            BinSet&           bins,
+                            BuildRange&       left,
+                            BuildRange&       right)
+{
+    if (range.count <= 1 || range.depth >= MAX_BUILD_DEPTH)
+        return false;
+
+    const BinMapping mapping  = getBinMapping(range);
+    const uint32_t   binCount = mapping.binCount;
+
+    for (auto& axisBins : bins)
+    {
+        std::fill(axisBins.begin(), axisBins.begin() + binCount, Bin {});
+    }
+
+    if (jobSystem != nullptr && range.count > parallelThreshold_)
+    {
+        std::vector<BinSet> chunkBins((range.count + BINNING_CHUNK_SIZE - 1) / BINNING_CHUNK_SIZE);
+        jobSystem->parallelFor(range.count, BINNING_CHUNK_SIZE, [&](uint32_t begin, uint32_t end) {
+            binRange(range.first + begin, end - begin, mapping, chunkBins[begin / BINNING_CHUNK_SIZE]);
+        });
+
+        for (const BinSet& chunk : chunkBins)
+        {
+            for (uint32_t axis = 0; axis < 3; axis++)
+            {
+                for (uint32_t bin = 0; bin < binCount; bin++)
+                {
+                    bins[axis][bin].bounds.expand(chunk[axis][bin].bounds);
+                    bins[axis][bin].count += chunk[axis][bin].count;
+                }
+            }
+        }
+    }
+    else
+    {
+        binRange(range.first, range.count, mapping, bins);
+    }
+
+    // sweep every axis from both sides, a split after bin i puts bins [0, i] to the left
+    float    bestCost  = std::numeric_limits<float>::max();
+    uint32_t bestAxis  = 0;
+    uint32_t bestSplit = 0;
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        std::array<float, MAX_BIN_COUNT>    rightAreas {};
+        std::array<uint32_t, MAX_BIN_COUNT> rightCounts {};
+
+        Aabb     accumulated {};
+        uint32_t count = 0;
+        for (uint32_t bin = binCount - 1; bin > 0; bin--)
+        {
+            accumulated.expand(bins[axis][bin].bounds);
+            count += bins[axis][bin].count;
+            rightAreas[bin - 1]  = accumulated.getSurfaceArea();
+            rightCounts[bin - 1] = count;
+        }
+
+        accumulated = {};
+        count       = 0;
+        for (uint32_t split = 0; split + 1 < binCount; split++)
+        {
+            accumulated.expand(bins[axis][split].bounds);
+            count += bins[axis][split].count;
+            if (count == 0 || rightCounts[split] == 0)
+                continue;
+
+            const float cost = accumulated.getSurfaceArea() * static_cast<float>(count) +
+                               rightAreas[split] * static_cast<float>(rightCounts[split]);
+            if (cost < bestCost)
+            {
+                bestCost  = cost;
+                bestAxis  = axis;
+                bestSplit = split;
+            }
+        }
+    }
+
+    left       = {};
+    right      = {};
+    left.depth = right.depth = range.depth + 1;
+    left.first               = range.first;
+
+    if (bestCost == std::numeric_limits<float>::max())
+    {
+        // every centroid in the same spot, no plane separates them
+        if (range.count <= maxLeafSize_)
+            return false;
+
+        left.count  = range.count / 2;
+        right.first = range.first + left.count;
+        right.count = range.count - left.count;
+        for (uint32_t index = range.first; index < range.first + range.count; index++)
+        {
+            BuildRange& half = index < right.first ? left : right;
+            half.bounds.expand(primitives_[index].bounds);
+            half.centroidBounds.expand(primitives_[index].centroid);
+        }
+        return true;
+    }
+
+    const float parentArea = range.bounds.getSurfaceArea();
+    const float splitCost  = traversalCost_ + (parentArea > 0.0F ? bestCost / parentArea : 0.0F);
+    if (range.count <= maxLeafSize_ && splitCost >= static_cast<float>(range.count))
+        return false;
+
+    for (uint32_t bin = 0; bin < binCount; bin++)
+    {
+        BuildRange& half = bin <= bestSplit ? left : right;
+        half.bounds.expand(bins[bestAxis][bin].bounds);
+        half.count += bins[bestAxis][bin].count;
+    }
+    right.first = range.first + left.count;
+
+    // partition in place, the centroid bounds of both halves come out of the same pass
+    uint32_t begin = range.first;
+    uint32_t end   = range.first + range.count;
+    while (begin < end)
+    {
+        const glm::vec3& centroid = primitives_[begin].centroid;
+        if (getBin(centroid, bestAxis, mapping) <= bestSplit)
+        {
+            left.centroidBounds.expand(centroid);
+            begin++;
+        }
+        else
+        {
+            right.centroidBounds.expand(centroid);
+            std::swap(primitives_[begin], primitives_[--end]);
+        }
+    }
+    return true;
+}
+
+void BvhBuilder::buildSubtree(const BuildRange& range, std::vector<BuildNode>& nodes)
+{
+    nodes.clear();
+    nodes.emplace_back();
+    nodes[0].bounds = range.bounds;
+
+    BinSet                  bins;
+    std::vector<BuildRange> pending {range};
+    pending.back().node = 0;
+
+    while (!pending.empty())
+    {
+        const BuildRange current = pending.back();
+        pending.pop_back();
+
+        BuildRange left {};
+        BuildRange right {};
+        if (!splitRange(current, nullptr, bins, left, right))
+        {
+            nodes[current.node].first = current.first;
+            nodes[current.node].count = current.count;
+            continue;
+        }
+
+        left.node  = static_cast<uint32_t>(nodes.size());
+        right.node = left.node + 1;
+        nodes.resize(nodes.size() + 2);
+        nodes[left.node].bounds   = left.bounds;
+        nodes[right.node].bounds  = right.bounds;
+        nodes[current.node].left  = left.node;
+        nodes[current.node].right = right.node;
+
+        pending.push_back(right);
+        pending.push_back(left);
+    }
+}
+
+// surface areas the SAH cost of the finished tree is made of
+struct SahAreas
+{
+    float nodeArea {0.0F};
+    float primitiveArea {0.0F};
+};
+
+// turns the binary node into a wide node by opening the largest inner children until four slots are used. Returns the
+// index of the wide node
+uint32_t collapse(const std::vector<BuildNode>& binaryNodes,
+                  uint32_t                      binaryIndex,
+                  uint32_t                      depth,
+                  std::vector<BvhNode>&         nodes,
+                  BvhStatistics&                statistics,
+                  SahAreas&                     areas)
+{
+    const uint32_t nodeIndex = static_cast<uint32_t>(nodes.size());
+    nodes.emplace_back();
+    statistics.maxDepth = std::max(statistics.maxDepth, depth);
+    areas.nodeArea += binaryNodes[binaryIndex].bounds.getSurfaceArea();
+
+    std::array<uint32_t, BvhNode::WIDTH> children {};
+    uint32_t                             childCount = 0;
+
+    const BuildNode& binaryNode = binaryNodes[binaryIndex];
+    if (binaryNode.count > 0)
+    {
+        children[childCount++] = binaryIndex;
+    }
+    else
+    {
+        children[childCount++] = binaryNode.left;
+        children[childCount++] = binaryNode.right;
+    }
+
+    while (childCount < BvhNode::WIDTH)
+    {
+        float    largestArea = -1.0F;
+        uint32_t largest     = BvhNode::WIDTH;
+        for (uint32_t slot = 0; slot < childCount; slot++)
+        {
+            const BuildNode& child = binaryNodes[children[slot]];
+            if (child.count == 0 && child.bounds.getSurfaceArea() > largestArea)
+            {
+                largestArea = child.bounds.getSurfaceArea();
+                largest     = slot;
+            }
+        }
+        if (largest == BvhNode::WIDTH)
+            break;
+
+        const BuildNode& opened = binaryNodes[children[largest]];
+        children[largest]       = opened.left;
+        children[childCount++]  = opened.right;
+    }
+
+    for (uint32_t slot = 0; slot < BvhNode::WIDTH; slot++)
+    {
+        nodes[nodeIndex].child[slot] = BvhNode::INVALID_CHILD;
+        nodes[nodeIndex].count[slot] = 0;
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            nodes[nodeIndex].bounds[axis][slot]     = std::numeric_limits<float>::infinity();
+            nodes[nodeIndex].bounds[axis + 3][slot] = -std::numeric_limits<float>::infinity();
+        }
+    }
+
+    for (uint32_t slot = 0; slot < childCount; slot++)
+    {
+        const BuildNode& child = binaryNodes[children[slot]];
+
+        // the recursion grows the node array, write through the index only
+        uint32_t childIndex = child.first;
+        if (child.count > 0)
+        {
+            statistics.leafCount++;
+            areas.primitiveArea += child.bounds.getSurfaceArea() * static_cast<float>(child.count);
+        }
+        else
+        {
+            childIndex = collapse(binaryNodes, children[slot], depth + 1, nodes, statistics, areas);
+        }
+
+        BvhNode& node    = nodes[nodeIndex];
+        node.child[slot] = childIndex;
+        node.count[slot] = child.count;
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            node.bounds[axis][slot]     = child.bounds.min[axis];
+            node.bounds[axis + 3][slot] = child.bounds.max[axis];
+        }
+    }
+
+    return nodeIndex;
+}
+} // namespace
+
+void Bvh::build(const std::vector<Aabb>& primitiveBounds, JobSystem* jobSystem, const BvhBuildSettings& settings)
+{
+    nodes_.clear();
+    primitiveIndices_.resize(primitiveBounds.size());
+    statistics_ = {};
+
+    if (primitiveBounds.empty())
+        return;
+
+    for (uint32_t index = 0; index < primitiveIndices_.size(); index++)
+    {
+        primitiveIndices_[index] = index;
+    }
+
+    BvhBuilder                   builder(primitiveBounds, primitiveIndices_, settings);
+    const std::vector<BuildNode> binaryNodes = builder.build(jobSystem, statistics_.subtreeCount);
+
+    SahAreas areas {};
+    nodes_.reserve(binaryNodes.size() / 2 + 1);
+    collapse(binaryNodes, 0, 1, nodes_, statistics_, areas);
+
+    const float rootArea  = binaryNodes[0].bounds.getSurfaceArea();
+    statistics_.nodeCount = static_cast<uint32_t>(nodes_.size());
+    statistics_.sahCost =
+        rootArea > 0.0F ? (settings.traversalCost * areas.nodeArea + areas.primitiveArea) / rootArea : 0.0F;
+}
+
+void Bvh::refit(const std::vector<Aabb>& primitiveBounds)
+{
+    // children always come after their parent
+    for (size_t nodeIndex = nodes_.size(); nodeIndex-- > 0;)
+    {
+        BvhNode& node = nodes_[nodeIndex];
+        for (uint32_t slot = 0; slot < BvhNode::WIDTH; slot++)
+        {
+            if (node.child[slot] == BvhNode::INVALID_CHILD)
+                continue;
+
+            Aabb bounds {};
+            if (node.count[slot] > 0)
+            {
+                for (uint32_t primitive = node.child[slot]; primitive < node.child[slot] + node.count[slot];
+                     primitive++)
+                {
+                    bounds.expand(primitiveBounds[primitiveIndices_[primitive]]);
+                }
+            }
+            else
+            {
+                const BvhNode& child = nodes_[node.child[slot]];
+                for (uint32_t childSlot = 0; childSlot < BvhNode::WIDTH; childSlot++)
+                {
+                    if (child.child[childSlot] != BvhNode::INVALID_CHILD)
+                    {
+                        bounds.expand(getChildBounds(child, childSlot));
+                    }
+                }
+            }
+            setChildBounds(node, slot, bounds);
+        }
+    }
+}
+
+void Bvh::query(const Aabb& bounds, std::vector<uint32_t>& primitives) const
+{
+    if (nodes_.empty())
+        return;
+
+    uint32_t stack[MAX_STACK_SIZE];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const BvhNode& node = nodes_[stack[--stackSize]];
+        for (uint32_t slot = 0; slot < BvhNode::WIDTH; slot++)
+        {
+            if (node.child[slot] == BvhNode::INVALID_CHILD || !getChildBounds(node, slot).intersects(bounds))
+                continue;
+
+            if (node.count[slot] == 0)
+            {
+                stack[stackSize++] = node.child[slot];
+                continue;
+            }
+
+            for (uint32_t primitive = node.child[slot]; primitive < node.child[slot] + node.count[slot]; primitive++)
+            {
+                primitives.push_back(primitiveIndices_[primitive]);
+            }
+        }
+    }
+}
+
+Aabb Bvh::getBounds() const
+{
+    Aabb bounds {};
+    if (nodes_.empty())
+        return bounds;
+
+    for (uint32_t slot = 0; slot < BvhNode::WIDTH; slot++)
+    {
+        if (nodes_[0].child[slot] != BvhNode::INVALID_CHILD)
+        {
+            bounds.expand(getChildBounds(nodes_[0], slot));
+        }
+    }
+    return bounds;
+}
+
+Bvh::TraversalRay Bvh::prepareRay(const Ray& ray)
+{
+    TraversalRay traversalRay {};
+    traversalRay.origin = ray.origin;
+
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        // a zero component would turn into 0 * inf = NaN in the slab test
+        float direction = ray.direction[axis];
+        if (std::abs(direction) < 1e-20F)
+        {
+            direction = std::copysign(1e-20F, direction);
+        }
+        traversalRay.inverseDirection[axis] = 1.0F / direction;
+    }
+
+    traversalRay.nearX = traversalRay.inverseDirection.x >= 0.0F ? 0 : 3;
+    traversalRay.nearY = traversalRay.inverseDirection.y >= 0.0F ? 1 : 4;
+    traversalRay.nearZ = traversalRay.inverseDirection.z >= 0.0F ? 2 : 5;
+    return traversalRay;
+}
+
+void Bvh::preparePacket(const RayPacket& packet, TraversalPacket& traversalPacket)
+{
+    for (uint32_t lane = 0; lane < RayPacket::WIDTH; lane++)
+    {
+        const TraversalRay traversalRay = prepareRay(packet.rays[lane]);
+        traversalPacket.originX[lane]   = traversalRay.origin.x;
+        traversalPacket.originY[lane]   = traversalRay.origin.y;
+        traversalPacket.originZ[lane]   = traversalRay.origin.z;
+        traversalPacket.inverseX[lane]  = traversalRay.inverseDirection.x;
+        traversalPacket.inverseY[lane]  = traversalRay.inverseDirection.y;
+        traversalPacket.inverseZ[lane]  = traversalRay.inverseDirection.z;
+        traversalPacket.tMax[lane]      = packet.rays[lane].tMax;
+    }
+}
+
+uint32_t Bvh::intersectChildren(const BvhNode& node, const TraversalRay& ray, float tMax, float* tNear)
+{
+    // entering through the near plane and leaving through the far one of every slab. Empty slots have inverted
+    // infinite bounds, which makes them enter at +inf and leave at -inf
+    const uint32_t farX = (ray.nearX + 3) % 6;
+    const uint32_t farY = (ray.nearY + 3) % 6;
+    const uint32_t farZ = (ray.nearZ + 3) % 6;
+
+#if defined(BVH_SSE2)
+    const __m128 originX  = _mm_set1_ps(ray.origin.x);
+    const __m128 originY  = _mm_set1_ps(ray.origin.y);
+    const __m128 originZ  = _mm_set1_ps(ray.origin.z);
+    const __m128 inverseX = _mm_set1_ps(ray.inverseDirection.x);
+    const __m128 inverseY = _mm_set1_ps(ray.inverseDirection.y);
+    const __m128 inverseZ = _mm_set1_ps(ray.inverseDirection.z);
+
+    const __m128 nearX = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.bounds[ray.nearX]), originX), inverseX);
+    const __m128 nearY = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.bounds[ray.nearY]), originY), inverseY);
+    const __m128 nearZ = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.bounds[ray.nearZ]), originZ), inverseZ);
+    const __m128 farXs = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.bounds[farX]), originX), inverseX);
+    const __m128 farYs = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.bounds[farY]), originY), inverseY);
+    const __m128 farZs = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.bounds[farZ]), originZ), inverseZ);
+
+    const __m128 entry = _mm_max_ps(_mm_max_ps(nearX, nearY), _mm_max_ps(nearZ, _mm_setzero_ps()));
+    const __m128 exit  = _mm_min_ps(_mm_min_ps(farXs, farYs), _mm_min_ps(farZs, _mm_set1_ps(tMax)));
+
+    _mm_storeu_ps(tNear, entry);
+    return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(entry, exit)));
+#elif defined(BVH_NEON)
+    const float32x4_t originX  = vdupq_n_f32(ray.origin.x);
+    const float32x4_t originY  = vdupq_n_f32(ray.origin.y);
+    const float32x4_t originZ  = vdupq_n_f32(ray.origin.z);
+    const float32x4_t inverseX = vdupq_n_f32(ray.inverseDirection.x);
+    const float32x4_t inverseY = vdupq_n_f32(ray.inverseDirection.y);
+    const float32x4_t inverseZ = vdupq_n_f32(ray.inverseDirection.z);
+
+    const float32x4_t nearX = vmulq_f32(vsubq_f32(vld1q_f32(node.bounds[ray.nearX]), originX), inverseX);
+    const float32x4_t nearY = vmulq_f32(vsubq_f32(vld1q_f32(node.bounds[ray.nearY]), originY), inverseY);
+    const float32x4_t nearZ = vmulq_f32(vsubq_f32(vld1q_f32(node.bounds[ray.nearZ]), originZ), inverseZ);
+    const float32x4_t farXs = vmulq_f32(vsubq_f32(vld1q_f32(node.bounds[farX]), originX), inverseX);
+    const float32x4_t farYs = vmulq_f32(vsubq_f32(vld1q_f32(node.bounds[farY]), originY), inverseY);
+    const float32x4_t farZs = vmulq_f32(vsubq_f32(vld1q_f32(node.bounds[farZ]), originZ), inverseZ);
+
+    const float32x4_t entry = vmaxq_f32(vmaxq_f32(nearX, nearY), vmaxq_f32(nearZ, vdupq_n_f32(0.0F)));
+    const float32x4_t exit  = vminq_f32(vminq_f32(farXs, farYs), vminq_f32(farZs, vdupq_n_f32(tMax)));
+
+    vst1q_f32(tNear, entry);
+    const uint32x4_t bits = {1U, 2U, 4U, 8U};
+    return vaddvq_u32(vandq_u32(vcleq_f32(entry, exit), bits));
+#else
+    uint32_t mask = 0;
+    for (uint32_t slot = 0; slot < BvhNode::WIDTH; slot++)
+    {
+        const float nearX = (node.bounds[ray.nearX][slot] - ray.origin.x) * ray.inverseDirection.x;
+        const float nearY = (node.bounds[ray.nearY][slot] - ray.origin.y) * ray.inverseDirection.y;
+        const float nearZ = (node.bounds[ray.nearZ][slot] - ray.origin.z) * ray.inverseDirection.z;
+        const float farXs = (node.bounds[farX][slot] - ray.origin.x) * ray.inverseDirection.x;
+        const float farYs = (node.bounds[farY][slot] - ray.origin.y) * ray.inverseDirection.y;
+        const float farZs = (node.bounds[farZ][slot] - ray.origin.z) * ray.inverseDirection.z;
+
+        tNear[slot]      = std::max({nearX, nearY, nearZ, 0.0F});
+        const float exit = std::min({farXs, farYs, farZs, tMax});
+        mask |= tNear[slot] <= exit ? 1U << slot : 0U;
+    }
+    return mask;
+#endif
+}
+
+uint32_t Bvh::intersectChildPacket(
+    const BvhNode& node, uint32_t slot, const TraversalPacket& packet, uint32_t rayMask, float& tNear)
+{
+    // the rays point different ways, so every lane orders the planes of a slab itself. Only valid slots get here, the
+    // inverted bounds of empty ones would come out as an infinite slab
+#if defined(BVH_SSE2)
+    const __m128 slabX0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.bounds[0][slot]), _mm_load_ps(packet.originX)),
+                                     _mm_load_ps(packet.inverseX));
+    const __m128 slabY0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.bounds[1][slot]), _mm_load_ps(packet.originY)),
+                                     _mm_load_ps(packet.inverseY));
+    const __m128 slabZ0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.bounds[2][slot]), _mm_load_ps(packet.originZ)),
+                                     _mm_load_ps(packet.inverseZ));
+    const __m128 slabX1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.bounds[3][slot]), _mm_load_ps(packet.originX)),
+                                     _mm_load_ps(packet.inverseX));
+    const __m128 slabY1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.bounds[4][slot]), _mm_load_ps(packet.originY)),
+                                     _mm_load_ps(packet.inverseY));
+    const __m128 slabZ1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.bounds[5][slot]), _mm_load_ps(packet.originZ)),
+                                     _mm_load_ps(packet.inverseZ));
+
+    const __m128 entry = _mm_max_ps(_mm_max_ps(_mm_min_ps(slabX0, slabX1), _mm_min_ps(slabY0, slabY1)),
+                                    _mm_max_ps(_mm_min_ps(slabZ0, slabZ1), _mm_setzero_ps()));
+    const __m128 exit  = _mm_min_ps(_mm_min_ps(_mm_max_ps(slabX0, slabX1), _mm_max_ps(slabY0, slabY1)),
+                                   _mm_min_ps(_mm_max_ps(slabZ0, slabZ1), _mm_load_ps(packet.tMax)));
+
+    alignas(16) float entries[RayPacket::WIDTH];
+    _mm_store_ps(entries, entry);
+    const uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(entry, exit))) & rayMask;
+#elif defined(BVH_NEON)
+    const float32x4_t slabX0 =
+        vmulq_f32(vsubq_f32(vdupq_n_f32(node.bounds[0][slot]), vld1q_f32(packet.originX)), vld1q_f32(packet.inverseX));
+    const float32x4_t slabY0 =
+        vmulq_f32(vsubq_f32(vdupq_n_f32(node.bounds[1][slot]), vld1q_f32(packet.originY)), vld1q_f32(packet.inverseY));
+    const float32x4_t slabZ0 =
+        vmulq_f32(vsubq_f32(vdupq_n_f32(node.bounds[2][slot]), vld1q_f32(packet.originZ)), vld1q_f32(packet.inverseZ));
+    const float32x4_t slabX1 =
+        vmulq_f32(vsubq_f32(vdupq_n_f32(node.bounds[3][slot]), vld1q_f32(packet.originX)), vld1q_f32(packet.inverseX));
+    const float32x4_t slabY1 =
+        vmulq_f32(vsubq_f32(vdupq_n_f32(node.bounds[4][slot]), vld1q_f32(packet.originY)), vld1q_f32(packet.inverseY));
+    const float32x4_t slabZ1 =
+        vmulq_f32(vsubq_f32(vdupq_n_f32(node.bounds[5][slot]), vld1q_f32(packet.originZ)), vld1q_f32(packet.inverseZ));
+
+    const float32x4_t entry = vmaxq_f32(vmaxq_f32(vminq_f32(slabX0, slabX1), vminq_f32(slabY0, slabY1)),
+                                        vmaxq_f32(vminq_f32(slabZ0, slabZ1), vdupq_n_f32(0.0F)));
+    const float32x4_t exit  = vminq_f32(vminq_f32(vmaxq_f32(slabX0, slabX1), vmaxq_f32(slabY0, slabY1)),
+                                       vminq_f32(vmaxq_f32(slabZ0, slabZ1), vld1q_f32(packet.tMax)));
+
+    float entries[RayPacket::WIDTH];
+    vst1q_f32(entries, entry);
+    const uint32x4_t bits = {1U, 2U, 4U, 8U};
+    const uint32_t   mask = vaddvq_u32(vandq_u32(vcleq_f32(entry, exit), bits)) & rayMask;
+#else
+    float    entries[RayPacket::WIDTH];
+    uint32_t mask = 0;
+    for (uint32_t lane = 0; lane < RayPacket::WIDTH; lane++)
+    {
+        const float slabX0 = (node.bounds[0][slot] - packet.originX[lane]) * packet.inverseX[lane];
+        const float slabY0 = (node.bounds[1][slot] - packet.originY[lane]) * packet.inverseY[lane];
+        const float slabZ0 = (node.bounds[2][slot] - packet.originZ[lane]) * packet.inverseZ[lane];
+        const float slabX1 = (node.bounds[3][slot] - packet.originX[lane]) * packet.inverseX[lane];
+        const float slabY1 = (node.bounds[4][slot] - packet.originY[lane]) * packet.inverseY[lane];
+        const float slabZ1 = (node.bounds[5][slot] - packet.originZ[lane]) * packet.inverseZ[lane];
+
+        entries[lane] = std::max({std::min(slabX0, slabX1), std::min(slabY0, slabY1), std::min(slabZ0, slabZ1), 0.0F});
+        const float exit =
+            std::min({std::max(slabX0, slabX1), std::max(slabY0, slabY1), std::max(slabZ0, slabZ1), packet.tMax[lane]});
+        mask |= entries[lane] <= exit ? 1U << lane : 0U;
+    }
+    mask &= rayMask;
+#endif
+
+    tNear = std::numeric_limits<float>::max();
+    for (uint32_t lane = 0; lane < RayPacket::WIDTH; lane++)
+    {
+        if ((mask & (1U << lane)) != 0)
+        {
+            tNear = std::min(tNear, entries[lane]);
+        }
+    }
+    return mask;
+}
+
+Aabb Bvh::getChildBounds(const BvhNode& node, uint32_t slot)
+{
+    Aabb bounds {};
+    bounds.min = {node.bounds[0][slot], node.bounds[1][slot], node.bounds[2][slot]};
+    bounds.max = {node.bounds[3][slot], node.bounds[4][slot], node.bounds[5][slot]};
+    return bounds;
+}
+
+void Bvh::setChildBounds(BvhNode& node, uint32_t slot, const Aabb& bounds)
+{
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        node.bounds[axis][slot]     = bounds.min[axis];
+        node.bounds[axis + 3][slot] = bounds.max[axis];
+    }
+}
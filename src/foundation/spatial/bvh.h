@@ -0,0 +1,293 @@
+#pragma once
+
+#include "foundation/job/job_system.h"
+#include "foundation/math/aabb.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+struct Ray
+{
+    glm::vec3 origin {0.0F};
+    glm::vec3 direction {0.0F, 0.0F, 1.0F};
+    float     tMax {std::numeric_limits<float>::max()};
+};
+
+// Rays traced through the tree together, every node is fetched and tested once for all rays that reach it. Pays off
+// for coherent rays, like the samples of one texel or shadow rays towards the same light. Rays outside activeMask are
+// left alone
+struct RayPacket
+{
+    static constexpr uint32_t WIDTH = 4;
+
+    Ray      rays[WIDTH];
+    uint32_t activeMask {(1U << WIDTH) - 1};
+};
+
+struct BvhBuildSettings
+{
+    // split candidates per axis, at most 32
+    uint32_t binCount {16};
+    uint32_t maxLeafSize {4};
+    // ranges with more primitives than this are binned by all threads together, smaller ones become subtrees that
+    // are built on a single thread each
+    uint32_t parallelThreshold {16384};
+    // cost of visiting a node relative to intersecting one primitive
+    float traversalCost {1.0F};
+};
+
+struct BvhStatistics
+{
+    uint32_t nodeCount {0};
+    uint32_t leafCount {0};
+    uint32_t maxDepth {0};
+    uint32_t subtreeCount {0};
+    // expected primitive tests plus node visits of a random ray hitting the root, lower is better
+    float sahCost {0.0F};
+};
+
+// Four children per node with their bounds in structure of arrays layout, so a single SIMD slab test covers all of
+// them. Exactly two cache lines. Unused slots have empty bounds and an invalid child.
+struct alignas(64) BvhNode
+{
+    static constexpr uint32_t WIDTH         = 4;
+    static constexpr uint32_t INVALID_CHILD = 0xFFFFFFFFU;
+
+    // min x, min y, min z, max x, max y, max z
+    float bounds[6][WIDTH];
+    // node index of an inner child, first entry of getPrimitiveIndices() for a leaf
+    uint32_t child[WIDTH];
+    // primitives of a leaf child, 0 for an inner child
+    uint32_t count[WIDTH];
+};
+
+// Bounding volume hierarchy over arbitrary primitives given by their bounds. Built top down with binned SAH: the upper
+// levels bin their primitives on every thread of the job system, the subtrees below them are built concurrently.
+// The binary tree is then collapsed into 4 wide nodes stored depth first, so parents always come before their
+// children and refit is a single backwards sweep.
+//
+// Primitives are reordered so every leaf covers a contiguous range of getPrimitiveIndices(). Traversal callbacks
+// receive positions in that order, which lets callers store their primitive data in leaf order as well.
+class Bvh {
+public:
+    void build(const std::vector<Aabb>& primitiveBounds,
+               JobSystem*               jobSystem = nullptr,
+               const BvhBuildSettings&  settings  = {});
+
+    // primitives moved but the tree keeps its topology, bounds are indexed like in build
+    void refit(const std::vector<Aabb>& primitiveBounds);
+
+    // closest hit traversal, children are visited near to far. intersector(uint32_t primitive, Ray& ray) tests the
+    // primitive at that position of getPrimitiveIndices() and shortens ray.tMax when it hits. Safe to call from
+    // several threads at once
+    template <typename Intersector>
+    void intersect(Ray& ray, Intersector&& intersector) const;
+
+    // closest hit traversal of a packet. intersector(uint32_t primitive, RayPacket& packet, uint32_t rayMask) tests
+    // the primitive against the rays in the mask and shortens the tMax of those it hits. Children are visited in the
+    // order of the nearest ray entering them
+    template <typename Intersector>
+    void intersectPacket(RayPacket& packet, Intersector&& intersector) const;
+
+    // appends the original indices of all primitives whose bounds overlap the box
+    void query(const Aabb& bounds, std::vector<uint32_t>& primitives) const;
+
+    [[nodiscard]] bool                         isEmpty() const { return nodes_.empty(); }
+    [[nodiscard]] Aabb                         getBounds() const;
+    [[nodiscard]] const std::vector<BvhNode>&  getNodes() const { return nodes_; }
+    [[nodiscard]] const std::vector<uint32_t>& getPrimitiveIndices() const { return primitiveIndices_; }
+    [[nodiscard]] const BvhStatistics&         getStatistics() const { return statistics_; }
+
+private:
+    static constexpr uint32_t MAX_STACK_SIZE = 256;
+
+    // ray prepared for slab tests, near names the bounds row the ray enters a slab through
+    struct TraversalRay
+    {
+        glm::vec3 origin;
+        glm::vec3 inverseDirection;
+        uint32_t  nearX;
+        uint32_t  nearY;
+        uint32_t  nearZ;
+    };
+
+    // the rays of a packet in structure of arrays layout, one SIMD slab test covers a child for all of them
+    struct alignas(16) TraversalPacket
+    {
+        float originX[RayPacket::WIDTH];
+        float originY[RayPacket::WIDTH];
+        float originZ[RayPacket::WIDTH];
+        float inverseX[RayPacket::WIDTH];
+        float inverseY[RayPacket::WIDTH];
+        float inverseZ[RayPacket::WIDTH];
+        float tMax[RayPacket::WIDTH];
+    };
+
+    static TraversalRay prepareRay(const Ray& ray);
+    static void         preparePacket(const RayPacket& packet, TraversalPacket& traversalPacket);
+
+    // bit per child whose bounds the ray enters before tMax, tNear receives the entry distances
+    static uint32_t intersectChildren(const BvhNode& node, const TraversalRay& ray, float tMax, float* tNear);
+
+    // bit per ray of the mask that enters the child before its tMax, tNear receives the nearest entry distance
+    static uint32_t intersectChildPacket(
+        const BvhNode& node, uint32_t slot, const TraversalPacket& packet, uint32_t rayMask, float& tNear);
+
+    static Aabb getChildBounds(const BvhNode& node, uint32_t slot);
+    static void setChildBounds(BvhNode& node, uint32_t slot, const Aabb& bounds);
+
+    std::vector<BvhNode>  nodes_;
+    std::vector<uint32_t> primitiveIndices_;
+    BvhStatistics         statistics_ {};
+};
+
+template <typename Intersector>
+void Bvh::intersect(Ray& ray, Intersector&& intersector) const
+{
+    if (nodes_.empty())
+        return;
+
+    struct StackEntry
+    {
+        uint32_t node;
+        float    tNear;
+    };
+
+    const TraversalRay traversalRay = prepareRay(ray);
+
+    StackEntry stack[MAX_STACK_SIZE];
+    uint32_t   stackSize = 0;
+    stack[stackSize++]   = {0, 0.0F};
+
+    while (stackSize > 0)
+    {
+        const StackEntry entry = stack[--stackSize];
+
+        // something closer was hit since the node was pushed
+        if (entry.tNear > ray.tMax)
+            continue;
+
+        const BvhNode& node = nodes_[entry.node];
+
+        float          tNear[BvhNode::WIDTH];
+        const uint32_t hitMask = intersectChildren(node, traversalRay, ray.tMax, tNear);
+        if (hitMask == 0)
+            continue;
+
+        // sort the hit children by entry distance
+        uint32_t order[BvhNode::WIDTH];
+        uint32_t hitCount = 0;
+        for (uint32_t slot = 0; slot < BvhNode::WIDTH; slot++)
+        {
+            if ((hitMask & (1U << slot)) == 0)
+                continue;
+
+            uint32_t position = hitCount++;
+            while (position > 0 && tNear[order[position - 1]] > tNear[slot])
+            {
+                order[position] = order[position - 1];
+                position--;
+            }
+            order[position] = slot;
+        }
+
+        // leaves right away near to far so they shorten the ray, inner children go on the stack far to near
+        for (uint32_t index = 0; index < hitCount; index++)
+        {
+            const uint32_t slot = order[index];
+            if (node.count[slot] == 0 || tNear[slot] > ray.tMax)
+                continue;
+
+            for (uint32_t primitive = node.child[slot]; primitive < node.child[slot] + node.count[slot]; primitive++)
+            {
+                intersector(primitive, ray);
+            }
+        }
+        for (uint32_t index = hitCount; index-- > 0;)
+        {
+            const uint32_t slot = order[index];
+            if (node.count[slot] == 0)
+            {
+                stack[stackSize++] = {node.child[slot], tNear[slot]};
+            }
+        }
+    }
+}
+
+template <typename Intersector>
+void Bvh::intersectPacket(RayPacket& packet, Intersector&& intersector) const
+{
+    if (nodes_.empty() || packet.activeMask == 0)
+        return;
+
+    struct StackEntry
+    {
+        uint32_t node;
+        uint32_t rayMask;
+    };
+
+    TraversalPacket traversalPacket;
+    preparePacket(packet, traversalPacket);
+
+    StackEntry stack[MAX_STACK_SIZE];
+    uint32_t   stackSize = 0;
+    stack[stackSize++]   = {0, packet.activeMask};
+
+    while (stackSize > 0)
+    {
+        const StackEntry entry = stack[--stackSize];
+        const BvhNode&   node  = nodes_[entry.node];
+
+        // hits since the node was pushed shortened the rays
+        for (uint32_t lane = 0; lane < RayPacket::WIDTH; lane++)
+        {
+            traversalPacket.tMax[lane] = packet.rays[lane].tMax;
+        }
+
+        float    tNear[BvhNode::WIDTH];
+        uint32_t rayMasks[BvhNode::WIDTH];
+        uint32_t order[BvhNode::WIDTH];
+        uint32_t hitCount = 0;
+        for (uint32_t slot = 0; slot < BvhNode::WIDTH; slot++)
+        {
+            if (node.child[slot] == BvhNode::INVALID_CHILD)
+                continue;
+
+            rayMasks[slot] = intersectChildPacket(node, slot, traversalPacket, entry.rayMask, tNear[slot]);
+            if (rayMasks[slot] == 0)
+                continue;
+
+            uint32_t position = hitCount++;
+            while (position > 0 && tNear[order[position - 1]] > tNear[slot])
+            {
+                order[position] = order[position - 1];
+                position--;
+            }
+            order[position] = slot;
+        }
+
+        // leaves right away near to far so they shorten the rays, inner children go on the stack far to near
+        for (uint32_t index = 0; index < hitCount; index++)
+        {
+            const uint32_t slot = order[index];
+            if (node.count[slot] == 0)
+                continue;
+
+            for (uint32_t primitive = node.child[slot]; primitive < node.child[slot] + node.count[slot]; primitive++)
+            {
+                intersector(primitive, packet, rayMasks[slot]);
+            }
+        }
+        for (uint32_t index = hitCount; index-- > 0;)
+        {
+            const uint32_t slot = order[index];
+            if (node.count[slot] == 0)
+            {
+                stack[stackSize++] = {node.child[slot], rayMasks[slot]};
+            }
+        }
+    }
+}
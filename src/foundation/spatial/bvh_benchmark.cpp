@@ -0,0 +1,293 @@
+#include "foundation/spatial/bvh_benchmark.h"
+#include "foundation/spatial/mesh_bvh.h"
+
+#include "foundation/job/job_system.h"
+#include "foundation/log/log_system.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <tiny_obj_loader.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace
+{
+using Clock = std::chrono::high_resolution_clock;
+
+double getMilliseconds(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+bool loadPositions(const std::string& path, std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices)
+{
+    tinyobj::attrib_t                attrib;
+    std::vector<tinyobj::shape_t>    shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string                      warn;
+    std::string                      err;
+
+    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str()))
+    {
+        LOG_ERROR("bvh: failed to load {}: {} {}", path, warn, err);
+        return false;
+    }
+
+    for (size_t vertex = 0; vertex + 2 < attrib.vertices.size(); vertex += 3)
+    {
+        positions.emplace_back(attrib.vertices[vertex], attrib.vertices[vertex + 1], attrib.vertices[vertex + 2]);
+    }
+    for (const auto& shape : shapes)
+    {
+        for (const auto& index : shape.mesh.indices)
+        {
+            indices.push_back(static_cast<uint32_t>(index.vertex_index));
+        }
+    }
+    return true;
+}
+} // namespace
+
+int BvhBenchmark::run(const BvhBenchmarkSettings& settings)
+{
+    std::vector<glm::vec3> modelPositions;
+    std::vector<uint32_t>  modelIndices;
+    if (!loadPositions(settings.modelPath, modelPositions, modelIndices))
+        return EXIT_FAILURE;
+
+    Aabb modelBounds {};
+    for (const auto& position : modelPositions)
+    {
+        modelBounds.expand(position);
+    }
+
+    // copies side by side on the xy plane with a little gap, z is up
+    const uint32_t  copiesPerSide = std::max(1U, settings.copiesPerSide);
+    const uint32_t  copyCount     = copiesPerSide * copiesPerSide;
+    const glm::vec3 spacing       = modelBounds.getExtent() * 1.1F;
+
+    std::vector<glm::vec3> basePositions;
+    std::vector<uint32_t>  indices;
+    basePositions.reserve(modelPositions.size() * copyCount);
+    indices.reserve(modelIndices.size() * copyCount);
+    for (uint32_t copy = 0; copy < copyCount; copy++)
+    {
+        const glm::vec3 offset {spacing.x * static_cast<float>(copy % copiesPerSide),
+                                spacing.y * static_cast<float>(copy / copiesPerSide),
+                                0.0F};
+        const uint32_t  firstVertex = static_cast<uint32_t>(basePositions.size());
+        for (const auto& position : modelPositions)
+        {
+            basePositions.push_back(position + offset);
+        }
+        for (const uint32_t index : modelIndices)
+        {
+            indices.push_back(firstVertex + index);
+        }
+    }
+    const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+    JobSystem jobSystem(std::max(1U, settings.threadCount) - 1);
+
+    MeshBvh        bvh;
+    const uint32_t buildIterations = std::max(1U, settings.buildIterations);
+
+    double serialBuildMs = std::numeric_limits<double>::max();
+    for (uint32_t iteration = 0; iteration < buildIterations; iteration++)
+    {
+        const auto start = Clock::now();
+        bvh.build(basePositions, indices);
+        serialBuildMs = std::min(serialBuildMs, getMilliseconds(start));
+    }
+    const float serialSahCost = bvh.getBvh().getStatistics().sahCost;
+
+    double parallelBuildMs = std::numeric_limits<double>::max();
+    for (uint32_t iteration = 0; iteration < buildIterations; iteration++)
+    {
+        const auto start = Clock::now();
+        bvh.build(basePositions, indices, &jobSystem);
+        parallelBuildMs = std::min(parallelBuildMs, getMilliseconds(start));
+    }
+
+    const BvhStatistics& statistics = bvh.getBvh().getStatistics();
+    LOG_INFO("bvh: {} triangles in {} copies of {}", triangleCount, copyCount, settings.modelPath);
+    LOG_INFO("bvh: build {:.2f} ms on 1 thread, {:.2f} ms on {} threads ({} subtrees), {:.1f} M triangles/s",
+             serialBuildMs,
+             parallelBuildMs,
+             jobSystem.getThreadCount(),
+             statistics.subtreeCount,
+             parallelBuildMs > 0.0 ? triangleCount / (parallelBuildMs * 1000.0) : 0.0);
+    LOG_INFO("bvh: {} nodes ({} bytes), {} leaves, depth {}, sah cost {:.2f} serial / {:.2f} parallel",
+             statistics.nodeCount,
+             statistics.nodeCount * sizeof(BvhNode),
+             statistics.leafCount,
+             statistics.maxDepth,
+             serialSahCost,
+             statistics.sahCost);
+
+    // looking down at the grid from one corner
+    const Aabb      worldBounds = bvh.getBvh().getBounds();
+    const glm::vec3 center      = worldBounds.getCenter();
+    const glm::vec3 extent      = worldBounds.getExtent();
+    const glm::vec3 eye         = center + glm::vec3(-0.6F * extent.x, -0.6F * extent.y, 0.4F * (extent.x + extent.y));
+    const glm::mat4 inverseViewProjection =
+        glm::inverse(glm::perspective(glm::radians(60.0F), 1.0F, 0.1F, 1000.0F) *
+                     glm::lookAt(eye, center, glm::vec3(0.0F, 0.0F, 1.0F)));
+
+    const uint32_t resolution = std::max(1U, settings.rayResolution);
+    const auto     makeRay    = [&](uint32_t pixel) {
+        const glm::vec2 pixelCenter {static_cast<float>(pixel % resolution) + 0.5F,
+                                     static_cast<float>(pixel / resolution) + 0.5F};
+        const glm::vec2 ndc      = pixelCenter / static_cast<float>(resolution) * 2.0F - 1.0F;
+        const glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndc, 1.0F, 1.0F);
+
+        Ray ray {};
+        ray.origin    = eye;
+        ray.direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - eye);
+        return ray;
+    };
+
+    const uint32_t rayCount = resolution * resolution;
+
+    // returns the time for all primary rays and the number that hit
+    const auto traceRays = [&](JobSystem* jobs, uint32_t& hitCount) {
+        std::atomic<uint32_t> hits {0};
+        const auto            traceRange = [&](uint32_t begin, uint32_t end) {
+            uint32_t localHits = 0;
+            for (uint32_t pixel = begin; pixel < end; pixel++)
+            {
+                RayHit hit {};
+                localHits += bvh.raycast(makeRay(pixel), hit) ? 1 : 0;
+            }
+            hits.fetch_add(localHits, std::memory_order_relaxed);
+        };
+
+        const auto start = Clock::now();
+        if (jobs != nullptr)
+        {
+            jobs->parallelFor(rayCount, resolution, traceRange);
+        }
+        else
+        {
+            traceRange(0, rayCount);
+        }
+        hitCount = hits.load();
+        return getMilliseconds(start);
+    };
+
+    uint32_t     hitCount   = 0;
+    const double serialMs   = traceRays(nullptr, hitCount);
+    const double parallelMs = traceRays(&jobSystem, hitCount);
+    LOG_INFO("bvh: {} primary rays, {:.1f}% hit, {:.2f} M rays/s on 1 thread, {:.2f} M rays/s on {} threads",
+             rayCount,
+             100.0 * hitCount / rayCount,
+             serialMs > 0.0 ? rayCount / (serialMs * 1000.0) : 0.0,
+             parallelMs > 0.0 ? rayCount / (parallelMs * 1000.0) : 0.0,
+             jobSystem.getThreadCount());
+
+    // picking, every ray is checked against the scan over every triangle
+    const auto comparePicks = [&](const char* label) {
+        const uint32_t pickCount  = std::min(rayCount, settings.bruteForceRayCount);
+        uint32_t       mismatches = 0;
+        double         bvhMs      = 0.0;
+        double         scanMs     = 0.0;
+        for (uint32_t pick = 0; pick < pickCount; pick++)
+        {
+            const Ray ray = makeRay(static_cast<uint32_t>(static_cast<uint64_t>(pick) * rayCount / pickCount));
+
+            RayHit     bvhHit {};
+            const auto bvhStart = Clock::now();
+            bvh.raycast(ray, bvhHit);
+            bvhMs += getMilliseconds(bvhStart);
+
+            RayHit     scanHit {};
+            const auto scanStart = Clock::now();
+            bvh.raycastBruteForce(ray, scanHit);
+            scanMs += getMilliseconds(scanStart);
+
+            if (bvhHit.isHit() != scanHit.isHit() ||
+                std::abs(bvhHit.distance - scanHit.distance) > 1e-4F * std::max(1.0F, scanHit.distance))
+            {
+                mismatches++;
+            }
+        }
+
+        LOG_INFO("bvh: {} picks {}, {:.2f} us per pick with the tree, {:.1f} us scanning every triangle",
+                 pickCount,
+                 label,
+                 pickCount > 0 ? bvhMs * 1000.0 / pickCount : 0.0,
+                 pickCount > 0 ? scanMs * 1000.0 / pickCount : 0.0);
+        if (mismatches > 0)
+        {
+            LOG_WARN("bvh: {} of {} picks disagree with the scan", mismatches, pickCount);
+        }
+        return mismatches;
+    };
+
+    uint32_t mismatches = comparePicks("after the build");
+
+    // overlap queries of object sized boxes, what collision and culling would ask for
+    std::mt19937                          random(1234);
+    std::uniform_real_distribution<float> unit(0.0F, 1.0F);
+    std::vector<uint32_t>                 overlapping;
+    uint64_t                              overlapCount = 0;
+
+    const auto queryStart = Clock::now();
+    for (uint32_t query = 0; query < settings.boxQueryCount; query++)
+    {
+        const glm::vec3 point = worldBounds.min + extent * glm::vec3(unit(random), unit(random), unit(random));
+        Aabb            box {};
+        box.expand(point - modelBounds.getExtent() * 0.05F);
+        box.expand(point + modelBounds.getExtent() * 0.05F);
+
+        overlapping.clear();
+        bvh.queryTriangles(box, overlapping);
+        overlapCount += overlapping.size();
+    }
+    const double queryMs = getMilliseconds(queryStart);
+    LOG_INFO("bvh: {} box queries, {:.2f} us per query, {:.1f} triangles per query",
+             settings.boxQueryCount,
+             settings.boxQueryCount > 0 ? queryMs * 1000.0 / settings.boxQueryCount : 0.0,
+             settings.boxQueryCount > 0 ? static_cast<double>(overlapCount) / settings.boxQueryCount : 0.0);
+
+    // every copy bobs and drifts on its own, the topology from the first build is kept
+    std::vector<glm::vec3> positions       = basePositions;
+    double                 refitMs         = 0.0;
+    const uint32_t         refitIterations = std::max(1U, settings.refitIterations);
+    for (uint32_t iteration = 0; iteration < refitIterations; iteration++)
+    {
+        const size_t verticesPerCopy = modelPositions.size();
+        for (size_t vertex = 0; vertex < positions.size(); vertex++)
+        {
+            const float     phase = static_cast<float>(iteration) * 0.3F + static_cast<float>(vertex / verticesPerCopy);
+            const glm::vec3 drift {std::sin(phase), std::cos(phase), std::sin(phase * 0.5F)};
+            positions[vertex] = basePositions[vertex] + drift * spacing * 0.2F;
+        }
+
+        const auto start = Clock::now();
+        bvh.refit(positions);
+        refitMs += getMilliseconds(start);
+    }
+
+    const double refitRayMs = traceRays(&jobSystem, hitCount);
+    mismatches += comparePicks("after refitting");
+
+    const auto rebuildStart = Clock::now();
+    bvh.build(positions, indices, &jobSystem);
+    const double rebuildMs    = getMilliseconds(rebuildStart);
+    const double rebuildRayMs = traceRays(&jobSystem, hitCount);
+
+    LOG_INFO("bvh: refit {:.2f} ms against a {:.2f} ms rebuild, rays {:.2f} M/s refitted and {:.2f} M/s rebuilt",
+             refitMs / refitIterations,
+             rebuildMs,
+             refitRayMs > 0.0 ? rayCount / (refitRayMs * 1000.0) : 0.0,
+             rebuildRayMs > 0.0 ? rayCount / (rebuildRayMs * 1000.0) : 0.0);
+
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
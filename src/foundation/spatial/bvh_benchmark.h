@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+struct BvhBenchmarkSettings
+{
+    std::string modelPath {"E:/projects/learn_vulkan/data/models/viking_room.obj"};
+    // the model is repeated on a copiesPerSide x copiesPerSide grid
+    uint32_t copiesPerSide {8};
+    uint32_t threadCount {4};
+    uint32_t buildIterations {5};
+    uint32_t refitIterations {20};
+    // primary rays of a rayResolution x rayResolution view over the grid
+    uint32_t rayResolution {512};
+    // rays checked against a scan over every triangle
+    uint32_t bruteForceRayCount {256};
+    uint32_t boxQueryCount {10000};
+};
+
+// Builds a MeshBvh over a grid of copies of a model and measures serial and parallel build times, refit time, ray and
+// box query throughput. Picking rays are compared against testing every triangle, which is also what each pick costs
+// without the tree.
+class BvhBenchmark {
+public:
+    static int run(const BvhBenchmarkSettings& settings);
+};
@@ -0,0 +1,156 @@
+#include "foundation/spatial/mesh_bvh.h"
+
+#include <cmath>
+
+void MeshBvh::build(const std::vector<glm::vec3>& positions,
+                    const std::vector<uint32_t>&  indices,
+                    JobSystem*                    jobSystem,
+                    const BvhBuildSettings&       settings)
+{
+    indices_ = indices;
+
+    const size_t triangleCount = indices_.size() / 3;
+    triangleBounds_.resize(triangleCount);
+    for (size_t triangle = 0; triangle < triangleCount; triangle++)
+    {
+        Aabb& bounds = triangleBounds_[triangle];
+        bounds       = {};
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            bounds.expand(positions[indices_[triangle * 3 + corner]]);
+        }
+    }
+
+    bvh_.build(triangleBounds_, jobSystem, settings);
+
+    triangles_.resize(triangleCount);
+    gatherTriangles(positions);
+}
+
+void MeshBvh::refit(const std::vector<glm::vec3>& positions)
+{
+    gatherTriangles(positions);
+    bvh_.refit(triangleBounds_);
+}
+
+bool MeshBvh::raycast(const Ray& ray, RayHit& hit) const
+{
+    hit = {};
+
+    Ray                          query            = ray;
+    const std::vector<uint32_t>& primitiveIndices = bvh_.getPrimitiveIndices();
+    bvh_.intersect(query, [&](uint32_t primitive, Ray& currentRay) {
+        float     distance {0.0F};
+        glm::vec2 barycentric {0.0F};
+        if (intersectTriangle(triangles_[primitive], currentRay, distance, barycentric))
+        {
+            currentRay.tMax = distance;
+            hit.triangle    = primitiveIndices[primitive];
+            hit.distance    = distance;
+            hit.barycentric = barycentric;
+        }
+    });
+
+    return hit.isHit();
+}
+
+uint32_t MeshBvh::raycastPacket(const RayPacket& packet, RayHit (&hits)[RayPacket::WIDTH]) const
+{
+    for (RayHit& hit : hits)
+    {
+        hit = {};
+    }
+
+    RayPacket                    query            = packet;
+    uint32_t                     hitMask          = 0;
+    const std::vector<uint32_t>& primitiveIndices = bvh_.getPrimitiveIndices();
+    bvh_.intersectPacket(query, [&](uint32_t primitive, RayPacket& currentPacket, uint32_t rayMask) {
+        for (uint32_t lane = 0; lane < RayPacket::WIDTH; lane++)
+        {
+            float     distance {0.0F};
+            glm::vec2 barycentric {0.0F};
+            if ((rayMask & (1U << lane)) == 0 ||
+                !intersectTriangle(triangles_[primitive], currentPacket.rays[lane], distance, barycentric))
+                continue;
+
+            currentPacket.rays[lane].tMax = distance;
+            hits[lane].triangle           = primitiveIndices[primitive];
+            hits[lane].distance           = distance;
+            hits[lane].barycentric        = barycentric;
+            hitMask |= 1U << lane;
+        }
+    });
+
+    return hitMask;
+}
+
+bool MeshBvh::raycastBruteForce(const Ray& ray, RayHit& hit) const
+{
+    hit = {};
+
+    Ray                          query            = ray;
+    const std::vector<uint32_t>& primitiveIndices = bvh_.getPrimitiveIndices();
+    for (uint32_t primitive = 0; primitive < triangles_.size(); primitive++)
+    {
+        float     distance {0.0F};
+        glm::vec2 barycentric {0.0F};
+        if (intersectTriangle(triangles_[primitive], query, distance, barycentric))
+        {
+            query.tMax      = distance;
+            hit.triangle    = primitiveIndices[primitive];
+            hit.distance    = distance;
+            hit.barycentric = barycentric;
+        }
+    }
+
+    return hit.isHit();
+}
+
+void MeshBvh::queryTriangles(const Aabb& bounds, std::vector<uint32_t>& triangles) const
+{
+    bvh_.query(bounds, triangles);
+}
+
+void MeshBvh::gatherTriangles(const std::vector<glm::vec3>& positions)
+{
+    const std::vector<uint32_t>& primitiveIndices = bvh_.getPrimitiveIndices();
+    for (size_t primitive = 0; primitive < triangles_.size(); primitive++)
+    {
+        const uint32_t   triangle = primitiveIndices[primitive];
+        const glm::vec3& vertex0  = positions[indices_[triangle * 3 + 0]];
+        const glm::vec3& vertex1  = positions[indices_[triangle * 3 + 1]];
+        const glm::vec3& vertex2  = positions[indices_[triangle * 3 + 2]];
+
+        triangles_[primitive] = {vertex0, vertex1 - vertex0, vertex2 - vertex0};
+
+        Aabb& bounds = triangleBounds_[triangle];
+        bounds       = {};
+        bounds.expand(vertex0);
+        bounds.expand(vertex1);
+        bounds.expand(vertex2);
+    }
+}
+
+bool MeshBvh::intersectTriangle(const Triangle& triangle, const Ray& ray, float& distance, glm::vec2& barycentric)
+{
+    // Moeller-Trumbore
+    const glm::vec3 p           = glm::cross(ray.direction, triangle.edge2);
+    const float     determinant = glm::dot(triangle.edge1, p);
+    if (std::abs(determinant) < 1e-12F)
+        return false;
+
+    const float     inverseDeterminant = 1.0F / determinant;
+    const glm::vec3 t                  = ray.origin - triangle.vertex0;
+    const float     u                  = glm::dot(t, p) * inverseDeterminant;
+    if (u < 0.0F || u > 1.0F)
+        return false;
+
+    const glm::vec3 q = glm::cross(t, triangle.edge1);
+    const float     v = glm::dot(ray.direction, q) * inverseDeterminant;
+    if (v < 0.0F || u + v > 1.0F)
+        return false;
+
+    distance    = glm::dot(triangle.edge2, q) * inverseDeterminant;
+    barycentric = {u, v};
+    return distance > 0.0F && distance < ray.tMax;
+}
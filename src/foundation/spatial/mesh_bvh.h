@@ -0,0 +1,67 @@
+#pragma once
+
+#include "foundation/spatial/bvh.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+struct RayHit
+{
+    static constexpr uint32_t NO_TRIANGLE = 0xFFFFFFFFU;
+
+    uint32_t  triangle {NO_TRIANGLE};
+    float     distance {std::numeric_limits<float>::max()};
+    glm::vec2 barycentric {0.0F};
+
+    [[nodiscard]] bool isHit() const { return triangle != NO_TRIANGLE; }
+};
+
+// Bvh over the triangles of an indexed mesh. The triangles are copied in leaf order as a vertex and two edges, so a
+// leaf is tested from one contiguous run of memory without going through the index buffer.
+class MeshBvh {
+public:
+    void build(const std::vector<glm::vec3>& positions,
+               const std::vector<uint32_t>&  indices,
+               JobSystem*                    jobSystem = nullptr,
+               const BvhBuildSettings&       settings  = {});
+
+    // the vertices moved, the index buffer is the same as in build
+    void refit(const std::vector<glm::vec3>& positions);
+
+    // closest triangle along the ray within ray.tMax, both windings count
+    bool raycast(const Ray& ray, RayHit& hit) const;
+
+    // closest triangles of the active rays of the packet traced together, hits of inactive rays stay empty. Returns
+    // the mask of the rays that hit something
+    uint32_t raycastPacket(const RayPacket& packet, RayHit (&hits)[RayPacket::WIDTH]) const;
+
+    // tests every triangle without the tree, the reference raycast is checked and measured against
+    bool raycastBruteForce(const Ray& ray, RayHit& hit) const;
+
+    // appends the index of every triangle whose bounds overlap the box
+    void queryTriangles(const Aabb& bounds, std::vector<uint32_t>& triangles) const;
+
+    [[nodiscard]] const Bvh& getBvh() const { return bvh_; }
+    [[nodiscard]] uint32_t   getTriangleCount() const { return static_cast<uint32_t>(triangles_.size()); }
+
+private:
+    struct Triangle
+    {
+        glm::vec3 vertex0;
+        glm::vec3 edge1;
+        glm::vec3 edge2;
+    };
+
+    // fills triangles_ in leaf order and the bounds in mesh order
+    void gatherTriangles(const std::vector<glm::vec3>& positions);
+
+    static bool intersectTriangle(const Triangle& triangle, const Ray& ray, float& distance, glm::vec2& barycentric);
+
+    std::vector<uint32_t> indices_;
+    std::vector<Triangle> triangles_;
+    std::vector<Aabb>     triangleBounds_;
+    Bvh                   bvh_;
+};
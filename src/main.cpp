@@ -1,7 +1,15 @@
 #define GLFW_INCLUDE_VULKAN
 
+#include "foundation/spatial/bvh_benchmark.h"
+#include "render/asset/impostor_baker.h"
+#include "render/asset/lightmap_baker.h"
+#include "render/backend/null/null_rhi_benchmark.h"
+#include "render/culling/dynamic_culling_benchmark.h"
+#include "render/culling/occlusion_culling_benchmark.h"
 #include "render/backend/vulkan/vulkan_app.h"
+#include <cstring>
 #include <iostream>
+#include <string>
 
 #include "foundation/log/log_system.h"
 
@@ -12,6 +20,45 @@ int main(int argc, char** argv)
     VulkanApp app;
     try
     {
+        // frontend throughput without a window or a gpu, usable on headless machines
+        if (argc > 1 && strcmp(argv[1], "--null-rhi-benchmark") == 0)
+        {
+            return NullRhiBenchmark::run({});
+        }
+        // measures the rhi replay only, the packets never reach a vulkan driver
+        if (argc > 2 && strcmp(argv[1], "--replay-rhi-trace") == 0)
+        {
+            const uint32_t iterations = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 100;
+            return NullRhiBenchmark::replayTrace(argv[2], iterations);
+        }
+        if (argc > 1 && strcmp(argv[1], "--occlusion-culling-benchmark") == 0)
+        {
+            return OcclusionCullingBenchmark::run({});
+        }
+        if (argc > 1 && strcmp(argv[1], "--bvh-benchmark") == 0)
+        {
+            BvhBenchmarkSettings settings {};
+            if (argc > 2)
+            {
+                settings.modelPath = argv[2];
+            }
+            return BvhBenchmark::run(settings);
+        }
+        if (argc > 1 && strcmp(argv[1], "--dynamic-culling-benchmark") == 0)
+        {
+            return DynamicCullingBenchmark::run({});
+        }
+        // cook step, bakes the impostor atlas of a mesh without a window or a gpu
+        if (argc > 4 && strcmp(argv[1], "--bake-impostor") == 0)
+        {
+            return ImpostorBaker::bakeFiles(argv[2], argv[3], argv[4]) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        // cook step, path traces the lightmap and the irradiance probes of a mesh without a window or a gpu
+        if (argc > 4 && strcmp(argv[1], "--bake-lightmap") == 0)
+        {
+            return LightmapBaker::bakeFiles(argv[2], argv[3], argv[4]) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
         app.run();
     }
     catch (const std::exception& e)
@@ -0,0 +1,88 @@
+#include "render/asset/asset_loader.h"
+
+#include "foundation/log/log_system.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+
+#include <chrono>
+#include <filesystem>
+
+namespace AssetLoader
+{
+Task<MeshAsset> loadMesh(TaskExecutor& executor, std::string path)
+{
+    co_await executor.schedule();
+
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    // materials are looked up next to the mesh
+    const std::string baseDirectory = std::filesystem::path(path).parent_path().string() + "/";
+
+    tinyobj::attrib_t                attrib;
+    std::vector<tinyobj::shape_t>    shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string                      warn;
+    std::string                      err;
+
+    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str(), baseDirectory.c_str()))
+    {
+        LOG_FATAL("{} {}", warn, err);
+    }
+
+    MeshAsset mesh;
+    for (const auto& shape : shapes)
+    {
+        for (const auto& index : shape.mesh.indices)
+        {
+            mesh.positions.emplace_back(attrib.vertices[3 * index.vertex_index + 0],
+                                        attrib.vertices[3 * index.vertex_index + 1],
+                                        attrib.vertices[3 * index.vertex_index + 2]);
+            mesh.texCoords.emplace_back(attrib.texcoords[2 * index.texcoord_index + 0],
+                                        1.0F - attrib.texcoords[2 * index.texcoord_index + 1]);
+            mesh.indices.push_back(static_cast<uint32_t>(mesh.indices.size()));
+        }
+    }
+
+    for (const auto& material : materials)
+    {
+        if (!material.diffuse_texname.empty())
+        {
+            mesh.diffuseTextures.push_back(baseDirectory + material.diffuse_texname);
+        }
+    }
+
+    LOG_INFO("Loaded mesh {}: {} triangles, {} textures in {:.2f} ms",
+             path,
+             mesh.indices.size() / 3,
+             mesh.diffuseTextures.size(),
+             std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+    co_return mesh;
+}
+
+Task<ImageAsset> loadImage(TaskExecutor& executor, std::string path)
+{
+    co_await executor.schedule();
+
+    int width {0};
+    int height {0};
+    int channels {0};
+
+    stbi_uc* pixels = stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+    if (pixels == nullptr)
+    {
+        LOG_FATAL("Failed to load image {}: {}", path, stbi_failure_reason());
+    }
+
+    ImageAsset image;
+    image.width  = static_cast<uint32_t>(width);
+    image.height = static_cast<uint32_t>(height);
+    image.pixels.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+    stbi_image_free(pixels);
+
+    co_return image;
+}
+} // namespace AssetLoader
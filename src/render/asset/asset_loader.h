@@ -0,0 +1,34 @@
+#pragma once
+
+#include "foundation/async/task.h"
+#include "foundation/async/task_executor.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Triangle list with one vertex per corner, as the obj file references them.
+struct MeshAsset
+{
+    std::vector<glm::vec3>   positions;
+    std::vector<glm::vec2>   texCoords; // v points down like in vulkan images
+    std::vector<uint32_t>    indices;
+    std::vector<std::string> diffuseTextures; // paths of the material textures, empty without a material library
+};
+
+struct ImageAsset
+{
+    uint32_t             width {0};
+    uint32_t             height {0};
+    std::vector<uint8_t> pixels; // rgba8, rows tightly packed
+};
+
+// Parsing and decoding run on the executor, awaiting them never blocks the calling thread. Failures throw through the
+// task like LOG_FATAL does elsewhere.
+namespace AssetLoader
+{
+Task<MeshAsset>  loadMesh(TaskExecutor& executor, std::string path);
+Task<ImageAsset> loadImage(TaskExecutor& executor, std::string path);
+} // namespace AssetLoader
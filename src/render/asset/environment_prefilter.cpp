@@ -0,0 +1,538 @@
+#include "render/asset/environment_prefilter.h"
+
+#include "foundation/image/image_writer.h"
+#include "foundation/log/log_system.h"
+#include "render/asset/impostor_baker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+constexpr uint32_t CHANNELS = 4;
+
+constexpr float PI = 3.14159265F;
+
+// texels of a job, a specular texel takes a few hundred samples
+constexpr uint32_t TEXELS_PER_JOB = 256;
+
+// the spherical harmonics are projected from the first level of the source pyramid at most this wide, the l2 bands
+// cannot tell the finer detail apart anyway
+constexpr uint32_t MAX_PROJECTION_WIDTH = 256;
+
+// "IBL1" in a little endian file. Bump the version whenever the layout or the math behind the cached data changes
+constexpr uint32_t CACHE_MAGIC   = 0x314C4249U;
+constexpr uint32_t CACHE_VERSION = 1;
+
+// the up axis is swapped for x once a direction comes this close to it
+constexpr float POLE_THRESHOLD = 0.999F;
+
+// the sky of createSky, brighter towards the zenith and dark below the horizon
+const glm::vec3 SKY_ZENITH {0.35F, 0.4F, 0.5F};
+const glm::vec3 SKY_HORIZON {0.45F, 0.45F, 0.45F};
+const glm::vec3 SKY_GROUND {0.12F, 0.11F, 0.1F};
+
+float toLinear(float srgb)
+{
+    return srgb <= 0.04045F ? srgb / 12.92F : std::pow((srgb + 0.055F) / 1.055F, 2.4F);
+}
+
+glm::vec3 getDirection(const glm::vec2& coord)
+{
+    const float azimuth = coord.x * 2.0F * PI;
+    const float polar   = coord.y * PI;
+    return {-std::cos(azimuth) * std::sin(polar), std::sin(azimuth) * std::sin(polar), std::cos(polar)};
+}
+
+glm::vec2 getCoord(const glm::vec3& direction)
+{
+    float azimuth = std::atan2(direction.y, -direction.x);
+    if (azimuth < 0.0F)
+    {
+        azimuth += 2.0F * PI;
+    }
+    return {azimuth / (2.0F * PI), std::acos(std::clamp(direction.z, -1.0F, 1.0F)) / PI};
+}
+
+// bilinear, wrapping around the azimuth and clamped at the poles
+glm::vec3 sampleMap(const EnvironmentMap& map, const glm::vec3& direction)
+{
+    const glm::vec2 texel = getCoord(direction) * glm::vec2(map.width, map.height) - 0.5F;
+    const glm::vec2 base  = glm::floor(texel);
+    const glm::vec2 blend = texel - base;
+
+    const auto column0 = static_cast<int32_t>(base.x);
+    const auto row0    = static_cast<int32_t>(base.y);
+    const auto width   = static_cast<int32_t>(map.width);
+    const auto height  = static_cast<int32_t>(map.height);
+
+    const auto fetch = [&](int32_t column, int32_t row) {
+        column = ((column % width) + width) % width;
+        row    = std::clamp(row, 0, height - 1);
+        return map.radiance[static_cast<size_t>(row) * map.width + column];
+    };
+
+    return glm::mix(glm::mix(fetch(column0, row0), fetch(column0 + 1, row0), blend.x),
+                    glm::mix(fetch(column0, row0 + 1), fetch(column0 + 1, row0 + 1), blend.x),
+                    blend.y);
+}
+
+// the source and its box filtered halvings, far and rough samples read the blurrier levels
+std::vector<EnvironmentMap> createPyramid(const EnvironmentMap& source)
+{
+    std::vector<EnvironmentMap> pyramid {source};
+    while (pyramid.back().width > 1 && pyramid.back().height > 1)
+    {
+        const EnvironmentMap& previous = pyramid.back();
+
+        EnvironmentMap level;
+        level.width  = previous.width / 2;
+        level.height = previous.height / 2;
+        level.radiance.resize(static_cast<size_t>(level.width) * level.height);
+        for (uint32_t y = 0; y < level.height; y++)
+        {
+            for (uint32_t x = 0; x < level.width; x++)
+            {
+                const size_t row0 = static_cast<size_t>(y) * 2 * previous.width;
+                const size_t row1 = row0 + previous.width;
+                level.radiance[static_cast<size_t>(y) * level.width + x] =
+                    0.25F * (previous.radiance[row0 + x * 2] + previous.radiance[row0 + x * 2 + 1] +
+                             previous.radiance[row1 + x * 2] + previous.radiance[row1 + x * 2 + 1]);
+            }
+        }
+        pyramid.push_back(std::move(level));
+    }
+    return pyramid;
+}
+
+glm::vec3 samplePyramid(const std::vector<EnvironmentMap>& pyramid, const glm::vec3& direction, float lod)
+{
+    lod                  = std::clamp(lod, 0.0F, static_cast<float>(pyramid.size() - 1));
+    const auto  lower    = static_cast<uint32_t>(lod);
+    const auto  upper    = std::min(lower + 1, static_cast<uint32_t>(pyramid.size() - 1));
+    const float fraction = lod - static_cast<float>(lower);
+    return glm::mix(sampleMap(pyramid[lower], direction), sampleMap(pyramid[upper], direction), fraction);
+}
+
+// the van der corput sequence against a regular one, a low discrepancy set that covers the square evenly
+glm::vec2 getHammersley(uint32_t index, uint32_t count)
+{
+    uint32_t bits = index;
+    bits          = (bits << 16U) | (bits >> 16U);
+    bits          = ((bits & 0x55555555U) << 1U) | ((bits & 0xAAAAAAAAU) >> 1U);
+    bits          = ((bits & 0x33333333U) << 2U) | ((bits & 0xCCCCCCCCU) >> 2U);
+    bits          = ((bits & 0x0F0F0F0FU) << 4U) | ((bits & 0xF0F0F0F0U) >> 4U);
+    bits          = ((bits & 0x00FF00FFU) << 8U) | ((bits & 0xFF00FF00U) >> 8U);
+    return {static_cast<float>(index) / static_cast<float>(count), static_cast<float>(bits) * 2.3283064e-10F};
+}
+
+// half vector around normal distributed like the ggx lobe of the roughness
+glm::vec3 sampleGgx(const glm::vec2& sample, const glm::vec3& normal, float roughness)
+{
+    const float alpha    = roughness * roughness;
+    const float azimuth  = 2.0F * PI * sample.x;
+    const float cosTheta = std::sqrt((1.0F - sample.y) / (1.0F + (alpha * alpha - 1.0F) * sample.y));
+    const float sinTheta = std::sqrt(std::max(0.0F, 1.0F - cosTheta * cosTheta));
+
+    const glm::vec3 axis =
+        std::abs(normal.z) > POLE_THRESHOLD ? glm::vec3(1.0F, 0.0F, 0.0F) : glm::vec3(0.0F, 0.0F, 1.0F);
+    const glm::vec3 tangent   = glm::normalize(glm::cross(axis, normal));
+    const glm::vec3 bitangent = glm::cross(normal, tangent);
+    return sinTheta * std::cos(azimuth) * tangent + sinTheta * std::sin(azimuth) * bitangent + cosTheta * normal;
+}
+
+float getGgxDistribution(float cosHalf, float roughness)
+{
+    const float alpha2 = roughness * roughness * roughness * roughness;
+    const float denom  = cosHalf * cosHalf * (alpha2 - 1.0F) + 1.0F;
+    return alpha2 / (PI * denom * denom);
+}
+
+// smith with the remapping of image based lighting, k = alpha / 2
+float getSmithVisibility(float cosView, float cosLight, float roughness)
+{
+    const float k = roughness * roughness * 0.5F;
+    return cosView / (cosView * (1.0F - k) + k) * cosLight / (cosLight * (1.0F - k) + k);
+}
+
+// projection onto the l2 basis, each texel weighted by the solid angle it covers. The cosine convolution scales the
+// bands by pi, 2 pi / 3 and pi / 4 and the division by pi leaves 1, 2 / 3 and 1 / 4
+std::array<glm::vec3, 9> projectIrradiance(const std::vector<EnvironmentMap>& pyramid)
+{
+    const EnvironmentMap* map = &pyramid.front();
+    for (const EnvironmentMap& level : pyramid)
+    {
+        map = &level;
+        if (level.width <= MAX_PROJECTION_WIDTH)
+            break;
+    }
+
+    std::array<glm::vec3, 9> coefficients {};
+    const float              texelArea = (2.0F * PI / static_cast<float>(map->width)) * (PI / map->height);
+    for (uint32_t y = 0; y < map->height; y++)
+    {
+        for (uint32_t x = 0; x < map->width; x++)
+        {
+            const glm::vec2 coord {(static_cast<float>(x) + 0.5F) / static_cast<float>(map->width),
+                                   (static_cast<float>(y) + 0.5F) / static_cast<float>(map->height)};
+            const glm::vec3 direction = getDirection(coord);
+            const glm::vec3 radiance =
+                map->radiance[static_cast<size_t>(y) * map->width + x] * texelArea * std::sin(coord.y * PI);
+
+            coefficients[0] += radiance * 0.282095F;
+            coefficients[1] += radiance * (0.488603F * direction.y);
+            coefficients[2] += radiance * (0.488603F * direction.z);
+            coefficients[3] += radiance * (0.488603F * direction.x);
+            coefficients[4] += radiance * (1.092548F * direction.x * direction.y);
+            coefficients[5] += radiance * (1.092548F * direction.y * direction.z);
+            coefficients[6] += radiance * (0.315392F * (3.0F * direction.z * direction.z - 1.0F));
+            coefficients[7] += radiance * (1.092548F * direction.x * direction.z);
+            coefficients[8] += radiance * (0.546274F * (direction.x * direction.x - direction.y * direction.y));
+        }
+    }
+
+    // the basis constants go into the coefficients as well, the shaders only multiply with the monomials
+    constexpr std::array<float, 9> SCALES = {0.282095F,
+                                             0.488603F * 2.0F / 3.0F,
+                                             0.488603F * 2.0F / 3.0F,
+                                             0.488603F * 2.0F / 3.0F,
+                                             1.092548F * 0.25F,
+                                             1.092548F * 0.25F,
+                                             0.315392F * 0.25F,
+                                             1.092548F * 0.25F,
+                                             0.546274F * 0.25F};
+    for (uint32_t index = 0; index < coefficients.size(); index++)
+    {
+        coefficients[index] *= SCALES[index];
+    }
+    return coefficients;
+}
+
+// a texel of a specular level looks along its direction with the normal and the view on it, so the lobe only
+// depends on the roughness. Samples read the source level whose texels cover about the solid angle they stand for
+glm::vec3 prefilterTexel(const std::vector<EnvironmentMap>& pyramid,
+                         const glm::vec3&                   normal,
+                         float                              roughness,
+                         float                              baseLod,
+                         uint32_t                           sampleCount)
+{
+    if (roughness <= 0.0F)
+        return samplePyramid(pyramid, normal, baseLod);
+
+    const float sourceTexelArea = 4.0F * PI / static_cast<float>(pyramid.front().width * pyramid.front().height);
+
+    glm::vec3 sum {0.0F};
+    float     weight = 0.0F;
+    for (uint32_t sample = 0; sample < sampleCount; sample++)
+    {
+        const glm::vec3 half     = sampleGgx(getHammersley(sample, sampleCount), normal, roughness);
+        const float     cosHalf  = glm::dot(normal, half);
+        const glm::vec3 light    = 2.0F * cosHalf * half - normal;
+        const float     cosLight = glm::dot(normal, light);
+        if (cosLight <= 0.0F)
+            continue;
+
+        // with the view along the normal the pdf of the reflected direction is D / 4
+        const float pdf        = getGgxDistribution(cosHalf, roughness) * 0.25F;
+        const float sampleArea = 1.0F / (static_cast<float>(sampleCount) * pdf + 1e-6F);
+        const float lod        = std::max(0.5F * std::log2(sampleArea / sourceTexelArea) + 1.0F, baseLod);
+
+        sum += samplePyramid(pyramid, light, lod) * cosLight;
+        weight += cosLight;
+    }
+    return weight > 0.0F ? sum / weight : glm::vec3(0.0F);
+}
+
+glm::vec2 integrateBrdf(float cosView, float roughness, uint32_t sampleCount)
+{
+    const glm::vec3 normal {0.0F, 0.0F, 1.0F};
+    const glm::vec3 view {std::sqrt(1.0F - cosView * cosView), 0.0F, cosView};
+
+    glm::vec2 sum {0.0F};
+    for (uint32_t sample = 0; sample < sampleCount; sample++)
+    {
+        const glm::vec3 half     = sampleGgx(getHammersley(sample, sampleCount), normal, roughness);
+        const float     cosVh    = glm::dot(view, half);
+        const glm::vec3 light    = 2.0F * cosVh * half - view;
+        const float     cosLight = light.z;
+        if (cosLight <= 0.0F)
+            continue;
+
+        const float visibility = getSmithVisibility(cosView, cosLight, roughness) * cosVh / (half.z * cosView);
+        const float fresnel    = std::pow(1.0F - std::max(cosVh, 0.0F), 5.0F);
+        sum += glm::vec2((1.0F - fresnel) * visibility, fresnel * visibility);
+    }
+    return sum / static_cast<float>(sampleCount);
+}
+
+uint64_t hashBytes(uint64_t hash, const void* data, size_t size)
+{
+    // 64 bit fnv-1a
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t index = 0; index < size; index++)
+    {
+        hash = (hash ^ bytes[index]) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+template <typename T>
+void appendBytes(std::vector<uint8_t>& data, const T* values, size_t count = 1)
+{
+    const size_t offset = data.size();
+    data.resize(offset + sizeof(T) * count);
+    std::memcpy(data.data() + offset, values, sizeof(T) * count);
+}
+
+// reads the next values of a cache entry, false once the entry is too short for them
+class CacheReader {
+public:
+    explicit CacheReader(const std::vector<uint8_t>& data) : data_(data) {}
+
+    template <typename T>
+    bool read(T* values, size_t count = 1)
+    {
+        if (data_.size() - offset_ < sizeof(T) * count)
+            return false;
+
+        std::memcpy(values, data_.data() + offset_, sizeof(T) * count);
+        offset_ += sizeof(T) * count;
+        return true;
+    }
+
+    [[nodiscard]] bool isAtEnd() const { return offset_ == data_.size(); }
+
+private:
+    const std::vector<uint8_t>& data_;
+    size_t                      offset_ {0};
+};
+
+std::vector<uint8_t> serialize(const EnvironmentLighting& lighting, uint64_t key)
+{
+    std::vector<uint8_t> data;
+    const auto           levelCount = static_cast<uint32_t>(lighting.specularLevels.size());
+    appendBytes(data, &CACHE_MAGIC);
+    appendBytes(data, &CACHE_VERSION);
+    appendBytes(data, &key);
+    appendBytes(data, &lighting.specularResolution);
+    appendBytes(data, &levelCount);
+    appendBytes(data, &lighting.brdfLutResolution);
+    appendBytes(data, lighting.irradiance.data(), lighting.irradiance.size());
+    for (const std::vector<glm::vec3>& level : lighting.specularLevels)
+    {
+        appendBytes(data, level.data(), level.size());
+    }
+    appendBytes(data, lighting.brdfLut.data(), lighting.brdfLut.size());
+    return data;
+}
+
+// empty unless the entry is complete and was written for this key
+EnvironmentLighting deserialize(const std::vector<uint8_t>& data, uint64_t key)
+{
+    CacheReader reader(data);
+    uint32_t    magic      = 0;
+    uint32_t    version    = 0;
+    uint64_t    entryKey   = 0;
+    uint32_t    levelCount = 0;
+
+    EnvironmentLighting lighting;
+    if (!reader.read(&magic) || !reader.read(&version) || !reader.read(&entryKey) ||
+        !reader.read(&lighting.specularResolution) || !reader.read(&levelCount) ||
+        !reader.read(&lighting.brdfLutResolution) || magic != CACHE_MAGIC || version != CACHE_VERSION ||
+        entryKey != key || levelCount > 32 || !reader.read(lighting.irradiance.data(), lighting.irradiance.size()))
+        return {};
+
+    lighting.specularLevels.resize(levelCount);
+    for (uint32_t level = 0; level < levelCount; level++)
+    {
+        const uint32_t resolution = std::max(1U, lighting.specularResolution >> level);
+        lighting.specularLevels[level].resize(static_cast<size_t>(resolution) * resolution);
+        if (!reader.read(lighting.specularLevels[level].data(), lighting.specularLevels[level].size()))
+            return {};
+    }
+
+    lighting.brdfLut.resize(static_cast<size_t>(lighting.brdfLutResolution) * lighting.brdfLutResolution);
+    if (!reader.read(lighting.brdfLut.data(), lighting.brdfLut.size()) || !reader.isAtEnd())
+        return {};
+    return lighting;
+}
+} // namespace
+
+namespace EnvironmentPrefilter
+{
+EnvironmentMap createSky(uint32_t width, uint32_t height)
+{
+    EnvironmentMap sky;
+    sky.width  = std::max(2U, width);
+    sky.height = std::max(1U, height);
+    sky.radiance.resize(static_cast<size_t>(sky.width) * sky.height);
+    for (uint32_t y = 0; y < sky.height; y++)
+    {
+        const float     elevation = getDirection({0.0F, (static_cast<float>(y) + 0.5F) / sky.height}).z;
+        const glm::vec3 radiance  = elevation >= 0.0F
+                                        ? glm::mix(SKY_HORIZON, SKY_ZENITH, std::sqrt(elevation))
+                                        : glm::mix(SKY_HORIZON, SKY_GROUND, std::min(1.0F, -elevation * 8.0F));
+        std::fill_n(sky.radiance.begin() + static_cast<ptrdiff_t>(y) * sky.width, sky.width, radiance);
+    }
+    return sky;
+}
+
+EnvironmentMap fromImage(const ImageAsset& image)
+{
+    std::array<float, 256> srgbToLinear {};
+    for (uint32_t value = 0; value < srgbToLinear.size(); value++)
+    {
+        srgbToLinear[value] = toLinear(static_cast<float>(value) / 255.0F);
+    }
+
+    EnvironmentMap map;
+    map.width  = image.width;
+    map.height = image.height;
+    map.radiance.resize(static_cast<size_t>(image.width) * image.height);
+    for (size_t texel = 0; texel < map.radiance.size(); texel++)
+    {
+        const uint8_t* pixel = &image.pixels[texel * CHANNELS];
+        map.radiance[texel]  = {srgbToLinear[pixel[0]], srgbToLinear[pixel[1]], srgbToLinear[pixel[2]]};
+    }
+    return map;
+}
+
+EnvironmentLighting
+prefilter(const EnvironmentMap& source, const EnvironmentPrefilterSettings& settings, JobSystem* jobSystem)
+{
+    EnvironmentLighting lighting;
+    if (source.isEmpty())
+        return lighting;
+
+    const std::vector<EnvironmentMap> pyramid = createPyramid(source);
+    lighting.irradiance                       = projectIrradiance(pyramid);
+
+    // every texel of every level and of the lut is independent, one flat range covers them all
+    lighting.specularResolution = std::max(1U, settings.specularResolution);
+    lighting.brdfLutResolution  = std::max(1U, settings.brdfLutResolution);
+
+    const uint32_t        levelCount = std::max(1U, settings.specularLevelCount);
+    std::vector<uint32_t> levelStarts;
+    uint32_t              texelCount = 0;
+    for (uint32_t level = 0; level < levelCount; level++)
+    {
+        const uint32_t resolution = std::max(1U, lighting.specularResolution >> level);
+        lighting.specularLevels.emplace_back(static_cast<size_t>(resolution) * resolution);
+        levelStarts.push_back(texelCount);
+        texelCount += resolution * resolution;
+    }
+    const uint32_t lutStart = texelCount;
+    lighting.brdfLut.resize(static_cast<size_t>(lighting.brdfLutResolution) * lighting.brdfLutResolution);
+    texelCount += static_cast<uint32_t>(lighting.brdfLut.size());
+
+    const float sourceTexelArea = 4.0F * PI / static_cast<float>(source.width * source.height);
+
+    const auto prefilterTexels = [&](uint32_t begin, uint32_t end) {
+        for (uint32_t texel = begin; texel < end; texel++)
+        {
+            if (texel >= lutStart)
+            {
+                const uint32_t  index = texel - lutStart;
+                const glm::vec2 coord =
+                    (glm::vec2(index % lighting.brdfLutResolution, index / lighting.brdfLutResolution) + 0.5F) /
+                    static_cast<float>(lighting.brdfLutResolution);
+                lighting.brdfLut[index] = integrateBrdf(coord.x, coord.y, settings.brdfLutSampleCount);
+                continue;
+            }
+
+            const auto level =
+                static_cast<uint32_t>(std::upper_bound(levelStarts.begin(), levelStarts.end(), texel) -
+                                      levelStarts.begin() - 1);
+            const uint32_t  resolution = std::max(1U, lighting.specularResolution >> level);
+            const uint32_t  index      = texel - levelStarts[level];
+            const glm::vec3 direction  = ImpostorBaker::decodeOctahedral(
+                (glm::vec2(index % resolution, index / resolution) + 0.5F) / static_cast<float>(resolution));
+
+            // even a mirror reads a source level no sharper than the texels of its own level
+            const float roughness = levelCount > 1 ? static_cast<float>(level) / (levelCount - 1) : 0.0F;
+            const float baseLod =
+                std::max(0.0F, 0.5F * std::log2(4.0F * PI / (resolution * resolution) / sourceTexelArea));
+            lighting.specularLevels[level][index] =
+                prefilterTexel(pyramid, direction, roughness, baseLod, settings.specularSampleCount);
+        }
+    };
+
+    if (jobSystem != nullptr)
+    {
+        jobSystem->parallelFor(texelCount, TEXELS_PER_JOB, prefilterTexels);
+    }
+    else
+    {
+        prefilterTexels(0, texelCount);
+    }
+    return lighting;
+}
+
+uint64_t getCacheKey(const EnvironmentMap& source, const EnvironmentPrefilterSettings& settings)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    hash          = hashBytes(hash, &CACHE_VERSION, sizeof(CACHE_VERSION));
+    hash          = hashBytes(hash, &source.width, sizeof(source.width));
+    hash          = hashBytes(hash, &source.height, sizeof(source.height));
+    hash          = hashBytes(hash, source.radiance.data(), source.radiance.size() * sizeof(glm::vec3));
+    hash          = hashBytes(hash, &settings, sizeof(settings));
+    return hash;
+}
+
+EnvironmentLighting loadOrPrefilter(const EnvironmentMap&               source,
+                                    const EnvironmentPrefilterSettings& settings,
+                                    const std::string&                  cacheDirectory,
+                                    JobSystem*                          jobSystem)
+{
+    const auto        start = std::chrono::high_resolution_clock::now();
+    const uint64_t    key   = getCacheKey(source, settings);
+    const std::string path  = fmt::format("{}/{:016x}.iblcache", cacheDirectory, key);
+
+    std::ifstream file(path, std::ios::binary);
+    if (file)
+    {
+        const std::vector<uint8_t> data {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        EnvironmentLighting        lighting = deserialize(data, key);
+        if (!lighting.isEmpty())
+        {
+            LOG_INFO("Environment lighting read from {} in {:.2f} ms",
+                     path,
+                     std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start)
+                         .count());
+            return lighting;
+        }
+        LOG_WARN("Environment cache entry {} is damaged or outdated, prefiltering again", path);
+    }
+
+    EnvironmentLighting lighting = prefilter(source, settings, jobSystem);
+    if (lighting.isEmpty())
+        return lighting;
+
+    LOG_INFO("Environment of {}x{} texels prefiltered into {} specular levels in {:.2f} ms",
+             source.width,
+             source.height,
+             lighting.specularLevels.size(),
+             std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+
+    // a failed write only costs the next startup another prefilter
+    if (!ImageWriter::writeFile(path, serialize(lighting, key)))
+    {
+        LOG_WARN("Failed to write the environment cache entry {}", path);
+    }
+    return lighting;
+}
+
+glm::vec3 evaluateIrradiance(const EnvironmentLighting& lighting, const glm::vec3& normal)
+{
+    const std::array<glm::vec3, 9>& c = lighting.irradiance;
+    const glm::vec3                 irradiance =
+        c[0] + c[1] * normal.y + c[2] * normal.z + c[3] * normal.x + c[4] * (normal.x * normal.y) +
+        c[5] * (normal.y * normal.z) + c[6] * (3.0F * normal.z * normal.z - 1.0F) + c[7] * (normal.x * normal.z) +
+        c[8] * (normal.x * normal.x - normal.y * normal.y);
+    return glm::max(irradiance, 0.0F);
+}
+} // namespace EnvironmentPrefilter
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "foundation/job/job_system.h"
+#include "render/asset/asset_loader.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Equirectangular radiance around the scene, z is up. Row 0 looks straight up, column 0 along -x and the columns turn
+// towards +y.
+struct EnvironmentMap
+{
+    uint32_t               width {0};
+    uint32_t               height {0};
+    std::vector<glm::vec3> radiance; // linear, rows tightly packed
+
+    [[nodiscard]] bool isEmpty() const { return radiance.empty(); }
+};
+
+struct EnvironmentPrefilterSettings
+{
+    uint32_t specularResolution {128};  // texels per side of the sharpest specular level
+    uint32_t specularLevelCount {6};    // roughness 0 in the first level to 1 in the last, halving the resolution
+    uint32_t specularSampleCount {128}; // ggx importance samples per texel
+    uint32_t brdfLutResolution {64};
+    uint32_t brdfLutSampleCount {512};
+};
+
+// Image based lighting of one environment. The diffuse irradiance is l2 spherical harmonics with the cosine
+// convolution and the basis constants folded in, so irradiance / pi towards a normal is the plain polynomial of
+// evaluateIrradiance. The specular levels are octahedral maps over the whole sphere like the impostor views, the brdf
+// lut holds the split sum scale and bias of the fresnel term.
+struct EnvironmentLighting
+{
+    std::array<glm::vec3, 9>            irradiance {};
+    uint32_t                            specularResolution {0};
+    std::vector<std::vector<glm::vec3>> specularLevels; // level i has specularResolution >> i texels per side
+    uint32_t                            brdfLutResolution {0};
+    std::vector<glm::vec2>              brdfLut; // rows of roughness, columns of n.v
+
+    [[nodiscard]] bool isEmpty() const { return specularLevels.empty(); }
+};
+
+// Convolution of environments for image based lighting on the cpu, spread over the job system. The results are cached
+// on disk keyed by a hash of the source and the settings, so only the first startup with an environment pays for it.
+namespace EnvironmentPrefilter
+{
+// a sky over a dark ground for scenes without an environment map. It has no sun, the sun lights the scene directly
+EnvironmentMap createSky(uint32_t width, uint32_t height);
+
+// decodes the srgb pixels of an ldr panorama
+EnvironmentMap fromImage(const ImageAsset& image);
+
+EnvironmentLighting
+prefilter(const EnvironmentMap& source, const EnvironmentPrefilterSettings& settings, JobSystem* jobSystem = nullptr);
+
+// the key of the cache entry, changes with every texel of the source, the settings and the cache format
+uint64_t getCacheKey(const EnvironmentMap& source, const EnvironmentPrefilterSettings& settings);
+
+// reads the lighting from the cache entry of the source, prefilters and writes the entry when there is none yet
+EnvironmentLighting loadOrPrefilter(const EnvironmentMap&               source,
+                                    const EnvironmentPrefilterSettings& settings,
+                                    const std::string&                  cacheDirectory,
+                                    JobSystem*                          jobSystem = nullptr);
+
+// irradiance / pi, the radiance a white lambert surface facing normal reflects. triangle.frag evaluates the same
+glm::vec3 evaluateIrradiance(const EnvironmentLighting& lighting, const glm::vec3& normal);
+} // namespace EnvironmentPrefilter
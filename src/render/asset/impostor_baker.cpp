@@ -0,0 +1,384 @@
+#include "render/asset/impostor_baker.h"
+
+#include "foundation/async/task_executor.h"
+#include "foundation/image/image_writer.h"
+#include "foundation/log/log_system.h"
+#include "foundation/math/aabb.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+// views are rasterized at this multiple of the frame resolution and box filtered down into the top mip
+constexpr uint32_t SUPERSAMPLING = 2;
+
+// empty texels take the color of covered neighbours this many texels out, so filtering at the silhouette does not
+// pull in black
+constexpr uint32_t DILATION_PASSES = 4;
+
+constexpr uint32_t CHANNELS = 4;
+
+// the up axis is swapped for x once a view direction comes this close to it
+constexpr float POLE_THRESHOLD = 0.999F;
+
+float edge(const glm::vec2& a, const glm::vec2& b, const glm::vec2& point)
+{
+    return (b.x - a.x) * (point.y - a.y) - (b.y - a.y) * (point.x - a.x);
+}
+
+// nearest texel with wrapping, v points down like the image rows
+const uint8_t* sampleTexture(const ImageAsset& texture, const glm::vec2& texCoord)
+{
+    const glm::vec2 wrapped = texCoord - glm::floor(texCoord);
+    const uint32_t  x       = std::min(static_cast<uint32_t>(wrapped.x * texture.width), texture.width - 1);
+    const uint32_t  y       = std::min(static_cast<uint32_t>(wrapped.y * texture.height), texture.height - 1);
+    return &texture.pixels[(static_cast<size_t>(y) * texture.width + x) * CHANNELS];
+}
+
+ImageAsset createImage(uint32_t width, uint32_t height)
+{
+    ImageAsset image;
+    image.width  = width;
+    image.height = height;
+    image.pixels.resize(static_cast<size_t>(width) * height * CHANNELS, 0);
+    return image;
+}
+
+// rasterizes one view into its cell of both atlases, nearest surface wins
+void bakeView(const MeshAsset&     mesh,
+              const ImageAsset&    texture,
+              const ImpostorAtlas& atlas,
+              uint32_t             resolution,
+              uint32_t             frame,
+              ImageAsset&          albedo,
+              ImageAsset&          normals)
+{
+    const uint32_t  frameX = frame % atlas.framesPerSide;
+    const uint32_t  frameY = frame / atlas.framesPerSide;
+    const glm::vec3 direction =
+        ImpostorBaker::decodeOctahedral((glm::vec2(frameX, frameY) + 0.5F) / static_cast<float>(atlas.framesPerSide));
+
+    glm::vec3 right {0.0F};
+    glm::vec3 up {0.0F};
+    ImpostorBaker::getViewBasis(direction, right, up);
+
+    // texel coordinates within the view and the distance towards the viewer
+    const auto             size = static_cast<float>(resolution);
+    std::vector<glm::vec3> projected(mesh.positions.size());
+    for (size_t vertex = 0; vertex < projected.size(); vertex++)
+    {
+        const glm::vec3 local = (mesh.positions[vertex] - atlas.center) / atlas.radius;
+        projected[vertex]     = {(glm::dot(local, right) * 0.5F + 0.5F) * size,
+                                 (0.5F - glm::dot(local, up) * 0.5F) * size,
+                                 glm::dot(local, direction)};
+    }
+
+    std::vector<float> depth(static_cast<size_t>(resolution) * resolution, std::numeric_limits<float>::lowest());
+    std::vector<bool>  filled(depth.size(), false);
+
+    const auto getTexel = [&](ImageAsset& image, uint32_t x, uint32_t y) {
+        const size_t row    = static_cast<size_t>(frameY) * resolution + y;
+        const size_t column = static_cast<size_t>(frameX) * resolution + x;
+        return &image.pixels[(row * image.width + column) * CHANNELS];
+    };
+
+    for (size_t index = 0; index + 2 < mesh.indices.size(); index += 3)
+    {
+        const uint32_t i0 = mesh.indices[index];
+        const uint32_t i1 = mesh.indices[index + 1];
+        const uint32_t i2 = mesh.indices[index + 2];
+
+        const glm::vec3& p0   = projected[i0];
+        const glm::vec3& p1   = projected[i1];
+        const glm::vec3& p2   = projected[i2];
+        const float      area = edge(p0, p1, p2);
+        if (std::abs(area) < 1e-8F)
+            continue;
+
+        // the mesh has no normals, the face normal is turned towards the view so both windings light alike
+        glm::vec3 normal = glm::normalize(
+            glm::cross(mesh.positions[i1] - mesh.positions[i0], mesh.positions[i2] - mesh.positions[i0]));
+        if (glm::dot(normal, direction) < 0.0F)
+        {
+            normal = -normal;
+        }
+        const glm::u8vec3 encodedNormal = glm::u8vec3(glm::round((normal * 0.5F + 0.5F) * 255.0F));
+
+        const glm::vec2 texCoord0 = i0 < mesh.texCoords.size() ? mesh.texCoords[i0] : glm::vec2(0.0F);
+        const glm::vec2 texCoord1 = i1 < mesh.texCoords.size() ? mesh.texCoords[i1] : glm::vec2(0.0F);
+        const glm::vec2 texCoord2 = i2 < mesh.texCoords.size() ? mesh.texCoords[i2] : glm::vec2(0.0F);
+
+        const glm::vec2 boundsMin = glm::min(glm::min(glm::vec2(p0), glm::vec2(p1)), glm::vec2(p2));
+        const glm::vec2 boundsMax = glm::max(glm::max(glm::vec2(p0), glm::vec2(p1)), glm::vec2(p2));
+        const auto      minX      = static_cast<uint32_t>(std::clamp(std::floor(boundsMin.x), 0.0F, size - 1.0F));
+        const auto      minY      = static_cast<uint32_t>(std::clamp(std::floor(boundsMin.y), 0.0F, size - 1.0F));
+        const auto      maxX      = static_cast<uint32_t>(std::clamp(std::ceil(boundsMax.x), 0.0F, size - 1.0F));
+        const auto      maxY      = static_cast<uint32_t>(std::clamp(std::ceil(boundsMax.y), 0.0F, size - 1.0F));
+
+        for (uint32_t y = minY; y <= maxY; y++)
+        {
+            for (uint32_t x = minX; x <= maxX; x++)
+            {
+                // dividing by the signed area accepts both windings
+                const glm::vec2 center {static_cast<float>(x) + 0.5F, static_cast<float>(y) + 0.5F};
+                const float     weight0 = edge(p1, p2, center) / area;
+                const float     weight1 = edge(p2, p0, center) / area;
+                const float     weight2 = 1.0F - weight0 - weight1;
+                if (weight0 < 0.0F || weight1 < 0.0F || weight2 < 0.0F)
+                    continue;
+
+                const size_t texel      = static_cast<size_t>(y) * resolution + x;
+                const float  texelDepth = weight0 * p0.z + weight1 * p1.z + weight2 * p2.z;
+                if (texelDepth <= depth[texel])
+                    continue;
+                depth[texel]  = texelDepth;
+                filled[texel] = true;
+
+                const glm::vec2 texCoord    = weight0 * texCoord0 + weight1 * texCoord1 + weight2 * texCoord2;
+                const uint8_t*  color       = sampleTexture(texture, texCoord);
+                uint8_t*        albedoTexel = getTexel(albedo, x, y);
+                uint8_t*        normalTexel = getTexel(normals, x, y);
+                albedoTexel[0]              = color[0];
+                albedoTexel[1]              = color[1];
+                albedoTexel[2]              = color[2];
+                albedoTexel[3]              = 255;
+                normalTexel[0]              = encodedNormal.x;
+                normalTexel[1]              = encodedNormal.y;
+                normalTexel[2]              = encodedNormal.z;
+                normalTexel[3]              = 255;
+            }
+        }
+    }
+
+    // grows the colors into the empty texels around the silhouette, alpha stays zero there
+    const std::array<glm::ivec2, 4> neighbourOffsets = {{{-1, 0}, {1, 0}, {0, -1}, {0, 1}}};
+
+    std::vector<bool> grown = filled;
+    for (uint32_t pass = 0; pass < DILATION_PASSES; pass++)
+    {
+        for (uint32_t y = 0; y < resolution; y++)
+        {
+            for (uint32_t x = 0; x < resolution; x++)
+            {
+                if (filled[static_cast<size_t>(y) * resolution + x])
+                    continue;
+
+                glm::uvec3 albedoSum {0};
+                glm::uvec3 normalSum {0};
+                uint32_t   count = 0;
+                for (const glm::ivec2& offset : neighbourOffsets)
+                {
+                    const glm::ivec2 neighbour = glm::ivec2(x, y) + offset;
+                    if (neighbour.x < 0 || neighbour.y < 0 || neighbour.x >= static_cast<int32_t>(resolution) ||
+                        neighbour.y >= static_cast<int32_t>(resolution) ||
+                        !filled[static_cast<size_t>(neighbour.y) * resolution + neighbour.x])
+                        continue;
+
+                    const uint8_t* albedoTexel = getTexel(albedo, neighbour.x, neighbour.y);
+                    const uint8_t* normalTexel = getTexel(normals, neighbour.x, neighbour.y);
+                    albedoSum += glm::uvec3(albedoTexel[0], albedoTexel[1], albedoTexel[2]);
+                    normalSum += glm::uvec3(normalTexel[0], normalTexel[1], normalTexel[2]);
+                    count++;
+                }
+                if (count == 0)
+                    continue;
+
+                uint8_t* albedoTexel = getTexel(albedo, x, y);
+                uint8_t* normalTexel = getTexel(normals, x, y);
+                for (uint32_t channel = 0; channel < 3; channel++)
+                {
+                    albedoTexel[channel] = static_cast<uint8_t>(albedoSum[channel] / count);
+                    normalTexel[channel] = static_cast<uint8_t>(normalSum[channel] / count);
+                }
+                grown[static_cast<size_t>(y) * resolution + x] = true;
+            }
+        }
+        filled = grown;
+    }
+}
+
+// 2x2 box filter, colors are weighted by coverage so empty texels only contribute their alpha. The cells of the views
+// stay aligned as long as their size is even
+ImageAsset downsample(const ImageAsset& source)
+{
+    ImageAsset target = createImage(source.width / 2, source.height / 2);
+    for (uint32_t y = 0; y < target.height; y++)
+    {
+        for (uint32_t x = 0; x < target.width; x++)
+        {
+            glm::vec3 weightedSum {0.0F};
+            glm::vec3 plainSum {0.0F};
+            float     coverage = 0.0F;
+            for (uint32_t sample = 0; sample < 4; sample++)
+            {
+                const size_t   row    = static_cast<size_t>(y) * 2 + sample / 2;
+                const size_t   column = static_cast<size_t>(x) * 2 + sample % 2;
+                const uint8_t* texel  = &source.pixels[(row * source.width + column) * CHANNELS];
+                const float    alpha  = texel[3] / 255.0F;
+
+                const glm::vec3 color {texel[0], texel[1], texel[2]};
+                weightedSum += color * alpha;
+                plainSum += color;
+                coverage += alpha;
+            }
+
+            const glm::vec3 color = coverage > 0.0F ? weightedSum / coverage : plainSum * 0.25F;
+
+            uint8_t* texel = &target.pixels[(static_cast<size_t>(y) * target.width + x) * CHANNELS];
+            texel[0]       = static_cast<uint8_t>(std::lround(color.r));
+            texel[1]       = static_cast<uint8_t>(std::lround(color.g));
+            texel[2]       = static_cast<uint8_t>(std::lround(color.b));
+            texel[3]       = static_cast<uint8_t>(std::lround(coverage * 0.25F * 255.0F));
+        }
+    }
+    return target;
+}
+} // namespace
+
+namespace ImpostorBaker
+{
+ImpostorAtlas
+bake(const MeshAsset& mesh, const ImageAsset& texture, const ImpostorBakeSettings& settings, JobSystem* jobSystem)
+{
+    ImpostorAtlas atlas;
+    atlas.framesPerSide   = std::max(1U, settings.framesPerSide);
+    atlas.frameResolution = std::max(2U, settings.frameResolution);
+
+    Aabb bounds {};
+    for (const glm::vec3& position : mesh.positions)
+    {
+        bounds.expand(position);
+    }
+    if (bounds.isEmpty() || texture.pixels.empty())
+        return atlas;
+
+    atlas.center = bounds.getCenter();
+    for (const glm::vec3& position : mesh.positions)
+    {
+        atlas.radius = std::max(atlas.radius, glm::length(position - atlas.center));
+    }
+    atlas.radius = std::max(atlas.radius, 1e-6F);
+
+    const uint32_t resolution = atlas.frameResolution * SUPERSAMPLING;
+    const uint32_t size       = atlas.framesPerSide * resolution;
+    const uint32_t frameCount = atlas.framesPerSide * atlas.framesPerSide;
+
+    ImageAsset albedo  = createImage(size, size);
+    ImageAsset normals = createImage(size, size);
+
+    // every view writes its own cell of the atlases
+    const auto bakeViews = [&](uint32_t begin, uint32_t end) {
+        for (uint32_t frame = begin; frame < end; frame++)
+        {
+            bakeView(mesh, texture, atlas, resolution, frame, albedo, normals);
+        }
+    };
+
+    if (jobSystem != nullptr)
+    {
+        jobSystem->parallelFor(frameCount, 1, bakeViews);
+    }
+    else
+    {
+        bakeViews(0, frameCount);
+    }
+
+    atlas.albedo.push_back(downsample(albedo));
+    atlas.normals.push_back(downsample(normals));
+    for (uint32_t frameSize = atlas.frameResolution; frameSize % 2 == 0 && frameSize / 2 >= settings.minMipResolution;
+         frameSize /= 2)
+    {
+        atlas.albedo.push_back(downsample(atlas.albedo.back()));
+        atlas.normals.push_back(downsample(atlas.normals.back()));
+    }
+    return atlas;
+}
+
+bool writeAtlas(const ImpostorAtlas& atlas, const std::string& pathPrefix)
+{
+    if (atlas.isEmpty())
+        return false;
+
+    std::vector<uint8_t> png;
+    ImageWriter::encodePng(atlas.albedo[0].pixels.data(), atlas.albedo[0].width, atlas.albedo[0].height, CHANNELS, png);
+    if (!ImageWriter::writeFile(pathPrefix + "_albedo.png", png))
+        return false;
+
+    ImageWriter::encodePng(
+        atlas.normals[0].pixels.data(), atlas.normals[0].width, atlas.normals[0].height, CHANNELS, png);
+    return ImageWriter::writeFile(pathPrefix + "_normals.png", png);
+}
+
+bool bakeFiles(const std::string&          meshPath,
+               const std::string&          texturePath,
+               const std::string&          pathPrefix,
+               const ImpostorBakeSettings& settings)
+{
+    TaskExecutor executor;
+    JobSystem    jobSystem;
+
+    const MeshAsset  mesh    = syncWait(AssetLoader::loadMesh(executor, meshPath));
+    const ImageAsset texture = syncWait(AssetLoader::loadImage(executor, texturePath));
+
+    const auto          bakeStart = std::chrono::high_resolution_clock::now();
+    const ImpostorAtlas atlas     = bake(mesh, texture, settings, &jobSystem);
+    if (atlas.isEmpty())
+    {
+        LOG_ERROR("Impostor of {} is empty, the mesh or its texture has no data", meshPath);
+        return false;
+    }
+
+    LOG_INFO("Impostor of {}: {}x{} views of {} texels, {} mips, baked in {:.2f} ms on {} threads",
+             meshPath,
+             atlas.framesPerSide,
+             atlas.framesPerSide,
+             atlas.frameResolution,
+             atlas.albedo.size(),
+             std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - bakeStart).count(),
+             jobSystem.getThreadCount());
+
+    if (!writeAtlas(atlas, pathPrefix))
+    {
+        LOG_ERROR("Failed to write the impostor atlas to {}", pathPrefix);
+        return false;
+    }
+    return true;
+}
+
+glm::vec2 encodeOctahedral(const glm::vec3& direction)
+{
+    const glm::vec3 octahedron = direction / (std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z));
+
+    // the lower half folds over the diagonals onto the corners
+    glm::vec2 coord {octahedron.x, octahedron.y};
+    if (octahedron.z < 0.0F)
+    {
+        coord = (1.0F - glm::abs(glm::vec2(coord.y, coord.x))) *
+                glm::vec2(coord.x >= 0.0F ? 1.0F : -1.0F, coord.y >= 0.0F ? 1.0F : -1.0F);
+    }
+    return coord * 0.5F + 0.5F;
+}
+
+glm::vec3 decodeOctahedral(const glm::vec2& coord)
+{
+    const glm::vec2 folded = coord * 2.0F - 1.0F;
+    glm::vec3       direction {folded.x, folded.y, 1.0F - std::abs(folded.x) - std::abs(folded.y)};
+
+    const float unfold = std::max(-direction.z, 0.0F);
+    direction.x += direction.x >= 0.0F ? -unfold : unfold;
+    direction.y += direction.y >= 0.0F ? -unfold : unfold;
+    return glm::normalize(direction);
+}
+
+void getViewBasis(const glm::vec3& direction, glm::vec3& right, glm::vec3& up)
+{
+    const glm::vec3 worldUp =
+        std::abs(direction.z) > POLE_THRESHOLD ? glm::vec3(1.0F, 0.0F, 0.0F) : glm::vec3(0.0F, 0.0F, 1.0F);
+    right = glm::normalize(glm::cross(worldUp, direction));
+    up    = glm::cross(direction, right);
+}
+} // namespace ImpostorBaker
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "foundation/job/job_system.h"
+#include "render/asset/asset_loader.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct ImpostorBakeSettings
+{
+    uint32_t framesPerSide {8};     // the atlas holds framesPerSide squared views
+    uint32_t frameResolution {128}; // texels per side of a view, a power of two
+    uint32_t minMipResolution {8};  // the mip chain stops before a view would get smaller than this
+};
+
+// Views of a mesh from directions spread over the whole sphere by an octahedral map. View (x, y) of the grid looks at
+// the mesh from decodeOctahedral((x + 0.5, y + 0.5) / framesPerSide), orthographically over the bounding sphere and
+// laid out in getViewBasis of that direction. Both atlases are rgba8 mip chains whose texels never mix neighbouring
+// views, alpha is the coverage in both of them.
+struct ImpostorAtlas
+{
+    uint32_t                framesPerSide {0};
+    uint32_t                frameResolution {0};
+    glm::vec3               center {0.0F}; // bounding sphere in mesh space
+    float                   radius {0.0F};
+    std::vector<ImageAsset> albedo;  // srgb like the texture it was sampled from
+    std::vector<ImageAsset> normals; // mesh space normals facing the view, scaled into [0, 1]
+
+    [[nodiscard]] bool isEmpty() const { return albedo.empty(); }
+};
+
+// Offline and load time baking of impostors, everything runs on the cpu so it works without a device.
+namespace ImpostorBaker
+{
+// rasterizes every view at twice the resolution and filters it down, one view per job on the job system
+ImpostorAtlas bake(const MeshAsset&            mesh,
+                   const ImageAsset&           texture,
+                   const ImpostorBakeSettings& settings  = {},
+                   JobSystem*                  jobSystem = nullptr);
+
+// writes the top mips to <prefix>_albedo.png and <prefix>_normals.png, false when a file could not be written
+bool writeAtlas(const ImpostorAtlas& atlas, const std::string& pathPrefix);
+
+// the headless cook step behind --bake-impostor, loads the mesh and its texture, bakes them and writes the atlas
+bool bakeFiles(const std::string&          meshPath,
+               const std::string&          texturePath,
+               const std::string&          pathPrefix,
+               const ImpostorBakeSettings& settings = {});
+
+// full sphere octahedral map onto [0, 1] squared, impostor.vert implements the same functions
+glm::vec2 encodeOctahedral(const glm::vec3& direction);
+glm::vec3 decodeOctahedral(const glm::vec2& coord);
+
+// right and up of a view looking against direction, the runtime quad is laid out in the same basis
+void getViewBasis(const glm::vec3& direction, glm::vec3& right, glm::vec3& up);
+} // namespace ImpostorBaker
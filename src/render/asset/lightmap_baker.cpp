@@ -0,0 +1,547 @@
+#include "render/asset/lightmap_baker.h"
+
+#include "foundation/async/task_executor.h"
+#include "foundation/image/image_writer.h"
+#include "foundation/log/log_system.h"
+#include "foundation/spatial/mesh_bvh.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+namespace
+{
+constexpr uint32_t CHANNELS = 4;
+
+// empty texels take the value of covered neighbours this many texels out, the mips of the lightmap average across
+// the borders of the charts
+constexpr uint32_t DILATION_PASSES = 8;
+
+// texels and probes handed to a job at once, each of them traces a few hundred paths
+constexpr uint32_t TEXELS_PER_JOB = 64;
+constexpr uint32_t PROBES_PER_JOB = 1;
+
+// rays leave surfaces this fraction of the mesh diagonal above them, so they do not hit the surface they start on
+constexpr float RAY_OFFSET_SCALE = 1e-4F;
+
+// the up axis is swapped for x once a normal comes this close to it
+constexpr float POLE_THRESHOLD = 0.999F;
+
+constexpr float PI = 3.14159265F;
+
+// normalization of the l1 spherical harmonics basis functions
+constexpr float SH_BAND0 = 0.282095F;
+constexpr float SH_BAND1 = 0.488603F;
+
+// "PRB1" in a little endian file, followed by the probe counts, the bounds and 12 floats per probe
+constexpr uint32_t PROBE_FILE_MAGIC = 0x31425250U;
+
+// everything a path needs, shared read only by all jobs
+struct BakeScene
+{
+    const MeshAsset&            mesh;
+    const ImageAsset&           texture;
+    const LightmapBakeSettings& settings;
+    glm::vec3                   sunDirection {0.0F};
+    float                       rayOffset {0.0F};
+    MeshBvh                     bvh;
+    std::vector<glm::vec3>      faceNormals; // from the winding, the side the pipelines do not cull
+    std::array<float, 256>      srgbToLinear {};
+};
+
+// a covered texel of the lightmap and the surface point at its center
+struct LightmapTexel
+{
+    uint32_t  index;
+    glm::vec3 position;
+    glm::vec3 normal;
+};
+
+float edge(const glm::vec2& a, const glm::vec2& b, const glm::vec2& point)
+{
+    return (b.x - a.x) * (point.y - a.y) - (b.y - a.y) * (point.x - a.x);
+}
+
+float toLinear(float srgb)
+{
+    return srgb <= 0.04045F ? srgb / 12.92F : std::pow((srgb + 0.055F) / 1.055F, 2.4F);
+}
+
+float toSrgb(float linear)
+{
+    return linear <= 0.0031308F ? linear * 12.92F : 1.055F * std::pow(linear, 1.0F / 2.4F) - 0.055F;
+}
+
+void getBasis(const glm::vec3& normal, glm::vec3& tangent, glm::vec3& bitangent)
+{
+    const glm::vec3 axis =
+        std::abs(normal.z) > POLE_THRESHOLD ? glm::vec3(1.0F, 0.0F, 0.0F) : glm::vec3(0.0F, 0.0F, 1.0F);
+    tangent   = glm::normalize(glm::cross(axis, normal));
+    bitangent = glm::cross(normal, tangent);
+}
+
+// cosine weighted, the pdf cancels the cosine and the 1 / pi of a lambert surface
+glm::vec3 sampleHemisphere(const glm::vec3& normal, std::minstd_rand& random)
+{
+    std::uniform_real_distribution<float> uniform(0.0F, 1.0F);
+    const float                           radius = std::sqrt(uniform(random));
+    const float                           angle  = 2.0F * PI * uniform(random);
+
+    glm::vec3 tangent {0.0F};
+    glm::vec3 bitangent {0.0F};
+    getBasis(normal, tangent, bitangent);
+    return radius * std::cos(angle) * tangent + radius * std::sin(angle) * bitangent +
+           std::sqrt(std::max(0.0F, 1.0F - radius * radius)) * normal;
+}
+
+glm::vec3 sampleSphere(std::minstd_rand& random)
+{
+    std::uniform_real_distribution<float> uniform(0.0F, 1.0F);
+    const float                           z      = 1.0F - 2.0F * uniform(random);
+    const float                           radius = std::sqrt(std::max(0.0F, 1.0F - z * z));
+    const float                           angle  = 2.0F * PI * uniform(random);
+    return {radius * std::cos(angle), radius * std::sin(angle), z};
+}
+
+// linear albedo at the hit, nearest texel with wrapping like the impostor baker
+glm::vec3 sampleAlbedo(const BakeScene& scene, const RayHit& hit)
+{
+    const MeshAsset& mesh = scene.mesh;
+    glm::vec2        texCoord {0.0F};
+    const float      weights[3] = {1.0F - hit.barycentric.x - hit.barycentric.y, hit.barycentric.x, hit.barycentric.y};
+    for (uint32_t corner = 0; corner < 3; corner++)
+    {
+        const uint32_t vertex = mesh.indices[static_cast<size_t>(hit.triangle) * 3 + corner];
+        if (vertex < mesh.texCoords.size())
+        {
+            texCoord += weights[corner] * mesh.texCoords[vertex];
+        }
+    }
+
+    const ImageAsset& texture = scene.texture;
+    const glm::vec2   wrapped = texCoord - glm::floor(texCoord);
+    const uint32_t    x       = std::min(static_cast<uint32_t>(wrapped.x * texture.width), texture.width - 1);
+    const uint32_t    y       = std::min(static_cast<uint32_t>(wrapped.y * texture.height), texture.height - 1);
+    const uint8_t*    texel   = &texture.pixels[(static_cast<size_t>(y) * texture.width + x) * CHANNELS];
+    return {scene.srgbToLinear[texel[0]], scene.srgbToLinear[texel[1]], scene.srgbToLinear[texel[2]]};
+}
+
+// radiance arriving along the active rays of the packet. Every ray continues as a path over up to bounceCount
+// surfaces, each of them adds the sun it reflects behind a shadow ray, paths that leave the mesh gather the sky
+void traceRadiance(const BakeScene& scene,
+                   RayPacket         packet,
+                   std::minstd_rand& random,
+                   glm::vec3 (&radiance)[RayPacket::WIDTH])
+{
+    glm::vec3 throughput[RayPacket::WIDTH];
+    for (uint32_t lane = 0; lane < RayPacket::WIDTH; lane++)
+    {
+        throughput[lane] = glm::vec3(1.0F);
+        radiance[lane]   = glm::vec3(0.0F);
+    }
+
+    for (uint32_t bounce = 0; bounce < scene.settings.bounceCount && packet.activeMask != 0; bounce++)
+    {
+        RayHit         hits[RayPacket::WIDTH];
+        const uint32_t hitMask = scene.bvh.raycastPacket(packet, hits);
+
+        RayPacket shadowPacket;
+        shadowPacket.activeMask = 0;
+        glm::vec3 sunLight[RayPacket::WIDTH];
+        for (uint32_t lane = 0; lane < RayPacket::WIDTH; lane++)
+        {
+            const uint32_t bit = 1U << lane;
+            if ((packet.activeMask & bit) == 0)
+                continue;
+
+            if ((hitMask & bit) == 0)
+            {
+                radiance[lane] += throughput[lane] * scene.settings.skyRadiance;
+                packet.activeMask &= ~bit;
+                continue;
+            }
+
+            const Ray& ray    = packet.rays[lane];
+            glm::vec3  normal = scene.faceNormals[hits[lane].triangle];
+            if (glm::dot(normal, ray.direction) > 0.0F)
+            {
+                normal = -normal;
+            }
+            const glm::vec3 position = ray.origin + ray.direction * hits[lane].distance + normal * scene.rayOffset;
+
+            throughput[lane] *= sampleAlbedo(scene, hits[lane]);
+
+            const float cosine = glm::dot(normal, scene.sunDirection);
+            if (cosine > 0.0F)
+            {
+                shadowPacket.rays[lane] = {position, scene.sunDirection};
+                shadowPacket.activeMask |= bit;
+                sunLight[lane] = throughput[lane] * scene.settings.sunIrradiance * (cosine / PI);
+            }
+
+            packet.rays[lane] = {position, sampleHemisphere(normal, random)};
+        }
+
+        if (shadowPacket.activeMask == 0)
+            continue;
+
+        RayHit         shadowHits[RayPacket::WIDTH];
+        const uint32_t occludedMask = scene.bvh.raycastPacket(shadowPacket, shadowHits);
+        for (uint32_t lane = 0; lane < RayPacket::WIDTH; lane++)
+        {
+            if ((shadowPacket.activeMask & ~occludedMask & (1U << lane)) != 0)
+            {
+                radiance[lane] += sunLight[lane];
+            }
+        }
+    }
+}
+
+// rasterizes the triangles over their texture coordinates, the first triangle covering a texel center owns it
+std::vector<LightmapTexel> gatherTexels(const BakeScene& scene, uint32_t resolution, std::vector<bool>& covered)
+{
+    const MeshAsset& mesh = scene.mesh;
+    const auto       size = static_cast<float>(resolution);
+
+    std::vector<LightmapTexel> texels;
+    covered.assign(static_cast<size_t>(resolution) * resolution, false);
+    for (size_t triangle = 0; triangle < mesh.indices.size() / 3; triangle++)
+    {
+        const uint32_t i0 = mesh.indices[triangle * 3];
+        const uint32_t i1 = mesh.indices[triangle * 3 + 1];
+        const uint32_t i2 = mesh.indices[triangle * 3 + 2];
+        if (i0 >= mesh.texCoords.size() || i1 >= mesh.texCoords.size() || i2 >= mesh.texCoords.size())
+            continue;
+
+        const glm::vec2 p0   = mesh.texCoords[i0] * size;
+        const glm::vec2 p1   = mesh.texCoords[i1] * size;
+        const glm::vec2 p2   = mesh.texCoords[i2] * size;
+        const float     area = edge(p0, p1, p2);
+        if (std::abs(area) < 1e-8F)
+            continue;
+
+        const glm::vec2 boundsMin = glm::min(glm::min(p0, p1), p2);
+        const glm::vec2 boundsMax = glm::max(glm::max(p0, p1), p2);
+        const auto      minX      = static_cast<uint32_t>(std::clamp(std::floor(boundsMin.x), 0.0F, size - 1.0F));
+        const auto      minY      = static_cast<uint32_t>(std::clamp(std::floor(boundsMin.y), 0.0F, size - 1.0F));
+        const auto      maxX      = static_cast<uint32_t>(std::clamp(std::ceil(boundsMax.x), 0.0F, size - 1.0F));
+        const auto      maxY      = static_cast<uint32_t>(std::clamp(std::ceil(boundsMax.y), 0.0F, size - 1.0F));
+
+        for (uint32_t y = minY; y <= maxY; y++)
+        {
+            for (uint32_t x = minX; x <= maxX; x++)
+            {
+                // dividing by the signed area accepts both windings
+                const glm::vec2 center {static_cast<float>(x) + 0.5F, static_cast<float>(y) + 0.5F};
+                const float     weight0 = edge(p1, p2, center) / area;
+                const float     weight1 = edge(p2, p0, center) / area;
+                const float     weight2 = 1.0F - weight0 - weight1;
+                const size_t    index   = static_cast<size_t>(y) * resolution + x;
+                if (weight0 < 0.0F || weight1 < 0.0F || weight2 < 0.0F || covered[index])
+                    continue;
+
+                const glm::vec3 position =
+                    weight0 * mesh.positions[i0] + weight1 * mesh.positions[i1] + weight2 * mesh.positions[i2];
+                covered[index] = true;
+                texels.push_back({static_cast<uint32_t>(index), position, scene.faceNormals[triangle]});
+            }
+        }
+    }
+    return texels;
+}
+
+void bakeTexel(const BakeScene& scene, const LightmapTexel& texel, std::vector<glm::vec3>& lightmap)
+{
+    const LightmapBakeSettings& settings = scene.settings;
+    const glm::vec3             origin   = texel.position + texel.normal * scene.rayOffset;
+    const uint32_t packetCount = std::max(1U, (settings.samplesPerTexel + RayPacket::WIDTH - 1) / RayPacket::WIDTH);
+
+    std::minstd_rand random(settings.seed * 0x9E3779B9U + texel.index + 1);
+
+    // the cosine weighted mean of the incoming radiance is irradiance / pi already
+    glm::vec3 sum {0.0F};
+    for (uint32_t packetIndex = 0; packetIndex < packetCount; packetIndex++)
+    {
+        RayPacket packet;
+        for (Ray& ray : packet.rays)
+        {
+            ray = {origin, sampleHemisphere(texel.normal, random)};
+        }
+
+        glm::vec3 radiance[RayPacket::WIDTH];
+        traceRadiance(scene, packet, random, radiance);
+        for (const glm::vec3& laneRadiance : radiance)
+        {
+            sum += laneRadiance;
+        }
+    }
+    glm::vec3 light = sum / static_cast<float>(packetCount * RayPacket::WIDTH);
+
+    // the sun is a single direction, one shadow ray finds it exactly
+    const float cosine = glm::dot(texel.normal, scene.sunDirection);
+    RayHit      hit;
+    if (cosine > 0.0F && !scene.bvh.raycast({origin, scene.sunDirection}, hit))
+    {
+        light += settings.sunIrradiance * (cosine / PI);
+    }
+    lightmap[texel.index] = light;
+}
+
+// projects the radiance arriving from the whole sphere around the probe onto the l1 basis
+IrradianceProbe bakeProbe(const BakeScene& scene, const glm::vec3& position, uint32_t probe)
+{
+    const LightmapBakeSettings& settings = scene.settings;
+    const uint32_t packetCount = std::max(1U, (settings.samplesPerProbe + RayPacket::WIDTH - 1) / RayPacket::WIDTH);
+    const float    weight      = 4.0F * PI / static_cast<float>(packetCount * RayPacket::WIDTH);
+
+    std::minstd_rand random(settings.seed * 0x85EBCA6BU + probe + 1);
+
+    IrradianceProbe result;
+    for (uint32_t packetIndex = 0; packetIndex < packetCount; packetIndex++)
+    {
+        RayPacket packet;
+        for (Ray& ray : packet.rays)
+        {
+            ray = {position, sampleSphere(random)};
+        }
+
+        glm::vec3 radiance[RayPacket::WIDTH];
+        traceRadiance(scene, packet, random, radiance);
+        for (uint32_t lane = 0; lane < RayPacket::WIDTH; lane++)
+        {
+            const glm::vec3& direction = packet.rays[lane].direction;
+            const glm::vec3  sample    = radiance[lane] * weight;
+            result.coefficients[0] += sample * SH_BAND0;
+            result.coefficients[1] += sample * (SH_BAND1 * direction.y);
+            result.coefficients[2] += sample * (SH_BAND1 * direction.z);
+            result.coefficients[3] += sample * (SH_BAND1 * direction.x);
+        }
+    }
+    return result;
+}
+
+// grows the values into the texels around the charts
+void dilate(std::vector<glm::vec3>& lightmap, std::vector<bool> filled, uint32_t resolution)
+{
+    const std::array<glm::ivec2, 4> neighbourOffsets = {{{-1, 0}, {1, 0}, {0, -1}, {0, 1}}};
+
+    std::vector<bool> grown = filled;
+    for (uint32_t pass = 0; pass < DILATION_PASSES; pass++)
+    {
+        for (uint32_t y = 0; y < resolution; y++)
+        {
+            for (uint32_t x = 0; x < resolution; x++)
+            {
+                const size_t index = static_cast<size_t>(y) * resolution + x;
+                if (filled[index])
+                    continue;
+
+                glm::vec3 sum {0.0F};
+                uint32_t  count = 0;
+                for (const glm::ivec2& offset : neighbourOffsets)
+                {
+                    const glm::ivec2 neighbour = glm::ivec2(x, y) + offset;
+                    if (neighbour.x < 0 || neighbour.y < 0 || neighbour.x >= static_cast<int32_t>(resolution) ||
+                        neighbour.y >= static_cast<int32_t>(resolution) ||
+                        !filled[static_cast<size_t>(neighbour.y) * resolution + neighbour.x])
+                        continue;
+
+                    sum += lightmap[static_cast<size_t>(neighbour.y) * resolution + neighbour.x];
+                    count++;
+                }
+                if (count == 0)
+                    continue;
+
+                lightmap[index] = sum / static_cast<float>(count);
+                grown[index]    = true;
+            }
+        }
+        filled = grown;
+    }
+}
+
+template <typename T>
+void appendBytes(std::vector<uint8_t>& data, const T& value)
+{
+    const size_t offset = data.size();
+    data.resize(offset + sizeof(T));
+    std::memcpy(data.data() + offset, &value, sizeof(T));
+}
+} // namespace
+
+namespace LightmapBaker
+{
+BakedLighting
+bake(const MeshAsset& mesh, const ImageAsset& texture, const LightmapBakeSettings& settings, JobSystem* jobSystem)
+{
+    BakedLighting lighting;
+    for (const glm::vec3& position : mesh.positions)
+    {
+        lighting.probeBounds.expand(position);
+    }
+    if (lighting.probeBounds.isEmpty() || mesh.texCoords.empty() || texture.pixels.empty())
+        return lighting;
+
+    LightmapBakeSettings clampedSettings = settings;
+    clampedSettings.resolution           = std::max(1U, settings.resolution);
+    clampedSettings.bounceCount          = std::max(1U, settings.bounceCount);
+
+    BakeScene scene {mesh,
+                     texture,
+                     clampedSettings,
+                     glm::normalize(settings.sunDirection),
+                     RAY_OFFSET_SCALE * glm::length(lighting.probeBounds.getExtent()),
+                     {},
+                     {},
+                     {}};
+    scene.bvh.build(mesh.positions, mesh.indices, jobSystem);
+    for (uint32_t value = 0; value < scene.srgbToLinear.size(); value++)
+    {
+        scene.srgbToLinear[value] = toLinear(static_cast<float>(value) / 255.0F);
+    }
+
+    scene.faceNormals.resize(mesh.indices.size() / 3);
+    for (size_t triangle = 0; triangle < scene.faceNormals.size(); triangle++)
+    {
+        const glm::vec3& p0    = mesh.positions[mesh.indices[triangle * 3]];
+        const glm::vec3& p1    = mesh.positions[mesh.indices[triangle * 3 + 1]];
+        const glm::vec3& p2    = mesh.positions[mesh.indices[triangle * 3 + 2]];
+        const glm::vec3  cross = glm::cross(p1 - p0, p2 - p0);
+        const float      area  = glm::length(cross);
+        scene.faceNormals[triangle] = area > 0.0F ? cross / area : glm::vec3(0.0F, 0.0F, 1.0F);
+    }
+
+    const uint32_t resolution = clampedSettings.resolution;
+    lighting.lightmapResolution = resolution;
+    lighting.lightmap.assign(static_cast<size_t>(resolution) * resolution, glm::vec3(0.0F));
+
+    std::vector<bool>                covered;
+    const std::vector<LightmapTexel> texels = gatherTexels(scene, resolution, covered);
+
+    const auto bakeTexels = [&](uint32_t begin, uint32_t end) {
+        for (uint32_t texel = begin; texel < end; texel++)
+        {
+            bakeTexel(scene, texels[texel], lighting.lightmap);
+        }
+    };
+
+    // probes on a grid over the bounds, a single probe on an axis sits in the middle
+    lighting.probeCounts = settings.probeCounts;
+    const uint32_t probeCount = settings.probeCounts.x * settings.probeCounts.y * settings.probeCounts.z;
+    lighting.probes.resize(probeCount);
+
+    const auto bakeProbes = [&](uint32_t begin, uint32_t end) {
+        for (uint32_t probe = begin; probe < end; probe++)
+        {
+            const glm::uvec3 coord {probe % settings.probeCounts.x,
+                                    probe / settings.probeCounts.x % settings.probeCounts.y,
+                                    probe / (settings.probeCounts.x * settings.probeCounts.y)};
+            const glm::vec3  fraction = glm::mix(glm::vec3(0.5F),
+                                                glm::vec3(coord) / glm::vec3(glm::max(settings.probeCounts, 2U) - 1U),
+                                                glm::greaterThan(settings.probeCounts, glm::uvec3(1U)));
+            const glm::vec3  position = lighting.probeBounds.min + fraction * lighting.probeBounds.getExtent();
+            lighting.probes[probe]    = bakeProbe(scene, position, probe);
+        }
+    };
+
+    const auto texelCount = static_cast<uint32_t>(texels.size());
+    if (jobSystem != nullptr)
+    {
+        jobSystem->parallelFor(texelCount, TEXELS_PER_JOB, bakeTexels);
+        jobSystem->parallelFor(probeCount, PROBES_PER_JOB, bakeProbes);
+    }
+    else
+    {
+        bakeTexels(0, texelCount);
+        bakeProbes(0, probeCount);
+    }
+
+    dilate(lighting.lightmap, std::move(covered), resolution);
+    return lighting;
+}
+
+bool writeLighting(const BakedLighting& lighting, const std::string& pathPrefix)
+{
+    if (lighting.isEmpty())
+        return false;
+
+    // srgb spends the 8 bits where the eye tells dark values apart, the runtime samples it through an srgb format
+    const uint32_t       resolution = lighting.lightmapResolution;
+    std::vector<uint8_t> pixels(lighting.lightmap.size() * CHANNELS, 255);
+    for (size_t texel = 0; texel < lighting.lightmap.size(); texel++)
+    {
+        for (uint32_t channel = 0; channel < 3; channel++)
+        {
+            const float value = std::clamp(lighting.lightmap[texel][channel] / LIGHTMAP_RANGE, 0.0F, 1.0F);
+            pixels[texel * CHANNELS + channel] = static_cast<uint8_t>(std::lround(toSrgb(value) * 255.0F));
+        }
+    }
+
+    std::vector<uint8_t> png;
+    ImageWriter::encodePng(pixels.data(), resolution, resolution, CHANNELS, png);
+    if (!ImageWriter::writeFile(pathPrefix + "_lightmap.png", png))
+        return false;
+
+    std::vector<uint8_t> probes;
+    appendBytes(probes, PROBE_FILE_MAGIC);
+    appendBytes(probes, lighting.probeCounts);
+    appendBytes(probes, lighting.probeBounds.min);
+    appendBytes(probes, lighting.probeBounds.max);
+    for (const IrradianceProbe& probe : lighting.probes)
+    {
+        appendBytes(probes, probe.coefficients);
+    }
+    return ImageWriter::writeFile(pathPrefix + "_probes.bin", probes);
+}
+
+bool bakeFiles(const std::string&          meshPath,
+               const std::string&          texturePath,
+               const std::string&          pathPrefix,
+               const LightmapBakeSettings& settings)
+{
+    TaskExecutor executor;
+    JobSystem    jobSystem;
+
+    const MeshAsset  mesh    = syncWait(AssetLoader::loadMesh(executor, meshPath));
+    const ImageAsset texture = syncWait(AssetLoader::loadImage(executor, texturePath));
+
+    const auto          bakeStart = std::chrono::high_resolution_clock::now();
+    const BakedLighting lighting  = bake(mesh, texture, settings, &jobSystem);
+    if (lighting.isEmpty())
+    {
+        LOG_ERROR("Lighting of {} is empty, the mesh has no texture coordinates or its texture has no data", meshPath);
+        return false;
+    }
+
+    LOG_INFO("Lighting of {}: {}x{} lightmap at {} samples per texel, {} probes, {} bounces, baked in {:.2f} ms on {} "
+             "threads",
+             meshPath,
+             lighting.lightmapResolution,
+             lighting.lightmapResolution,
+             settings.samplesPerTexel,
+             lighting.probes.size(),
+             settings.bounceCount,
+             std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - bakeStart).count(),
+             jobSystem.getThreadCount());
+
+    if (!writeLighting(lighting, pathPrefix))
+    {
+        LOG_ERROR("Failed to write the baked lighting to {}", pathPrefix);
+        return false;
+    }
+    return true;
+}
+
+glm::vec3 evaluateIrradiance(const IrradianceProbe& probe, const glm::vec3& normal)
+{
+    // convolution with the clamped cosine scales band 0 by pi and band 1 by 2 pi / 3
+    const std::array<glm::vec3, 4>& coefficients = probe.coefficients;
+    const glm::vec3                 irradiance =
+        PI * SH_BAND0 * coefficients[0] +
+        (2.0F * PI / 3.0F) * SH_BAND1 *
+            (coefficients[1] * normal.y + coefficients[2] * normal.z + coefficients[3] * normal.x);
+    return glm::max(irradiance, 0.0F);
+}
+} // namespace LightmapBaker
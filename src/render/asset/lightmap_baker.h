@@ -0,0 +1,70 @@
+#pragma once
+
+#include "foundation/job/job_system.h"
+#include "foundation/math/aabb.h"
+#include "render/asset/asset_loader.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct LightmapBakeSettings
+{
+    uint32_t   resolution {512};     // texels per side of the lightmap, laid out over the texture coordinates
+    uint32_t   samplesPerTexel {64}; // rounded up to whole ray packets, like the samples of a probe
+    uint32_t   samplesPerProbe {256};
+    uint32_t   bounceCount {2};      // surfaces a path may hit, 1 gathers the sky and the directly lit surfaces only
+    glm::vec3  sunDirection {0.408F, 0.408F, 0.816F}; // towards the sun, the light direction of the shaders
+    glm::vec3  sunIrradiance {2.2F};                  // on a surface facing the sun, pi * 0.7 like the lambert light
+    glm::vec3  skyRadiance {0.3F};                    // an open surface gathers the ambient term of the lambert light
+    glm::uvec3 probeCounts {8, 8, 4};                 // grid over the bounds of the mesh, 0 on any axis bakes none
+    uint32_t   seed {1};
+};
+
+// Incoming radiance around a point as l1 spherical harmonics, constant term first and then y, z, x.
+struct IrradianceProbe
+{
+    std::array<glm::vec3, 4> coefficients {};
+};
+
+// Diffuse lighting of a static mesh. The lightmap stores irradiance / pi, the radiance a white lambert surface
+// reflects, so the runtime only multiplies it with the albedo. Texels no triangle covers borrow their neighbours.
+struct BakedLighting
+{
+    uint32_t                     lightmapResolution {0};
+    std::vector<glm::vec3>       lightmap; // linear, rows with v pointing down like the texture coordinates
+    Aabb                         probeBounds {};
+    glm::uvec3                   probeCounts {0};
+    std::vector<IrradianceProbe> probes; // x fastest, the corner probes sit on the corners of the bounds
+
+    [[nodiscard]] bool isEmpty() const { return lightmap.empty(); }
+};
+
+// Offline baking of static lighting with a path tracer on the cpu, it needs no device and runs headless. Paths are
+// traced four at a time as ray packets through a bvh of the mesh, the texels and probes are spread over the job system.
+namespace LightmapBaker
+{
+// the lightmap png holds srgb encoded values divided by this, the shaders scale them back up
+constexpr float LIGHTMAP_RANGE = 2.0F;
+
+// the texture coordinates double as lightmap coordinates, which needs a unique unwrap like an atlas texture
+BakedLighting bake(const MeshAsset&            mesh,
+                   const ImageAsset&           texture,
+                   const LightmapBakeSettings& settings  = {},
+                   JobSystem*                  jobSystem = nullptr);
+
+// writes <prefix>_lightmap.png and <prefix>_probes.bin, false when a file could not be written
+bool writeLighting(const BakedLighting& lighting, const std::string& pathPrefix);
+
+// the headless cook step behind --bake-lightmap, loads the mesh and its texture, bakes them and writes the results
+bool bakeFiles(const std::string&          meshPath,
+               const std::string&          texturePath,
+               const std::string&          pathPrefix,
+               const LightmapBakeSettings& settings = {});
+
+// irradiance arriving at a surface facing normal
+glm::vec3 evaluateIrradiance(const IrradianceProbe& probe, const glm::vec3& normal);
+} // namespace LightmapBaker
@@ -0,0 +1,207 @@
+#include "render/asset/procedural_mesh.h"
+
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace
+{
+constexpr uint32_t TENTACLE_KEY_COUNT      = 16;
+constexpr float    TENTACLE_CLIP_DURATION  = 2.0F;
+constexpr float    TENTACLE_SWAY_AMPLITUDE = 0.35F; // radians per joint
+constexpr float    TENTACLE_JOINT_PHASE    = 0.7F;  // the sway travels up the chain
+constexpr float    TENTACLE_TIP_TAPER      = 0.7F;  // share of the radius lost towards the tip
+
+void addTentacleJoints(SkinnedMeshAsset& asset, uint32_t jointCount, float segmentLength)
+{
+    Skeleton& skeleton = asset.skeleton;
+    skeleton.parents.resize(jointCount);
+    skeleton.bindPose.resize(jointCount);
+    skeleton.inverseBindMatrices.resize(jointCount);
+
+    for (uint32_t joint = 0; joint < jointCount; joint++)
+    {
+        skeleton.parents[joint] = static_cast<int32_t>(joint) - 1;
+        if (joint > 0)
+        {
+            skeleton.bindPose[joint].translation = {0.0F, 0.0F, segmentLength};
+        }
+        skeleton.inverseBindMatrices[joint] =
+            glm::translate(glm::mat4(1.0F), glm::vec3(0.0F, 0.0F, -segmentLength * static_cast<float>(joint)));
+    }
+
+    AnimationClip& clip = asset.clip;
+    clip.duration       = TENTACLE_CLIP_DURATION;
+    clip.tracks.resize(jointCount);
+
+    // the root stays put, every other joint bends a little further than its parent; the last key repeats the first
+    for (uint32_t joint = 1; joint < jointCount; joint++)
+    {
+        JointTrack& track = clip.tracks[joint];
+        for (uint32_t key = 0; key <= TENTACLE_KEY_COUNT; key++)
+        {
+            const float phase = glm::two_pi<float>() * static_cast<float>(key) / TENTACLE_KEY_COUNT -
+                                TENTACLE_JOINT_PHASE * static_cast<float>(joint);
+            const float bendX = TENTACLE_SWAY_AMPLITUDE * std::sin(phase);
+            const float bendY = TENTACLE_SWAY_AMPLITUDE * 0.5F * std::cos(phase);
+
+            track.times.push_back(TENTACLE_CLIP_DURATION * static_cast<float>(key) / TENTACLE_KEY_COUNT);
+            track.translations.push_back(skeleton.bindPose[joint].translation);
+            track.rotations.push_back(glm::angleAxis(bendX, glm::vec3(1.0F, 0.0F, 0.0F)) *
+                                      glm::angleAxis(bendY, glm::vec3(0.0F, 1.0F, 0.0F)));
+        }
+    }
+}
+
+// the two joints whose segments meet closest to the height
+void setJointWeights(SkinnedVertex& vertex, float height, float segmentLength, uint32_t jointCount)
+{
+    const float    segment = height / segmentLength;
+    const uint32_t lower   = std::min(static_cast<uint32_t>(segment), jointCount - 1);
+    const float    blend   = std::clamp(segment - static_cast<float>(lower), 0.0F, 1.0F);
+
+    vertex.joints  = {lower, std::min(lower + 1, jointCount - 1), 0, 0};
+    vertex.weights = {1.0F - blend, blend, 0.0F, 0.0F};
+    if (vertex.joints.x == vertex.joints.y)
+    {
+        vertex.weights = {1.0F, 0.0F, 0.0F, 0.0F};
+    }
+}
+
+void addCorner(MeshAsset& mesh, const glm::vec3& position, const glm::vec2& texCoord)
+{
+    mesh.indices.push_back(static_cast<uint32_t>(mesh.positions.size()));
+    mesh.positions.push_back(position);
+    mesh.texCoords.push_back(texCoord);
+}
+} // namespace
+
+namespace ProceduralMesh
+{
+SkinnedMeshAsset createTentacle(uint32_t jointCount, uint32_t ringCount, uint32_t sideCount, float height, float radius)
+{
+    jointCount = std::max(1U, jointCount);
+    ringCount  = std::max(1U, ringCount);
+    sideCount  = std::max(3U, sideCount);
+
+    const float segmentLength = height / static_cast<float>(jointCount);
+
+    SkinnedMeshAsset asset;
+    addTentacleJoints(asset, jointCount, segmentLength);
+
+    // one seam column more than sides so the texture wraps around once
+    const uint32_t columnCount = sideCount + 1;
+    for (uint32_t ring = 0; ring <= ringCount; ring++)
+    {
+        const float along      = static_cast<float>(ring) / static_cast<float>(ringCount);
+        const float ringHeight = height * along;
+        const float ringRadius = radius * (1.0F - TENTACLE_TIP_TAPER * along);
+
+        for (uint32_t column = 0; column < columnCount; column++)
+        {
+            const float around = static_cast<float>(column) / static_cast<float>(sideCount);
+            const float angle  = glm::two_pi<float>() * around;
+
+            SkinnedVertex vertex {};
+            vertex.position = {ringRadius * std::cos(angle), ringRadius * std::sin(angle), ringHeight, 1.0F};
+            vertex.texCoord = {around, 1.0F - along};
+            setJointWeights(vertex, ringHeight, segmentLength, jointCount);
+            asset.vertices.push_back(vertex);
+        }
+    }
+
+    // counter clockwise seen from outside
+    for (uint32_t ring = 0; ring < ringCount; ring++)
+    {
+        for (uint32_t side = 0; side < sideCount; side++)
+        {
+            const uint32_t bottom = ring * columnCount + side;
+            const uint32_t top    = bottom + columnCount;
+            asset.indices.insert(asset.indices.end(), {bottom, bottom + 1, top + 1, bottom, top + 1, top});
+        }
+    }
+
+    // closes the tip
+    SkinnedVertex tip {};
+    tip.position = {0.0F, 0.0F, height, 1.0F};
+    tip.texCoord = {0.5F, 0.0F};
+    setJointWeights(tip, height, segmentLength, jointCount);
+
+    const auto tipIndex = static_cast<uint32_t>(asset.vertices.size());
+    asset.vertices.push_back(tip);
+
+    const uint32_t topRing = ringCount * columnCount;
+    for (uint32_t side = 0; side < sideCount; side++)
+    {
+        asset.indices.insert(asset.indices.end(), {topRing + side, topRing + side + 1, tipIndex});
+    }
+
+    return asset;
+}
+
+MeshAsset createBox(const glm::vec3& halfExtent)
+{
+    // two triangles of the unit square in the tangent plane of a face, counter clockwise seen from outside
+    constexpr std::array<glm::vec2, 6> FACE_CORNERS = {
+        {{-1.0F, -1.0F}, {1.0F, -1.0F}, {1.0F, 1.0F}, {-1.0F, -1.0F}, {1.0F, 1.0F}, {-1.0F, 1.0F}}};
+
+    MeshAsset mesh;
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        for (const float side : {-1.0F, 1.0F})
+        {
+            // the tangents are swapped on the negative side so that u x v still points outwards
+            glm::vec3 normal {0.0F};
+            glm::vec3 tangentU {0.0F};
+            glm::vec3 tangentV {0.0F};
+            normal[axis]                                 = side;
+            tangentU[(axis + (side > 0.0F ? 1 : 2)) % 3] = 1.0F;
+            tangentV[(axis + (side > 0.0F ? 2 : 1)) % 3] = 1.0F;
+
+            for (const glm::vec2& corner : FACE_CORNERS)
+            {
+                const glm::vec3 unit = normal + tangentU * corner.x + tangentV * corner.y;
+                addCorner(mesh,
+                          glm::vec3(0.0F, 0.0F, halfExtent.z) + unit * halfExtent,
+                          {corner.x * 0.5F + 0.5F, 0.5F - corner.y * 0.5F});
+            }
+        }
+    }
+    return mesh;
+}
+
+MeshAsset createPrism(uint32_t sideCount, float radius, float height)
+{
+    sideCount = std::max(3U, sideCount);
+
+    MeshAsset mesh;
+    for (uint32_t side = 0; side < sideCount; side++)
+    {
+        const float     around0 = static_cast<float>(side) / static_cast<float>(sideCount);
+        const float     around1 = static_cast<float>(side + 1) / static_cast<float>(sideCount);
+        const glm::vec3 corner0 {radius * std::cos(glm::two_pi<float>() * around0),
+                                 radius * std::sin(glm::two_pi<float>() * around0),
+                                 0.0F};
+        const glm::vec3 corner1 {radius * std::cos(glm::two_pi<float>() * around1),
+                                 radius * std::sin(glm::two_pi<float>() * around1),
+                                 0.0F};
+        const glm::vec3 up {0.0F, 0.0F, height};
+
+        // counter clockwise seen from outside, the bottom stays open since the prism stands on the ground
+        addCorner(mesh, corner0, {around0, 1.0F});
+        addCorner(mesh, corner1, {around1, 1.0F});
+        addCorner(mesh, corner1 + up, {around1, 0.0F});
+        addCorner(mesh, corner0, {around0, 1.0F});
+        addCorner(mesh, corner1 + up, {around1, 0.0F});
+        addCorner(mesh, corner0 + up, {around0, 0.0F});
+
+        addCorner(mesh, corner0 + up, {glm::vec2(corner0) / (2.0F * radius) + 0.5F});
+        addCorner(mesh, corner1 + up, {glm::vec2(corner1) / (2.0F * radius) + 0.5F});
+        addCorner(mesh, up, {0.5F, 0.5F});
+    }
+    return mesh;
+}
+} // namespace ProceduralMesh
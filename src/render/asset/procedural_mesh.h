@@ -0,0 +1,42 @@
+#pragma once
+
+#include "foundation/animation/skeletal_animation.h"
+#include "render/asset/asset_loader.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Bind pose vertex of a skinned mesh in std430 layout, the skinning shader reads the array as it is.
+struct SkinnedVertex
+{
+    glm::vec4  position {0.0F, 0.0F, 0.0F, 1.0F};
+    glm::vec2  texCoord {0.0F};
+    glm::vec2  padding {0.0F};
+    glm::vec4  weights {1.0F, 0.0F, 0.0F, 0.0F};
+    glm::uvec4 joints {0};
+};
+
+static_assert(sizeof(SkinnedVertex) == 64, "SkinnedVertex must match the std430 shader layout");
+
+struct SkinnedMeshAsset
+{
+    std::vector<SkinnedVertex> vertices;
+    std::vector<uint32_t>      indices;
+    Skeleton                   skeleton;
+    AnimationClip              clip;
+};
+
+// The repository ships no rigged models, these stand in for them.
+namespace ProceduralMesh
+{
+// Tapered tube standing on the xy plane with a chain of joints up its axis and a looping clip that sways it.
+// Vertices blend between the two joints closest to their height.
+SkinnedMeshAsset
+createTentacle(uint32_t jointCount, uint32_t ringCount, uint32_t sideCount, float height, float radius);
+
+// Static props standing on the xy plane around the origin, one vertex per corner like a loaded obj.
+MeshAsset createBox(const glm::vec3& halfExtent);
+MeshAsset createPrism(uint32_t sideCount, float radius, float height);
+} // namespace ProceduralMesh
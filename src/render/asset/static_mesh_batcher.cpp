@@ -0,0 +1,232 @@
+#include "render/asset/static_mesh_batcher.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace
+{
+constexpr uint32_t PLACEMENT_CHUNK_SIZE = 64;
+constexpr float    MORTON_GRID_SIZE     = 1023.0F;
+
+// spreads the low ten bits of value to every third bit
+uint32_t spreadBits(uint32_t value)
+{
+    value = (value | (value << 16)) & 0x030000FFU;
+    value = (value | (value << 8)) & 0x0300F00FU;
+    value = (value | (value << 4)) & 0x030C30C3U;
+    value = (value | (value << 2)) & 0x09249249U;
+    return value;
+}
+
+uint32_t encodeMorton(const glm::vec3& position, const Aabb& bounds)
+{
+    const glm::vec3  extent = glm::max(bounds.getExtent(), glm::vec3(1e-6F));
+    const glm::uvec3 cell   = glm::clamp((position - bounds.min) / extent, 0.0F, 1.0F) * MORTON_GRID_SIZE;
+    return spreadBits(cell.x) | (spreadBits(cell.y) << 1) | (spreadBits(cell.z) << 2);
+}
+
+// where the vertices and indices of one instance go in the merged buffers
+struct Placement
+{
+    uint32_t instance {0};
+    uint32_t chunk {0};
+    uint32_t firstVertex {0};
+    uint32_t firstIndex {0};
+};
+} // namespace
+
+void StaticBatch::cull(const Frustum& frustum, std::vector<StaticBatchDraw>& draws) const
+{
+    draws.clear();
+
+    for (uint32_t groupIndex = 0; groupIndex < groups.size(); groupIndex++)
+    {
+        const StaticBatchGroup& group = groups[groupIndex];
+
+        const FrustumTest groupTest = frustum.test(group.bounds);
+        if (groupTest == FrustumTest::OUTSIDE || group.chunkCount == 0)
+            continue;
+
+        if (groupTest == FrustumTest::INSIDE)
+        {
+            const StaticBatchChunk& first = chunks[group.firstChunk];
+            const StaticBatchChunk& last  = chunks[group.firstChunk + group.chunkCount - 1];
+            draws.push_back({groupIndex, first.firstIndex, last.firstIndex + last.indexCount - first.firstIndex});
+            continue;
+        }
+
+        for (uint32_t chunkIndex = group.firstChunk; chunkIndex < group.firstChunk + group.chunkCount; chunkIndex++)
+        {
+            const StaticBatchChunk& chunk = chunks[chunkIndex];
+            if (!frustum.intersects(chunk.bounds))
+                continue;
+
+            // the chunks of a group are back to back in the index buffer
+            if (!draws.empty() && draws.back().group == groupIndex &&
+                draws.back().firstIndex + draws.back().indexCount == chunk.firstIndex)
+            {
+                draws.back().indexCount += chunk.indexCount;
+            }
+            else
+            {
+                draws.push_back({groupIndex, chunk.firstIndex, chunk.indexCount});
+            }
+        }
+    }
+}
+
+StaticBatchStatistics StaticBatch::getStatistics() const
+{
+    StaticBatchStatistics statistics {};
+    statistics.groupCount  = static_cast<uint32_t>(groups.size());
+    statistics.chunkCount  = static_cast<uint32_t>(chunks.size());
+    statistics.vertexCount = static_cast<uint32_t>(vertices.size());
+    statistics.indexCount  = static_cast<uint32_t>(indices.size());
+    for (const auto& chunk : chunks)
+    {
+        statistics.instanceCount += chunk.instanceCount;
+    }
+    return statistics;
+}
+
+namespace StaticMeshBatcher
+{
+StaticBatch
+build(const std::vector<StaticMeshInstance>& instances, const StaticBatchSettings& settings, JobSystem* jobSystem)
+{
+    StaticBatch batch;
+
+    // transforming the bounds of the mesh is conservative, but good enough to order the instances
+    std::unordered_map<const MeshAsset*, Aabb> meshBounds;
+    std::vector<Aabb>                          instanceBounds(instances.size());
+    std::vector<uint32_t>                      order;
+    Aabb                                       setBounds {};
+    for (uint32_t instance = 0; instance < instances.size(); instance++)
+    {
+        const MeshAsset* mesh = instances[instance].mesh;
+        if (mesh == nullptr || mesh->indices.empty())
+            continue;
+
+        auto [entry, inserted] = meshBounds.try_emplace(mesh);
+        if (inserted)
+        {
+            for (const glm::vec3& position : mesh->positions)
+            {
+                entry->second.expand(position);
+            }
+        }
+
+        instanceBounds[instance] = entry->second.transformed(instances[instance].transform);
+        setBounds.expand(instanceBounds[instance]);
+        order.push_back(instance);
+    }
+
+    // material in the high half of the key, so the groups come out in material order
+    std::vector<uint64_t> sortKeys(instances.size());
+    for (const uint32_t instance : order)
+    {
+        sortKeys[instance] = (static_cast<uint64_t>(instances[instance].material) << 32U) |
+                             encodeMorton(instanceBounds[instance].getCenter(), setBounds);
+    }
+    std::sort(order.begin(), order.end(), [&sortKeys](uint32_t left, uint32_t right) {
+        return sortKeys[left] < sortKeys[right];
+    });
+
+    // cut the order into groups and chunks, only counts are needed for that
+    std::vector<Placement> placements;
+    placements.reserve(order.size());
+
+    uint32_t vertexCount      = 0;
+    uint32_t indexCount       = 0;
+    uint32_t chunkVertexCount = 0;
+    for (const uint32_t instance : order)
+    {
+        const MeshAsset& mesh            = *instances[instance].mesh;
+        const uint32_t   material        = instances[instance].material;
+        const auto       meshVertexCount = static_cast<uint32_t>(mesh.positions.size());
+        const bool       startsGroup     = batch.groups.empty() || batch.groups.back().material != material;
+        const bool       chunkFull =
+            chunkVertexCount > 0 && chunkVertexCount + meshVertexCount > settings.maxChunkVertices;
+
+        if (startsGroup)
+        {
+            StaticBatchGroup group {};
+            group.material   = material;
+            group.firstChunk = static_cast<uint32_t>(batch.chunks.size());
+            batch.groups.push_back(group);
+        }
+
+        if (startsGroup || chunkFull)
+        {
+            StaticBatchChunk chunk {};
+            chunk.firstIndex = indexCount;
+            batch.chunks.push_back(chunk);
+            batch.groups.back().chunkCount++;
+            chunkVertexCount = 0;
+        }
+
+        placements.push_back({instance, static_cast<uint32_t>(batch.chunks.size() - 1), vertexCount, indexCount});
+
+        StaticBatchChunk& chunk = batch.chunks.back();
+        chunk.indexCount += static_cast<uint32_t>(mesh.indices.size());
+        chunk.instanceCount++;
+
+        chunkVertexCount += meshVertexCount;
+        vertexCount += meshVertexCount;
+        indexCount += static_cast<uint32_t>(mesh.indices.size());
+    }
+
+    batch.vertices.resize(vertexCount);
+    batch.indices.resize(indexCount);
+
+    // exact bounds of the transformed vertices, the chunks are culled with these
+    std::vector<Aabb> placementBounds(placements.size());
+
+    const auto copyPlacements = [&](uint32_t begin, uint32_t end) {
+        for (uint32_t placementIndex = begin; placementIndex < end; placementIndex++)
+        {
+            const Placement&          placement = placements[placementIndex];
+            const StaticMeshInstance& instance  = instances[placement.instance];
+            const MeshAsset&          mesh      = *instance.mesh;
+
+            for (uint32_t vertex = 0; vertex < mesh.positions.size(); vertex++)
+            {
+                StaticBatchVertex& target = batch.vertices[placement.firstVertex + vertex];
+                target.position           = glm::vec3(instance.transform * glm::vec4(mesh.positions[vertex], 1.0F));
+                target.texCoord           = vertex < mesh.texCoords.size() ? mesh.texCoords[vertex] : glm::vec2(0.0F);
+                placementBounds[placementIndex].expand(target.position);
+            }
+
+            for (uint32_t index = 0; index < mesh.indices.size(); index++)
+            {
+                batch.indices[placement.firstIndex + index] = placement.firstVertex + mesh.indices[index];
+            }
+        }
+    };
+
+    const auto placementCount = static_cast<uint32_t>(placements.size());
+    if (jobSystem != nullptr)
+    {
+        jobSystem->parallelFor(placementCount, PLACEMENT_CHUNK_SIZE, copyPlacements);
+    }
+    else
+    {
+        copyPlacements(0, placementCount);
+    }
+
+    for (uint32_t placementIndex = 0; placementIndex < placementCount; placementIndex++)
+    {
+        batch.chunks[placements[placementIndex].chunk].bounds.expand(placementBounds[placementIndex]);
+    }
+
+    for (auto& group : batch.groups)
+    {
+        for (uint32_t chunk = group.firstChunk; chunk < group.firstChunk + group.chunkCount; chunk++)
+        {
+            group.bounds.expand(batch.chunks[chunk].bounds);
+        }
+    }
+
+    return batch;
+}
+} // namespace StaticMeshBatcher
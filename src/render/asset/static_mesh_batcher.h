@@ -0,0 +1,100 @@
+#pragma once
+
+#include "foundation/job/job_system.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/frustum.h"
+#include "render/asset/asset_loader.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Vertex of the merged buffers, already transformed into the space of the batch.
+struct StaticBatchVertex
+{
+    glm::vec3 position {0.0F};
+    glm::vec2 texCoord {0.0F};
+};
+
+static_assert(sizeof(StaticBatchVertex) == 20, "StaticBatchVertex must stay tightly packed");
+
+// One placement of a mesh. Instances with the same material end up in the same draws, the mesh is only read while
+// the batch is built.
+struct StaticMeshInstance
+{
+    const MeshAsset* mesh {nullptr};
+    glm::mat4        transform {1.0F};
+    uint32_t         material {0};
+};
+
+// Spatially compact run of whole instances of one material, the unit of culling.
+struct StaticBatchChunk
+{
+    Aabb     bounds;
+    uint32_t firstIndex {0};
+    uint32_t indexCount {0};
+    uint32_t instanceCount {0};
+};
+
+// The chunks of one material, consecutive in the index buffer so that neighbouring visible chunks merge into one draw.
+struct StaticBatchGroup
+{
+    Aabb     bounds;
+    uint32_t material {0};
+    uint32_t firstChunk {0};
+    uint32_t chunkCount {0};
+};
+
+struct StaticBatchDraw
+{
+    uint32_t group {0};
+    uint32_t firstIndex {0};
+    uint32_t indexCount {0};
+
+    bool operator==(const StaticBatchDraw& other) const
+    {
+        return group == other.group && firstIndex == other.firstIndex && indexCount == other.indexCount;
+    }
+};
+
+struct StaticBatchStatistics
+{
+    uint32_t instanceCount {0};
+    uint32_t groupCount {0};
+    uint32_t chunkCount {0};
+    uint32_t vertexCount {0};
+    uint32_t indexCount {0};
+};
+
+// Many small static meshes merged into one vertex and one index buffer. Indices are absolute, so any run of
+// consecutive chunks of a group is a single indexed draw without a vertex offset.
+struct StaticBatch
+{
+    std::vector<StaticBatchVertex> vertices;
+    std::vector<uint32_t>          indices;
+    std::vector<StaticBatchChunk>  chunks;
+    std::vector<StaticBatchGroup>  groups;
+
+    // replaces draws with one draw per run of consecutive visible chunks, a group inside the frustum is one draw
+    void cull(const Frustum& frustum, std::vector<StaticBatchDraw>& draws) const;
+
+    [[nodiscard]] bool                  isEmpty() const { return indices.empty(); }
+    [[nodiscard]] StaticBatchStatistics getStatistics() const;
+};
+
+struct StaticBatchSettings
+{
+    // a chunk closes before it would exceed this, a single larger instance still gets a chunk of its own
+    uint32_t maxChunkVertices {8192};
+};
+
+// Merges static meshes at load time. Instances are grouped by material and ordered along a Morton curve through the
+// bounds of the whole set within a group, so the chunks cut from that order stay compact and cull well. Copying and
+// transforming the vertices runs on the job system when there is one.
+namespace StaticMeshBatcher
+{
+StaticBatch build(const std::vector<StaticMeshInstance>& instances,
+                  const StaticBatchSettings&             settings  = {},
+                  JobSystem*                             jobSystem = nullptr);
+} // namespace StaticMeshBatcher
@@ -0,0 +1,165 @@
+#include "render/backend/null/null_rhi_backend.h"
+
+#include "foundation/log/log_system.h"
+
+#include <cstring>
+
+RhiBufferHandle NullRhiBackend::createBuffer(const RhiBufferDesc& desc, const void* initialData)
+{
+    RhiBufferHandle handle {};
+    if (!freeBufferSlots_.empty())
+    {
+        handle.index = freeBufferSlots_.back();
+        freeBufferSlots_.pop_back();
+    }
+    else
+    {
+        handle.index = static_cast<uint32_t>(buffers_.size());
+        buffers_.emplace_back();
+        bufferAlive_.push_back(false);
+    }
+
+    std::vector<std::byte>& data = buffers_[handle.index];
+    data.resize(static_cast<size_t>(desc.size));
+    if (initialData != nullptr)
+    {
+        memcpy(data.data(), initialData, data.size());
+    }
+    bufferAlive_[handle.index] = true;
+
+    return handle;
+}
+
+void NullRhiBackend::destroyBuffer(RhiBufferHandle buffer)
+{
+    buffers_[buffer.index].clear();
+    buffers_[buffer.index].shrink_to_fit();
+    bufferAlive_[buffer.index] = false;
+    freeBufferSlots_.push_back(buffer.index);
+}
+
+RhiPipelineHandle NullRhiBackend::createPipeline()
+{
+    return RhiPipelineHandle {++pipelineCount_};
+}
+
+RhiDescriptorSetHandle NullRhiBackend::createDescriptorSet()
+{
+    return RhiDescriptorSetHandle {++descriptorSetCount_};
+}
+
+void NullRhiBackend::execute(const RhiCommandList& commandList)
+{
+    commandList.forEach([this](const RhiCommandHeader& header) {
+        validate(header);
+
+        commandCounts_[static_cast<size_t>(header.type)]++;
+        executedBytes_ += header.size;
+        statistics_.commandCount++;
+
+        if (header.type == RhiCommandType::DRAW)
+        {
+            const auto& command = RhiCommandList::as<RhiCmdDraw>(header);
+            primitiveCount_ += static_cast<uint64_t>(command.vertexCount / 3) * command.instanceCount;
+            statistics_.drawCount++;
+        }
+        else if (header.type == RhiCommandType::DRAW_INDEXED)
+        {
+            const auto& command = RhiCommandList::as<RhiCmdDrawIndexed>(header);
+            primitiveCount_ += static_cast<uint64_t>(command.indexCount / 3) * command.instanceCount;
+            statistics_.drawCount++;
+        }
+        else if (header.type == RhiCommandType::DRAW_INDIRECT)
+        {
+            // no gpu writes the arguments here, count what the buffer holds and only the draws that fit into it
+            const auto& command = RhiCommandList::as<RhiCmdDrawIndirect>(header);
+            const auto& data    = buffers_[command.buffer.index];
+            for (uint32_t draw = 0; draw < command.drawCount; draw++)
+            {
+                const uint64_t offset = command.offset + static_cast<uint64_t>(draw) * command.stride;
+                if (offset + sizeof(uint32_t) * 2 > data.size())
+                {
+                    break;
+                }
+
+                uint32_t counts[2] = {}; // vertex count, instance count
+                memcpy(counts, data.data() + offset, sizeof(counts));
+                primitiveCount_ += static_cast<uint64_t>(counts[0] / 3) * counts[1];
+                statistics_.drawCount++;
+            }
+        }
+    });
+}
+
+const std::vector<std::byte>& NullRhiBackend::getBufferData(RhiBufferHandle buffer) const
+{
+    return buffers_[buffer.index];
+}
+
+uint64_t NullRhiBackend::getCommandCount(RhiCommandType type) const
+{
+    return commandCounts_[static_cast<size_t>(type)];
+}
+
+uint32_t NullRhiBackend::getBufferCount() const
+{
+    // slot 0 is never handed out
+    return static_cast<uint32_t>(buffers_.size() - 1 - freeBufferSlots_.size());
+}
+
+void NullRhiBackend::resetCounters()
+{
+    commandCounts_  = {};
+    primitiveCount_ = 0;
+    executedBytes_  = 0;
+    resetStatistics();
+}
+
+void NullRhiBackend::validate(const RhiCommandHeader& header) const
+{
+    // a real backend would crash or hang the device on these, catch them where they are cheap to debug
+    if (header.type >= RhiCommandType::COUNT)
+    {
+        LOG_FATAL("Unknown rhi command type {}", static_cast<uint32_t>(header.type));
+    }
+
+    const auto checkBuffer = [this](RhiBufferHandle buffer) {
+        if (buffer.index >= buffers_.size() || !bufferAlive_[buffer.index])
+        {
+            LOG_FATAL("Command references invalid rhi buffer {}", buffer.index);
+        }
+    };
+
+    switch (header.type)
+    {
+        case RhiCommandType::BIND_PIPELINE:
+            if (!RhiCommandList::as<RhiCmdBindPipeline>(header).pipeline.isValid())
+            {
+                LOG_FATAL("Command binds an invalid rhi pipeline");
+            }
+            break;
+        case RhiCommandType::BIND_DESCRIPTOR_SET:
+            if (!RhiCommandList::as<RhiCmdBindDescriptorSet>(header).descriptorSet.isValid())
+            {
+                LOG_FATAL("Command binds an invalid rhi descriptor set");
+            }
+            break;
+        case RhiCommandType::BIND_VERTEX_BUFFER:
+            checkBuffer(RhiCommandList::as<RhiCmdBindVertexBuffer>(header).buffer);
+            break;
+        case RhiCommandType::BIND_INDEX_BUFFER:
+            checkBuffer(RhiCommandList::as<RhiCmdBindIndexBuffer>(header).buffer);
+            break;
+        case RhiCommandType::DRAW_INDIRECT: {
+            const auto& command = RhiCommandList::as<RhiCmdDrawIndirect>(header);
+            checkBuffer(command.buffer);
+            if (command.drawCount > 1 && command.stride < sizeof(uint32_t) * 2)
+            {
+                LOG_FATAL("Indirect draws overlap, stride {} is too small", command.stride);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "render/rhi/rhi_backend.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Backend without a device. Buffers live in cpu memory, pipelines and descriptor sets are bare handles, and execute
+// only walks the packets and counts them. Lets the frontend run and be measured on machines without a gpu, isolated
+// from any driver cost.
+class NullRhiBackend : public RhiBackend {
+public:
+    [[nodiscard]] const char* getName() const override { return "null"; }
+
+    RhiBufferHandle createBuffer(const RhiBufferDesc& desc, const void* initialData) override;
+    void            destroyBuffer(RhiBufferHandle buffer) override;
+
+    RhiPipelineHandle      createPipeline();
+    RhiDescriptorSetHandle createDescriptorSet();
+
+    void execute(const RhiCommandList& commandList) override;
+
+    [[nodiscard]] const std::vector<std::byte>& getBufferData(RhiBufferHandle buffer) const;
+
+    [[nodiscard]] uint64_t getCommandCount(RhiCommandType type) const;
+    [[nodiscard]] uint64_t getPrimitiveCount() const { return primitiveCount_; }
+    [[nodiscard]] uint64_t getExecutedBytes() const { return executedBytes_; }
+
+    // live resources
+    [[nodiscard]] uint32_t getBufferCount() const;
+    [[nodiscard]] uint32_t getPipelineCount() const { return pipelineCount_; }
+    [[nodiscard]] uint32_t getDescriptorSetCount() const { return descriptorSetCount_; }
+    void                   resetCounters();
+
+private:
+    void validate(const RhiCommandHeader& header) const;
+
+    // slot 0 stays empty so a zero handle is never valid
+    std::vector<std::vector<std::byte>> buffers_ {1};
+    std::vector<bool>                   bufferAlive_ {false};
+    std::vector<uint32_t>               freeBufferSlots_;
+    uint32_t                            pipelineCount_ {0};
+    uint32_t                            descriptorSetCount_ {0};
+
+    std::array<uint64_t, static_cast<size_t>(RhiCommandType::COUNT)> commandCounts_ {};
+    uint64_t                                                          primitiveCount_ {0};
+    uint64_t                                                          executedBytes_ {0};
+};
@@ -0,0 +1,235 @@
+#include "render/backend/null/null_rhi_benchmark.h"
+#include "render/backend/null/null_rhi_backend.h"
+#include "render/rhi/rhi_trace.h"
+
+#include "foundation/job/job_system.h"
+#include "foundation/log/log_system.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <optional>
+#include <vector>
+
+namespace
+{
+// logs every mismatch instead of stopping at the first, a broken run shows all the counts that are off
+class CountCheck {
+public:
+    void expect(const char* name, uint64_t expected, uint64_t actual)
+    {
+        if (expected == actual)
+            return;
+
+        LOG_ERROR("null rhi: {} is {}, expected {}", name, actual, expected);
+        passed_ = false;
+    }
+
+    [[nodiscard]] bool hasPassed() const { return passed_; }
+
+private:
+    bool passed_ {true};
+};
+} // namespace
+
+int NullRhiBenchmark::run(const NullRhiBenchmarkSettings& settings)
+{
+    NullRhiBackend backend;
+
+    const uint32_t pipelineCount = 16;
+    const uint32_t meshCount     = 256;
+    const uint32_t indexCount    = 256;
+
+    std::vector<RhiPipelineHandle> pipelines(pipelineCount);
+    for (auto& pipeline : pipelines)
+    {
+        pipeline = backend.createPipeline();
+    }
+
+    std::vector<RhiDescriptorSetHandle> descriptorSets(meshCount);
+    std::vector<RhiBufferHandle>        vertexBuffers(meshCount);
+    std::vector<RhiBufferHandle>        indexBuffers(meshCount);
+    for (uint32_t mesh = 0; mesh < meshCount; mesh++)
+    {
+        descriptorSets[mesh] = backend.createDescriptorSet();
+        vertexBuffers[mesh]  = backend.createBuffer({4096, RHI_BUFFER_USAGE_VERTEX}, nullptr);
+        indexBuffers[mesh]   = backend.createBuffer({1024, RHI_BUFFER_USAGE_INDEX}, nullptr);
+    }
+
+    std::vector<RhiCommandList> commandLists(settings.threadCount);
+
+    const auto recordRange = [&](uint32_t thread) {
+        RhiCommandList& commandList = commandLists[thread];
+        commandList.reset();
+
+        const uint32_t firstDraw = thread * settings.drawsPerThread;
+        for (uint32_t draw = firstDraw; draw < firstDraw + settings.drawsPerThread; draw++)
+        {
+            const uint32_t          mesh     = draw % meshCount;
+            const RhiPipelineHandle pipeline = pipelines[(draw / settings.drawsPerPipeline) % pipelineCount];
+
+            if (draw == firstDraw || draw % settings.drawsPerPipeline == 0)
+            {
+                commandList.bindPipeline(pipeline);
+                commandList.setViewport({0.0F, 0.0F, 1920.0F, 1080.0F, 0.0F, 1.0F});
+                commandList.setScissor({0, 0, 1920, 1080});
+            }
+
+            commandList.bindDescriptorSet(pipeline, 0, descriptorSets[mesh]);
+            commandList.bindVertexBuffer(0, vertexBuffers[mesh]);
+            commandList.bindIndexBuffer(indexBuffers[mesh], RhiIndexType::UINT32);
+            commandList.drawIndexed(indexCount, 1, 0, 0, 0);
+        }
+    };
+
+    const auto recordRanges = [&](uint32_t begin, uint32_t end) {
+        for (uint32_t thread = begin; thread < end; thread++)
+        {
+            recordRange(thread);
+        }
+    };
+
+    // the workers are started once, a frame only times the recording. A single thread records inline
+    std::optional<JobSystem> jobSystem;
+    if (settings.threadCount > 1)
+    {
+        jobSystem.emplace(settings.threadCount - 1);
+    }
+
+    double recordMs  = 0.0;
+    double executeMs = 0.0;
+
+    for (uint32_t frame = 0; frame < settings.frameCount; frame++)
+    {
+        const auto recordStart = std::chrono::high_resolution_clock::now();
+
+        if (jobSystem)
+        {
+            jobSystem->parallelFor(settings.threadCount, 1, recordRanges);
+        }
+        else
+        {
+            recordRanges(0, settings.threadCount);
+        }
+
+        const auto executeStart = std::chrono::high_resolution_clock::now();
+
+        for (const auto& commandList : commandLists)
+        {
+            backend.execute(commandList);
+        }
+
+        const auto executeEnd = std::chrono::high_resolution_clock::now();
+
+        // the first frame grows the lists to their steady state size
+        if (frame > 0)
+        {
+            recordMs += std::chrono::duration<double, std::milli>(executeStart - recordStart).count();
+            executeMs += std::chrono::duration<double, std::milli>(executeEnd - executeStart).count();
+        }
+    }
+
+    const uint32_t measuredFrames   = settings.frameCount > 1 ? settings.frameCount - 1 : 1;
+    const uint64_t drawCount        = backend.getStatistics().drawCount;
+    const uint64_t commandCount     = backend.getStatistics().commandCount;
+    const double   commandsPerFrame = static_cast<double>(commandCount) / settings.frameCount;
+    const double   executeFrameMs   = executeMs / measuredFrames;
+
+    LOG_INFO("null rhi: {} threads, {} draws per frame, {} frames",
+             settings.threadCount,
+             settings.threadCount * settings.drawsPerThread,
+             settings.frameCount);
+    LOG_INFO("null rhi: record {:.3f} ms/frame, execute {:.3f} ms/frame, {:.1f} M commands/s executed",
+             recordMs / measuredFrames,
+             executeFrameMs,
+             executeFrameMs > 0.0 ? commandsPerFrame / (executeFrameMs * 1000.0) : 0.0);
+    LOG_INFO("null rhi: {} draws, {} commands, {} primitives, {} bytes of packets",
+             drawCount,
+             commandCount,
+             backend.getPrimitiveCount(),
+             backend.getExecutedBytes());
+
+    // the scene is fully determined by the settings, so is everything the backend has to have seen. A frontend or
+    // backend change that drops or duplicates commands fails the run on ci instead of only shifting the numbers
+    uint64_t pipelineBindsPerFrame = 0;
+    for (uint32_t thread = 0; thread < settings.threadCount && settings.drawsPerThread > 0; thread++)
+    {
+        // every multiple of drawsPerPipeline in the range of the thread, plus its first draw when that is none
+        const uint32_t firstDraw = thread * settings.drawsPerThread;
+        const uint32_t endDraw   = firstDraw + settings.drawsPerThread;
+        pipelineBindsPerFrame += (endDraw + settings.drawsPerPipeline - 1) / settings.drawsPerPipeline -
+                                 (firstDraw + settings.drawsPerPipeline - 1) / settings.drawsPerPipeline;
+        pipelineBindsPerFrame += firstDraw % settings.drawsPerPipeline != 0 ? 1 : 0;
+    }
+    const uint64_t drawsPerFrame = static_cast<uint64_t>(settings.threadCount) * settings.drawsPerThread;
+
+    // a draw is a descriptor set, a vertex buffer, an index buffer and the draw, a pipeline bind also sets the
+    // viewport and the scissor
+    CountCheck check;
+    check.expect("draw count", settings.frameCount * drawsPerFrame, drawCount);
+    check.expect(
+        "command count", settings.frameCount * (4 * drawsPerFrame + 3 * pipelineBindsPerFrame), commandCount);
+    check.expect("pipeline binds",
+                 settings.frameCount * pipelineBindsPerFrame,
+                 backend.getCommandCount(RhiCommandType::BIND_PIPELINE));
+    check.expect("indexed draws",
+                 settings.frameCount * drawsPerFrame,
+                 backend.getCommandCount(RhiCommandType::DRAW_INDEXED));
+    check.expect("primitive count", settings.frameCount * drawsPerFrame * (indexCount / 3), backend.getPrimitiveCount());
+    check.expect("buffer count", 2 * meshCount, backend.getBufferCount());
+    check.expect("pipeline count", pipelineCount, backend.getPipelineCount());
+    check.expect("descriptor set count", meshCount, backend.getDescriptorSetCount());
+
+    return check.hasPassed() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int NullRhiBenchmark::replayTrace(const std::string& path, uint32_t iterations)
+{
+    RhiTraceReplayer replayer;
+    if (!replayer.load(path))
+        return EXIT_FAILURE;
+
+    NullRhiBackend backend;
+
+    RhiTraceResourceFactory factory {};
+    factory.createPipeline      = [&backend] { return backend.createPipeline(); };
+    factory.createDescriptorSet = [&backend] { return backend.createDescriptorSet(); };
+    if (!replayer.bind(backend, factory))
+        return EXIT_FAILURE;
+
+    if (replayer.getFrameCount() == 0)
+    {
+        LOG_ERROR("rhi trace {} contains no frames", path);
+        return EXIT_FAILURE;
+    }
+
+    const RhiTraceReplayStatistics statistics = replayer.replay(backend, iterations);
+
+    LOG_INFO("rhi trace {} into the null backend, no driver cost included", path);
+    LOG_INFO("rhi trace {}: {} frames x {} iterations, {} commands in {:.3f} ms, {:.3f} ms/frame",
+             path,
+             replayer.getFrameCount(),
+             statistics.iterations,
+             statistics.commandCount,
+             statistics.totalMs,
+             replayer.getFrameCount() > 0 ? statistics.totalMs / (replayer.getFrameCount() * statistics.iterations) :
+                                            0.0);
+
+    // what the trace is made of, the timing above covers the replayer and the packet walk only
+    uint64_t typedCount = 0;
+    for (size_t type = 0; type < static_cast<size_t>(RhiCommandType::COUNT); type++)
+    {
+        const uint64_t count = backend.getCommandCount(static_cast<RhiCommandType>(type));
+        typedCount += count;
+        if (count == 0)
+            continue;
+
+        LOG_INFO("    {:<20} {:>10} commands", getRhiCommandTypeName(static_cast<RhiCommandType>(type)), count);
+    }
+
+    // every recorded command has to have reached the backend exactly once per iteration
+    CountCheck check;
+    check.expect("executed command count", statistics.commandCount, backend.getStatistics().commandCount);
+    check.expect("command count by type", statistics.commandCount, typedCount);
+
+    return check.hasPassed() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
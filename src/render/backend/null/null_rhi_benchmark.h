@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+struct NullRhiBenchmarkSettings
+{
+    uint32_t threadCount {4};
+    uint32_t drawsPerThread {25000};
+    uint32_t frameCount {100};
+    uint32_t drawsPerPipeline {64};
+};
+
+// Records a synthetic scene into one command list per thread and replays the lists through the null backend.
+// Measures frontend recording and translation throughput without a window or a gpu.
+class NullRhiBenchmark {
+public:
+    static int run(const NullRhiBenchmarkSettings& settings);
+
+    // replays a captured rhi trace into the null backend and checks that every packet arrived, needs neither a window
+    // nor a vulkan driver. No vulkan call is made, the timing covers the replayer and the packet walk only
+    static int replayTrace(const std::string& path, uint32_t iterations);
+};
@@ -2,14 +2,22 @@
 #include "render/backend/vulkan/vulkan_app.h"
 #include "render/backend/vulkan/vulkan_utils.h"
 
+#include "render/asset/asset_loader.h"
+
 #include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-#include <stb_image.h>
-#include <tiny_obj_loader.h>
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <limits>
 #include <optional>
+#include <random>
 #include <set>
 #include <vector>
 
@@ -30,10 +38,235 @@
 const std::string MODEL_PATH   = "E:/projects/learn_vulkan/data/models/viking_room.obj";
 const std::string TEXTURE_PATH = "E:/projects/learn_vulkan/data/textures/viking_room.png";
 
+// written by --bake-lightmap, the scene falls back to lambert shading without it
+const std::string LIGHTMAP_PATH = "E:/projects/learn_vulkan/data/textures/viking_room_lightmap.png";
+
+namespace
+{
+// written to the id buffer through firstInstance, zero is left for the background
+constexpr uint32_t SCENE_OBJECT_ID = 1;
+
+// the skinned instances follow the scene, one id each
+constexpr uint32_t SKINNED_OBJECT_ID_BASE = 2;
+
+// the skinned instances wave out of step, each one starts this far into the clip after its predecessor
+constexpr float SKINNED_INSTANCE_PHASE = 0.37F;
+
+// the static props follow the skinned instances, one id per material since a merged draw covers many props
+constexpr uint32_t STATIC_PROP_OBJECT_ID_BASE = SKINNED_OBJECT_ID_BASE + gSkinnedInstanceCount;
+
+// the props of a cell are scattered the same way whenever it loads, the seed is mixed with the cell index
+constexpr uint32_t STATIC_PROP_SEED = 1234;
+
+// the far field copies follow the prop materials, one id each so picking tells them apart
+constexpr uint32_t FAR_FIELD_OBJECT_ID_BASE = STATIC_PROP_OBJECT_ID_BASE + gStaticPropMaterialCount;
+constexpr uint32_t FAR_FIELD_SEED           = 4321;
+constexpr float    FAR_FIELD_MIN_SCALE      = 0.5F;
+constexpr float    FAR_FIELD_MAX_SCALE      = 0.8F;
+
+// the procedural sky standing in for a missing environment map
+constexpr uint32_t SKY_WIDTH  = 512;
+constexpr uint32_t SKY_HEIGHT = 256;
+
+// the merged props are drawn by the scene pipeline as they are
+static_assert(sizeof(StaticBatchVertex) == sizeof(Vertex) &&
+                  offsetof(StaticBatchVertex, position) == offsetof(Vertex, pos) &&
+                  offsetof(StaticBatchVertex, texCoord) == offsetof(Vertex, texCoord),
+              "StaticBatchVertex must match the scene vertex layout");
+
+// object id and triangle index per texel
+constexpr uint32_t OBJECT_ID_TEXEL_SIZE = 8;
+
+// the particle fountain, its parameters are rewritten into the frame parameters of every image
+const glm::vec4 PARTICLE_EMITTER {0.0F, 0.0F, 0.4F, 0.05F}; // w is the spawn radius
+const glm::vec4 PARTICLE_GRAVITY {0.0F, 0.0F, -0.8F, 0.4F}; // w is the drag
+const glm::vec4 PARTICLE_START_COLOR {1.0F, 0.65F, 0.25F, 0.8F};
+const glm::vec4 PARTICLE_END_COLOR {0.35F, 0.35F, 0.4F, 0.0F};
+
+// longest simulation step, a hitch must not emit a burst of particles all in one place
+constexpr float PARTICLE_MAX_STEP = 0.1F;
+
+// longest camera step, the first key press after an idle wait must not jump across the world
+constexpr float CAMERA_MAX_STEP = 0.1F;
+
+// specialization constants of the scene fragment shaders
+struct MaterialSpecialization
+{
+    uint32_t shadingModel {0};
+    uint32_t textureCount {1};
+};
+
+constexpr std::array<VkSpecializationMapEntry, 2> MATERIAL_SPECIALIZATION_ENTRIES = {{
+    {0, offsetof(MaterialSpecialization, shadingModel), sizeof(uint32_t)},
+    {1, offsetof(MaterialSpecialization, textureCount), sizeof(uint32_t)},
+}};
+
+// vertex and fragment stage of the scene pipeline for every shading model, only the specialization differs
+struct MaterialShaderStages
+{
+    MaterialShaderStages(VkShaderModule vertexModule, VkShaderModule fragmentModule, uint32_t textureCount)
+    {
+        for (uint32_t model = 0; model < SHADING_MODEL_COUNT; model++)
+        {
+            specializations[model] = {model, textureCount};
+
+            specializationInfos[model].mapEntryCount = static_cast<uint32_t>(MATERIAL_SPECIALIZATION_ENTRIES.size());
+            specializationInfos[model].pMapEntries   = MATERIAL_SPECIALIZATION_ENTRIES.data();
+            specializationInfos[model].dataSize      = sizeof(MaterialSpecialization);
+            specializationInfos[model].pData         = &specializations[model];
+
+            stages[model][0].sType               = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            stages[model][0].stage               = VK_SHADER_STAGE_VERTEX_BIT;
+            stages[model][0].module              = vertexModule;
+            stages[model][0].pName               = "main";
+            stages[model][1].sType               = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            stages[model][1].stage               = VK_SHADER_STAGE_FRAGMENT_BIT;
+            stages[model][1].module              = fragmentModule;
+            stages[model][1].pName               = "main";
+            stages[model][1].pSpecializationInfo = &specializationInfos[model];
+        }
+    }
+
+    // the stages point into the specialization arrays
+    MaterialShaderStages(const MaterialShaderStages&)            = delete;
+    MaterialShaderStages& operator=(const MaterialShaderStages&) = delete;
+
+    std::array<MaterialSpecialization, SHADING_MODEL_COUNT>                         specializations {};
+    std::array<VkSpecializationInfo, SHADING_MODEL_COUNT>                           specializationInfos {};
+    std::array<std::array<VkPipelineShaderStageCreateInfo, 2>, SHADING_MODEL_COUNT> stages {};
+};
+
+// per draw material lookups read both halves of the material buffer
+constexpr VkPipelineStageFlags MATERIAL_READ_STAGES =
+    VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+// cleared every frame and kept for the readback copy recorded after the main pass
+VkAttachmentDescription getObjectIdAttachment()
+{
+    VkAttachmentDescription attachment {};
+    attachment.format         = gObjectIdFormat;
+    attachment.samples        = VK_SAMPLE_COUNT_1_BIT;
+    attachment.loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachment.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
+    attachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachment.initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachment.finalLayout    = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    return attachment;
+}
+
+// makes the id writes of the subpass visible to the readback copy
+VkSubpassDependency getObjectIdReadbackDependency(uint32_t subpass)
+{
+    VkSubpassDependency dependency {};
+    dependency.srcSubpass    = subpass;
+    dependency.dstSubpass    = VK_SUBPASS_EXTERNAL;
+    dependency.srcStageMask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependency.dstStageMask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    dependency.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    return dependency;
+}
+} // namespace
+
 void VulkanApp::frameBufferResizeCallback(GLFWwindow* windows, int width, int height)
 {
-    auto* app                = static_cast<VulkanApp*>(glfwGetWindowUserPointer(windows));
-    app->frameBufferResized_ = true;
+    auto* app           = static_cast<VulkanApp*>(glfwGetWindowUserPointer(windows));
+    app->windowResized_ = true;
+    app->requestRedraw(REDRAW_WINDOW);
+}
+
+void VulkanApp::keyCallback(GLFWwindow* windows, int key, int scancode, int action, int mods)
+{
+    auto* app = static_cast<VulkanApp*>(glfwGetWindowUserPointer(windows));
+
+    if (action != GLFW_PRESS)
+        return;
+
+    if (key == GLFW_KEY_F1)
+    {
+        app->showPerfHud_ = !app->showPerfHud_;
+        app->requestRedraw(REDRAW_SCENE);
+    }
+    else if (key == GLFW_KEY_F2)
+    {
+        app->deferredShadingRequested_ = !app->deferredShadingRequested_;
+        app->requestRedraw(REDRAW_SCENE);
+    }
+    else if (key == GLFW_KEY_F3)
+    {
+        app->renderOnDemand_ = !app->renderOnDemand_;
+        LOG_INFO("Rendering: {}", app->renderOnDemand_ ? "on demand" : "continuous");
+    }
+    else if (key == GLFW_KEY_F9 && app->traceFramesPending_ == 0)
+    {
+        app->traceFramesPending_ = gTraceCaptureFrameCount;
+        app->requestRedraw(REDRAW_SCENE);
+    }
+    else if ((key == GLFW_KEY_F11 || key == GLFW_KEY_F12) && app->captureFramesPending_ == 0)
+    {
+        // F12 saves the next frame, F11 a sequence of consecutive frames
+        app->captureFramesPending_ = key == GLFW_KEY_F12 ? 1 : gCaptureSequenceFrameCount;
+        app->requestRedraw(REDRAW_SCENE);
+    }
+    else if (key == GLFW_KEY_SPACE)
+    {
+        // restart the clock so the time spent paused does not end up in the first animated frame
+        app->animating_         = !app->animating_;
+        app->lastAnimationTime_ = std::chrono::high_resolution_clock::now();
+        app->requestRedraw(REDRAW_SCENE);
+    }
+}
+
+void VulkanApp::windowRefreshCallback(GLFWwindow* windows)
+{
+    // the window system lost the contents, e.g. after being uncovered, the idle image has to be presented again
+    auto* app = static_cast<VulkanApp*>(glfwGetWindowUserPointer(windows));
+    app->requestRedraw(REDRAW_WINDOW);
+}
+
+void VulkanApp::mouseButtonCallback(GLFWwindow* windows, int button, int action, int mods)
+{
+    auto* app = static_cast<VulkanApp*>(glfwGetWindowUserPointer(windows));
+
+    if (button == GLFW_MOUSE_BUTTON_LEFT)
+    {
+        app->cameraDragging_ = action == GLFW_PRESS;
+        glfwGetCursorPos(windows, &app->lastCursorPos_.x, &app->lastCursorPos_.y);
+    }
+    else if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS)
+    {
+        app->pickAtCursor();
+    }
+}
+
+void VulkanApp::cursorPosCallback(GLFWwindow* windows, double x, double y)
+{
+    auto* app = static_cast<VulkanApp*>(glfwGetWindowUserPointer(windows));
+
+    const glm::dvec2 cursorPos {x, y};
+    const glm::dvec2 delta = cursorPos - app->lastCursorPos_;
+    app->lastCursorPos_    = cursorPos;
+
+    if (!app->cameraDragging_ || (delta.x == 0.0 && delta.y == 0.0))
+        return;
+
+    // z is up, keep the pitch away from the poles so lookAt never degenerates
+    OrbitCamera& camera = app->camera_;
+    camera.yaw -= static_cast<float>(delta.x) * 0.01F;
+    camera.pitch = glm::clamp(camera.pitch + static_cast<float>(delta.y) * 0.01F, -1.5F, 1.5F);
+    app->requestRedraw(REDRAW_CAMERA);
+}
+
+void VulkanApp::scrollCallback(GLFWwindow* windows, double xOffset, double yOffset)
+{
+    auto* app = static_cast<VulkanApp*>(glfwGetWindowUserPointer(windows));
+    if (yOffset == 0.0)
+        return;
+
+    OrbitCamera& camera = app->camera_;
+    camera.distance     = glm::clamp(camera.distance * (1.0F - static_cast<float>(yOffset) * 0.1F), 0.5F, 9.0F);
+    app->requestRedraw(REDRAW_CAMERA);
 }
 
 void VulkanApp::run()
@@ -53,35 +286,86 @@ void VulkanApp::initWindow()
     window_ = glfwCreateWindow(WIDTH, HEIGHT, "Vulkan", nullptr, nullptr);
     glfwSetWindowUserPointer(window_, this);
     glfwSetFramebufferSizeCallback(window_, frameBufferResizeCallback);
+    glfwSetKeyCallback(window_, keyCallback);
+    glfwSetWindowRefreshCallback(window_, windowRefreshCallback);
+    glfwSetMouseButtonCallback(window_, mouseButtonCallback);
+    glfwSetCursorPosCallback(window_, cursorPosCallback);
+    glfwSetScrollCallback(window_, scrollCallback);
 }
 
 void VulkanApp::initVulkan()
 {
-    loadModel();
+    // glfw may only be queried on the main thread, from here on the size arrives through frame packets
+    int width  = 0;
+    int height = 0;
+    glfwGetFramebufferSize(window_, &width, &height);
+    framebufferExtent_ = {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
 
     createInstance();
     setupDebugMessenger();
     createSurface();
     pickPhysicalDevice();
     createLogicalDevice();
+    submitManager_.create(device_, gUseSubmitThread);
+    rhiBackend_.create(physicalDevice_, device_);
     createSwapChain();
     createImageViews();
-    createRenderPass();
+    if (usesRenderPass())
+    {
+        createRenderPass();
+    }
     createDescriptorSetLayout();
+    createPipelineCache();
     createGraphicsPipeline();
+    skinningPass_.create(physicalDevice_,
+                         device_,
+                         pipelineCache_,
+                         VulkanUtils::readFile("E:/projects/learn_vulkan/data/shaders/skinning_comp.spv"),
+                         sizeof(Vertex));
+    particleSystem_.create(physicalDevice_,
+                           device_,
+                           pipelineCache_,
+                           {VulkanUtils::readFile("E:/projects/learn_vulkan/data/shaders/particle_control_comp.spv"),
+                            VulkanUtils::readFile("E:/projects/learn_vulkan/data/shaders/particle_emit_comp.spv"),
+                            VulkanUtils::readFile("E:/projects/learn_vulkan/data/shaders/particle_simulate_comp.spv"),
+                            VulkanUtils::readFile("E:/projects/learn_vulkan/data/shaders/particle_sort_comp.spv")},
+                           independentBlendSupported_);
+    impostorRenderer_.create(physicalDevice_, device_, pipelineCache_);
+    hudRenderer_.create(physicalDevice_, device_, pipelineCache_, independentBlendSupported_);
     createDepthResources();
-    createFrameBuffers();
+    createObjectIdResources();
+    createEnvironmentBuffer();
+    createGBufferResources();
+    if (usesRenderPass())
+    {
+        createFrameBuffers();
+    }
     createCommandPool();
-    createTextureImage();
+
+    // the render thread does not run yet, this thread submits the uploads while it waits
+    syncWait(loadSceneAssets(), [this]() { uploadQueue_.pump(); });
+
+    // the impostor pipeline is specialized on the atlas, which is only baked while the assets load
+    createForwardPipelines();
     createTextureImageView();
     createTextureSampler();
-    createVertexBuffer();
-    createIndexBuffer();
+    createMaterialResources();
     createUniformBuffers();
+    skinningPass_.createFrameResources(static_cast<uint32_t>(swapChainImages_.size()));
+    particleSystem_.createFrameResources(static_cast<uint32_t>(swapChainImages_.size()));
+    impostorRenderer_.createFrameResources(uniformBuffers_);
+    hudRenderer_.createFrameResources(static_cast<uint32_t>(swapChainImages_.size()), gPerfHudMaxVertices);
     createDescriptorPool();
     createDescriptorSets();
+    createTimestampQueryPool();
     createCommandBuffers();
     createSyncObjects();
+    importRhiResources();
+
+    if (gBenchmarkDispatchOverhead)
+    {
+        benchmarkDispatchOverhead();
+    }
 
     VulkanUtils::dumpExtensionInfo();
     VulkanUtils::dumpQueueFamilyInfo(physicalDevice_);
@@ -89,13 +373,82 @@ void VulkanApp::initVulkan()
 
 void VulkanApp::mainLoop()
 {
-    while (glfwWindowShouldClose(window_) == 0)
+    // the main thread keeps the window responsive and runs the simulation, the render thread owns the device queue
+    // and everything recorded into it. Simulating frame N + 1 overlaps with recording and submitting frame N
+    renderThread_      = std::thread(&VulkanApp::renderLoop, this);
+    lastAnimationTime_ = std::chrono::high_resolution_clock::now();
+    lastCameraTime_    = lastAnimationTime_;
+
+    while (glfwWindowShouldClose(window_) == 0 && !renderThreadFailed_)
     {
-        glfwPollEvents();
-        drawFrame();
+        if (swapChainRecreated_.exchange(false))
+        {
+            requestRedraw(REDRAW_WINDOW);
+        }
+
+        // input wakes the wait up immediately, so idling adds no latency to the frame that reacts to it
+        if (renderOnDemand_ && !needsRedraw())
+        {
+            glfwWaitEventsTimeout(gIdleWaitTimeoutSeconds);
+        }
+        else
+        {
+            glfwPollEvents();
+        }
+
+        advanceAnimation();
+        advanceCamera();
+
+        // handle minimization, there is nothing to present into until the window gets a size again
+        int width  = 0;
+        int height = 0;
+        glfwGetFramebufferSize(window_, &width, &height);
+        if (width == 0 || height == 0)
+        {
+            glfwWaitEvents();
+            continue;
+        }
+
+        if (!renderOnDemand_ || needsRedraw())
+        {
+            submitFramePacket();
+        }
+        else
+        {
+            idleSinceLastPacket_ = true;
+        }
     }
 
+    framePackets_.close();
+    renderThread_.join();
+
+    submitManager_.drain();
     vkDeviceWaitIdle(device_);
+
+    if (renderThreadError_)
+    {
+        std::rethrow_exception(renderThreadError_);
+    }
+}
+
+void VulkanApp::renderLoop()
+{
+    try
+    {
+        while (const FramePacket* packet = framePackets_.acquireRead())
+        {
+            drawFrame(*packet);
+            framePackets_.releaseRead();
+        }
+    }
+    catch (...)
+    {
+        // hand the error over to the main thread, which rethrows it once it left the event loop
+        renderThreadError_ = std::current_exception();
+        framePackets_.close();
+        renderThreadFailed_ = true;
+        glfwPostEmptyEvent();
+    }
 }
 
 void VulkanApp::cleanupSwapChain()
@@ -104,16 +457,28 @@ void VulkanApp::cleanupSwapChain()
     {
         vkDestroyFramebuffer(device_, framebuffer, nullptr);
     }
+    swapChainFrameBuffers_.clear();
     vkFreeCommandBuffers(device_, commandPool_, static_cast<uint32_t>(commandBuffers_.size()), commandBuffers_.data());
 
-    vkDestroyPipeline(device_, graphicsPipeline_, nullptr);
-    vkDestroyPipelineLayout(device_, pipelineLayout_, nullptr);
-    vkDestroyRenderPass(device_, renderPass_, nullptr);
-
     vkDestroyImageView(device_, depthImageView_, nullptr);
     vkDestroyImage(device_, depthImage_, nullptr);
     vkFreeMemory(device_, depthImageMemory_, nullptr);
 
+    vkDestroyImageView(device_, objectIdImageView_, nullptr);
+    vkDestroyImage(device_, objectIdImage_, nullptr);
+    vkFreeMemory(device_, objectIdImageMemory_, nullptr);
+    objectIdImageView_   = VK_NULL_HANDLE;
+    objectIdImage_       = VK_NULL_HANDLE;
+    objectIdImageMemory_ = VK_NULL_HANDLE;
+
+    destroyTransientAttachment(gBufferAlbedo_);
+    destroyTransientAttachment(gBufferNormal_);
+    vkDestroyDescriptorPool(device_, gBufferDescriptorPool_, nullptr);
+    gBufferDescriptorPool_ = VK_NULL_HANDLE;
+
+    vkDestroyQueryPool(device_, timestampQueryPool_, nullptr);
+    timestampQueryPool_ = VK_NULL_HANDLE;
+
     for (auto* imageView : swapChainImageViews_)
     {
         vkDestroyImageView(device_, imageView, nullptr);
@@ -124,15 +489,42 @@ void VulkanApp::cleanupSwapChain()
         vkDestroyBuffer(device_, uniformBuffers_[index], nullptr);
         vkFreeMemory(device_, uniformBuffersMemory_[index], nullptr);
     }
+    skinningPass_.destroyFrameResources();
+    particleSystem_.destroyFrameResources();
+    impostorRenderer_.destroyFrameResources();
+    hudRenderer_.destroyFrameResources();
 
     vkDestroyDescriptorPool(device_, descriptorPool_, nullptr);
 
     vkDestroySwapchainKHR(device_, swapChain_, nullptr);
 }
 
+void VulkanApp::cleanupPipeline()
+{
+    for (VkPipeline& pipeline : graphicsPipelines_)
+    {
+        vkDestroyPipeline(device_, pipeline, nullptr);
+        pipeline = VK_NULL_HANDLE;
+    }
+    vkDestroyPipelineLayout(device_, pipelineLayout_, nullptr);
+    vkDestroyPipeline(device_, lightingPipeline_, nullptr);
+    vkDestroyPipelineLayout(device_, lightingPipelineLayout_, nullptr);
+    vkDestroyRenderPass(device_, renderPass_, nullptr);
+    particleSystem_.destroyDrawPipeline();
+    impostorRenderer_.destroyDrawPipeline();
+    hudRenderer_.destroyDrawPipeline();
+
+    pipelineLayout_         = VK_NULL_HANDLE;
+    lightingPipeline_       = VK_NULL_HANDLE;
+    lightingPipelineLayout_ = VK_NULL_HANDLE;
+    renderPass_             = VK_NULL_HANDLE;
+}
+
 void VulkanApp::cleanup()
 {
+    drainWorldStreaming();
     cleanupSwapChain();
+    cleanupPipeline();
 
     for (size_t index = 0; index < MAX_FRAMES_IN_FLIGHT; index++)
     {
@@ -147,16 +539,58 @@ void VulkanApp::cleanup()
     vkDestroyImage(device_, textureImage_, nullptr);
     vkFreeMemory(device_, textureImageMemory_, nullptr);
 
+    vkDestroyImageView(device_, lightmapImageView_, nullptr);
+    vkDestroyImage(device_, lightmapImage_, nullptr);
+    vkFreeMemory(device_, lightmapImageMemory_, nullptr);
+
+    vkDestroyBuffer(device_, environmentBuffer_, nullptr);
+    vkFreeMemory(device_, environmentBufferMemory_, nullptr);
+
+    vkDestroyBuffer(device_, materialBuffer_, nullptr);
+    vkFreeMemory(device_, materialBufferMemory_, nullptr);
+
     vkDestroyBuffer(device_, indexBuffer_, nullptr);
     vkFreeMemory(device_, indexBufferMemory_, nullptr);
 
     vkDestroyBuffer(device_, vertexBuffer_, nullptr);
     vkFreeMemory(device_, vertexBufferMemory_, nullptr);
 
+    for (auto& [index, cell] : worldCells_)
+    {
+        destroyWorldCell(*cell);
+    }
+    for (auto& cell : retiredWorldCells_)
+    {
+        destroyWorldCell(*cell);
+    }
+    worldCells_.clear();
+    retiredWorldCells_.clear();
+
+    vkDestroyBuffer(device_, farFieldIndexBuffer_, nullptr);
+    vkFreeMemory(device_, farFieldIndexBufferMemory_, nullptr);
+
+    vkDestroyBuffer(device_, farFieldVertexBuffer_, nullptr);
+    vkFreeMemory(device_, farFieldVertexBufferMemory_, nullptr);
+    impostorRenderer_.destroy();
+
+    vkDestroyBuffer(device_, skinnedIndexBuffer_, nullptr);
+    vkFreeMemory(device_, skinnedIndexBufferMemory_, nullptr);
+    skinningPass_.destroy();
+    particleSystem_.destroy();
+    hudRenderer_.destroy();
+
     vkDestroyDescriptorSetLayout(device_, descriptorSetLayout_, nullptr);
+    vkDestroyDescriptorSetLayout(device_, gBufferDescriptorSetLayout_, nullptr);
+    vkDestroyPipelineCache(device_, pipelineCache_, nullptr);
 
+    commandCache_.destroy();
+    readbackManager_.destroy();
+    uploadQueue_.destroy();
     vkDestroyCommandPool(device_, commandPool_, nullptr);
 
+    rhiBackend_.destroy();
+    submitManager_.destroy();
+
     vkDestroyDevice(device_, nullptr);
 
     vkDestroySurfaceKHR(instance_, surface_, nullptr);
@@ -167,6 +601,7 @@ void VulkanApp::cleanup()
     }
 
     vkDestroyInstance(instance_, nullptr);
+    VulkanLoader::shutdown();
 
     glfwDestroyWindow(window_);
     glfwTerminate();
@@ -174,18 +609,22 @@ void VulkanApp::cleanup()
 
 void VulkanApp::createInstance()
 {
+    VulkanLoader::initialize();
+
     if (gEnableValidationLayers && !VulkanUtils::checkValidationLayerSupport(gValidationLayers))
     {
         LOG_FATAL("validataion layers requested, but not available!");
     }
 
+    instanceApiVersion_ = VulkanUtils::chooseInstanceApiVersion(gTargetApiVersion);
+
     VkApplicationInfo appInfo {};
     appInfo.sType              = VK_STRUCTURE_TYPE_APPLICATION_INFO;
     appInfo.pApplicationName   = "VulkanApp";
     appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.pEngineName        = "No Engine";
     appInfo.engineVersion      = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.apiVersion         = VK_API_VERSION_1_0;
+    appInfo.apiVersion         = instanceApiVersion_;
 
     auto extensions = VulkanUtils::getRequiredExtensions();
 
@@ -214,6 +653,8 @@ void VulkanApp::createInstance()
     {
         LOG_FATAL("failed to create instance!");
     }
+
+    VulkanLoader::loadInstance(instance_);
 }
 
 void VulkanApp::setupDebugMessenger()
@@ -264,6 +705,38 @@ void VulkanApp::pickPhysicalDevice()
     }
 
     VulkanUtils::dumpPhysicalDeviceProperties(physicalDevice_);
+
+    useDynamicRendering_ =
+        gPreferDynamicRendering && VulkanUtils::checkDynamicRenderingSupported(physicalDevice_, instanceApiVersion_);
+    LOG_INFO("Render Path: {}", useDynamicRendering_ ? "dynamic rendering" : "render pass");
+
+    VkPhysicalDeviceProperties properties {};
+    vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
+    timestampPeriod_ = properties.limits.timestampPeriod;
+
+    // materials pick their texture per draw, without dynamic indexing the table only has the one slot
+    VkPhysicalDeviceFeatures features {};
+    vkGetPhysicalDeviceFeatures(physicalDevice_, &features);
+
+    materialTextureCapacity_ = 1;
+    if (features.shaderSampledImageArrayDynamicIndexing == VK_TRUE)
+    {
+        materialTextureCapacity_ = std::min({gMaxMaterialTextures,
+                                             properties.limits.maxPerStageDescriptorSamplers,
+                                             properties.limits.maxPerStageDescriptorSampledImages,
+                                             properties.limits.maxDescriptorSetSamplers,
+                                             properties.limits.maxDescriptorSetSampledImages});
+    }
+    LOG_INFO("Material texture slots: {}", materialTextureCapacity_);
+
+    // particles blend into the color attachment while the id attachment next to it keeps its value
+    independentBlendSupported_ = features.independentBlend == VK_TRUE;
+
+    // the hud shows the device local memory in use against the budget of the driver, which needs the extension
+    memoryBudgetSupported_ =
+        instanceApiVersion_ >= VK_API_VERSION_1_1 && properties.apiVersion >= VK_API_VERSION_1_1 &&
+        VulkanUtils::isDeviceExtensionSupported(physicalDevice_, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    LOG_INFO("Memory budget: {}", memoryBudgetSupported_ ? "supported" : "unsupported");
 }
 
 void VulkanApp::createLogicalDevice()
@@ -286,15 +759,36 @@ void VulkanApp::createLogicalDevice()
     }
 
     VkPhysicalDeviceFeatures deviceFeatures {};
-    deviceFeatures.samplerAnisotropy = VK_TRUE;
+    deviceFeatures.samplerAnisotropy                      = VK_TRUE;
+    deviceFeatures.shaderSampledImageArrayDynamicIndexing = materialTextureCapacity_ > 1 ? VK_TRUE : VK_FALSE;
+    deviceFeatures.independentBlend                       = independentBlendSupported_ ? VK_TRUE : VK_FALSE;
+
+    std::vector<const char*> deviceExtensions(gDeviceExtensions.begin(), gDeviceExtensions.end());
+    if (memoryBudgetSupported_)
+    {
+        deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
 
     VkDeviceCreateInfo deviceCreateInfo {};
-    deviceCreateInfo.sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-    deviceCreateInfo.pQueueCreateInfos       = queueCreateInfos.data();
-    deviceCreateInfo.queueCreateInfoCount    = static_cast<uint32_t>(queueCreateInfos.size());
-    deviceCreateInfo.pEnabledFeatures        = &deviceFeatures;
-    deviceCreateInfo.enabledExtensionCount   = static_cast<uint32_t>(gDeviceExtensions.size());
-    deviceCreateInfo.ppEnabledExtensionNames = gDeviceExtensions.data();
+    deviceCreateInfo.sType                = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceCreateInfo.pQueueCreateInfos    = queueCreateInfos.data();
+    deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
+    deviceCreateInfo.pEnabledFeatures     = &deviceFeatures;
+
+#if VULKAN_HAS_DYNAMIC_RENDERING
+    VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures {};
+    dynamicRenderingFeatures.sType            = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+    dynamicRenderingFeatures.dynamicRendering = VK_TRUE;
+
+    if (useDynamicRendering_)
+    {
+        deviceExtensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+        deviceCreateInfo.pNext = &dynamicRenderingFeatures;
+    }
+#endif
+
+    deviceCreateInfo.enabledExtensionCount   = static_cast<uint32_t>(deviceExtensions.size());
+    deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();
 
     if (gEnableValidationLayers)
     {
@@ -311,8 +805,20 @@ void VulkanApp::createLogicalDevice()
         LOG_FATAL("Failed to create Logical Device");
     }
 
+    VulkanLoader::loadDevice(device_);
+
     vkGetDeviceQueue(device_, indices.graphicsFamily.value(), 0, &graphicsQueue_);
     vkGetDeviceQueue(device_, indices.presentFamily.value(), 0, &presentQueue_);
+
+#if VULKAN_HAS_DYNAMIC_RENDERING
+    if (useDynamicRendering_)
+    {
+        if (vkCmdBeginRenderingKHR == nullptr || vkCmdEndRenderingKHR == nullptr)
+        {
+            LOG_FATAL("Failed to load dynamic rendering functions!");
+        }
+    }
+#endif
 }
 
 void VulkanApp::createSwapChain()
@@ -320,7 +826,8 @@ void VulkanApp::createSwapChain()
     const SwapChainSupportDetails swapChainSupport = VulkanUtils::querySwapChainSupport(physicalDevice_, surface_);
     const VkSurfaceFormatKHR      surfaceFormat    = VulkanUtils::chooseSwapSurfaceFormat(swapChainSupport.formats);
     const VkPresentModeKHR        presentMode      = VulkanUtils::chooseSwapPresentMode(swapChainSupport.presentModes);
-    const VkExtent2D              extent = VulkanUtils::chooseSwapExtent(swapChainSupport.capabilities, window_);
+    const VkExtent2D              extent =
+        VulkanUtils::chooseSwapExtent(swapChainSupport.capabilities, framebufferExtent_);
 
     uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
     if (swapChainSupport.capabilities.maxImageCount > 0 && imageCount > swapChainSupport.capabilities.maxImageCount)
@@ -338,6 +845,13 @@ void VulkanApp::createSwapChain()
     createInfo.imageArrayLayers = 1;
     createInfo.imageUsage       = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 
+    // frame captures copy straight out of the presented image
+    swapChainReadable_ = (swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
+    if (swapChainReadable_)
+    {
+        createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    }
+
     QueueFamilyIndices indices              = VulkanUtils::findQueueFamilies(physicalDevice_, surface_);
     uint32_t           queueFamilyIndices[] = {indices.graphicsFamily.value(), indices.presentFamily.value()};
     if (indices.graphicsFamily != indices.presentFamily)
@@ -385,6 +899,12 @@ void VulkanApp::createImageViews()
 
 void VulkanApp::createRenderPass()
 {
+    if (deferredShading_)
+    {
+        createDeferredRenderPass();
+        return;
+    }
+
     VkAttachmentDescription colorAttachment {};
     colorAttachment.format         = swapChainImageFormat_;
     colorAttachment.samples        = VK_SAMPLE_COUNT_1_BIT;
@@ -413,23 +933,36 @@ void VulkanApp::createRenderPass()
     depthAttachmentRef.attachment = 1;
     depthAttachmentRef.layout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
+    std::vector<VkAttachmentDescription> attachments = {colorAttachment, depthAttachment};
+    std::vector<VkAttachmentReference>   colorAttachmentRefs {colorAttachmentRef};
+    if (gEnableObjectIdBuffer)
+    {
+        attachments.push_back(getObjectIdAttachment());
+        colorAttachmentRefs.push_back({2, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+    }
+
     VkSubpassDescription subpass {};
     subpass.pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.colorAttachmentCount    = 1;
-    subpass.pColorAttachments       = &colorAttachmentRef;
+    subpass.colorAttachmentCount    = static_cast<uint32_t>(colorAttachmentRefs.size());
+    subpass.pColorAttachments       = colorAttachmentRefs.data();
     subpass.pDepthStencilAttachment = &depthAttachmentRef;
 
-    VkSubpassDependency dependency {};
-    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-    dependency.dstSubpass = 0;
-    dependency.srcStageMask =
+    // the id buffer of the previous frame may still be read by its readback copy
+    std::vector<VkSubpassDependency> dependencies(1);
+    dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[0].dstSubpass = 0;
+    dependencies[0].srcStageMask =
         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-    dependency.srcAccessMask = 0;
-    dependency.dstStageMask =
+    dependencies[0].srcAccessMask = 0;
+    dependencies[0].dstStageMask =
         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-
-    std::array<VkAttachmentDescription, 2> attachments = {colorAttachment, depthAttachment};
+    dependencies[0].dstAccessMask =
+        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    if (gEnableObjectIdBuffer)
+    {
+        dependencies[0].srcStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+        dependencies.push_back(getObjectIdReadbackDependency(0));
+    }
 
     VkRenderPassCreateInfo renderPassInfo {};
     renderPassInfo.sType           = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -437,8 +970,8 @@ void VulkanApp::createRenderPass()
     renderPassInfo.pAttachments    = attachments.data();
     renderPassInfo.subpassCount    = 1;
     renderPassInfo.pSubpasses      = &subpass;
-    renderPassInfo.dependencyCount = 1;
-    renderPassInfo.pDependencies   = &dependency;
+    renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+    renderPassInfo.pDependencies   = dependencies.data();
 
     if (vkCreateRenderPass(device_, &renderPassInfo, nullptr, &renderPass_) != VK_SUCCESS)
     {
@@ -446,6 +979,136 @@ void VulkanApp::createRenderPass()
     }
 }
 
+void VulkanApp::createDeferredRenderPass()
+{
+    VkAttachmentDescription colorAttachment {};
+    colorAttachment.format         = swapChainImageFormat_;
+    colorAttachment.samples        = VK_SAMPLE_COUNT_1_BIT;
+    colorAttachment.loadOp         = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    colorAttachment.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    colorAttachment.initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
+    colorAttachment.finalLayout    = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+    VkAttachmentDescription depthAttachment {};
+    depthAttachment.format         = findDepthFormat();
+    depthAttachment.samples        = VK_SAMPLE_COUNT_1_BIT;
+    depthAttachment.loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depthAttachment.storeOp        = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
+    depthAttachment.finalLayout    = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    // the G-buffer never leaves the render pass: cleared on load and discarded on store, so tile based GPUs keep
+    // it in tile memory and never write it out
+    VkAttachmentDescription albedoAttachment {};
+    albedoAttachment.format         = gGBufferAlbedoFormat;
+    albedoAttachment.samples        = VK_SAMPLE_COUNT_1_BIT;
+    albedoAttachment.loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    albedoAttachment.storeOp        = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    albedoAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    albedoAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    albedoAttachment.initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
+    albedoAttachment.finalLayout    = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkAttachmentDescription normalAttachment = albedoAttachment;
+    normalAttachment.format                  = gGBufferNormalFormat;
+
+    std::vector<VkAttachmentDescription> attachments = {
+        colorAttachment, depthAttachment, albedoAttachment, normalAttachment};
+
+    // subpass 0: fill the G-buffer, the id buffer is written alongside and outlives the render pass
+    std::vector<VkAttachmentReference> gBufferAttachmentRefs(2);
+    gBufferAttachmentRefs[0].attachment = 2;
+    gBufferAttachmentRefs[0].layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    gBufferAttachmentRefs[1].attachment = 3;
+    gBufferAttachmentRefs[1].layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    if (gEnableObjectIdBuffer)
+    {
+        attachments.push_back(getObjectIdAttachment());
+        gBufferAttachmentRefs.push_back({4, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+    }
+
+    VkAttachmentReference depthAttachmentRef {};
+    depthAttachmentRef.attachment = 1;
+    depthAttachmentRef.layout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    // subpass 1: resolve lighting into the swap chain image
+    VkAttachmentReference colorAttachmentRef {};
+    colorAttachmentRef.attachment = 0;
+    colorAttachmentRef.layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    std::array<VkAttachmentReference, 2> inputAttachmentRefs {};
+    inputAttachmentRefs[0].attachment = 2;
+    inputAttachmentRefs[0].layout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    inputAttachmentRefs[1].attachment = 3;
+    inputAttachmentRefs[1].layout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    std::array<VkSubpassDescription, 2> subpasses {};
+    subpasses[0].pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpasses[0].colorAttachmentCount    = static_cast<uint32_t>(gBufferAttachmentRefs.size());
+    subpasses[0].pColorAttachments       = gBufferAttachmentRefs.data();
+    subpasses[0].pDepthStencilAttachment = &depthAttachmentRef;
+
+    // the impostors are drawn over the lit image with depth, the particles blended over them only test it
+    subpasses[1].pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpasses[1].colorAttachmentCount    = 1;
+    subpasses[1].pColorAttachments       = &colorAttachmentRef;
+    subpasses[1].inputAttachmentCount    = static_cast<uint32_t>(inputAttachmentRefs.size());
+    subpasses[1].pInputAttachments       = inputAttachmentRefs.data();
+    subpasses[1].pDepthStencilAttachment = &depthAttachmentRef;
+
+    std::vector<VkSubpassDependency> dependencies(2);
+    dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[0].dstSubpass = 0;
+    dependencies[0].srcStageMask =
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dependencies[0].srcAccessMask = 0;
+    dependencies[0].dstStageMask =
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dependencies[0].dstAccessMask =
+        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+    // by region: each lighting fragment only reads the G-buffer texel under it, so the tile never has to be flushed
+    dependencies[1].srcSubpass      = 0;
+    dependencies[1].dstSubpass      = 1;
+    dependencies[1].srcStageMask    = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[1].srcAccessMask   = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[1].dstStageMask    = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    dependencies[1].dstAccessMask   = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+    dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+    // the impostors and particles test against the depth the G-buffer pass wrote, the impostors write it as well
+    dependencies[1].srcStageMask |= VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependencies[1].srcAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependencies[1].dstStageMask |=
+        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependencies[1].dstAccessMask |=
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+    if (gEnableObjectIdBuffer)
+    {
+        dependencies[0].srcStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+        dependencies.push_back(getObjectIdReadbackDependency(0));
+    }
+
+    VkRenderPassCreateInfo renderPassInfo {};
+    renderPassInfo.sType           = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    renderPassInfo.pAttachments    = attachments.data();
+    renderPassInfo.subpassCount    = static_cast<uint32_t>(subpasses.size());
+    renderPassInfo.pSubpasses      = subpasses.data();
+    renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+    renderPassInfo.pDependencies   = dependencies.data();
+
+    if (vkCreateRenderPass(device_, &renderPassInfo, nullptr, &renderPass_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create deferred render pass");
+    }
+}
+
 void VulkanApp::createDescriptorSetLayout()
 {
     VkDescriptorSetLayoutBinding uboLayoutBinding {};
@@ -455,14 +1118,41 @@ void VulkanApp::createDescriptorSetLayout()
     uboLayoutBinding.stageFlags         = VK_SHADER_STAGE_VERTEX_BIT;
     uboLayoutBinding.pImmutableSamplers = nullptr;
 
+    // the bindless texture table, materials reference textures by their slot
     VkDescriptorSetLayoutBinding samplerLayoutBinding {};
     samplerLayoutBinding.binding            = 1;
-    samplerLayoutBinding.descriptorCount    = 1;
+    samplerLayoutBinding.descriptorCount    = materialTextureCapacity_;
     samplerLayoutBinding.descriptorType     = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
     samplerLayoutBinding.pImmutableSamplers = nullptr;
     samplerLayoutBinding.stageFlags         = VK_SHADER_STAGE_FRAGMENT_BIT;
 
-    std::array<VkDescriptorSetLayoutBinding, 2> bindings = {uboLayoutBinding, samplerLayoutBinding};
+    VkDescriptorSetLayoutBinding materialLayoutBinding {};
+    materialLayoutBinding.binding            = 2;
+    materialLayoutBinding.descriptorCount    = 1;
+    materialLayoutBinding.descriptorType     = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    materialLayoutBinding.pImmutableSamplers = nullptr;
+    materialLayoutBinding.stageFlags         = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    // the vertex shader looks the material of its object up once, the fragments get the index as a flat input
+    VkDescriptorSetLayoutBinding materialTableLayoutBinding {};
+    materialTableLayoutBinding.binding            = 3;
+    materialTableLayoutBinding.descriptorCount    = 1;
+    materialTableLayoutBinding.descriptorType     = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    materialTableLayoutBinding.pImmutableSamplers = nullptr;
+    materialTableLayoutBinding.stageFlags         = VK_SHADER_STAGE_VERTEX_BIT;
+
+    VkDescriptorSetLayoutBinding environmentLayoutBinding {};
+    environmentLayoutBinding.binding            = 4;
+    environmentLayoutBinding.descriptorCount    = 1;
+    environmentLayoutBinding.descriptorType     = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    environmentLayoutBinding.pImmutableSamplers = nullptr;
+    environmentLayoutBinding.stageFlags         = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    std::array<VkDescriptorSetLayoutBinding, 5> bindings = {uboLayoutBinding,
+                                                            samplerLayoutBinding,
+                                                            materialLayoutBinding,
+                                                            materialTableLayoutBinding,
+                                                            environmentLayoutBinding};
 
     VkDescriptorSetLayoutCreateInfo layoutInfo {};
     layoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -473,29 +1163,59 @@ void VulkanApp::createDescriptorSetLayout()
     {
         LOG_FATAL("Failed to create descriptor set layout");
     }
+
+    // albedo and normal, then the environment the lighting subpass takes its ambient term from
+    std::array<VkDescriptorSetLayoutBinding, 3> gBufferBindings {};
+    for (uint32_t index = 0; index < gBufferBindings.size(); index++)
+    {
+        gBufferBindings[index].binding            = index;
+        gBufferBindings[index].descriptorType     = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+        gBufferBindings[index].descriptorCount    = 1;
+        gBufferBindings[index].stageFlags         = VK_SHADER_STAGE_FRAGMENT_BIT;
+        gBufferBindings[index].pImmutableSamplers = nullptr;
+    }
+    gBufferBindings[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+
+    VkDescriptorSetLayoutCreateInfo gBufferLayoutInfo {};
+    gBufferLayoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    gBufferLayoutInfo.bindingCount = static_cast<uint32_t>(gBufferBindings.size());
+    gBufferLayoutInfo.pBindings    = gBufferBindings.data();
+
+    if (vkCreateDescriptorSetLayout(device_, &gBufferLayoutInfo, nullptr, &gBufferDescriptorSetLayout_) !=
+        VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create G-buffer descriptor set layout");
+    }
+}
+
+void VulkanApp::createPipelineCache()
+{
+    // lives as long as the device, switching between forward and deferred shading rebuilds the pipelines of every
+    // shading model and the driver only has to compile each of them once
+    VkPipelineCacheCreateInfo cacheInfo {};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+    if (vkCreatePipelineCache(device_, &cacheInfo, nullptr, &pipelineCache_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create pipeline cache!");
+    }
 }
 
 void VulkanApp::createGraphicsPipeline()
 {
+    if (deferredShading_)
+    {
+        createDeferredPipelines();
+        return;
+    }
+
     auto vertShaderCode = VulkanUtils::readFile("E:/projects/learn_vulkan/data/shaders/vert.spv");
     auto fragShaderCode = VulkanUtils::readFile("E:/projects/learn_vulkan/data/shaders/frag.spv");
 
     VkShaderModule vertShaderModule = createShaderModule(vertShaderCode);
     VkShaderModule fragShaderModule = createShaderModule(fragShaderCode);
 
-    VkPipelineShaderStageCreateInfo vertShaderStageInfo {};
-    vertShaderStageInfo.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    vertShaderStageInfo.stage  = VK_SHADER_STAGE_VERTEX_BIT;
-    vertShaderStageInfo.module = vertShaderModule;
-    vertShaderStageInfo.pName  = "main";
-
-    VkPipelineShaderStageCreateInfo fragShaderStageInfo {};
-    fragShaderStageInfo.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    fragShaderStageInfo.stage  = VK_SHADER_STAGE_FRAGMENT_BIT;
-    fragShaderStageInfo.module = fragShaderModule;
-    fragShaderStageInfo.pName  = "main";
-
-    VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
+    const MaterialShaderStages shaderStages(vertShaderModule, fragShaderModule, materialTextureCapacity_);
 
     auto bindingDescription    = Vertex::getBindingDescription();
     auto attributeDescriptions = Vertex::getAttributeDescriptions();
@@ -512,24 +1232,13 @@ void VulkanApp::createGraphicsPipeline()
     inputAssembly.topology               = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
     inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-    VkViewport viewport {};
-    viewport.x        = 0.0F;
-    viewport.y        = 0.0F;
-    viewport.width    = static_cast<float>(swapChainExtent_.width);
-    viewport.height   = static_cast<float>(swapChainExtent_.height);
-    viewport.minDepth = 0.0F;
-    viewport.maxDepth = 1.0F;
-
-    VkRect2D scissor {};
-    scissor.offset = {0, 0};
-    scissor.extent = swapChainExtent_;
-
+    // viewport and scissor are set while recording, so the pipeline survives swap chain resizes
     VkPipelineViewportStateCreateInfo viewportState {};
     viewportState.sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
     viewportState.viewportCount = 1;
-    viewportState.pViewports    = &viewport;
+    viewportState.pViewports    = nullptr;
     viewportState.scissorCount  = 1;
-    viewportState.pScissors     = &scissor;
+    viewportState.pScissors     = nullptr;
 
     VkPipelineRasterizationStateCreateInfo rasterizer {};
     rasterizer.sType                   = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
@@ -576,18 +1285,22 @@ void VulkanApp::createGraphicsPipeline()
     colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
     colorBlendAttachment.alphaBlendOp        = VK_BLEND_OP_ADD;
 
+    // integer attachments cannot blend, the color attachment does not either so the state is shared
+    std::array<VkPipelineColorBlendAttachmentState, 2> colorBlendAttachments = {colorBlendAttachment,
+                                                                                colorBlendAttachment};
+
     VkPipelineColorBlendStateCreateInfo colorBlending {};
     colorBlending.sType             = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
     colorBlending.logicOpEnable     = VK_FALSE;
     colorBlending.logicOp           = VK_LOGIC_OP_COPY;
-    colorBlending.attachmentCount   = 1;
-    colorBlending.pAttachments      = &colorBlendAttachment;
+    colorBlending.attachmentCount   = gEnableObjectIdBuffer ? 2 : 1;
+    colorBlending.pAttachments      = colorBlendAttachments.data();
     colorBlending.blendConstants[0] = 0.0F;
     colorBlending.blendConstants[1] = 0.0F;
     colorBlending.blendConstants[2] = 0.0F;
     colorBlending.blendConstants[3] = 0.0F;
 
-    VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_LINE_WIDTH};
+    VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
 
     VkPipelineDynamicStateCreateInfo dynamicState {};
     dynamicState.sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
@@ -609,7 +1322,7 @@ void VulkanApp::createGraphicsPipeline()
     VkGraphicsPipelineCreateInfo pipelineInfo {};
     pipelineInfo.sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
     pipelineInfo.stageCount          = 2;
-    pipelineInfo.pStages             = shaderStages;
+    pipelineInfo.pStages             = shaderStages.stages[0].data();
     pipelineInfo.pVertexInputState   = &vertexInputInfo;
     pipelineInfo.pInputAssemblyState = &inputAssembly;
     pipelineInfo.pViewportState      = &viewportState;
@@ -617,14 +1330,45 @@ void VulkanApp::createGraphicsPipeline()
     pipelineInfo.pMultisampleState   = &multisampling;
     pipelineInfo.pDepthStencilState  = &depthStencil;
     pipelineInfo.pColorBlendState    = &colorBlending;
-    pipelineInfo.pDynamicState       = nullptr;
+    pipelineInfo.pDynamicState       = &dynamicState;
     pipelineInfo.layout              = pipelineLayout_;
     pipelineInfo.renderPass          = renderPass_;
     pipelineInfo.subpass             = 0;
     pipelineInfo.basePipelineHandle  = nullptr;
     pipelineInfo.basePipelineIndex   = -1;
 
-    if (vkCreateGraphicsPipelines(device_, nullptr, 1, &pipelineInfo, nullptr, &graphicsPipeline_) != VK_SUCCESS)
+#if VULKAN_HAS_DYNAMIC_RENDERING
+    const VkFormat                depthFormat  = findDepthFormat();
+    const std::array<VkFormat, 2> colorFormats = {swapChainImageFormat_, gObjectIdFormat};
+
+    VkPipelineRenderingCreateInfoKHR renderingInfo {};
+    renderingInfo.sType                   = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+    renderingInfo.colorAttachmentCount    = gEnableObjectIdBuffer ? 2 : 1;
+    renderingInfo.pColorAttachmentFormats = colorFormats.data();
+    renderingInfo.depthAttachmentFormat   = depthFormat;
+    renderingInfo.stencilAttachmentFormat =
+        VulkanUtils::hasStencilComponent(depthFormat) ? depthFormat : VK_FORMAT_UNDEFINED;
+
+    if (useDynamicRendering_)
+    {
+        pipelineInfo.pNext      = &renderingInfo;
+        pipelineInfo.renderPass = VK_NULL_HANDLE;
+    }
+#endif
+
+    std::array<VkGraphicsPipelineCreateInfo, SHADING_MODEL_COUNT> pipelineInfos {};
+    for (uint32_t model = 0; model < SHADING_MODEL_COUNT; model++)
+    {
+        pipelineInfos[model]         = pipelineInfo;
+        pipelineInfos[model].pStages = shaderStages.stages[model].data();
+    }
+
+    if (vkCreateGraphicsPipelines(device_,
+                                  pipelineCache_,
+                                  static_cast<uint32_t>(pipelineInfos.size()),
+                                  pipelineInfos.data(),
+                                  nullptr,
+                                  graphicsPipelines_.data()) != VK_SUCCESS)
     {
         LOG_FATAL("Failed to create graphics pipeline!");
     }
@@ -633,13 +1377,238 @@ void VulkanApp::createGraphicsPipeline()
     vkDestroyShaderModule(device_, vertShaderModule, nullptr);
 }
 
+void VulkanApp::createDeferredPipelines()
+{
+    auto gBufferVertShaderCode  = VulkanUtils::readFile("E:/projects/learn_vulkan/data/shaders/gbuffer_vert.spv");
+    auto gBufferFragShaderCode  = VulkanUtils::readFile("E:/projects/learn_vulkan/data/shaders/gbuffer_frag.spv");
+    auto lightingVertShaderCode = VulkanUtils::readFile("E:/projects/learn_vulkan/data/shaders/fullscreen_vert.spv");
+    auto lightingFragShaderCode =
+        VulkanUtils::readFile("E:/projects/learn_vulkan/data/shaders/deferred_lighting_frag.spv");
+
+    VkShaderModule gBufferVertShaderModule  = createShaderModule(gBufferVertShaderCode);
+    VkShaderModule gBufferFragShaderModule  = createShaderModule(gBufferFragShaderCode);
+    VkShaderModule lightingVertShaderModule = createShaderModule(lightingVertShaderCode);
+    VkShaderModule lightingFragShaderModule = createShaderModule(lightingFragShaderCode);
+
+    const MaterialShaderStages gBufferShaderStages(
+        gBufferVertShaderModule, gBufferFragShaderModule, materialTextureCapacity_);
+
+    std::array<VkPipelineShaderStageCreateInfo, 2> lightingShaderStages = gBufferShaderStages.stages[0];
+    lightingShaderStages[0].module                                      = lightingVertShaderModule;
+    lightingShaderStages[1].module                                      = lightingFragShaderModule;
+    lightingShaderStages[1].pSpecializationInfo                         = nullptr;
+
+    auto bindingDescription    = Vertex::getBindingDescription();
+    auto attributeDescriptions = Vertex::getAttributeDescriptions();
+
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo {};
+    vertexInputInfo.sType                           = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInputInfo.vertexBindingDescriptionCount   = 1;
+    vertexInputInfo.pVertexBindingDescriptions      = &bindingDescription;
+    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+    vertexInputInfo.pVertexAttributeDescriptions    = attributeDescriptions.data();
+
+    VkPipelineVertexInputStateCreateInfo emptyVertexInputInfo {};
+    emptyVertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly {};
+    inputAssembly.sType                  = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology               = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+    VkPipelineViewportStateCreateInfo viewportState {};
+    viewportState.sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount  = 1;
+
+    VkPipelineRasterizationStateCreateInfo rasterizer {};
+    rasterizer.sType                   = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.depthClampEnable        = VK_FALSE;
+    rasterizer.rasterizerDiscardEnable = VK_FALSE;
+    rasterizer.polygonMode             = VK_POLYGON_MODE_FILL;
+    rasterizer.lineWidth               = 1.0F;
+    rasterizer.cullMode                = VK_CULL_MODE_BACK_BIT;
+    rasterizer.frontFace               = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterizer.depthBiasEnable         = VK_FALSE;
+
+    VkPipelineRasterizationStateCreateInfo lightingRasterizer = rasterizer;
+    lightingRasterizer.cullMode                               = VK_CULL_MODE_NONE;
+
+    VkPipelineMultisampleStateCreateInfo multisampling {};
+    multisampling.sType                = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.sampleShadingEnable  = VK_FALSE;
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    multisampling.minSampleShading     = 1.0F;
+
+    VkPipelineDepthStencilStateCreateInfo depthStencil {};
+    depthStencil.sType            = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable  = VK_TRUE;
+    depthStencil.depthWriteEnable = VK_TRUE;
+    depthStencil.depthCompareOp   = VK_COMPARE_OP_LESS;
+    depthStencil.minDepthBounds   = 0.0F;
+    depthStencil.maxDepthBounds   = 1.0F;
+
+    // the lighting pass covers the whole screen, the depth attachment of its subpass is for what is drawn after it
+    VkPipelineDepthStencilStateCreateInfo lightingDepthStencil {};
+    lightingDepthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+
+    VkPipelineColorBlendAttachmentState colorBlendAttachment {};
+    colorBlendAttachment.colorWriteMask =
+        VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    colorBlendAttachment.blendEnable = VK_FALSE;
+
+    std::array<VkPipelineColorBlendAttachmentState, 3> gBufferBlendAttachments = {
+        colorBlendAttachment, colorBlendAttachment, colorBlendAttachment};
+
+    VkPipelineColorBlendStateCreateInfo gBufferColorBlending {};
+    gBufferColorBlending.sType           = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    gBufferColorBlending.logicOpEnable   = VK_FALSE;
+    gBufferColorBlending.attachmentCount = gEnableObjectIdBuffer ? 3 : 2;
+    gBufferColorBlending.pAttachments    = gBufferBlendAttachments.data();
+
+    VkPipelineColorBlendStateCreateInfo lightingColorBlending = gBufferColorBlending;
+    lightingColorBlending.attachmentCount                     = 1;
+    lightingColorBlending.pAttachments                        = &colorBlendAttachment;
+
+    VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+
+    VkPipelineDynamicStateCreateInfo dynamicState {};
+    dynamicState.sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = sizeof(dynamicStates) / sizeof(VkDynamicState);
+    dynamicState.pDynamicStates    = dynamicStates;
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo {};
+    pipelineLayoutInfo.sType          = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts    = &descriptorSetLayout_;
+
+    if (vkCreatePipelineLayout(device_, &pipelineLayoutInfo, nullptr, &pipelineLayout_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create pipeline layout!");
+    }
+
+    VkPipelineLayoutCreateInfo lightingPipelineLayoutInfo {};
+    lightingPipelineLayoutInfo.sType          = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    lightingPipelineLayoutInfo.setLayoutCount = 1;
+    lightingPipelineLayoutInfo.pSetLayouts    = &gBufferDescriptorSetLayout_;
+
+    if (vkCreatePipelineLayout(device_, &lightingPipelineLayoutInfo, nullptr, &lightingPipelineLayout_) !=
+        VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create lighting pipeline layout!");
+    }
+
+    // the G-buffer pipelines of all shading models first, the lighting pipeline last
+    constexpr uint32_t LIGHTING_PIPELINE = SHADING_MODEL_COUNT;
+
+    std::array<VkGraphicsPipelineCreateInfo, SHADING_MODEL_COUNT + 1> pipelineInfos {};
+    pipelineInfos[0].sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfos[0].stageCount          = static_cast<uint32_t>(gBufferShaderStages.stages[0].size());
+    pipelineInfos[0].pStages             = gBufferShaderStages.stages[0].data();
+    pipelineInfos[0].pVertexInputState   = &vertexInputInfo;
+    pipelineInfos[0].pInputAssemblyState = &inputAssembly;
+    pipelineInfos[0].pViewportState      = &viewportState;
+    pipelineInfos[0].pRasterizationState = &rasterizer;
+    pipelineInfos[0].pMultisampleState   = &multisampling;
+    pipelineInfos[0].pDepthStencilState  = &depthStencil;
+    pipelineInfos[0].pColorBlendState    = &gBufferColorBlending;
+    pipelineInfos[0].pDynamicState       = &dynamicState;
+    pipelineInfos[0].layout              = pipelineLayout_;
+    pipelineInfos[0].renderPass          = renderPass_;
+    pipelineInfos[0].subpass             = 0;
+    pipelineInfos[0].basePipelineIndex   = -1;
+
+    for (uint32_t model = 1; model < SHADING_MODEL_COUNT; model++)
+    {
+        pipelineInfos[model]         = pipelineInfos[0];
+        pipelineInfos[model].pStages = gBufferShaderStages.stages[model].data();
+    }
+
+    pipelineInfos[LIGHTING_PIPELINE]                     = pipelineInfos[0];
+    pipelineInfos[LIGHTING_PIPELINE].pStages             = lightingShaderStages.data();
+    pipelineInfos[LIGHTING_PIPELINE].pVertexInputState   = &emptyVertexInputInfo;
+    pipelineInfos[LIGHTING_PIPELINE].pRasterizationState = &lightingRasterizer;
+    pipelineInfos[LIGHTING_PIPELINE].pDepthStencilState  = &lightingDepthStencil;
+    pipelineInfos[LIGHTING_PIPELINE].pColorBlendState    = &lightingColorBlending;
+    pipelineInfos[LIGHTING_PIPELINE].layout              = lightingPipelineLayout_;
+    pipelineInfos[LIGHTING_PIPELINE].subpass             = 1;
+
+    std::array<VkPipeline, SHADING_MODEL_COUNT + 1> pipelines {};
+    if (vkCreateGraphicsPipelines(device_,
+                                  pipelineCache_,
+                                  static_cast<uint32_t>(pipelineInfos.size()),
+                                  pipelineInfos.data(),
+                                  nullptr,
+                                  pipelines.data()) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create deferred pipelines!");
+    }
+
+    std::copy_n(pipelines.begin(), SHADING_MODEL_COUNT, graphicsPipelines_.begin());
+    lightingPipeline_ = pipelines[LIGHTING_PIPELINE];
+
+    vkDestroyShaderModule(device_, lightingFragShaderModule, nullptr);
+    vkDestroyShaderModule(device_, lightingVertShaderModule, nullptr);
+    vkDestroyShaderModule(device_, gBufferFragShaderModule, nullptr);
+    vkDestroyShaderModule(device_, gBufferVertShaderModule, nullptr);
+}
+
+void VulkanApp::createForwardPipelines()
+{
+    // drawn last into the last subpass, over the lit image and against the depth of the scene
+    VulkanDrawTarget target {};
+    target.renderPass           = renderPass_;
+    target.subpass              = deferredShading_ ? 1 : 0;
+    target.colorAttachmentCount = !deferredShading_ && gEnableObjectIdBuffer ? 2 : 1;
+
+#if VULKAN_HAS_DYNAMIC_RENDERING
+    const VkFormat                depthFormat  = findDepthFormat();
+    const std::array<VkFormat, 2> colorFormats = {swapChainImageFormat_, gObjectIdFormat};
+
+    VkPipelineRenderingCreateInfoKHR renderingInfo {};
+    renderingInfo.sType                   = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+    renderingInfo.colorAttachmentCount    = target.colorAttachmentCount;
+    renderingInfo.pColorAttachmentFormats = colorFormats.data();
+    renderingInfo.depthAttachmentFormat   = depthFormat;
+    renderingInfo.stencilAttachmentFormat =
+        VulkanUtils::hasStencilComponent(depthFormat) ? depthFormat : VK_FORMAT_UNDEFINED;
+
+    if (!usesRenderPass())
+    {
+        target.renderPass    = VK_NULL_HANDLE;
+        target.renderingInfo = &renderingInfo;
+    }
+#endif
+
+    particleSystem_.createDrawPipeline(
+        target,
+        VulkanUtils::readFile("E:/projects/learn_vulkan/data/shaders/particle_vert.spv"),
+        VulkanUtils::readFile("E:/projects/learn_vulkan/data/shaders/particle_frag.spv"));
+    impostorRenderer_.createDrawPipeline(
+        target,
+        VulkanUtils::readFile("E:/projects/learn_vulkan/data/shaders/impostor_vert.spv"),
+        VulkanUtils::readFile("E:/projects/learn_vulkan/data/shaders/impostor_frag.spv"));
+    hudRenderer_.createDrawPipeline(target,
+                                    VulkanUtils::readFile("E:/projects/learn_vulkan/data/shaders/hud_vert.spv"),
+                                    VulkanUtils::readFile("E:/projects/learn_vulkan/data/shaders/hud_frag.spv"));
+}
+
 void VulkanApp::createFrameBuffers()
 {
     swapChainFrameBuffers_.resize(swapChainImages_.size());
 
     for (size_t index = 0; index < swapChainImageViews_.size(); index++)
     {
-        std::array<VkImageView, 2> attachments = {swapChainImageViews_[index], depthImageView_};
+        std::vector<VkImageView> attachments = {swapChainImageViews_[index], depthImageView_};
+        if (deferredShading_)
+        {
+            attachments.push_back(gBufferAlbedo_.view);
+            attachments.push_back(gBufferNormal_.view);
+        }
+        if (gEnableObjectIdBuffer)
+        {
+            attachments.push_back(objectIdImageView_);
+        }
 
         VkFramebufferCreateInfo frameBufferInfo {};
         frameBufferInfo.sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
@@ -664,12 +1633,26 @@ void VulkanApp::createCommandPool()
     VkCommandPoolCreateInfo poolInfo {};
     poolInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
     poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
-    poolInfo.flags            = 0;
+    poolInfo.flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
     if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool_) != VK_SUCCESS)
     {
         LOG_FATAL("Failed to create command pool!");
     }
+
+    commandCache_.create(device_, queueFamilyIndices.graphicsFamily.value());
+    readbackManager_.create(physicalDevice_,
+                            device_,
+                            queueFamilyIndices.graphicsFamily.value(),
+                            MAX_FRAMES_IN_FLIGHT,
+                            gReadbackRingSize);
+    uploadQueue_.create(physicalDevice_,
+                        device_,
+                        queueFamilyIndices.graphicsFamily.value(),
+                        graphicsQueue_,
+                        submitManager_,
+                        assetExecutor_,
+                        gUploadStagingBlockSize);
 }
 
 void VulkanApp::createDepthResources()
@@ -691,70 +1674,105 @@ void VulkanApp::createDepthResources()
     //    depthImage_, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, 1);
 }
 
-void VulkanApp::createTextureImage()
+void VulkanApp::createObjectIdResources()
 {
-    int textureWidth {0};
-    int textureHeight {0};
-    int textureChannels {0};
+    if (!gEnableObjectIdBuffer)
+        return;
 
-    stbi_uc* pixels = stbi_load(TEXTURE_PATH.c_str(), &textureWidth, &textureHeight, &textureChannels, STBI_rgb_alpha);
-    if (pixels == nullptr)
-    {
-        LOG_FATAL("Failded to load texture image!");
-    }
+    createImage(swapChainExtent_.width,
+                swapChainExtent_.height,
+                1,
+                gObjectIdFormat,
+                VK_IMAGE_TILING_OPTIMAL,
+                VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                objectIdImage_,
+                objectIdImageMemory_);
+    objectIdImageView_ = createImageView(objectIdImage_, gObjectIdFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+}
 
-    mipLevels_ = static_cast<uint32_t>(std::floor(std::log2(std::max(textureWidth, textureHeight)))) + 1;
+void VulkanApp::createGBufferResources()
+{
+    if (!deferredShading_)
+        return;
 
-    VkDeviceSize imageSize = textureWidth * textureHeight * 4;
+    createTransientAttachment(gGBufferAlbedoFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, gBufferAlbedo_);
+    createTransientAttachment(gGBufferNormalFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, gBufferNormal_);
 
-    VkBuffer       stagingBuffer {nullptr};
-    VkDeviceMemory stagingBufferMemory {nullptr};
+    std::array<VkDescriptorPoolSize, 2> poolSizes {};
+    poolSizes[0].type            = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+    poolSizes[0].descriptorCount = 2;
+    poolSizes[1].type            = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    poolSizes[1].descriptorCount = 1;
 
-    createBuffer(imageSize,
-                 VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                 stagingBuffer,
-                 stagingBufferMemory);
+    VkDescriptorPoolCreateInfo poolInfo {};
+    poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes    = poolSizes.data();
+    poolInfo.maxSets       = 1;
 
-    void* data {nullptr};
-    vkMapMemory(device_, stagingBufferMemory, 0, imageSize, 0, &data);
-    memcpy(data, static_cast<void*>(pixels), static_cast<size_t>(imageSize));
-    vkUnmapMemory(device_, stagingBufferMemory);
+    if (vkCreateDescriptorPool(device_, &poolInfo, nullptr, &gBufferDescriptorPool_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create G-buffer descriptor pool");
+    }
 
-    stbi_image_free(pixels);
+    VkDescriptorSetAllocateInfo allocInfo {};
+    allocInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool     = gBufferDescriptorPool_;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts        = &gBufferDescriptorSetLayout_;
 
-    createImage(textureWidth,
-                textureHeight,
-                mipLevels_,
-                VK_FORMAT_R8G8B8A8_SRGB,
-                VK_IMAGE_TILING_OPTIMAL,
-                VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                textureImage_,
-                textureImageMemory_);
+    if (vkAllocateDescriptorSets(device_, &allocInfo, &gBufferDescriptorSet_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to allocate G-buffer descriptor set");
+    }
 
-    transitionImageLayout(textureImage_,
-                          VK_FORMAT_R8G8B8A8_SRGB,
-                          VK_IMAGE_LAYOUT_UNDEFINED,
-                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                          mipLevels_);
-    copyBufferToImage(
-        stagingBuffer, textureImage_, static_cast<uint32_t>(textureWidth), static_cast<uint32_t>(textureHeight));
-    transitionImageLayout(textureImage_,
-                          VK_FORMAT_R8G8B8A8_SRGB,
-                          VK_IMAGE_LAYOUT_UNDEFINED,
-                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                          mipLevels_);
+    std::array<VkDescriptorImageInfo, 2> imageInfos {};
+    imageInfos[0].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    imageInfos[0].imageView   = gBufferAlbedo_.view;
+    imageInfos[1].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    imageInfos[1].imageView   = gBufferNormal_.view;
 
-    generateMipmaps(textureImage_, VK_FORMAT_R8G8B8A8_SRGB, textureWidth, textureHeight, mipLevels_);
+    VkDescriptorBufferInfo environmentInfo {};
+    environmentInfo.buffer = environmentBuffer_;
+    environmentInfo.offset = 0;
+    environmentInfo.range  = sizeof(EnvironmentUniforms);
 
-    vkDestroyBuffer(device_, stagingBuffer, nullptr);
-    vkFreeMemory(device_, stagingBufferMemory, nullptr);
+    std::array<VkWriteDescriptorSet, 3> descriptorWrites {};
+    for (uint32_t index = 0; index < imageInfos.size(); index++)
+    {
+        descriptorWrites[index].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[index].dstSet          = gBufferDescriptorSet_;
+        descriptorWrites[index].dstBinding      = index;
+        descriptorWrites[index].dstArrayElement = 0;
+        descriptorWrites[index].descriptorType  = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+        descriptorWrites[index].descriptorCount = 1;
+        descriptorWrites[index].pImageInfo      = &imageInfos[index];
+    }
+    descriptorWrites[2]                = descriptorWrites[0];
+    descriptorWrites[2].dstBinding     = 2;
+    descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    descriptorWrites[2].pImageInfo     = nullptr;
+    descriptorWrites[2].pBufferInfo    = &environmentInfo;
+
+    vkUpdateDescriptorSets(
+        device_, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
 }
 
 void VulkanApp::createTextureImageView()
 {
     textureImageView_ = createImageView(textureImage_, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels_);
+
+    // slot 0 of the texture table
+    materialTextures_.push_back(textureImageView_);
+
+    // slot 1 when there is a baked lightmap
+    if (lightmapImage_ != VK_NULL_HANDLE)
+    {
+        lightmapImageView_ =
+            createImageView(lightmapImage_, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, lightmapMipLevels_);
+        materialTextures_.push_back(lightmapImageView_);
+    }
 }
 
 void VulkanApp::createTextureSampler()
@@ -786,63 +1804,68 @@ void VulkanApp::createTextureSampler()
     }
 }
 
-void VulkanApp::createVertexBuffer()
+void VulkanApp::createMaterialResources()
 {
-    const VkDeviceSize bufferSize = sizeof(vertices_[0]) * vertices_.size();
+    materialSystem_.create(gMaxMaterials, gMaxMaterialObjects, materialTextureCapacity_);
 
-    VkBuffer       stagingBuffer {nullptr};
-    VkDeviceMemory stagingBufferMemory {nullptr};
+    VkPhysicalDeviceProperties properties {};
+    vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
 
-    createBuffer(bufferSize,
-                 VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                 stagingBuffer,
-                 stagingBufferMemory);
-    void* data {nullptr};
-    vkMapMemory(device_, stagingBufferMemory, 0, bufferSize, 0, &data);
-    memcpy(data, vertices_.data(), static_cast<size_t>(bufferSize));
-    vkUnmapMemory(device_, stagingBufferMemory);
+    // both tables share one buffer, the object table starts at the next offset a storage buffer may be bound at
+    const VkDeviceSize alignment     = properties.limits.minStorageBufferOffsetAlignment;
+    const VkDeviceSize parameterSize = sizeof(MaterialParameters) * materialSystem_.getMaterialCapacity();
+    materialTableOffset_             = (parameterSize + alignment - 1) / alignment * alignment;
 
-    createBuffer(bufferSize,
-                 VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+    createBuffer(materialTableOffset_ + sizeof(uint32_t) * materialSystem_.getObjectCapacity(),
+                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                 vertexBuffer_,
-                 vertexBufferMemory_);
-
-    copyBuffer(stagingBuffer, vertexBuffer_, bufferSize);
-
-    vkDestroyBuffer(device_, stagingBuffer, nullptr);
-    vkFreeMemory(device_, stagingBufferMemory, nullptr);
-}
+                 materialBuffer_,
+                 materialBufferMemory_);
 
-void VulkanApp::createIndexBuffer()
-{
-    VkDeviceSize bufferSize = sizeof(indices_[0]) * indices_.size();
+    // the scene texture sits in slot 0 and the baked lightmap in slot 1, unless the table is too small to hold it. The
+    // first frame uploads the whole material buffer
+    const bool lightmapped = materialTextures_.size() > 1 && materialTextureCapacity_ > 1;
 
-    VkBuffer       stagingBuffer {nullptr};
-    VkDeviceMemory stagingBufferMemory {nullptr};
+    MaterialDesc sceneMaterial {};
+    sceneMaterial.baseColorTexture = 0;
+    sceneMaterial.lightmapTexture  = lightmapped ? 1 : 0;
+    sceneMaterial.shadingModel     = lightmapped ? ShadingModel::LIGHTMAPPED : ShadingModel::LAMBERT;
 
-    createBuffer(bufferSize,
-                 VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                 stagingBuffer,
-                 stagingBufferMemory);
+    const uint32_t sceneMaterialId = materialSystem_.createMaterial(sceneMaterial);
+    materialSystem_.assignMaterial(SCENE_OBJECT_ID, sceneMaterialId);
 
-    void* data {nullptr};
-    vkMapMemory(device_, stagingBufferMemory, 0, bufferSize, 0, &data);
-    memcpy(data, indices_.data(), static_cast<size_t>(bufferSize));
-    vkUnmapMemory(device_, stagingBufferMemory);
+    // the far field is made of copies of the scene, near and far ones alike
+    for (uint32_t copy = 0; copy < farFieldCopies_.size(); copy++)
+    {
+        materialSystem_.assignMaterial(FAR_FIELD_OBJECT_ID_BASE + copy, sceneMaterialId);
+    }
 
-    createBuffer(bufferSize,
-                 VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                 indexBuffer_,
-                 indexBufferMemory_);
+    // the skinned instances share the scene texture, tinted around the hue circle
+    for (uint32_t instance = 0; instance < skinningPass_.getInstanceCount(); instance++)
+    {
+        const float hue = glm::two_pi<float>() * static_cast<float>(instance) / skinningPass_.getInstanceCount();
+
+        MaterialDesc instanceMaterial {};
+        instanceMaterial.baseColor        = {0.6F + 0.4F * std::cos(hue),
+                                             0.6F + 0.4F * std::cos(hue - glm::two_pi<float>() / 3.0F),
+                                             0.6F + 0.4F * std::cos(hue + glm::two_pi<float>() / 3.0F),
+                                             1.0F};
+        instanceMaterial.baseColorTexture = 0;
+        materialSystem_.assignMaterial(SKINNED_OBJECT_ID_BASE + instance,
+                                       materialSystem_.createMaterial(instanceMaterial));
+    }
 
-    copyBuffer(stagingBuffer, indexBuffer_, bufferSize);
+    // the props as well, in darker shades so they read as ground clutter
+    for (uint32_t material = 0; material < gStaticPropMaterialCount; material++)
+    {
+        const float shade = 0.35F + 0.3F * static_cast<float>(material) / gStaticPropMaterialCount;
 
-    vkDestroyBuffer(device_, stagingBuffer, nullptr);
-    vkFreeMemory(device_, stagingBufferMemory, nullptr);
+        MaterialDesc propMaterial {};
+        propMaterial.baseColor        = {shade, shade * 0.9F, shade * 0.75F, 1.0F};
+        propMaterial.baseColorTexture = 0;
+        materialSystem_.assignMaterial(STATIC_PROP_OBJECT_ID_BASE + material,
+                                       materialSystem_.createMaterial(propMaterial));
+    }
 }
 
 void VulkanApp::createUniformBuffers()
@@ -862,19 +1885,41 @@ void VulkanApp::createUniformBuffers()
     }
 }
 
+void VulkanApp::createEnvironmentBuffer()
+{
+    createBuffer(sizeof(EnvironmentUniforms),
+                 VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                 environmentBuffer_,
+                 environmentBufferMemory_);
+
+    // the constant ambient of the shaders until the environment is loaded
+    EnvironmentUniforms uniforms {};
+    uniforms.irradiance[0] = glm::vec4(0.3F);
+
+    void* data = nullptr;
+    vkMapMemory(device_, environmentBufferMemory_, 0, sizeof(uniforms), 0, &data);
+    memcpy(data, &uniforms, sizeof(uniforms));
+    vkUnmapMemory(device_, environmentBufferMemory_);
+}
+
 void VulkanApp::createDescriptorPool()
 {
-    std::array<VkDescriptorPoolSize, 2> poolSizes {};
+    const auto setCount = static_cast<uint32_t>(swapChainImages_.size());
+
+    std::array<VkDescriptorPoolSize, 3> poolSizes {};
     poolSizes[0].type            = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    poolSizes[0].descriptorCount = static_cast<uint32_t>(swapChainImages_.size());
+    poolSizes[0].descriptorCount = setCount * 2;
     poolSizes[1].type            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    poolSizes[1].descriptorCount = static_cast<uint32_t>(swapChainImages_.size());
+    poolSizes[1].descriptorCount = setCount * materialTextureCapacity_;
+    poolSizes[2].type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[2].descriptorCount = setCount * 2;
 
     VkDescriptorPoolCreateInfo poolInfo {};
     poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
     poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
     poolInfo.pPoolSizes    = poolSizes.data();
-    poolInfo.maxSets       = static_cast<uint32_t>(swapChainImages_.size());
+    poolInfo.maxSets       = setCount;
 
     if (vkCreateDescriptorPool(device_, &poolInfo, nullptr, &descriptorPool_) != VK_SUCCESS)
     {
@@ -898,6 +1943,30 @@ void VulkanApp::createDescriptorSets()
         LOG_FATAL("Failed to allocate descriptor sets");
     }
 
+    // every slot of the texture table has to be valid, the ones without a texture repeat the first one
+    std::vector<VkDescriptorImageInfo> imageInfos(materialTextureCapacity_);
+    for (uint32_t slot = 0; slot < materialTextureCapacity_; slot++)
+    {
+        imageInfos[slot].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imageInfos[slot].imageView   = materialTextures_[slot < materialTextures_.size() ? slot : 0];
+        imageInfos[slot].sampler     = textureSampler_;
+    }
+
+    VkDescriptorBufferInfo materialBufferInfo {};
+    materialBufferInfo.buffer = materialBuffer_;
+    materialBufferInfo.offset = 0;
+    materialBufferInfo.range  = sizeof(MaterialParameters) * materialSystem_.getMaterialCapacity();
+
+    VkDescriptorBufferInfo materialTableInfo {};
+    materialTableInfo.buffer = materialBuffer_;
+    materialTableInfo.offset = materialTableOffset_;
+    materialTableInfo.range  = sizeof(uint32_t) * materialSystem_.getObjectCapacity();
+
+    VkDescriptorBufferInfo environmentInfo {};
+    environmentInfo.buffer = environmentBuffer_;
+    environmentInfo.offset = 0;
+    environmentInfo.range  = sizeof(EnvironmentUniforms);
+
     // config each descriptor set
     for (size_t index = 0; index < swapChainImages_.size(); index++)
     {
@@ -906,12 +1975,7 @@ void VulkanApp::createDescriptorSets()
         bufferInfo.offset = 0;
         bufferInfo.range  = sizeof(UniformBufferObject);
 
-        VkDescriptorImageInfo imageInfo {};
-        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        imageInfo.imageView   = textureImageView_;
-        imageInfo.sampler     = textureSampler_;
-
-        std::array<VkWriteDescriptorSet, 2> descriptorWrites {};
+        std::array<VkWriteDescriptorSet, 5> descriptorWrites {};
 
         descriptorWrites[0].sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         descriptorWrites[0].dstSet           = descriptorSets_[index];
@@ -928,11 +1992,27 @@ void VulkanApp::createDescriptorSets()
         descriptorWrites[1].dstBinding       = 1;
         descriptorWrites[1].dstArrayElement  = 0;
         descriptorWrites[1].descriptorType   = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        descriptorWrites[1].descriptorCount  = 1;
+        descriptorWrites[1].descriptorCount  = materialTextureCapacity_;
         descriptorWrites[1].pBufferInfo      = nullptr;
-        descriptorWrites[1].pImageInfo       = &imageInfo;
+        descriptorWrites[1].pImageInfo       = imageInfos.data();
         descriptorWrites[1].pTexelBufferView = nullptr;
 
+        descriptorWrites[2].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[2].dstSet          = descriptorSets_[index];
+        descriptorWrites[2].dstBinding      = 2;
+        descriptorWrites[2].dstArrayElement = 0;
+        descriptorWrites[2].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[2].descriptorCount = 1;
+        descriptorWrites[2].pBufferInfo     = &materialBufferInfo;
+
+        descriptorWrites[3]             = descriptorWrites[2];
+        descriptorWrites[3].dstBinding  = 3;
+        descriptorWrites[3].pBufferInfo = &materialTableInfo;
+
+        descriptorWrites[4]             = descriptorWrites[0];
+        descriptorWrites[4].dstBinding  = 4;
+        descriptorWrites[4].pBufferInfo = &environmentInfo;
+
         vkUpdateDescriptorSets(
             device_, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
     }
@@ -940,7 +2020,7 @@ void VulkanApp::createDescriptorSets()
 
 void VulkanApp::createCommandBuffers()
 {
-    commandBuffers_.resize(swapChainFrameBuffers_.size());
+    commandBuffers_.resize(swapChainImages_.size());
 
     VkCommandBufferAllocateInfo allocInfo {};
     allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -953,120 +2033,843 @@ void VulkanApp::createCommandBuffers()
         LOG_FATAL("Failed to allocate command buffers!");
     }
 
-    for (size_t index = 0; index < commandBuffers_.size(); index++)
-    {
-        VkCommandBufferBeginInfo beginInfo {};
-        beginInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        beginInfo.flags            = 0; // VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-        beginInfo.pInheritanceInfo = nullptr;
+    // recorded lazily in drawFrame, once the image is no longer in flight
+    commandBufferDirty_.assign(commandBuffers_.size(), true);
+    staticDrawLists_.assign(commandBuffers_.size(), {});
+    staticDrawVersions_.assign(commandBuffers_.size(), 0);
+    recordedDrawCounts_.assign(commandBuffers_.size() * 2, 0);
+
+    // one slot per image and subpass
+    commandCache_.resize(static_cast<uint32_t>(commandBuffers_.size()) * 2);
+}
 
-        if (vkBeginCommandBuffer(commandBuffers_[index], &beginInfo) != VK_SUCCESS)
+void VulkanApp::recordCommandBuffer(uint32_t imageIndex)
+{
+    const uint32_t subpassCount = deferredShading_ ? 2 : 1;
+
+#if VULKAN_HAS_DYNAMIC_RENDERING
+    const VkFormat                depthFormat  = findDepthFormat();
+    const std::array<VkFormat, 2> colorFormats = {swapChainImageFormat_, gObjectIdFormat};
+
+    VkCommandBufferInheritanceRenderingInfoKHR renderingInheritanceInfo {};
+    renderingInheritanceInfo.sType                   = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR;
+    renderingInheritanceInfo.colorAttachmentCount    = gEnableObjectIdBuffer ? 2 : 1;
+    renderingInheritanceInfo.pColorAttachmentFormats = colorFormats.data();
+    renderingInheritanceInfo.depthAttachmentFormat   = depthFormat;
+    renderingInheritanceInfo.stencilAttachmentFormat =
+        VulkanUtils::hasStencilComponent(depthFormat) ? depthFormat : VK_FORMAT_UNDEFINED;
+    renderingInheritanceInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+#endif
+
+    std::array<VkCommandBufferInheritanceInfo, 2> inheritanceInfos {};
+    for (uint32_t subpass = 0; subpass < subpassCount; subpass++)
+    {
+        inheritanceInfos[subpass].sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        if (usesRenderPass())
+        {
+            inheritanceInfos[subpass].renderPass  = renderPass_;
+            inheritanceInfos[subpass].subpass     = subpass;
+            inheritanceInfos[subpass].framebuffer = swapChainFrameBuffers_[imageIndex];
+        }
+#if VULKAN_HAS_DYNAMIC_RENDERING
+        else
         {
-            LOG_FATAL("Failed to begin recording command buffer!");
+            inheritanceInfos[subpass].pNext = &renderingInheritanceInfo;
         }
+#endif
+    }
 
-        std::array<VkClearValue, 2> clearVaules {};
-        clearVaules[0].color        = {0.0F, 0.0F, 0.0F, 1.0F};
-        clearVaules[1].depthStencil = {1.0F, 0};
+    const VkFramebuffer framebuffer = usesRenderPass() ? swapChainFrameBuffers_[imageIndex] : VK_NULL_HANDLE;
+
+    // a material switching its shading model switches the pipeline of the scene and with it the key, the skinned
+    // instances pick theirs per draw and are covered by the pipeline version. Both versions only ever grow, so their
+    // sum also changes when the culled static draws of the image changed
+    const ShadingModel sceneShadingModel =
+        materialSystem_.getShadingModel(materialSystem_.getObjectMaterial(SCENE_OBJECT_ID));
+
+    StaticDrawKey sceneKey {};
+    sceneKey.pipeline      = graphicsPipelines_[static_cast<uint32_t>(sceneShadingModel)];
+    sceneKey.descriptorSet = descriptorSets_[imageIndex];
+    sceneKey.vertexBuffer  = vertexBuffer_;
+    sceneKey.indexBuffer   = indexBuffer_;
+    sceneKey.indexCount    = static_cast<uint32_t>(indices_.size());
+    sceneKey.renderPass    = renderPass_;
+    sceneKey.subpass       = 0;
+    sceneKey.framebuffer   = framebuffer;
+    sceneKey.extent        = swapChainExtent_;
+    sceneKey.drawVersion   = materialSystem_.getPipelineVersion() + staticDrawVersions_[imageIndex];
+
+    std::array<VkCommandBuffer, 2> staticCommandBuffers {};
+
+    // a re-recorded secondary invalidates every primary that executes it
+    bool primaryDirty = commandBufferDirty_[imageIndex];
+    primaryDirty |= commandCache_.acquire(
+        imageIndex * 2,
+        sceneKey,
+        inheritanceInfos[0],
+        [this, imageIndex](VkCommandBuffer commandBuffer) {
+            rhiCommands_.reset();
+            recordSceneDraws(rhiCommands_, imageIndex);
+            if (!deferredShading_)
+            {
+                recordImpostorDraws(rhiCommands_, imageIndex);
+                recordParticleDraws(rhiCommands_, imageIndex);
+            }
+            // the hud does not count its own draw
+            recordedDrawCounts_[imageIndex * 2] = rhiCommands_.getDrawCount();
+            if (!deferredShading_)
+            {
+                recordHudDraws(rhiCommands_, imageIndex);
+            }
+            translateCommands(commandBuffer);
+        },
+        staticCommandBuffers[0]);
+
+    if (deferredShading_)
+    {
+        StaticDrawKey lightingKey {};
+        lightingKey.pipeline      = lightingPipeline_;
+        lightingKey.descriptorSet = gBufferDescriptorSet_;
+        lightingKey.renderPass    = renderPass_;
+        lightingKey.subpass       = 1;
+        lightingKey.framebuffer   = framebuffer;
+        lightingKey.extent        = swapChainExtent_;
+        lightingKey.drawVersion   = staticDrawVersions_[imageIndex];
+
+        primaryDirty |= commandCache_.acquire(
+            imageIndex * 2 + 1,
+            lightingKey,
+            inheritanceInfos[1],
+            [this, imageIndex](VkCommandBuffer commandBuffer) {
+                rhiCommands_.reset();
+                recordLightingDraws(rhiCommands_);
+                // neither the fullscreen lighting draw nor the hud count as draws of the scene
+                const uint32_t lightingDrawCount = rhiCommands_.getDrawCount();
+                recordImpostorDraws(rhiCommands_, imageIndex);
+                recordParticleDraws(rhiCommands_, imageIndex);
+                recordedDrawCounts_[imageIndex * 2 + 1] = rhiCommands_.getDrawCount() - lightingDrawCount;
+                recordHudDraws(rhiCommands_, imageIndex);
+                translateCommands(commandBuffer);
+            },
+            staticCommandBuffers[1]);
+    }
 
-        VkRenderPassBeginInfo renderPassInfo {};
-        renderPassInfo.sType             = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderPassInfo.renderPass        = renderPass_;
-        renderPassInfo.framebuffer       = swapChainFrameBuffers_[index];
-        renderPassInfo.renderArea.offset = {0, 0};
-        renderPassInfo.renderArea.extent = swapChainExtent_;
-        renderPassInfo.clearValueCount   = static_cast<uint32_t>(clearVaules.size());
-        renderPassInfo.pClearValues      = clearVaules.data();
+    if (!primaryDirty)
+        return;
 
-        vkCmdBeginRenderPass(commandBuffers_[index], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    VkCommandBuffer commandBuffer = commandBuffers_[imageIndex];
+
+    VkCommandBufferBeginInfo beginInfo {};
+    beginInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags            = 0; // VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+    beginInfo.pInheritanceInfo = nullptr;
 
-        vkCmdBindPipeline(commandBuffers_[index], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline_);
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to begin recording command buffer!");
+    }
 
-        VkBuffer     vertexBufffers[] = {vertexBuffer_};
-        VkDeviceSize offsets[]        = {0};
+    if (timestampQueryPool_ != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(commandBuffer, timestampQueryPool_, imageIndex * 2, 2);
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampQueryPool_, imageIndex * 2);
+    }
 
-        vkCmdBindVertexBuffers(commandBuffers_[index], 0, 1, vertexBufffers, offsets);
-        vkCmdBindIndexBuffer(commandBuffers_[index], indexBuffer_, 0, VK_INDEX_TYPE_UINT32);
-        vkCmdBindDescriptorSets(commandBuffers_[index],
-                                VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                pipelineLayout_,
-                                0,
-                                1,
-                                &descriptorSets_[index],
-                                0,
-                                nullptr);
+    // the command buffer is replayed as long as nothing else changes, the dispatch reads the palettes of the image
+    // which are rewritten every frame, so the skinned vertices still move
+    if (skinningPass_.isReady())
+    {
+        skinningPass_.record(commandBuffer, imageIndex);
+    }
 
-        vkCmdDrawIndexed(commandBuffers_[index], static_cast<uint32_t>(indices_.size()), 1, 0, 0, 0);
+    // the same goes for the particles, every replay steps the simulation with the parameters of the frame
+    if (particleSystem_.isReady())
+    {
+        particleSystem_.record(commandBuffer, imageIndex);
+    }
 
-        vkCmdEndRenderPass(commandBuffers_[index]);
+    beginMainPass(commandBuffer, imageIndex);
 
-        if (vkEndCommandBuffer(commandBuffers_[index]) != VK_SUCCESS)
+    for (uint32_t subpass = 0; subpass < subpassCount; subpass++)
+    {
+        if (subpass > 0)
         {
-            LOG_FATAL("Failed to record command buffer");
+            vkCmdNextSubpass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
         }
+
+        vkCmdExecuteCommands(commandBuffer, 1, &staticCommandBuffers[subpass]);
+    }
+
+    endMainPass(commandBuffer, imageIndex);
+
+    if (timestampQueryPool_ != VK_NULL_HANDLE)
+    {
+        vkCmdWriteTimestamp(
+            commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool_, imageIndex * 2 + 1);
+    }
+
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to record command buffer");
     }
+
+    commandBufferDirty_[imageIndex] = false;
 }
 
-void VulkanApp::createSyncObjects()
+void VulkanApp::recordSceneDraws(RhiCommandList& commandList, uint32_t imageIndex) const
 {
-    imageAvailableSemaphores_.resize(MAX_FRAMES_IN_FLIGHT);
-    renderFinishedSemaphores_.resize(MAX_FRAMES_IN_FLIGHT);
-    inFlightFences_.resize(MAX_FRAMES_IN_FLIGHT);
-    imagesInFlight_.resize(swapChainImages_.size(), nullptr);
+    // the material itself is looked up in the shaders through the object id, only its shading model picks the
+    // pipeline. Every scene pipeline shares the layout, so the descriptor set stays bound across pipeline switches
+    const auto getPipeline = [this](uint32_t object) {
+        const ShadingModel model = materialSystem_.getShadingModel(materialSystem_.getObjectMaterial(object));
+        return graphicsPipelineHandles_[static_cast<uint32_t>(model)];
+    };
 
-    VkSemaphoreCreateInfo semaphoreInfo {};
-    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    RhiPipelineHandle pipeline = getPipeline(SCENE_OBJECT_ID);
+    commandList.bindPipeline(pipeline);
 
-    VkFenceCreateInfo fenceInfo {};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+    setViewportAndScissor(commandList);
 
-    for (size_t index = 0; index < MAX_FRAMES_IN_FLIGHT; index++)
+    commandList.bindVertexBuffer(0, vertexBufferHandle_);
+    commandList.bindIndexBuffer(indexBufferHandle_, RhiIndexType::UINT32);
+    commandList.bindDescriptorSet(pipeline, 0, descriptorSetHandles_[imageIndex]);
+
+    commandList.drawIndexed(static_cast<uint32_t>(indices_.size()), 1, 0, 0, SCENE_OBJECT_ID);
+
+    // the props are already in scene space, each draw is a run of visible chunks of a cell sharing a material. The
+    // draws of a cell are consecutive, its buffers are bound once
+    const StaticDrawLists& staticDraws = staticDrawLists_[imageIndex];
+    const WorldCell*       boundCell   = nullptr;
+    for (const auto& [cell, draw] : staticDraws.props)
     {
-        if (vkCreateSemaphore(device_, &semaphoreInfo, nullptr, &imageAvailableSemaphores_[index]) != VK_SUCCESS ||
-            vkCreateSemaphore(device_, &semaphoreInfo, nullptr, &renderFinishedSemaphores_[index]) != VK_SUCCESS ||
-            vkCreateFence(device_, &fenceInfo, nullptr, &inFlightFences_[index]) != VK_SUCCESS)
+        if (boundCell == nullptr || boundCell->index != cell)
         {
-            LOG_FATAL("Failed to create syncronization objects for a frame");
+            boundCell = worldCells_.at(cell).get();
+            commandList.bindVertexBuffer(0, boundCell->vertexBufferHandle);
+            commandList.bindIndexBuffer(boundCell->indexBufferHandle, RhiIndexType::UINT32);
         }
-    }
-}
 
-void VulkanApp::recreateSwapChain()
-{
-    // handle minimization
-    int width  = 0;
-    int height = 0;
+        const uint32_t object = STATIC_PROP_OBJECT_ID_BASE + boundCell->batch.groups[draw.group].material;
 
-    glfwGetFramebufferSize(window_, &width, &height);
-    while (width == 0 || height == 0)
+        const RhiPipelineHandle drawPipeline = getPipeline(object);
+        if (drawPipeline != pipeline)
+        {
+            pipeline = drawPipeline;
+            commandList.bindPipeline(pipeline);
+        }
+
+        commandList.drawIndexed(draw.indexCount, 1, draw.firstIndex, 0, object);
+    }
+
+    // the near copies of the far field at full detail, one draw each
+    if (!staticDraws.farFieldMeshes.empty())
     {
-        glfwGetFramebufferSize(window_, &width, &height);
-        glfwWaitEvents();
+        commandList.bindVertexBuffer(0, farFieldVertexBufferHandle_);
+        commandList.bindIndexBuffer(farFieldIndexBufferHandle_, RhiIndexType::UINT32);
+
+        for (const auto& draw : staticDraws.farFieldMeshes)
+        {
+            const uint32_t object = FAR_FIELD_OBJECT_ID_BASE + farFieldBatch_.groups[draw.group].material;
+
+            const RhiPipelineHandle drawPipeline = getPipeline(object);
+            if (drawPipeline != pipeline)
+            {
+                pipeline = drawPipeline;
+                commandList.bindPipeline(pipeline);
+            }
+
+            commandList.drawIndexed(draw.indexCount, 1, draw.firstIndex, 0, object);
+        }
     }
 
-    vkDeviceWaitIdle(device_);
+    if (!skinningPass_.isReady())
+        return;
 
-    cleanupSwapChain();
+    // every instance has its own copy of the mesh in the skinned vertex buffer, the vertex offset selects it
+    commandList.bindVertexBuffer(0, skinnedVertexBufferHandle_);
+    commandList.bindIndexBuffer(skinnedIndexBufferHandle_, RhiIndexType::UINT32);
 
-    createSwapChain();
-    createImageViews();
-    createRenderPass();
-    createGraphicsPipeline();
-    createDepthResources();
-    createFrameBuffers();
-    createUniformBuffers();
-    createDescriptorPool();
-    createDescriptorSets();
-    createCommandBuffers();
+    const auto indexCount = static_cast<uint32_t>(skinnedMesh_.indices.size());
+    for (uint32_t instance = 0; instance < skinningPass_.getInstanceCount(); instance++)
+    {
+        const RhiPipelineHandle instancePipeline = getPipeline(SKINNED_OBJECT_ID_BASE + instance);
+        if (instancePipeline != pipeline)
+        {
+            pipeline = instancePipeline;
+            commandList.bindPipeline(pipeline);
+        }
 
-    imagesInFlight_.resize(swapChainImages_.size(), nullptr);
+        const auto vertexOffset = static_cast<int32_t>(instance * skinningPass_.getVertexCount());
+        commandList.drawIndexed(indexCount, 1, 0, vertexOffset, SKINNED_OBJECT_ID_BASE + instance);
+    }
 }
 
-VkShaderModule VulkanApp::createShaderModule(const std::vector<char>& code) const
+void VulkanApp::recordLightingDraws(RhiCommandList& commandList) const
 {
-    VkShaderModuleCreateInfo createInfo {};
-    createInfo.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    commandList.bindPipeline(lightingPipelineHandle_);
+
+    setViewportAndScissor(commandList);
+
+    commandList.bindDescriptorSet(lightingPipelineHandle_, 0, gBufferDescriptorSetHandle_);
+    commandList.draw(3, 1, 0, 0);
+}
+
+void VulkanApp::recordImpostorDraws(RhiCommandList& commandList, uint32_t imageIndex) const
+{
+    const std::vector<ImpostorDraw>& draws = staticDrawLists_[imageIndex].impostors;
+    if (!impostorRenderer_.isDrawable() || draws.empty())
+        return;
+
+    // six vertices per copy instead of its whole mesh, a run of consecutive far copies is one instanced draw
+    commandList.bindPipeline(impostorPipelineHandle_);
+    commandList.bindVertexBuffer(0, impostorInstanceBufferHandle_);
+    commandList.bindDescriptorSet(impostorPipelineHandle_, 0, impostorDescriptorSetHandles_[imageIndex]);
+    for (const auto& draw : draws)
+    {
+        commandList.draw(6, draw.instanceCount, 0, draw.firstInstance);
+    }
+}
+
+void VulkanApp::recordParticleDraws(RhiCommandList& commandList, uint32_t imageIndex) const
+{
+    if (!particleSystem_.isDrawable())
+        return;
+
+    // one quad per live particle, the count never leaves the gpu
+    commandList.bindPipeline(particlePipelineHandle_);
+    commandList.bindDescriptorSet(particlePipelineHandle_, 0, particleDescriptorSetHandles_[imageIndex]);
+    commandList.drawIndirect(
+        particleDrawArgsHandle_, VulkanParticleSystem::getDrawArgsOffset(), 1, sizeof(VkDrawIndirectCommand));
+}
+
+void VulkanApp::recordHudDraws(RhiCommandList& commandList, uint32_t imageIndex) const
+{
+    if (!hudRenderer_.isDrawable())
+        return;
+
+    // the vertex count is written along with the vertices every frame, so the cached draw stays valid
+    commandList.bindPipeline(hudPipelineHandle_);
+    commandList.bindDescriptorSet(hudPipelineHandle_, 0, hudDescriptorSetHandle_);
+    commandList.bindVertexBuffer(0, hudBufferHandles_[imageIndex], VulkanHudRenderer::getVertexOffset());
+    commandList.drawIndirect(hudBufferHandles_[imageIndex], 0, 1, sizeof(VkDrawIndirectCommand));
+}
+
+void VulkanApp::setViewportAndScissor(RhiCommandList& commandList) const
+{
+    RhiViewport viewport {};
+    viewport.x        = 0.0F;
+    viewport.y        = 0.0F;
+    viewport.width    = static_cast<float>(swapChainExtent_.width);
+    viewport.height   = static_cast<float>(swapChainExtent_.height);
+    viewport.minDepth = 0.0F;
+    viewport.maxDepth = 1.0F;
+
+    RhiRect scissor {};
+    scissor.width  = swapChainExtent_.width;
+    scissor.height = swapChainExtent_.height;
+
+    commandList.setViewport(viewport);
+    commandList.setScissor(scissor);
+}
+
+void VulkanApp::translateCommands(VkCommandBuffer commandBuffer)
+{
+    rhiBackend_.setCommandBuffer(commandBuffer);
+    rhiBackend_.execute(rhiCommands_);
+
+    if (traceWriter_.isCapturing())
+    {
+        traceWriter_.writeCommandList(rhiCommands_);
+    }
+}
+
+void VulkanApp::beginTraceCapture()
+{
+    if (!traceWriter_.begin(gTraceCapturePath))
+        return;
+
+    // the contents of the geometry buffers are part of the trace, so it replays without the original assets
+    traceWriter_.writeBuffer(vertexBufferHandle_,
+                             {sizeof(vertices_[0]) * vertices_.size(), RHI_BUFFER_USAGE_VERTEX},
+                             vertices_.data());
+    traceWriter_.writeBuffer(
+        indexBufferHandle_, {sizeof(indices_[0]) * indices_.size(), RHI_BUFFER_USAGE_INDEX}, indices_.data());
+
+    // the skinned vertices only exist on the gpu, the trace replays the instances in their bind pose
+    if (skinningPass_.isReady())
+    {
+        std::vector<Vertex> bindPose;
+        bindPose.reserve(skinnedMesh_.vertices.size() * skinningPass_.getInstanceCount());
+        for (uint32_t instance = 0; instance < skinningPass_.getInstanceCount(); instance++)
+        {
+            for (const SkinnedVertex& vertex : skinnedMesh_.vertices)
+            {
+                bindPose.push_back({glm::vec3(vertex.position), vertex.texCoord});
+            }
+        }
+        traceWriter_.writeBuffer(skinnedVertexBufferHandle_,
+                                 {sizeof(bindPose[0]) * bindPose.size(), RHI_BUFFER_USAGE_VERTEX},
+                                 bindPose.data());
+        traceWriter_.writeBuffer(
+            skinnedIndexBufferHandle_,
+            {sizeof(skinnedMesh_.indices[0]) * skinnedMesh_.indices.size(), RHI_BUFFER_USAGE_INDEX},
+            skinnedMesh_.indices.data());
+    }
+
+    if (!farFieldBatch_.isEmpty())
+    {
+        traceWriter_.writeBuffer(
+            farFieldVertexBufferHandle_,
+            {sizeof(farFieldBatch_.vertices[0]) * farFieldBatch_.vertices.size(), RHI_BUFFER_USAGE_VERTEX},
+            farFieldBatch_.vertices.data());
+        traceWriter_.writeBuffer(
+            farFieldIndexBufferHandle_,
+            {sizeof(farFieldBatch_.indices[0]) * farFieldBatch_.indices.size(), RHI_BUFFER_USAGE_INDEX},
+            farFieldBatch_.indices.data());
+        traceWriter_.writeBuffer(
+            impostorInstanceBufferHandle_,
+            {sizeof(farFieldCopies_[0]) * farFieldCopies_.size(), RHI_BUFFER_USAGE_VERTEX},
+            farFieldCopies_.data());
+    }
+
+    // the particles only exist on the gpu as well, their draw arguments replay with no instances
+    const std::vector<std::byte> particleDrawArgs(VulkanParticleSystem::getDrawArgsOffset() +
+                                                  sizeof(VkDrawIndirectCommand));
+    traceWriter_.writeBuffer(particleDrawArgsHandle_,
+                             {particleDrawArgs.size(), RHI_BUFFER_USAGE_STORAGE | RHI_BUFFER_USAGE_INDIRECT},
+                             particleDrawArgs.data());
+
+    // the overlay is rebuilt every frame, the trace replays it hidden
+    const std::vector<std::byte> hudVertices(hudRenderer_.isReady() ? hudRenderer_.getBufferSize() : 0);
+    for (const auto& handle : hudBufferHandles_)
+    {
+        traceWriter_.writeBuffer(
+            handle, {hudVertices.size(), RHI_BUFFER_USAGE_VERTEX | RHI_BUFFER_USAGE_INDIRECT}, hudVertices.data());
+    }
+
+    for (const auto& handle : graphicsPipelineHandles_)
+    {
+        traceWriter_.writePipeline(handle);
+    }
+    traceWriter_.writePipeline(lightingPipelineHandle_);
+    traceWriter_.writePipeline(particlePipelineHandle_);
+    traceWriter_.writePipeline(impostorPipelineHandle_);
+    traceWriter_.writePipeline(hudPipelineHandle_);
+    for (const auto& handle : descriptorSetHandles_)
+    {
+        traceWriter_.writeDescriptorSet(handle);
+    }
+    for (const auto& handle : particleDescriptorSetHandles_)
+    {
+        traceWriter_.writeDescriptorSet(handle);
+    }
+    for (const auto& handle : impostorDescriptorSetHandles_)
+    {
+        traceWriter_.writeDescriptorSet(handle);
+    }
+    traceWriter_.writeDescriptorSet(gBufferDescriptorSetHandle_);
+    traceWriter_.writeDescriptorSet(hudDescriptorSetHandle_);
+
+    LOG_INFO("Capturing rhi trace into {}", gTraceCapturePath);
+}
+
+void VulkanApp::benchmarkDispatchOverhead() const
+{
+    VulkanDeviceTable trampolineTable {};
+    VulkanDeviceTable deviceTable {};
+    VulkanLoader::loadTrampolineTable(instance_, trampolineTable);
+    VulkanLoader::loadDeviceTable(device_, deviceTable);
+
+    VkCommandBufferAllocateInfo allocInfo {};
+    allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool        = commandPool_;
+    allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    if (vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to allocate dispatch benchmark command buffer!");
+    }
+
+    VkViewport viewport {0.0F, 0.0F, 1.0F, 1.0F, 0.0F, 1.0F};
+    VkRect2D   scissor {{0, 0}, {1, 1}};
+
+    // dynamic state outside a render pass is valid to record, the command buffer is never submitted
+    const auto measure = [&](const VulkanDeviceTable& table) {
+        VkCommandBufferBeginInfo beginInfo {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        table.vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+        const auto startTime = std::chrono::high_resolution_clock::now();
+        for (uint32_t index = 0; index < gDispatchBenchmarkCallCount; index += 2)
+        {
+            table.vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+            table.vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+        }
+        const auto endTime = std::chrono::high_resolution_clock::now();
+
+        table.vkEndCommandBuffer(commandBuffer);
+
+        return std::chrono::duration<double, std::nano>(endTime - startTime).count() / gDispatchBenchmarkCallCount;
+    };
+
+    // alternate the two tables and keep the best round of each so cache warm-up does not favour either one
+    double trampolineNs = std::numeric_limits<double>::max();
+    double deviceNs     = std::numeric_limits<double>::max();
+    for (uint32_t round = 0; round < 5; round++)
+    {
+        trampolineNs = std::min(trampolineNs, measure(trampolineTable));
+        deviceNs     = std::min(deviceNs, measure(deviceTable));
+    }
+
+    vkFreeCommandBuffers(device_, commandPool_, 1, &commandBuffer);
+
+    LOG_INFO("Dispatch overhead: loader trampoline {:.2f} ns/call, device table {:.2f} ns/call ({:.1f}% saved)",
+             trampolineNs,
+             deviceNs,
+             (1.0 - deviceNs / trampolineNs) * 100.0);
+}
+
+void VulkanApp::importRhiResources()
+{
+    for (uint32_t model = 0; model < SHADING_MODEL_COUNT; model++)
+    {
+        graphicsPipelineHandles_[model] = rhiBackend_.importPipeline(graphicsPipelines_[model],
+                                                                     pipelineLayout_,
+                                                                     VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                                                     graphicsPipelineHandles_[model]);
+    }
+    lightingPipelineHandle_ = rhiBackend_.importPipeline(
+        lightingPipeline_, lightingPipelineLayout_, VK_PIPELINE_BIND_POINT_GRAPHICS, lightingPipelineHandle_);
+    particlePipelineHandle_ = rhiBackend_.importPipeline(particleSystem_.getDrawPipeline(),
+                                                         particleSystem_.getPipelineLayout(),
+                                                         VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                                         particlePipelineHandle_);
+    impostorPipelineHandle_ = rhiBackend_.importPipeline(impostorRenderer_.getDrawPipeline(),
+                                                         impostorRenderer_.getPipelineLayout(),
+                                                         VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                                         impostorPipelineHandle_);
+    hudPipelineHandle_      = rhiBackend_.importPipeline(hudRenderer_.getDrawPipeline(),
+                                                         hudRenderer_.getPipelineLayout(),
+                                                         VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                                         hudPipelineHandle_);
+
+    vertexBufferHandle_ = rhiBackend_.importBuffer(vertexBuffer_, vertexBufferHandle_);
+    indexBufferHandle_  = rhiBackend_.importBuffer(indexBuffer_, indexBufferHandle_);
+
+    skinnedVertexBufferHandle_ = rhiBackend_.importBuffer(skinningPass_.getOutputBuffer(), skinnedVertexBufferHandle_);
+    skinnedIndexBufferHandle_  = rhiBackend_.importBuffer(skinnedIndexBuffer_, skinnedIndexBufferHandle_);
+    particleDrawArgsHandle_    = rhiBackend_.importBuffer(particleSystem_.getDrawArgsBuffer(), particleDrawArgsHandle_);
+
+    farFieldVertexBufferHandle_ = rhiBackend_.importBuffer(farFieldVertexBuffer_, farFieldVertexBufferHandle_);
+    farFieldIndexBufferHandle_  = rhiBackend_.importBuffer(farFieldIndexBuffer_, farFieldIndexBufferHandle_);
+    impostorInstanceBufferHandle_ =
+        rhiBackend_.importBuffer(impostorRenderer_.getInstanceBuffer(), impostorInstanceBufferHandle_);
+
+    descriptorSetHandles_.resize(descriptorSets_.size());
+    for (size_t index = 0; index < descriptorSets_.size(); index++)
+    {
+        descriptorSetHandles_[index] =
+            rhiBackend_.importDescriptorSet(descriptorSets_[index], descriptorSetHandles_[index]);
+    }
+    gBufferDescriptorSetHandle_ = rhiBackend_.importDescriptorSet(gBufferDescriptorSet_, gBufferDescriptorSetHandle_);
+
+    particleDescriptorSetHandles_.resize(swapChainImages_.size());
+    for (uint32_t index = 0; index < swapChainImages_.size(); index++)
+    {
+        particleDescriptorSetHandles_[index] = rhiBackend_.importDescriptorSet(particleSystem_.getDescriptorSet(index),
+                                                                               particleDescriptorSetHandles_[index]);
+    }
+
+    // nothing to import when no impostor was baked
+    impostorDescriptorSetHandles_.resize(impostorRenderer_.isReady() ? swapChainImages_.size() : 0);
+    for (uint32_t index = 0; index < impostorDescriptorSetHandles_.size(); index++)
+    {
+        impostorDescriptorSetHandles_[index] = rhiBackend_.importDescriptorSet(
+            impostorRenderer_.getDescriptorSet(index), impostorDescriptorSetHandles_[index]);
+    }
+
+    hudDescriptorSetHandle_ = rhiBackend_.importDescriptorSet(hudRenderer_.getDescriptorSet(), hudDescriptorSetHandle_);
+    hudBufferHandles_.resize(hudRenderer_.isReady() ? swapChainImages_.size() : 0);
+    for (uint32_t index = 0; index < hudBufferHandles_.size(); index++)
+    {
+        hudBufferHandles_[index] = rhiBackend_.importBuffer(hudRenderer_.getBuffer(index), hudBufferHandles_[index]);
+    }
+}
+
+void VulkanApp::beginMainPass(VkCommandBuffer commandBuffer, uint32_t imageIndex) const
+{
+    std::array<VkClearValue, 5> clearVaules {};
+    clearVaules[0].color        = {0.0F, 0.0F, 0.0F, 1.0F};
+    clearVaules[1].depthStencil = {1.0F, 0};
+    clearVaules[2].color        = {0.0F, 0.0F, 0.0F, 0.0F};
+    clearVaules[3].color        = {0.5F, 0.5F, 0.5F, 0.0F};
+
+    // the id buffer follows the last attachment of the pass, its clear value of zero is the background id
+    const uint32_t objectIdAttachment = deferredShading_ ? 4 : 2;
+    const uint32_t attachmentCount    = gEnableObjectIdBuffer ? objectIdAttachment + 1 : objectIdAttachment;
+
+    if (usesRenderPass())
+    {
+        VkRenderPassBeginInfo renderPassInfo {};
+        renderPassInfo.sType             = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass        = renderPass_;
+        renderPassInfo.framebuffer       = swapChainFrameBuffers_[imageIndex];
+        renderPassInfo.renderArea.offset = {0, 0};
+        renderPassInfo.renderArea.extent = swapChainExtent_;
+        renderPassInfo.clearValueCount   = attachmentCount;
+        renderPassInfo.pClearValues      = clearVaules.data();
+
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        return;
+    }
+
+#if VULKAN_HAS_DYNAMIC_RENDERING
+    const VkFormat depthFormat = findDepthFormat();
+    const bool     hasStencil  = VulkanUtils::hasStencilComponent(depthFormat);
+
+    // without a render pass the layout transitions done by the attachment descriptions have to be explicit
+    std::array<VkImageMemoryBarrier, 3> barriers {};
+    barriers[0].sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barriers[0].srcAccessMask                   = 0;
+    barriers[0].dstAccessMask                   = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    barriers[0].oldLayout                       = VK_IMAGE_LAYOUT_UNDEFINED;
+    barriers[0].newLayout                       = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    barriers[0].srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    barriers[0].dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    barriers[0].image                           = swapChainImages_[imageIndex];
+    barriers[0].subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    barriers[0].subresourceRange.baseMipLevel   = 0;
+    barriers[0].subresourceRange.levelCount     = 1;
+    barriers[0].subresourceRange.baseArrayLayer = 0;
+    barriers[0].subresourceRange.layerCount     = 1;
+
+    barriers[1]               = barriers[0];
+    barriers[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    barriers[1].dstAccessMask =
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    barriers[1].newLayout                   = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    barriers[1].image                       = depthImage_;
+    barriers[1].subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+    if (hasStencil)
+    {
+        barriers[1].subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+    }
+
+    // waits for the readback copy of the previous frame before the id buffer is cleared
+    barriers[2]       = barriers[0];
+    barriers[2].image = objectIdImage_;
+
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                             VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                             VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                         0,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr,
+                         gEnableObjectIdBuffer ? 3 : 2,
+                         barriers.data());
+
+    std::array<VkRenderingAttachmentInfoKHR, 2> colorAttachments {};
+    colorAttachments[0].sType       = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+    colorAttachments[0].imageView   = swapChainImageViews_[imageIndex];
+    colorAttachments[0].imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    colorAttachments[0].loadOp      = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    colorAttachments[0].storeOp     = VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttachments[0].clearValue  = clearVaules[0];
+
+    colorAttachments[1]            = colorAttachments[0];
+    colorAttachments[1].imageView  = objectIdImageView_;
+    colorAttachments[1].clearValue = clearVaules[objectIdAttachment];
+
+    VkRenderingAttachmentInfoKHR depthAttachment {};
+    depthAttachment.sType       = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+    depthAttachment.imageView   = depthImageView_;
+    depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    depthAttachment.loadOp      = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depthAttachment.storeOp     = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.clearValue  = clearVaules[1];
+
+    VkRenderingInfoKHR renderingInfo {};
+    renderingInfo.sType                = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+    renderingInfo.flags                = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR;
+    renderingInfo.renderArea.offset    = {0, 0};
+    renderingInfo.renderArea.extent    = swapChainExtent_;
+    renderingInfo.layerCount           = 1;
+    renderingInfo.colorAttachmentCount = attachmentCount - 1;
+    renderingInfo.pColorAttachments    = colorAttachments.data();
+    renderingInfo.pDepthAttachment     = &depthAttachment;
+    renderingInfo.pStencilAttachment   = hasStencil ? &depthAttachment : nullptr;
+
+    vkCmdBeginRenderingKHR(commandBuffer, &renderingInfo);
+#endif
+}
+
+void VulkanApp::endMainPass(VkCommandBuffer commandBuffer, uint32_t imageIndex) const
+{
+    if (usesRenderPass())
+    {
+        vkCmdEndRenderPass(commandBuffer);
+        return;
+    }
+
+#if VULKAN_HAS_DYNAMIC_RENDERING
+    vkCmdEndRenderingKHR(commandBuffer);
+
+    std::array<VkImageMemoryBarrier, 2> barriers {};
+    barriers[0].sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barriers[0].srcAccessMask                   = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    barriers[0].dstAccessMask                   = 0;
+    barriers[0].oldLayout                       = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    barriers[0].newLayout                       = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    barriers[0].srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    barriers[0].dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    barriers[0].image                           = swapChainImages_[imageIndex];
+    barriers[0].subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    barriers[0].subresourceRange.baseMipLevel   = 0;
+    barriers[0].subresourceRange.levelCount     = 1;
+    barriers[0].subresourceRange.baseArrayLayer = 0;
+    barriers[0].subresourceRange.layerCount     = 1;
+
+    // same layout the render pass leaves the id buffer in for the readback copy
+    barriers[1]               = barriers[0];
+    barriers[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barriers[1].newLayout     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barriers[1].image         = objectIdImage_;
+
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                         VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr,
+                         gEnableObjectIdBuffer ? 2 : 1,
+                         barriers.data());
+#endif
+}
+
+void VulkanApp::createTimestampQueryPool()
+{
+    const QueueFamilyIndices indices = VulkanUtils::findQueueFamilies(physicalDevice_, surface_);
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice_, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice_, &queueFamilyCount, queueFamilies.data());
+
+    if (timestampPeriod_ <= 0.0F || queueFamilies[indices.graphicsFamily.value()].timestampValidBits == 0)
+    {
+        LOG_WARN("Timestamp queries are not supported, GPU frame times are unavailable");
+        return;
+    }
+
+    // two timestamps per swap chain image, around the main pass
+    VkQueryPoolCreateInfo queryPoolInfo {};
+    queryPoolInfo.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = static_cast<uint32_t>(swapChainImages_.size()) * 2;
+
+    if (vkCreateQueryPool(device_, &queryPoolInfo, nullptr, &timestampQueryPool_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create timestamp query pool!");
+    }
+}
+
+void VulkanApp::createSyncObjects()
+{
+    imageAvailableSemaphores_.resize(MAX_FRAMES_IN_FLIGHT);
+    renderFinishedSemaphores_.resize(MAX_FRAMES_IN_FLIGHT);
+    inFlightFences_.resize(MAX_FRAMES_IN_FLIGHT);
+    imagesInFlight_.resize(swapChainImages_.size(), nullptr);
+
+    VkSemaphoreCreateInfo semaphoreInfo {};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    VkFenceCreateInfo fenceInfo {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    for (size_t index = 0; index < MAX_FRAMES_IN_FLIGHT; index++)
+    {
+        if (vkCreateSemaphore(device_, &semaphoreInfo, nullptr, &imageAvailableSemaphores_[index]) != VK_SUCCESS ||
+            vkCreateSemaphore(device_, &semaphoreInfo, nullptr, &renderFinishedSemaphores_[index]) != VK_SUCCESS ||
+            vkCreateFence(device_, &fenceInfo, nullptr, &inFlightFences_[index]) != VK_SUCCESS)
+        {
+            LOG_FATAL("Failed to create syncronization objects for a frame");
+        }
+    }
+}
+
+void VulkanApp::recreateSwapChain()
+{
+    // minimized windows never produce packets, so framebufferExtent_ is always usable here
+    submitManager_.drain();
+    vkDeviceWaitIdle(device_);
+
+    // a result still pending from the submit thread belongs to the swapchain that is about to go away
+    submitManager_.takePresentResult();
+
+    const VkFormat oldImageFormat = swapChainImageFormat_;
+
+    cleanupSwapChain();
+    commandCache_.invalidate();
+
+    createSwapChain();
+    createImageViews();
+
+    // the pipeline only depends on the attachment formats, a plain resize keeps it
+    if (swapChainImageFormat_ != oldImageFormat || renderPathChanged_)
+    {
+        cleanupPipeline();
+        if (usesRenderPass())
+        {
+            createRenderPass();
+        }
+        createGraphicsPipeline();
+        createForwardPipelines();
+
+        LOG_INFO("Shading: {}", deferredShading_ ? "deferred" : "forward");
+        renderPathChanged_ = false;
+        frameStatistics_   = {};
+    }
+
+    createDepthResources();
+    createObjectIdResources();
+    createGBufferResources();
+    if (usesRenderPass())
+    {
+        createFrameBuffers();
+    }
+    createUniformBuffers();
+    skinningPass_.createFrameResources(static_cast<uint32_t>(swapChainImages_.size()));
+    particleSystem_.createFrameResources(static_cast<uint32_t>(swapChainImages_.size()));
+    impostorRenderer_.createFrameResources(uniformBuffers_);
+    hudRenderer_.createFrameResources(static_cast<uint32_t>(swapChainImages_.size()), gPerfHudMaxVertices);
+    createDescriptorPool();
+    createDescriptorSets();
+    createTimestampQueryPool();
+    createCommandBuffers();
+    importRhiResources();
+
+    // everything is idle and the timestamp queries were recreated, so no image has a frame in flight anymore
+    imagesInFlight_.assign(swapChainImages_.size(), VK_NULL_HANDLE);
+
+    // the new images have never been presented, ask the main thread for another packet
+    swapChainRecreated_ = true;
+    glfwPostEmptyEvent();
+}
+
+VkShaderModule VulkanApp::createShaderModule(const std::vector<char>& code) const
+{
+    VkShaderModuleCreateInfo createInfo {};
+    createInfo.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
     createInfo.codeSize = code.size();
     createInfo.pCode    = reinterpret_cast<const uint32_t*>(code.data());
 
@@ -1112,25 +2915,28 @@ void VulkanApp::createBuffer(VkDeviceSize          size,
     vkBindBufferMemory(device_, buffer, bufferMemory, 0);
 }
 
-void VulkanApp::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) const
+void VulkanApp::copyBuffer(VkCommandBuffer commandBuffer,
+                           VkBuffer        srcBuffer,
+                           VkDeviceSize    srcOffset,
+                           VkBuffer        dstBuffer,
+                           VkDeviceSize    size) const
 {
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
     VkBufferCopy copyRegion {};
-    copyRegion.srcOffset = 0;
+    copyRegion.srcOffset = srcOffset;
     copyRegion.dstOffset = 0;
     copyRegion.size      = size;
     vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
-
-    endSingleTimeCommands(commandBuffer);
 }
 
-void VulkanApp::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height) const
+void VulkanApp::copyBufferToImage(VkCommandBuffer commandBuffer,
+                                  VkBuffer        buffer,
+                                  VkDeviceSize    bufferOffset,
+                                  VkImage         image,
+                                  uint32_t        width,
+                                  uint32_t        height) const
 {
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
     VkBufferImageCopy region {};
-    region.bufferOffset                    = 0;
+    region.bufferOffset                    = bufferOffset;
     region.bufferRowLength                 = 0;
     region.bufferImageHeight               = 0;
     region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -1141,8 +2947,6 @@ void VulkanApp::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width
     region.imageExtent                     = {width, height, 1};
 
     vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-    endSingleTimeCommands(commandBuffer);
 }
 
 void VulkanApp::createImage(uint32_t              width,
@@ -1184,86 +2988,492 @@ void VulkanApp::createImage(uint32_t              width,
     allocInfo.allocationSize  = memRequirements.size;
     allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
 
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS)
+    if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to allocate image memory!");
+    }
+
+    vkBindImageMemory(device_, image, imageMemory, 0);
+}
+
+VkImageView
+VulkanApp::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels) const
+{
+    VkImageViewCreateInfo viewInfo {};
+    viewInfo.sType                           = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image                           = image;
+    viewInfo.viewType                        = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format                          = format;
+    viewInfo.subresourceRange.aspectMask     = aspectFlags;
+    viewInfo.components.r                    = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewInfo.components.g                    = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewInfo.components.b                    = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewInfo.components.a                    = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewInfo.subresourceRange.baseMipLevel   = 0;
+    viewInfo.subresourceRange.levelCount     = mipLevels;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount     = 1;
+
+    VkImageView imageView {};
+    if (vkCreateImageView(device_, &viewInfo, nullptr, &imageView) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create texture image view");
+    }
+
+    return imageView;
+}
+
+uint32_t VulkanApp::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+{
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice_, &memoryProperties);
+
+    for (uint32_t index = 0; index < memoryProperties.memoryTypeCount; index++)
+    {
+        if (((typeFilter & (1 << index)) != 0) &&
+            (memoryProperties.memoryTypes[index].propertyFlags & properties) == properties)
+        {
+            return index;
+        }
+    }
+
+    LOG_FATAL("Failed to find suitable memory type!");
+
+    return 0;
+}
+
+VkFormat VulkanApp::findDepthFormat() const
+{
+    return VulkanUtils::findSupportedFormat(
+        physicalDevice_,
+        {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+}
+
+void VulkanApp::createTransientAttachment(VkFormat             format,
+                                          VkImageUsageFlags    usage,
+                                          TransientAttachment& attachment) const
+{
+    VkImageCreateInfo imageInfo {};
+    imageInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType     = VK_IMAGE_TYPE_2D;
+    imageInfo.extent.width  = swapChainExtent_.width;
+    imageInfo.extent.height = swapChainExtent_.height;
+    imageInfo.extent.depth  = 1;
+    imageInfo.mipLevels     = 1;
+    imageInfo.arrayLayers   = 1;
+    imageInfo.format        = format;
+    imageInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage         = usage | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+    imageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
+
+    if (vkCreateImage(device_, &imageInfo, nullptr, &attachment.image) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create transient attachment!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device_, attachment.image, &memRequirements);
+
+    // tile based GPUs expose lazily allocated memory which only gets backed if the attachment has to leave the tile,
+    // desktop GPUs usually do not and get plain device local memory
+    uint32_t memoryTypeIndex = 0;
+    attachment.lazilyAllocated =
+        VulkanUtils::findMemoryTypeIndex(physicalDevice_,
+                                         memRequirements.memoryTypeBits,
+                                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT,
+                                         memoryTypeIndex);
+    if (!attachment.lazilyAllocated)
+    {
+        memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+
+    VkMemoryAllocateInfo allocInfo {};
+    allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize  = memRequirements.size;
+    allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+    if (vkAllocateMemory(device_, &allocInfo, nullptr, &attachment.memory) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to allocate transient attachment memory!");
+    }
+
+    vkBindImageMemory(device_, attachment.image, attachment.memory, 0);
+
+    attachment.view = createImageView(attachment.image, format, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+
+    VkDeviceSize committedBytes = memRequirements.size;
+    if (attachment.lazilyAllocated)
+    {
+        vkGetDeviceMemoryCommitment(device_, attachment.memory, &committedBytes);
+    }
+
+    LOG_INFO("Transient Attachment {}: {}, {} of {} bytes committed",
+             VK_TO_STRING(VkFormat, format),
+             attachment.lazilyAllocated ? "lazily allocated" : "device local",
+             committedBytes,
+             memRequirements.size);
+}
+
+void VulkanApp::destroyTransientAttachment(TransientAttachment& attachment) const
+{
+    vkDestroyImageView(device_, attachment.view, nullptr);
+    vkDestroyImage(device_, attachment.image, nullptr);
+    vkFreeMemory(device_, attachment.memory, nullptr);
+
+    attachment = {};
+}
+
+bool VulkanApp::usesRenderPass() const
+{
+    // subpass input attachments need a render pass, so deferred shading always takes that path
+    return deferredShading_ || !useDynamicRendering_;
+}
+
+void VulkanApp::requestTimestamps(uint32_t imageIndex)
+{
+    if (timestampQueryPool_ == VK_NULL_HANDLE)
+        return;
+
+    readbackManager_.requestQueries(timestampQueryPool_, imageIndex * 2, 2, [this](const VulkanReadbackResult& result) {
+        if (result.data == nullptr)
+            return;
+
+        std::array<uint64_t, 2> timestamps {};
+        std::memcpy(timestamps.data(), result.data, sizeof(timestamps));
+
+        const double gpuTimeMs = static_cast<double>(timestamps[1] - timestamps[0]) * timestampPeriod_ * 1e-6;
+        frameStatistics_.gpuTimeMs += gpuTimeMs;
+        frameStatistics_.gpuSampleCount++;
+        lastGpuTimeMs_ = static_cast<float>(gpuTimeMs);
+    });
+}
+
+void VulkanApp::requestFrameCapture()
+{
+    readbackManager_.requestRegion(
+        VulkanReadbackSource::SWAPCHAIN, 0, 0, UINT32_MAX, UINT32_MAX, [this](const VulkanReadbackResult& result) {
+            if (result.data == nullptr)
+            {
+                LOG_WARN("Frame {} could not be captured from a {} swap chain",
+                         result.frameNumber,
+                         VK_TO_STRING(VkFormat, swapChainImageFormat_));
+                return;
+            }
+
+            // only the copy out of the ring happens here, conversion and encoding run on the writer threads
+            const bool bgra = VulkanUtils::isBgraFormat(result.format);
+
+            ImageWriteRequest request {};
+            request.path   = fmt::format("{}/frame_{:06}.png", gCaptureDirectory, result.frameNumber);
+            request.width  = result.width;
+            request.height = result.height;
+            request.layout = bgra ? ImagePixelLayout::BGRA8 : ImagePixelLayout::RGBA8;
+            request.pixels.resize(result.size);
+            std::memcpy(request.pixels.data(), result.data, result.size);
+            captureWriter_.push(std::move(request));
+        });
+}
+
+void VulkanApp::uploadMaterials()
+{
+    const MaterialSystem::DirtyRange materials = materialSystem_.takeDirtyMaterials();
+    if (materials.count > 0)
+    {
+        uploadMaterialRange(sizeof(MaterialParameters) * materials.first,
+                            sizeof(MaterialParameters) * materials.count,
+                            materialSystem_.getParameters() + materials.first);
+    }
+
+    const MaterialSystem::DirtyRange objects = materialSystem_.takeDirtyObjects();
+    if (objects.count > 0)
+    {
+        uploadMaterialRange(materialTableOffset_ + sizeof(uint32_t) * objects.first,
+                            sizeof(uint32_t) * objects.count,
+                            materialSystem_.getObjectMaterials() + objects.first);
+    }
+}
+
+void VulkanApp::uploadMaterialRange(VkDeviceSize offset, VkDeviceSize size, const void* data)
+{
+    // the upload is submitted ahead of the frame that reads it, frames still in flight read the old contents
+    auto recordUpload = [this, offset, size](
+                            VkCommandBuffer commandBuffer, VkBuffer stagingBuffer, VkDeviceSize stagingOffset) {
+        VkBufferMemoryBarrier barrier {};
+        barrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask       = VK_ACCESS_SHADER_READ_BIT;
+        barrier.dstAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer              = materialBuffer_;
+        barrier.offset              = offset;
+        barrier.size                = size;
+
+        vkCmdPipelineBarrier(commandBuffer,
+                             MATERIAL_READ_STAGES,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             0,
+                             0,
+                             nullptr,
+                             1,
+                             &barrier,
+                             0,
+                             nullptr);
+
+        VkBufferCopy copyRegion {};
+        copyRegion.srcOffset = stagingOffset;
+        copyRegion.dstOffset = offset;
+        copyRegion.size      = size;
+        vkCmdCopyBuffer(commandBuffer, stagingBuffer, materialBuffer_, 1, &copyRegion);
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        vkCmdPipelineBarrier(commandBuffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             MATERIAL_READ_STAGES,
+                             0,
+                             0,
+                             nullptr,
+                             1,
+                             &barrier,
+                             0,
+                             nullptr);
+    };
+
+    uploadQueue_.submit(data, size, recordUpload);
+}
+
+void VulkanApp::updateFrameStatistics()
+{
+    const auto currentTime = std::chrono::high_resolution_clock::now();
+    if (frameStatistics_.frameCount > 0)
+    {
+        frameStatistics_.elapsedMs +=
+            std::chrono::duration<double, std::milli>(currentTime - frameStatistics_.lastFrameTime).count();
+    }
+    frameStatistics_.lastFrameTime = currentTime;
+    frameStatistics_.frameCount++;
+
+    if (frameStatistics_.elapsedMs < 1000.0)
+        return;
+
+    const double gpuTimeMs = frameStatistics_.gpuSampleCount > 0 ?
+                                 frameStatistics_.gpuTimeMs / frameStatistics_.gpuSampleCount :
+                                 0.0;
+    const VulkanSubmitStatistics  submitStatistics = submitManager_.takeStatistics();
+    const WorldStreamerStatistics worldStatistics  = worldStreamer_.getStatistics();
+    LOG_INFO("[{}] frame: {:.3f} ms, main pass gpu: {:.3f} ms, static command buffers recorded: {}, "
+             "queue submits: {} ({} batches), world cells: {} resident, {} loading, {:.1f} MiB",
+             deferredShading_ ? "deferred" : "forward",
+             frameStatistics_.elapsedMs / (frameStatistics_.frameCount - 1),
+             gpuTimeMs,
+             commandCache_.takeRecordCount(),
+             submitStatistics.submitCallCount,
+             submitStatistics.batchCount,
+             worldStatistics.residentCellCount,
+             worldStatistics.loadingCellCount,
+             static_cast<double>(worldStatistics.usedBytes) / (1024.0 * 1024.0));
+
+    frameStatistics_               = {};
+    frameStatistics_.lastFrameTime = currentTime;
+    frameStatistics_.frameCount    = 1;
+}
+
+void VulkanApp::updateUniformBuffer(uint32_t imageIndex, const FramePacket& packet)
+{
+    UniformBufferObject ubo {};
+    ubo.model = packet.model;
+    ubo.view  = packet.view;
+    ubo.proj  = getProjectionMatrix(swapChainExtent_.width / static_cast<float>(swapChainExtent_.height));
+
+    void* data {nullptr};
+    vkMapMemory(device_, uniformBuffersMemory_[imageIndex], 0, sizeof(ubo), 0, &data);
+    memcpy(data, &ubo, sizeof(ubo));
+    vkUnmapMemory(device_, uniformBuffersMemory_[imageIndex]);
+}
+
+void VulkanApp::cullStaticDraws(uint32_t imageIndex, const FramePacket& packet)
+{
+    // the props and the copies live in the space of the scene model matrix, culled with the matrices of the uniform
+    // buffer
+    const float     aspectRatio = swapChainExtent_.width / static_cast<float>(swapChainExtent_.height);
+    const glm::mat4 viewModel   = packet.view * packet.model;
+    const Frustum   frustum     = Frustum::fromViewProjection(getProjectionMatrix(aspectRatio) * viewModel);
+
+    StaticDrawLists& lists = staticDrawScratch_;
+    lists.props.clear();
+    for (const auto& [index, cell] : worldCells_)
+    {
+        cell->batch.cull(frustum, worldCullScratch_);
+        for (const StaticBatchDraw& draw : worldCullScratch_)
+        {
+            lists.props.push_back({index, draw});
+        }
+    }
+    farFieldBatch_.cull(frustum, lists.farFieldMeshes);
+
+    // visible copies beyond the impostor distance leave the mesh draws for the impostor runs, copies come out of the
+    // cull in index order since their index is the material of their group
+    const glm::vec3 eye       = glm::vec3(glm::inverse(viewModel)[3]);
+    size_t          meshCount = 0;
+    lists.impostors.clear();
+    for (const StaticBatchDraw& draw : lists.farFieldMeshes)
+    {
+        const uint32_t copy = farFieldBatch_.groups[draw.group].material;
+        if (!impostorRenderer_.isReady() || glm::distance(eye, farFieldCopies_[copy].center) <= gImpostorDistance)
+        {
+            lists.farFieldMeshes[meshCount++] = draw;
+        }
+        else if (!lists.impostors.empty() &&
+                 lists.impostors.back().firstInstance + lists.impostors.back().instanceCount == copy)
+        {
+            lists.impostors.back().instanceCount++;
+        }
+        else
+        {
+            lists.impostors.push_back({copy, 1});
+        }
+    }
+    lists.farFieldMeshes.resize(meshCount);
+
+    // the cached draws of the image are only re-recorded once what they cover changed
+    if (lists != staticDrawLists_[imageIndex])
     {
-        LOG_FATAL("Failed to allocate image memory!");
+        std::swap(staticDrawLists_[imageIndex], lists);
+        staticDrawVersions_[imageIndex]++;
     }
-
-    vkBindImageMemory(device_, image, imageMemory, 0);
 }
 
-VkImageView
-VulkanApp::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels) const
+void VulkanApp::updateSkinningPalettes(uint32_t imageIndex, const FramePacket& packet)
 {
-    VkImageViewCreateInfo viewInfo {};
-    viewInfo.sType                           = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-    viewInfo.image                           = image;
-    viewInfo.viewType                        = VK_IMAGE_VIEW_TYPE_2D;
-    viewInfo.format                          = format;
-    viewInfo.subresourceRange.aspectMask     = aspectFlags;
-    viewInfo.components.r                    = VK_COMPONENT_SWIZZLE_IDENTITY;
-    viewInfo.components.g                    = VK_COMPONENT_SWIZZLE_IDENTITY;
-    viewInfo.components.b                    = VK_COMPONENT_SWIZZLE_IDENTITY;
-    viewInfo.components.a                    = VK_COMPONENT_SWIZZLE_IDENTITY;
-    viewInfo.subresourceRange.baseMipLevel   = 0;
-    viewInfo.subresourceRange.levelCount     = mipLevels;
-    viewInfo.subresourceRange.baseArrayLayer = 0;
-    viewInfo.subresourceRange.layerCount     = 1;
+    if (!skinningPass_.isReady())
+        return;
 
-    VkImageView imageView {};
-    if (vkCreateImageView(device_, &viewInfo, nullptr, &imageView) != VK_SUCCESS)
+    // the instances stand in a ring around the scene, facing outwards
+    skinnedInstances_.resize(skinningPass_.getInstanceCount());
+    for (uint32_t instance = 0; instance < skinningPass_.getInstanceCount(); instance++)
     {
-        LOG_FATAL("Failed to create texture image view");
+        const float angle = glm::two_pi<float>() * static_cast<float>(instance) / skinningPass_.getInstanceCount();
+
+        AnimationInstance& animation = skinnedInstances_[instance];
+        animation.clip               = &skinnedMesh_.clip;
+        animation.time               = packet.animationTime + SKINNED_INSTANCE_PHASE * static_cast<float>(instance);
+        animation.transform          = glm::rotate(glm::mat4(1.0F), angle, glm::vec3(0.0F, 0.0F, 1.0F));
+        animation.transform          = glm::translate(animation.transform, glm::vec3(gSkinnedRingRadius, 0.0F, 0.0F));
     }
 
-    return imageView;
+    // written straight into the mapped palette buffer of the image, the image is not in flight anymore
+    SkeletalAnimation::evaluatePoses(
+        &jobSystem_, skinnedMesh_.skeleton, skinnedInstances_, skinningPass_.getPalette(imageIndex));
 }
 
-uint32_t VulkanApp::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+void VulkanApp::updateParticleParams(uint32_t imageIndex, const FramePacket& packet)
 {
-    VkPhysicalDeviceMemoryProperties memoryProperties;
-    vkGetPhysicalDeviceMemoryProperties(physicalDevice_, &memoryProperties);
+    if (!particleSystem_.isReady())
+        return;
 
-    for (uint32_t index = 0; index < memoryProperties.memoryTypeCount; index++)
+    // stepped by the animation clock, a paused scene freezes the particles
+    const float deltaTime = std::clamp(packet.animationTime - particleTime_, 0.0F, PARTICLE_MAX_STEP);
+    particleTime_         = packet.animationTime;
+
+    // the fraction of a particle left over is emitted with a later frame
+    particleEmitRemainder_ += deltaTime * gParticleEmitRate;
+    const auto emitCount = static_cast<uint32_t>(particleEmitRemainder_);
+    particleEmitRemainder_ -= static_cast<float>(emitCount);
+
+    const float aspectRatio = swapChainExtent_.width / static_cast<float>(swapChainExtent_.height);
+
+    // written straight into the mapped parameters of the image, the image is not in flight anymore
+    ParticleFrameParams* params = particleSystem_.getFrameParams(imageIndex);
+    params->view                = packet.view;
+    params->proj                = getProjectionMatrix(aspectRatio);
+    params->emitterPosition     = PARTICLE_EMITTER;
+    params->gravity             = PARTICLE_GRAVITY;
+    params->startColor          = PARTICLE_START_COLOR;
+    params->endColor            = PARTICLE_END_COLOR;
+    params->deltaTime           = deltaTime;
+    params->emitCount           = emitCount;
+    params->seed                = static_cast<uint32_t>(packet.frameNumber);
+    params->particleSize        = gParticleSize;
+    params->emitSpeed           = gParticleSpeed;
+    params->minLifetime         = gParticleMinLifetime;
+    params->maxLifetime         = gParticleMaxLifetime;
+    params->capacity            = particleSystem_.getCapacity();
+}
+
+void VulkanApp::updatePerfHud(uint32_t imageIndex, const FramePacket& packet)
+{
+    if (!hudRenderer_.isReady())
+        return;
+
+    // taken every frame, so a hidden overlay does not pile the uploads up for when it shows again
+    const VulkanUploadStatistics uploadStatistics = uploadQueue_.takeStatistics();
+
+    // the cpu time is that of the previous frame, this one is still being made
+    const auto currentTime = std::chrono::high_resolution_clock::now();
+    if (hudFrameCount_ > 0 && !packet.resumedFromIdle)
     {
-        if (((typeFilter & (1 << index)) != 0) &&
-            (memoryProperties.memoryTypes[index].propertyFlags & properties) == properties)
-        {
-            return index;
-        }
+        PerfHudSample sample {};
+        sample.frameMs     = std::chrono::duration<float, std::milli>(currentTime - lastHudFrameTime_).count();
+        sample.cpuMs       = lastCpuTimeMs_;
+        sample.gpuMs       = lastGpuTimeMs_;
+        sample.uploadCount = uploadStatistics.uploadCount;
+        sample.uploadBytes = uploadStatistics.byteCount;
+        perfHud_.addSample(sample);
     }
+    lastHudFrameTime_ = currentTime;
 
-    LOG_FATAL("Failed to find suitable memory type!");
+    if (hudFrameCount_ % gPerfHudMemoryQueryInterval == 0)
+    {
+        queryDeviceMemory(hudCounters_);
+    }
+    hudFrameCount_++;
 
-    return 0;
+    hudCounters_.drawCount = recordedDrawCounts_[imageIndex * 2];
+    if (deferredShading_)
+    {
+        hudCounters_.drawCount += recordedDrawCounts_[imageIndex * 2 + 1];
+    }
+    hudCounters_.streamedBytes = worldStreamer_.getStatistics().usedBytes;
+    perfHud_.setCounters(hudCounters_);
+
+    // written straight into the mapped vertex buffer of the image, the image is not in flight anymore
+    const uint32_t vertexCount =
+        packet.showPerfHud ? perfHud_.build({swapChainExtent_.width, swapChainExtent_.height},
+                                            hudRenderer_.getVertices(imageIndex),
+                                            hudRenderer_.getVertexCapacity()) :
+                             0;
+    hudRenderer_.setVertexCount(imageIndex, vertexCount);
 }
 
-VkFormat VulkanApp::findDepthFormat() const
+void VulkanApp::queryDeviceMemory(PerfHudCounters& counters) const
 {
-    return VulkanUtils::findSupportedFormat(
-        physicalDevice_,
-        {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
-        VK_IMAGE_TILING_OPTIMAL,
-        VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
-}
+    if (!memoryBudgetSupported_)
+        return;
 
-void VulkanApp::updateUniformBuffer(uint32_t imageIndex)
-{
-    static auto startTime   = std::chrono::high_resolution_clock::now();
-    const auto  currentTime = std::chrono::high_resolution_clock::now();
-    const float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties {};
+    budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
 
-    UniformBufferObject ubo {};
-    ubo.model = glm::rotate(glm::mat4(1.0F), time * glm::radians(90.0F), glm::vec3(0.0F, 0.0F, 1.0F));
-    ubo.view  = glm::lookAt(glm::vec3(2.0F, 2.0F, 2.0F), glm::vec3(0.0F, 0.0F, 0.0F), glm::vec3(0.0F, 0.0F, 1.0F));
-    ubo.proj  = glm::perspective(
-        glm::radians(45.0F), swapChainExtent_.width / static_cast<float>(swapChainExtent_.height), 0.1F, 10.0F);
-    ubo.proj[1][1] *= -1;
+    VkPhysicalDeviceMemoryProperties2 memoryProperties {};
+    memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    memoryProperties.pNext = &budgetProperties;
+    vkGetPhysicalDeviceMemoryProperties2(physicalDevice_, &memoryProperties);
 
-    void* data {nullptr};
-    vkMapMemory(device_, uniformBuffersMemory_[imageIndex], 0, sizeof(ubo), 0, &data);
-    memcpy(data, &ubo, sizeof(ubo));
-    vkUnmapMemory(device_, uniformBuffersMemory_[imageIndex]);
+    // the heaps the scene lives in, host memory the device can read does not count
+    counters.deviceMemoryUsage  = 0;
+    counters.deviceMemoryBudget = 0;
+    for (uint32_t heap = 0; heap < memoryProperties.memoryProperties.memoryHeapCount; heap++)
+    {
+        if ((memoryProperties.memoryProperties.memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) == 0)
+            continue;
+
+        counters.deviceMemoryUsage += budgetProperties.heapUsage[heap];
+        counters.deviceMemoryBudget += budgetProperties.heapBudget[heap];
+    }
 }
 
 VkCommandBuffer VulkanApp::beginSingleTimeCommands() const
@@ -1286,29 +3496,26 @@ VkCommandBuffer VulkanApp::beginSingleTimeCommands() const
     return commandBuffer;
 }
 
-void VulkanApp::endSingleTimeCommands(VkCommandBuffer commandBuffer) const
+void VulkanApp::endSingleTimeCommands(VkCommandBuffer commandBuffer)
 {
     vkEndCommandBuffer(commandBuffer);
 
-    VkSubmitInfo submitInfo {};
-    submitInfo.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers    = &commandBuffer;
+    VulkanSubmitBatch batch {};
+    batch.commandBuffers.push_back(commandBuffer);
 
-    vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(graphicsQueue_);
+    submitManager_.submit(graphicsQueue_, batch);
+    submitManager_.flushAndWait(graphicsQueue_);
 
     vkFreeCommandBuffers(device_, commandPool_, 1, &commandBuffer);
 }
 
-void VulkanApp::transitionImageLayout(VkImage       image,
-                                      VkFormat      format,
-                                      VkImageLayout oldLayout,
-                                      VkImageLayout newLayout,
-                                      uint32_t      mipLevels) const
+void VulkanApp::transitionImageLayout(VkCommandBuffer commandBuffer,
+                                      VkImage         image,
+                                      VkFormat        format,
+                                      VkImageLayout   oldLayout,
+                                      VkImageLayout   newLayout,
+                                      uint32_t        mipLevels) const
 {
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
     VkImageAspectFlags aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 
     if (newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
@@ -1368,15 +3575,14 @@ void VulkanApp::transitionImageLayout(VkImage       image,
     }
 
     vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
-
-    endSingleTimeCommands(commandBuffer);
 }
 
-void VulkanApp::generateMipmaps(VkImage  image,
-                                VkFormat imageFormat,
-                                int32_t  texWidth,
-                                int32_t  texHeight,
-                                uint32_t mipLevels)
+void VulkanApp::generateMipmaps(VkCommandBuffer commandBuffer,
+                                VkImage         image,
+                                VkFormat        imageFormat,
+                                int32_t         texWidth,
+                                int32_t         texHeight,
+                                uint32_t        mipLevels) const
 {
     // Check if image format supports linear blitting
     VkFormatProperties formatProperties;
@@ -1386,8 +3592,6 @@ void VulkanApp::generateMipmaps(VkImage  image,
         LOG_FATAL("Texture image format does not support linear blitting!");
     }
 
-    const VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
     VkImageMemoryBarrier barrier {};
     barrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.image                           = image;
@@ -1466,7 +3670,7 @@ void VulkanApp::generateMipmaps(VkImage  image,
             mipHeight /= 2;
     }
 
-    barrier.subresourceRange.baseMipLevel = mipLevels_ - 1;
+    barrier.subresourceRange.baseMipLevel = mipLevels - 1;
     barrier.oldLayout                     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
     barrier.newLayout                     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
     barrier.srcAccessMask                 = VK_ACCESS_TRANSFER_WRITE_BIT;
@@ -1482,95 +3686,629 @@ void VulkanApp::generateMipmaps(VkImage  image,
                          nullptr,
                          1,
                          &barrier);
+}
+
+Task<void> VulkanApp::loadSceneAssets()
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    // the texture comes from the material library when there is one, so it is only known once the mesh is parsed
+    MeshAsset mesh = co_await AssetLoader::loadMesh(assetExecutor_, MODEL_PATH);
+
+    const std::string texturePath = mesh.diffuseTextures.empty() ? TEXTURE_PATH : mesh.diffuseTextures.front();
+
+    // the far field takes its own copy of the mesh, before the scene buffers below take it apart
+    std::vector<Task<void>> tasks;
+    tasks.push_back(buildFarField(mesh, texturePath));
+
+    vertices_.resize(mesh.positions.size());
+    for (size_t index = 0; index < vertices_.size(); index++)
+    {
+        vertices_[index].pos      = mesh.positions[index];
+        vertices_[index].texCoord = mesh.texCoords[index];
+    }
+    indices_ = std::move(mesh.indices);
+
+    tasks.push_back(loadTexture(texturePath, textureImage_, textureImageMemory_, mipLevels_));
+    if (std::filesystem::exists(LIGHTMAP_PATH))
+    {
+        tasks.push_back(loadTexture(LIGHTMAP_PATH, lightmapImage_, lightmapImageMemory_, lightmapMipLevels_));
+    }
+    tasks.push_back(uploadBuffer(vertices_.data(),
+                                 sizeof(vertices_[0]) * vertices_.size(),
+                                 VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                 vertexBuffer_,
+                                 vertexBufferMemory_));
+    tasks.push_back(uploadBuffer(indices_.data(),
+                                 sizeof(indices_[0]) * indices_.size(),
+                                 VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                                 indexBuffer_,
+                                 indexBufferMemory_));
+    tasks.push_back(buildSceneBvh(std::move(mesh.positions)));
+    tasks.push_back(loadSkinnedAssets());
+    tasks.push_back(particleSystem_.initialize(uploadQueue_, gParticleCapacity, gEnableParticleSorting));
+    tasks.push_back(loadEnvironment());
+    tasks.push_back(loadHud());
+    co_await whenAll(std::move(tasks));
+
+    // the props of the world stream in once frames are drawn, only the shapes they are made of exist up front. A few
+    // shapes repeated many times, like the rocks and crates of a level
+    worldPropMeshes_ = {ProceduralMesh::createBox({0.04F, 0.04F, 0.04F}),
+                        ProceduralMesh::createBox({0.08F, 0.02F, 0.015F}),
+                        ProceduralMesh::createPrism(6, 0.025F, 0.12F)};
+
+    WorldStreamerSettings worldSettings {};
+    worldSettings.cellsPerSide       = gWorldCellsPerSide;
+    worldSettings.cellSize           = gWorldCellSize;
+    worldSettings.loadRadius         = gWorldLoadRadius;
+    worldSettings.unloadRadius       = gWorldUnloadRadius;
+    worldSettings.memoryBudget       = gWorldMemoryBudget;
+    worldSettings.maxConcurrentLoads = gWorldMaxConcurrentLoads;
+    worldStreamer_.configure(worldSettings);
+
+    LOG_INFO("Scene assets loaded in {:.2f} ms",
+             std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+}
+
+Task<void> VulkanApp::loadTexture(std::string     path,
+                                  VkImage&        image,
+                                  VkDeviceMemory& imageMemory,
+                                  uint32_t&       mipLevels)
+{
+    const ImageAsset asset = co_await AssetLoader::loadImage(assetExecutor_, std::move(path));
+
+    mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(asset.width, asset.height)))) + 1;
+
+    createImage(asset.width,
+                asset.height,
+                mipLevels,
+                VK_FORMAT_R8G8B8A8_SRGB,
+                VK_IMAGE_TILING_OPTIMAL,
+                VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                image,
+                imageMemory);
+
+    const auto recordUpload = [this, &asset, target = image, mipLevels](VkCommandBuffer commandBuffer,
+                                                                         VkBuffer        stagingBuffer,
+                                                                         VkDeviceSize    stagingOffset) {
+        transitionImageLayout(commandBuffer,
+                              target,
+                              VK_FORMAT_R8G8B8A8_SRGB,
+                              VK_IMAGE_LAYOUT_UNDEFINED,
+                              VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                              mipLevels);
+        copyBufferToImage(commandBuffer, stagingBuffer, stagingOffset, target, asset.width, asset.height);
+        generateMipmaps(commandBuffer,
+                        target,
+                        VK_FORMAT_R8G8B8A8_SRGB,
+                        static_cast<int32_t>(asset.width),
+                        static_cast<int32_t>(asset.height),
+                        mipLevels);
+    };
+    co_await uploadQueue_.upload(asset.pixels.data(), asset.pixels.size(), recordUpload);
+}
+
+Task<void> VulkanApp::uploadBuffer(const void*        data,
+                                   VkDeviceSize       size,
+                                   VkBufferUsageFlags usage,
+                                   VkBuffer&          buffer,
+                                   VkDeviceMemory&    bufferMemory)
+{
+    createBuffer(
+        size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, bufferMemory);
+
+    const auto recordUpload = [this, target = buffer, size](
+                                  VkCommandBuffer commandBuffer, VkBuffer stagingBuffer, VkDeviceSize stagingOffset) {
+        copyBuffer(commandBuffer, stagingBuffer, stagingOffset, target, size);
+    };
+    co_await uploadQueue_.upload(data, size, recordUpload);
+}
+
+Task<void> VulkanApp::buildSceneBvh(std::vector<glm::vec3> positions)
+{
+    co_await assetExecutor_.schedule();
+
+    const auto buildStart = std::chrono::high_resolution_clock::now();
+    sceneBvh_.build(positions, indices_, &jobSystem_);
+    LOG_INFO("Scene bvh: {} triangles, {} nodes, built in {:.2f} ms on {} threads",
+             sceneBvh_.getTriangleCount(),
+             sceneBvh_.getBvh().getStatistics().nodeCount,
+             std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - buildStart).count(),
+             jobSystem_.getThreadCount());
+}
 
-    endSingleTimeCommands(commandBuffer);
+Task<void> VulkanApp::loadSkinnedAssets()
+{
+    co_await assetExecutor_.schedule();
+
+    skinnedMesh_ = ProceduralMesh::createTentacle(
+        gTentacleJointCount, gTentacleRingCount, gTentacleSideCount, gTentacleHeight, gTentacleRadius);
+
+    std::vector<Task<void>> tasks;
+    tasks.push_back(skinningPass_.uploadMesh(uploadQueue_,
+                                             skinnedMesh_.vertices.data(),
+                                             static_cast<uint32_t>(skinnedMesh_.vertices.size()),
+                                             skinnedMesh_.skeleton.getJointCount(),
+                                             gSkinnedInstanceCount));
+    tasks.push_back(uploadBuffer(skinnedMesh_.indices.data(),
+                                 sizeof(skinnedMesh_.indices[0]) * skinnedMesh_.indices.size(),
+                                 VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                                 skinnedIndexBuffer_,
+                                 skinnedIndexBufferMemory_));
+    co_await whenAll(std::move(tasks));
 }
 
-void VulkanApp::loadModel()
+Task<void> VulkanApp::buildFarField(MeshAsset mesh, std::string texturePath)
 {
-    tinyobj::attrib_t                attrib;
-    std::vector<tinyobj::shape_t>    shapes;
-    std::vector<tinyobj::material_t> materials;
-    std::string                      warn;
-    std::string                      err;
+    // decoded a second time, the one of the scene goes straight to the gpu
+    const ImageAsset texture = co_await AssetLoader::loadImage(assetExecutor_, std::move(texturePath));
+
+    const auto bakeStart = std::chrono::high_resolution_clock::now();
 
-    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, MODEL_PATH.c_str()))
+    ImpostorBakeSettings bakeSettings {};
+    bakeSettings.framesPerSide   = gImpostorFramesPerSide;
+    bakeSettings.frameResolution = gImpostorFrameResolution;
+    const ImpostorAtlas atlas    = ImpostorBaker::bake(mesh, texture, bakeSettings, &jobSystem_);
+
+    const double bakeMs =
+        std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - bakeStart).count();
+
+    std::mt19937                          random(FAR_FIELD_SEED);
+    std::uniform_real_distribution<float> unit(0.0F, 1.0F);
+
+    std::vector<StaticMeshInstance> instances(gFarFieldCopyCount);
+    farFieldCopies_.resize(gFarFieldCopyCount);
+    for (uint32_t copy = 0; copy < gFarFieldCopyCount; copy++)
     {
-        LOG_FATAL("{} {}", warn, err);
+        const float     radius   = std::sqrt(glm::mix(gFarFieldInnerRadius * gFarFieldInnerRadius,
+                                                    gFarFieldOuterRadius * gFarFieldOuterRadius,
+                                                    unit(random)));
+        const float     angle    = glm::two_pi<float>() * unit(random);
+        const glm::vec3 position = radius * glm::vec3(std::cos(angle), std::sin(angle), 0.0F);
+        const float     yaw      = glm::two_pi<float>() * unit(random);
+        const float     scale    = glm::mix(FAR_FIELD_MIN_SCALE, FAR_FIELD_MAX_SCALE, unit(random));
+
+        // a group of its own for every copy, so the culled draws name the copies they cover
+        StaticMeshInstance& instance = instances[copy];
+        instance.mesh                = &mesh;
+        instance.material            = copy;
+        instance.transform           = glm::translate(glm::mat4(1.0F), position);
+        instance.transform           = glm::rotate(instance.transform, yaw, glm::vec3(0.0F, 0.0F, 1.0F));
+        instance.transform           = glm::scale(instance.transform, glm::vec3(scale));
+
+        ImpostorInstance& impostor = farFieldCopies_[copy];
+        impostor.center            = glm::vec3(instance.transform * glm::vec4(atlas.center, 1.0F));
+        impostor.radius            = atlas.radius * scale;
+        impostor.yaw               = yaw;
+        impostor.objectId          = FAR_FIELD_OBJECT_ID_BASE + copy;
     }
 
-    for (const auto& shape : shapes)
+    farFieldBatch_ = StaticMeshBatcher::build(instances, {}, &jobSystem_);
+
+    const StaticBatchStatistics statistics = farFieldBatch_.getStatistics();
+    LOG_INFO("Far field: {} copies of {} vertices, impostor atlas of {}x{} views baked in {:.2f} ms",
+             statistics.instanceCount,
+             mesh.positions.size(),
+             atlas.framesPerSide,
+             atlas.framesPerSide,
+             bakeMs);
+
+    if (farFieldBatch_.isEmpty())
+        co_return;
+
+    std::vector<Task<void>> tasks;
+    tasks.push_back(uploadBuffer(farFieldBatch_.vertices.data(),
+                                 sizeof(farFieldBatch_.vertices[0]) * farFieldBatch_.vertices.size(),
+                                 VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                 farFieldVertexBuffer_,
+                                 farFieldVertexBufferMemory_));
+    tasks.push_back(uploadBuffer(farFieldBatch_.indices.data(),
+                                 sizeof(farFieldBatch_.indices[0]) * farFieldBatch_.indices.size(),
+                                 VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                                 farFieldIndexBuffer_,
+                                 farFieldIndexBufferMemory_));
+    tasks.push_back(impostorRenderer_.upload(uploadQueue_, atlas, farFieldCopies_));
+    co_await whenAll(std::move(tasks));
+}
+
+Task<void> VulkanApp::loadEnvironment()
+{
+    EnvironmentMap source;
+    if (std::filesystem::exists(gEnvironmentMapPath))
     {
-        for (const auto& index : shape.mesh.indices)
-        {
-            Vertex vertex {};
-            vertex.pos = {attrib.vertices[3 * index.vertex_index + 0],
-                          attrib.vertices[3 * index.vertex_index + 1],
-                          attrib.vertices[3 * index.vertex_index + 2]};
+        source = EnvironmentPrefilter::fromImage(co_await AssetLoader::loadImage(assetExecutor_, gEnvironmentMapPath));
+    }
+    else
+    {
+        co_await assetExecutor_.schedule();
+        source = EnvironmentPrefilter::createSky(SKY_WIDTH, SKY_HEIGHT);
+    }
+
+    environmentLighting_ = EnvironmentPrefilter::loadOrPrefilter(
+        source, EnvironmentPrefilterSettings {}, gEnvironmentCacheDirectory, &jobSystem_);
+
+    EnvironmentUniforms uniforms {};
+    for (size_t index = 0; index < environmentLighting_.irradiance.size(); index++)
+    {
+        uniforms.irradiance[index] = glm::vec4(environmentLighting_.irradiance[index], 0.0F);
+    }
+
+    // the buffer is only read by frames recorded after the assets are loaded
+    void* data = nullptr;
+    vkMapMemory(device_, environmentBufferMemory_, 0, sizeof(uniforms), 0, &data);
+    memcpy(data, &uniforms, sizeof(uniforms));
+    vkUnmapMemory(device_, environmentBufferMemory_);
+}
+
+Task<void> VulkanApp::loadHud()
+{
+    co_await assetExecutor_.schedule();
+    const SdfFontAtlas atlas = SdfFont::create();
+    perfHud_.setFont(atlas);
+    co_await hudRenderer_.upload(uploadQueue_, atlas);
+}
+
+Task<void> VulkanApp::loadWorldCell(uint32_t cell)
+{
+    co_await assetExecutor_.schedule();
+
+    auto worldCell   = std::make_unique<WorldCell>();
+    worldCell->index = cell;
+
+    std::seed_seq                         seed {STATIC_PROP_SEED, cell};
+    std::mt19937                          random(seed);
+    std::uniform_real_distribution<float> unit(0.0F, 1.0F);
+
+    const glm::vec2 cellMin = worldStreamer_.getCellMin(cell);
+
+    std::vector<StaticMeshInstance> instances;
+    instances.reserve(gStaticPropsPerCell);
+    for (uint32_t prop = 0; prop < gStaticPropsPerCell; prop++)
+    {
+        const glm::vec2 position = cellMin + glm::vec2(unit(random), unit(random)) * worldStreamer_.getCellSize();
+        const float     rotation = glm::two_pi<float>() * unit(random);
+        const float     scale    = glm::mix(0.6F, 1.4F, unit(random));
+        const auto      mesh     = static_cast<uint32_t>(random() % worldPropMeshes_.size());
+        const auto      material = static_cast<uint32_t>(random() % gStaticPropMaterialCount);
+        if (glm::length(position) < gStaticPropInnerRadius)
+            continue;
+
+        StaticMeshInstance& instance = instances.emplace_back();
+        instance.mesh                = &worldPropMeshes_[mesh];
+        instance.material            = material;
+        instance.transform           = glm::translate(glm::mat4(1.0F), glm::vec3(position, 0.0F));
+        instance.transform           = glm::rotate(instance.transform, rotation, glm::vec3(0.0F, 0.0F, 1.0F));
+        instance.transform           = glm::scale(instance.transform, glm::vec3(scale));
+    }
 
-            vertex.texCoord = {attrib.texcoords[2 * index.texcoord_index + 0],
-                               1.0f - attrib.texcoords[2 * index.texcoord_index + 1]};
+    // without the job system, its loops would stall the render thread posing the skinned instances meanwhile
+    StaticBatchSettings settings {};
+    settings.maxChunkVertices = gStaticBatchChunkVertices;
+    worldCell->batch          = StaticMeshBatcher::build(instances, settings);
 
-            vertex.color = {1.0F, 1.0F, 1.0F};
+    StaticBatch& batch = worldCell->batch;
+    if (!batch.isEmpty())
+    {
+        const VkDeviceSize vertexBytes = sizeof(batch.vertices[0]) * batch.vertices.size();
+        const VkDeviceSize indexBytes  = sizeof(batch.indices[0]) * batch.indices.size();
+        worldCell->bytes               = vertexBytes + indexBytes;
+
+        std::vector<Task<void>> tasks;
+        tasks.push_back(uploadBuffer(batch.vertices.data(),
+                                     vertexBytes,
+                                     VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                     worldCell->vertexBuffer,
+                                     worldCell->vertexBufferMemory));
+        tasks.push_back(uploadBuffer(batch.indices.data(),
+                                     indexBytes,
+                                     VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                                     worldCell->indexBuffer,
+                                     worldCell->indexBufferMemory));
+        co_await whenAll(std::move(tasks));
+
+        // culling only reads the chunks and groups, the geometry lives on the gpu from here on
+        batch.vertices = {};
+        batch.indices  = {};
+    }
+
+    std::lock_guard<std::mutex> lock(loadedWorldCellsMutex_);
+    loadedWorldCells_.push_back(std::move(worldCell));
+}
+
+void VulkanApp::streamWorld(const FramePacket& packet)
+{
+    bool residencyChanged = collectWorldCells();
+
+    // decided in the space of the scene, where the cells are laid out
+    const glm::vec3 eye = glm::vec3(glm::inverse(packet.view * packet.model)[3]);
+    worldStreamer_.update(glm::vec2(eye), worldRequests_);
+
+    for (const uint32_t index : worldRequests_.unloads)
+    {
+        const auto iterator = worldCells_.find(index);
+
+        std::unique_ptr<WorldCell> cell = std::move(iterator->second);
+        worldCells_.erase(iterator);
+
+        // the slots may be handed out again right away, nothing recorded from here on names them
+        rhiBackend_.destroyBuffer(cell->vertexBufferHandle);
+        rhiBackend_.destroyBuffer(cell->indexBufferHandle);
+        cell->retireFrame = packet.frameNumber;
+        retiredWorldCells_.push_back(std::move(cell));
+        residencyChanged = true;
+    }
+
+    for (const uint32_t index : worldRequests_.loads)
+    {
+        spawn(loadWorldCell(index));
+    }
+
+    // the frames before the retire frame may still be in flight, the fence of the oldest one was waited for already
+    std::erase_if(retiredWorldCells_, [this, &packet](const std::unique_ptr<WorldCell>& cell) {
+        if (packet.frameNumber < cell->retireFrame + MAX_FRAMES_IN_FLIGHT)
+            return false;
 
-            vertices_.push_back(vertex);
-            indices_.push_back(static_cast<uint32_t>(indices_.size()));
+        destroyWorldCell(*cell);
+        return true;
+    });
+
+    // a cell that unloaded and came back has new buffers behind the same draws, so any change re-records every image
+    if (residencyChanged)
+    {
+        for (uint64_t& version : staticDrawVersions_)
+        {
+            version++;
         }
     }
+
+    worldStreaming_ = worldStreamer_.isLoading() || !retiredWorldCells_.empty();
+}
+
+bool VulkanApp::collectWorldCells()
+{
+    std::vector<std::unique_ptr<WorldCell>> loaded;
+    {
+        std::lock_guard<std::mutex> lock(loadedWorldCellsMutex_);
+        loaded.swap(loadedWorldCells_);
+    }
+
+    for (std::unique_ptr<WorldCell>& cell : loaded)
+    {
+        worldStreamer_.finishLoad(cell->index, cell->bytes);
+        cell->vertexBufferHandle = rhiBackend_.importBuffer(cell->vertexBuffer);
+        cell->indexBufferHandle  = rhiBackend_.importBuffer(cell->indexBuffer);
+
+        const uint32_t index = cell->index;
+        worldCells_.emplace(index, std::move(cell));
+    }
+
+    return !loaded.empty();
+}
+
+void VulkanApp::destroyWorldCell(WorldCell& cell) const
+{
+    vkDestroyBuffer(device_, cell.indexBuffer, nullptr);
+    vkFreeMemory(device_, cell.indexBufferMemory, nullptr);
+
+    vkDestroyBuffer(device_, cell.vertexBuffer, nullptr);
+    vkFreeMemory(device_, cell.vertexBufferMemory, nullptr);
+}
+
+void VulkanApp::drainWorldStreaming()
+{
+    // the render thread is gone, this thread submits the uploads the remaining loads wait for
+    while (worldStreamer_.isLoading())
+    {
+        uploadQueue_.pump();
+        collectWorldCells();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void VulkanApp::pickAtCursor()
+{
+    int width  = 0;
+    int height = 0;
+    glfwGetWindowSize(window_, &width, &height);
+    if (width == 0 || height == 0)
+        return;
+
+    double cursorX = 0.0;
+    double cursorY = 0.0;
+    glfwGetCursorPos(window_, &cursorX, &cursorY);
+
+    if (gEnableObjectIdBuffer)
+    {
+        // the cursor is in screen coordinates, which only match pixels without content scaling
+        int framebufferWidth  = 0;
+        int framebufferHeight = 0;
+        glfwGetFramebufferSize(window_, &framebufferWidth, &framebufferHeight);
+        const auto pixelX = static_cast<int32_t>(cursorX * framebufferWidth / width);
+        const auto pixelY = static_cast<int32_t>(cursorY * framebufferHeight / height);
+
+        readbackManager_.requestRegion(
+            VulkanReadbackSource::OBJECT_ID, pixelX, pixelY, 1, 1, [](const VulkanReadbackResult& result) {
+                uint32_t texel[2] = {0, 0};
+                if (result.data != nullptr)
+                {
+                    std::memcpy(texel, result.data, sizeof(texel));
+                }
+
+                if (texel[0] != 0)
+                {
+                    LOG_INFO("Picked object {} triangle {} in frame {}", texel[0], texel[1], result.frameNumber);
+                }
+                else
+                {
+                    LOG_INFO("Picked nothing in frame {}", result.frameNumber);
+                }
+            });
+        requestRedraw(REDRAW_SCENE);
+        return;
+    }
+
+    // the projection flips y, so window y grows in the same direction as ndc y. The ray is traced in model space
+    const glm::mat4 inverseTransform = glm::inverse(getProjectionMatrix(static_cast<float>(width) / height) *
+                                                    camera_.getViewMatrix() * getModelMatrix());
+    const glm::vec2 ndc {static_cast<float>(cursorX / width) * 2.0F - 1.0F,
+                         static_cast<float>(cursorY / height) * 2.0F - 1.0F};
+    const glm::vec4 nearPoint = inverseTransform * glm::vec4(ndc, 0.0F, 1.0F);
+    const glm::vec4 farPoint  = inverseTransform * glm::vec4(ndc, 1.0F, 1.0F);
+
+    Ray ray {};
+    ray.origin    = glm::vec3(nearPoint) / nearPoint.w;
+    ray.direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - ray.origin);
+
+    RayHit hit {};
+    if (sceneBvh_.raycast(ray, hit))
+    {
+        LOG_INFO("Picked triangle {} at distance {:.3f}", hit.triangle, hit.distance);
+    }
+    else
+    {
+        LOG_INFO("Picked nothing");
+    }
+}
+
+glm::mat4 VulkanApp::getModelMatrix() const
+{
+    return glm::rotate(glm::mat4(1.0F), animationTime_ * glm::radians(90.0F), glm::vec3(0.0F, 0.0F, 1.0F));
+}
+
+glm::mat4 VulkanApp::getProjectionMatrix(float aspectRatio)
+{
+    glm::mat4 projection = glm::perspective(glm::radians(45.0F), aspectRatio, 0.1F, 10.0F);
+    projection[1][1] *= -1;
+    return projection;
 }
 
-void VulkanApp::drawFrame()
+void VulkanApp::drawFrame(const FramePacket& packet)
 {
-    vkWaitForFences(device_, 1, &inFlightFences_[currentFrameIndex_], VK_TRUE, UINT16_MAX);
+    if (packet.deferredShading != deferredShading_)
+    {
+        deferredShading_   = packet.deferredShading;
+        renderPathChanged_ = true;
+    }
+    if (packet.resumedFromIdle)
+    {
+        // the gap since the previous frame was idle time, not frame time
+        frameStatistics_ = {};
+    }
+    framebufferExtent_ = {packet.framebufferWidth, packet.framebufferHeight};
+    frameBufferResized_ |= packet.framebufferResized;
 
-    uint32_t imageIndex {0};
-    vkAcquireNextImageKHR(
-        device_, swapChain_, UINT64_MAX, imageAvailableSemaphores_[currentFrameIndex_], VK_NULL_HANDLE, &imageIndex);
+    if (packet.traceFramesLeft == gTraceCaptureFrameCount)
+    {
+        beginTraceCapture();
+    }
+
+    // the readbacks, the material ring and the retired world cells below all rely on the frame having finished
+    submitManager_.waitForFence(inFlightFences_[currentFrameIndex_]);
+    // the cpu time of the hud leaves out the waits on the gpu and the swap chain
+    auto cpuStartTime = std::chrono::high_resolution_clock::now();
+    readbackManager_.collect(static_cast<uint32_t>(currentFrameIndex_));
+    uploadMaterials();
+    uploadQueue_.pump();
+    streamWorld(packet);
+
+    const auto acquireStartTime = std::chrono::high_resolution_clock::now();
+    uint32_t   imageIndex {0};
+    {
+        // the submit thread may be presenting into the same swapchain
+        const auto swapchainLock = submitManager_.lockSwapchain();
+        vkAcquireNextImageKHR(device_,
+                              swapChain_,
+                              UINT64_MAX,
+                              imageAvailableSemaphores_[currentFrameIndex_],
+                              VK_NULL_HANDLE,
+                              &imageIndex);
+    }
 
     // Check if a previous frame is using this image (i.e. there is its fence to wait on)
     if (imagesInFlight_[imageIndex] != VK_NULL_HANDLE)
     {
-        vkWaitForFences(device_, 1, &imagesInFlight_[imageIndex], VK_TRUE, UINT64_MAX);
+        submitManager_.waitForFence(imagesInFlight_[imageIndex]);
+    }
+    cpuStartTime += std::chrono::high_resolution_clock::now() - acquireStartTime;
+
+    // a trace has to contain the whole frame, not only what fell out of the cache
+    if (traceWriter_.isCapturing())
+    {
+        commandCache_.invalidate();
+        traceWriter_.beginFrame();
     }
+
+    // only re-records what was invalidated, a static scene submits the same command buffer every frame
+    cullStaticDraws(imageIndex, packet);
+    recordCommandBuffer(imageIndex);
     // Mark the image as now being in use by this frame
     imagesInFlight_[imageIndex] = inFlightFences_[currentFrameIndex_];
 
-    VkSemaphore          waitSemaphores[]   = {imageAvailableSemaphores_[currentFrameIndex_]};
-    VkSemaphore          signalSemaphores[] = {renderFinishedSemaphores_[currentFrameIndex_]};
-    VkPipelineStageFlags waitStages[]       = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-
     vkResetFences(device_, 1, &inFlightFences_[currentFrameIndex_]);
 
-    updateUniformBuffer(imageIndex);
+    updateUniformBuffer(imageIndex, packet);
+    updateSkinningPalettes(imageIndex, packet);
+    updateParticleParams(imageIndex, packet);
+    updatePerfHud(imageIndex, packet);
 
-    VkSubmitInfo submitInfo {};
-    submitInfo.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.waitSemaphoreCount   = 1;
-    submitInfo.pWaitSemaphores      = waitSemaphores;
-    submitInfo.pWaitDstStageMask    = waitStages;
-    submitInfo.commandBufferCount   = 1;
-    submitInfo.pCommandBuffers      = &commandBuffers_[imageIndex];
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores    = signalSemaphores;
+    // the frame and its readback copies go out in one vkQueueSubmit. Uploads are not part of it, the upload queue
+    // flushes its batches separately with fences of their own
+    frameBatch_.waitSemaphores.assign(1, imageAvailableSemaphores_[currentFrameIndex_]);
+    frameBatch_.waitStages.assign(1, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+    frameBatch_.commandBuffers.assign(1, commandBuffers_[imageIndex]);
+
+    requestTimestamps(imageIndex);
+    if (packet.captureFramesLeft > 0)
+    {
+        requestFrameCapture();
+    }
 
-    if (vkQueueSubmit(graphicsQueue_, 1, &submitInfo, inFlightFences_[currentFrameIndex_]) != VK_SUCCESS)
+    // the copies run after the main pass, which left the id buffer in TRANSFER_SRC_OPTIMAL and the swap chain image
+    // ready to present
+    VulkanReadbackImages readbackImages {};
+    if (gEnableObjectIdBuffer)
+    {
+        readbackImages[static_cast<size_t>(VulkanReadbackSource::OBJECT_ID)] = {objectIdImage_,
+                                                                                swapChainExtent_,
+                                                                                gObjectIdFormat,
+                                                                                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                                                                OBJECT_ID_TEXEL_SIZE};
+    }
+    if (swapChainReadable_ && VulkanUtils::isRgba8Format(swapChainImageFormat_))
+    {
+        readbackImages[static_cast<size_t>(VulkanReadbackSource::SWAPCHAIN)] = {swapChainImages_[imageIndex],
+                                                                                swapChainExtent_,
+                                                                                swapChainImageFormat_,
+                                                                                VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                                                                                4};
+    }
+    const VkCommandBuffer readbackCommandBuffer = readbackManager_.recordCopies(
+        static_cast<uint32_t>(currentFrameIndex_), packet.frameNumber, readbackImages);
+    if (readbackCommandBuffer != VK_NULL_HANDLE)
     {
-        LOG_FATAL("Failed to submit draw command buffer");
+        frameBatch_.commandBuffers.push_back(readbackCommandBuffer);
     }
+    frameBatch_.signalSemaphores.assign(1, renderFinishedSemaphores_[currentFrameIndex_]);
+
+    submitManager_.submit(graphicsQueue_, frameBatch_);
+    submitManager_.flush(graphicsQueue_, inFlightFences_[currentFrameIndex_]);
+    submitManager_.present(presentQueue_, swapChain_, imageIndex, renderFinishedSemaphores_[currentFrameIndex_]);
 
-    VkSwapchainKHR swapChains[] = {swapChain_};
+    // with a submit thread this is the result of the previous present, a stale swapchain is caught one frame later
+    const VkResult presentResult = submitManager_.takePresentResult();
+    lastCpuTimeMs_ =
+        std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - cpuStartTime).count();
+    updateFrameStatistics();
 
-    VkPresentInfoKHR presentInfo {};
-    presentInfo.sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-    presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores    = signalSemaphores;
-    presentInfo.swapchainCount     = 1;
-    presentInfo.pSwapchains        = swapChains;
-    presentInfo.pImageIndices      = &imageIndex;
-    presentInfo.pResults           = nullptr;
+    if (traceWriter_.isCapturing() && packet.traceFramesLeft <= 1)
+    {
+        traceWriter_.end();
+        LOG_INFO("Captured {} frames into {}", traceWriter_.getFrameCount(), gTraceCapturePath);
+    }
 
-    const VkResult presentResult = vkQueuePresentKHR(presentQueue_, &presentInfo);
-    if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR || frameBufferResized_)
+    if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR || frameBufferResized_ ||
+        renderPathChanged_)
     {
         frameBufferResized_ = false;
         recreateSwapChain();
@@ -1583,6 +4321,104 @@ void VulkanApp::drawFrame()
     currentFrameIndex_ = (currentFrameIndex_ + 1) % MAX_FRAMES_IN_FLIGHT;
 }
 
+void VulkanApp::requestRedraw(uint32_t reasons)
+{
+    redrawReasons_ |= reasons;
+}
+
+bool VulkanApp::needsRedraw() const
+{
+    // a running capture needs consecutive frames and streamed cells only show up in a frame drawn after they finished
+    // loading
+    return redrawReasons_ != REDRAW_NONE || traceFramesPending_ > 0 || captureFramesPending_ > 0 ||
+           readbackManager_.hasPendingRequests() || worldStreaming_;
+}
+
+void VulkanApp::advanceAnimation()
+{
+    const auto  currentTime = std::chrono::high_resolution_clock::now();
+    const float deltaTime =
+        std::chrono::duration<float, std::chrono::seconds::period>(currentTime - lastAnimationTime_).count();
+    lastAnimationTime_ = currentTime;
+
+    if (!animating_)
+        return;
+
+    animationTime_ += deltaTime;
+    requestRedraw(REDRAW_SCENE);
+}
+
+void VulkanApp::advanceCamera()
+{
+    const auto  currentTime = std::chrono::high_resolution_clock::now();
+    const float deltaTime   = std::min(
+        std::chrono::duration<float, std::chrono::seconds::period>(currentTime - lastCameraTime_).count(),
+        CAMERA_MAX_STEP);
+    lastCameraTime_ = currentTime;
+
+    glm::vec2 input {0.0F};
+    input.y += glfwGetKey(window_, GLFW_KEY_W) == GLFW_PRESS ? 1.0F : 0.0F;
+    input.y -= glfwGetKey(window_, GLFW_KEY_S) == GLFW_PRESS ? 1.0F : 0.0F;
+    input.x += glfwGetKey(window_, GLFW_KEY_D) == GLFW_PRESS ? 1.0F : 0.0F;
+    input.x -= glfwGetKey(window_, GLFW_KEY_A) == GLFW_PRESS ? 1.0F : 0.0F;
+    if (input == glm::vec2(0.0F))
+        return;
+
+    // the target moves over the ground along the view direction and sideways to it, faster when zoomed out
+    const glm::vec2 forward = -glm::vec2(std::cos(camera_.yaw), std::sin(camera_.yaw));
+    const glm::vec2 right {forward.y, -forward.x};
+    const glm::vec2 step = glm::normalize(forward * input.y + right * input.x) * gCameraPanSpeed * camera_.distance;
+    camera_.target += glm::vec3(step * deltaTime, 0.0F);
+    requestRedraw(REDRAW_CAMERA);
+}
+
+void VulkanApp::submitFramePacket()
+{
+    // blocks while the render thread still owns both packets
+    FramePacket* packet = framePackets_.acquireWrite();
+    if (packet == nullptr)
+        return;
+
+    int width  = 0;
+    int height = 0;
+    glfwGetFramebufferSize(window_, &width, &height);
+
+    packet->model = getModelMatrix();
+    packet->view  = camera_.getViewMatrix();
+
+    packet->animationTime = animationTime_;
+
+    packet->framebufferWidth   = static_cast<uint32_t>(width);
+    packet->framebufferHeight  = static_cast<uint32_t>(height);
+    packet->framebufferResized = windowResized_;
+    packet->deferredShading    = deferredShadingRequested_;
+    packet->resumedFromIdle    = idleSinceLastPacket_;
+    packet->showPerfHud        = showPerfHud_;
+    packet->traceFramesLeft    = traceFramesPending_;
+    packet->captureFramesLeft  = captureFramesPending_;
+
+    framePackets_.publish();
+
+    // the packet reflects every change so far, anything arriving from here on needs another one
+    windowResized_       = false;
+    idleSinceLastPacket_ = false;
+    redrawReasons_       = REDRAW_NONE;
+    if (traceFramesPending_ > 0)
+    {
+        traceFramesPending_--;
+    }
+    if (captureFramesPending_ > 0)
+    {
+        captureFramesPending_--;
+    }
+}
+
+glm::mat4 OrbitCamera::getViewMatrix() const
+{
+    const glm::vec3 direction {std::cos(pitch) * std::cos(yaw), std::cos(pitch) * std::sin(yaw), std::sin(pitch)};
+    return glm::lookAt(target + direction * distance, target, glm::vec3(0.0F, 0.0F, 1.0F));
+}
+
 VkVertexInputBindingDescription Vertex::getBindingDescription()
 {
     VkVertexInputBindingDescription bindingDescription {};
@@ -1593,9 +4429,9 @@ VkVertexInputBindingDescription Vertex::getBindingDescription()
     return bindingDescription;
 }
 
-std::array<VkVertexInputAttributeDescription, 3> Vertex::getAttributeDescriptions()
+std::array<VkVertexInputAttributeDescription, 2> Vertex::getAttributeDescriptions()
 {
-    std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions {};
+    std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions {};
 
     attributeDescriptions[0].binding  = 0;
     attributeDescriptions[0].location = 0;
@@ -1604,13 +4440,8 @@ std::array<VkVertexInputAttributeDescription, 3> Vertex::getAttributeDescription
 
     attributeDescriptions[1].binding  = 0;
     attributeDescriptions[1].location = 1;
-    attributeDescriptions[1].format   = VK_FORMAT_R32G32B32_SFLOAT;
-    attributeDescriptions[1].offset   = offsetof(Vertex, color);
-
-    attributeDescriptions[2].binding  = 0;
-    attributeDescriptions[2].location = 2;
-    attributeDescriptions[2].format   = VK_FORMAT_R32G32_SFLOAT;
-    attributeDescriptions[2].offset   = offsetof(Vertex, texCoord);
+    attributeDescriptions[1].format   = VK_FORMAT_R32G32_SFLOAT;
+    attributeDescriptions[1].offset   = offsetof(Vertex, texCoord);
 
     return attributeDescriptions;
 }
@@ -1,22 +1,53 @@
 #pragma once
 
+#include "foundation/async/task.h"
+#include "foundation/async/task_executor.h"
+#include "foundation/image/image_write_queue.h"
+#include "foundation/job/job_system.h"
+#include "foundation/spatial/mesh_bvh.h"
+#include "render/asset/environment_prefilter.h"
+#include "render/asset/static_mesh_batcher.h"
+#include "render/backend/vulkan/vulkan_command_cache.h"
 #include "render/backend/vulkan/vulkan_config.h"
+#include "render/backend/vulkan/vulkan_hud_renderer.h"
+#include "render/backend/vulkan/vulkan_impostor_renderer.h"
+#include "render/backend/vulkan/vulkan_loader.h"
+#include "render/backend/vulkan/vulkan_particle_system.h"
+#include "render/backend/vulkan/vulkan_readback_manager.h"
+#include "render/backend/vulkan/vulkan_rhi_backend.h"
+#include "render/backend/vulkan/vulkan_skinning_pass.h"
+#include "render/backend/vulkan/vulkan_submit_manager.h"
+#include "render/backend/vulkan/vulkan_upload_queue.h"
+#include "render/frame_packet.h"
+#include "render/hud/perf_hud.h"
+#include "render/material/material_system.h"
+#include "render/rhi/rhi_trace.h"
+#include "render/world/world_streamer.h"
 
 #include <glm/glm.hpp>
 #include <vulkan/vulkan.h>
 
 #include <GLFW/glfw3.h>
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 
+// colors come from the material of the object, not from its vertices
 struct Vertex
 {
     glm::vec3 pos;
-    glm::vec3 color;
     glm::vec2 texCoord;
 
     static VkVertexInputBindingDescription                  getBindingDescription();
-    static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions();
+    static std::array<VkVertexInputAttributeDescription, 2> getAttributeDescriptions();
 };
 
 struct UniformBufferObject
@@ -26,6 +57,86 @@ struct UniformBufferObject
     glm::mat4 proj;
 };
 
+// diffuse irradiance of the environment as the l2 spherical harmonics of EnvironmentLighting, std140 pads each to a vec4
+struct EnvironmentUniforms
+{
+    glm::vec4 irradiance[9];
+};
+
+struct TransientAttachment
+{
+    VkImage        image {};
+    VkDeviceMemory memory {};
+    VkImageView    view {};
+    bool           lazilyAllocated {false};
+};
+
+struct FrameStatistics
+{
+    std::chrono::high_resolution_clock::time_point lastFrameTime {};
+    double                                         elapsedMs {0.0};
+    double                                         gpuTimeMs {0.0};
+    uint32_t                                       frameCount {0};
+    uint32_t                                       gpuSampleCount {0};
+};
+
+// props of one cell of the world, merged into buffers of their own. The cpu side only keeps what culling needs
+struct WorldCell
+{
+    uint32_t        index {0};
+    StaticBatch     batch;
+    uint64_t        bytes {0};
+    VkBuffer        vertexBuffer {};
+    VkDeviceMemory  vertexBufferMemory {};
+    VkBuffer        indexBuffer {};
+    VkDeviceMemory  indexBufferMemory {};
+    RhiBufferHandle vertexBufferHandle {};
+    RhiBufferHandle indexBufferHandle {};
+    uint64_t        retireFrame {0}; // first frame that no longer drew it
+};
+
+struct WorldPropDraw
+{
+    uint32_t        cell {0};
+    StaticBatchDraw draw;
+
+    bool operator==(const WorldPropDraw& other) const { return cell == other.cell && draw == other.draw; }
+};
+
+// what the cached static draws of an image cover, culled again every frame
+struct StaticDrawLists
+{
+    std::vector<WorldPropDraw>   props;
+    std::vector<StaticBatchDraw> farFieldMeshes; // copies within the impostor distance, one group per copy
+    std::vector<ImpostorDraw>    impostors;      // runs of consecutive copies beyond it
+
+    bool operator==(const StaticDrawLists& other) const
+    {
+        return props == other.props && farFieldMeshes == other.farFieldMeshes && impostors == other.impostors;
+    }
+};
+
+// orbits the target with z up, the defaults match the former fixed eye at (2, 2, 2)
+struct OrbitCamera
+{
+    glm::vec3 target {0.0F, 0.0F, 0.0F};
+    float     yaw {glm::radians(45.0F)};
+    float     pitch {glm::radians(35.264F)};
+    float     distance {3.464F};
+
+    [[nodiscard]] glm::mat4 getViewMatrix() const;
+};
+
+// why a new frame has to be rendered, mainLoop idles while none of these are set
+enum RedrawReason : uint32_t
+{
+    REDRAW_NONE   = 0,
+    REDRAW_SCENE  = 1U << 0U,
+    REDRAW_CAMERA = 1U << 1U,
+    REDRAW_WINDOW = 1U << 2U,
+    REDRAW_ALL    = REDRAW_SCENE | REDRAW_CAMERA | REDRAW_WINDOW,
+};
+
 class VulkanApp {
 public:
     virtual ~VulkanApp() = default;
@@ -36,9 +147,11 @@ protected:
     void initWindow();
     void initVulkan();
     void mainLoop();
+    void renderLoop();
 
     // release resources
     void cleanupSwapChain();
+    void cleanupPipeline();
     void cleanup();
 
     // create resources
@@ -50,23 +163,44 @@ protected:
     void createSwapChain();
     void createImageViews();
     void createRenderPass();
+    void createDeferredRenderPass();
     void createDescriptorSetLayout();
     void createGraphicsPipeline();
+    void createDeferredPipelines();
     void createFrameBuffers();
     void createCommandPool();
     void createDepthResources();
-    void createTextureImage();
+    void createObjectIdResources();
+    void createGBufferResources();
     void createTextureImageView();
     void createTextureSampler();
-    void createVertexBuffer();
-    void createIndexBuffer();
     void createUniformBuffers();
+    void createEnvironmentBuffer();
     void createDescriptorPool();
     void createDescriptorSets();
     void createCommandBuffers();
     void createSyncObjects();
+    void createTimestampQueryPool();
+    void createPipelineCache();
+    void createMaterialResources();
+    void createForwardPipelines();
 
     void recreateSwapChain();
+    void importRhiResources();
+    void beginTraceCapture();
+    void benchmarkDispatchOverhead() const;
+
+    // command recording
+    void recordCommandBuffer(uint32_t imageIndex);
+    void recordSceneDraws(RhiCommandList& commandList, uint32_t imageIndex) const;
+    void recordLightingDraws(RhiCommandList& commandList) const;
+    void recordImpostorDraws(RhiCommandList& commandList, uint32_t imageIndex) const;
+    void recordParticleDraws(RhiCommandList& commandList, uint32_t imageIndex) const;
+    void recordHudDraws(RhiCommandList& commandList, uint32_t imageIndex) const;
+    void setViewportAndScissor(RhiCommandList& commandList) const;
+    void translateCommands(VkCommandBuffer commandBuffer);
+    void beginMainPass(VkCommandBuffer commandBuffer, uint32_t imageIndex) const;
+    void endMainPass(VkCommandBuffer commandBuffer, uint32_t imageIndex) const;
 
     // helper functions
     [[nodiscard]] VkShaderModule createShaderModule(const std::vector<char>& code) const;
@@ -75,8 +209,17 @@ protected:
                                               VkMemoryPropertyFlags properties,
                                               VkBuffer&             buffer,
                                               VkDeviceMemory&       bufferMemory) const;
-    void                         copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) const;
-    void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height) const;
+    void copyBuffer(VkCommandBuffer commandBuffer,
+                    VkBuffer        srcBuffer,
+                    VkDeviceSize    srcOffset,
+                    VkBuffer        dstBuffer,
+                    VkDeviceSize    size) const;
+    void copyBufferToImage(VkCommandBuffer commandBuffer,
+                           VkBuffer        buffer,
+                           VkDeviceSize    bufferOffset,
+                           VkImage         image,
+                           uint32_t        width,
+                           uint32_t        height) const;
     void createImage(uint32_t              width,
                      uint32_t              height,
                      uint32_t              mipLevels,
@@ -90,24 +233,88 @@ protected:
     createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels) const;
     [[nodiscard]] uint32_t        findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
     [[nodiscard]] VkFormat        findDepthFormat() const;
-    void                          updateUniformBuffer(uint32_t imageIndex);
+    void                          updateUniformBuffer(uint32_t imageIndex, const FramePacket& packet);
+    void                          updateSkinningPalettes(uint32_t imageIndex, const FramePacket& packet);
+    void                          updateParticleParams(uint32_t imageIndex, const FramePacket& packet);
+    void                          cullStaticDraws(uint32_t imageIndex, const FramePacket& packet);
     [[nodiscard]] VkCommandBuffer beginSingleTimeCommands() const;
-    void                          endSingleTimeCommands(VkCommandBuffer commandBuffer) const;
-    void                          transitionImageLayout(VkImage       image,
-                                                        VkFormat      format,
-                                                        VkImageLayout oldLayout,
-                                                        VkImageLayout newLayout,
-                                                        uint32_t      mipLevels) const;
-    void generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels);
+    void                          endSingleTimeCommands(VkCommandBuffer commandBuffer);
+    void                          transitionImageLayout(VkCommandBuffer commandBuffer,
+                                                        VkImage         image,
+                                                        VkFormat        format,
+                                                        VkImageLayout   oldLayout,
+                                                        VkImageLayout   newLayout,
+                                                        uint32_t        mipLevels) const;
+    void                          generateMipmaps(VkCommandBuffer commandBuffer,
+                                                  VkImage         image,
+                                                  VkFormat        imageFormat,
+                                                  int32_t         texWidth,
+                                                  int32_t         texHeight,
+                                                  uint32_t        mipLevels) const;
+
+    void createTransientAttachment(VkFormat format, VkImageUsageFlags usage, TransientAttachment& attachment) const;
+    void destroyTransientAttachment(TransientAttachment& attachment) const;
+    [[nodiscard]] bool usesRenderPass() const;
+    void               updateFrameStatistics();
+
+    // builds the overlay of the frame into the vertex buffer of the image, after its fence signaled
+    void updatePerfHud(uint32_t imageIndex, const FramePacket& packet);
+    void queryDeviceMemory(PerfHudCounters& counters) const;
+
+    // copied out through the readback ring after the frame, the results arrive once its fence signaled
+    void requestTimestamps(uint32_t imageIndex);
+    void requestFrameCapture();
+
+    // copies what changed in the material system since the last frame into the material buffer
+    void uploadMaterials();
+    void uploadMaterialRange(VkDeviceSize offset, VkDeviceSize size, const void* data);
+
+    // asset loading, the loads and uploads of independent assets overlap on the asset executor
+    Task<void> loadSceneAssets();
+    Task<void> loadTexture(std::string path, VkImage& image, VkDeviceMemory& imageMemory, uint32_t& mipLevels);
+    Task<void> uploadBuffer(const void*        data,
+                            VkDeviceSize       size,
+                            VkBufferUsageFlags usage,
+                            VkBuffer&          buffer,
+                            VkDeviceMemory&    bufferMemory);
+    Task<void> buildSceneBvh(std::vector<glm::vec3> positions);
+    Task<void> loadSkinnedAssets();
+    Task<void> buildFarField(MeshAsset mesh, std::string texturePath);
+    Task<void> loadEnvironment();
+    Task<void> loadHud();
+
+    // world streaming, the render thread decides and the asset threads load
+    Task<void> loadWorldCell(uint32_t cell);
+    void       streamWorld(const FramePacket& packet);
+    bool       collectWorldCells();
+    void       destroyWorldCell(WorldCell& cell) const;
+    void       drainWorldStreaming();
+
+    void drawFrame(const FramePacket& packet);
+
+    // reads the id buffer under the cursor back a few frames later, casts a ray against the scene bvh without it
+    void                    pickAtCursor();
+    [[nodiscard]] glm::mat4 getModelMatrix() const;
+    static glm::mat4        getProjectionMatrix(float aspectRatio);
 
-    void loadModel();
-    void drawFrame();
+    // render on demand
+    void               requestRedraw(uint32_t reasons);
+    [[nodiscard]] bool needsRedraw() const;
+    void               advanceAnimation();
+    void               advanceCamera();
+    void               submitFramePacket();
 
     static void frameBufferResizeCallback(GLFWwindow* windows, int width, int height);
+    static void keyCallback(GLFWwindow* windows, int key, int scancode, int action, int mods);
+    static void windowRefreshCallback(GLFWwindow* windows);
+    static void mouseButtonCallback(GLFWwindow* windows, int button, int action, int mods);
+    static void cursorPosCallback(GLFWwindow* windows, double x, double y);
+    static void scrollCallback(GLFWwindow* windows, double xOffset, double yOffset);
 
 private:
     GLFWwindow*                  window_ {nullptr};
     VkInstance                   instance_ {};
+    uint32_t                     instanceApiVersion_ {VK_API_VERSION_1_0};
     VkDebugUtilsMessengerEXT     debugMessenger_ {};
     VkPhysicalDevice             physicalDevice_ {nullptr};
     VkDevice                     device_ {nullptr};
@@ -117,37 +324,183 @@ private:
     VkSwapchainKHR               swapChain_ {};
     VkFormat                     swapChainImageFormat_ {};
     VkExtent2D                   swapChainExtent_ {};
+    VkExtent2D                   framebufferExtent_ {};
+    bool                         swapChainReadable_ {false};
     std::vector<VkImage>         swapChainImages_;
     std::vector<VkImageView>     swapChainImageViews_;
     std::vector<VkFramebuffer>   swapChainFrameBuffers_;
     VkRenderPass                 renderPass_ {};
     VkDescriptorSetLayout        descriptorSetLayout_ {};
     VkPipelineLayout             pipelineLayout_ {};
-    VkPipeline                   graphicsPipeline_ {};
+    VkPipelineCache              pipelineCache_ {};
     VkCommandPool                commandPool_ {};
     VkDescriptorPool             descriptorPool_ {};
     VkImage                      depthImage_ {};
     VkDeviceMemory               depthImageMemory_ {};
     VkImageView                  depthImageView_ {};
+    VkImage                      objectIdImage_ {};
+    VkDeviceMemory               objectIdImageMemory_ {};
+    VkImageView                  objectIdImageView_ {};
+    TransientAttachment          gBufferAlbedo_ {};
+    TransientAttachment          gBufferNormal_ {};
+    VkDescriptorSetLayout        gBufferDescriptorSetLayout_ {};
+    VkDescriptorPool             gBufferDescriptorPool_ {};
+    VkDescriptorSet              gBufferDescriptorSet_ {};
+    VkPipelineLayout             lightingPipelineLayout_ {};
+    VkPipeline                   lightingPipeline_ {};
+    VkQueryPool                  timestampQueryPool_ {};
+    float                        timestampPeriod_ {0.0F};
+    FrameStatistics              frameStatistics_ {};
     uint32_t                     mipLevels_ {0};
     VkImage                      textureImage_ {};
     VkDeviceMemory               textureImageMemory_ {};
     VkImageView                  textureImageView_ {};
+    uint32_t                     lightmapMipLevels_ {0};
+    VkImage                      lightmapImage_ {}; // null without a baked lightmap
+    VkDeviceMemory               lightmapImageMemory_ {};
+    VkImageView                  lightmapImageView_ {};
     VkSampler                    textureSampler_ {};
+    uint32_t                     materialTextureCapacity_ {1};
+    std::vector<VkImageView>     materialTextures_; // bindless texture table, unused slots repeat the first texture
+    VkBuffer                     materialBuffer_ {};
+    VkDeviceMemory               materialBufferMemory_ {};
+    VkDeviceSize                 materialTableOffset_ {0}; // object -> material table behind the parameters
     VkBuffer                     vertexBuffer_ {};
     VkDeviceMemory               vertexBufferMemory_ {};
     VkBuffer                     indexBuffer_ {};
     VkDeviceMemory               indexBufferMemory_ {};
     std::vector<VkBuffer>        uniformBuffers_;
     std::vector<VkDeviceMemory>  uniformBuffersMemory_;
+    VkBuffer                     environmentBuffer_ {}; // EnvironmentUniforms, written once the environment is loaded
+    VkDeviceMemory               environmentBufferMemory_ {};
+    EnvironmentLighting          environmentLighting_;
     std::vector<VkDescriptorSet> descriptorSets_;
     std::vector<VkCommandBuffer> commandBuffers_;
+    std::vector<bool>            commandBufferDirty_;
+    VulkanCommandCache           commandCache_;
+    VulkanSubmitManager          submitManager_;
+    VulkanSubmitBatch            frameBatch_ {};
+    VulkanReadbackManager        readbackManager_;
+    ImageWriteQueue              captureWriter_ {gCaptureWriterThreadCount};
+    TaskExecutor                 assetExecutor_ {gAssetThreadCount};
+    VulkanUploadQueue            uploadQueue_;
+    MaterialSystem               materialSystem_;
+
+    // scene pipelines by shading model, the same layout and shaders specialized on the model
+    std::array<VkPipeline, SHADING_MODEL_COUNT> graphicsPipelines_ {};
+
+    // animated instances of one skinned mesh, drawn from the vertices the skinning pass wrote this frame
+    VulkanSkinningPass             skinningPass_;
+    SkinnedMeshAsset               skinnedMesh_;
+    VkBuffer                       skinnedIndexBuffer_ {};
+    VkDeviceMemory                 skinnedIndexBufferMemory_ {};
+    std::vector<AnimationInstance> skinnedInstances_; // render thread scratch for the pose evaluation
+
+    // simulated and drawn without the cpu touching a particle, stepped by the animation clock
+    VulkanParticleSystem particleSystem_;
+    bool                 independentBlendSupported_ {false};
+    float                particleTime_ {0.0F};
+    float                particleEmitRemainder_ {0.0F};
+
+    // the performance overlay, built on the render thread every drawn frame. The counters of the memory heaps are
+    // only queried every few frames, the draw counts are taken when a command cache slot is recorded
+    VulkanHudRenderer                              hudRenderer_;
+    PerfHud                                        perfHud_;
+    PerfHudCounters                                hudCounters_ {};
+    std::vector<uint32_t>                          recordedDrawCounts_; // by command cache slot
+    bool                                           memoryBudgetSupported_ {false};
+    uint64_t                                       hudFrameCount_ {0};
+    float                                          lastCpuTimeMs_ {0.0F};
+    float                                          lastGpuTimeMs_ {-1.0F}; // of the latest timestamps that came back
+    std::chrono::high_resolution_clock::time_point lastHudFrameTime_ {};
+
+    // small props streamed in per cell of the world, the draws of an image are the runs of chunks its camera saw.
+    // Loads finish on the asset threads, unloaded cells are kept until no frame in flight can read them anymore
+    WorldStreamer                                  worldStreamer_;
+    WorldStreamingRequests                         worldRequests_;
+    std::array<MeshAsset, 3>                       worldPropMeshes_;
+    std::map<uint32_t, std::unique_ptr<WorldCell>> worldCells_; // resident ones by cell
+    std::vector<std::unique_ptr<WorldCell>>        retiredWorldCells_;
+    std::vector<StaticBatchDraw>                   worldCullScratch_;
+    std::atomic<bool>                              worldStreaming_ {false}; // read by the main thread
+
+    // asset threads -> render thread
+    std::mutex                              loadedWorldCellsMutex_;
+    std::vector<std::unique_ptr<WorldCell>> loadedWorldCells_;
+
+    // copies of the scene merged the same way, with the material of an instance being its index. The far ones are
+    // swapped for impostors of the scene mesh, baked when it is loaded
+    StaticBatch                   farFieldBatch_;
+    std::vector<ImpostorInstance> farFieldCopies_;
+    VkBuffer                      farFieldVertexBuffer_ {};
+    VkDeviceMemory                farFieldVertexBufferMemory_ {};
+    VkBuffer                      farFieldIndexBuffer_ {};
+    VkDeviceMemory                farFieldIndexBufferMemory_ {};
+    VulkanImpostorRenderer        impostorRenderer_;
+
+    std::vector<StaticDrawLists> staticDrawLists_;
+    std::vector<uint64_t>        staticDrawVersions_; // bumped whenever the draw lists of an image change
+    StaticDrawLists              staticDrawScratch_;
+
+    // frontend recording goes through the rhi, the handles are re-pointed whenever the objects are rebuilt
+    VulkanRhiBackend                                   rhiBackend_;
+    RhiCommandList                                     rhiCommands_;
+    std::array<RhiPipelineHandle, SHADING_MODEL_COUNT> graphicsPipelineHandles_ {};
+    RhiPipelineHandle                                  lightingPipelineHandle_ {};
+    RhiBufferHandle                                    vertexBufferHandle_ {};
+    RhiBufferHandle                                    indexBufferHandle_ {};
+    RhiBufferHandle                                    skinnedVertexBufferHandle_ {};
+    RhiBufferHandle                                    skinnedIndexBufferHandle_ {};
+    RhiBufferHandle                                    farFieldVertexBufferHandle_ {};
+    RhiBufferHandle                                    farFieldIndexBufferHandle_ {};
+    RhiPipelineHandle                                  impostorPipelineHandle_ {};
+    RhiBufferHandle                                    impostorInstanceBufferHandle_ {};
+    RhiPipelineHandle                                  particlePipelineHandle_ {};
+    RhiBufferHandle                                    particleDrawArgsHandle_ {};
+    std::vector<RhiDescriptorSetHandle>                descriptorSetHandles_;
+    std::vector<RhiDescriptorSetHandle>                particleDescriptorSetHandles_;
+    std::vector<RhiDescriptorSetHandle>                impostorDescriptorSetHandles_;
+    RhiPipelineHandle                                  hudPipelineHandle_ {};
+    RhiDescriptorSetHandle                             hudDescriptorSetHandle_ {};
+    std::vector<RhiBufferHandle>                       hudBufferHandles_;
+    RhiDescriptorSetHandle                             gBufferDescriptorSetHandle_ {};
+    RhiTraceWriter                                     traceWriter_;
+
     std::vector<VkSemaphore>     imageAvailableSemaphores_ {};
     std::vector<VkSemaphore>     renderFinishedSemaphores_ {};
     std::vector<VkFence>         inFlightFences_ {};
     std::vector<VkFence>         imagesInFlight_ {};
     std::vector<Vertex>          vertices_ {};
     std::vector<uint32_t>        indices_ {};
+    JobSystem                    jobSystem_;
+    MeshBvh                      sceneBvh_;
     size_t                       currentFrameIndex_ {0};
     bool                         frameBufferResized_ {false};
+    bool                         useDynamicRendering_ {false};
+    bool                         deferredShading_ {gEnableDeferredShading};
+    bool                         renderPathChanged_ {false};
+
+    // owned by the main thread, reaches the render thread only through frame packets
+    bool                                           renderOnDemand_ {gRenderOnDemand};
+    uint32_t                                       redrawReasons_ {REDRAW_ALL};
+    OrbitCamera                                    camera_ {};
+    bool                                           cameraDragging_ {false};
+    glm::dvec2                                     lastCursorPos_ {0.0, 0.0};
+    bool                                           animating_ {false};
+    float                                          animationTime_ {0.0F};
+    std::chrono::high_resolution_clock::time_point lastAnimationTime_ {};
+    std::chrono::high_resolution_clock::time_point lastCameraTime_ {};
+    bool                                           deferredShadingRequested_ {gEnableDeferredShading};
+    bool                                           showPerfHud_ {gShowPerfHud};
+    bool                                           windowResized_ {false};
+    bool                                           idleSinceLastPacket_ {false};
+    uint32_t                                       traceFramesPending_ {0};
+    uint32_t                                       captureFramesPending_ {0};
+
+    // main thread <-> render thread
+    std::thread        renderThread_;
+    FramePacketQueue   framePackets_;
+    std::exception_ptr renderThreadError_;
+    std::atomic<bool>  renderThreadFailed_ {false};
+    std::atomic<bool>  swapChainRecreated_ {false};
 };
@@ -0,0 +1,100 @@
+#include "render/backend/vulkan/vulkan_command_cache.h"
+
+void VulkanCommandCache::create(VkDevice device, uint32_t queueFamilyIndex)
+{
+    device_ = device;
+
+    VkCommandPoolCreateInfo poolInfo {};
+    poolInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = queueFamilyIndex;
+    poolInfo.flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+    if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create command cache pool!");
+    }
+}
+
+void VulkanCommandCache::destroy()
+{
+    freeCommandBuffers();
+
+    vkDestroyCommandPool(device_, commandPool_, nullptr);
+    commandPool_ = VK_NULL_HANDLE;
+}
+
+void VulkanCommandCache::resize(uint32_t slotCount)
+{
+    freeCommandBuffers();
+
+    std::vector<VkCommandBuffer> commandBuffers(slotCount);
+
+    VkCommandBufferAllocateInfo allocInfo {};
+    allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool        = commandPool_;
+    allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+    allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+
+    if (vkAllocateCommandBuffers(device_, &allocInfo, commandBuffers.data()) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to allocate secondary command buffers!");
+    }
+
+    entries_.resize(slotCount);
+    for (uint32_t index = 0; index < slotCount; index++)
+    {
+        entries_[index].commandBuffer = commandBuffers[index];
+    }
+}
+
+void VulkanCommandCache::invalidate()
+{
+    generation_++;
+}
+
+uint32_t VulkanCommandCache::takeRecordCount()
+{
+    const uint32_t recordCount = recordCount_;
+    recordCount_               = 0;
+    return recordCount;
+}
+
+void VulkanCommandCache::freeCommandBuffers()
+{
+    std::vector<VkCommandBuffer> commandBuffers;
+    for (const auto& entry : entries_)
+    {
+        commandBuffers.push_back(entry.commandBuffer);
+    }
+
+    if (!commandBuffers.empty())
+    {
+        vkFreeCommandBuffers(
+            device_, commandPool_, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+    }
+
+    entries_.clear();
+}
+
+void VulkanCommandCache::beginSecondary(VkCommandBuffer                       commandBuffer,
+                                        const VkCommandBufferInheritanceInfo& inheritanceInfo) const
+{
+    VkCommandBufferBeginInfo beginInfo {};
+    beginInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags            = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+    // the pool allows individual resets, begin implicitly resets the previous recording
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to begin recording secondary command buffer!");
+    }
+}
+
+void VulkanCommandCache::endSecondary(VkCommandBuffer commandBuffer) const
+{
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to record secondary command buffer!");
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "foundation/log/log_system.h"
+#include "render/backend/vulkan/vulkan_config.h"
+#include "render/backend/vulkan/vulkan_loader.h"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+// Everything a cached secondary command buffer was recorded against. Handles can be recycled by the driver after a
+// destroy, so the cache generation is part of the key and gets bumped whenever those resources are rebuilt.
+struct StaticDrawKey
+{
+    VkPipeline      pipeline {};
+    VkDescriptorSet descriptorSet {};
+    VkBuffer        vertexBuffer {};
+    VkBuffer        indexBuffer {};
+    uint32_t        indexCount {0};
+    VkRenderPass    renderPass {};
+    uint32_t        subpass {0};
+    VkFramebuffer   framebuffer {};
+    VkExtent2D      extent {};
+    uint64_t        drawVersion {0}; // bumped by whatever changes the draws without changing the handles above
+
+    bool operator==(const StaticDrawKey& other) const
+    {
+        return pipeline == other.pipeline && descriptorSet == other.descriptorSet &&
+               vertexBuffer == other.vertexBuffer && indexBuffer == other.indexBuffer &&
+               indexCount == other.indexCount && renderPass == other.renderPass && subpass == other.subpass &&
+               framebuffer == other.framebuffer && extent.width == other.extent.width &&
+               extent.height == other.extent.height && drawVersion == other.drawVersion;
+    }
+};
+
+// Secondary command buffers for draws that do not change between frames. A slot is only re-recorded when its key or
+// the cache generation changed, so a static scene costs no recording at all once warmed up. There are no per-frame
+// slots: what changes every frame (skinning palettes, particle parameters, overlay vertex counts) reaches the gpu
+// through buffers the recorded commands read, so the recordings stay valid.
+class VulkanCommandCache {
+public:
+    void create(VkDevice device, uint32_t queueFamilyIndex);
+    void destroy();
+
+    // (re)allocates the secondary command buffers, every slot starts out invalid
+    void resize(uint32_t slotCount);
+
+    // forces every slot to be re-recorded on its next use
+    void invalidate();
+
+    // returns true when the slot had to be re-recorded, the primary executing it has to be re-recorded as well
+    template<typename RECORD>
+    bool acquire(uint32_t                              slot,
+                 const StaticDrawKey&                  key,
+                 const VkCommandBufferInheritanceInfo& inheritanceInfo,
+                 RECORD&&                              record,
+                 VkCommandBuffer&                      commandBuffer)
+    {
+        Entry& entry  = entries_[slot];
+        commandBuffer = entry.commandBuffer;
+
+        if (entry.valid && entry.generation == generation_ && entry.key == key)
+            return false;
+
+        beginSecondary(commandBuffer, inheritanceInfo);
+        record(commandBuffer);
+        endSecondary(commandBuffer);
+
+        entry.key        = key;
+        entry.generation = generation_;
+        entry.valid      = true;
+        recordCount_++;
+
+        return true;
+    }
+
+    // number of slots recorded since the last call
+    uint32_t takeRecordCount();
+
+private:
+    struct Entry
+    {
+        VkCommandBuffer commandBuffer {};
+        StaticDrawKey   key {};
+        uint64_t        generation {0};
+        bool            valid {false};
+    };
+
+    void freeCommandBuffers();
+    void beginSecondary(VkCommandBuffer commandBuffer, const VkCommandBufferInheritanceInfo& inheritanceInfo) const;
+    void endSecondary(VkCommandBuffer commandBuffer) const;
+
+    VkDevice                     device_ {nullptr};
+    VkCommandPool                commandPool_ {};
+    std::vector<Entry> entries_;
+    uint64_t           generation_ {0};
+    uint32_t           recordCount_ {0};
+};
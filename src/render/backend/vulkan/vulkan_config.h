@@ -6,14 +6,17 @@
 
 #define VK_VALUE_SERIALIZATION_CONFIG_MAIN
 
-#define STB_IMAGE_IMPLEMENTATION
-
-#define TINYOBJLOADER_IMPLEMENTATION
-
 #include <vulkan/vulkan.h>
 
 #include <vector>
 
+// VK_KHR_dynamic_rendering only exists in headers from Vulkan SDK 1.2.197 onwards
+#if defined(VK_KHR_dynamic_rendering)
+#define VULKAN_HAS_DYNAMIC_RENDERING 1
+#else
+#define VULKAN_HAS_DYNAMIC_RENDERING 0
+#endif
+
 namespace VulkanConfig
 {
 #ifdef NDEBUG
@@ -27,6 +30,127 @@ const uint32_t HEIGHT = 600;
 
 const uint32_t MAX_FRAMES_IN_FLIGHT = 2;
 
+// highest api version requested from the loader, the device may still report a lower one
+const uint32_t gTargetApiVersion = VK_API_VERSION_1_2;
+
+// render without VkRenderPass/VkFramebuffer objects when the device supports VK_KHR_dynamic_rendering,
+// otherwise fall back to the render pass path
+const bool gPreferDynamicRendering = true;
+
+// split the main pass into a G-buffer subpass and a lighting subpass that reads it back through transient input
+// attachments, F2 toggles between deferred and forward shading at runtime
+const bool gEnableDeferredShading = false;
+
+const VkFormat gGBufferAlbedoFormat = VK_FORMAT_R8G8B8A8_SRGB;
+const VkFormat gGBufferNormalFormat = VK_FORMAT_A2B10G10R10_UNORM_PACK32;
+
+// only render when the scene, the camera or the window changed, otherwise block in glfwWaitEventsTimeout and leave
+// the last presented image on screen. F3 switches between on-demand and continuous rendering
+const bool gRenderOnDemand = true;
+
+// upper bound for a single idle wait, keeps time based work ticking while nothing is drawn
+const double gIdleWaitTimeoutSeconds = 0.5;
+
+// F9 captures the rhi command streams of the next frames, replay with --replay-rhi-trace
+const char* const gTraceCapturePath       = "E:/projects/learn_vulkan/data/traces/capture.rhitrace";
+const uint32_t    gTraceCaptureFrameCount = 60;
+
+// log the cost of a vkCmd* call through the loader trampoline and through the device dispatch table at startup
+const bool     gBenchmarkDispatchOverhead  = false;
+const uint32_t gDispatchBenchmarkCallCount = 200000;
+
+// hand vkQueueSubmit and vkQueuePresentKHR to a dedicated thread so driver time overlaps with recording the next frame
+const bool gUseSubmitThread = true;
+
+// write object id and triangle index of every pixel into an extra attachment of the main pass, right click reads the
+// pixel under the cursor back instead of raycasting the scene on the cpu
+const bool     gEnableObjectIdBuffer = true;
+const VkFormat gObjectIdFormat       = VK_FORMAT_R32G32_UINT;
+
+// host cached ring shared by the readbacks of all frames in flight, requests beyond it wait for a later frame. A full
+// 1080p frame capture takes 8 MiB
+const VkDeviceSize gReadbackRingSize = 32 * 1024 * 1024;
+
+// F12 writes the next frame, F11 the next frames as a numbered sequence, encoded as PNG on background threads
+const char* const gCaptureDirectory          = "E:/projects/learn_vulkan/data/captures";
+const uint32_t    gCaptureSequenceFrameCount = 120;
+const uint32_t    gCaptureWriterThreadCount  = 2;
+
+// workers resuming asset loading coroutines, they mostly wait on the disk and the upload fences
+const uint32_t gAssetThreadCount = 2;
+
+// uploads are staged in persistently mapped blocks of this size, a block is reused once all of its uploads finished.
+// Larger uploads get a block of their own for the time they are in flight
+const VkDeviceSize gUploadStagingBlockSize = 16 * 1024 * 1024;
+
+// materials are parameter blocks in one storage buffer indexed per draw, their textures slots in one table of
+// combined image samplers. The texture table shrinks to what the device allows
+const uint32_t gMaxMaterials        = 4096;
+const uint32_t gMaxMaterialObjects  = 4096;
+const uint32_t gMaxMaterialTextures = 256;
+
+// animated tentacles standing in a ring around the scene, posed on the job system and skinned by one compute
+// dispatch per frame. Each instance is one draw from the shared skinned vertex buffer
+const uint32_t gSkinnedInstanceCount = 64;
+const float    gSkinnedRingRadius    = 1.4F;
+const uint32_t gTentacleJointCount   = 6;
+const uint32_t gTentacleRingCount    = 24;
+const uint32_t gTentacleSideCount    = 12;
+const float    gTentacleHeight       = 0.6F;
+const float    gTentacleRadius       = 0.04F;
+
+// a fountain of particles above the scene, emitted, simulated and sorted back to front in compute shaders and drawn
+// with one indirect draw. The sort always covers the capacity rounded up to a power of two
+const uint32_t gParticleCapacity      = 1U << 20U;
+const float    gParticleEmitRate      = 250000.0F; // per second
+const float    gParticleMinLifetime   = 2.0F;
+const float    gParticleMaxLifetime   = 5.0F;
+const float    gParticleSpeed         = 1.2F;
+const float    gParticleSize          = 0.006F;
+const bool     gEnableParticleSorting = true;
+
+// small static props scattered over the world, merged into shared buffers by material per cell of the world grid.
+// Chunks of nearby props are culled on the cpu and neighbouring visible chunks drawn together, about one draw per
+// material and cell. The props keep clear of the scene within the inner radius
+const uint32_t gStaticPropsPerCell       = 2000;
+const uint32_t gStaticPropMaterialCount  = 4;
+const float    gStaticPropInnerRadius    = 1.8F;
+const uint32_t gStaticBatchChunkVertices = 4096;
+
+// the world is a square grid of cells centered on the scene, streamed around the eye on the asset threads. Cells within
+// the load radius load nearest first, resident ones stay until the eye is beyond the unload radius. Resident and
+// loading cells share a fixed budget, the farthest cells are evicted to make room for nearer ones. W/A/S/D move the
+// camera across the world
+const uint32_t gWorldCellsPerSide       = 64;
+const float    gWorldCellSize           = 4.0F;
+const float    gWorldLoadRadius         = 10.0F;
+const float    gWorldUnloadRadius       = 14.0F;
+const uint64_t gWorldMemoryBudget       = 64ULL * 1024 * 1024;
+const uint32_t gWorldMaxConcurrentLoads = 4;
+const float    gCameraPanSpeed          = 0.6F; // orbit distances per second
+
+// copies of the scene scattered beyond the props. Copies within the impostor distance of the eye are drawn from merged
+// buffers at full detail, farther ones as a single quad each from an octahedral atlas baked at load time
+const uint32_t gFarFieldCopyCount       = 64;
+const float    gFarFieldInnerRadius     = 5.5F;
+const float    gFarFieldOuterRadius     = 9.0F;
+const float    gImpostorDistance        = 6.5F;
+const uint32_t gImpostorFramesPerSide   = 8;
+const uint32_t gImpostorFrameResolution = 128;
+
+// image based lighting from an equirectangular ldr panorama, a procedural sky stands in when the file is missing. The
+// convolved results are cached keyed by a hash of the source, so only the first startup with an environment pays for
+// the prefiltering. The diffuse irradiance replaces the constant ambient term of the shaders
+const char* const gEnvironmentMapPath        = "E:/projects/learn_vulkan/data/textures/environment.png";
+const char* const gEnvironmentCacheDirectory = "E:/projects/learn_vulkan/data/cache/ibl";
+
+// an overlay with frame, cpu and gpu time graphs, the draw and upload counters and the memory in use, toggled with F1.
+// It is drawn on top of the last pass in one draw out of a per image vertex buffer. Only drawn frames update it, a
+// scene that does not change shows the numbers of the last frame it drew
+const bool     gShowPerfHud                = true;
+const uint32_t gPerfHudMaxVertices         = 8192;
+const uint32_t gPerfHudMemoryQueryInterval = 30; // frames between memory budget queries
+
 const std::vector<const char*> gValidationLayers = {"VK_LAYER_KHRONOS_validation"};
 
 const std::vector<const char*> gDeviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
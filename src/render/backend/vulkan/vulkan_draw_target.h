@@ -0,0 +1,15 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+
+// Where a subsystem draws into the main pass, renderingInfo is the VkPipelineRenderingCreateInfoKHR when there is no
+// render pass.
+struct VulkanDrawTarget
+{
+    VkRenderPass renderPass {VK_NULL_HANDLE};
+    uint32_t     subpass {0};
+    uint32_t     colorAttachmentCount {1};
+    const void*  renderingInfo {nullptr};
+};
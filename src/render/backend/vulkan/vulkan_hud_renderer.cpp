@@ -0,0 +1,500 @@
+#include "render/backend/vulkan/vulkan_hud_renderer.h"
+#include "render/backend/vulkan/vulkan_utils.h"
+
+#include "foundation/log/log_system.h"
+
+#include <array>
+#include <cstddef>
+
+namespace
+{
+constexpr VkFormat ATLAS_FORMAT = VK_FORMAT_R8_UNORM;
+
+void recordAtlasBarrier(VkCommandBuffer      commandBuffer,
+                        VkImage              image,
+                        VkImageLayout        oldLayout,
+                        VkImageLayout        newLayout,
+                        VkAccessFlags        srcAccessMask,
+                        VkAccessFlags        dstAccessMask,
+                        VkPipelineStageFlags srcStage,
+                        VkPipelineStageFlags dstStage)
+{
+    VkImageMemoryBarrier barrier {};
+    barrier.sType                       = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask               = srcAccessMask;
+    barrier.dstAccessMask               = dstAccessMask;
+    barrier.oldLayout                   = oldLayout;
+    barrier.newLayout                   = newLayout;
+    barrier.srcQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image                       = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.layerCount = 1;
+
+    vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+} // namespace
+
+void VulkanHudRenderer::create(VkPhysicalDevice physicalDevice,
+                               VkDevice         device,
+                               VkPipelineCache  pipelineCache,
+                               bool             independentBlend)
+{
+    physicalDevice_   = physicalDevice;
+    device_           = device;
+    pipelineCache_    = pipelineCache;
+    independentBlend_ = independentBlend;
+
+    VkDescriptorSetLayoutBinding atlasBinding {};
+    atlasBinding.binding         = 0;
+    atlasBinding.descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    atlasBinding.descriptorCount = 1;
+    atlasBinding.stageFlags      = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo {};
+    layoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings    = &atlasBinding;
+
+    if (vkCreateDescriptorSetLayout(device_, &layoutInfo, nullptr, &descriptorSetLayout_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create hud descriptor set layout!");
+    }
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo {};
+    pipelineLayoutInfo.sType          = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts    = &descriptorSetLayout_;
+
+    if (vkCreatePipelineLayout(device_, &pipelineLayoutInfo, nullptr, &pipelineLayout_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create hud pipeline layout!");
+    }
+
+    // the field is smooth, so bilinear filtering of it keeps the outline sharp when the glyphs are magnified
+    VkSamplerCreateInfo samplerInfo {};
+    samplerInfo.sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter    = VK_FILTER_LINEAR;
+    samplerInfo.minFilter    = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.compareOp    = VK_COMPARE_OP_ALWAYS;
+    samplerInfo.borderColor  = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+
+    if (vkCreateSampler(device_, &samplerInfo, nullptr, &sampler_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create hud sampler!");
+    }
+
+    VkDescriptorPoolSize poolSize {};
+    poolSize.type            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSize.descriptorCount = 1;
+
+    VkDescriptorPoolCreateInfo poolInfo {};
+    poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes    = &poolSize;
+    poolInfo.maxSets       = 1;
+
+    if (vkCreateDescriptorPool(device_, &poolInfo, nullptr, &descriptorPool_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create hud descriptor pool!");
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo {};
+    allocInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool     = descriptorPool_;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts        = &descriptorSetLayout_;
+
+    if (vkAllocateDescriptorSets(device_, &allocInfo, &descriptorSet_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to allocate hud descriptor set!");
+    }
+}
+
+void VulkanHudRenderer::destroy()
+{
+    destroyFrameResources();
+    destroyDrawPipeline();
+
+    vkDestroyImageView(device_, atlasView_, nullptr);
+    vkDestroyImage(device_, atlasImage_, nullptr);
+    vkFreeMemory(device_, atlasMemory_, nullptr);
+    atlasView_   = VK_NULL_HANDLE;
+    atlasImage_  = VK_NULL_HANDLE;
+    atlasMemory_ = VK_NULL_HANDLE;
+
+    // frees the descriptor set along with it
+    vkDestroyDescriptorPool(device_, descriptorPool_, nullptr);
+    vkDestroySampler(device_, sampler_, nullptr);
+    vkDestroyPipelineLayout(device_, pipelineLayout_, nullptr);
+    vkDestroyDescriptorSetLayout(device_, descriptorSetLayout_, nullptr);
+    descriptorPool_      = VK_NULL_HANDLE;
+    descriptorSet_       = VK_NULL_HANDLE;
+    sampler_             = VK_NULL_HANDLE;
+    pipelineLayout_      = VK_NULL_HANDLE;
+    descriptorSetLayout_ = VK_NULL_HANDLE;
+}
+
+Task<void> VulkanHudRenderer::upload(VulkanUploadQueue& uploadQueue, const SdfFontAtlas& atlas)
+{
+    if (atlas.isEmpty())
+        co_return;
+
+    VkImageCreateInfo imageInfo {};
+    imageInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType     = VK_IMAGE_TYPE_2D;
+    imageInfo.extent        = {atlas.width, atlas.height, 1};
+    imageInfo.mipLevels     = 1;
+    imageInfo.arrayLayers   = 1;
+    imageInfo.format        = ATLAS_FORMAT;
+    imageInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage         = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateImage(device_, &imageInfo, nullptr, &atlasImage_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create hud font image!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device_, atlasImage_, &memRequirements);
+
+    VkMemoryAllocateInfo allocInfo {};
+    allocInfo.sType          = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    if (!VulkanUtils::findMemoryTypeIndex(physicalDevice_,
+                                          memRequirements.memoryTypeBits,
+                                          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                          allocInfo.memoryTypeIndex))
+    {
+        LOG_FATAL("Failed to find a memory type for the hud font!");
+    }
+
+    if (vkAllocateMemory(device_, &allocInfo, nullptr, &atlasMemory_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to allocate hud font memory!");
+    }
+    vkBindImageMemory(device_, atlasImage_, atlasMemory_, 0);
+
+    VkImageViewCreateInfo viewInfo {};
+    viewInfo.sType                       = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image                       = atlasImage_;
+    viewInfo.viewType                    = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format                      = ATLAS_FORMAT;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    if (vkCreateImageView(device_, &viewInfo, nullptr, &atlasView_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create hud font image view!");
+    }
+
+    const auto recordAtlasUpload = [image = atlasImage_, extent = imageInfo.extent](VkCommandBuffer commandBuffer,
+                                                                                    VkBuffer        stagingBuffer,
+                                                                                    VkDeviceSize    stagingOffset) {
+        recordAtlasBarrier(commandBuffer,
+                           image,
+                           VK_IMAGE_LAYOUT_UNDEFINED,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           0,
+                           VK_ACCESS_TRANSFER_WRITE_BIT,
+                           VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                           VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+        VkBufferImageCopy region {};
+        region.bufferOffset                = stagingOffset;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent                 = extent;
+
+        vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+        recordAtlasBarrier(commandBuffer,
+                           image,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                           VK_ACCESS_TRANSFER_WRITE_BIT,
+                           VK_ACCESS_SHADER_READ_BIT,
+                           VK_PIPELINE_STAGE_TRANSFER_BIT,
+                           VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    };
+
+    co_await uploadQueue.upload(atlas.texels.data(), atlas.texels.size(), recordAtlasUpload);
+
+    const VkDescriptorImageInfo imageDescriptor {sampler_, atlasView_, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+
+    VkWriteDescriptorSet descriptorWrite {};
+    descriptorWrite.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet          = descriptorSet_;
+    descriptorWrite.dstBinding      = 0;
+    descriptorWrite.descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.pImageInfo      = &imageDescriptor;
+
+    vkUpdateDescriptorSets(device_, 1, &descriptorWrite, 0, nullptr);
+
+    LOG_INFO("Hud font: {}x{} distance field", atlas.width, atlas.height);
+}
+
+void VulkanHudRenderer::createDrawPipeline(const VulkanDrawTarget&  target,
+                                           const std::vector<char>& vertShaderCode,
+                                           const std::vector<char>& fragShaderCode)
+{
+    // the extra attachments are integer ids, which cannot blend with the color
+    if (target.colorAttachmentCount > 1 && !independentBlend_)
+    {
+        LOG_WARN("The hud is not drawn, the device lacks independent blending");
+        return;
+    }
+
+    const auto createModule = [this](const std::vector<char>& code) {
+        VkShaderModuleCreateInfo moduleInfo {};
+        moduleInfo.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleInfo.codeSize = code.size();
+        moduleInfo.pCode    = reinterpret_cast<const uint32_t*>(code.data());
+
+        VkShaderModule shaderModule = VK_NULL_HANDLE;
+        if (vkCreateShaderModule(device_, &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS)
+        {
+            LOG_FATAL("Failed to create hud shader module!");
+        }
+        return shaderModule;
+    };
+
+    VkShaderModule vertShaderModule = createModule(vertShaderCode);
+    VkShaderModule fragShaderModule = createModule(fragShaderCode);
+
+    std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages {};
+    shaderStages[0].sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStages[0].stage  = VK_SHADER_STAGE_VERTEX_BIT;
+    shaderStages[0].module = vertShaderModule;
+    shaderStages[0].pName  = "main";
+    shaderStages[1].sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStages[1].stage  = VK_SHADER_STAGE_FRAGMENT_BIT;
+    shaderStages[1].module = fragShaderModule;
+    shaderStages[1].pName  = "main";
+
+    VkVertexInputBindingDescription bindingDescription {};
+    bindingDescription.binding   = 0;
+    bindingDescription.stride    = sizeof(HudVertex);
+    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions {};
+    attributeDescriptions[0].location = 0;
+    attributeDescriptions[0].format   = VK_FORMAT_R32G32_SFLOAT;
+    attributeDescriptions[0].offset   = offsetof(HudVertex, position);
+    attributeDescriptions[1].location = 1;
+    attributeDescriptions[1].format   = VK_FORMAT_R32G32_SFLOAT;
+    attributeDescriptions[1].offset   = offsetof(HudVertex, texCoord);
+    attributeDescriptions[2].location = 2;
+    attributeDescriptions[2].format   = VK_FORMAT_R8G8B8A8_UNORM;
+    attributeDescriptions[2].offset   = offsetof(HudVertex, color);
+
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo {};
+    vertexInputInfo.sType                           = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInputInfo.vertexBindingDescriptionCount   = 1;
+    vertexInputInfo.pVertexBindingDescriptions      = &bindingDescription;
+    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+    vertexInputInfo.pVertexAttributeDescriptions    = attributeDescriptions.data();
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly {};
+    inputAssembly.sType    = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkPipelineViewportStateCreateInfo viewportState {};
+    viewportState.sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount  = 1;
+
+    VkPipelineRasterizationStateCreateInfo rasterizer {};
+    rasterizer.sType       = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizer.lineWidth   = 1.0F;
+    rasterizer.cullMode    = VK_CULL_MODE_NONE;
+    rasterizer.frontFace   = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+    VkPipelineMultisampleStateCreateInfo multisampling {};
+    multisampling.sType                = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    multisampling.minSampleShading     = 1.0F;
+
+    // on top of everything, in the order the quads were written
+    VkPipelineDepthStencilStateCreateInfo depthStencil {};
+    depthStencil.sType            = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable  = VK_FALSE;
+    depthStencil.depthWriteEnable = VK_FALSE;
+    depthStencil.depthCompareOp   = VK_COMPARE_OP_ALWAYS;
+    depthStencil.maxDepthBounds   = 1.0F;
+
+    // premultiplied alpha
+    VkPipelineColorBlendAttachmentState colorBlendAttachment {};
+    colorBlendAttachment.colorWriteMask =
+        VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    colorBlendAttachment.blendEnable         = VK_TRUE;
+    colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+    colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    colorBlendAttachment.colorBlendOp        = VK_BLEND_OP_ADD;
+    colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    colorBlendAttachment.alphaBlendOp        = VK_BLEND_OP_ADD;
+
+    // the overlay is not part of the scene, picking sees through it
+    VkPipelineColorBlendAttachmentState idBlendAttachment {};
+    idBlendAttachment.colorWriteMask = 0;
+    idBlendAttachment.blendEnable    = VK_FALSE;
+
+    std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachments(target.colorAttachmentCount,
+                                                                           idBlendAttachment);
+    colorBlendAttachments[0] = colorBlendAttachment;
+
+    VkPipelineColorBlendStateCreateInfo colorBlending {};
+    colorBlending.sType           = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlending.logicOpEnable   = VK_FALSE;
+    colorBlending.logicOp         = VK_LOGIC_OP_COPY;
+    colorBlending.attachmentCount = static_cast<uint32_t>(colorBlendAttachments.size());
+    colorBlending.pAttachments    = colorBlendAttachments.data();
+
+    VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+
+    VkPipelineDynamicStateCreateInfo dynamicState {};
+    dynamicState.sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = sizeof(dynamicStates) / sizeof(VkDynamicState);
+    dynamicState.pDynamicStates    = dynamicStates;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo {};
+    pipelineInfo.sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.pNext               = target.renderingInfo;
+    pipelineInfo.stageCount          = static_cast<uint32_t>(shaderStages.size());
+    pipelineInfo.pStages             = shaderStages.data();
+    pipelineInfo.pVertexInputState   = &vertexInputInfo;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState      = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState   = &multisampling;
+    pipelineInfo.pDepthStencilState  = &depthStencil;
+    pipelineInfo.pColorBlendState    = &colorBlending;
+    pipelineInfo.pDynamicState       = &dynamicState;
+    pipelineInfo.layout              = pipelineLayout_;
+    pipelineInfo.renderPass          = target.renderPass;
+    pipelineInfo.subpass             = target.subpass;
+    pipelineInfo.basePipelineIndex   = -1;
+
+    if (vkCreateGraphicsPipelines(device_, pipelineCache_, 1, &pipelineInfo, nullptr, &drawPipeline_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create hud draw pipeline!");
+    }
+
+    vkDestroyShaderModule(device_, fragShaderModule, nullptr);
+    vkDestroyShaderModule(device_, vertShaderModule, nullptr);
+}
+
+void VulkanHudRenderer::destroyDrawPipeline()
+{
+    vkDestroyPipeline(device_, drawPipeline_, nullptr);
+    drawPipeline_ = VK_NULL_HANDLE;
+}
+
+void VulkanHudRenderer::createFrameResources(uint32_t imageCount, uint32_t vertexCapacity)
+{
+    vertexCapacity_ = vertexCapacity;
+
+    frames_.resize(imageCount);
+    for (Frame& frame : frames_)
+    {
+        createBuffer(getBufferSize(),
+                     VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                     frame.buffer,
+                     frame.memory);
+
+        void* mapped = nullptr;
+        vkMapMemory(device_, frame.memory, 0, VK_WHOLE_SIZE, 0, &mapped);
+        frame.drawArgs = static_cast<VkDrawIndirectCommand*>(mapped);
+        frame.vertices = reinterpret_cast<HudVertex*>(static_cast<uint8_t*>(mapped) + getVertexOffset());
+
+        // nothing is drawn until the first overlay was built
+        *frame.drawArgs               = {};
+        frame.drawArgs->instanceCount = 1;
+    }
+}
+
+void VulkanHudRenderer::destroyFrameResources()
+{
+    for (const Frame& frame : frames_)
+    {
+        vkUnmapMemory(device_, frame.memory);
+        vkDestroyBuffer(device_, frame.buffer, nullptr);
+        vkFreeMemory(device_, frame.memory, nullptr);
+    }
+    frames_.clear();
+}
+
+HudVertex* VulkanHudRenderer::getVertices(uint32_t imageIndex) const
+{
+    return frames_[imageIndex].vertices;
+}
+
+void VulkanHudRenderer::setVertexCount(uint32_t imageIndex, uint32_t vertexCount) const
+{
+    frames_[imageIndex].drawArgs->vertexCount = vertexCount;
+}
+
+VkBuffer VulkanHudRenderer::getBuffer(uint32_t imageIndex) const
+{
+    return frames_[imageIndex].buffer;
+}
+
+VkDeviceSize VulkanHudRenderer::getVertexOffset()
+{
+    // the vertices are read as floats, keep them aligned to the vertex size
+    return sizeof(HudVertex) * ((sizeof(VkDrawIndirectCommand) + sizeof(HudVertex) - 1) / sizeof(HudVertex));
+}
+
+VkDeviceSize VulkanHudRenderer::getBufferSize() const
+{
+    return getVertexOffset() + sizeof(HudVertex) * vertexCapacity_;
+}
+
+void VulkanHudRenderer::createBuffer(VkDeviceSize          size,
+                                     VkBufferUsageFlags    usage,
+                                     VkMemoryPropertyFlags properties,
+                                     VkBuffer&             buffer,
+                                     VkDeviceMemory&       bufferMemory) const
+{
+    VkBufferCreateInfo bufferInfo {};
+    bufferInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size        = size;
+    bufferInfo.usage       = usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create hud buffer!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
+
+    VkMemoryAllocateInfo allocInfo {};
+    allocInfo.sType          = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    if (!VulkanUtils::findMemoryTypeIndex(
+            physicalDevice_, memRequirements.memoryTypeBits, properties, allocInfo.memoryTypeIndex))
+    {
+        LOG_FATAL("Failed to find a memory type for hud buffers!");
+    }
+
+    if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to allocate hud buffer memory!");
+    }
+    vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+}
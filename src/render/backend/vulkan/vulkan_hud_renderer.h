@@ -0,0 +1,87 @@
+#pragma once
+
+#include "foundation/async/task.h"
+#include "render/backend/vulkan/vulkan_draw_target.h"
+#include "render/backend/vulkan/vulkan_loader.h"
+#include "render/backend/vulkan/vulkan_upload_queue.h"
+#include "render/hud/perf_hud.h"
+#include "render/hud/sdf_font.h"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+// Draws the overlays built by PerfHud. Every swapchain image owns one persistently mapped host visible buffer that
+// starts with a VkDrawIndirectCommand followed by the vertices, the overlay of a frame is written into the buffer of
+// its image after the fence of the image signaled. The recorded draw reads its vertex count from the same buffer, so
+// the cached command buffers stay valid while the overlay changes every frame, and a hidden overlay is a draw of zero
+// vertices.
+class VulkanHudRenderer {
+public:
+    void create(VkPhysicalDevice physicalDevice, VkDevice device, VkPipelineCache pipelineCache, bool independentBlend);
+    void destroy();
+
+    // the distance field of the font, sampled by every quad of the overlay
+    Task<void> upload(VulkanUploadQueue& uploadQueue, const SdfFontAtlas& atlas);
+
+    // blended on top of the color attachment of the last pass, rebuilt with the scene pipelines
+    void createDrawPipeline(const VulkanDrawTarget&  target,
+                            const std::vector<char>& vertShaderCode,
+                            const std::vector<char>& fragShaderCode);
+    void destroyDrawPipeline();
+
+    // vertex buffers of vertexCapacity vertices, one per swapchain image
+    void createFrameResources(uint32_t imageCount, uint32_t vertexCapacity);
+    void destroyFrameResources();
+
+    // the image must not be in flight while its vertices are written
+    [[nodiscard]] HudVertex* getVertices(uint32_t imageIndex) const;
+    void                     setVertexCount(uint32_t imageIndex, uint32_t vertexCount) const;
+
+    [[nodiscard]] bool isReady() const { return atlasImage_ != VK_NULL_HANDLE && !frames_.empty(); }
+    [[nodiscard]] bool isDrawable() const { return isReady() && drawPipeline_ != VK_NULL_HANDLE; }
+
+    [[nodiscard]] VkPipeline       getDrawPipeline() const { return drawPipeline_; }
+    [[nodiscard]] VkPipelineLayout getPipelineLayout() const { return pipelineLayout_; }
+    [[nodiscard]] VkDescriptorSet  getDescriptorSet() const { return descriptorSet_; }
+    [[nodiscard]] uint32_t         getVertexCapacity() const { return vertexCapacity_; }
+
+    // the draw arguments at offset 0, the vertices at getVertexOffset()
+    [[nodiscard]] VkBuffer            getBuffer(uint32_t imageIndex) const;
+    [[nodiscard]] static VkDeviceSize getVertexOffset();
+    [[nodiscard]] VkDeviceSize        getBufferSize() const;
+
+private:
+    struct Frame
+    {
+        VkBuffer               buffer {VK_NULL_HANDLE};
+        VkDeviceMemory         memory {VK_NULL_HANDLE};
+        VkDrawIndirectCommand* drawArgs {nullptr};
+        HudVertex*             vertices {nullptr};
+    };
+
+    void createBuffer(VkDeviceSize          size,
+                      VkBufferUsageFlags    usage,
+                      VkMemoryPropertyFlags properties,
+                      VkBuffer&             buffer,
+                      VkDeviceMemory&       bufferMemory) const;
+
+    VkPhysicalDevice      physicalDevice_ {VK_NULL_HANDLE};
+    VkDevice              device_ {VK_NULL_HANDLE};
+    VkPipelineCache       pipelineCache_ {VK_NULL_HANDLE};
+    VkDescriptorSetLayout descriptorSetLayout_ {VK_NULL_HANDLE};
+    VkPipelineLayout      pipelineLayout_ {VK_NULL_HANDLE};
+    VkPipeline            drawPipeline_ {VK_NULL_HANDLE};
+    VkDescriptorPool      descriptorPool_ {VK_NULL_HANDLE};
+    VkDescriptorSet       descriptorSet_ {VK_NULL_HANDLE};
+    VkSampler             sampler_ {VK_NULL_HANDLE};
+    bool                  independentBlend_ {false};
+
+    VkImage        atlasImage_ {VK_NULL_HANDLE};
+    VkDeviceMemory atlasMemory_ {VK_NULL_HANDLE};
+    VkImageView    atlasView_ {VK_NULL_HANDLE};
+    uint32_t       vertexCapacity_ {0};
+
+    std::vector<Frame> frames_;
+};
@@ -0,0 +1,566 @@
+#include "render/backend/vulkan/vulkan_impostor_renderer.h"
+#include "render/backend/vulkan/vulkan_utils.h"
+
+#include "foundation/log/log_system.h"
+
+#include <array>
+#include <cstddef>
+#include <utility>
+
+namespace
+{
+// scene uniform buffer, albedo atlas, normal atlas
+constexpr uint32_t IMPOSTOR_BINDING_COUNT = 3;
+
+// constant_id of the grid size in impostor.vert
+constexpr uint32_t FRAMES_PER_SIDE_CONSTANT = 0;
+
+constexpr VkFormat ALBEDO_FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
+constexpr VkFormat NORMAL_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+
+// where the pixels of each atlas level start in the staging data
+struct LevelUpload
+{
+    VkImage      image {VK_NULL_HANDLE};
+    uint32_t     level {0};
+    uint32_t     width {0};
+    uint32_t     height {0};
+    VkDeviceSize offset {0};
+};
+
+void recordAtlasBarrier(VkCommandBuffer      commandBuffer,
+                        VkImage              image,
+                        uint32_t             mipLevels,
+                        VkImageLayout        oldLayout,
+                        VkImageLayout        newLayout,
+                        VkAccessFlags        srcAccessMask,
+                        VkAccessFlags        dstAccessMask,
+                        VkPipelineStageFlags srcStage,
+                        VkPipelineStageFlags dstStage)
+{
+    VkImageMemoryBarrier barrier {};
+    barrier.sType                       = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask               = srcAccessMask;
+    barrier.dstAccessMask               = dstAccessMask;
+    barrier.oldLayout                   = oldLayout;
+    barrier.newLayout                   = newLayout;
+    barrier.srcQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image                       = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = mipLevels;
+    barrier.subresourceRange.layerCount = 1;
+
+    vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+} // namespace
+
+void VulkanImpostorRenderer::create(VkPhysicalDevice physicalDevice, VkDevice device, VkPipelineCache pipelineCache)
+{
+    physicalDevice_ = physicalDevice;
+    device_         = device;
+    pipelineCache_  = pipelineCache;
+
+    std::array<VkDescriptorSetLayoutBinding, IMPOSTOR_BINDING_COUNT> bindings {};
+    for (uint32_t binding = 0; binding < IMPOSTOR_BINDING_COUNT; binding++)
+    {
+        bindings[binding].binding         = binding;
+        bindings[binding].descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[binding].descriptorCount = 1;
+        bindings[binding].stageFlags      = VK_SHADER_STAGE_FRAGMENT_BIT;
+    }
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    bindings[0].stageFlags     = VK_SHADER_STAGE_VERTEX_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo {};
+    layoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings    = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(device_, &layoutInfo, nullptr, &descriptorSetLayout_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create impostor descriptor set layout!");
+    }
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo {};
+    pipelineLayoutInfo.sType          = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts    = &descriptorSetLayout_;
+
+    if (vkCreatePipelineLayout(device_, &pipelineLayoutInfo, nullptr, &pipelineLayout_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create impostor pipeline layout!");
+    }
+
+    // the silhouette of a view stays inside the circle its bounding sphere projects to, so filtering across the edge
+    // of a frame only mixes in transparent texels
+    VkSamplerCreateInfo samplerInfo {};
+    samplerInfo.sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter    = VK_FILTER_LINEAR;
+    samplerInfo.minFilter    = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.compareOp    = VK_COMPARE_OP_ALWAYS;
+    samplerInfo.minLod       = 0.0F;
+    samplerInfo.maxLod       = VK_LOD_CLAMP_NONE;
+    samplerInfo.borderColor  = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+
+    if (vkCreateSampler(device_, &samplerInfo, nullptr, &sampler_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create impostor sampler!");
+    }
+}
+
+void VulkanImpostorRenderer::destroy()
+{
+    destroyFrameResources();
+    destroyDrawPipeline();
+
+    destroyAtlasImage(albedo_);
+    destroyAtlasImage(normals_);
+
+    vkDestroyBuffer(device_, instanceBuffer_, nullptr);
+    vkFreeMemory(device_, instanceMemory_, nullptr);
+    instanceBuffer_ = VK_NULL_HANDLE;
+    instanceMemory_ = VK_NULL_HANDLE;
+    instanceCount_  = 0;
+
+    vkDestroySampler(device_, sampler_, nullptr);
+    vkDestroyPipelineLayout(device_, pipelineLayout_, nullptr);
+    vkDestroyDescriptorSetLayout(device_, descriptorSetLayout_, nullptr);
+    sampler_             = VK_NULL_HANDLE;
+    pipelineLayout_      = VK_NULL_HANDLE;
+    descriptorSetLayout_ = VK_NULL_HANDLE;
+}
+
+Task<void> VulkanImpostorRenderer::upload(VulkanUploadQueue&                   uploadQueue,
+                                          const ImpostorAtlas&                 atlas,
+                                          const std::vector<ImpostorInstance>& instances)
+{
+    if (atlas.isEmpty() || instances.empty())
+        co_return;
+
+    framesPerSide_ = atlas.framesPerSide;
+    mipLevels_     = static_cast<uint32_t>(atlas.albedo.size());
+    instanceCount_ = static_cast<uint32_t>(instances.size());
+
+    createAtlasImage(atlas.albedo, ALBEDO_FORMAT, albedo_);
+    createAtlasImage(atlas.normals, NORMAL_FORMAT, normals_);
+    createBuffer(sizeof(ImpostorInstance) * instances.size(),
+                 VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                 instanceBuffer_,
+                 instanceMemory_);
+
+    // every level of both atlases goes through one staging buffer, the mips were filtered by the baker already
+    const std::array<std::pair<VkImage, const std::vector<ImageAsset>*>, 2> chains = {{
+        {albedo_.image, &atlas.albedo},
+        {normals_.image, &atlas.normals},
+    }};
+
+    std::vector<uint8_t>     pixels;
+    std::vector<LevelUpload> levels;
+    for (const auto& [image, chain] : chains)
+    {
+        for (uint32_t level = 0; level < chain->size(); level++)
+        {
+            const ImageAsset& asset = (*chain)[level];
+            levels.push_back({image, level, asset.width, asset.height, pixels.size()});
+            pixels.insert(pixels.end(), asset.pixels.begin(), asset.pixels.end());
+        }
+    }
+
+    const auto recordAtlasUpload = [this, levels = std::move(levels)](VkCommandBuffer commandBuffer,
+                                                                      VkBuffer        stagingBuffer,
+                                                                      VkDeviceSize    stagingOffset) {
+        for (const VkImage image : {albedo_.image, normals_.image})
+        {
+            recordAtlasBarrier(commandBuffer,
+                               image,
+                               mipLevels_,
+                               VK_IMAGE_LAYOUT_UNDEFINED,
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               0,
+                               VK_ACCESS_TRANSFER_WRITE_BIT,
+                               VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                               VK_PIPELINE_STAGE_TRANSFER_BIT);
+        }
+
+        for (const LevelUpload& level : levels)
+        {
+            VkBufferImageCopy region {};
+            region.bufferOffset                = stagingOffset + level.offset;
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel   = level.level;
+            region.imageSubresource.layerCount = 1;
+            region.imageExtent                 = {level.width, level.height, 1};
+
+            vkCmdCopyBufferToImage(
+                commandBuffer, stagingBuffer, level.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        }
+
+        for (const VkImage image : {albedo_.image, normals_.image})
+        {
+            recordAtlasBarrier(commandBuffer,
+                               image,
+                               mipLevels_,
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                               VK_ACCESS_TRANSFER_WRITE_BIT,
+                               VK_ACCESS_SHADER_READ_BIT,
+                               VK_PIPELINE_STAGE_TRANSFER_BIT,
+                               VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+        }
+    };
+
+    const auto recordInstanceUpload = [target = instanceBuffer_, size = sizeof(ImpostorInstance) * instances.size()](
+                                          VkCommandBuffer commandBuffer,
+                                          VkBuffer        stagingBuffer,
+                                          VkDeviceSize    stagingOffset) {
+        VkBufferCopy copyRegion {};
+        copyRegion.srcOffset = stagingOffset;
+        copyRegion.size      = size;
+        vkCmdCopyBuffer(commandBuffer, stagingBuffer, target, 1, &copyRegion);
+    };
+
+    co_await uploadQueue.upload(pixels.data(), pixels.size(), recordAtlasUpload);
+    co_await uploadQueue.upload(instances.data(), sizeof(ImpostorInstance) * instances.size(), recordInstanceUpload);
+
+    LOG_INFO("Impostors: {} instances, {}x{} views of {} texels in {} mips",
+             instanceCount_,
+             framesPerSide_,
+             framesPerSide_,
+             atlas.frameResolution,
+             mipLevels_);
+}
+
+void VulkanImpostorRenderer::createDrawPipeline(const VulkanDrawTarget&  target,
+                                                const std::vector<char>& vertShaderCode,
+                                                const std::vector<char>& fragShaderCode)
+{
+    const auto createModule = [this](const std::vector<char>& code) {
+        VkShaderModuleCreateInfo moduleInfo {};
+        moduleInfo.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleInfo.codeSize = code.size();
+        moduleInfo.pCode    = reinterpret_cast<const uint32_t*>(code.data());
+
+        VkShaderModule shaderModule = VK_NULL_HANDLE;
+        if (vkCreateShaderModule(device_, &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS)
+        {
+            LOG_FATAL("Failed to create impostor shader module!");
+        }
+        return shaderModule;
+    };
+
+    VkShaderModule vertShaderModule = createModule(vertShaderCode);
+    VkShaderModule fragShaderModule = createModule(fragShaderCode);
+
+    VkSpecializationMapEntry specializationEntry {};
+    specializationEntry.constantID = FRAMES_PER_SIDE_CONSTANT;
+    specializationEntry.offset     = 0;
+    specializationEntry.size       = sizeof(uint32_t);
+
+    VkSpecializationInfo specializationInfo {};
+    specializationInfo.mapEntryCount = 1;
+    specializationInfo.pMapEntries   = &specializationEntry;
+    specializationInfo.dataSize      = sizeof(uint32_t);
+    specializationInfo.pData         = &framesPerSide_;
+
+    std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages {};
+    shaderStages[0].sType               = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStages[0].stage               = VK_SHADER_STAGE_VERTEX_BIT;
+    shaderStages[0].module              = vertShaderModule;
+    shaderStages[0].pName               = "main";
+    shaderStages[0].pSpecializationInfo = &specializationInfo;
+    shaderStages[1].sType               = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStages[1].stage               = VK_SHADER_STAGE_FRAGMENT_BIT;
+    shaderStages[1].module              = fragShaderModule;
+    shaderStages[1].pName               = "main";
+
+    // the quad corners come from the vertex index, the copy from the instance buffer
+    VkVertexInputBindingDescription bindingDescription {};
+    bindingDescription.binding   = 0;
+    bindingDescription.stride    = sizeof(ImpostorInstance);
+    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+    std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions {};
+    attributeDescriptions[0].location = 0;
+    attributeDescriptions[0].format   = VK_FORMAT_R32G32B32A32_SFLOAT;
+    attributeDescriptions[0].offset   = offsetof(ImpostorInstance, center);
+    attributeDescriptions[1].location = 1;
+    attributeDescriptions[1].format   = VK_FORMAT_R32_SFLOAT;
+    attributeDescriptions[1].offset   = offsetof(ImpostorInstance, yaw);
+    attributeDescriptions[2].location = 2;
+    attributeDescriptions[2].format   = VK_FORMAT_R32_UINT;
+    attributeDescriptions[2].offset   = offsetof(ImpostorInstance, objectId);
+
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo {};
+    vertexInputInfo.sType                           = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInputInfo.vertexBindingDescriptionCount   = 1;
+    vertexInputInfo.pVertexBindingDescriptions      = &bindingDescription;
+    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+    vertexInputInfo.pVertexAttributeDescriptions    = attributeDescriptions.data();
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly {};
+    inputAssembly.sType    = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkPipelineViewportStateCreateInfo viewportState {};
+    viewportState.sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount  = 1;
+
+    VkPipelineRasterizationStateCreateInfo rasterizer {};
+    rasterizer.sType       = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizer.lineWidth   = 1.0F;
+    rasterizer.cullMode    = VK_CULL_MODE_NONE;
+    rasterizer.frontFace   = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+    VkPipelineMultisampleStateCreateInfo multisampling {};
+    multisampling.sType                = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    multisampling.minSampleShading     = 1.0F;
+
+    // alpha tested, so the impostors are opaque geometry as far as the depth buffer is concerned
+    VkPipelineDepthStencilStateCreateInfo depthStencil {};
+    depthStencil.sType            = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable  = VK_TRUE;
+    depthStencil.depthWriteEnable = VK_TRUE;
+    depthStencil.depthCompareOp   = VK_COMPARE_OP_LESS;
+    depthStencil.maxDepthBounds   = 1.0F;
+
+    // the id attachment gets the object id of the copy, like the mesh it stands in for
+    VkPipelineColorBlendAttachmentState colorBlendAttachment {};
+    colorBlendAttachment.colorWriteMask =
+        VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    colorBlendAttachment.blendEnable = VK_FALSE;
+
+    const std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachments(target.colorAttachmentCount,
+                                                                                 colorBlendAttachment);
+
+    VkPipelineColorBlendStateCreateInfo colorBlending {};
+    colorBlending.sType           = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlending.logicOpEnable   = VK_FALSE;
+    colorBlending.logicOp         = VK_LOGIC_OP_COPY;
+    colorBlending.attachmentCount = static_cast<uint32_t>(colorBlendAttachments.size());
+    colorBlending.pAttachments    = colorBlendAttachments.data();
+
+    VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+
+    VkPipelineDynamicStateCreateInfo dynamicState {};
+    dynamicState.sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = sizeof(dynamicStates) / sizeof(VkDynamicState);
+    dynamicState.pDynamicStates    = dynamicStates;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo {};
+    pipelineInfo.sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.pNext               = target.renderingInfo;
+    pipelineInfo.stageCount          = static_cast<uint32_t>(shaderStages.size());
+    pipelineInfo.pStages             = shaderStages.data();
+    pipelineInfo.pVertexInputState   = &vertexInputInfo;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState      = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState   = &multisampling;
+    pipelineInfo.pDepthStencilState  = &depthStencil;
+    pipelineInfo.pColorBlendState    = &colorBlending;
+    pipelineInfo.pDynamicState       = &dynamicState;
+    pipelineInfo.layout              = pipelineLayout_;
+    pipelineInfo.renderPass          = target.renderPass;
+    pipelineInfo.subpass             = target.subpass;
+    pipelineInfo.basePipelineIndex   = -1;
+
+    if (vkCreateGraphicsPipelines(device_, pipelineCache_, 1, &pipelineInfo, nullptr, &drawPipeline_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create impostor draw pipeline!");
+    }
+
+    vkDestroyShaderModule(device_, fragShaderModule, nullptr);
+    vkDestroyShaderModule(device_, vertShaderModule, nullptr);
+}
+
+void VulkanImpostorRenderer::destroyDrawPipeline()
+{
+    vkDestroyPipeline(device_, drawPipeline_, nullptr);
+    drawPipeline_ = VK_NULL_HANDLE;
+}
+
+void VulkanImpostorRenderer::createFrameResources(const std::vector<VkBuffer>& uniformBuffers)
+{
+    // nothing was baked, the frame has no impostors to draw
+    if (instanceBuffer_ == VK_NULL_HANDLE)
+        return;
+
+    const auto imageCount = static_cast<uint32_t>(uniformBuffers.size());
+
+    std::array<VkDescriptorPoolSize, 2> poolSizes {};
+    poolSizes[0].type            = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    poolSizes[0].descriptorCount = imageCount;
+    poolSizes[1].type            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[1].descriptorCount = imageCount * (IMPOSTOR_BINDING_COUNT - 1);
+
+    VkDescriptorPoolCreateInfo poolInfo {};
+    poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes    = poolSizes.data();
+    poolInfo.maxSets       = imageCount;
+
+    if (vkCreateDescriptorPool(device_, &poolInfo, nullptr, &descriptorPool_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create impostor descriptor pool!");
+    }
+
+    const std::vector<VkDescriptorSetLayout> layouts(imageCount, descriptorSetLayout_);
+
+    VkDescriptorSetAllocateInfo allocInfo {};
+    allocInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool     = descriptorPool_;
+    allocInfo.descriptorSetCount = imageCount;
+    allocInfo.pSetLayouts        = layouts.data();
+
+    descriptorSets_.resize(imageCount);
+    if (vkAllocateDescriptorSets(device_, &allocInfo, descriptorSets_.data()) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to allocate impostor descriptor sets!");
+    }
+
+    const std::array<VkDescriptorImageInfo, IMPOSTOR_BINDING_COUNT - 1> imageInfos = {{
+        {sampler_, albedo_.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
+        {sampler_, normals_.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
+    }};
+
+    for (uint32_t image = 0; image < imageCount; image++)
+    {
+        const VkDescriptorBufferInfo bufferInfo {uniformBuffers[image], 0, VK_WHOLE_SIZE};
+
+        std::array<VkWriteDescriptorSet, IMPOSTOR_BINDING_COUNT> descriptorWrites {};
+        for (uint32_t binding = 0; binding < IMPOSTOR_BINDING_COUNT; binding++)
+        {
+            descriptorWrites[binding].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descriptorWrites[binding].dstSet          = descriptorSets_[image];
+            descriptorWrites[binding].dstBinding      = binding;
+            descriptorWrites[binding].descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            descriptorWrites[binding].descriptorCount = 1;
+        }
+        descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        descriptorWrites[0].pBufferInfo    = &bufferInfo;
+        descriptorWrites[1].pImageInfo     = &imageInfos[0];
+        descriptorWrites[2].pImageInfo     = &imageInfos[1];
+
+        vkUpdateDescriptorSets(
+            device_, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+    }
+}
+
+void VulkanImpostorRenderer::destroyFrameResources()
+{
+    descriptorSets_.clear();
+
+    // frees the descriptor sets along with it
+    vkDestroyDescriptorPool(device_, descriptorPool_, nullptr);
+    descriptorPool_ = VK_NULL_HANDLE;
+}
+
+void VulkanImpostorRenderer::createAtlasImage(const std::vector<ImageAsset>& levels,
+                                              VkFormat                       format,
+                                              AtlasImage&                    atlasImage) const
+{
+    VkImageCreateInfo imageInfo {};
+    imageInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType     = VK_IMAGE_TYPE_2D;
+    imageInfo.extent        = {levels.front().width, levels.front().height, 1};
+    imageInfo.mipLevels     = static_cast<uint32_t>(levels.size());
+    imageInfo.arrayLayers   = 1;
+    imageInfo.format        = format;
+    imageInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage         = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateImage(device_, &imageInfo, nullptr, &atlasImage.image) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create impostor atlas image!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device_, atlasImage.image, &memRequirements);
+
+    VkMemoryAllocateInfo allocInfo {};
+    allocInfo.sType          = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    if (!VulkanUtils::findMemoryTypeIndex(physicalDevice_,
+                                          memRequirements.memoryTypeBits,
+                                          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                          allocInfo.memoryTypeIndex))
+    {
+        LOG_FATAL("Failed to find a memory type for impostor atlases!");
+    }
+
+    if (vkAllocateMemory(device_, &allocInfo, nullptr, &atlasImage.memory) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to allocate impostor atlas memory!");
+    }
+    vkBindImageMemory(device_, atlasImage.image, atlasImage.memory, 0);
+
+    VkImageViewCreateInfo viewInfo {};
+    viewInfo.sType                       = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image                       = atlasImage.image;
+    viewInfo.viewType                    = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format                      = format;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.levelCount = imageInfo.mipLevels;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    if (vkCreateImageView(device_, &viewInfo, nullptr, &atlasImage.view) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create impostor atlas image view!");
+    }
+}
+
+void VulkanImpostorRenderer::destroyAtlasImage(AtlasImage& atlasImage) const
+{
+    vkDestroyImageView(device_, atlasImage.view, nullptr);
+    vkDestroyImage(device_, atlasImage.image, nullptr);
+    vkFreeMemory(device_, atlasImage.memory, nullptr);
+    atlasImage = {};
+}
+
+void VulkanImpostorRenderer::createBuffer(VkDeviceSize          size,
+                                          VkBufferUsageFlags    usage,
+                                          VkMemoryPropertyFlags properties,
+                                          VkBuffer&             buffer,
+                                          VkDeviceMemory&       bufferMemory) const
+{
+    VkBufferCreateInfo bufferInfo {};
+    bufferInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size        = size;
+    bufferInfo.usage       = usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create impostor buffer!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
+
+    VkMemoryAllocateInfo allocInfo {};
+    allocInfo.sType          = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    if (!VulkanUtils::findMemoryTypeIndex(
+            physicalDevice_, memRequirements.memoryTypeBits, properties, allocInfo.memoryTypeIndex))
+    {
+        LOG_FATAL("Failed to find a memory type for impostor buffers!");
+    }
+
+    if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to allocate impostor buffer memory!");
+    }
+    vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "foundation/async/task.h"
+#include "render/asset/impostor_baker.h"
+#include "render/backend/vulkan/vulkan_draw_target.h"
+#include "render/backend/vulkan/vulkan_loader.h"
+#include "render/backend/vulkan/vulkan_upload_queue.h"
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+// One copy of the baked mesh, read per instance by impostor.vert.
+struct ImpostorInstance
+{
+    glm::vec3 center {0.0F}; // bounding sphere of the copy in scene space
+    float     radius {0.0F};
+    float     yaw {0.0F}; // rotation of the copy about z
+    uint32_t  objectId {0};
+    float     padding[2] {};
+};
+
+static_assert(sizeof(ImpostorInstance) == 32, "ImpostorInstance must match the instance input of impostor.vert");
+
+struct ImpostorDraw
+{
+    uint32_t firstInstance {0};
+    uint32_t instanceCount {0};
+
+    bool operator==(const ImpostorDraw& other) const
+    {
+        return firstInstance == other.firstInstance && instanceCount == other.instanceCount;
+    }
+};
+
+// Draws far copies of a mesh as one camera facing quad each, textured from an octahedral impostor atlas. The vertex
+// shader picks the baked view closest to the direction the camera sees a copy from and lays the quad out in the basis
+// of that view, the fragment shader alpha tests the silhouette and lights the baked normals. Every copy is an instance
+// of one buffer, so any run of consecutive copies is a single draw of six vertices.
+class VulkanImpostorRenderer {
+public:
+    void create(VkPhysicalDevice physicalDevice, VkDevice device, VkPipelineCache pipelineCache);
+    void destroy();
+
+    // uploads both atlases with their mip chains and the instances, before the frame resources are created
+    Task<void> upload(VulkanUploadQueue&                   uploadQueue,
+                      const ImpostorAtlas&                 atlas,
+                      const std::vector<ImpostorInstance>& instances);
+
+    // rebuilt with the scene pipelines, the grid size of the atlas is specialized into the vertex shader
+    void createDrawPipeline(const VulkanDrawTarget&  target,
+                            const std::vector<char>& vertShaderCode,
+                            const std::vector<char>& fragShaderCode);
+    void destroyDrawPipeline();
+
+    // one descriptor set per swapchain image around the scene uniform buffer of that image
+    void createFrameResources(const std::vector<VkBuffer>& uniformBuffers);
+    void destroyFrameResources();
+
+    [[nodiscard]] bool isReady() const { return instanceBuffer_ != VK_NULL_HANDLE && !descriptorSets_.empty(); }
+    [[nodiscard]] bool isDrawable() const { return isReady() && drawPipeline_ != VK_NULL_HANDLE; }
+
+    [[nodiscard]] VkPipeline       getDrawPipeline() const { return drawPipeline_; }
+    [[nodiscard]] VkPipelineLayout getPipelineLayout() const { return pipelineLayout_; }
+    [[nodiscard]] VkDescriptorSet  getDescriptorSet(uint32_t imageIndex) const { return descriptorSets_[imageIndex]; }
+    [[nodiscard]] VkBuffer         getInstanceBuffer() const { return instanceBuffer_; }
+    [[nodiscard]] uint32_t         getInstanceCount() const { return instanceCount_; }
+
+private:
+    struct AtlasImage
+    {
+        VkImage        image {VK_NULL_HANDLE};
+        VkDeviceMemory memory {VK_NULL_HANDLE};
+        VkImageView    view {VK_NULL_HANDLE};
+    };
+
+    void createAtlasImage(const std::vector<ImageAsset>& levels, VkFormat format, AtlasImage& atlasImage) const;
+    void destroyAtlasImage(AtlasImage& atlasImage) const;
+
+    void createBuffer(VkDeviceSize          size,
+                      VkBufferUsageFlags    usage,
+                      VkMemoryPropertyFlags properties,
+                      VkBuffer&             buffer,
+                      VkDeviceMemory&       bufferMemory) const;
+
+    VkPhysicalDevice      physicalDevice_ {VK_NULL_HANDLE};
+    VkDevice              device_ {VK_NULL_HANDLE};
+    VkPipelineCache       pipelineCache_ {VK_NULL_HANDLE};
+    VkDescriptorSetLayout descriptorSetLayout_ {VK_NULL_HANDLE};
+    VkPipelineLayout      pipelineLayout_ {VK_NULL_HANDLE};
+    VkPipeline            drawPipeline_ {VK_NULL_HANDLE};
+    VkDescriptorPool      descriptorPool_ {VK_NULL_HANDLE};
+    VkSampler             sampler_ {VK_NULL_HANDLE};
+
+    AtlasImage     albedo_ {};
+    AtlasImage     normals_ {};
+    uint32_t       framesPerSide_ {1};
+    uint32_t       mipLevels_ {1};
+    VkBuffer       instanceBuffer_ {VK_NULL_HANDLE};
+    VkDeviceMemory instanceMemory_ {VK_NULL_HANDLE};
+    uint32_t       instanceCount_ {0};
+
+    std::vector<VkDescriptorSet> descriptorSets_;
+};
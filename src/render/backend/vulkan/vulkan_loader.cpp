@@ -0,0 +1,117 @@
+#include "render/backend/vulkan/vulkan_loader.h"
+
+#include "foundation/log/log_system.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+#define VULKAN_DEFINE_FUNCTION(name) PFN_##name name {nullptr};
+VULKAN_EXPORTED_FUNCTIONS(VULKAN_DEFINE_FUNCTION)
+VULKAN_GLOBAL_FUNCTIONS(VULKAN_DEFINE_FUNCTION)
+VULKAN_INSTANCE_FUNCTIONS(VULKAN_DEFINE_FUNCTION)
+VULKAN_DEVICE_FUNCTIONS(VULKAN_DEFINE_FUNCTION)
+#undef VULKAN_DEFINE_FUNCTION
+
+namespace
+{
+#ifdef _WIN32
+HMODULE gLoaderLibrary {nullptr};
+#else
+void* gLoaderLibrary {nullptr};
+#endif
+} // namespace
+
+namespace VulkanLoader
+{
+void initialize()
+{
+    if (gLoaderLibrary != nullptr)
+        return;
+
+#ifdef _WIN32
+    gLoaderLibrary = LoadLibraryA("vulkan-1.dll");
+    if (gLoaderLibrary == nullptr)
+    {
+        LOG_FATAL("Failed to load vulkan-1.dll, is a Vulkan driver installed?");
+    }
+    vkGetInstanceProcAddr =
+        reinterpret_cast<PFN_vkGetInstanceProcAddr>(GetProcAddress(gLoaderLibrary, "vkGetInstanceProcAddr"));
+#else
+    gLoaderLibrary = dlopen("libvulkan.so.1", RTLD_NOW | RTLD_LOCAL);
+    if (gLoaderLibrary == nullptr)
+    {
+        LOG_FATAL("Failed to load libvulkan.so.1, is a Vulkan driver installed?");
+    }
+    vkGetInstanceProcAddr = reinterpret_cast<PFN_vkGetInstanceProcAddr>(dlsym(gLoaderLibrary, "vkGetInstanceProcAddr"));
+#endif
+
+    if (vkGetInstanceProcAddr == nullptr)
+    {
+        LOG_FATAL("The Vulkan loader does not export vkGetInstanceProcAddr!");
+    }
+
+    // vkEnumerateInstanceVersion is missing from 1.0 loaders, callers check it for null
+#define VULKAN_LOAD_FUNCTION(name) name = reinterpret_cast<PFN_##name>(vkGetInstanceProcAddr(nullptr, #name));
+    VULKAN_GLOBAL_FUNCTIONS(VULKAN_LOAD_FUNCTION)
+#undef VULKAN_LOAD_FUNCTION
+
+    if (vkCreateInstance == nullptr)
+    {
+        LOG_FATAL("Failed to load the global Vulkan functions!");
+    }
+}
+
+void shutdown()
+{
+    if (gLoaderLibrary == nullptr)
+        return;
+
+#ifdef _WIN32
+    FreeLibrary(gLoaderLibrary);
+#else
+    dlclose(gLoaderLibrary);
+#endif
+    gLoaderLibrary        = nullptr;
+    vkGetInstanceProcAddr = nullptr;
+}
+
+void loadInstance(VkInstance instance)
+{
+#define VULKAN_LOAD_FUNCTION(name) name = reinterpret_cast<PFN_##name>(vkGetInstanceProcAddr(instance, #name));
+    VULKAN_INSTANCE_FUNCTIONS(VULKAN_LOAD_FUNCTION)
+#undef VULKAN_LOAD_FUNCTION
+}
+
+void loadDevice(VkDevice device)
+{
+    VulkanDeviceTable table {};
+    loadDeviceTable(device, table);
+
+#define VULKAN_ASSIGN_FUNCTION(name) name = table.name;
+    VULKAN_DEVICE_FUNCTIONS(VULKAN_ASSIGN_FUNCTION)
+#undef VULKAN_ASSIGN_FUNCTION
+}
+
+void loadDeviceTable(VkDevice device, VulkanDeviceTable& table)
+{
+#define VULKAN_LOAD_FUNCTION(name) table.name = reinterpret_cast<PFN_##name>(vkGetDeviceProcAddr(device, #name));
+    VULKAN_DEVICE_FUNCTIONS(VULKAN_LOAD_FUNCTION)
+#undef VULKAN_LOAD_FUNCTION
+}
+
+void loadTrampolineTable(VkInstance instance, VulkanDeviceTable& table)
+{
+#define VULKAN_LOAD_FUNCTION(name) table.name = reinterpret_cast<PFN_##name>(vkGetInstanceProcAddr(instance, #name));
+    VULKAN_DEVICE_FUNCTIONS(VULKAN_LOAD_FUNCTION)
+#undef VULKAN_LOAD_FUNCTION
+}
+} // namespace VulkanLoader
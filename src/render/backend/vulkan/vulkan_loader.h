@@ -0,0 +1,175 @@
+#pragma once
+
+#include "render/backend/vulkan/vulkan_config.h"
+
+#include <vulkan/vulkan.h>
+
+// The project is built with VK_NO_PROTOTYPES, every vk* symbol below is a function pointer resolved at runtime instead
+// of an import from vulkan-1.lib. Statically linked calls go through the loader trampoline, which looks up the
+// dispatch table of the handle on every call; device-level pointers fetched with vkGetDeviceProcAddr jump straight
+// into the driver (or the first enabled layer).
+
+#define VULKAN_EXPORTED_FUNCTIONS(X) X(vkGetInstanceProcAddr)
+
+#define VULKAN_GLOBAL_FUNCTIONS(X) \
+    X(vkCreateInstance) \
+    X(vkEnumerateInstanceExtensionProperties) \
+    X(vkEnumerateInstanceLayerProperties) \
+    X(vkEnumerateInstanceVersion)
+
+#define VULKAN_INSTANCE_FUNCTIONS(X) \
+    X(vkDestroyInstance) \
+    X(vkEnumeratePhysicalDevices) \
+    X(vkGetPhysicalDeviceProperties) \
+    X(vkGetPhysicalDeviceFeatures) \
+    X(vkGetPhysicalDeviceFeatures2) \
+    X(vkGetPhysicalDeviceFormatProperties) \
+    X(vkGetPhysicalDeviceMemoryProperties) \
+    X(vkGetPhysicalDeviceMemoryProperties2) \
+    X(vkGetPhysicalDeviceQueueFamilyProperties) \
+    X(vkGetPhysicalDeviceSurfaceSupportKHR) \
+    X(vkGetPhysicalDeviceSurfaceCapabilitiesKHR) \
+    X(vkGetPhysicalDeviceSurfaceFormatsKHR) \
+    X(vkGetPhysicalDeviceSurfacePresentModesKHR) \
+    X(vkDestroySurfaceKHR) \
+    X(vkEnumerateDeviceExtensionProperties) \
+    X(vkCreateDevice) \
+    X(vkGetDeviceProcAddr) \
+    X(vkCreateDebugUtilsMessengerEXT) \
+    X(vkDestroyDebugUtilsMessengerEXT)
+
+#define VULKAN_CORE_DEVICE_FUNCTIONS(X) \
+    X(vkDestroyDevice) \
+    X(vkGetDeviceQueue) \
+    X(vkDeviceWaitIdle) \
+    X(vkQueueSubmit) \
+    X(vkQueueWaitIdle) \
+    X(vkAllocateMemory) \
+    X(vkFreeMemory) \
+    X(vkMapMemory) \
+    X(vkUnmapMemory) \
+    X(vkInvalidateMappedMemoryRanges) \
+    X(vkGetDeviceMemoryCommitment) \
+    X(vkCreateBuffer) \
+    X(vkDestroyBuffer) \
+    X(vkBindBufferMemory) \
+    X(vkGetBufferMemoryRequirements) \
+    X(vkCreateImage) \
+    X(vkDestroyImage) \
+    X(vkBindImageMemory) \
+    X(vkGetImageMemoryRequirements) \
+    X(vkCreateImageView) \
+    X(vkDestroyImageView) \
+    X(vkCreateSampler) \
+    X(vkDestroySampler) \
+    X(vkCreateShaderModule) \
+    X(vkDestroyShaderModule) \
+    X(vkCreateRenderPass) \
+    X(vkDestroyRenderPass) \
+    X(vkCreateFramebuffer) \
+    X(vkDestroyFramebuffer) \
+    X(vkCreateDescriptorSetLayout) \
+    X(vkDestroyDescriptorSetLayout) \
+    X(vkCreatePipelineLayout) \
+    X(vkDestroyPipelineLayout) \
+    X(vkCreatePipelineCache) \
+    X(vkDestroyPipelineCache) \
+    X(vkCreateGraphicsPipelines) \
+    X(vkCreateComputePipelines) \
+    X(vkDestroyPipeline) \
+    X(vkCreateDescriptorPool) \
+    X(vkDestroyDescriptorPool) \
+    X(vkAllocateDescriptorSets) \
+    X(vkUpdateDescriptorSets) \
+    X(vkCreateCommandPool) \
+    X(vkDestroyCommandPool) \
+    X(vkAllocateCommandBuffers) \
+    X(vkFreeCommandBuffers) \
+    X(vkBeginCommandBuffer) \
+    X(vkEndCommandBuffer) \
+    X(vkCreateFence) \
+    X(vkDestroyFence) \
+    X(vkResetFences) \
+    X(vkWaitForFences) \
+    X(vkGetFenceStatus) \
+    X(vkCreateSemaphore) \
+    X(vkDestroySemaphore) \
+    X(vkCreateQueryPool) \
+    X(vkDestroyQueryPool) \
+    X(vkGetQueryPoolResults) \
+    X(vkCmdBeginRenderPass) \
+    X(vkCmdNextSubpass) \
+    X(vkCmdEndRenderPass) \
+    X(vkCmdExecuteCommands) \
+    X(vkCmdBindPipeline) \
+    X(vkCmdBindDescriptorSets) \
+    X(vkCmdBindVertexBuffers) \
+    X(vkCmdBindIndexBuffer) \
+    X(vkCmdSetViewport) \
+    X(vkCmdSetScissor) \
+    X(vkCmdDraw) \
+    X(vkCmdDrawIndexed) \
+    X(vkCmdDrawIndirect) \
+    X(vkCmdDispatch) \
+    X(vkCmdDispatchIndirect) \
+    X(vkCmdPushConstants) \
+    X(vkCmdPipelineBarrier) \
+    X(vkCmdCopyBuffer) \
+    X(vkCmdCopyBufferToImage) \
+    X(vkCmdCopyImageToBuffer) \
+    X(vkCmdBlitImage) \
+    X(vkCmdResetQueryPool) \
+    X(vkCmdCopyQueryPoolResults) \
+    X(vkCmdWriteTimestamp) \
+    X(vkCreateSwapchainKHR) \
+    X(vkDestroySwapchainKHR) \
+    X(vkGetSwapchainImagesKHR) \
+    X(vkAcquireNextImageKHR) \
+    X(vkQueuePresentKHR)
+
+#if VULKAN_HAS_DYNAMIC_RENDERING
+#define VULKAN_EXTENSION_DEVICE_FUNCTIONS(X) \
+    X(vkCmdBeginRenderingKHR) \
+    X(vkCmdEndRenderingKHR)
+#else
+#define VULKAN_EXTENSION_DEVICE_FUNCTIONS(X)
+#endif
+
+#define VULKAN_DEVICE_FUNCTIONS(X) \
+    VULKAN_CORE_DEVICE_FUNCTIONS(X) \
+    VULKAN_EXTENSION_DEVICE_FUNCTIONS(X)
+
+#define VULKAN_DECLARE_FUNCTION(name) extern PFN_##name name;
+VULKAN_EXPORTED_FUNCTIONS(VULKAN_DECLARE_FUNCTION)
+VULKAN_GLOBAL_FUNCTIONS(VULKAN_DECLARE_FUNCTION)
+VULKAN_INSTANCE_FUNCTIONS(VULKAN_DECLARE_FUNCTION)
+VULKAN_DEVICE_FUNCTIONS(VULKAN_DECLARE_FUNCTION)
+#undef VULKAN_DECLARE_FUNCTION
+
+// Device-level entry points of one VkDevice. Functions of extensions the device was created without stay null.
+struct VulkanDeviceTable
+{
+#define VULKAN_TABLE_MEMBER(name) PFN_##name name {nullptr};
+    VULKAN_DEVICE_FUNCTIONS(VULKAN_TABLE_MEMBER)
+#undef VULKAN_TABLE_MEMBER
+};
+
+namespace VulkanLoader
+{
+// opens the Vulkan loader library and resolves the global functions, has to run before any other vk call
+void initialize();
+void shutdown();
+
+// instance-level functions of extensions that were not enabled stay null
+void loadInstance(VkInstance instance);
+
+// resolves the device table through vkGetDeviceProcAddr and makes it the one the global vk* symbols point at,
+// the renderer only ever creates a single device
+void loadDevice(VkDevice device);
+
+void loadDeviceTable(VkDevice device, VulkanDeviceTable& table);
+
+// the same table resolved through vkGetInstanceProcAddr, every entry is a loader trampoline; this is what
+// linking against vulkan-1.lib used to call and is only kept around to measure the difference
+void loadTrampolineTable(VkInstance instance, VulkanDeviceTable& table);
+} // namespace VulkanLoader
@@ -0,0 +1,675 @@
+#include "render/backend/vulkan/vulkan_particle_system.h"
+#include "render/backend/vulkan/vulkan_utils.h"
+
+#include "foundation/log/log_system.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <utility>
+
+namespace
+{
+// local_size_x of particle_sort.comp, every invocation compares one pair so a group sorts a block of twice its size
+constexpr uint32_t SORT_GROUP_SIZE = 512;
+constexpr uint32_t SORT_BLOCK_SIZE = SORT_GROUP_SIZE * 2;
+
+// frame parameters, particles, alive lists, dead list, counters, sort pairs
+constexpr uint32_t PARTICLE_BINDING_COUNT = 6;
+
+// push constant stage of particle_control.comp
+constexpr uint32_t CONTROL_BEGIN_EMIT     = 0;
+constexpr uint32_t CONTROL_BEGIN_SIMULATE = 1;
+constexpr uint32_t CONTROL_FINISH         = 2;
+
+// push constant stage of particle_sort.comp
+constexpr uint32_t SORT_WRITE_KEYS  = 0;
+constexpr uint32_t SORT_LOCAL       = 1;
+constexpr uint32_t SORT_GLOBAL_STEP = 2;
+constexpr uint32_t SORT_LOCAL_MERGE = 3;
+
+struct ParticlePushConstants
+{
+    uint32_t stage {0};
+    uint32_t blockSize {0}; // size of the bitonic sequences being merged
+    uint32_t stride {0};    // distance of the compared pairs
+};
+
+// matches the Particle struct of the shaders
+struct GpuParticle
+{
+    glm::vec4 positionAge;
+    glm::vec4 velocityLifetime;
+};
+
+// matches the Counters block of the shaders, the indirect arguments are 16 byte aligned for std430 uvec4
+struct ParticleCounters
+{
+    uint32_t                  aliveCount[2];
+    uint32_t                  deadCount;
+    uint32_t                  current;      // alive list the particles of the last frame are in
+    uint32_t                  spawnedCount; // slots handed out so far, the dead list only holds returned ones
+    uint32_t                  emitCount;
+    uint32_t                  emitFromDead;
+    uint32_t                  padding0;
+    VkDispatchIndirectCommand emitDispatch;
+    uint32_t                  padding1;
+    VkDispatchIndirectCommand simulateDispatch;
+    uint32_t                  padding2;
+    VkDrawIndirectCommand     draw;
+};
+static_assert(offsetof(ParticleCounters, emitDispatch) == 32 && offsetof(ParticleCounters, draw) == 64,
+              "the indirect arguments have to match the uvec4 members of the shaders");
+
+uint32_t nextPowerOfTwo(uint32_t value)
+{
+    uint32_t result = 1;
+    while (result < value)
+    {
+        result <<= 1U;
+    }
+    return result;
+}
+
+// every pass reads what the previous one wrote, some of it as indirect arguments
+void recordComputeBarrier(VkCommandBuffer commandBuffer)
+{
+    VkMemoryBarrier barrier {};
+    barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask =
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                         0,
+                         1,
+                         &barrier,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr);
+}
+} // namespace
+
+void VulkanParticleSystem::create(VkPhysicalDevice          physicalDevice,
+                                  VkDevice                  device,
+                                  VkPipelineCache           pipelineCache,
+                                  const ParticleShaderCode& shaderCode,
+                                  bool                      independentBlend)
+{
+    physicalDevice_   = physicalDevice;
+    device_           = device;
+    pipelineCache_    = pipelineCache;
+    independentBlend_ = independentBlend;
+
+    // the draw reads the same set as the simulation, the particles are never copied into a vertex buffer
+    std::array<VkDescriptorSetLayoutBinding, PARTICLE_BINDING_COUNT> bindings {};
+    for (uint32_t binding = 0; binding < PARTICLE_BINDING_COUNT; binding++)
+    {
+        bindings[binding].binding         = binding;
+        bindings[binding].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[binding].descriptorCount = 1;
+        bindings[binding].stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+    }
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo {};
+    layoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings    = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(device_, &layoutInfo, nullptr, &descriptorSetLayout_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create particle descriptor set layout!");
+    }
+
+    VkPushConstantRange pushConstantRange {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset     = 0;
+    pushConstantRange.size       = sizeof(ParticlePushConstants);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo {};
+    pipelineLayoutInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount         = 1;
+    pipelineLayoutInfo.pSetLayouts            = &descriptorSetLayout_;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges    = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(device_, &pipelineLayoutInfo, nullptr, &pipelineLayout_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create particle pipeline layout!");
+    }
+
+    controlPipeline_  = createComputePipeline(shaderCode.control);
+    emitPipeline_     = createComputePipeline(shaderCode.emit);
+    simulatePipeline_ = createComputePipeline(shaderCode.simulate);
+    sortPipeline_     = createComputePipeline(shaderCode.sort);
+}
+
+void VulkanParticleSystem::destroy()
+{
+    destroyFrameResources();
+    destroyDrawPipeline();
+
+    const std::array<std::pair<VkBuffer*, VkDeviceMemory*>, 5> buffers = {{
+        {&particleBuffer_, &particleMemory_},
+        {&aliveBuffer_, &aliveMemory_},
+        {&deadBuffer_, &deadMemory_},
+        {&sortBuffer_, &sortMemory_},
+        {&counterBuffer_, &counterMemory_},
+    }};
+    for (const auto& [buffer, memory] : buffers)
+    {
+        vkDestroyBuffer(device_, *buffer, nullptr);
+        vkFreeMemory(device_, *memory, nullptr);
+        *buffer = VK_NULL_HANDLE;
+        *memory = VK_NULL_HANDLE;
+    }
+
+    for (VkPipeline* pipeline : {&controlPipeline_, &emitPipeline_, &simulatePipeline_, &sortPipeline_})
+    {
+        vkDestroyPipeline(device_, *pipeline, nullptr);
+        *pipeline = VK_NULL_HANDLE;
+    }
+    vkDestroyPipelineLayout(device_, pipelineLayout_, nullptr);
+    vkDestroyDescriptorSetLayout(device_, descriptorSetLayout_, nullptr);
+    pipelineLayout_      = VK_NULL_HANDLE;
+    descriptorSetLayout_ = VK_NULL_HANDLE;
+}
+
+Task<void> VulkanParticleSystem::initialize(VulkanUploadQueue& uploadQueue, uint32_t capacity, bool sorting)
+{
+    capacity_     = capacity;
+    sortCapacity_ = std::max(nextPowerOfTwo(capacity), SORT_BLOCK_SIZE);
+    sorting_      = sorting;
+
+    createBuffer(sizeof(GpuParticle) * static_cast<VkDeviceSize>(capacity_),
+                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                 particleBuffer_,
+                 particleMemory_);
+    createBuffer(sizeof(uint32_t) * 2 * static_cast<VkDeviceSize>(capacity_),
+                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                 aliveBuffer_,
+                 aliveMemory_);
+    createBuffer(sizeof(uint32_t) * static_cast<VkDeviceSize>(capacity_),
+                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                 deadBuffer_,
+                 deadMemory_);
+    createBuffer(sizeof(uint32_t) * 2 * static_cast<VkDeviceSize>(sortCapacity_),
+                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                 sortBuffer_,
+                 sortMemory_);
+    createBuffer(sizeof(ParticleCounters),
+                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                     VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                 counterBuffer_,
+                 counterMemory_);
+
+    // no slot was handed out yet, so neither the particles nor the lists need clearing
+    const ParticleCounters counters {};
+
+    const auto recordUpload = [target = counterBuffer_](
+                                  VkCommandBuffer commandBuffer, VkBuffer stagingBuffer, VkDeviceSize stagingOffset) {
+        VkBufferCopy copyRegion {};
+        copyRegion.srcOffset = stagingOffset;
+        copyRegion.size      = sizeof(ParticleCounters);
+        vkCmdCopyBuffer(commandBuffer, stagingBuffer, target, 1, &copyRegion);
+
+        VkBufferMemoryBarrier barrier {};
+        barrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask       = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer              = target;
+        barrier.offset              = 0;
+        barrier.size                = VK_WHOLE_SIZE;
+
+        vkCmdPipelineBarrier(commandBuffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0,
+                             0,
+                             nullptr,
+                             1,
+                             &barrier,
+                             0,
+                             nullptr);
+    };
+    co_await uploadQueue.upload(&counters, sizeof(counters), recordUpload);
+
+    LOG_INFO("Particles: capacity {}, sorting {}", capacity_, sorting_ ? sortCapacity_ : 0);
+}
+
+void VulkanParticleSystem::createDrawPipeline(const VulkanDrawTarget&  target,
+                                              const std::vector<char>& vertShaderCode,
+                                              const std::vector<char>& fragShaderCode)
+{
+    // the extra attachments are integer ids, which cannot blend with the color
+    if (target.colorAttachmentCount > 1 && !independentBlend_)
+    {
+        LOG_WARN("Particles are not drawn, the device lacks independent blending");
+        return;
+    }
+
+    const auto createModule = [this](const std::vector<char>& code) {
+        VkShaderModuleCreateInfo moduleInfo {};
+        moduleInfo.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleInfo.codeSize = code.size();
+        moduleInfo.pCode    = reinterpret_cast<const uint32_t*>(code.data());
+
+        VkShaderModule shaderModule = VK_NULL_HANDLE;
+        if (vkCreateShaderModule(device_, &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS)
+        {
+            LOG_FATAL("Failed to create particle shader module!");
+        }
+        return shaderModule;
+    };
+
+    VkShaderModule vertShaderModule = createModule(vertShaderCode);
+    VkShaderModule fragShaderModule = createModule(fragShaderCode);
+
+    std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages {};
+    shaderStages[0].sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStages[0].stage  = VK_SHADER_STAGE_VERTEX_BIT;
+    shaderStages[0].module = vertShaderModule;
+    shaderStages[0].pName  = "main";
+    shaderStages[1].sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStages[1].stage  = VK_SHADER_STAGE_FRAGMENT_BIT;
+    shaderStages[1].module = fragShaderModule;
+    shaderStages[1].pName  = "main";
+
+    // the quad corners come from the vertex index, the particle from the instance index
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo {};
+    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly {};
+    inputAssembly.sType    = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkPipelineViewportStateCreateInfo viewportState {};
+    viewportState.sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount  = 1;
+
+    VkPipelineRasterizationStateCreateInfo rasterizer {};
+    rasterizer.sType       = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizer.lineWidth   = 1.0F;
+    rasterizer.cullMode    = VK_CULL_MODE_NONE;
+    rasterizer.frontFace   = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+    VkPipelineMultisampleStateCreateInfo multisampling {};
+    multisampling.sType                = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    multisampling.minSampleShading     = 1.0F;
+
+    // tested against the scene, but sorted particles must not hide each other
+    VkPipelineDepthStencilStateCreateInfo depthStencil {};
+    depthStencil.sType            = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable  = VK_TRUE;
+    depthStencil.depthWriteEnable = VK_FALSE;
+    depthStencil.depthCompareOp   = VK_COMPARE_OP_LESS;
+    depthStencil.maxDepthBounds   = 1.0F;
+
+    // premultiplied alpha, back to front
+    VkPipelineColorBlendAttachmentState colorBlendAttachment {};
+    colorBlendAttachment.colorWriteMask =
+        VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    colorBlendAttachment.blendEnable         = VK_TRUE;
+    colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+    colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    colorBlendAttachment.colorBlendOp        = VK_BLEND_OP_ADD;
+    colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    colorBlendAttachment.alphaBlendOp        = VK_BLEND_OP_ADD;
+
+    // particles keep the ids of whatever is behind them
+    VkPipelineColorBlendAttachmentState idBlendAttachment {};
+    idBlendAttachment.colorWriteMask = 0;
+    idBlendAttachment.blendEnable    = VK_FALSE;
+
+    std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachments(target.colorAttachmentCount,
+                                                                           idBlendAttachment);
+    colorBlendAttachments[0] = colorBlendAttachment;
+
+    VkPipelineColorBlendStateCreateInfo colorBlending {};
+    colorBlending.sType           = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlending.logicOpEnable   = VK_FALSE;
+    colorBlending.logicOp         = VK_LOGIC_OP_COPY;
+    colorBlending.attachmentCount = static_cast<uint32_t>(colorBlendAttachments.size());
+    colorBlending.pAttachments    = colorBlendAttachments.data();
+
+    VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+
+    VkPipelineDynamicStateCreateInfo dynamicState {};
+    dynamicState.sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = sizeof(dynamicStates) / sizeof(VkDynamicState);
+    dynamicState.pDynamicStates    = dynamicStates;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo {};
+    pipelineInfo.sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.pNext               = target.renderingInfo;
+    pipelineInfo.stageCount          = static_cast<uint32_t>(shaderStages.size());
+    pipelineInfo.pStages             = shaderStages.data();
+    pipelineInfo.pVertexInputState   = &vertexInputInfo;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState      = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState   = &multisampling;
+    pipelineInfo.pDepthStencilState  = &depthStencil;
+    pipelineInfo.pColorBlendState    = &colorBlending;
+    pipelineInfo.pDynamicState       = &dynamicState;
+    pipelineInfo.layout              = pipelineLayout_;
+    pipelineInfo.renderPass          = target.renderPass;
+    pipelineInfo.subpass             = target.subpass;
+    pipelineInfo.basePipelineIndex   = -1;
+
+    if (vkCreateGraphicsPipelines(device_, pipelineCache_, 1, &pipelineInfo, nullptr, &drawPipeline_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create particle draw pipeline!");
+    }
+
+    vkDestroyShaderModule(device_, fragShaderModule, nullptr);
+    vkDestroyShaderModule(device_, vertShaderModule, nullptr);
+}
+
+void VulkanParticleSystem::destroyDrawPipeline()
+{
+    vkDestroyPipeline(device_, drawPipeline_, nullptr);
+    drawPipeline_ = VK_NULL_HANDLE;
+}
+
+void VulkanParticleSystem::createFrameResources(uint32_t imageCount)
+{
+    std::array<VkDescriptorPoolSize, 2> poolSizes {};
+    poolSizes[0].type            = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    poolSizes[0].descriptorCount = imageCount;
+    poolSizes[1].type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[1].descriptorCount = imageCount * (PARTICLE_BINDING_COUNT - 1);
+
+    VkDescriptorPoolCreateInfo poolInfo {};
+    poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes    = poolSizes.data();
+    poolInfo.maxSets       = imageCount;
+
+    if (vkCreateDescriptorPool(device_, &poolInfo, nullptr, &descriptorPool_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create particle descriptor pool!");
+    }
+
+    frames_.resize(imageCount);
+    for (Frame& frame : frames_)
+    {
+        createBuffer(sizeof(ParticleFrameParams),
+                     VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                     frame.paramsBuffer,
+                     frame.paramsMemory);
+
+        void* mapped = nullptr;
+        vkMapMemory(device_, frame.paramsMemory, 0, VK_WHOLE_SIZE, 0, &mapped);
+        frame.params = static_cast<ParticleFrameParams*>(mapped);
+
+        VkDescriptorSetAllocateInfo allocInfo {};
+        allocInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool     = descriptorPool_;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts        = &descriptorSetLayout_;
+
+        if (vkAllocateDescriptorSets(device_, &allocInfo, &frame.descriptorSet) != VK_SUCCESS)
+        {
+            LOG_FATAL("Failed to allocate particle descriptor set!");
+        }
+
+        const std::array<VkDescriptorBufferInfo, PARTICLE_BINDING_COUNT> bufferInfos = {{
+            {frame.paramsBuffer, 0, VK_WHOLE_SIZE},
+            {particleBuffer_, 0, VK_WHOLE_SIZE},
+            {aliveBuffer_, 0, VK_WHOLE_SIZE},
+            {deadBuffer_, 0, VK_WHOLE_SIZE},
+            {counterBuffer_, 0, VK_WHOLE_SIZE},
+            {sortBuffer_, 0, VK_WHOLE_SIZE},
+        }};
+
+        std::array<VkWriteDescriptorSet, PARTICLE_BINDING_COUNT> descriptorWrites {};
+        for (uint32_t binding = 0; binding < PARTICLE_BINDING_COUNT; binding++)
+        {
+            descriptorWrites[binding].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descriptorWrites[binding].dstSet          = frame.descriptorSet;
+            descriptorWrites[binding].dstBinding      = binding;
+            descriptorWrites[binding].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            descriptorWrites[binding].descriptorCount = 1;
+            descriptorWrites[binding].pBufferInfo     = &bufferInfos[binding];
+        }
+        descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+
+        vkUpdateDescriptorSets(
+            device_, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+    }
+}
+
+void VulkanParticleSystem::destroyFrameResources()
+{
+    for (const Frame& frame : frames_)
+    {
+        vkUnmapMemory(device_, frame.paramsMemory);
+        vkDestroyBuffer(device_, frame.paramsBuffer, nullptr);
+        vkFreeMemory(device_, frame.paramsMemory, nullptr);
+    }
+    frames_.clear();
+
+    // frees the descriptor sets along with it
+    vkDestroyDescriptorPool(device_, descriptorPool_, nullptr);
+    descriptorPool_ = VK_NULL_HANDLE;
+}
+
+ParticleFrameParams* VulkanParticleSystem::getFrameParams(uint32_t imageIndex) const
+{
+    return frames_[imageIndex].params;
+}
+
+VkDescriptorSet VulkanParticleSystem::getDescriptorSet(uint32_t imageIndex) const
+{
+    return frames_[imageIndex].descriptorSet;
+}
+
+VkDeviceSize VulkanParticleSystem::getDrawArgsOffset()
+{
+    return offsetof(ParticleCounters, draw);
+}
+
+void VulkanParticleSystem::record(VkCommandBuffer commandBuffer, uint32_t imageIndex) const
+{
+    // the previous frame may still be drawing from the lists and the arguments, an execution dependency covers
+    // write after read
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr);
+
+    // every pass shares the layout, the set stays bound across the pipeline switches
+    vkCmdBindDescriptorSets(commandBuffer,
+                            VK_PIPELINE_BIND_POINT_COMPUTE,
+                            pipelineLayout_,
+                            0,
+                            1,
+                            &frames_[imageIndex].descriptorSet,
+                            0,
+                            nullptr);
+
+    // clamps the requested emission to the free slots and sizes the emit dispatch
+    dispatch(commandBuffer, controlPipeline_, CONTROL_BEGIN_EMIT, 1);
+    recordComputeBarrier(commandBuffer);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, emitPipeline_);
+    vkCmdDispatchIndirect(commandBuffer, counterBuffer_, offsetof(ParticleCounters, emitDispatch));
+    recordComputeBarrier(commandBuffer);
+
+    // takes the emitted slots off the dead list and sizes the simulation to the alive count
+    dispatch(commandBuffer, controlPipeline_, CONTROL_BEGIN_SIMULATE, 1);
+    recordComputeBarrier(commandBuffer);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, simulatePipeline_);
+    vkCmdDispatchIndirect(commandBuffer, counterBuffer_, offsetof(ParticleCounters, simulateDispatch));
+    recordComputeBarrier(commandBuffer);
+
+    // flips the alive lists and writes the draw arguments
+    dispatch(commandBuffer, controlPipeline_, CONTROL_FINISH, 1);
+    recordComputeBarrier(commandBuffer);
+
+    // without sorting the keys pass still gathers the alive slots in list order for the draw
+    dispatch(commandBuffer, sortPipeline_, SORT_WRITE_KEYS, sortCapacity_ / SORT_BLOCK_SIZE);
+    recordComputeBarrier(commandBuffer);
+    if (sorting_)
+    {
+        sort(commandBuffer);
+    }
+
+    VkMemoryBarrier barrier {};
+    barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                         0,
+                         1,
+                         &barrier,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr);
+}
+
+void VulkanParticleSystem::dispatch(VkCommandBuffer commandBuffer,
+                                    VkPipeline      pipeline,
+                                    uint32_t        stage,
+                                    uint32_t        groupCount) const
+{
+    ParticlePushConstants constants {};
+    constants.stage = stage;
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    vkCmdPushConstants(
+        commandBuffer, pipelineLayout_, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+    vkCmdDispatch(commandBuffer, groupCount, 1, 1);
+}
+
+void VulkanParticleSystem::sort(VkCommandBuffer commandBuffer) const
+{
+    // bitonic sort of the whole padded range. Blocks are sorted in shared memory first, after that every merge runs
+    // its wide steps over the whole buffer and finishes the steps that fit into a block in shared memory again
+    const uint32_t groupCount = sortCapacity_ / SORT_BLOCK_SIZE;
+
+    ParticlePushConstants constants {};
+    constants.stage = SORT_LOCAL;
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, sortPipeline_);
+    vkCmdPushConstants(
+        commandBuffer, pipelineLayout_, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+    vkCmdDispatch(commandBuffer, groupCount, 1, 1);
+    recordComputeBarrier(commandBuffer);
+
+    for (uint32_t blockSize = SORT_BLOCK_SIZE * 2; blockSize <= sortCapacity_; blockSize *= 2)
+    {
+        constants.blockSize = blockSize;
+        for (uint32_t stride = blockSize / 2; stride >= SORT_BLOCK_SIZE; stride /= 2)
+        {
+            constants.stage  = SORT_GLOBAL_STEP;
+            constants.stride = stride;
+            vkCmdPushConstants(
+                commandBuffer, pipelineLayout_, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+            vkCmdDispatch(commandBuffer, groupCount, 1, 1);
+            recordComputeBarrier(commandBuffer);
+        }
+
+        constants.stage  = SORT_LOCAL_MERGE;
+        constants.stride = SORT_GROUP_SIZE;
+        vkCmdPushConstants(
+            commandBuffer, pipelineLayout_, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+        vkCmdDispatch(commandBuffer, groupCount, 1, 1);
+        recordComputeBarrier(commandBuffer);
+    }
+}
+
+VkPipeline VulkanParticleSystem::createComputePipeline(const std::vector<char>& code) const
+{
+    VkShaderModuleCreateInfo moduleInfo {};
+    moduleInfo.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    moduleInfo.codeSize = code.size();
+    moduleInfo.pCode    = reinterpret_cast<const uint32_t*>(code.data());
+
+    VkShaderModule shaderModule = VK_NULL_HANDLE;
+    if (vkCreateShaderModule(device_, &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create particle shader module!");
+    }
+
+    VkComputePipelineCreateInfo pipelineInfo {};
+    pipelineInfo.sType        = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = shaderModule;
+    pipelineInfo.stage.pName  = "main";
+    pipelineInfo.layout       = pipelineLayout_;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if (vkCreateComputePipelines(device_, pipelineCache_, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create particle pipeline!");
+    }
+
+    vkDestroyShaderModule(device_, shaderModule, nullptr);
+    return pipeline;
+}
+
+void VulkanParticleSystem::createBuffer(VkDeviceSize          size,
+                                        VkBufferUsageFlags    usage,
+                                        VkMemoryPropertyFlags properties,
+                                        VkBuffer&             buffer,
+                                        VkDeviceMemory&       bufferMemory) const
+{
+    VkBufferCreateInfo bufferInfo {};
+    bufferInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size        = size;
+    bufferInfo.usage       = usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create particle buffer!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
+
+    VkMemoryAllocateInfo allocInfo {};
+    allocInfo.sType          = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    if (!VulkanUtils::findMemoryTypeIndex(
+            physicalDevice_, memRequirements.memoryTypeBits, properties, allocInfo.memoryTypeIndex))
+    {
+        LOG_FATAL("Failed to find a memory type for particle buffers!");
+    }
+
+    if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to allocate particle buffer memory!");
+    }
+    vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "foundation/async/task.h"
+#include "render/backend/vulkan/vulkan_draw_target.h"
+#include "render/backend/vulkan/vulkan_loader.h"
+#include "render/backend/vulkan/vulkan_upload_queue.h"
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+// std140 layout of the per image parameter block, shared by every particle shader
+struct ParticleFrameParams
+{
+    glm::mat4 view {1.0F};
+    glm::mat4 proj {1.0F};
+    glm::vec4 emitterPosition {0.0F}; // w is the spawn radius
+    glm::vec4 gravity {0.0F};         // w is the drag per second
+    glm::vec4 startColor {1.0F};      // premultiplied by the shader
+    glm::vec4 endColor {0.0F};
+    float     deltaTime {0.0F};
+    uint32_t  emitCount {0};
+    uint32_t  seed {0};
+    float     particleSize {0.0F};
+    float     emitSpeed {0.0F};
+    float     minLifetime {0.0F};
+    float     maxLifetime {0.0F};
+    uint32_t  capacity {0};
+};
+
+struct ParticleShaderCode
+{
+    std::vector<char> control;
+    std::vector<char> emit;
+    std::vector<char> simulate;
+    std::vector<char> sort;
+};
+
+// Emits, simulates, compacts and sorts particles entirely in compute shaders. Particle slots come from a dead list,
+// the survivors of a frame are compacted from one alive list into the other, so the cpu never touches a particle and
+// never reads a count back. The counts live in a gpu buffer next to the indirect arguments the passes write for each
+// other, the chain is recorded once into the cached primary command buffer of an image and replayed with the
+// parameters of the frame. The draw is one indirect instanced draw of camera facing quads, back to front after the
+// bitonic sort.
+class VulkanParticleSystem {
+public:
+    void create(VkPhysicalDevice          physicalDevice,
+                VkDevice                  device,
+                VkPipelineCache           pipelineCache,
+                const ParticleShaderCode& shaderCode,
+                bool                      independentBlend);
+    void destroy();
+
+    // allocates the particle storage and clears the counters, before the frame resources are created
+    Task<void> initialize(VulkanUploadQueue& uploadQueue, uint32_t capacity, bool sorting);
+
+    // the blended draw pipeline depends on the render path and is rebuilt with the scene pipelines
+    void createDrawPipeline(const VulkanDrawTarget&  target,
+                            const std::vector<char>& vertShaderCode,
+                            const std::vector<char>& fragShaderCode);
+    void destroyDrawPipeline();
+
+    // parameter buffers and descriptor sets, one per swapchain image
+    void createFrameResources(uint32_t imageCount);
+    void destroyFrameResources();
+
+    // the image must not be in flight while its parameters are written
+    [[nodiscard]] ParticleFrameParams* getFrameParams(uint32_t imageIndex) const;
+
+    // runs the whole simulation and leaves the draw arguments and the sorted order visible to the draw, outside of
+    // any render pass
+    void record(VkCommandBuffer commandBuffer, uint32_t imageIndex) const;
+
+    [[nodiscard]] bool isReady() const { return counterBuffer_ != VK_NULL_HANDLE && !frames_.empty(); }
+    [[nodiscard]] bool isDrawable() const { return isReady() && drawPipeline_ != VK_NULL_HANDLE; }
+
+    [[nodiscard]] VkPipeline       getDrawPipeline() const { return drawPipeline_; }
+    [[nodiscard]] VkPipelineLayout getPipelineLayout() const { return pipelineLayout_; }
+    [[nodiscard]] VkDescriptorSet  getDescriptorSet(uint32_t imageIndex) const;
+    [[nodiscard]] uint32_t         getCapacity() const { return capacity_; }
+
+    // a VkDrawIndirectCommand written by the simulation, instanceCount is the number of live particles
+    [[nodiscard]] VkBuffer            getDrawArgsBuffer() const { return counterBuffer_; }
+    [[nodiscard]] static VkDeviceSize getDrawArgsOffset();
+
+private:
+    struct Frame
+    {
+        VkBuffer             paramsBuffer {VK_NULL_HANDLE};
+        VkDeviceMemory       paramsMemory {VK_NULL_HANDLE};
+        ParticleFrameParams* params {nullptr};
+        VkDescriptorSet      descriptorSet {VK_NULL_HANDLE};
+    };
+
+    [[nodiscard]] VkPipeline createComputePipeline(const std::vector<char>& code) const;
+    void dispatch(VkCommandBuffer commandBuffer, VkPipeline pipeline, uint32_t stage, uint32_t groupCount) const;
+    void sort(VkCommandBuffer commandBuffer) const;
+
+    void createBuffer(VkDeviceSize          size,
+                      VkBufferUsageFlags    usage,
+                      VkMemoryPropertyFlags properties,
+                      VkBuffer&             buffer,
+                      VkDeviceMemory&       bufferMemory) const;
+
+    VkPhysicalDevice      physicalDevice_ {VK_NULL_HANDLE};
+    VkDevice              device_ {VK_NULL_HANDLE};
+    VkPipelineCache       pipelineCache_ {VK_NULL_HANDLE};
+    VkDescriptorSetLayout descriptorSetLayout_ {VK_NULL_HANDLE};
+    VkPipelineLayout      pipelineLayout_ {VK_NULL_HANDLE};
+    VkPipeline            controlPipeline_ {VK_NULL_HANDLE};
+    VkPipeline            emitPipeline_ {VK_NULL_HANDLE};
+    VkPipeline            simulatePipeline_ {VK_NULL_HANDLE};
+    VkPipeline            sortPipeline_ {VK_NULL_HANDLE};
+    VkPipeline            drawPipeline_ {VK_NULL_HANDLE};
+    VkDescriptorPool      descriptorPool_ {VK_NULL_HANDLE};
+    bool                  independentBlend_ {false};
+
+    VkBuffer       particleBuffer_ {VK_NULL_HANDLE};
+    VkDeviceMemory particleMemory_ {VK_NULL_HANDLE};
+    VkBuffer       aliveBuffer_ {VK_NULL_HANDLE}; // two lists of capacity slots, flipped every frame
+    VkDeviceMemory aliveMemory_ {VK_NULL_HANDLE};
+    VkBuffer       deadBuffer_ {VK_NULL_HANDLE};
+    VkDeviceMemory deadMemory_ {VK_NULL_HANDLE};
+    VkBuffer       sortBuffer_ {VK_NULL_HANDLE}; // key and slot pairs, padded to a power of two
+    VkDeviceMemory sortMemory_ {VK_NULL_HANDLE};
+    VkBuffer       counterBuffer_ {VK_NULL_HANDLE};
+    VkDeviceMemory counterMemory_ {VK_NULL_HANDLE};
+    uint32_t       capacity_ {0};
+    uint32_t       sortCapacity_ {0};
+    bool           sorting_ {false};
+
+    std::vector<Frame> frames_;
+};
@@ -0,0 +1,470 @@
+#include "render/backend/vulkan/vulkan_readback_manager.h"
+#include "render/backend/vulkan/vulkan_utils.h"
+
+#include "foundation/log/log_system.h"
+
+#include <algorithm>
+
+namespace
+{
+// buffer image copies need offsets aligned to four bytes and the texel size, sixteen covers every format
+constexpr VkDeviceSize COPY_ALIGNMENT = 16;
+
+constexpr VkDeviceSize QUERY_RESULT_SIZE = sizeof(uint64_t);
+
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+VkImageMemoryBarrier makeImageBarrier(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout)
+{
+    VkImageMemoryBarrier barrier {};
+    barrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout                       = oldLayout;
+    barrier.newLayout                       = newLayout;
+    barrier.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image                           = image;
+    barrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel   = 0;
+    barrier.subresourceRange.levelCount     = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount     = 1;
+    return barrier;
+}
+} // namespace
+
+void VulkanReadbackManager::create(VkPhysicalDevice physicalDevice,
+                                   VkDevice         device,
+                                   uint32_t         queueFamilyIndex,
+                                   uint32_t         frameCount,
+                                   VkDeviceSize     ringSize)
+{
+    device_   = device;
+    ringSize_ = alignUp(ringSize, COPY_ALIGNMENT);
+    ringHead_ = 0;
+    ringUsed_ = 0;
+
+    VkPhysicalDeviceProperties properties {};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    nonCoherentAtomSize_ = std::max<VkDeviceSize>(1, properties.limits.nonCoherentAtomSize);
+
+    VkCommandPoolCreateInfo poolInfo {};
+    poolInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = queueFamilyIndex;
+    poolInfo.flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+    if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create readback command pool!");
+    }
+
+    VkBufferCreateInfo bufferInfo {};
+    bufferInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size        = ringSize_;
+    bufferInfo.usage       = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(device_, &bufferInfo, nullptr, &ringBuffer_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create readback buffer!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements(device_, ringBuffer_, &memRequirements);
+
+    // cached memory makes reading on the cpu fast, it is usually not coherent and has to be invalidated
+    const VkMemoryPropertyFlags preferredFlags[] = {
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
+
+    uint32_t memoryTypeIndex = UINT32_MAX;
+    for (const VkMemoryPropertyFlags flags : preferredFlags)
+    {
+        if (VulkanUtils::findMemoryTypeIndex(physicalDevice, memRequirements.memoryTypeBits, flags, memoryTypeIndex))
+            break;
+    }
+    if (memoryTypeIndex == UINT32_MAX)
+    {
+        LOG_FATAL("Failed to find a host visible memory type for readbacks!");
+    }
+
+    VkPhysicalDeviceMemoryProperties memoryProperties {};
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+    hostCoherent_ =
+        (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+
+    VkMemoryAllocateInfo allocInfo {};
+    allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize  = memRequirements.size;
+    allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+    if (vkAllocateMemory(device_, &allocInfo, nullptr, &ringMemory_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to allocate readback memory!");
+    }
+    ringMemorySize_ = memRequirements.size;
+    vkBindBufferMemory(device_, ringBuffer_, ringMemory_, 0);
+
+    void* mapped = nullptr;
+    vkMapMemory(device_, ringMemory_, 0, VK_WHOLE_SIZE, 0, &mapped);
+    ringData_ = static_cast<const std::byte*>(mapped);
+
+    frames_.resize(frameCount);
+    for (Frame& frame : frames_)
+    {
+        VkCommandBufferAllocateInfo commandBufferInfo {};
+        commandBufferInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        commandBufferInfo.commandPool        = commandPool_;
+        commandBufferInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        commandBufferInfo.commandBufferCount = 1;
+
+        if (vkAllocateCommandBuffers(device_, &commandBufferInfo, &frame.commandBuffer) != VK_SUCCESS)
+        {
+            LOG_FATAL("Failed to allocate readback command buffer!");
+        }
+    }
+
+    LOG_INFO("Readback: {} KiB ring in {} memory", ringSize_ / 1024, hostCoherent_ ? "host coherent" : "host cached");
+}
+
+void VulkanReadbackManager::destroy()
+{
+    // the device is idle, whatever was still in flight is dropped without calling back
+    frames_.clear();
+
+    vkUnmapMemory(device_, ringMemory_);
+    vkDestroyBuffer(device_, ringBuffer_, nullptr);
+    vkFreeMemory(device_, ringMemory_, nullptr);
+    ringData_   = nullptr;
+    ringBuffer_ = VK_NULL_HANDLE;
+    ringMemory_ = VK_NULL_HANDLE;
+
+    vkDestroyCommandPool(device_, commandPool_, nullptr);
+    commandPool_ = VK_NULL_HANDLE;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    requests_.clear();
+    pendingCount_ = 0;
+}
+
+void VulkanReadbackManager::requestRegion(VulkanReadbackSource   source,
+                                          int32_t                x,
+                                          int32_t                y,
+                                          uint32_t               width,
+                                          uint32_t               height,
+                                          VulkanReadbackCallback callback)
+{
+    Request request {};
+    request.type     = RequestType::IMAGE;
+    request.source   = source;
+    request.x        = x;
+    request.y        = y;
+    request.width    = width;
+    request.height   = height;
+    request.callback = std::move(callback);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    requests_.push_back(std::move(request));
+    pendingCount_++;
+}
+
+void VulkanReadbackManager::requestBuffer(VkBuffer               buffer,
+                                          VkDeviceSize           offset,
+                                          VkDeviceSize           size,
+                                          VulkanReadbackCallback callback)
+{
+    Request request {};
+    request.type     = RequestType::BUFFER;
+    request.buffer   = buffer;
+    request.offset   = offset;
+    request.size     = size;
+    request.callback = std::move(callback);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    requests_.push_back(std::move(request));
+    pendingCount_++;
+}
+
+void VulkanReadbackManager::requestQueries(VkQueryPool            queryPool,
+                                           uint32_t               firstQuery,
+                                           uint32_t               queryCount,
+                                           VulkanReadbackCallback callback)
+{
+    Request request {};
+    request.type      = RequestType::QUERIES;
+    request.queryPool = queryPool;
+    request.offset    = firstQuery;
+    request.size      = queryCount;
+    request.callback  = std::move(callback);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    requests_.push_back(std::move(request));
+    pendingCount_++;
+}
+
+bool VulkanReadbackManager::allocate(Frame& frame, VkDeviceSize size, VkDeviceSize& offset)
+{
+    size = alignUp(size, COPY_ALIGNMENT);
+
+    // an allocation never straddles the end, the skipped tail counts as used until this frame completes
+    VkDeviceSize skipped = 0;
+    if (ringHead_ + size > ringSize_)
+    {
+        skipped = ringSize_ - ringHead_;
+    }
+    if (ringUsed_ + skipped + size > ringSize_)
+        return false;
+
+    if (skipped > 0)
+    {
+        ringHead_ = 0;
+    }
+    offset = ringHead_;
+    ringHead_ += size;
+    ringUsed_ += skipped + size;
+    frame.ringBytes += skipped + size;
+    return true;
+}
+
+VkCommandBuffer
+VulkanReadbackManager::recordCopies(uint32_t frameIndex, uint64_t frameNumber, const VulkanReadbackImages& images)
+{
+    Frame& frame = frames_[frameIndex];
+
+    // parallel to frame.copies, the callbacks moved over to the copies
+    std::vector<Request> served;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        for (Request& request : requests_)
+        {
+            Copy copy {};
+            copy.result.frameNumber = frameNumber;
+
+            // an unavailable image or an empty region reads nothing but still calls back
+            if (request.type == RequestType::IMAGE)
+            {
+                const VulkanReadbackImage& image  = images[static_cast<size_t>(request.source)];
+                VulkanReadbackResult&      result = copy.result;
+                if (image.texelSize > 0)
+                {
+                    const int64_t right  = std::min<int64_t>(int64_t {request.x} + request.width, image.extent.width);
+                    const int64_t bottom = std::min<int64_t>(int64_t {request.y} + request.height, image.extent.height);
+
+                    result.x         = static_cast<uint32_t>(std::clamp<int64_t>(request.x, 0, image.extent.width));
+                    result.y         = static_cast<uint32_t>(std::clamp<int64_t>(request.y, 0, image.extent.height));
+                    result.width     = static_cast<uint32_t>(std::max<int64_t>(0, right - result.x));
+                    result.height    = static_cast<uint32_t>(std::max<int64_t>(0, bottom - result.y));
+                    result.texelSize = image.texelSize;
+                    result.format    = image.format;
+                    result.size      = VkDeviceSize {result.width} * result.height * result.texelSize;
+                }
+            }
+            else if (request.type == RequestType::BUFFER)
+            {
+                copy.result.size = request.size;
+            }
+            else
+            {
+                copy.result.size = request.size * QUERY_RESULT_SIZE;
+            }
+
+            if (copy.result.size > 0 && !allocate(frame, copy.result.size, copy.offset))
+            {
+                if (alignUp(copy.result.size, COPY_ALIGNMENT) <= ringSize_)
+                    break;
+
+                // the ring will never fit it, hand back an empty result instead of blocking the queue forever
+                LOG_WARN("Readback of {} bytes does not fit into the {} byte ring", copy.result.size, ringSize_);
+                copy.result             = {};
+                copy.result.frameNumber = frameNumber;
+            }
+
+            copy.callback = std::move(request.callback);
+            frame.copies.push_back(std::move(copy));
+            served.push_back(std::move(request));
+        }
+
+        requests_.erase(requests_.begin(), requests_.begin() + static_cast<std::ptrdiff_t>(served.size()));
+    }
+
+    if (frame.copies.empty())
+        return VK_NULL_HANDLE;
+
+    VkCommandBufferBeginInfo beginInfo {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    if (vkBeginCommandBuffer(frame.commandBuffer, &beginInfo) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to begin recording readback command buffer!");
+    }
+
+    // source images that have to move to TRANSFER_SRC_OPTIMAL for the copies and back afterwards
+    std::vector<VkImageMemoryBarrier>                                  acquireBarriers;
+    std::vector<VkImageMemoryBarrier>                                  releaseBarriers;
+    std::array<bool, static_cast<size_t>(VulkanReadbackSource::COUNT)> transitioned {};
+    for (size_t index = 0; index < served.size(); index++)
+    {
+        const auto source = static_cast<size_t>(served[index].source);
+        if (served[index].type != RequestType::IMAGE || frame.copies[index].result.size == 0 || transitioned[source])
+            continue;
+
+        transitioned[source]             = true;
+        const VulkanReadbackImage& image = images[source];
+        if (image.layout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+            continue;
+
+        acquireBarriers.push_back(makeImageBarrier(image.image, image.layout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL));
+        acquireBarriers.back().srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+        acquireBarriers.back().dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+        releaseBarriers.push_back(makeImageBarrier(image.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image.layout));
+    }
+
+    // buffers and queries may have been written by any earlier command of the frame
+    VkMemoryBarrier memoryBarrier {};
+    memoryBarrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memoryBarrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+    vkCmdPipelineBarrier(frame.commandBuffer,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0,
+                         1,
+                         &memoryBarrier,
+                         0,
+                         nullptr,
+                         static_cast<uint32_t>(acquireBarriers.size()),
+                         acquireBarriers.data());
+
+    for (size_t index = 0; index < served.size(); index++)
+    {
+        const Request&              request = served[index];
+        const Copy&                 copy    = frame.copies[index];
+        const VulkanReadbackResult& result  = copy.result;
+        if (result.size == 0)
+            continue;
+
+        if (request.type == RequestType::IMAGE)
+        {
+            VkBufferImageCopy region {};
+            region.bufferOffset                = copy.offset;
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.layerCount = 1;
+            region.imageOffset                 = {static_cast<int32_t>(result.x), static_cast<int32_t>(result.y), 0};
+            region.imageExtent                 = {result.width, result.height, 1};
+
+            vkCmdCopyImageToBuffer(frame.commandBuffer,
+                                   images[static_cast<size_t>(request.source)].image,
+                                   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                   ringBuffer_,
+                                   1,
+                                   &region);
+        }
+        else if (request.type == RequestType::BUFFER)
+        {
+            VkBufferCopy region {};
+            region.srcOffset = request.offset;
+            region.dstOffset = copy.offset;
+            region.size      = request.size;
+
+            vkCmdCopyBuffer(frame.commandBuffer, request.buffer, ringBuffer_, 1, &region);
+        }
+        else
+        {
+            vkCmdCopyQueryPoolResults(frame.commandBuffer,
+                                      request.queryPool,
+                                      static_cast<uint32_t>(request.offset),
+                                      static_cast<uint32_t>(request.size),
+                                      ringBuffer_,
+                                      copy.offset,
+                                      QUERY_RESULT_SIZE,
+                                      VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+        }
+    }
+
+    // makes the copies visible to the host once the fence of the frame signaled, the images go back to where the
+    // following commands expect them, e.g. PRESENT_SRC_KHR for the swap chain
+    VkBufferMemoryBarrier bufferBarrier {};
+    bufferBarrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    bufferBarrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+    bufferBarrier.dstAccessMask       = VK_ACCESS_HOST_READ_BIT;
+    bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufferBarrier.buffer              = ringBuffer_;
+    bufferBarrier.offset              = 0;
+    bufferBarrier.size                = VK_WHOLE_SIZE;
+
+    vkCmdPipelineBarrier(frame.commandBuffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_HOST_BIT | VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                         0,
+                         0,
+                         nullptr,
+                         1,
+                         &bufferBarrier,
+                         static_cast<uint32_t>(releaseBarriers.size()),
+                         releaseBarriers.data());
+
+    if (vkEndCommandBuffer(frame.commandBuffer) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to record readback command buffer!");
+    }
+
+    return frame.commandBuffer;
+}
+
+void VulkanReadbackManager::collect(uint32_t frameIndex)
+{
+    Frame& frame = frames_[frameIndex];
+    if (frame.copies.empty())
+        return;
+
+    if (!hostCoherent_)
+    {
+        std::vector<VkMappedMemoryRange> ranges;
+        for (const Copy& copy : frame.copies)
+        {
+            if (copy.result.size == 0)
+                continue;
+
+            // invalidation works on whole atoms, a range reaching the end of the allocation takes the rest of it
+            VkMappedMemoryRange range {};
+            range.sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+            range.memory = ringMemory_;
+            range.offset = copy.offset / nonCoherentAtomSize_ * nonCoherentAtomSize_;
+            range.size   = alignUp(copy.offset + copy.result.size - range.offset, nonCoherentAtomSize_);
+            if (range.offset + range.size >= ringMemorySize_)
+            {
+                range.size = VK_WHOLE_SIZE;
+            }
+            ranges.push_back(range);
+        }
+        if (!ranges.empty())
+        {
+            vkInvalidateMappedMemoryRanges(device_, static_cast<uint32_t>(ranges.size()), ranges.data());
+        }
+    }
+
+    for (Copy& copy : frame.copies)
+    {
+        if (copy.result.size > 0)
+        {
+            copy.result.data = ringData_ + copy.offset;
+        }
+        if (copy.callback)
+        {
+            copy.callback(copy.result);
+        }
+        pendingCount_--;
+    }
+    frame.copies.clear();
+
+    // frames complete in submission order, so releasing from the tail of the ring keeps it contiguous
+    ringUsed_ -= frame.ringBytes;
+    frame.ringBytes = 0;
+}
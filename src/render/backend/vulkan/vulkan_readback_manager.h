@@ -0,0 +1,151 @@
+#pragma once
+
+#include "render/backend/vulkan/vulkan_loader.h"
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// images a readback can be taken from, the render thread hands their current state to recordCopies every frame
+enum class VulkanReadbackSource : uint8_t
+{
+    OBJECT_ID,
+    SWAPCHAIN,
+    COUNT,
+};
+
+struct VulkanReadbackImage
+{
+    VkImage       image {VK_NULL_HANDLE};
+    VkExtent2D    extent {};
+    VkFormat      format {VK_FORMAT_UNDEFINED};
+    VkImageLayout layout {VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL}; // left in this layout after the copies
+    uint32_t      texelSize {0};                                // zero marks the source as unavailable
+};
+
+// One finished readback. Image regions are tightly packed row after row, buffers and queries are copied as they are
+// with 64 bit query results. The data is only valid during the callback and is null when nothing could be read.
+struct VulkanReadbackResult
+{
+    const void*  data {nullptr};
+    VkDeviceSize size {0};
+    uint32_t     x {0};
+    uint32_t     y {0};
+    uint32_t     width {0};
+    uint32_t     height {0};
+    uint32_t     texelSize {0};
+    VkFormat     format {VK_FORMAT_UNDEFINED};
+    uint64_t     frameNumber {0}; // frame whose commands produced the data
+};
+
+using VulkanReadbackCallback = std::function<void(const VulkanReadbackResult&)>;
+using VulkanReadbackImages   = std::array<VulkanReadbackImage, static_cast<size_t>(VulkanReadbackSource::COUNT)>;
+
+// Copies GPU data to the host without stalling the queue. Every frame records the copies of the pending requests into
+// its own command buffer, which goes into the same submit as the frame, right after the main pass. The copies land in
+// one persistently mapped, preferably host cached ring buffer. Once the fence of the frame signaled its callbacks run
+// and its part of the ring is released, so results arrive as many frames later as there are frames in flight.
+// Requests are served in order, when the ring is full the rest waits for a later frame.
+class VulkanReadbackManager {
+public:
+    void create(VkPhysicalDevice physicalDevice,
+                VkDevice         device,
+                uint32_t         queueFamilyIndex,
+                uint32_t         frameCount,
+                VkDeviceSize     ringSize);
+    void destroy();
+
+    // Any thread, callbacks run on the render thread. A region is clamped to the image when the copy gets recorded,
+    // pass UINT32_MAX as width and height for the whole image
+    void requestRegion(VulkanReadbackSource   source,
+                       int32_t                x,
+                       int32_t                y,
+                       uint32_t               width,
+                       uint32_t               height,
+                       VulkanReadbackCallback callback);
+
+    // The buffer needs TRANSFER_SRC usage and has to outlive the frame the copy is recorded into. Writes submitted
+    // before that frame are visible to the copy
+    void requestBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, VulkanReadbackCallback callback);
+
+    // 64 bit results of queries written by the frame the copy is recorded into or an earlier one, the copy waits on
+    // the GPU until they are available
+    void requestQueries(VkQueryPool            queryPool,
+                        uint32_t               firstQuery,
+                        uint32_t               queryCount,
+                        VulkanReadbackCallback callback);
+
+    // render thread, records the copies of pending requests for the frame and returns VK_NULL_HANDLE when there are
+    // none. Source images only have to be written by the commands submitted before
+    VkCommandBuffer recordCopies(uint32_t frameIndex, uint64_t frameNumber, const VulkanReadbackImages& images);
+
+    // render thread, after the fence of the frame signaled
+    void collect(uint32_t frameIndex);
+
+    // queued or in flight, the main thread keeps rendering until every request got its result
+    [[nodiscard]] bool hasPendingRequests() const { return pendingCount_.load() > 0; }
+
+private:
+    enum class RequestType : uint8_t
+    {
+        IMAGE,
+        BUFFER,
+        QUERIES,
+    };
+
+    struct Request
+    {
+        RequestType            type {RequestType::IMAGE};
+        VulkanReadbackSource   source {VulkanReadbackSource::OBJECT_ID};
+        int32_t                x {0};
+        int32_t                y {0};
+        uint32_t               width {0};
+        uint32_t               height {0};
+        VkBuffer               buffer {VK_NULL_HANDLE};
+        VkQueryPool            queryPool {VK_NULL_HANDLE};
+        VkDeviceSize           offset {0}; // buffer offset or first query
+        VkDeviceSize           size {0};   // buffer range or query count
+        VulkanReadbackCallback callback;
+    };
+
+    struct Copy
+    {
+        VulkanReadbackResult   result {};
+        VkDeviceSize           offset {0};
+        VulkanReadbackCallback callback;
+    };
+
+    struct Frame
+    {
+        VkCommandBuffer   commandBuffer {VK_NULL_HANDLE};
+        VkDeviceSize      ringBytes {0}; // allocated including the tail skipped when wrapping around
+        std::vector<Copy> copies;
+    };
+
+    // false when the ring cannot hold the size until older frames released their part
+    bool allocate(Frame& frame, VkDeviceSize size, VkDeviceSize& offset);
+
+    VkDevice           device_ {VK_NULL_HANDLE};
+    VkCommandPool      commandPool_ {VK_NULL_HANDLE};
+    VkBuffer           ringBuffer_ {VK_NULL_HANDLE};
+    VkDeviceMemory     ringMemory_ {VK_NULL_HANDLE};
+    const std::byte*   ringData_ {nullptr};
+    VkDeviceSize       ringSize_ {0};
+    VkDeviceSize       ringMemorySize_ {0};
+    VkDeviceSize       ringHead_ {0};
+    VkDeviceSize       ringUsed_ {0};
+    VkDeviceSize       nonCoherentAtomSize_ {1};
+    bool               hostCoherent_ {true};
+    std::vector<Frame> frames_;
+
+    // any thread -> render thread
+    std::mutex           mutex_;
+    std::vector<Request> requests_;
+    std::atomic<int32_t> pendingCount_ {0};
+};
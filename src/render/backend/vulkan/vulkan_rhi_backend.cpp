@@ -0,0 +1,373 @@
+#include "render/backend/vulkan/vulkan_rhi_backend.h"
+#include "render/backend/vulkan/vulkan_utils.h"
+
+#include <cstring>
+
+void VulkanRhiBackend::create(VkPhysicalDevice physicalDevice, VkDevice device)
+{
+    physicalDevice_ = physicalDevice;
+    device_         = device;
+
+    buffers_.resize(1);
+    pipelines_.resize(1);
+    descriptorSets_.resize(1);
+}
+
+void VulkanRhiBackend::destroy()
+{
+    for (auto& entry : buffers_)
+    {
+        if (entry.memory != VK_NULL_HANDLE)
+        {
+            vkDestroyBuffer(device_, entry.buffer, nullptr);
+            vkFreeMemory(device_, entry.memory, nullptr);
+        }
+    }
+
+    buffers_.clear();
+    freeBufferSlots_.clear();
+    pipelines_.clear();
+    freePipelineSlots_.clear();
+    descriptorSets_.clear();
+    freeDescriptorSetSlots_.clear();
+}
+
+RhiBufferHandle VulkanRhiBackend::createBuffer(const RhiBufferDesc& desc, const void* initialData)
+{
+    VkBufferUsageFlags usage = 0;
+    if ((desc.usage & RHI_BUFFER_USAGE_VERTEX) != 0)
+        usage |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    if ((desc.usage & RHI_BUFFER_USAGE_INDEX) != 0)
+        usage |= VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+    if ((desc.usage & RHI_BUFFER_USAGE_UNIFORM) != 0)
+        usage |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    if ((desc.usage & RHI_BUFFER_USAGE_STORAGE) != 0)
+        usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    if ((desc.usage & RHI_BUFFER_USAGE_INDIRECT) != 0)
+        usage |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+
+    VkBufferCreateInfo bufferInfo {};
+    bufferInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size        = desc.size;
+    bufferInfo.usage       = usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    BufferEntry entry {};
+    if (vkCreateBuffer(device_, &bufferInfo, nullptr, &entry.buffer) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create rhi buffer!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements(device_, entry.buffer, &memRequirements);
+
+    VkMemoryAllocateInfo allocInfo {};
+    allocInfo.sType          = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    if (!VulkanUtils::findMemoryTypeIndex(physicalDevice_,
+                                          memRequirements.memoryTypeBits,
+                                          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                          allocInfo.memoryTypeIndex))
+    {
+        LOG_FATAL("Failed to find a host visible memory type for a rhi buffer!");
+    }
+
+    if (vkAllocateMemory(device_, &allocInfo, nullptr, &entry.memory) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to allocate rhi buffer memory!");
+    }
+    vkBindBufferMemory(device_, entry.buffer, entry.memory, 0);
+
+    if (initialData != nullptr)
+    {
+        void* data {nullptr};
+        vkMapMemory(device_, entry.memory, 0, desc.size, 0, &data);
+        memcpy(data, initialData, static_cast<size_t>(desc.size));
+        vkUnmapMemory(device_, entry.memory);
+    }
+
+    const auto handle      = allocateSlot<RhiBufferHandle>(buffers_, freeBufferSlots_);
+    buffers_[handle.index] = entry;
+
+    return handle;
+}
+
+void VulkanRhiBackend::destroyBuffer(RhiBufferHandle buffer)
+{
+    BufferEntry& entry = buffers_[buffer.index];
+    if (entry.memory != VK_NULL_HANDLE)
+    {
+        vkDestroyBuffer(device_, entry.buffer, nullptr);
+        vkFreeMemory(device_, entry.memory, nullptr);
+    }
+
+    entry = {};
+    freeBufferSlots_.push_back(buffer.index);
+}
+
+RhiBufferHandle VulkanRhiBackend::importBuffer(VkBuffer buffer, RhiBufferHandle handle)
+{
+    if (!handle.isValid())
+    {
+        handle = allocateSlot<RhiBufferHandle>(buffers_, freeBufferSlots_);
+    }
+
+    buffers_[handle.index] = {buffer, VK_NULL_HANDLE};
+
+    return handle;
+}
+
+RhiPipelineHandle VulkanRhiBackend::importPipeline(VkPipeline          pipeline,
+                                                   VkPipelineLayout    layout,
+                                                   VkPipelineBindPoint bindPoint,
+                                                   RhiPipelineHandle   handle)
+{
+    if (!handle.isValid())
+    {
+        handle = allocateSlot<RhiPipelineHandle>(pipelines_, freePipelineSlots_);
+    }
+
+    pipelines_[handle.index] = {pipeline, layout, bindPoint};
+
+    return handle;
+}
+
+RhiDescriptorSetHandle VulkanRhiBackend::importDescriptorSet(VkDescriptorSet        descriptorSet,
+                                                             RhiDescriptorSetHandle handle)
+{
+    if (!handle.isValid())
+    {
+        handle = allocateSlot<RhiDescriptorSetHandle>(descriptorSets_, freeDescriptorSetSlots_);
+    }
+
+    descriptorSets_[handle.index] = descriptorSet;
+
+    return handle;
+}
+
+void VulkanRhiBackend::setCommandBuffer(VkCommandBuffer commandBuffer)
+{
+    commandBuffer_ = commandBuffer;
+    bound_         = {};
+}
+
+void VulkanRhiBackend::execute(const RhiCommandList& commandList)
+{
+    commandList.forEach([this](const RhiCommandHeader& header) { translate(header); });
+}
+
+template<typename HANDLE, typename ENTRY>
+HANDLE VulkanRhiBackend::allocateSlot(std::vector<ENTRY>& entries, std::vector<uint32_t>& freeSlots)
+{
+    HANDLE handle {};
+    if (!freeSlots.empty())
+    {
+        handle.index = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else
+    {
+        handle.index = static_cast<uint32_t>(entries.size());
+        entries.emplace_back();
+    }
+
+    return handle;
+}
+
+void VulkanRhiBackend::translate(const RhiCommandHeader& header)
+{
+    statistics_.commandCount++;
+
+    switch (header.type)
+    {
+        case RhiCommandType::BIND_PIPELINE: {
+            const auto& command = RhiCommandList::as<RhiCmdBindPipeline>(header);
+            if (command.pipeline == bound_.pipeline)
+            {
+                statistics_.redundantCommandCount++;
+                break;
+            }
+
+            const PipelineEntry& entry = pipelines_[command.pipeline.index];
+            vkCmdBindPipeline(commandBuffer_, entry.bindPoint, entry.pipeline);
+
+            // sets bound against another layout are not guaranteed to stay valid
+            if (entry.layout != bound_.layout)
+            {
+                bound_.descriptorSets = {};
+                bound_.layout         = entry.layout;
+            }
+            bound_.pipeline = command.pipeline;
+            break;
+        }
+        case RhiCommandType::BIND_DESCRIPTOR_SET: {
+            const auto&          command = RhiCommandList::as<RhiCmdBindDescriptorSet>(header);
+            const PipelineEntry& entry   = pipelines_[command.pipeline.index];
+            if (entry.layout == bound_.layout && command.setIndex < MAX_BOUND_SETS &&
+                bound_.descriptorSets[command.setIndex] == command.descriptorSet)
+            {
+                statistics_.redundantCommandCount++;
+                break;
+            }
+
+            vkCmdBindDescriptorSets(commandBuffer_,
+                                    entry.bindPoint,
+                                    entry.layout,
+                                    command.setIndex,
+                                    1,
+                                    &descriptorSets_[command.descriptorSet.index],
+                                    0,
+                                    nullptr);
+
+            if (entry.layout != bound_.layout)
+            {
+                bound_.descriptorSets = {};
+                bound_.layout         = entry.layout;
+            }
+            if (command.setIndex < MAX_BOUND_SETS)
+            {
+                bound_.descriptorSets[command.setIndex] = command.descriptorSet;
+            }
+            break;
+        }
+        case RhiCommandType::BIND_VERTEX_BUFFER: {
+            const auto& command = RhiCommandList::as<RhiCmdBindVertexBuffer>(header);
+            if (command.binding >= MAX_VERTEX_BINDINGS)
+            {
+                LOG_FATAL("Vertex buffer binding {} exceeds the rhi limit", command.binding);
+            }
+
+            if (bound_.vertexBuffers[command.binding] == command.buffer &&
+                bound_.vertexOffsets[command.binding] == command.offset)
+            {
+                statistics_.redundantCommandCount++;
+                break;
+            }
+
+            // deferred until the next draw so neighbouring bindings go out in one call
+            bound_.vertexBuffers[command.binding] = command.buffer;
+            bound_.vertexOffsets[command.binding] = command.offset;
+            bound_.dirtyVertexBindings |= 1U << command.binding;
+            break;
+        }
+        case RhiCommandType::BIND_INDEX_BUFFER: {
+            const auto& command = RhiCommandList::as<RhiCmdBindIndexBuffer>(header);
+            if (bound_.indexBuffer == command.buffer && bound_.indexType == command.indexType &&
+                bound_.indexOffset == command.offset)
+            {
+                statistics_.redundantCommandCount++;
+                break;
+            }
+
+            const VkIndexType indexType =
+                command.indexType == RhiIndexType::UINT16 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+            vkCmdBindIndexBuffer(commandBuffer_, buffers_[command.buffer.index].buffer, command.offset, indexType);
+
+            bound_.indexBuffer = command.buffer;
+            bound_.indexType   = command.indexType;
+            bound_.indexOffset = command.offset;
+            break;
+        }
+        case RhiCommandType::SET_VIEWPORT: {
+            const auto& command = RhiCommandList::as<RhiCmdSetViewport>(header);
+            if (bound_.viewportValid && memcmp(&bound_.viewport, &command.viewport, sizeof(RhiViewport)) == 0)
+            {
+                statistics_.redundantCommandCount++;
+                break;
+            }
+
+            VkViewport viewport {};
+            viewport.x        = command.viewport.x;
+            viewport.y        = command.viewport.y;
+            viewport.width    = command.viewport.width;
+            viewport.height   = command.viewport.height;
+            viewport.minDepth = command.viewport.minDepth;
+            viewport.maxDepth = command.viewport.maxDepth;
+            vkCmdSetViewport(commandBuffer_, 0, 1, &viewport);
+
+            bound_.viewport      = command.viewport;
+            bound_.viewportValid = true;
+            break;
+        }
+        case RhiCommandType::SET_SCISSOR: {
+            const auto& command = RhiCommandList::as<RhiCmdSetScissor>(header);
+            if (bound_.scissorValid && memcmp(&bound_.scissor, &command.scissor, sizeof(RhiRect)) == 0)
+            {
+                statistics_.redundantCommandCount++;
+                break;
+            }
+
+            VkRect2D scissor {};
+            scissor.offset = {command.scissor.x, command.scissor.y};
+            scissor.extent = {command.scissor.width, command.scissor.height};
+            vkCmdSetScissor(commandBuffer_, 0, 1, &scissor);
+
+            bound_.scissor      = command.scissor;
+            bound_.scissorValid = true;
+            break;
+        }
+        case RhiCommandType::DRAW: {
+            const auto& command = RhiCommandList::as<RhiCmdDraw>(header);
+            flushVertexBindings();
+            vkCmdDraw(
+                commandBuffer_, command.vertexCount, command.instanceCount, command.firstVertex, command.firstInstance);
+            statistics_.drawCount++;
+            break;
+        }
+        case RhiCommandType::DRAW_INDEXED: {
+            const auto& command = RhiCommandList::as<RhiCmdDrawIndexed>(header);
+            flushVertexBindings();
+            vkCmdDrawIndexed(commandBuffer_,
+                             command.indexCount,
+                             command.instanceCount,
+                             command.firstIndex,
+                             command.vertexOffset,
+                             command.firstInstance);
+            statistics_.drawCount++;
+            break;
+        }
+        case RhiCommandType::DRAW_INDIRECT: {
+            const auto& command = RhiCommandList::as<RhiCmdDrawIndirect>(header);
+            flushVertexBindings();
+            vkCmdDrawIndirect(commandBuffer_,
+                              buffers_[command.buffer.index].buffer,
+                              command.offset,
+                              command.drawCount,
+                              command.stride);
+            statistics_.drawCount += command.drawCount;
+            break;
+        }
+        default:
+            LOG_FATAL("Unknown rhi command type {}", static_cast<uint32_t>(header.type));
+            break;
+    }
+}
+
+void VulkanRhiBackend::flushVertexBindings()
+{
+    std::array<VkBuffer, MAX_VERTEX_BINDINGS>     buffers {};
+    std::array<VkDeviceSize, MAX_VERTEX_BINDINGS> offsets {};
+
+    uint32_t binding = 0;
+    while (bound_.dirtyVertexBindings != 0)
+    {
+        if ((bound_.dirtyVertexBindings & (1U << binding)) == 0)
+        {
+            binding++;
+            continue;
+        }
+
+        // one call per run of consecutive dirty bindings
+        uint32_t count = 0;
+        while (binding + count < MAX_VERTEX_BINDINGS && (bound_.dirtyVertexBindings & (1U << (binding + count))) != 0)
+        {
+            buffers[count] = buffers_[bound_.vertexBuffers[binding + count].index].buffer;
+            offsets[count] = bound_.vertexOffsets[binding + count];
+            bound_.dirtyVertexBindings &= ~(1U << (binding + count));
+            count++;
+        }
+
+        vkCmdBindVertexBuffers(commandBuffer_, binding, count, buffers.data(), offsets.data());
+        binding += count;
+    }
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "render/rhi/rhi_backend.h"
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Translates RHI command packets into a VkCommandBuffer. State that is already bound is filtered out and vertex
+// buffer bindings are collected until the next draw, so consecutive bindings end up in a single
+// vkCmdBindVertexBuffers call.
+class VulkanRhiBackend : public RhiBackend {
+public:
+    void create(VkPhysicalDevice physicalDevice, VkDevice device);
+    void destroy();
+
+    [[nodiscard]] const char* getName() const override { return "vulkan"; }
+
+    // host visible buffers, meant for data the cpu rewrites often
+    RhiBufferHandle createBuffer(const RhiBufferDesc& desc, const void* initialData) override;
+    void            destroyBuffer(RhiBufferHandle buffer) override;
+
+    // objects created outside of the RHI, passing a valid handle re-points it at the new object after a rebuild
+    RhiBufferHandle        importBuffer(VkBuffer buffer, RhiBufferHandle handle = {});
+    RhiPipelineHandle      importPipeline(VkPipeline          pipeline,
+                                          VkPipelineLayout    layout,
+                                          VkPipelineBindPoint bindPoint,
+                                          RhiPipelineHandle   handle = {});
+    RhiDescriptorSetHandle importDescriptorSet(VkDescriptorSet descriptorSet, RhiDescriptorSetHandle handle = {});
+
+    // target of the following execute calls, nothing is assumed to be bound in it yet
+    void setCommandBuffer(VkCommandBuffer commandBuffer);
+
+    void execute(const RhiCommandList& commandList) override;
+
+private:
+    static constexpr uint32_t MAX_VERTEX_BINDINGS = 8;
+    static constexpr uint32_t MAX_BOUND_SETS      = 4;
+
+    struct BufferEntry
+    {
+        VkBuffer       buffer {};
+        VkDeviceMemory memory {}; // null for imported buffers
+    };
+
+    struct PipelineEntry
+    {
+        VkPipeline          pipeline {};
+        VkPipelineLayout    layout {};
+        VkPipelineBindPoint bindPoint {VK_PIPELINE_BIND_POINT_GRAPHICS};
+    };
+
+    struct BoundState
+    {
+        RhiPipelineHandle                                  pipeline {};
+        VkPipelineLayout                                   layout {};
+        std::array<RhiDescriptorSetHandle, MAX_BOUND_SETS> descriptorSets {};
+        std::array<RhiBufferHandle, MAX_VERTEX_BINDINGS>   vertexBuffers {};
+        std::array<uint64_t, MAX_VERTEX_BINDINGS>          vertexOffsets {};
+        uint32_t                                           dirtyVertexBindings {0};
+        RhiBufferHandle                                    indexBuffer {};
+        RhiIndexType                                       indexType {RhiIndexType::UINT32};
+        uint64_t                                           indexOffset {0};
+        RhiViewport                                        viewport {};
+        bool                                               viewportValid {false};
+        RhiRect                                            scissor {};
+        bool                                               scissorValid {false};
+    };
+
+    template<typename HANDLE, typename ENTRY>
+    static HANDLE allocateSlot(std::vector<ENTRY>& entries, std::vector<uint32_t>& freeSlots);
+
+    void translate(const RhiCommandHeader& header);
+    void flushVertexBindings();
+
+    VkPhysicalDevice physicalDevice_ {nullptr};
+    VkDevice         device_ {nullptr};
+    VkCommandBuffer  commandBuffer_ {nullptr};
+    BoundState       bound_ {};
+
+    // slot 0 of every table stays empty so a zero handle is never valid
+    std::vector<BufferEntry>     buffers_;
+    std::vector<uint32_t>        freeBufferSlots_;
+    std::vector<PipelineEntry>   pipelines_;
+    std::vector<uint32_t>        freePipelineSlots_;
+    std::vector<VkDescriptorSet> descriptorSets_;
+    std::vector<uint32_t>        freeDescriptorSetSlots_;
+};
@@ -0,0 +1,355 @@
+#include "render/backend/vulkan/vulkan_skinning_pass.h"
+#include "render/backend/vulkan/vulkan_utils.h"
+
+#include "foundation/log/log_system.h"
+
+#include <array>
+
+namespace
+{
+// local_size_x of skinning.comp
+constexpr uint32_t SKINNING_GROUP_SIZE = 64;
+
+// bind pose, palettes, skinned vertices
+constexpr uint32_t SKINNING_BINDING_COUNT = 3;
+
+struct SkinningPushConstants
+{
+    uint32_t vertexCount {0};
+    uint32_t instanceCount {0};
+    uint32_t jointCount {0};
+    uint32_t outputStride {0}; // in floats
+};
+} // namespace
+
+void VulkanSkinningPass::create(VkPhysicalDevice         physicalDevice,
+                                VkDevice                 device,
+                                VkPipelineCache          pipelineCache,
+                                const std::vector<char>& shaderCode,
+                                uint32_t                 outputVertexSize)
+{
+    physicalDevice_   = physicalDevice;
+    device_           = device;
+    outputVertexSize_ = outputVertexSize;
+
+    std::array<VkDescriptorSetLayoutBinding, SKINNING_BINDING_COUNT> bindings {};
+    for (uint32_t binding = 0; binding < SKINNING_BINDING_COUNT; binding++)
+    {
+        bindings[binding].binding         = binding;
+        bindings[binding].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[binding].descriptorCount = 1;
+        bindings[binding].stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo {};
+    layoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings    = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(device_, &layoutInfo, nullptr, &descriptorSetLayout_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create skinning descriptor set layout!");
+    }
+
+    VkPushConstantRange pushConstantRange {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset     = 0;
+    pushConstantRange.size       = sizeof(SkinningPushConstants);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo {};
+    pipelineLayoutInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount         = 1;
+    pipelineLayoutInfo.pSetLayouts            = &descriptorSetLayout_;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges    = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(device_, &pipelineLayoutInfo, nullptr, &pipelineLayout_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create skinning pipeline layout!");
+    }
+
+    VkShaderModuleCreateInfo moduleInfo {};
+    moduleInfo.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    moduleInfo.codeSize = shaderCode.size();
+    moduleInfo.pCode    = reinterpret_cast<const uint32_t*>(shaderCode.data());
+
+    VkShaderModule shaderModule = VK_NULL_HANDLE;
+    if (vkCreateShaderModule(device_, &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create skinning shader module!");
+    }
+
+    VkComputePipelineCreateInfo pipelineInfo {};
+    pipelineInfo.sType        = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = shaderModule;
+    pipelineInfo.stage.pName  = "main";
+    pipelineInfo.layout       = pipelineLayout_;
+
+    if (vkCreateComputePipelines(device_, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create skinning pipeline!");
+    }
+
+    vkDestroyShaderModule(device_, shaderModule, nullptr);
+}
+
+void VulkanSkinningPass::destroy()
+{
+    destroyFrameResources();
+
+    vkDestroyBuffer(device_, bindPoseBuffer_, nullptr);
+    vkFreeMemory(device_, bindPoseMemory_, nullptr);
+    vkDestroyBuffer(device_, outputBuffer_, nullptr);
+    vkFreeMemory(device_, outputMemory_, nullptr);
+    bindPoseBuffer_ = VK_NULL_HANDLE;
+    bindPoseMemory_ = VK_NULL_HANDLE;
+    outputBuffer_   = VK_NULL_HANDLE;
+    outputMemory_   = VK_NULL_HANDLE;
+
+    vkDestroyPipeline(device_, pipeline_, nullptr);
+    vkDestroyPipelineLayout(device_, pipelineLayout_, nullptr);
+    vkDestroyDescriptorSetLayout(device_, descriptorSetLayout_, nullptr);
+    pipeline_            = VK_NULL_HANDLE;
+    pipelineLayout_      = VK_NULL_HANDLE;
+    descriptorSetLayout_ = VK_NULL_HANDLE;
+}
+
+Task<void> VulkanSkinningPass::uploadMesh(VulkanUploadQueue&   uploadQueue,
+                                          const SkinnedVertex* vertices,
+                                          uint32_t             vertexCount,
+                                          uint32_t             jointCount,
+                                          uint32_t             instanceCount)
+{
+    vertexCount_   = vertexCount;
+    jointCount_    = jointCount;
+    instanceCount_ = instanceCount;
+
+    const VkDeviceSize bindPoseSize = sizeof(SkinnedVertex) * vertexCount;
+    createBuffer(bindPoseSize,
+                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                 bindPoseBuffer_,
+                 bindPoseMemory_);
+
+    // every instance gets its own copy of the mesh, a draw picks it through the vertex offset
+    createBuffer(static_cast<VkDeviceSize>(outputVertexSize_) * vertexCount * instanceCount,
+                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                 outputBuffer_,
+                 outputMemory_);
+
+    const auto recordUpload = [target = bindPoseBuffer_, bindPoseSize](VkCommandBuffer commandBuffer,
+                                                                       VkBuffer        stagingBuffer,
+                                                                       VkDeviceSize    stagingOffset) {
+        VkBufferCopy copyRegion {};
+        copyRegion.srcOffset = stagingOffset;
+        copyRegion.size      = bindPoseSize;
+        vkCmdCopyBuffer(commandBuffer, stagingBuffer, target, 1, &copyRegion);
+
+        VkBufferMemoryBarrier barrier {};
+        barrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask       = VK_ACCESS_SHADER_READ_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer              = target;
+        barrier.offset              = 0;
+        barrier.size                = VK_WHOLE_SIZE;
+
+        vkCmdPipelineBarrier(commandBuffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0,
+                             0,
+                             nullptr,
+                             1,
+                             &barrier,
+                             0,
+                             nullptr);
+    };
+    co_await uploadQueue.upload(vertices, bindPoseSize, recordUpload);
+
+    LOG_INFO("Skinning: {} vertices, {} joints, {} instances", vertexCount_, jointCount_, instanceCount_);
+}
+
+void VulkanSkinningPass::createFrameResources(uint32_t imageCount)
+{
+    VkDescriptorPoolSize poolSize {};
+    poolSize.type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSize.descriptorCount = imageCount * SKINNING_BINDING_COUNT;
+
+    VkDescriptorPoolCreateInfo poolInfo {};
+    poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes    = &poolSize;
+    poolInfo.maxSets       = imageCount;
+
+    if (vkCreateDescriptorPool(device_, &poolInfo, nullptr, &descriptorPool_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create skinning descriptor pool!");
+    }
+
+    const VkDeviceSize paletteSize = sizeof(SkinningMatrix) * jointCount_ * instanceCount_;
+
+    frames_.resize(imageCount);
+    for (Frame& frame : frames_)
+    {
+        // written straight from the pose evaluation jobs, the shader reads every matrix exactly once
+        createBuffer(paletteSize,
+                     VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                     frame.paletteBuffer,
+                     frame.paletteMemory);
+
+        void* mapped = nullptr;
+        vkMapMemory(device_, frame.paletteMemory, 0, VK_WHOLE_SIZE, 0, &mapped);
+        frame.palette = static_cast<SkinningMatrix*>(mapped);
+
+        VkDescriptorSetAllocateInfo allocInfo {};
+        allocInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool     = descriptorPool_;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts        = &descriptorSetLayout_;
+
+        if (vkAllocateDescriptorSets(device_, &allocInfo, &frame.descriptorSet) != VK_SUCCESS)
+        {
+            LOG_FATAL("Failed to allocate skinning descriptor set!");
+        }
+
+        const std::array<VkDescriptorBufferInfo, SKINNING_BINDING_COUNT> bufferInfos = {{
+            {bindPoseBuffer_, 0, VK_WHOLE_SIZE},
+            {frame.paletteBuffer, 0, VK_WHOLE_SIZE},
+            {outputBuffer_, 0, VK_WHOLE_SIZE},
+        }};
+
+        std::array<VkWriteDescriptorSet, SKINNING_BINDING_COUNT> descriptorWrites {};
+        for (uint32_t binding = 0; binding < SKINNING_BINDING_COUNT; binding++)
+        {
+            descriptorWrites[binding].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descriptorWrites[binding].dstSet          = frame.descriptorSet;
+            descriptorWrites[binding].dstBinding      = binding;
+            descriptorWrites[binding].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            descriptorWrites[binding].descriptorCount = 1;
+            descriptorWrites[binding].pBufferInfo     = &bufferInfos[binding];
+        }
+
+        vkUpdateDescriptorSets(
+            device_, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+    }
+}
+
+void VulkanSkinningPass::destroyFrameResources()
+{
+    for (const Frame& frame : frames_)
+    {
+        vkUnmapMemory(device_, frame.paletteMemory);
+        vkDestroyBuffer(device_, frame.paletteBuffer, nullptr);
+        vkFreeMemory(device_, frame.paletteMemory, nullptr);
+    }
+    frames_.clear();
+
+    // frees the descriptor sets along with it
+    vkDestroyDescriptorPool(device_, descriptorPool_, nullptr);
+    descriptorPool_ = VK_NULL_HANDLE;
+}
+
+SkinningMatrix* VulkanSkinningPass::getPalette(uint32_t imageIndex) const
+{
+    return frames_[imageIndex].palette;
+}
+
+void VulkanSkinningPass::record(VkCommandBuffer commandBuffer, uint32_t imageIndex) const
+{
+    // the previous frame may still be drawing from the output, an execution dependency covers write after read
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr);
+
+    SkinningPushConstants constants {};
+    constants.vertexCount   = vertexCount_;
+    constants.instanceCount = instanceCount_;
+    constants.jointCount    = jointCount_;
+    constants.outputStride  = outputVertexSize_ / static_cast<uint32_t>(sizeof(float));
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_);
+    vkCmdBindDescriptorSets(commandBuffer,
+                            VK_PIPELINE_BIND_POINT_COMPUTE,
+                            pipelineLayout_,
+                            0,
+                            1,
+                            &frames_[imageIndex].descriptorSet,
+                            0,
+                            nullptr);
+    vkCmdPushConstants(
+        commandBuffer, pipelineLayout_, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+
+    // one invocation per skinned vertex across all instances
+    const uint32_t invocationCount = vertexCount_ * instanceCount_;
+    vkCmdDispatch(commandBuffer, (invocationCount + SKINNING_GROUP_SIZE - 1) / SKINNING_GROUP_SIZE, 1, 1);
+
+    VkBufferMemoryBarrier barrier {};
+    barrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask       = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask       = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer              = outputBuffer_;
+    barrier.offset              = 0;
+    barrier.size                = VK_WHOLE_SIZE;
+
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                         0,
+                         0,
+                         nullptr,
+                         1,
+                         &barrier,
+                         0,
+                         nullptr);
+}
+
+void VulkanSkinningPass::createBuffer(VkDeviceSize          size,
+                                      VkBufferUsageFlags    usage,
+                                      VkMemoryPropertyFlags properties,
+                                      VkBuffer&             buffer,
+                                      VkDeviceMemory&       bufferMemory) const
+{
+    VkBufferCreateInfo bufferInfo {};
+    bufferInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size        = size;
+    bufferInfo.usage       = usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create skinning buffer!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
+
+    VkMemoryAllocateInfo allocInfo {};
+    allocInfo.sType          = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    if (!VulkanUtils::findMemoryTypeIndex(
+            physicalDevice_, memRequirements.memoryTypeBits, properties, allocInfo.memoryTypeIndex))
+    {
+        LOG_FATAL("Failed to find a memory type for skinning buffers!");
+    }
+
+    if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to allocate skinning buffer memory!");
+    }
+    vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+}
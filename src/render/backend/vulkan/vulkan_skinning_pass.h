@@ -0,0 +1,83 @@
+#pragma once
+
+#include "foundation/animation/skeletal_animation.h"
+#include "foundation/async/task.h"
+#include "render/asset/procedural_mesh.h"
+#include "render/backend/vulkan/vulkan_loader.h"
+#include "render/backend/vulkan/vulkan_upload_queue.h"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+// Skins every instance of one mesh with a compute shader, once per frame. The skinned vertices of all instances land
+// back to back in one vertex buffer in the regular vertex layout, every pass draws them like static geometry instead
+// of skinning again in its vertex shader. The cpu writes the palettes into a persistently mapped buffer per swapchain
+// image, the dispatch is recorded into the primary command buffer of that image ahead of the main pass.
+class VulkanSkinningPass {
+public:
+    void create(VkPhysicalDevice         physicalDevice,
+                VkDevice                 device,
+                VkPipelineCache          pipelineCache,
+                const std::vector<char>& shaderCode,
+                uint32_t                 outputVertexSize);
+    void destroy();
+
+    // Uploads the bind pose and sizes the output for the instances, before the frame resources are created. The
+    // vertices only have to stay valid until the upload suspended
+    Task<void> uploadMesh(VulkanUploadQueue&   uploadQueue,
+                          const SkinnedVertex* vertices,
+                          uint32_t             vertexCount,
+                          uint32_t             jointCount,
+                          uint32_t             instanceCount);
+
+    // palette buffers and descriptor sets, one per swapchain image
+    void createFrameResources(uint32_t imageCount);
+    void destroyFrameResources();
+
+    // jointCount matrices per instance, the image must not be in flight while they are written
+    [[nodiscard]] SkinningMatrix* getPalette(uint32_t imageIndex) const;
+
+    // skins into the output buffer and makes it visible to vertex input, outside of any render pass
+    void record(VkCommandBuffer commandBuffer, uint32_t imageIndex) const;
+
+    [[nodiscard]] bool     isReady() const { return outputBuffer_ != VK_NULL_HANDLE && !frames_.empty(); }
+    [[nodiscard]] VkBuffer getOutputBuffer() const { return outputBuffer_; }
+    [[nodiscard]] uint32_t getVertexCount() const { return vertexCount_; }
+    [[nodiscard]] uint32_t getJointCount() const { return jointCount_; }
+    [[nodiscard]] uint32_t getInstanceCount() const { return instanceCount_; }
+
+private:
+    struct Frame
+    {
+        VkBuffer        paletteBuffer {VK_NULL_HANDLE};
+        VkDeviceMemory  paletteMemory {VK_NULL_HANDLE};
+        SkinningMatrix* palette {nullptr};
+        VkDescriptorSet descriptorSet {VK_NULL_HANDLE};
+    };
+
+    void createBuffer(VkDeviceSize          size,
+                      VkBufferUsageFlags    usage,
+                      VkMemoryPropertyFlags properties,
+                      VkBuffer&             buffer,
+                      VkDeviceMemory&       bufferMemory) const;
+
+    VkPhysicalDevice      physicalDevice_ {VK_NULL_HANDLE};
+    VkDevice              device_ {VK_NULL_HANDLE};
+    VkDescriptorSetLayout descriptorSetLayout_ {VK_NULL_HANDLE};
+    VkPipelineLayout      pipelineLayout_ {VK_NULL_HANDLE};
+    VkPipeline            pipeline_ {VK_NULL_HANDLE};
+    VkDescriptorPool      descriptorPool_ {VK_NULL_HANDLE};
+    uint32_t              outputVertexSize_ {0};
+
+    VkBuffer       bindPoseBuffer_ {VK_NULL_HANDLE};
+    VkDeviceMemory bindPoseMemory_ {VK_NULL_HANDLE};
+    VkBuffer       outputBuffer_ {VK_NULL_HANDLE};
+    VkDeviceMemory outputMemory_ {VK_NULL_HANDLE};
+    uint32_t       vertexCount_ {0};
+    uint32_t       jointCount_ {0};
+    uint32_t       instanceCount_ {0};
+
+    std::vector<Frame> frames_;
+};
@@ -0,0 +1,284 @@
+#include "render/backend/vulkan/vulkan_submit_manager.h"
+
+#include "foundation/log/log_system.h"
+
+namespace
+{
+// how long a fence wait blocks before it checks on the submit thread
+constexpr uint64_t FENCE_WAIT_SLICE_NS = 100'000'000;
+} // namespace
+
+void VulkanSubmitManager::create(VkDevice device, bool useSubmitThread)
+{
+    device_ = device;
+
+    VkFenceCreateInfo fenceInfo {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    if (vkCreateFence(device_, &fenceInfo, nullptr, &uploadFence_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create upload fence!");
+    }
+
+    if (useSubmitThread)
+    {
+        stopping_     = false;
+        submitThread_ = std::thread(&VulkanSubmitManager::submitThreadLoop, this);
+    }
+}
+
+void VulkanSubmitManager::destroy()
+{
+    if (submitThread_.joinable())
+    {
+        // the thread empties the queue before it stops
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        condition_.notify_all();
+        submitThread_.join();
+    }
+
+    vkDestroyFence(device_, uploadFence_, nullptr);
+    uploadFence_ = VK_NULL_HANDLE;
+    pendingQueues_.clear();
+}
+
+void VulkanSubmitManager::submit(VkQueue queue, const VulkanSubmitBatch& batch)
+{
+    getPendingQueue(queue).batches.push_back(batch);
+}
+
+void VulkanSubmitManager::flush(VkQueue queue, VkFence fence)
+{
+    rethrowSubmitThreadError();
+
+    PendingQueue& pendingQueue = getPendingQueue(queue);
+    if (pendingQueue.batches.empty() && fence == VK_NULL_HANDLE)
+        return;
+
+    Operation operation {};
+    operation.type  = OperationType::SUBMIT;
+    operation.queue = queue;
+    operation.fence = fence;
+    operation.batches.swap(pendingQueue.batches);
+
+    enqueue(std::move(operation));
+}
+
+void VulkanSubmitManager::flushAndWait(VkQueue queue)
+{
+    flush(queue, uploadFence_);
+    drain();
+
+    // only waits for this queue's work, unlike vkQueueWaitIdle frames in flight keep running
+    vkWaitForFences(device_, 1, &uploadFence_, VK_TRUE, UINT64_MAX);
+    vkResetFences(device_, 1, &uploadFence_);
+}
+
+void VulkanSubmitManager::waitForFence(VkFence fence)
+{
+    for (;;)
+    {
+        const VkResult result = vkWaitForFences(device_, 1, &fence, VK_TRUE, FENCE_WAIT_SLICE_NS);
+        if (result == VK_SUCCESS)
+            return;
+
+        if (result != VK_TIMEOUT)
+        {
+            LOG_FATAL("Failed to wait for fence!");
+        }
+        rethrowSubmitThreadError();
+    }
+}
+
+void VulkanSubmitManager::present(VkQueue        queue,
+                                  VkSwapchainKHR swapchain,
+                                  uint32_t       imageIndex,
+                                  VkSemaphore    waitSemaphore)
+{
+    rethrowSubmitThreadError();
+
+    Operation operation {};
+    operation.type          = OperationType::PRESENT;
+    operation.queue         = queue;
+    operation.swapchain     = swapchain;
+    operation.imageIndex    = imageIndex;
+    operation.waitSemaphore = waitSemaphore;
+
+    enqueue(std::move(operation));
+}
+
+VkResult VulkanSubmitManager::takePresentResult()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const VkResult              result = presentResult_;
+    presentResult_                     = VK_SUCCESS;
+    return result;
+}
+
+void VulkanSubmitManager::drain()
+{
+    if (submitThread_.joinable())
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [this]() {
+            return (operations_.empty() && !executing_) || submitThreadError_ != nullptr;
+        });
+    }
+
+    rethrowSubmitThreadError();
+}
+
+std::unique_lock<std::mutex> VulkanSubmitManager::lockSwapchain()
+{
+    return std::unique_lock<std::mutex>(swapchainMutex_);
+}
+
+VulkanSubmitStatistics VulkanSubmitManager::takeStatistics()
+{
+    std::lock_guard<std::mutex>  lock(mutex_);
+    const VulkanSubmitStatistics statistics = statistics_;
+    statistics_                             = {};
+    return statistics;
+}
+
+VulkanSubmitManager::PendingQueue& VulkanSubmitManager::getPendingQueue(VkQueue queue)
+{
+    // graphics and present, a linear search beats any map
+    for (auto& pendingQueue : pendingQueues_)
+    {
+        if (pendingQueue.queue == queue)
+            return pendingQueue;
+    }
+
+    pendingQueues_.push_back({});
+    pendingQueues_.back().queue = queue;
+    return pendingQueues_.back();
+}
+
+void VulkanSubmitManager::enqueue(Operation&& operation)
+{
+    if (!submitThread_.joinable())
+    {
+        execute(operation);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        operations_.push_back(std::move(operation));
+    }
+    condition_.notify_all();
+}
+
+void VulkanSubmitManager::execute(const Operation& operation)
+{
+    switch (operation.type)
+    {
+        case OperationType::SUBMIT: {
+            std::vector<VkSubmitInfo> submitInfos(operation.batches.size());
+            for (size_t index = 0; index < operation.batches.size(); index++)
+            {
+                const VulkanSubmitBatch& batch      = operation.batches[index];
+                VkSubmitInfo&            submitInfo = submitInfos[index];
+
+                submitInfo.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+                submitInfo.waitSemaphoreCount   = static_cast<uint32_t>(batch.waitSemaphores.size());
+                submitInfo.pWaitSemaphores      = batch.waitSemaphores.data();
+                submitInfo.pWaitDstStageMask    = batch.waitStages.data();
+                submitInfo.commandBufferCount   = static_cast<uint32_t>(batch.commandBuffers.size());
+                submitInfo.pCommandBuffers      = batch.commandBuffers.data();
+                submitInfo.signalSemaphoreCount = static_cast<uint32_t>(batch.signalSemaphores.size());
+                submitInfo.pSignalSemaphores    = batch.signalSemaphores.data();
+            }
+
+            if (vkQueueSubmit(operation.queue,
+                              static_cast<uint32_t>(submitInfos.size()),
+                              submitInfos.data(),
+                              operation.fence) != VK_SUCCESS)
+            {
+                LOG_FATAL("Failed to submit {} command batches!", submitInfos.size());
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            statistics_.submitCallCount++;
+            statistics_.batchCount += static_cast<uint32_t>(submitInfos.size());
+            break;
+        }
+        case OperationType::PRESENT: {
+            VkPresentInfoKHR presentInfo {};
+            presentInfo.sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+            presentInfo.waitSemaphoreCount = 1;
+            presentInfo.pWaitSemaphores    = &operation.waitSemaphore;
+            presentInfo.swapchainCount     = 1;
+            presentInfo.pSwapchains        = &operation.swapchain;
+            presentInfo.pImageIndices      = &operation.imageIndex;
+
+            VkResult result = VK_SUCCESS;
+            {
+                std::lock_guard<std::mutex> swapchainLock(swapchainMutex_);
+                result = vkQueuePresentKHR(operation.queue, &presentInfo);
+            }
+
+            // keep the first non-success result until the render thread picked it up
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (presentResult_ == VK_SUCCESS)
+            {
+                presentResult_ = result;
+            }
+            statistics_.presentCount++;
+            break;
+        }
+    }
+}
+
+void VulkanSubmitManager::submitThreadLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        condition_.wait(lock, [this]() { return stopping_ || !operations_.empty(); });
+        if (operations_.empty())
+            break;
+
+        Operation operation = std::move(operations_.front());
+        operations_.pop_front();
+        executing_ = true;
+
+        lock.unlock();
+        try
+        {
+            execute(operation);
+        }
+        catch (...)
+        {
+            // surfaces on the render thread with its next call into the manager
+            lock.lock();
+            submitThreadError_ = std::current_exception();
+            executing_         = false;
+            operations_.clear();
+            condition_.notify_all();
+            return;
+        }
+        lock.lock();
+
+        executing_ = false;
+        condition_.notify_all();
+    }
+}
+
+void VulkanSubmitManager::rethrowSubmitThreadError()
+{
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        error = submitThreadError_;
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "render/backend/vulkan/vulkan_loader.h"
+
+#include <vulkan/vulkan.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// One VkSubmitInfo worth of work, the semaphores and command buffers are copied when the batch gets queued.
+struct VulkanSubmitBatch
+{
+    std::vector<VkSemaphore>          waitSemaphores;
+    std::vector<VkPipelineStageFlags> waitStages;
+    std::vector<VkCommandBuffer>      commandBuffers;
+    std::vector<VkSemaphore>          signalSemaphores;
+};
+
+struct VulkanSubmitStatistics
+{
+    uint32_t submitCallCount {0};
+    uint32_t batchCount {0};
+    uint32_t presentCount {0};
+};
+
+// Collects batches per queue and hands everything pending on a queue to the driver with a single vkQueueSubmit.
+// With a submit thread the driver calls run there, so the render thread can start on the next frame while the
+// driver validates and patches the previous one. Every queue access has to go through the manager once it exists,
+// the queues are externally synchronized and the submit thread owns them.
+class VulkanSubmitManager {
+public:
+    void create(VkDevice device, bool useSubmitThread);
+    void destroy();
+
+    // queued until the next flush of the same queue
+    void submit(VkQueue queue, const VulkanSubmitBatch& batch);
+
+    // submits every pending batch of the queue in one call, the fence signals once all of them completed
+    void flush(VkQueue queue, VkFence fence);
+
+    // flushes the queue and blocks until its work finished on the gpu, for uploads
+    void flushAndWait(VkQueue queue);
+
+    void present(VkQueue queue, VkSwapchainKHR swapchain, uint32_t imageIndex, VkSemaphore waitSemaphore);
+
+    // result of the latest present, one frame late when a submit thread is used
+    VkResult takePresentResult();
+
+    // blocks until the fence of an earlier flush signaled. With a submit thread the fence may not have reached the
+    // driver yet, a submit thread that failed before it got there is rethrown instead of waited for forever
+    void waitForFence(VkFence fence);
+
+    // blocks until everything flushed so far was handed to the driver, required before waiting for device idle
+    void drain();
+
+    // acquire and present both access the swapchain, which is externally synchronized
+    std::unique_lock<std::mutex> lockSwapchain();
+
+    VulkanSubmitStatistics takeStatistics();
+
+private:
+    enum class OperationType : uint8_t
+    {
+        SUBMIT,
+        PRESENT,
+    };
+
+    struct Operation
+    {
+        OperationType                  type {OperationType::SUBMIT};
+        VkQueue                        queue {VK_NULL_HANDLE};
+        std::vector<VulkanSubmitBatch> batches;
+        VkFence                        fence {VK_NULL_HANDLE};
+        VkSwapchainKHR                 swapchain {VK_NULL_HANDLE};
+        uint32_t                       imageIndex {0};
+        VkSemaphore                    waitSemaphore {VK_NULL_HANDLE};
+    };
+
+    struct PendingQueue
+    {
+        VkQueue                        queue {VK_NULL_HANDLE};
+        std::vector<VulkanSubmitBatch> batches;
+    };
+
+    PendingQueue& getPendingQueue(VkQueue queue);
+    void          enqueue(Operation&& operation);
+    void          execute(const Operation& operation);
+    void          submitThreadLoop();
+    void          rethrowSubmitThreadError();
+
+    VkDevice                  device_ {VK_NULL_HANDLE};
+    VkFence                   uploadFence_ {VK_NULL_HANDLE};
+    std::vector<PendingQueue> pendingQueues_;
+
+    std::mutex swapchainMutex_;
+
+    // render thread -> submit thread, everything below is guarded by mutex_
+    std::thread             submitThread_;
+    std::deque<Operation>   operations_;
+    std::mutex              mutex_;
+    std::condition_variable condition_;
+    bool                    executing_ {false};
+    bool                    stopping_ {false};
+    std::exception_ptr      submitThreadError_;
+    VkResult                presentResult_ {VK_SUCCESS};
+    VulkanSubmitStatistics  statistics_ {};
+};
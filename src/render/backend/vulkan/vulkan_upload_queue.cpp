@@ -0,0 +1,317 @@
+#include "render/backend/vulkan/vulkan_upload_queue.h"
+#include "render/backend/vulkan/vulkan_utils.h"
+
+#include "foundation/log/log_system.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+// buffer image copies need offsets aligned to four bytes and the texel size, sixteen covers every format
+constexpr VkDeviceSize COPY_ALIGNMENT = 16;
+
+// idle blocks kept around for the next burst of uploads, the rest are freed
+constexpr size_t MAX_IDLE_STAGING_BLOCKS = 2;
+
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+} // namespace
+
+VulkanUploadQueue::UploadAwaiter::UploadAwaiter(VulkanUploadQueue&   queue,
+                                                const void*          data,
+                                                VkDeviceSize         size,
+                                                VulkanUploadRecorder recorder) :
+    queue_(queue),
+    data_(data),
+    size_(size),
+    recorder_(std::move(recorder))
+{
+}
+
+void VulkanUploadQueue::UploadAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    queue_.enqueue(data_, size_, std::move(recorder_), handle);
+}
+
+void VulkanUploadQueue::create(VkPhysicalDevice     physicalDevice,
+                               VkDevice             device,
+                               uint32_t             queueFamilyIndex,
+                               VkQueue              queue,
+                               VulkanSubmitManager& submitManager,
+                               TaskExecutor&        executor,
+                               VkDeviceSize         stagingBlockSize)
+{
+    physicalDevice_   = physicalDevice;
+    device_           = device;
+    queue_            = queue;
+    submitManager_    = &submitManager;
+    executor_         = &executor;
+    stagingBlockSize_ = stagingBlockSize;
+
+    VkPhysicalDeviceProperties properties {};
+    vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
+    stagingAlignment_ = std::max(COPY_ALIGNMENT, properties.limits.optimalBufferCopyOffsetAlignment);
+
+    VkCommandPoolCreateInfo poolInfo {};
+    poolInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = queueFamilyIndex;
+    poolInfo.flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+    if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool_) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create upload command pool!");
+    }
+}
+
+void VulkanUploadQueue::destroy()
+{
+    // the device is idle, coroutines still waiting for an upload are never resumed
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (inFlightCount_ > 0)
+    {
+        LOG_WARN("Dropping {} unfinished uploads", inFlightCount_);
+    }
+
+    for (const Batch& batch : batches_)
+    {
+        vkDestroyFence(device_, batch.fence, nullptr);
+    }
+    for (const std::unique_ptr<StagingBlock>& block : stagingBlocks_)
+    {
+        destroyStagingBlock(*block);
+    }
+    batches_.clear();
+    pending_.clear();
+    stagingBlocks_.clear();
+    inFlightCount_ = 0;
+
+    vkDestroyCommandPool(device_, commandPool_, nullptr);
+    commandPool_ = VK_NULL_HANDLE;
+}
+
+void VulkanUploadQueue::enqueue(const void*             data,
+                                VkDeviceSize            size,
+                                VulkanUploadRecorder    recorder,
+                                std::coroutine_handle<> handle)
+{
+    Upload upload {};
+    upload.size         = size;
+    upload.recorder     = std::move(recorder);
+    upload.continuation = handle;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        upload.block = allocateStaging(size, upload.offset);
+    }
+
+    // the range is ours until the upload retires, no need to hold the lock for the copy
+    memcpy(upload.block->mapped + upload.offset, data, static_cast<size_t>(size));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.push_back(std::move(upload));
+    inFlightCount_++;
+    statistics_.uploadCount++;
+    statistics_.byteCount += size;
+}
+
+VulkanUploadQueue::StagingBlock* VulkanUploadQueue::allocateStaging(VkDeviceSize size, VkDeviceSize& offset)
+{
+    offset = 0;
+
+    // larger than a block, it gets one of its own that is freed again when the upload retires
+    if (size > stagingBlockSize_)
+    {
+        std::unique_ptr<StagingBlock> block = createStagingBlock(size);
+        block->used                         = size;
+        block->liveCount                    = 1;
+        return stagingBlocks_.emplace_back(std::move(block)).get();
+    }
+
+    for (const std::unique_ptr<StagingBlock>& block : stagingBlocks_)
+    {
+        const VkDeviceSize alignedOffset = alignUp(block->used, stagingAlignment_);
+        if (block->size == stagingBlockSize_ && alignedOffset + size <= block->size)
+        {
+            offset      = alignedOffset;
+            block->used = alignedOffset + size;
+            block->liveCount++;
+            return block.get();
+        }
+    }
+
+    std::unique_ptr<StagingBlock> block = createStagingBlock(stagingBlockSize_);
+    block->used                         = size;
+    block->liveCount                    = 1;
+    return stagingBlocks_.emplace_back(std::move(block)).get();
+}
+
+void VulkanUploadQueue::releaseStaging(StagingBlock* block)
+{
+    if (--block->liveCount > 0)
+        return;
+
+    // nothing in flight reads from it any more
+    block->used = 0;
+
+    const auto idleCount = static_cast<size_t>(std::count_if(
+        stagingBlocks_.begin(), stagingBlocks_.end(), [](const std::unique_ptr<StagingBlock>& candidate) {
+            return candidate->liveCount == 0;
+        }));
+    if (block->size == stagingBlockSize_ && idleCount <= MAX_IDLE_STAGING_BLOCKS)
+        return;
+
+    destroyStagingBlock(*block);
+    std::erase_if(stagingBlocks_,
+                  [block](const std::unique_ptr<StagingBlock>& candidate) { return candidate.get() == block; });
+}
+
+std::unique_ptr<VulkanUploadQueue::StagingBlock> VulkanUploadQueue::createStagingBlock(VkDeviceSize size) const
+{
+    auto block  = std::make_unique<StagingBlock>();
+    block->size = size;
+
+    VkBufferCreateInfo bufferInfo {};
+    bufferInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size        = size;
+    bufferInfo.usage       = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(device_, &bufferInfo, nullptr, &block->buffer) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create upload staging buffer!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements(device_, block->buffer, &memRequirements);
+
+    VkMemoryAllocateInfo allocInfo {};
+    allocInfo.sType          = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    if (!VulkanUtils::findMemoryTypeIndex(physicalDevice_,
+                                          memRequirements.memoryTypeBits,
+                                          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                          allocInfo.memoryTypeIndex))
+    {
+        LOG_FATAL("Failed to find a host visible memory type for uploads!");
+    }
+
+    if (vkAllocateMemory(device_, &allocInfo, nullptr, &block->memory) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to allocate upload staging memory!");
+    }
+    vkBindBufferMemory(device_, block->buffer, block->memory, 0);
+
+    void* mapped = nullptr;
+    if (vkMapMemory(device_, block->memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to map upload staging memory!");
+    }
+    block->mapped = static_cast<uint8_t*>(mapped);
+
+    LOG_DEBUG("Created upload staging block, {} KiB", size / 1024);
+    return block;
+}
+
+void VulkanUploadQueue::destroyStagingBlock(const StagingBlock& block) const
+{
+    // freeing the memory unmaps it
+    vkDestroyBuffer(device_, block.buffer, nullptr);
+    vkFreeMemory(device_, block.memory, nullptr);
+}
+
+void VulkanUploadQueue::pump()
+{
+    // batches complete in submission order
+    while (!batches_.empty() && vkGetFenceStatus(device_, batches_.front().fence) == VK_SUCCESS)
+    {
+        const Batch batch = std::move(batches_.front());
+        batches_.pop_front();
+
+        vkDestroyFence(device_, batch.fence, nullptr);
+        vkFreeCommandBuffers(device_, commandPool_, 1, &batch.commandBuffer);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const Upload& upload : batch.uploads)
+            {
+                releaseStaging(upload.block);
+            }
+            inFlightCount_ -= static_cast<uint32_t>(batch.uploads.size());
+        }
+
+        // resumed on the executor, a continuation may run long and the pumping thread has a frame to finish
+        for (const Upload& upload : batch.uploads)
+        {
+            if (upload.continuation)
+            {
+                executor_->post(upload.continuation);
+            }
+        }
+    }
+
+    Batch batch {};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        batch.uploads.swap(pending_);
+    }
+    if (batch.uploads.empty())
+        return;
+
+    VkCommandBufferAllocateInfo allocInfo {};
+    allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool        = commandPool_;
+    allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+
+    if (vkAllocateCommandBuffers(device_, &allocInfo, &batch.commandBuffer) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to allocate upload command buffer!");
+    }
+
+    VkCommandBufferBeginInfo beginInfo {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(batch.commandBuffer, &beginInfo);
+
+    VkDeviceSize byteCount = 0;
+    for (const Upload& upload : batch.uploads)
+    {
+        upload.recorder(batch.commandBuffer, upload.block->buffer, upload.offset);
+        byteCount += upload.size;
+    }
+
+    vkEndCommandBuffer(batch.commandBuffer);
+
+    VkFenceCreateInfo fenceInfo {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    if (vkCreateFence(device_, &fenceInfo, nullptr, &batch.fence) != VK_SUCCESS)
+    {
+        LOG_FATAL("Failed to create upload fence!");
+    }
+
+    VulkanSubmitBatch submitBatch {};
+    submitBatch.commandBuffers.push_back(batch.commandBuffer);
+    submitManager_->submit(queue_, submitBatch);
+    submitManager_->flush(queue_, batch.fence);
+
+    LOG_DEBUG("Submitted {} uploads, {} KiB", batch.uploads.size(), byteCount / 1024);
+    batches_.push_back(std::move(batch));
+}
+
+bool VulkanUploadQueue::hasPendingUploads() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return inFlightCount_ > 0;
+}
+
+VulkanUploadStatistics VulkanUploadQueue::takeStatistics()
+{
+    std::lock_guard<std::mutex>  lock(mutex_);
+    const VulkanUploadStatistics statistics = statistics_;
+    statistics_                             = {};
+    return statistics;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "foundation/async/task_executor.h"
+#include "render/backend/vulkan/vulkan_loader.h"
+#include "render/backend/vulkan/vulkan_submit_manager.h"
+
+#include <vulkan/vulkan.h>
+
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+struct VulkanUploadStatistics
+{
+    uint32_t     uploadCount {0};
+    VkDeviceSize byteCount {0};
+};
+
+// records the transfer out of the staging buffer, together with whatever barriers the destination needs. The data
+// starts at stagingOffset, other uploads share the buffer
+using VulkanUploadRecorder =
+    std::function<void(VkCommandBuffer commandBuffer, VkBuffer stagingBuffer, VkDeviceSize stagingOffset)>;
+
+// Awaitable gpu uploads. Any thread can co_await upload(), the data goes into a staging block right away and the
+// coroutine stays suspended until the recorded commands finished on the gpu, then it resumes on the executor. The
+// thread that owns the queue calls pump() to submit the pending uploads as one batch and to retire finished batches,
+// the render thread once per frame and syncWait while assets load before it started.
+class VulkanUploadQueue {
+public:
+    class UploadAwaiter {
+    public:
+        UploadAwaiter(VulkanUploadQueue& queue, const void* data, VkDeviceSize size, VulkanUploadRecorder recorder);
+
+        [[nodiscard]] bool await_ready() const noexcept { return false; }
+        void               await_suspend(std::coroutine_handle<> handle);
+        void               await_resume() const noexcept {}
+
+    private:
+        VulkanUploadQueue&   queue_;
+        const void*          data_;
+        VkDeviceSize         size_;
+        VulkanUploadRecorder recorder_;
+    };
+
+    void create(VkPhysicalDevice     physicalDevice,
+                VkDevice             device,
+                uint32_t             queueFamilyIndex,
+                VkQueue              queue,
+                VulkanSubmitManager& submitManager,
+                TaskExecutor&        executor,
+                VkDeviceSize         stagingBlockSize);
+    void destroy();
+
+    // the data only has to stay valid until the awaiting coroutine suspended
+    [[nodiscard]] UploadAwaiter upload(const void* data, VkDeviceSize size, VulkanUploadRecorder recorder)
+    {
+        return UploadAwaiter(*this, data, size, std::move(recorder));
+    }
+
+    // fire and forget for uploads nobody waits on, the recorder has to order them against earlier gpu reads itself
+    void submit(const void* data, VkDeviceSize size, VulkanUploadRecorder recorder)
+    {
+        enqueue(data, size, std::move(recorder), {});
+    }
+
+    void pump();
+
+    [[nodiscard]] bool hasPendingUploads() const;
+
+    // what was enqueued since the previous call
+    VulkanUploadStatistics takeStatistics();
+
+private:
+    // persistently mapped, uploads are bump allocated from it and it starts over once none of them is in flight
+    struct StagingBlock
+    {
+        VkBuffer       buffer {VK_NULL_HANDLE};
+        VkDeviceMemory memory {VK_NULL_HANDLE};
+        uint8_t*       mapped {nullptr};
+        VkDeviceSize   size {0};
+        VkDeviceSize   used {0};
+        uint32_t       liveCount {0};
+    };
+
+    struct Upload
+    {
+        StagingBlock*           block {nullptr};
+        VkDeviceSize            offset {0};
+        VkDeviceSize            size {0};
+        VulkanUploadRecorder    recorder;
+        std::coroutine_handle<> continuation; // empty for submit()
+    };
+
+    struct Batch
+    {
+        VkCommandBuffer     commandBuffer {VK_NULL_HANDLE};
+        VkFence             fence {VK_NULL_HANDLE};
+        std::vector<Upload> uploads;
+    };
+
+    void enqueue(const void* data, VkDeviceSize size, VulkanUploadRecorder recorder, std::coroutine_handle<> handle);
+
+    // both under mutex_
+    StagingBlock* allocateStaging(VkDeviceSize size, VkDeviceSize& offset);
+    void          releaseStaging(StagingBlock* block);
+
+    [[nodiscard]] std::unique_ptr<StagingBlock> createStagingBlock(VkDeviceSize size) const;
+    void                                        destroyStagingBlock(const StagingBlock& block) const;
+
+    VkPhysicalDevice     physicalDevice_ {VK_NULL_HANDLE};
+    VkDevice             device_ {VK_NULL_HANDLE};
+    VkQueue              queue_ {VK_NULL_HANDLE};
+    VkCommandPool        commandPool_ {VK_NULL_HANDLE};
+    VkDeviceSize         stagingBlockSize_ {0};
+    VkDeviceSize         stagingAlignment_ {1};
+    VulkanSubmitManager* submitManager_ {nullptr};
+    TaskExecutor*        executor_ {nullptr};
+    std::deque<Batch>    batches_; // submitted, oldest first
+
+    // any thread -> pumping thread
+    mutable std::mutex                         mutex_;
+    std::vector<std::unique_ptr<StagingBlock>> stagingBlocks_;
+    std::vector<Upload>                        pending_;
+    uint32_t                                   inFlightCount_ {0};
+    VulkanUploadStatistics                     statistics_ {};
+};
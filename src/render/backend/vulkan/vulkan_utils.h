@@ -2,6 +2,7 @@
 
 #include "foundation/log/log_system.h"
 #include "render/backend/vulkan/vulkan_config.h"
+#include "render/backend/vulkan/vulkan_loader.h"
 
 #include <vk_value_serialization.hpp>
 #include <vulkan/vulkan.h>
@@ -94,11 +95,10 @@ public:
                                                  const VkAllocationCallbacks*              pAllocator,
                                                  VkDebugUtilsMessengerEXT*                 pDebugMessenger)
     {
-        const auto func =
-            (PFN_vkCreateDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkCreateDebugUtilsMessengerEXT");
-        if (func != nullptr)
+        // resolved by VulkanLoader::loadInstance, null when VK_EXT_debug_utils was not enabled
+        if (vkCreateDebugUtilsMessengerEXT != nullptr)
         {
-            return func(instance, pCreateInfo, pAllocator, pDebugMessenger);
+            return vkCreateDebugUtilsMessengerEXT(instance, pCreateInfo, pAllocator, pDebugMessenger);
         }
         else
         {
@@ -110,11 +110,9 @@ public:
                                               VkDebugUtilsMessengerEXT     debugMessenger,
                                               const VkAllocationCallbacks* pAllocator)
     {
-        const auto func =
-            (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkDestroyDebugUtilsMEssengerEXT");
-        if (func != nullptr)
+        if (vkDestroyDebugUtilsMessengerEXT != nullptr)
         {
-            func(instance, debugMessenger, pAllocator);
+            vkDestroyDebugUtilsMessengerEXT(instance, debugMessenger, pAllocator);
         }
     }
 
@@ -148,6 +146,65 @@ public:
         return requiredExtensions.empty();
     }
 
+    static bool isDeviceExtensionSupported(VkPhysicalDevice physicalDevice, const char* extensionName)
+    {
+        uint32_t extensionCount;
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+
+        for (const auto& extension : availableExtensions)
+        {
+            if (strcmp(extension.extensionName, extensionName) == 0)
+                return true;
+        }
+
+        return false;
+    }
+
+    // Vulkan 1.0 loaders do not export vkEnumerateInstanceVersion and reject any apiVersion above 1.0
+    static uint32_t chooseInstanceApiVersion(uint32_t targetApiVersion)
+    {
+        // only 1.1+ loaders export it
+        if (vkEnumerateInstanceVersion == nullptr)
+        {
+            return VK_API_VERSION_1_0;
+        }
+
+        uint32_t loaderApiVersion = VK_API_VERSION_1_0;
+        vkEnumerateInstanceVersion(&loaderApiVersion);
+
+        return std::min(loaderApiVersion, targetApiVersion);
+    }
+
+    static bool checkDynamicRenderingSupported(VkPhysicalDevice physicalDevice, uint32_t instanceApiVersion)
+    {
+#if VULKAN_HAS_DYNAMIC_RENDERING
+        VkPhysicalDeviceProperties properties {};
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+        // the extension depends on VK_KHR_depth_stencil_resolve, which is core since 1.2
+        if (instanceApiVersion < VK_API_VERSION_1_2 || properties.apiVersion < VK_API_VERSION_1_2)
+            return false;
+
+        if (!isDeviceExtensionSupported(physicalDevice, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME))
+            return false;
+
+        VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures {};
+        dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+
+        VkPhysicalDeviceFeatures2 features {};
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext = &dynamicRenderingFeatures;
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+        return dynamicRenderingFeatures.dynamicRendering == VK_TRUE;
+#else
+        return false;
+#endif
+    }
+
     // Queue Family Utils
     static QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface)
     {
@@ -228,7 +285,7 @@ public:
         return VK_PRESENT_MODE_FIFO_KHR;
     }
 
-    static VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, GLFWwindow* window)
+    static VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, VkExtent2D framebufferExtent)
     {
         if (capabilities.currentExtent.width != UINT32_MAX)
         {
@@ -236,10 +293,7 @@ public:
         }
         else
         {
-            int width, height;
-            glfwGetFramebufferSize(window, &width, &height);
-
-            VkExtent2D actualExtent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+            VkExtent2D actualExtent = framebufferExtent;
 
             actualExtent.width  = std::max(capabilities.minImageExtent.width,
                                           std::min(capabilities.maxImageExtent.width, actualExtent.width));
@@ -299,11 +353,44 @@ public:
         return VK_FORMAT_UNDEFINED;
     }
 
+    static bool findMemoryTypeIndex(VkPhysicalDevice      physicalDevice,
+                                    uint32_t              typeFilter,
+                                    VkMemoryPropertyFlags properties,
+                                    uint32_t&             memoryTypeIndex)
+    {
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+        for (uint32_t index = 0; index < memoryProperties.memoryTypeCount; index++)
+        {
+            if (((typeFilter & (1 << index)) != 0) &&
+                (memoryProperties.memoryTypes[index].propertyFlags & properties) == properties)
+            {
+                memoryTypeIndex = index;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
     static bool hasStencilComponent(VkFormat format)
     {
         return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
     }
 
+    // four 8 bit channels in either byte order, what the image writers accept
+    static bool isRgba8Format(VkFormat format)
+    {
+        return format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB ||
+               format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB;
+    }
+
+    static bool isBgraFormat(VkFormat format)
+    {
+        return format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB;
+    }
+
     static std::vector<char> readFile(const std::string& filename)
     {
         std::ifstream file(filename, std::ios::ate | std::ios::binary);
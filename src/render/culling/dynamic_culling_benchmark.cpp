@@ -0,0 +1,258 @@
+#include "render/culling/dynamic_culling_benchmark.h"
+#include "render/culling/loose_octree.h"
+#include "render/render_queue.h"
+
+#include "foundation/job/job_system.h"
+#include "foundation/log/log_system.h"
+#include "foundation/math/frustum.h"
+#include "foundation/spatial/bvh.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace
+{
+using Clock = std::chrono::high_resolution_clock;
+
+constexpr uint32_t MATERIAL_COUNT       = 64;
+constexpr float    LARGE_OBJECT_SHARE   = 0.01F;
+constexpr float    CAMERA_FIELD_OF_VIEW = 60.0F;
+constexpr float    CAMERA_ASPECT        = 16.0F / 9.0F;
+
+double getMilliseconds(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+Aabb makeBounds(const glm::vec3& center, const glm::vec3& halfExtent)
+{
+    Aabb bounds {};
+    bounds.min = center - halfExtent;
+    bounds.max = center + halfExtent;
+    return bounds;
+}
+} // namespace
+
+int DynamicCullingBenchmark::run(const DynamicCullingBenchmarkSettings& settings)
+{
+    const float    worldSize  = std::max(1.0F, settings.worldSize);
+    const float    halfWorld  = worldSize * 0.5F;
+    const uint32_t frameCount = std::max(1U, settings.frameCount);
+
+    // a single thread builds the bvh inline instead of spinning up a pool
+    std::optional<JobSystem> jobSystem;
+    if (settings.threadCount > 1)
+    {
+        jobSystem.emplace(settings.threadCount - 1);
+    }
+    JobSystem* jobs = jobSystem ? &*jobSystem : nullptr;
+
+    const glm::mat4 projection =
+        glm::perspective(glm::radians(CAMERA_FIELD_OF_VIEW), CAMERA_ASPECT, 0.5F, halfWorld);
+
+    for (const uint32_t objectCount : settings.objectCounts)
+    {
+        // mostly props and characters with a few buildings sized objects, spread over the whole world
+        std::mt19937                          random(1234);
+        std::uniform_real_distribution<float> positionDistribution(-halfWorld, halfWorld);
+        std::uniform_real_distribution<float> smallDistribution(0.25F, 4.0F);
+        std::uniform_real_distribution<float> largeDistribution(10.0F, 60.0F);
+        std::uniform_real_distribution<float> unitDistribution(0.0F, 1.0F);
+        std::uniform_real_distribution<float> velocityDistribution(-3.0F, 3.0F);
+
+        std::vector<glm::vec3> centers(objectCount);
+        std::vector<glm::vec3> halfExtents(objectCount);
+        std::vector<glm::vec3> velocities(objectCount);
+        std::vector<Aabb>      bounds(objectCount);
+        for (uint32_t object = 0; object < objectCount; object++)
+        {
+            std::uniform_real_distribution<float>& sizeDistribution =
+                unitDistribution(random) < LARGE_OBJECT_SHARE ? largeDistribution : smallDistribution;
+
+            centers[object]     = {positionDistribution(random), positionDistribution(random),
+                                   positionDistribution(random)};
+            halfExtents[object] = {sizeDistribution(random), sizeDistribution(random), sizeDistribution(random)};
+            velocities[object]  = {velocityDistribution(random), velocityDistribution(random),
+                                   velocityDistribution(random)};
+            bounds[object]      = makeBounds(centers[object], halfExtents[object]);
+        }
+
+        const auto insertStart = Clock::now();
+
+        LooseOctree octree;
+        octree.initialize(glm::vec3(0.0F), worldSize, settings.octreeDepth);
+
+        std::vector<uint32_t> handles(objectCount);
+        for (uint32_t object = 0; object < objectCount; object++)
+        {
+            const uint64_t material = object % MATERIAL_COUNT;
+            handles[object]         = octree.insert(bounds[object], object, (material << 32) | object);
+        }
+
+        const double insertMs = getMilliseconds(insertStart);
+
+        const uint32_t movingCount = static_cast<uint32_t>(
+            static_cast<float>(objectCount) * std::clamp(settings.movingFraction, 0.0F, 1.0F));
+
+        RenderQueue                queue;
+        std::vector<uint32_t>      visibleObjects;
+        std::vector<uint32_t>      referenceObjects;
+        std::vector<uint32_t>      sphereObjects;
+        LooseOctreeQueryStatistics queryStatistics {};
+        Bvh                        bvh;
+
+        double   updateMs         = 0.0;
+        double   frustumMs        = 0.0;
+        double   sortMs           = 0.0;
+        double   bruteForceMs     = 0.0;
+        double   sphereMs         = 0.0;
+        double   rebuildMs        = 0.0;
+        uint64_t visibleCount     = 0;
+        uint64_t insideCellCount  = 0;
+        uint64_t testedCount      = 0;
+        uint64_t sphereHitCount   = 0;
+        uint32_t mismatchedFrames = 0;
+
+        const uint64_t cellChangesBefore = octree.getStatistics().cellChangeCount;
+
+        for (uint32_t frame = 0; frame < frameCount; frame++)
+        {
+            // objects bounce off the world borders, integration is not part of the measured update
+            for (uint32_t object = 0; object < movingCount; object++)
+            {
+                glm::vec3& center   = centers[object];
+                glm::vec3& velocity = velocities[object];
+                center += velocity;
+                for (uint32_t axis = 0; axis < 3; axis++)
+                {
+                    if (std::abs(center[axis]) > halfWorld)
+                    {
+                        velocity[axis] = -velocity[axis];
+                        center[axis]   = std::clamp(center[axis], -halfWorld, halfWorld);
+                    }
+                }
+                bounds[object] = makeBounds(center, halfExtents[object]);
+            }
+
+            const auto updateStart = Clock::now();
+            for (uint32_t object = 0; object < movingCount; object++)
+            {
+                octree.update(handles[object], bounds[object]);
+            }
+            updateMs += getMilliseconds(updateStart);
+
+            // spin on the spot in the middle of the world while looking slightly down
+            const float     yaw = 6.2831853F * static_cast<float>(frame) / static_cast<float>(frameCount);
+            const glm::vec3 forward {std::cos(yaw), std::sin(yaw), -0.2F};
+            const glm::mat4 view    = glm::lookAt(glm::vec3(0.0F), forward, glm::vec3(0.0F, 0.0F, 1.0F));
+            const Frustum   frustum = Frustum::fromViewProjection(projection * view);
+
+            const auto frustumStart = Clock::now();
+            queue.clear();
+            octree.queryFrustum(frustum, queue, &queryStatistics);
+            frustumMs += getMilliseconds(frustumStart);
+
+            const auto sortStart = Clock::now();
+            queue.sort();
+            sortMs += getMilliseconds(sortStart);
+
+            visibleCount += queue.getSize();
+            insideCellCount += queryStatistics.insideCellCount;
+            testedCount += queryStatistics.testedObjectCount;
+
+            const auto bruteForceStart = Clock::now();
+            referenceObjects.clear();
+            for (uint32_t object = 0; object < objectCount; object++)
+            {
+                if (frustum.intersects(bounds[object]))
+                {
+                    referenceObjects.push_back(object);
+                }
+            }
+            bruteForceMs += getMilliseconds(bruteForceStart);
+
+            // the queue has to hold exactly the objects the scan found, in key order
+            visibleObjects.clear();
+            bool ordered = true;
+            for (size_t item = 0; item < queue.getSize(); item++)
+            {
+                const RenderItem& renderItem = queue.getItems()[item];
+                visibleObjects.push_back(renderItem.object);
+                ordered = ordered && (item == 0 || queue.getItems()[item - 1].sortKey <= renderItem.sortKey);
+            }
+            std::sort(visibleObjects.begin(), visibleObjects.end());
+            if (!ordered || visibleObjects != referenceObjects)
+            {
+                mismatchedFrames++;
+            }
+
+            const auto sphereStart = Clock::now();
+            for (uint32_t query = 0; query < settings.sphereQueriesPerFrame; query++)
+            {
+                const glm::vec3 center {positionDistribution(random), positionDistribution(random),
+                                        positionDistribution(random)};
+                sphereObjects.clear();
+                octree.querySphere(center, settings.sphereQueryRadius, sphereObjects);
+                sphereHitCount += sphereObjects.size();
+            }
+            sphereMs += getMilliseconds(sphereStart);
+
+            const auto rebuildStart = Clock::now();
+            bvh.build(bounds, jobs);
+            rebuildMs += getMilliseconds(rebuildStart);
+        }
+
+        const LooseOctreeStatistics statistics = octree.getStatistics();
+        const double                frames     = static_cast<double>(frameCount);
+        const uint64_t              moves      = static_cast<uint64_t>(movingCount) * frameCount;
+
+        LOG_INFO("dynamic culling: {} objects, {} moving, depth {} octree with {} cells, {} occupied, {} in the root",
+                 objectCount,
+                 movingCount,
+                 settings.octreeDepth,
+                 octree.getCellCount(),
+                 statistics.occupiedCellCount,
+                 statistics.rootObjectCount);
+        LOG_INFO("dynamic culling: insert {:.2f} ms, update {:.3f} ms/frame ({:.1f} ns/object, {:.1f}% changed cells)",
+                 insertMs,
+                 updateMs / frames,
+                 moves > 0 ? updateMs * 1e6 / static_cast<double>(moves) : 0.0,
+                 moves > 0 ? 100.0 * static_cast<double>(statistics.cellChangeCount - cellChangesBefore) /
+                                 static_cast<double>(moves) :
+                             0.0);
+        LOG_INFO("dynamic culling: frustum {:.3f} ms/frame for {:.0f} visible, {:.0f} objects tested, {:.0f} cells "
+                 "emitted whole, queue sort {:.3f} ms/frame",
+                 frustumMs / frames,
+                 static_cast<double>(visibleCount) / frames,
+                 static_cast<double>(testedCount) / frames,
+                 static_cast<double>(insideCellCount) / frames,
+                 sortMs / frames);
+        LOG_INFO("dynamic culling: testing every object {:.3f} ms/frame, bvh rebuild {:.2f} ms/frame on {} threads",
+                 bruteForceMs / frames,
+                 rebuildMs / frames,
+                 jobs != nullptr ? jobs->getThreadCount() : 1);
+        LOG_INFO("dynamic culling: sphere query {:.2f} us ({:.1f} objects each)",
+                 settings.sphereQueriesPerFrame > 0 ? sphereMs * 1000.0 / (frames * settings.sphereQueriesPerFrame) :
+                                                      0.0,
+                 settings.sphereQueriesPerFrame > 0 ?
+                     static_cast<double>(sphereHitCount) / (frames * settings.sphereQueriesPerFrame) :
+                     0.0);
+
+        if (mismatchedFrames > 0)
+        {
+            LOG_WARN("dynamic culling: {} of {} frustum queries disagree with testing every object",
+                     mismatchedFrames,
+                     frameCount);
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
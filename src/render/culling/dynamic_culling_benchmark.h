@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct DynamicCullingBenchmarkSettings
+{
+    std::vector<uint32_t> objectCounts {100000, 300000, 1000000};
+    float                 worldSize {2000.0F};
+    uint32_t              octreeDepth {6};
+    // share of the objects that move every frame
+    float    movingFraction {0.5F};
+    uint32_t frameCount {10};
+    uint32_t sphereQueriesPerFrame {1000};
+    float    sphereQueryRadius {25.0F};
+    // for the bvh rebuild the octree is compared against
+    uint32_t threadCount {4};
+};
+
+// Moves objects through a loose octree and queries it with a rotating camera frustum and gameplay sized spheres for
+// every object count. Visible objects go straight into a render queue that is sorted afterwards. Every frustum query
+// is checked against testing each object on its own, which is also the cost without an index, and a parallel bvh
+// rebuild over the same bounds shows what keeping a bvh up to date would cost per frame.
+class DynamicCullingBenchmark {
+public:
+    static int run(const DynamicCullingBenchmarkSettings& settings);
+};
@@ -0,0 +1,401 @@
+#include "render/culling/loose_octree.h"
+
+#include "foundation/log/log_system.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// spreads the low ten bits of value to every third bit
+uint32_t spreadBits(uint32_t value)
+{
+    value = (value | (value << 16)) & 0x030000FFU;
+    value = (value | (value << 8)) & 0x0300F00FU;
+    value = (value | (value << 4)) & 0x030C30C3U;
+    value = (value | (value << 2)) & 0x09249249U;
+    return value;
+}
+
+uint32_t encodeMorton(uint32_t x, uint32_t y, uint32_t z)
+{
+    return spreadBits(x) | (spreadBits(y) << 1) | (spreadBits(z) << 2);
+}
+
+float distanceSquared(const Aabb& bounds, const glm::vec3& point)
+{
+    const glm::vec3 closest = glm::clamp(point, bounds.min, bounds.max);
+    const glm::vec3 offset  = point - closest;
+    return glm::dot(offset, offset);
+}
+} // namespace
+
+void LooseOctree::initialize(const glm::vec3& worldCenter, float worldSize, uint32_t depth)
+{
+    if (worldSize <= 0.0F)
+    {
+        LOG_FATAL("loose octree world size has to be positive, got {}", worldSize);
+    }
+
+    depth_     = std::min(depth, MAX_DEPTH);
+    worldSize_ = worldSize;
+    worldMin_  = worldCenter - glm::vec3(worldSize * 0.5F);
+
+    levelOffsets_.resize(depth_ + 2);
+    cellSizes_.resize(depth_ + 1);
+    inverseCellSizes_.resize(depth_ + 1);
+
+    uint32_t cellCount = 0;
+    for (uint32_t level = 0; level <= depth_; level++)
+    {
+        levelOffsets_[level]     = cellCount;
+        cellSizes_[level]        = worldSize / static_cast<float>(1U << level);
+        inverseCellSizes_[level] = 1.0F / cellSizes_[level];
+        cellCount += 1U << (3 * level);
+    }
+    levelOffsets_[depth_ + 1] = cellCount;
+
+    cellHeads_.assign(cellCount, INVALID_HANDLE);
+    cellSubtreeCounts_.assign(cellCount, 0);
+
+    entries_.clear();
+
+    freeHead_        = INVALID_HANDLE;
+    objectCount_     = 0;
+    cellChangeCount_ = 0;
+}
+
+void LooseOctree::clear()
+{
+    initialize(worldMin_ + glm::vec3(worldSize_ * 0.5F), worldSize_, depth_);
+}
+
+uint32_t LooseOctree::insert(const Aabb& bounds, uint32_t object, uint64_t sortKey)
+{
+    uint32_t handle = freeHead_;
+    if (handle != INVALID_HANDLE)
+    {
+        freeHead_ = entries_[handle].next;
+    }
+    else
+    {
+        handle = static_cast<uint32_t>(entries_.size());
+        entries_.emplace_back();
+    }
+
+    Entry& entry  = entries_[handle];
+    entry.bounds  = bounds;
+    entry.object  = object;
+    entry.sortKey = sortKey;
+
+    uint32_t       level = 0;
+    const uint32_t cell  = findCell(bounds, level);
+    link(handle, cell, level);
+
+    objectCount_++;
+    return handle;
+}
+
+void LooseOctree::update(uint32_t handle, const Aabb& bounds)
+{
+    entries_[handle].bounds = bounds;
+
+    uint32_t       level = 0;
+    const uint32_t cell  = findCell(bounds, level);
+    if (cell == entries_[handle].cell)
+        return;
+
+    unlink(handle);
+    link(handle, cell, level);
+    cellChangeCount_++;
+}
+
+void LooseOctree::remove(uint32_t handle)
+{
+    unlink(handle);
+
+    entries_[handle].cell = INVALID_HANDLE;
+    entries_[handle].next = freeHead_;
+    freeHead_             = handle;
+    objectCount_--;
+}
+
+void LooseOctree::setSortKey(uint32_t handle, uint64_t sortKey)
+{
+    entries_[handle].sortKey = sortKey;
+}
+
+void LooseOctree::queryFrustum(const Frustum&              frustum,
+                               RenderQueue&                queue,
+                               LooseOctreeQueryStatistics* statistics) const
+{
+    LooseOctreeQueryStatistics counters {};
+    if (!cellSubtreeCounts_.empty() && cellSubtreeCounts_[0] > 0)
+    {
+        frustumCell({0, 0, 0, 0, 0}, frustum, queue, counters);
+    }
+    if (statistics != nullptr)
+    {
+        *statistics = counters;
+    }
+}
+
+void LooseOctree::querySphere(const glm::vec3&            center,
+                              float                       radius,
+                              std::vector<uint32_t>&      objects,
+                              LooseOctreeQueryStatistics* statistics) const
+{
+    LooseOctreeQueryStatistics counters {};
+    if (!cellSubtreeCounts_.empty() && cellSubtreeCounts_[0] > 0)
+    {
+        sphereCell({0, 0, 0, 0, 0}, center, radius, objects, counters);
+    }
+    if (statistics != nullptr)
+    {
+        *statistics = counters;
+    }
+}
+
+LooseOctreeStatistics LooseOctree::getStatistics() const
+{
+    LooseOctreeStatistics statistics {};
+    statistics.objectCount     = objectCount_;
+    statistics.cellChangeCount = cellChangeCount_;
+
+    for (const uint32_t head : cellHeads_)
+    {
+        statistics.occupiedCellCount += head != INVALID_HANDLE ? 1 : 0;
+    }
+    for (uint32_t handle = cellHeads_.empty() ? INVALID_HANDLE : cellHeads_[0]; handle != INVALID_HANDLE;
+         handle          = entries_[handle].next)
+    {
+        statistics.rootObjectCount++;
+    }
+    return statistics;
+}
+
+uint32_t LooseOctree::findCell(const Aabb& bounds, uint32_t& level) const
+{
+    const glm::vec3 center   = bounds.getCenter();
+    const glm::vec3 relative = center - worldMin_;
+    const glm::vec3 extent   = bounds.getExtent();
+
+    // the negated comparison also sends nan centers to the root
+    if (!(relative.x >= 0.0F && relative.y >= 0.0F && relative.z >= 0.0F && relative.x < worldSize_ &&
+          relative.y < worldSize_ && relative.z < worldSize_))
+    {
+        level = 0;
+        return 0;
+    }
+
+    // deepest level whose cell is at least as large as the object, the loose cell then still holds it with the center
+    // anywhere in the regular cell
+    const float largest = std::max(extent.x, std::max(extent.y, extent.z));
+    if (largest <= 0.0F)
+    {
+        level = depth_;
+    }
+    else
+    {
+        const float ratio = worldSize_ / largest;
+        level             = ratio < 1.0F ? 0 : std::min(static_cast<uint32_t>(std::ilogb(ratio)), depth_);
+    }
+
+    const uint32_t  last   = (1U << level) - 1;
+    const glm::vec3 scaled = relative * inverseCellSizes_[level];
+    const uint32_t  x      = std::min(static_cast<uint32_t>(scaled.x), last);
+    const uint32_t  y      = std::min(static_cast<uint32_t>(scaled.y), last);
+    const uint32_t  z      = std::min(static_cast<uint32_t>(scaled.z), last);
+
+    return levelOffsets_[level] + encodeMorton(x, y, z);
+}
+
+Aabb LooseOctree::getLooseBounds(const CellCoordinate& cell) const
+{
+    const float     size = cellSizes_[cell.level];
+    const glm::vec3 min  = worldMin_ + glm::vec3(static_cast<float>(cell.x), static_cast<float>(cell.y),
+                                                 static_cast<float>(cell.z)) * size;
+
+    Aabb bounds {};
+    bounds.min = min - glm::vec3(size * 0.5F);
+    bounds.max = min + glm::vec3(size * 1.5F);
+    return bounds;
+}
+
+uint32_t LooseOctree::getLevel(uint32_t cell) const
+{
+    uint32_t level = 0;
+    while (cell >= levelOffsets_[level + 1])
+    {
+        level++;
+    }
+    return level;
+}
+
+void LooseOctree::link(uint32_t handle, uint32_t cell, uint32_t level)
+{
+    const uint32_t head = cellHeads_[cell];
+    if (head != INVALID_HANDLE)
+    {
+        entries_[head].previous = handle;
+    }
+
+    Entry& entry     = entries_[handle];
+    entry.next       = head;
+    entry.previous   = INVALID_HANDLE;
+    entry.cell       = cell;
+    cellHeads_[cell] = handle;
+
+    uint32_t local = cell - levelOffsets_[level];
+    for (uint32_t ancestor = level + 1; ancestor-- > 0;)
+    {
+        cellSubtreeCounts_[levelOffsets_[ancestor] + local]++;
+        local >>= 3;
+    }
+}
+
+void LooseOctree::unlink(uint32_t handle)
+{
+    const Entry&   entry = entries_[handle];
+    const uint32_t cell  = entry.cell;
+
+    if (entry.previous != INVALID_HANDLE)
+    {
+        entries_[entry.previous].next = entry.next;
+    }
+    else
+    {
+        cellHeads_[cell] = entry.next;
+    }
+    if (entry.next != INVALID_HANDLE)
+    {
+        entries_[entry.next].previous = entry.previous;
+    }
+
+    const uint32_t level = getLevel(cell);
+    uint32_t       local = cell - levelOffsets_[level];
+    for (uint32_t ancestor = level + 1; ancestor-- > 0;)
+    {
+        cellSubtreeCounts_[levelOffsets_[ancestor] + local]--;
+        local >>= 3;
+    }
+}
+
+void LooseOctree::frustumCell(const CellCoordinate&       cell,
+                              const Frustum&              frustum,
+                              RenderQueue&                queue,
+                              LooseOctreeQueryStatistics& statistics) const
+{
+    statistics.visitedCellCount++;
+
+    // the root also holds everything outside the world, its loose bounds say nothing about those
+    if (cell.level > 0)
+    {
+        const FrustumTest test = frustum.test(getLooseBounds(cell));
+        if (test == FrustumTest::OUTSIDE)
+            return;
+
+        if (test == FrustumTest::INSIDE)
+        {
+            statistics.insideCellCount++;
+            emitSubtree(cell, queue, statistics);
+            return;
+        }
+    }
+
+    for (uint32_t handle = cellHeads_[cell.index]; handle != INVALID_HANDLE; handle = entries_[handle].next)
+    {
+        const Entry& entry = entries_[handle];
+        statistics.testedObjectCount++;
+        if (frustum.intersects(entry.bounds))
+        {
+            queue.push(entry.sortKey, entry.object);
+            statistics.emittedObjectCount++;
+        }
+    }
+
+    if (cell.level == depth_)
+        return;
+
+    for (uint32_t child = 0; child < 8; child++)
+    {
+        const CellCoordinate childCell = getChild(cell, child);
+        if (cellSubtreeCounts_[childCell.index] > 0)
+        {
+            frustumCell(childCell, frustum, queue, statistics);
+        }
+    }
+}
+
+void LooseOctree::emitSubtree(const CellCoordinate&       cell,
+                              RenderQueue&                queue,
+                              LooseOctreeQueryStatistics& statistics) const
+{
+    for (uint32_t handle = cellHeads_[cell.index]; handle != INVALID_HANDLE; handle = entries_[handle].next)
+    {
+        queue.push(entries_[handle].sortKey, entries_[handle].object);
+        statistics.emittedObjectCount++;
+    }
+
+    if (cell.level == depth_)
+        return;
+
+    for (uint32_t child = 0; child < 8; child++)
+    {
+        const CellCoordinate childCell = getChild(cell, child);
+        if (cellSubtreeCounts_[childCell.index] > 0)
+        {
+            emitSubtree(childCell, queue, statistics);
+        }
+    }
+}
+
+void LooseOctree::sphereCell(const CellCoordinate&       cell,
+                             const glm::vec3&            center,
+                             float                       radius,
+                             std::vector<uint32_t>&      objects,
+                             LooseOctreeQueryStatistics& statistics) const
+{
+    statistics.visitedCellCount++;
+
+    const float radiusSquared = radius * radius;
+    if (cell.level > 0 && distanceSquared(getLooseBounds(cell), center) > radiusSquared)
+        return;
+
+    for (uint32_t handle = cellHeads_[cell.index]; handle != INVALID_HANDLE; handle = entries_[handle].next)
+    {
+        const Entry& entry = entries_[handle];
+        statistics.testedObjectCount++;
+        if (distanceSquared(entry.bounds, center) <= radiusSquared)
+        {
+            objects.push_back(entry.object);
+            statistics.emittedObjectCount++;
+        }
+    }
+
+    if (cell.level == depth_)
+        return;
+
+    for (uint32_t child = 0; child < 8; child++)
+    {
+        const CellCoordinate childCell = getChild(cell, child);
+        if (cellSubtreeCounts_[childCell.index] > 0)
+        {
+            sphereCell(childCell, center, radius, objects, statistics);
+        }
+    }
+}
+
+LooseOctree::CellCoordinate LooseOctree::getChild(const CellCoordinate& cell, uint32_t child) const
+{
+    const uint32_t level = cell.level + 1;
+    const uint32_t local = cell.index - levelOffsets_[cell.level];
+
+    CellCoordinate childCell {};
+    childCell.level = level;
+    childCell.x     = cell.x * 2 + (child & 1);
+    childCell.y     = cell.y * 2 + ((child >> 1) & 1);
+    childCell.z     = cell.z * 2 + (child >> 2);
+    childCell.index = levelOffsets_[level] + local * 8 + child;
+    return childCell;
+}
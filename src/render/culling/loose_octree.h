@@ -0,0 +1,133 @@
+#pragma once
+
+#include "render/render_queue.h"
+
+#include "foundation/math/aabb.h"
+#include "foundation/math/frustum.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+struct LooseOctreeQueryStatistics
+{
+    uint32_t visitedCellCount {0};
+    uint32_t insideCellCount {0}; // cells whose whole subtree was emitted without testing a single object
+    uint32_t testedObjectCount {0};
+    uint32_t emittedObjectCount {0};
+};
+
+struct LooseOctreeStatistics
+{
+    uint32_t objectCount {0};
+    uint32_t rootObjectCount {0}; // too large for any child cell or centered outside the world
+    uint32_t occupiedCellCount {0};
+    uint64_t cellChangeCount {0}; // updates that had to move the object to another cell since initialize
+};
+
+// Loose octree over a fixed cube of the world for many moving objects. Cells are twice the size of their regular
+// octree cell, so an object always goes to the cell under its center on the level that fits its size, found in
+// constant time without descending the tree. Every level is a dense array in Morton order, the eight children of a
+// cell are next to each other and nothing is ever allocated or freed while objects move.
+//
+// Each cell links its objects in an intrusive list through the entry array and counts the objects of its whole
+// subtree, queries skip empty subtrees from those counts. An update that stays in the same cell only stores the new
+// bounds, moving to another cell relinks the object and touches one count per level. Objects centered outside the
+// world live in the root, which is always tested object by object.
+class LooseOctree {
+public:
+    static constexpr uint32_t INVALID_HANDLE = 0xFFFFFFFFU;
+    static constexpr uint32_t MAX_DEPTH      = 8;
+
+    // depth levels below the root, removes every object
+    void initialize(const glm::vec3& worldCenter, float worldSize, uint32_t depth = 6);
+    void clear();
+
+    // object and sort key are what queries emit for it, the handle stays valid until remove
+    uint32_t insert(const Aabb& bounds, uint32_t object, uint64_t sortKey = 0);
+    void     update(uint32_t handle, const Aabb& bounds);
+    void     remove(uint32_t handle);
+    void     setSortKey(uint32_t handle, uint64_t sortKey);
+
+    // pushes every object whose bounds touch the frustum into the queue, fully contained cells are emitted whole
+    void queryFrustum(const Frustum&              frustum,
+                      RenderQueue&                queue,
+                      LooseOctreeQueryStatistics* statistics = nullptr) const;
+
+    // appends the object of every entry whose bounds touch the sphere
+    void querySphere(const glm::vec3&            center,
+                     float                       radius,
+                     std::vector<uint32_t>&      objects,
+                     LooseOctreeQueryStatistics* statistics = nullptr) const;
+
+    [[nodiscard]] const Aabb&           getBounds(uint32_t handle) const { return entries_[handle].bounds; }
+    [[nodiscard]] uint32_t              getObject(uint32_t handle) const { return entries_[handle].object; }
+    [[nodiscard]] uint32_t              getObjectCount() const { return objectCount_; }
+    [[nodiscard]] size_t                getCellCount() const { return cellSubtreeCounts_.size(); }
+    [[nodiscard]] LooseOctreeStatistics getStatistics() const;
+
+private:
+    // everything a query reads about an object sits in one cache line. A cell list starts with the entry linked into
+    // it last, its order follows inserts and moves rather than handles
+    struct Entry
+    {
+        Aabb     bounds;
+        uint64_t sortKey;
+        uint32_t object;
+        uint32_t cell; // INVALID_HANDLE while the handle is free
+        uint32_t next; // next in the cell list, or in the free list
+        uint32_t previous;
+    };
+
+    // position of a cell during traversal, the index is into the per cell arrays
+    struct CellCoordinate
+    {
+        uint32_t level;
+        uint32_t x;
+        uint32_t y;
+        uint32_t z;
+        uint32_t index;
+    };
+
+    [[nodiscard]] uint32_t findCell(const Aabb& bounds, uint32_t& level) const;
+    [[nodiscard]] Aabb     getLooseBounds(const CellCoordinate& cell) const;
+
+    [[nodiscard]] uint32_t getLevel(uint32_t cell) const;
+
+    void link(uint32_t handle, uint32_t cell, uint32_t level);
+    void unlink(uint32_t handle);
+
+    void frustumCell(const CellCoordinate&       cell,
+                     const Frustum&              frustum,
+                     RenderQueue&                queue,
+                     LooseOctreeQueryStatistics& statistics) const;
+    void emitSubtree(const CellCoordinate& cell, RenderQueue& queue, LooseOctreeQueryStatistics& statistics) const;
+    void sphereCell(const CellCoordinate&       cell,
+                    const glm::vec3&            center,
+                    float                       radius,
+                    std::vector<uint32_t>&      objects,
+                    LooseOctreeQueryStatistics& statistics) const;
+
+    [[nodiscard]] CellCoordinate getChild(const CellCoordinate& cell, uint32_t child) const;
+
+    glm::vec3 worldMin_ {0.0F};
+    float     worldSize_ {0.0F};
+    uint32_t  depth_ {0};
+
+    // per level, level zero is the root
+    std::vector<uint32_t> levelOffsets_;
+    std::vector<float>    cellSizes_;
+    std::vector<float>    inverseCellSizes_;
+
+    // per cell
+    std::vector<uint32_t> cellHeads_;
+    std::vector<uint32_t> cellSubtreeCounts_;
+
+    // indexed by handle
+    std::vector<Entry> entries_;
+
+    uint32_t freeHead_ {INVALID_HANDLE};
+    uint32_t objectCount_ {0};
+    uint64_t cellChangeCount_ {0};
+};
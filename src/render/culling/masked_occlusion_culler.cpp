@@ -0,0 +1,471 @@
+#include "render/culling/masked_occlusion_culler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define OCCLUSION_CULLER_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OCCLUSION_CULLER_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define OCCLUSION_CULLER_NEON 1
+#endif
+
+namespace
+{
+constexpr uint32_t FULL_COVERAGE = 0xFFFFFFFFU;
+
+// anything closer to the eye than this gets dropped as an occluder and counts as visible as an occludee
+constexpr float NEAR_CLIP_W = 1e-4F;
+
+// bit n is set when pixel n of an 8 pixel row lies inside all three edges, given the edge values at the first pixel
+// center and their step from one pixel to the next
+uint32_t computeRowMask(const float* edgeValue, const float* edgeStep)
+{
+#if defined(OCCLUSION_CULLER_AVX2)
+    const __m256 lane   = _mm256_setr_ps(0.0F, 1.0F, 2.0F, 3.0F, 4.0F, 5.0F, 6.0F, 7.0F);
+    const __m256 zero   = _mm256_setzero_ps();
+    __m256       inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (uint32_t edge = 0; edge < 3; edge++)
+    {
+        const __m256 value =
+            _mm256_add_ps(_mm256_set1_ps(edgeValue[edge]), _mm256_mul_ps(_mm256_set1_ps(edgeStep[edge]), lane));
+        inside = _mm256_and_ps(inside, _mm256_cmp_ps(value, zero, _CMP_GE_OQ));
+    }
+    return static_cast<uint32_t>(_mm256_movemask_ps(inside));
+#elif defined(OCCLUSION_CULLER_SSE2)
+    const __m128 laneLow  = _mm_setr_ps(0.0F, 1.0F, 2.0F, 3.0F);
+    const __m128 laneHigh = _mm_setr_ps(4.0F, 5.0F, 6.0F, 7.0F);
+    const __m128 zero     = _mm_setzero_ps();
+    __m128       low      = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    __m128       high     = low;
+    for (uint32_t edge = 0; edge < 3; edge++)
+    {
+        const __m128 value = _mm_set1_ps(edgeValue[edge]);
+        const __m128 step  = _mm_set1_ps(edgeStep[edge]);
+        low                = _mm_and_ps(low, _mm_cmpge_ps(_mm_add_ps(value, _mm_mul_ps(step, laneLow)), zero));
+        high               = _mm_and_ps(high, _mm_cmpge_ps(_mm_add_ps(value, _mm_mul_ps(step, laneHigh)), zero));
+    }
+    return static_cast<uint32_t>(_mm_movemask_ps(low)) | (static_cast<uint32_t>(_mm_movemask_ps(high)) << 4);
+#elif defined(OCCLUSION_CULLER_NEON)
+    const float32x4_t laneLow  = {0.0F, 1.0F, 2.0F, 3.0F};
+    const float32x4_t laneHigh = {4.0F, 5.0F, 6.0F, 7.0F};
+    const float32x4_t zero     = vdupq_n_f32(0.0F);
+    uint32x4_t        low      = vdupq_n_u32(FULL_COVERAGE);
+    uint32x4_t        high     = low;
+    for (uint32_t edge = 0; edge < 3; edge++)
+    {
+        const float32x4_t value = vdupq_n_f32(edgeValue[edge]);
+        const float32x4_t step  = vdupq_n_f32(edgeStep[edge]);
+        low                     = vandq_u32(low, vcgeq_f32(vmlaq_f32(value, step, laneLow), zero));
+        high                    = vandq_u32(high, vcgeq_f32(vmlaq_f32(value, step, laneHigh), zero));
+    }
+    const uint32x4_t bits = {1U, 2U, 4U, 8U};
+    return vaddvq_u32(vandq_u32(low, bits)) | (vaddvq_u32(vandq_u32(high, bits)) << 4);
+#else
+    uint32_t mask = 0;
+    for (uint32_t pixel = 0; pixel < MaskedOcclusionCuller::SUBTILE_WIDTH; pixel++)
+    {
+        bool inside = true;
+        for (uint32_t edge = 0; edge < 3; edge++)
+        {
+            inside &= edgeValue[edge] + edgeStep[edge] * static_cast<float>(pixel) >= 0.0F;
+        }
+        mask |= inside ? 1U << pixel : 0U;
+    }
+    return mask;
+#endif
+}
+} // namespace
+
+void MaskedOcclusionCuller::resize(uint32_t width, uint32_t height)
+{
+    tileCountX_    = std::max(1U, (width + TILE_WIDTH - 1) / TILE_WIDTH);
+    tileCountY_    = std::max(1U, (height + TILE_HEIGHT - 1) / TILE_HEIGHT);
+    width_         = tileCountX_ * TILE_WIDTH;
+    height_        = tileCountY_ * TILE_HEIGHT;
+    subtileCountX_ = width_ / SUBTILE_WIDTH;
+
+    subtiles_.resize(static_cast<size_t>(subtileCountX_) * (height_ / SUBTILE_HEIGHT));
+    tileZMax_.resize(static_cast<size_t>(tileCountX_) * tileCountY_);
+    clear();
+}
+
+void MaskedOcclusionCuller::clear()
+{
+    std::fill(subtiles_.begin(), subtiles_.end(), Subtile {});
+    std::fill(tileZMax_.begin(), tileZMax_.end(), 1.0F);
+    statistics_ = {};
+}
+
+void MaskedOcclusionCuller::renderOccluders(const std::vector<OccluderMesh>& occluders,
+                                            const glm::mat4&                 viewProjection,
+                                            JobSystem*                       jobSystem)
+{
+    viewProjection_ = viewProjection;
+
+    triangles_.clear();
+    for (const auto& occluder : occluders)
+    {
+        setupTriangles(occluder, triangles_);
+        statistics_.occluderTriangleCount += occluder.indexCount / 3;
+    }
+    statistics_.rasterizedTriangleCount += static_cast<uint32_t>(triangles_.size());
+
+    if (triangles_.empty())
+        return;
+
+    bandUpdateCounts_.assign(tileCountY_, 0);
+
+    const auto rasterizeBands = [this](uint32_t begin, uint32_t end) {
+        for (uint32_t tileRow = begin; tileRow < end; tileRow++)
+        {
+            rasterizeBand(tileRow);
+        }
+    };
+
+    if (jobSystem != nullptr)
+    {
+        jobSystem->parallelFor(tileCountY_, 1, rasterizeBands);
+    }
+    else
+    {
+        rasterizeBands(0, tileCountY_);
+    }
+
+    for (const uint32_t updateCount : bandUpdateCounts_)
+    {
+        statistics_.subtileUpdateCount += updateCount;
+    }
+}
+
+CullingResult MaskedOcclusionCuller::testAabb(const Aabb& bounds) const
+{
+    glm::vec2 screenMin {std::numeric_limits<float>::max()};
+    glm::vec2 screenMax {std::numeric_limits<float>::lowest()};
+    float     zNear = std::numeric_limits<float>::max();
+
+    // corners outside of the same frustum plane, bit per plane
+    uint32_t outsideAll = 0x1F;
+    bool     behindEye  = false;
+
+    for (uint32_t corner = 0; corner < 8; corner++)
+    {
+        const glm::vec4 clip = viewProjection_ * glm::vec4(bounds.getCorner(corner), 1.0F);
+
+        uint32_t outside = 0;
+        outside |= clip.x < -clip.w ? 0x01U : 0U;
+        outside |= clip.x > clip.w ? 0x02U : 0U;
+        outside |= clip.y < -clip.w ? 0x04U : 0U;
+        outside |= clip.y > clip.w ? 0x08U : 0U;
+        outside |= clip.z > clip.w ? 0x10U : 0U;
+        outsideAll &= outside;
+
+        if (clip.w <= NEAR_CLIP_W)
+        {
+            behindEye = true;
+            continue;
+        }
+
+        const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        const glm::vec2 screen {(ndc.x * 0.5F + 0.5F) * static_cast<float>(width_),
+                                (ndc.y * 0.5F + 0.5F) * static_cast<float>(height_)};
+
+        screenMin = glm::min(screenMin, screen);
+        screenMax = glm::max(screenMax, screen);
+        zNear     = std::min(zNear, ndc.z);
+    }
+
+    if (outsideAll != 0)
+        return CullingResult::VIEW_CULLED;
+
+    // the box reaches behind the eye, its projection is unbounded
+    if (behindEye)
+        return CullingResult::VISIBLE;
+
+    // every pixel center the box could touch
+    const int32_t minX = std::max(0, static_cast<int32_t>(std::floor(screenMin.x)));
+    const int32_t minY = std::max(0, static_cast<int32_t>(std::floor(screenMin.y)));
+    const int32_t maxX = std::min(static_cast<int32_t>(width_) - 1, static_cast<int32_t>(std::ceil(screenMax.x)));
+    const int32_t maxY = std::min(static_cast<int32_t>(height_) - 1, static_cast<int32_t>(std::ceil(screenMax.y)));
+    if (minX > maxX || minY > maxY)
+        return CullingResult::VIEW_CULLED;
+
+    const uint32_t subtileMinX = static_cast<uint32_t>(minX) / SUBTILE_WIDTH;
+    const uint32_t subtileMaxX = static_cast<uint32_t>(maxX) / SUBTILE_WIDTH;
+    const uint32_t subtileMinY = static_cast<uint32_t>(minY) / SUBTILE_HEIGHT;
+    const uint32_t subtileMaxY = static_cast<uint32_t>(maxY) / SUBTILE_HEIGHT;
+
+    for (uint32_t tileY = subtileMinY / SUBTILES_PER_COL; tileY <= subtileMaxY / SUBTILES_PER_COL; tileY++)
+    {
+        for (uint32_t tileX = subtileMinX / SUBTILES_PER_ROW; tileX <= subtileMaxX / SUBTILES_PER_ROW; tileX++)
+        {
+            // the whole tile is covered by something closer
+            if (tileZMax_[tileY * tileCountX_ + tileX] <= zNear)
+                continue;
+
+            const uint32_t firstY = std::max(subtileMinY, tileY * SUBTILES_PER_COL);
+            const uint32_t lastY  = std::min(subtileMaxY, tileY * SUBTILES_PER_COL + SUBTILES_PER_COL - 1);
+            const uint32_t firstX = std::max(subtileMinX, tileX * SUBTILES_PER_ROW);
+            const uint32_t lastX  = std::min(subtileMaxX, tileX * SUBTILES_PER_ROW + SUBTILES_PER_ROW - 1);
+
+            for (uint32_t subtileY = firstY; subtileY <= lastY; subtileY++)
+            {
+                for (uint32_t subtileX = firstX; subtileX <= lastX; subtileX++)
+                {
+                    if (subtiles_[subtileY * subtileCountX_ + subtileX].zMax0 > zNear)
+                        return CullingResult::VISIBLE;
+                }
+            }
+        }
+    }
+
+    return CullingResult::OCCLUDED;
+}
+
+uint32_t MaskedOcclusionCuller::getWidth() const
+{
+    return width_;
+}
+
+uint32_t MaskedOcclusionCuller::getHeight() const
+{
+    return height_;
+}
+
+OcclusionCullingStatistics MaskedOcclusionCuller::getStatistics() const
+{
+    return statistics_;
+}
+
+float MaskedOcclusionCuller::getDepth(uint32_t x, uint32_t y) const
+{
+    const Subtile& subtile = subtiles_[(y / SUBTILE_HEIGHT) * subtileCountX_ + x / SUBTILE_WIDTH];
+    const uint32_t bit     = 1U << ((y % SUBTILE_HEIGHT) * SUBTILE_WIDTH + x % SUBTILE_WIDTH);
+    return (subtile.mask & bit) != 0 ? subtile.zMax1 : subtile.zMax0;
+}
+
+void MaskedOcclusionCuller::setupTriangles(const OccluderMesh& occluder, std::vector<ScreenTriangle>& triangles) const
+{
+    const glm::mat4 transform = viewProjection_ * occluder.model;
+
+    std::vector<glm::vec4> clipPositions(occluder.vertexCount);
+    for (uint32_t vertex = 0; vertex < occluder.vertexCount; vertex++)
+    {
+        clipPositions[vertex] = transform * glm::vec4(occluder.vertices[vertex], 1.0F);
+    }
+
+    const float width  = static_cast<float>(width_);
+    const float height = static_cast<float>(height_);
+
+    for (uint32_t index = 0; index + 2 < occluder.indexCount; index += 3)
+    {
+        glm::vec3 screen[3];
+        bool      clipped = false;
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            const glm::vec4& clip = clipPositions[occluder.indices[index + corner]];
+
+            // dropping an occluder only ever hides less, so near plane clipping is not worth it
+            if (clip.w <= NEAR_CLIP_W)
+            {
+                clipped = true;
+                break;
+            }
+
+            const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+            screen[corner] = {(ndc.x * 0.5F + 0.5F) * width, (ndc.y * 0.5F + 0.5F) * height, ndc.z};
+        }
+        if (clipped)
+            continue;
+
+        float area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) -
+                     (screen[2].x - screen[0].x) * (screen[1].y - screen[0].y);
+        if (std::abs(area) < 1e-6F)
+            continue;
+
+        // occluders are solid, both windings hide what is behind them
+        if (area < 0.0F)
+        {
+            std::swap(screen[1], screen[2]);
+            area = -area;
+        }
+
+        const float zMin = std::min({screen[0].z, screen[1].z, screen[2].z});
+        if (zMin >= 1.0F)
+            continue;
+
+        const glm::vec2 corner0 {screen[0]};
+        const glm::vec2 corner1 {screen[1]};
+        const glm::vec2 corner2 {screen[2]};
+        const glm::vec2 boundsMin = glm::min(glm::min(corner0, corner1), corner2);
+        const glm::vec2 boundsMax = glm::max(glm::max(corner0, corner1), corner2);
+        const int32_t   lastX     = static_cast<int32_t>(width_) - 1;
+        const int32_t   lastY     = static_cast<int32_t>(height_) - 1;
+
+        // pixels whose center may lie inside
+        ScreenTriangle triangle {};
+        triangle.minX = std::max(0, static_cast<int32_t>(std::ceil(boundsMin.x - 0.5F)));
+        triangle.minY = std::max(0, static_cast<int32_t>(std::ceil(boundsMin.y - 0.5F)));
+        triangle.maxX = std::min(lastX, static_cast<int32_t>(std::floor(boundsMax.x - 0.5F)));
+        triangle.maxY = std::min(lastY, static_cast<int32_t>(std::floor(boundsMax.y - 0.5F)));
+        if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+            continue;
+
+        // positive inside for counter clockwise triangles
+        for (uint32_t edge = 0; edge < 3; edge++)
+        {
+            const glm::vec3& from = screen[edge];
+            const glm::vec3& to   = screen[(edge + 1) % 3];
+            triangle.edgeA[edge]  = from.y - to.y;
+            triangle.edgeB[edge]  = to.x - from.x;
+            triangle.edgeC[edge]  = from.x * to.y - from.y * to.x;
+        }
+
+        // z / w is affine in screen space
+        const glm::vec3 delta1 = screen[1] - screen[0];
+        const glm::vec3 delta2 = screen[2] - screen[0];
+        triangle.zA            = (delta1.z * delta2.y - delta2.z * delta1.y) / area;
+        triangle.zB            = (delta1.x * delta2.z - delta2.x * delta1.z) / area;
+        triangle.zC            = screen[0].z - triangle.zA * screen[0].x - triangle.zB * screen[0].y;
+        triangle.zMax          = std::min(1.0F, std::max({screen[0].z, screen[1].z, screen[2].z}));
+
+        triangles.push_back(triangle);
+    }
+}
+
+void MaskedOcclusionCuller::rasterizeBand(uint32_t tileRow)
+{
+    const int32_t bandMinY = static_cast<int32_t>(tileRow * TILE_HEIGHT);
+    const int32_t bandMaxY = bandMinY + static_cast<int32_t>(TILE_HEIGHT) - 1;
+
+    for (const auto& triangle : triangles_)
+    {
+        if (triangle.maxY < bandMinY || triangle.minY > bandMaxY)
+            continue;
+
+        rasterizeTriangle(triangle, tileRow);
+    }
+
+    // refresh the coarse bounds of the band
+    for (uint32_t tileX = 0; tileX < tileCountX_; tileX++)
+    {
+        float tileZMax = 0.0F;
+        for (uint32_t subtileY = tileRow * SUBTILES_PER_COL; subtileY < (tileRow + 1) * SUBTILES_PER_COL; subtileY++)
+        {
+            for (uint32_t subtileX = tileX * SUBTILES_PER_ROW; subtileX < (tileX + 1) * SUBTILES_PER_ROW; subtileX++)
+            {
+                tileZMax = std::max(tileZMax, subtiles_[subtileY * subtileCountX_ + subtileX].zMax0);
+            }
+        }
+        tileZMax_[tileRow * tileCountX_ + tileX] = tileZMax;
+    }
+}
+
+void MaskedOcclusionCuller::rasterizeTriangle(const ScreenTriangle& triangle, uint32_t tileRow)
+{
+    const uint32_t bandFirstY = tileRow * SUBTILES_PER_COL;
+    const uint32_t bandLastY  = bandFirstY + SUBTILES_PER_COL - 1;
+    const uint32_t firstY     = std::max(bandFirstY, static_cast<uint32_t>(triangle.minY) / SUBTILE_HEIGHT);
+    const uint32_t lastY      = std::min(bandLastY, static_cast<uint32_t>(triangle.maxY) / SUBTILE_HEIGHT);
+    const uint32_t firstX     = static_cast<uint32_t>(triangle.minX) / SUBTILE_WIDTH;
+    const uint32_t lastX      = static_cast<uint32_t>(triangle.maxX) / SUBTILE_WIDTH;
+
+    uint32_t& updateCount = bandUpdateCounts_[tileRow];
+
+    for (uint32_t subtileY = firstY; subtileY <= lastY; subtileY++)
+    {
+        const float top    = static_cast<float>(subtileY * SUBTILE_HEIGHT) + 0.5F;
+        const float bottom = top + static_cast<float>(SUBTILE_HEIGHT - 1);
+
+        for (uint32_t subtileX = firstX; subtileX <= lastX; subtileX++)
+        {
+            const float left  = static_cast<float>(subtileX * SUBTILE_WIDTH) + 0.5F;
+            const float right = left + static_cast<float>(SUBTILE_WIDTH - 1);
+
+            // edge values at the pixel centers that are the most and the least inside, rejects and accepts whole
+            // subtiles before any mask gets computed
+            bool  rejected   = false;
+            bool  accepted   = true;
+            float edgeValue[3];
+            for (uint32_t edge = 0; edge < 3; edge++)
+            {
+                const float a = triangle.edgeA[edge];
+                const float b = triangle.edgeB[edge];
+                const float c = triangle.edgeC[edge];
+
+                const float best  = a * (a > 0.0F ? right : left) + b * (b > 0.0F ? bottom : top) + c;
+                const float worst = a * (a > 0.0F ? left : right) + b * (b > 0.0F ? top : bottom) + c;
+                rejected |= best < 0.0F;
+                accepted &= worst >= 0.0F;
+
+                edgeValue[edge] = a * left + b * top + c;
+            }
+            if (rejected)
+                continue;
+
+            uint32_t coverage = FULL_COVERAGE;
+            if (!accepted)
+            {
+                coverage = 0;
+                for (uint32_t row = 0; row < SUBTILE_HEIGHT; row++)
+                {
+                    coverage |= computeRowMask(edgeValue, triangle.edgeA) << (row * SUBTILE_WIDTH);
+                    for (uint32_t edge = 0; edge < 3; edge++)
+                    {
+                        edgeValue[edge] += triangle.edgeB[edge];
+                    }
+                }
+                if (coverage == 0)
+                    continue;
+            }
+
+            // farthest depth of the triangle plane over the subtile, never beyond its farthest vertex
+            const float zSubtile = triangle.zA * (triangle.zA > 0.0F ? right : left) +
+                                   triangle.zB * (triangle.zB > 0.0F ? bottom : top) + triangle.zC;
+
+            updateSubtile(subtiles_[subtileY * subtileCountX_ + subtileX], coverage, std::min(zSubtile, triangle.zMax));
+            updateCount++;
+        }
+    }
+}
+
+void MaskedOcclusionCuller::updateSubtile(Subtile& subtile, uint32_t coverage, float zTriangle)
+{
+    // behind what the subtile already guarantees, nothing to gain
+    if (zTriangle >= subtile.zMax0)
+        return;
+
+    if (coverage == FULL_COVERAGE)
+    {
+        subtile.zMax0 = zTriangle;
+        if (subtile.zMax1 >= zTriangle)
+        {
+            subtile.mask = 0;
+        }
+        return;
+    }
+
+    // merging pulls the working layer back to the triangle, once that gets it closer to the reference layer than to
+    // where it was, a fresh layer made of the triangle alone keeps more of the occlusion
+    if (subtile.mask == 0 || zTriangle - subtile.zMax1 > subtile.zMax0 - zTriangle)
+    {
+        subtile.zMax1 = zTriangle;
+        subtile.mask  = coverage;
+    }
+    else
+    {
+        subtile.zMax1 = std::max(subtile.zMax1, zTriangle);
+        subtile.mask |= coverage;
+    }
+
+    if (subtile.mask == FULL_COVERAGE)
+    {
+        subtile.zMax0 = subtile.zMax1;
+        subtile.mask  = 0;
+    }
+}
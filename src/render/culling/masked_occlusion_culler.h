@@ -0,0 +1,114 @@
+#pragma once
+
+#include "foundation/job/job_system.h"
+#include "foundation/math/aabb.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Triangle mesh that hides what is behind it, vertices and indices are not owned and have to outlive the call.
+struct OccluderMesh
+{
+    const glm::vec3* vertices {nullptr};
+    uint32_t         vertexCount {0};
+    const uint32_t*  indices {nullptr};
+    uint32_t         indexCount {0};
+    glm::mat4        model {1.0F};
+};
+
+enum class CullingResult : uint8_t
+{
+    VISIBLE,
+    OCCLUDED,
+    VIEW_CULLED,
+};
+
+struct OcclusionCullingStatistics
+{
+    uint32_t occluderTriangleCount {0};
+    uint32_t rasterizedTriangleCount {0};
+    uint32_t subtileUpdateCount {0};
+};
+
+// Software occlusion culling after Hasselgren et al., "Masked Software Occlusion Culling". The depth buffer is split
+// into 8x4 pixel subtiles that store a 32 bit coverage mask and two far depth bounds instead of per pixel depth:
+// zMax0 holds for the whole subtile, zMax1 for the pixels in the mask. Once the mask is full the working layer
+// replaces the reference layer. Coverage masks for a subtile row come out of one SIMD comparison (AVX2, SSE or NEON).
+//
+// Occluders are rasterized in bands of 32x16 pixel tiles, every band belongs to a single job so no two threads ever
+// touch the same subtile. A coarse per tile bound makes testing large boxes cheap. Depth is clip z / w, everything
+// at or beyond 1 counts as far plane, so both zero-to-one and minus-one-to-one projections work.
+class MaskedOcclusionCuller {
+public:
+    static constexpr uint32_t SUBTILE_WIDTH    = 8;
+    static constexpr uint32_t SUBTILE_HEIGHT   = 4;
+    static constexpr uint32_t TILE_WIDTH       = 32;
+    static constexpr uint32_t TILE_HEIGHT      = 16;
+    static constexpr uint32_t SUBTILES_PER_ROW = TILE_WIDTH / SUBTILE_WIDTH;
+    static constexpr uint32_t SUBTILES_PER_COL = TILE_HEIGHT / SUBTILE_HEIGHT;
+
+    // rounded up to whole tiles
+    void resize(uint32_t width, uint32_t height);
+    void clear();
+
+    // rasterizes the occluders on top of what the buffer already holds, a null job system runs everything inline
+    void renderOccluders(const std::vector<OccluderMesh>& occluders,
+                         const glm::mat4&                 viewProjection,
+                         JobSystem*                       jobSystem = nullptr);
+
+    // conservative, only reports OCCLUDED when every pixel of the projected box lies behind an occluder. Uses the view
+    // projection of the last renderOccluders call and is safe to call from several threads at once
+    [[nodiscard]] CullingResult testAabb(const Aabb& bounds) const;
+
+    [[nodiscard]] uint32_t                   getWidth() const;
+    [[nodiscard]] uint32_t                   getHeight() const;
+    [[nodiscard]] OcclusionCullingStatistics getStatistics() const;
+
+    // far bound of the pixel, for debug views
+    [[nodiscard]] float getDepth(uint32_t x, uint32_t y) const;
+
+private:
+    struct Subtile
+    {
+        float    zMax0 {1.0F};
+        float    zMax1 {0.0F};
+        uint32_t mask {0};
+    };
+
+    // screen space triangle with edge and depth plane equations over pixel coordinates
+    struct ScreenTriangle
+    {
+        float   edgeA[3];
+        float   edgeB[3];
+        float   edgeC[3];
+        float   zA;
+        float   zB;
+        float   zC;
+        float   zMax;
+        int32_t minX;
+        int32_t minY;
+        int32_t maxX;
+        int32_t maxY;
+    };
+
+    void setupTriangles(const OccluderMesh& occluder, std::vector<ScreenTriangle>& triangles) const;
+    void rasterizeBand(uint32_t tileRow);
+    void rasterizeTriangle(const ScreenTriangle& triangle, uint32_t tileRow);
+    void updateSubtile(Subtile& subtile, uint32_t coverage, float zTriangle);
+
+    uint32_t width_ {0};
+    uint32_t height_ {0};
+    uint32_t tileCountX_ {0};
+    uint32_t tileCountY_ {0};
+    uint32_t subtileCountX_ {0};
+
+    std::vector<Subtile> subtiles_;
+    std::vector<float>   tileZMax_;
+
+    glm::mat4                   viewProjection_ {1.0F};
+    std::vector<ScreenTriangle> triangles_;
+    std::vector<uint32_t>       bandUpdateCounts_;
+    OcclusionCullingStatistics  statistics_ {};
+};
@@ -0,0 +1,454 @@
+#include "render/culling/occlusion_culling_benchmark.h"
+#include "render/backend/null/null_rhi_backend.h"
+#include "render/culling/masked_occlusion_culler.h"
+
+#include "foundation/job/job_system.h"
+#include "foundation/log/log_system.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr float ROOM_SIZE      = 10.0F;
+constexpr float WALL_HEIGHT    = 3.0F;
+constexpr float WALL_THICKNESS = 0.2F;
+constexpr float DOOR_WIDTH     = 1.6F;
+constexpr float DOOR_HEIGHT    = 2.2F;
+constexpr float EYE_HEIGHT     = 1.7F;
+
+// same cut off as the culler, occluder triangles closer than this are dropped and boxes reaching it are visible
+constexpr double NEAR_CLIP_W = 1e-4;
+
+// the reference covers pixels on a triangle edge and takes depths within this of the box as hidden, so rounding
+// differences to the culler never count as a wrong result
+constexpr double EDGE_TOLERANCE  = 1e-3;
+constexpr double DEPTH_TOLERANCE = 1e-5;
+
+void addBox(const Aabb& box, std::vector<glm::vec3>& vertices, std::vector<uint32_t>& indices)
+{
+    static constexpr uint32_t BOX_INDICES[36] = {0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6, 0, 1, 4, 1, 5, 4,
+                                                 2, 6, 3, 3, 6, 7, 0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5};
+
+    const uint32_t firstVertex = static_cast<uint32_t>(vertices.size());
+    for (uint32_t corner = 0; corner < 8; corner++)
+    {
+        vertices.push_back(box.getCorner(corner));
+    }
+    for (const uint32_t index : BOX_INDICES)
+    {
+        indices.push_back(firstVertex + index);
+    }
+}
+
+// wall between from and to along one axis, split around a doorway in its middle unless it is an outer wall
+void addWall(glm::vec2 from, glm::vec2 to, bool withDoor, std::vector<glm::vec3>& vertices,
+             std::vector<uint32_t>& indices)
+{
+    const glm::vec2 thickness = from.x == to.x ? glm::vec2(WALL_THICKNESS * 0.5F, 0.0F) :
+                                                 glm::vec2(0.0F, WALL_THICKNESS * 0.5F);
+
+    const auto addSegment = [&](glm::vec2 begin, glm::vec2 end, float bottom, float top) {
+        Aabb segment {};
+        segment.expand(glm::vec3(glm::min(begin, end) - thickness, bottom));
+        segment.expand(glm::vec3(glm::max(begin, end) + thickness, top));
+        addBox(segment, vertices, indices);
+    };
+
+    if (!withDoor)
+    {
+        addSegment(from, to, 0.0F, WALL_HEIGHT);
+        return;
+    }
+
+    const glm::vec2 direction = glm::normalize(to - from);
+    const glm::vec2 middle    = (from + to) * 0.5F;
+    const glm::vec2 doorBegin = middle - direction * (DOOR_WIDTH * 0.5F);
+    const glm::vec2 doorEnd   = middle + direction * (DOOR_WIDTH * 0.5F);
+
+    addSegment(from, doorBegin, 0.0F, WALL_HEIGHT);
+    addSegment(doorEnd, to, 0.0F, WALL_HEIGHT);
+    addSegment(doorBegin, doorEnd, DOOR_HEIGHT, WALL_HEIGHT);
+}
+
+// Per pixel depth of the occluders, rasterized one pixel center at a time in double precision. Slow but exact, it
+// checks the promise of the culler that a box reported occluded is hidden at every pixel it could touch
+class ReferenceDepthBuffer {
+public:
+    void render(const OccluderMesh& occluder, const glm::mat4& viewProjection, uint32_t width, uint32_t height)
+    {
+        width_          = width;
+        height_         = height;
+        viewProjection_ = viewProjection;
+        depth_.assign(static_cast<size_t>(width_) * height_, 1.0);
+
+        const glm::dmat4 transform = glm::dmat4(viewProjection * occluder.model);
+        for (uint32_t index = 0; index + 2 < occluder.indexCount; index += 3)
+        {
+            glm::dvec3 screen[3];
+            bool       clipped = false;
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                const glm::vec3& vertex = occluder.vertices[occluder.indices[index + corner]];
+                const glm::dvec4 clip   = transform * glm::dvec4(vertex, 1.0);
+                if (clip.w <= NEAR_CLIP_W)
+                {
+                    clipped = true;
+                    break;
+                }
+                screen[corner] = toScreen(clip);
+            }
+            if (!clipped)
+            {
+                rasterizeTriangle(screen);
+            }
+        }
+    }
+
+    [[nodiscard]] bool isOccluded(const Aabb& bounds) const
+    {
+        glm::dvec2 screenMin {std::numeric_limits<double>::max()};
+        glm::dvec2 screenMax {std::numeric_limits<double>::lowest()};
+        double     zNear = std::numeric_limits<double>::max();
+        for (uint32_t corner = 0; corner < 8; corner++)
+        {
+            const glm::dvec4 clip = glm::dmat4(viewProjection_) * glm::dvec4(bounds.getCorner(corner), 1.0);
+            if (clip.w <= NEAR_CLIP_W)
+                return false;
+
+            const glm::dvec3 screen = toScreen(clip);
+            screenMin               = glm::min(screenMin, glm::dvec2(screen));
+            screenMax               = glm::max(screenMax, glm::dvec2(screen));
+            zNear                   = std::min(zNear, screen.z);
+        }
+
+        const int32_t minX = std::max(0, static_cast<int32_t>(std::floor(screenMin.x)));
+        const int32_t minY = std::max(0, static_cast<int32_t>(std::floor(screenMin.y)));
+        const int32_t maxX = std::min(static_cast<int32_t>(width_) - 1, static_cast<int32_t>(std::ceil(screenMax.x)));
+        const int32_t maxY = std::min(static_cast<int32_t>(height_) - 1, static_cast<int32_t>(std::ceil(screenMax.y)));
+        for (int32_t y = minY; y <= maxY; y++)
+        {
+            for (int32_t x = minX; x <= maxX; x++)
+            {
+                if (depth_[static_cast<size_t>(y) * width_ + x] > zNear + DEPTH_TOLERANCE)
+                    return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    [[nodiscard]] glm::dvec3 toScreen(const glm::dvec4& clip) const
+    {
+        const glm::dvec3 ndc = glm::dvec3(clip) / clip.w;
+        return {(ndc.x * 0.5 + 0.5) * width_, (ndc.y * 0.5 + 0.5) * height_, ndc.z};
+    }
+
+    void rasterizeTriangle(glm::dvec3 screen[3])
+    {
+        double area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) -
+                      (screen[2].x - screen[0].x) * (screen[1].y - screen[0].y);
+        if (area == 0.0)
+            return;
+        if (area < 0.0)
+        {
+            std::swap(screen[1], screen[2]);
+            area = -area;
+        }
+
+        double edgeA[3];
+        double edgeB[3];
+        double edgeC[3];
+        for (uint32_t edge = 0; edge < 3; edge++)
+        {
+            const glm::dvec3& from = screen[edge];
+            const glm::dvec3& to   = screen[(edge + 1) % 3];
+            edgeA[edge]            = from.y - to.y;
+            edgeB[edge]            = to.x - from.x;
+            edgeC[edge]            = from.x * to.y - from.y * to.x;
+            edgeC[edge] += EDGE_TOLERANCE * std::hypot(edgeA[edge], edgeB[edge]);
+        }
+
+        const glm::dvec3 delta1 = screen[1] - screen[0];
+        const glm::dvec3 delta2 = screen[2] - screen[0];
+        const double     zA     = (delta1.z * delta2.y - delta2.z * delta1.y) / area;
+        const double     zB     = (delta1.x * delta2.z - delta2.x * delta1.z) / area;
+        const double     zC     = screen[0].z - zA * screen[0].x - zB * screen[0].y;
+
+        const double minX = std::min({screen[0].x, screen[1].x, screen[2].x});
+        const double minY = std::min({screen[0].y, screen[1].y, screen[2].y});
+        const double maxX = std::max({screen[0].x, screen[1].x, screen[2].x});
+        const double maxY = std::max({screen[0].y, screen[1].y, screen[2].y});
+
+        const int32_t firstX = std::max(0, static_cast<int32_t>(std::floor(minX - 0.5)));
+        const int32_t firstY = std::max(0, static_cast<int32_t>(std::floor(minY - 0.5)));
+        const int32_t lastX  = std::min(static_cast<int32_t>(width_) - 1, static_cast<int32_t>(std::ceil(maxX - 0.5)));
+        const int32_t lastY  = std::min(static_cast<int32_t>(height_) - 1, static_cast<int32_t>(std::ceil(maxY - 0.5)));
+
+        for (int32_t y = firstY; y <= lastY; y++)
+        {
+            const double centerY = y + 0.5;
+            for (int32_t x = firstX; x <= lastX; x++)
+            {
+                const double centerX = x + 0.5;
+                bool         inside  = true;
+                for (uint32_t edge = 0; edge < 3; edge++)
+                {
+                    inside &= edgeA[edge] * centerX + edgeB[edge] * centerY + edgeC[edge] >= 0.0;
+                }
+                if (!inside)
+                    continue;
+
+                double& depth = depth_[static_cast<size_t>(y) * width_ + x];
+                depth         = std::min(depth, zA * centerX + zB * centerY + zC);
+            }
+        }
+    }
+
+    uint32_t            width_ {0};
+    uint32_t            height_ {0};
+    glm::mat4           viewProjection_ {1.0F};
+    std::vector<double> depth_;
+};
+} // namespace
+
+int OcclusionCullingBenchmark::run(const OcclusionCullingBenchmarkSettings& settings)
+{
+    const uint32_t roomsPerSide = std::max(1U, settings.roomsPerSide);
+    const float    worldSize    = ROOM_SIZE * static_cast<float>(roomsPerSide);
+
+    std::vector<glm::vec3> wallVertices;
+    std::vector<uint32_t>  wallIndices;
+    for (uint32_t line = 0; line <= roomsPerSide; line++)
+    {
+        const float position = ROOM_SIZE * static_cast<float>(line);
+        const bool  outer    = line == 0 || line == roomsPerSide;
+        for (uint32_t room = 0; room < roomsPerSide; room++)
+        {
+            const float begin = ROOM_SIZE * static_cast<float>(room);
+            const float end   = begin + ROOM_SIZE;
+            addWall({position, begin}, {position, end}, !outer, wallVertices, wallIndices);
+            addWall({begin, position}, {end, position}, !outer, wallVertices, wallIndices);
+        }
+    }
+
+    OccluderMesh walls {};
+    walls.vertices    = wallVertices.data();
+    walls.vertexCount = static_cast<uint32_t>(wallVertices.size());
+    walls.indices     = wallIndices.data();
+    walls.indexCount  = static_cast<uint32_t>(wallIndices.size());
+    const std::vector<OccluderMesh> occluders {walls};
+
+    // small props spread over the floor of every room
+    std::mt19937                          random(1234);
+    std::uniform_real_distribution<float> sizeDistribution(0.2F, 0.8F);
+    std::uniform_real_distribution<float> offsetDistribution(0.5F, ROOM_SIZE - 1.3F);
+
+    std::vector<Aabb> objects;
+    objects.reserve(static_cast<size_t>(roomsPerSide) * roomsPerSide * settings.objectsPerRoom);
+    for (uint32_t roomY = 0; roomY < roomsPerSide; roomY++)
+    {
+        for (uint32_t roomX = 0; roomX < roomsPerSide; roomX++)
+        {
+            const glm::vec2 roomOrigin {ROOM_SIZE * static_cast<float>(roomX), ROOM_SIZE * static_cast<float>(roomY)};
+            for (uint32_t object = 0; object < settings.objectsPerRoom; object++)
+            {
+                const glm::vec3 size {sizeDistribution(random), sizeDistribution(random), sizeDistribution(random)};
+                const glm::vec3 origin {roomOrigin.x + offsetDistribution(random),
+                                        roomOrigin.y + offsetDistribution(random),
+                                        0.0F};
+
+                Aabb bounds {};
+                bounds.expand(origin);
+                bounds.expand(origin + size);
+                objects.push_back(bounds);
+            }
+        }
+    }
+    const uint32_t objectCount = static_cast<uint32_t>(objects.size());
+
+    NullRhiBackend backend;
+
+    const uint32_t          descriptorSetCount = 256;
+    const RhiPipelineHandle pipeline           = backend.createPipeline();
+    const RhiBufferHandle vertexBuffer = backend.createBuffer({sizeof(glm::vec3) * 8, RHI_BUFFER_USAGE_VERTEX}, nullptr);
+    const RhiBufferHandle indexBuffer  = backend.createBuffer({sizeof(uint32_t) * 36, RHI_BUFFER_USAGE_INDEX}, nullptr);
+
+    std::vector<RhiDescriptorSetHandle> descriptorSets(descriptorSetCount);
+    for (auto& descriptorSet : descriptorSets)
+    {
+        descriptorSet = backend.createDescriptorSet();
+    }
+
+    RhiCommandList commandList;
+
+    // records one draw per object whose result passes, returns the time to record and execute the list
+    const auto drawObjects = [&](const std::vector<CullingResult>& results, CullingResult rejected) {
+        const auto start = std::chrono::high_resolution_clock::now();
+
+        commandList.reset();
+        commandList.bindPipeline(pipeline);
+        commandList.setViewport({0.0F,
+                                 0.0F,
+                                 static_cast<float>(settings.width),
+                                 static_cast<float>(settings.height),
+                                 0.0F,
+                                 1.0F});
+        commandList.setScissor({0, 0, settings.width, settings.height});
+        commandList.bindVertexBuffer(0, vertexBuffer);
+        commandList.bindIndexBuffer(indexBuffer, RhiIndexType::UINT32);
+
+        for (uint32_t object = 0; object < objectCount; object++)
+        {
+            if (results[object] == CullingResult::VIEW_CULLED || results[object] == rejected)
+                continue;
+
+            commandList.bindDescriptorSet(pipeline, 0, descriptorSets[object % descriptorSetCount]);
+            commandList.drawIndexed(36, 1, 0, 0, 0);
+        }
+        backend.execute(commandList);
+
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    };
+
+    MaskedOcclusionCuller culler;
+    culler.resize(settings.width, settings.height);
+
+    // a single thread runs everything inline instead of spinning up a pool
+    std::optional<JobSystem> jobSystem;
+    if (settings.threadCount > 1)
+    {
+        jobSystem.emplace(settings.threadCount - 1);
+    }
+    JobSystem* jobs = jobSystem ? &*jobSystem : nullptr;
+
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0F),
+                                                  static_cast<float>(settings.width) /
+                                                      static_cast<float>(settings.height),
+                                                  0.1F,
+                                                  worldSize * 2.0F);
+
+    std::vector<CullingResult> results(objectCount);
+    ReferenceDepthBuffer       reference;
+
+    double   rasterizeMs      = 0.0;
+    double   testMs           = 0.0;
+    double   culledDrawMs     = 0.0;
+    double   frustumDrawMs    = 0.0;
+    uint64_t visibleCount     = 0;
+    uint64_t occludedCount    = 0;
+    uint64_t viewCulledCount  = 0;
+    uint64_t culledDrawCount  = 0;
+    uint64_t frustumDrawCount = 0;
+    uint64_t subtileUpdates   = 0;
+    uint64_t wrongOccluded    = 0;
+
+    const uint32_t frameCount = std::max(1U, settings.frameCount);
+    for (uint32_t frame = 0; frame < frameCount; frame++)
+    {
+        // walk back and forth along the row of doorways through the middle of the grid while looking around
+        const float     phase = static_cast<float>(frame) / static_cast<float>(frameCount);
+        const float     walk  = 1.0F - std::abs(2.0F * phase - 1.0F);
+        const float     yaw   = std::sin(static_cast<float>(frame) * 0.05F) * 1.2F;
+        const glm::vec3 eye {0.5F + walk * (worldSize - 1.0F),
+                             ROOM_SIZE * (static_cast<float>(roomsPerSide / 2) + 0.5F),
+                             EYE_HEIGHT};
+        const glm::vec3 forward {std::cos(yaw), std::sin(yaw), 0.0F};
+        const glm::mat4 view = glm::lookAt(eye, eye + forward, glm::vec3(0.0F, 0.0F, 1.0F));
+
+        const auto rasterizeStart = std::chrono::high_resolution_clock::now();
+
+        culler.clear();
+        culler.renderOccluders(occluders, projection * view, jobs);
+
+        const auto testStart = std::chrono::high_resolution_clock::now();
+
+        const auto testObjects = [&](uint32_t begin, uint32_t end) {
+            for (uint32_t object = begin; object < end; object++)
+            {
+                results[object] = culler.testAabb(objects[object]);
+            }
+        };
+        if (jobs != nullptr)
+        {
+            jobs->parallelFor(objectCount, 256, testObjects);
+        }
+        else
+        {
+            testObjects(0, objectCount);
+        }
+
+        const auto testEnd = std::chrono::high_resolution_clock::now();
+
+        rasterizeMs += std::chrono::duration<double, std::milli>(testStart - rasterizeStart).count();
+        testMs += std::chrono::duration<double, std::milli>(testEnd - testStart).count();
+        subtileUpdates += culler.getStatistics().subtileUpdateCount;
+
+        for (const CullingResult result : results)
+        {
+            visibleCount += result == CullingResult::VISIBLE ? 1 : 0;
+            occludedCount += result == CullingResult::OCCLUDED ? 1 : 0;
+            viewCulledCount += result == CullingResult::VIEW_CULLED ? 1 : 0;
+        }
+
+        // outside of the timed sections, a box the culler hides has to be hidden at every pixel of the reference
+        reference.render(walls, projection * view, culler.getWidth(), culler.getHeight());
+        for (uint32_t object = 0; object < objectCount; object++)
+        {
+            if (results[object] == CullingResult::OCCLUDED && !reference.isOccluded(objects[object]))
+            {
+                wrongOccluded++;
+            }
+        }
+
+        const uint64_t drawsBefore = backend.getStatistics().drawCount;
+        culledDrawMs += drawObjects(results, CullingResult::OCCLUDED);
+        const uint64_t drawsCulled = backend.getStatistics().drawCount;
+        frustumDrawMs += drawObjects(results, CullingResult::VIEW_CULLED);
+
+        culledDrawCount += drawsCulled - drawsBefore;
+        frustumDrawCount += backend.getStatistics().drawCount - drawsCulled;
+    }
+
+    const double frames = static_cast<double>(frameCount);
+
+    LOG_INFO("occlusion culling: {}x{} buffer, {} threads, {} occluder triangles, {} objects, {} frames",
+             culler.getWidth(),
+             culler.getHeight(),
+             jobs != nullptr ? jobs->getThreadCount() : 1,
+             walls.indexCount / 3,
+             objectCount,
+             frameCount);
+    LOG_INFO("occlusion culling: rasterize {:.3f} ms/frame, test {:.3f} ms/frame ({:.1f} ns/object), {:.0f} subtile "
+             "updates/frame",
+             rasterizeMs / frames,
+             testMs / frames,
+             objectCount > 0 ? testMs * 1e6 / (frames * objectCount) : 0.0,
+             static_cast<double>(subtileUpdates) / frames);
+    LOG_INFO("occlusion culling: {:.1f} visible, {:.1f} occluded, {:.1f} view culled objects per frame",
+             static_cast<double>(visibleCount) / frames,
+             static_cast<double>(occludedCount) / frames,
+             static_cast<double>(viewCulledCount) / frames);
+    LOG_INFO("occlusion culling: {:.1f} draws/frame in {:.3f} ms with occlusion culling, {:.1f} draws/frame in {:.3f} "
+             "ms with frustum culling only",
+             static_cast<double>(culledDrawCount) / frames,
+             culledDrawMs / frames,
+             static_cast<double>(frustumDrawCount) / frames,
+             frustumDrawMs / frames);
+
+    if (wrongOccluded > 0)
+    {
+        LOG_WARN("occlusion culling: {} occluded results are visible in the per pixel reference", wrongOccluded);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+struct OcclusionCullingBenchmarkSettings
+{
+    uint32_t width {640};
+    uint32_t height {384};
+    uint32_t threadCount {4};
+    uint32_t roomsPerSide {8};
+    uint32_t objectsPerRoom {64};
+    uint32_t frameCount {200};
+};
+
+// Walks a camera through a grid of rooms joined by doorways, rasterizes the walls into the masked occlusion culler
+// and tests every object in the rooms against it. Draws of the survivors are recorded and replayed through the null
+// rhi backend next to an unculled run, so the whole pass can be measured without a window or a gpu. Every box reported
+// occluded is checked against a per pixel depth reference of the same walls, the run fails on any that is visible.
+class OcclusionCullingBenchmark {
+public:
+    static int run(const OcclusionCullingBenchmarkSettings& settings);
+};
@@ -0,0 +1,80 @@
+#include "render/frame_packet.h"
+
+FramePacket* FramePacketQueue::acquireWrite()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    uint32_t slot = SLOT_COUNT;
+    condition_.wait(lock, [&] {
+        for (slot = 0; slot < SLOT_COUNT; slot++)
+        {
+            if (states_[slot] == SlotState::FREE)
+                return true;
+        }
+        return closed_;
+    });
+
+    if (closed_)
+        return nullptr;
+
+    states_[slot] = SlotState::WRITING;
+    writeSlot_    = slot;
+
+    return &packets_[slot];
+}
+
+void FramePacketQueue::publish()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        packets_[writeSlot_].frameNumber = nextFrameNumber_++;
+        states_[writeSlot_]              = SlotState::READY;
+    }
+    condition_.notify_all();
+}
+
+const FramePacket* FramePacketQueue::acquireRead()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // both slots can be ready when the render thread fell behind, the older packet goes first
+    uint32_t slot = SLOT_COUNT;
+    condition_.wait(lock, [&] {
+        slot = SLOT_COUNT;
+        for (uint32_t index = 0; index < SLOT_COUNT; index++)
+        {
+            if (states_[index] == SlotState::READY &&
+                (slot == SLOT_COUNT || packets_[index].frameNumber < packets_[slot].frameNumber))
+            {
+                slot = index;
+            }
+        }
+        return slot != SLOT_COUNT || closed_;
+    });
+
+    if (closed_)
+        return nullptr;
+
+    states_[slot] = SlotState::READING;
+    readSlot_     = slot;
+
+    return &packets_[slot];
+}
+
+void FramePacketQueue::releaseRead()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        states_[readSlot_] = SlotState::FREE;
+    }
+    condition_.notify_all();
+}
+
+void FramePacketQueue::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+    }
+    condition_.notify_all();
+}
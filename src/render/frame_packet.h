@@ -0,0 +1,64 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// Everything the render thread takes from the simulation for one frame. The main thread fills the next packet while
+// the render thread is still recording and submitting the previous one, so nothing in here may point back into
+// state the main thread keeps mutating.
+struct FramePacket
+{
+    uint64_t  frameNumber {0};
+    glm::mat4 model {1.0F};
+    glm::mat4 view {1.0F};
+    float     animationTime {0.0F}; // seconds the animation ran, drives the skinned instances
+    uint32_t  framebufferWidth {0};
+    uint32_t  framebufferHeight {0};
+    bool      framebufferResized {false};
+    bool      deferredShading {false};
+    bool      resumedFromIdle {false};
+    bool      showPerfHud {false};
+    uint32_t  traceFramesLeft {0};   // captured into an rhi trace while non zero, the last frame closes the trace
+    uint32_t  captureFramesLeft {0}; // written to an image file while non zero
+};
+
+// Two packets handed back and forth between the main thread and the render thread. Packets are consumed in the
+// order they were published and never dropped, the writer blocks while the render thread owns both of them, which
+// keeps the simulation at most one frame ahead of submission.
+class FramePacketQueue {
+public:
+    // main thread, returns the packet to fill or nullptr once the queue was closed
+    FramePacket* acquireWrite();
+    void         publish();
+
+    // render thread, blocks until a packet was published, returns nullptr once the queue was closed
+    const FramePacket* acquireRead();
+    void               releaseRead();
+
+    // wakes up both sides, every following acquire returns nullptr
+    void close();
+
+private:
+    enum class SlotState : uint8_t
+    {
+        FREE,
+        WRITING,
+        READY,
+        READING
+    };
+
+    static constexpr uint32_t SLOT_COUNT = 2;
+
+    std::array<FramePacket, SLOT_COUNT> packets_ {};
+    std::array<SlotState, SLOT_COUNT>   states_ {SlotState::FREE, SlotState::FREE};
+    uint32_t                            writeSlot_ {0};
+    uint32_t                            readSlot_ {0};
+    uint64_t                            nextFrameNumber_ {0};
+    bool                                closed_ {false};
+    std::mutex                          mutex_;
+    std::condition_variable             condition_;
+};
@@ -0,0 +1,258 @@
+#include "render/hud/perf_hud.h"
+
+#include "foundation/log/log_system.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+// screen pixels per font pixel
+constexpr float TEXT_SCALE = 2.0F;
+
+// in screen pixels
+constexpr float PANEL_OFFSET  = 8.0F;
+constexpr float PANEL_PADDING = 8.0F;
+constexpr float BAR_WIDTH     = 2.0F;
+constexpr float GRAPH_HEIGHT  = 40.0F;
+constexpr float GRAPH_SPACING = 6.0F;
+constexpr float LINE_HEIGHT   = SdfFont::LINE_HEIGHT * TEXT_SCALE;
+
+constexpr uint32_t GRAPH_COUNT   = 3;
+constexpr uint32_t COUNTER_LINES = 5;
+
+// the graphs mark this frame time and scale in powers of two of it
+constexpr float TARGET_FRAME_MS = 1000.0F / 60.0F;
+
+// samples the numbers average over, about half a second at 60 fps
+constexpr uint32_t AVERAGE_COUNT = 30;
+
+constexpr uint32_t VERTICES_PER_QUAD = 6;
+
+constexpr uint32_t packColor(uint32_t red, uint32_t green, uint32_t blue, uint32_t alpha)
+{
+    return red | green << 8U | blue << 16U | alpha << 24U;
+}
+
+constexpr uint32_t BACKGROUND_COLOR = packColor(0, 0, 0, 160);
+constexpr uint32_t GRAPH_BACKGROUND = packColor(255, 255, 255, 24);
+constexpr uint32_t TARGET_COLOR     = packColor(255, 255, 255, 110);
+constexpr uint32_t TEXT_COLOR       = packColor(235, 235, 235, 255);
+constexpr uint32_t OVER_COLOR       = packColor(235, 70, 70, 255);
+constexpr uint32_t FRAME_COLOR      = packColor(100, 210, 100, 255);
+constexpr uint32_t CPU_COLOR        = packColor(90, 160, 235, 255);
+constexpr uint32_t GPU_COLOR        = packColor(235, 160, 60, 255);
+
+constexpr double BYTES_PER_MIB = 1024.0 * 1024.0;
+
+// formats into a fixed buffer, long text is cut instead of allocating
+template<typename... TARGS>
+const char* formatLine(std::array<char, 64>& buffer, const char* format, const TARGS&... args)
+{
+    const auto result = fmt::format_to_n(buffer.data(), buffer.size() - 1, format, args...);
+    *result.out       = '\0';
+    return buffer.data();
+}
+} // namespace
+
+void PerfHud::setFont(const SdfFontAtlas& atlas)
+{
+    glyphs_        = atlas.glyphs;
+    solidTexCoord_ = atlas.solidTexCoord;
+    hasFont_       = !atlas.isEmpty();
+}
+
+void PerfHud::addSample(const PerfHudSample& sample)
+{
+    frameMs_[next_]      = sample.frameMs;
+    cpuMs_[next_]        = sample.cpuMs;
+    gpuMs_[next_]        = sample.gpuMs;
+    uploadCounts_[next_] = sample.uploadCount;
+    uploadBytes_[next_]  = sample.uploadBytes;
+    gpuMeasured_ |= sample.gpuMs >= 0.0F;
+
+    next_        = (next_ + 1) % HISTORY_LENGTH;
+    sampleCount_ = std::min(sampleCount_ + 1, HISTORY_LENGTH);
+}
+
+uint32_t PerfHud::build(const glm::uvec2& extent, HudVertex* vertices, uint32_t capacity)
+{
+    if (!hasFont_ || extent.x == 0 || extent.y == 0)
+        return 0;
+
+    const auto startTime = std::chrono::high_resolution_clock::now();
+
+    Batch batch {};
+    batch.vertices    = vertices;
+    batch.capacity    = capacity;
+    batch.pixelToClip = 2.0F / glm::vec2(extent);
+
+    const glm::vec2 graphSize {HISTORY_LENGTH * BAR_WIDTH, GRAPH_HEIGHT};
+    const glm::vec2 panelMin {PANEL_OFFSET};
+    const glm::vec2 panelSize {graphSize.x + 2.0F * PANEL_PADDING,
+                               GRAPH_COUNT * (LINE_HEIGHT + GRAPH_HEIGHT + GRAPH_SPACING) +
+                                   COUNTER_LINES * LINE_HEIGHT + 2.0F * PANEL_PADDING};
+    addRect(batch, panelMin, panelMin + panelSize, BACKGROUND_COLOR);
+
+    // the three graphs share a scale, so their bars compare
+    float maxMs = TARGET_FRAME_MS;
+    for (uint32_t sample = 0; sample < HISTORY_LENGTH; sample++)
+    {
+        maxMs = std::max({maxMs, frameMs_[sample], cpuMs_[sample], gpuMs_[sample]});
+    }
+    const float scaleMs = TARGET_FRAME_MS * std::exp2(std::ceil(std::log2(maxMs / TARGET_FRAME_MS)));
+
+    const float frameMs = getAverage(frameMs_);
+    const float cpuMs   = getAverage(cpuMs_);
+    const float gpuMs   = getAverage(gpuMs_);
+
+    std::array<char, 64> line {};
+    glm::vec2            pen = panelMin + PANEL_PADDING;
+
+    const auto addTimeGraph = [&](const char* text, const std::array<float, HISTORY_LENGTH>& history, uint32_t color) {
+        addText(batch, pen, text, TEXT_COLOR);
+        pen.y += LINE_HEIGHT;
+        addGraph(batch, pen, graphSize, history, scaleMs, color);
+        pen.y += GRAPH_HEIGHT + GRAPH_SPACING;
+    };
+
+    addTimeGraph(formatLine(line, "FRAME   {:.2f} MS {:.0f} FPS", frameMs, frameMs > 0.0F ? 1000.0F / frameMs : 0.0F),
+                 frameMs_,
+                 FRAME_COLOR);
+    addTimeGraph(formatLine(line, "CPU     {:.2f} MS", cpuMs), cpuMs_, CPU_COLOR);
+    addTimeGraph(gpuMeasured_ ? formatLine(line, "GPU     {:.2f} MS", gpuMs) : "GPU     N/A", gpuMs_, GPU_COLOR);
+
+    // the upload rates are over the frames the numbers average over, idle time between frames does not count
+    uint32_t uploadCount = 0;
+    uint64_t uploadBytes = 0;
+    float    elapsedMs   = 0.0F;
+    for (uint32_t age = 1; age <= std::min(sampleCount_, AVERAGE_COUNT); age++)
+    {
+        const uint32_t sample = (next_ + HISTORY_LENGTH - age) % HISTORY_LENGTH;
+        uploadCount += uploadCounts_[sample];
+        uploadBytes += uploadBytes_[sample];
+        elapsedMs += frameMs_[sample];
+    }
+    const double perSecond = elapsedMs > 0.0F ? 1000.0 / elapsedMs : 0.0;
+
+    addText(batch, pen, formatLine(line, "DRAWS   {}", counters_.drawCount), TEXT_COLOR);
+    pen.y += LINE_HEIGHT;
+    addText(batch,
+            pen,
+            formatLine(line,
+                       "UPLOADS {:.0f}/S {:.2f} MIB/S",
+                       uploadCount * perSecond,
+                       static_cast<double>(uploadBytes) * perSecond / BYTES_PER_MIB),
+            TEXT_COLOR);
+    pen.y += LINE_HEIGHT;
+    addText(batch,
+            pen,
+            counters_.deviceMemoryBudget > 0 ?
+                formatLine(line,
+                           "VRAM    {:.0f}/{:.0f} MIB",
+                           static_cast<double>(counters_.deviceMemoryUsage) / BYTES_PER_MIB,
+                           static_cast<double>(counters_.deviceMemoryBudget) / BYTES_PER_MIB) :
+                "VRAM    N/A",
+            counters_.deviceMemoryUsage > counters_.deviceMemoryBudget ? OVER_COLOR : TEXT_COLOR);
+    pen.y += LINE_HEIGHT;
+    addText(batch,
+            pen,
+            formatLine(line, "WORLD   {:.1f} MIB", static_cast<double>(counters_.streamedBytes) / BYTES_PER_MIB),
+            TEXT_COLOR);
+    pen.y += LINE_HEIGHT;
+    addText(batch, pen, formatLine(line, "HUD     {:.3f} MS", buildMs_), TEXT_COLOR);
+
+    buildMs_ = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    return batch.count;
+}
+
+void PerfHud::addRect(Batch& batch, const glm::vec2& min, const glm::vec2& max, uint32_t color) const
+{
+    addQuad(batch, min, max, solidTexCoord_, solidTexCoord_, color);
+}
+
+void PerfHud::addQuad(Batch&           batch,
+                      const glm::vec2& min,
+                      const glm::vec2& max,
+                      const glm::vec2& uvMin,
+                      const glm::vec2& uvMax,
+                      uint32_t         color) const
+{
+    if (batch.count + VERTICES_PER_QUAD > batch.capacity)
+        return;
+
+    const glm::vec2 clipMin = min * batch.pixelToClip - 1.0F;
+    const glm::vec2 clipMax = max * batch.pixelToClip - 1.0F;
+
+    // two triangles, vulkan clip space has y down like the pixels
+    HudVertex* vertices = batch.vertices + batch.count;
+    vertices[0]         = {clipMin, uvMin, color};
+    vertices[1]         = {{clipMin.x, clipMax.y}, {uvMin.x, uvMax.y}, color};
+    vertices[2]         = {clipMax, uvMax, color};
+    vertices[3]         = vertices[0];
+    vertices[4]         = vertices[2];
+    vertices[5]         = {{clipMax.x, clipMin.y}, {uvMax.x, uvMin.y}, color};
+    batch.count += VERTICES_PER_QUAD;
+}
+
+void PerfHud::addText(Batch& batch, const glm::vec2& pen, const char* text, uint32_t color) const
+{
+    // the cell of a glyph reaches GLYPH_MARGIN font pixels beyond it on every side
+    const glm::vec2 margin {SdfFont::GLYPH_MARGIN * TEXT_SCALE};
+    const glm::vec2 glyphSize {SdfFont::GLYPH_WIDTH * TEXT_SCALE, SdfFont::GLYPH_HEIGHT * TEXT_SCALE};
+
+    glm::vec2 position = pen;
+    for (const char* character = text; *character != '\0'; character++)
+    {
+        const auto code = static_cast<uint8_t>(*character);
+        if (code != ' ')
+        {
+            const SdfGlyph& glyph = code < glyphs_.size() && !glyphs_[code].isEmpty() ? glyphs_[code] : glyphs_['?'];
+            addQuad(batch, position - margin, position + glyphSize + margin, glyph.uvMin, glyph.uvMax, color);
+        }
+        position.x += SdfFont::GLYPH_ADVANCE * TEXT_SCALE;
+    }
+}
+
+void PerfHud::addGraph(Batch&                                   batch,
+                       const glm::vec2&                         min,
+                       const glm::vec2&                         size,
+                       const std::array<float, HISTORY_LENGTH>& history,
+                       float                                    scaleMs,
+                       uint32_t                                 color) const
+{
+    const glm::vec2 max = min + size;
+    addRect(batch, min, max, GRAPH_BACKGROUND);
+
+    // oldest sample first, the newest one ends at the right edge
+    for (uint32_t age = sampleCount_; age > 0; age--)
+    {
+        const float value = history[(next_ + HISTORY_LENGTH - age) % HISTORY_LENGTH];
+        const float top   = max.y - std::min(value / scaleMs, 1.0F) * size.y;
+        if (top > max.y - 1.0F)
+            continue;
+
+        const float left = max.x - static_cast<float>(age) * BAR_WIDTH;
+        addRect(batch, {left, top}, {left + BAR_WIDTH, max.y}, value > TARGET_FRAME_MS ? OVER_COLOR : color);
+    }
+
+    const float targetY = max.y - TARGET_FRAME_MS / scaleMs * size.y;
+    addRect(batch, {min.x, targetY}, {max.x, targetY + 1.0F}, TARGET_COLOR);
+}
+
+float PerfHud::getAverage(const std::array<float, HISTORY_LENGTH>& history) const
+{
+    float    sum   = 0.0F;
+    uint32_t count = 0;
+    for (uint32_t age = 1; age <= std::min(sampleCount_, AVERAGE_COUNT); age++)
+    {
+        const float value = history[(next_ + HISTORY_LENGTH - age) % HISTORY_LENGTH];
+        if (value < 0.0F)
+            continue;
+
+        sum += value;
+        count++;
+    }
+    return count > 0 ? sum / static_cast<float>(count) : 0.0F;
+}
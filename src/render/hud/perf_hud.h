@@ -0,0 +1,99 @@
+#pragma once
+
+#include "render/hud/sdf_font.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+
+// One corner of an overlay triangle. The position is in clip space, so the vertex shader passes it through, the color
+// is rgba8 with red in the lowest byte and not premultiplied.
+struct HudVertex
+{
+    glm::vec2 position {0.0F};
+    glm::vec2 texCoord {0.0F};
+    uint32_t  color {0};
+};
+static_assert(sizeof(HudVertex) == 20, "HudVertex is read with a stride of 20 bytes");
+
+// the timings of one drawn frame, negative for what was not measured
+struct PerfHudSample
+{
+    float    frameMs {0.0F}; // from the previous frame to this one
+    float    cpuMs {0.0F};   // recording and submitting, without the waits on the gpu and the swap chain
+    float    gpuMs {-1.0F};  // main pass of the latest frame the timestamps came back for
+    uint32_t uploadCount {0};
+    uint64_t uploadBytes {0};
+};
+
+struct PerfHudCounters
+{
+    uint32_t drawCount {0};          // scene, impostor and particle draws, not the lighting pass or the hud itself
+    uint64_t deviceMemoryUsage {0};  // bytes of the device local heaps, 0 if the driver does not tell
+    uint64_t deviceMemoryBudget {0}; // of the same heaps, 0 if the driver does not tell
+    uint64_t streamedBytes {0};      // resident world cells
+};
+
+// Frame time, cpu time and gpu time graphs with the counters of the frame as text, built into one list of triangles.
+// Every glyph and every rectangle is a quad textured from the same distance field atlas, rectangles sample its solid
+// texel, so the whole overlay is a single draw out of a single vertex buffer. The vertices are written straight into
+// mapped memory and the cost of writing them is part of the overlay.
+class PerfHud {
+public:
+    static constexpr uint32_t HISTORY_LENGTH = 160;
+
+    // only the texture coordinates are kept, the texels go to the gpu elsewhere
+    void setFont(const SdfFontAtlas& atlas);
+    void addSample(const PerfHudSample& sample);
+    void setCounters(const PerfHudCounters& counters) { counters_ = counters; }
+
+    // writes the triangles for a framebuffer of extent and returns the vertex count, stops at capacity
+    uint32_t build(const glm::uvec2& extent, HudVertex* vertices, uint32_t capacity);
+
+    [[nodiscard]] bool hasFont() const { return hasFont_; }
+
+private:
+    struct Batch
+    {
+        HudVertex* vertices {nullptr};
+        uint32_t   capacity {0};
+        uint32_t   count {0};
+        glm::vec2  pixelToClip {0.0F};
+    };
+
+    void addRect(Batch& batch, const glm::vec2& min, const glm::vec2& max, uint32_t color) const;
+    void addQuad(Batch&           batch,
+                 const glm::vec2& min,
+                 const glm::vec2& max,
+                 const glm::vec2& uvMin,
+                 const glm::vec2& uvMax,
+                 uint32_t         color) const;
+    void addText(Batch& batch, const glm::vec2& pen, const char* text, uint32_t color) const;
+    // bars of the last samples of a history, right aligned, with a line at the target frame time
+    void addGraph(Batch&                                   batch,
+                  const glm::vec2&                         min,
+                  const glm::vec2&                         size,
+                  const std::array<float, HISTORY_LENGTH>& history,
+                  float                                    scaleMs,
+                  uint32_t                                 color) const;
+
+    [[nodiscard]] float getAverage(const std::array<float, HISTORY_LENGTH>& history) const;
+
+    std::array<SdfGlyph, 128> glyphs_ {};
+    glm::vec2                 solidTexCoord_ {0.0F};
+    bool                      hasFont_ {false};
+
+    // ring buffers, next_ is the oldest sample
+    std::array<float, HISTORY_LENGTH>    frameMs_ {};
+    std::array<float, HISTORY_LENGTH>    cpuMs_ {};
+    std::array<float, HISTORY_LENGTH>    gpuMs_ {};
+    std::array<uint32_t, HISTORY_LENGTH> uploadCounts_ {};
+    std::array<uint64_t, HISTORY_LENGTH> uploadBytes_ {};
+    uint32_t                             next_ {0};
+    uint32_t                             sampleCount_ {0};
+    bool                                 gpuMeasured_ {false};
+
+    PerfHudCounters counters_ {};
+    float           buildMs_ {0.0F}; // of the previous build, a build cannot show its own cost
+};
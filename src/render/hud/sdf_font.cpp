@@ -0,0 +1,178 @@
+#include "render/hud/sdf_font.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+
+namespace
+{
+struct PixelGlyph
+{
+    char                                           code;
+    std::array<const char*, SdfFont::GLYPH_HEIGHT> rows; // top row first, '#' is set
+};
+
+// upper case, digits and the punctuation of the overlays
+constexpr PixelGlyph PIXEL_GLYPHS[] = {
+    {' ', {".....", ".....", ".....", ".....", ".....", ".....", "....."}},
+    {'!', {"..#..", "..#..", "..#..", "..#..", "..#..", ".....", "..#.."}},
+    {'%', {"##...", "##..#", "...#.", "..#..", ".#...", "#..##", "...##"}},
+    {'(', {"...#.", "..#..", ".#...", ".#...", ".#...", "..#..", "...#."}},
+    {')', {".#...", "..#..", "...#.", "...#.", "...#.", "..#..", ".#..."}},
+    {'+', {".....", "..#..", "..#..", "#####", "..#..", "..#..", "....."}},
+    {',', {".....", ".....", ".....", ".....", ".##..", "..#..", ".#..."}},
+    {'-', {".....", ".....", ".....", "#####", ".....", ".....", "....."}},
+    {'.', {".....", ".....", ".....", ".....", ".....", ".##..", ".##.."}},
+    {'/', {".....", "....#", "...#.", "..#..", ".#...", "#....", "....."}},
+    {'0', {".###.", "#...#", "#..##", "#.#.#", "##..#", "#...#", ".###."}},
+    {'1', {"..#..", ".##..", "..#..", "..#..", "..#..", "..#..", ".###."}},
+    {'2', {".###.", "#...#", "....#", "...#.", "..#..", ".#...", "#####"}},
+    {'3', {"#####", "...#.", "..#..", "...#.", "....#", "#...#", ".###."}},
+    {'4', {"...#.", "..##.", ".#.#.", "#..#.", "#####", "...#.", "...#."}},
+    {'5', {"#####", "#....", "####.", "....#", "....#", "#...#", ".###."}},
+    {'6', {"..##.", ".#...", "#....", "####.", "#...#", "#...#", ".###."}},
+    {'7', {"#####", "....#", "...#.", "..#..", ".#...", ".#...", ".#..."}},
+    {'8', {".###.", "#...#", "#...#", ".###.", "#...#", "#...#", ".###."}},
+    {'9', {".###.", "#...#", "#...#", ".####", "....#", "...#.", ".##.."}},
+    {':', {".....", ".##..", ".##..", ".....", ".##..", ".##..", "....."}},
+    {'<', {"...#.", "..#..", ".#...", "#....", ".#...", "..#..", "...#."}},
+    {'=', {".....", ".....", "#####", ".....", "#####", ".....", "....."}},
+    {'>', {".#...", "..#..", "...#.", "....#", "...#.", "..#..", ".#..."}},
+    {'?', {".###.", "#...#", "....#", "...#.", "..#..", ".....", "..#.."}},
+    {'A', {".###.", "#...#", "#...#", "#####", "#...#", "#...#", "#...#"}},
+    {'B', {"####.", "#...#", "#...#", "####.", "#...#", "#...#", "####."}},
+    {'C', {".###.", "#...#", "#....", "#....", "#....", "#...#", ".###."}},
+    {'D', {"###..", "#..#.", "#...#", "#...#", "#...#", "#..#.", "###.."}},
+    {'E', {"#####", "#....", "#....", "####.", "#....", "#....", "#####"}},
+    {'F', {"#####", "#....", "#....", "####.", "#....", "#....", "#...."}},
+    {'G', {".###.", "#...#", "#....", "#.###", "#...#", "#...#", ".####"}},
+    {'H', {"#...#", "#...#", "#...#", "#####", "#...#", "#...#", "#...#"}},
+    {'I', {".###.", "..#..", "..#..", "..#..", "..#..", "..#..", ".###."}},
+    {'J', {"..###", "...#.", "...#.", "...#.", "...#.", "#..#.", ".##.."}},
+    {'K', {"#...#", "#..#.", "#.#..", "##...", "#.#..", "#..#.", "#...#"}},
+    {'L', {"#....", "#....", "#....", "#....", "#....", "#....", "#####"}},
+    {'M', {"#...#", "##.##", "#.#.#", "#.#.#", "#...#", "#...#", "#...#"}},
+    {'N', {"#...#", "#...#", "##..#", "#.#.#", "#..##", "#...#", "#...#"}},
+    {'O', {".###.", "#...#", "#...#", "#...#", "#...#", "#...#", ".###."}},
+    {'P', {"####.", "#...#", "#...#", "####.", "#....", "#....", "#...."}},
+    {'Q', {".###.", "#...#", "#...#", "#...#", "#.#.#", "#..#.", ".##.#"}},
+    {'R', {"####.", "#...#", "#...#", "####.", "#.#..", "#..#.", "#...#"}},
+    {'S', {".####", "#....", "#....", ".###.", "....#", "....#", "####."}},
+    {'T', {"#####", "..#..", "..#..", "..#..", "..#..", "..#..", "..#.."}},
+    {'U', {"#...#", "#...#", "#...#", "#...#", "#...#", "#...#", ".###."}},
+    {'V', {"#...#", "#...#", "#...#", "#...#", "#...#", ".#.#.", "..#.."}},
+    {'W', {"#...#", "#...#", "#...#", "#.#.#", "#.#.#", "#.#.#", ".#.#."}},
+    {'X', {"#...#", "#...#", ".#.#.", "..#..", ".#.#.", "#...#", "#...#"}},
+    {'Y', {"#...#", "#...#", ".#.#.", "..#..", "..#..", "..#..", "..#.."}},
+    {'Z', {"#####", "....#", "...#.", "..#..", ".#...", "#....", "#####"}},
+    {'[', {".###.", ".#...", ".#...", ".#...", ".#...", ".#...", ".###."}},
+    {']', {".###.", "...#.", "...#.", "...#.", "...#.", "...#.", ".###."}},
+    {'_', {".....", ".....", ".....", ".....", ".....", ".....", "#####"}},
+    {'|', {"..#..", "..#..", "..#..", "..#..", "..#..", "..#..", "..#.."}},
+};
+constexpr auto GLYPH_COUNT = static_cast<uint32_t>(std::size(PIXEL_GLYPHS));
+
+// glyph cells per row of the atlas, the solid cell follows the last glyph
+constexpr uint32_t CELLS_PER_ROW = 16;
+
+constexpr uint32_t CELL_PIXELS_X = SdfFont::GLYPH_WIDTH + 2 * SdfFont::GLYPH_MARGIN;
+constexpr uint32_t CELL_PIXELS_Y = SdfFont::GLYPH_HEIGHT + 2 * SdfFont::GLYPH_MARGIN;
+
+bool isSet(const PixelGlyph& glyph, int32_t x, int32_t y)
+{
+    if (x < 0 || y < 0 || x >= static_cast<int32_t>(SdfFont::GLYPH_WIDTH) ||
+        y >= static_cast<int32_t>(SdfFont::GLYPH_HEIGHT))
+        return false;
+    return glyph.rows[y][x] == '#';
+}
+
+// signed distance in font pixels from point to the outline of the glyph, negative inside. The glyph is a union of
+// unit squares, so the distance to the nearest square of the other kind is exact. Squares of the margin count as
+// unset, the field is clamped to the margin anyway
+float getSignedDistance(const PixelGlyph& glyph, const glm::vec2& point)
+{
+    const glm::ivec2 pixel {static_cast<int32_t>(std::floor(point.x)), static_cast<int32_t>(std::floor(point.y))};
+    const bool       inside = isSet(glyph, pixel.x, pixel.y);
+
+    float nearest = static_cast<float>(SdfFont::GLYPH_MARGIN);
+    for (int32_t y = -1; y <= static_cast<int32_t>(SdfFont::GLYPH_HEIGHT); y++)
+    {
+        for (int32_t x = -1; x <= static_cast<int32_t>(SdfFont::GLYPH_WIDTH); x++)
+        {
+            if (isSet(glyph, x, y) == inside)
+                continue;
+
+            const glm::vec2 square {static_cast<float>(x), static_cast<float>(y)};
+            const glm::vec2 offset = glm::max(glm::max(square - point, point - (square + 1.0F)), 0.0F);
+            nearest                = std::min(nearest, glm::length(offset));
+        }
+    }
+    return inside ? -nearest : nearest;
+}
+} // namespace
+
+namespace SdfFont
+{
+SdfFontAtlas create(uint32_t texelsPerPixel)
+{
+    texelsPerPixel = std::max(1U, texelsPerPixel);
+
+    const uint32_t cellWidth  = CELL_PIXELS_X * texelsPerPixel;
+    const uint32_t cellHeight = CELL_PIXELS_Y * texelsPerPixel;
+    const uint32_t cellCount  = GLYPH_COUNT + 1;
+
+    SdfFontAtlas atlas;
+    atlas.width  = CELLS_PER_ROW * cellWidth;
+    atlas.height = (cellCount + CELLS_PER_ROW - 1) / CELLS_PER_ROW * cellHeight;
+    atlas.texels.assign(static_cast<size_t>(atlas.width) * atlas.height, 0);
+
+    const glm::vec2 texelSize     = 1.0F / glm::vec2(atlas.width, atlas.height);
+    const auto      getCellOrigin = [&](uint32_t cell) {
+        return glm::uvec2(cell % CELLS_PER_ROW * cellWidth, cell / CELLS_PER_ROW * cellHeight);
+    };
+
+    for (uint32_t cell = 0; cell < GLYPH_COUNT; cell++)
+    {
+        const PixelGlyph& glyph  = PIXEL_GLYPHS[cell];
+        const glm::uvec2  origin = getCellOrigin(cell);
+        for (uint32_t y = 0; y < cellHeight; y++)
+        {
+            for (uint32_t x = 0; x < cellWidth; x++)
+            {
+                // texel centers in font pixels relative to the top left corner of the glyph
+                const glm::vec2 point = (glm::vec2(x, y) + 0.5F) / static_cast<float>(texelsPerPixel) -
+                                        static_cast<float>(GLYPH_MARGIN);
+                const float distance = getSignedDistance(glyph, point);
+                const float value    = std::clamp(0.5F - 0.5F * distance / GLYPH_MARGIN, 0.0F, 1.0F);
+                atlas.texels[static_cast<size_t>(origin.y + y) * atlas.width + origin.x + x] =
+                    static_cast<uint8_t>(std::lround(value * 255.0F));
+            }
+        }
+
+        SdfGlyph& entry = atlas.glyphs[static_cast<uint8_t>(glyph.code)];
+        entry.uvMin     = glm::vec2(origin) * texelSize;
+        entry.uvMax     = glm::vec2(origin + glm::uvec2(cellWidth, cellHeight)) * texelSize;
+    }
+
+    // lower case text renders in upper case, unless the font has a glyph of its own for the letter
+    for (uint32_t code = 'a'; code <= 'z'; code++)
+    {
+        if (atlas.glyphs[code].isEmpty())
+        {
+            atlas.glyphs[code] = atlas.glyphs[std::toupper(static_cast<int>(code))];
+        }
+    }
+
+    const glm::uvec2 solidOrigin = getCellOrigin(cellCount - 1);
+    for (uint32_t y = 0; y < cellHeight; y++)
+    {
+        std::fill_n(atlas.texels.begin() + static_cast<ptrdiff_t>(solidOrigin.y + y) * atlas.width + solidOrigin.x,
+                    cellWidth,
+                    uint8_t {255});
+    }
+    atlas.solidTexCoord = (glm::vec2(solidOrigin) + glm::vec2(cellWidth, cellHeight) * 0.5F) * texelSize;
+    return atlas;
+}
+} // namespace SdfFont
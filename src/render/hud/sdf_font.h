@@ -0,0 +1,42 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+struct SdfGlyph
+{
+    glm::vec2 uvMin {0.0F};
+    glm::vec2 uvMax {0.0F};
+
+    [[nodiscard]] bool isEmpty() const { return uvMin == uvMax; }
+};
+
+// Signed distance field of the built in font, one r8 texel per entry. 0.5 lies on the outline, larger values are
+// inside, so a shader that thresholds at 0.5 with a screen space smoothing width stays sharp at any scale. Every glyph
+// cell covers the glyph and GLYPH_MARGIN font pixels of field around it.
+struct SdfFontAtlas
+{
+    uint32_t                  width {0};
+    uint32_t                  height {0};
+    std::vector<uint8_t>      texels;    // rows tightly packed
+    std::array<SdfGlyph, 128> glyphs {}; // by ascii code, lower case maps to upper case, empty for missing ones
+    glm::vec2                 solidTexCoord {0.0F}; // a texel deep inside, for untextured rectangles
+
+    [[nodiscard]] bool isEmpty() const { return texels.empty(); }
+};
+
+// A monospaced 5x7 pixel font baked into a distance field atlas at startup, so the overlays need no font file.
+namespace SdfFont
+{
+constexpr uint32_t GLYPH_WIDTH   = 5;
+constexpr uint32_t GLYPH_HEIGHT  = 7;
+constexpr uint32_t GLYPH_MARGIN  = 1; // font pixels, the quad of a glyph is this much larger on every side
+constexpr uint32_t GLYPH_ADVANCE = GLYPH_WIDTH + 1;
+constexpr uint32_t LINE_HEIGHT   = GLYPH_HEIGHT + 2;
+
+// texelsPerPixel sets the resolution of the field, 4 keeps the corners of the pixel font crisp up to about 8x
+SdfFontAtlas create(uint32_t texelsPerPixel = 4);
+} // namespace SdfFont
@@ -0,0 +1,139 @@
+#include "render/material/material_system.h"
+
+#include "foundation/log/log_system.h"
+
+#include <algorithm>
+
+namespace
+{
+MaterialParameters toParameters(const MaterialDesc& desc)
+{
+    MaterialParameters parameters {};
+    parameters.baseColor        = desc.baseColor;
+    parameters.baseColorTexture = desc.baseColorTexture;
+    parameters.shadingModel     = static_cast<uint32_t>(desc.shadingModel);
+    parameters.lightmapTexture  = desc.lightmapTexture;
+    return parameters;
+}
+} // namespace
+
+void MaterialSystem::create(uint32_t materialCapacity, uint32_t objectCapacity, uint32_t textureCapacity)
+{
+    materialCapacity_ = std::max(1U, materialCapacity);
+    textureCapacity_  = std::max(1U, textureCapacity);
+
+    parameters_.clear();
+    parameters_.reserve(materialCapacity_);
+    parameters_.push_back(toParameters(MaterialDesc {}));
+    objectMaterials_.assign(std::max(1U, objectCapacity), 0);
+
+    // the gpu buffers start out undefined, everything goes up with the first upload
+    dirtyMaterials_ = {0, 1};
+    dirtyObjects_   = {0, static_cast<uint32_t>(objectMaterials_.size())};
+    pipelineVersion_++;
+}
+
+uint32_t MaterialSystem::createMaterial(const MaterialDesc& desc)
+{
+    if (parameters_.size() >= materialCapacity_)
+    {
+        LOG_ERROR("Material capacity of {} exhausted, using the default material", materialCapacity_);
+        return 0;
+    }
+
+    const auto material = static_cast<uint32_t>(parameters_.size());
+    parameters_.push_back(toParameters(desc));
+    parameters_.back().baseColorTexture = validateTexture(desc.baseColorTexture);
+    parameters_.back().lightmapTexture  = validateTexture(desc.lightmapTexture);
+    markDirty(dirtyMaterials_, material);
+    return material;
+}
+
+void MaterialSystem::setBaseColor(uint32_t material, const glm::vec4& baseColor)
+{
+    if (!isValidMaterial(material))
+        return;
+
+    parameters_[material].baseColor = baseColor;
+    markDirty(dirtyMaterials_, material);
+}
+
+void MaterialSystem::setBaseColorTexture(uint32_t material, uint32_t texture)
+{
+    if (!isValidMaterial(material))
+        return;
+
+    parameters_[material].baseColorTexture = validateTexture(texture);
+    markDirty(dirtyMaterials_, material);
+}
+
+void MaterialSystem::setShadingModel(uint32_t material, ShadingModel shadingModel)
+{
+    if (!isValidMaterial(material) || shadingModel == ShadingModel::COUNT)
+        return;
+
+    parameters_[material].shadingModel = static_cast<uint32_t>(shadingModel);
+    markDirty(dirtyMaterials_, material);
+    pipelineVersion_++;
+}
+
+void MaterialSystem::assignMaterial(uint32_t object, uint32_t material)
+{
+    if (object >= objectMaterials_.size())
+    {
+        LOG_ERROR("Object {} is outside the material table of {} objects", object, objectMaterials_.size());
+        return;
+    }
+    if (!isValidMaterial(material) || objectMaterials_[object] == material)
+        return;
+
+    objectMaterials_[object] = material;
+    markDirty(dirtyObjects_, object);
+    pipelineVersion_++;
+}
+
+uint32_t MaterialSystem::getObjectMaterial(uint32_t object) const
+{
+    return object < objectMaterials_.size() ? objectMaterials_[object] : 0;
+}
+
+ShadingModel MaterialSystem::getShadingModel(uint32_t material) const
+{
+    return static_cast<ShadingModel>(parameters_[isValidMaterial(material) ? material : 0].shadingModel);
+}
+
+bool MaterialSystem::isValidMaterial(uint32_t material) const
+{
+    if (material < parameters_.size())
+        return true;
+
+    LOG_ERROR("Invalid material {}", material);
+    return false;
+}
+
+uint32_t MaterialSystem::validateTexture(uint32_t texture) const
+{
+    if (texture < textureCapacity_)
+        return texture;
+
+    LOG_WARN("Texture slot {} is outside the texture table of {} slots, using slot 0", texture, textureCapacity_);
+    return 0;
+}
+
+void MaterialSystem::markDirty(DirtySpan& span, uint32_t index)
+{
+    span.begin = std::min(span.begin, index);
+    span.end   = std::max(span.end, index + 1);
+}
+
+MaterialSystem::DirtyRange MaterialSystem::takeDirtyRange(DirtySpan& span)
+{
+    DirtyRange range {};
+    if (span.begin < span.end)
+    {
+        range.first = span.begin;
+        range.count = span.end - span.begin;
+    }
+    span = {};
+    return range;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Selects the pipeline a material draws with, everything else about a material is data the shaders read.
+enum class ShadingModel : uint32_t
+{
+    UNLIT,
+    LAMBERT,
+    LIGHTMAPPED, // baked diffuse lighting from the lightmap texture, see LightmapBaker
+    COUNT
+};
+
+constexpr uint32_t SHADING_MODEL_COUNT = static_cast<uint32_t>(ShadingModel::COUNT);
+
+struct MaterialDesc
+{
+    glm::vec4    baseColor {1.0F};
+    uint32_t     baseColorTexture {0}; // slot in the bindless texture table
+    uint32_t     lightmapTexture {0};  // sampled with the same texture coordinates, only by lightmapped materials
+    ShadingModel shadingModel {ShadingModel::LAMBERT};
+};
+
+// One entry of the material buffer in std430 layout, the shaders declare the same struct.
+struct MaterialParameters
+{
+    glm::vec4 baseColor {1.0F};
+    uint32_t  baseColorTexture {0};
+    uint32_t  shadingModel {0};
+    uint32_t  lightmapTexture {0};
+    uint32_t  padding {0};
+};
+
+static_assert(sizeof(MaterialParameters) == 32, "MaterialParameters must match the std430 shader layout");
+
+// Materials as typed parameter blocks in one flat array, mirrored into a single gpu buffer and indexed per draw
+// through a second array that maps object ids to materials. Changes only mark the touched entries, the owner copies
+// the dirty ranges to the gpu once per frame, so a material costs neither a descriptor set nor an upload of its own.
+// Not thread safe, the render thread owns it once it runs.
+class MaterialSystem {
+public:
+    struct DirtyRange
+    {
+        uint32_t first {0};
+        uint32_t count {0};
+    };
+
+    // material 0 is the default every object starts out with
+    void create(uint32_t materialCapacity, uint32_t objectCapacity, uint32_t textureCapacity);
+
+    // falls back to the default material once the capacity is used up
+    uint32_t createMaterial(const MaterialDesc& desc);
+
+    void setBaseColor(uint32_t material, const glm::vec4& baseColor);
+    void setBaseColorTexture(uint32_t material, uint32_t texture);
+    void setShadingModel(uint32_t material, ShadingModel shadingModel);
+
+    void assignMaterial(uint32_t object, uint32_t material);
+
+    [[nodiscard]] uint32_t     getObjectMaterial(uint32_t object) const;
+    [[nodiscard]] ShadingModel getShadingModel(uint32_t material) const;
+    [[nodiscard]] uint32_t     getMaterialCount() const { return static_cast<uint32_t>(parameters_.size()); }
+    [[nodiscard]] uint32_t     getMaterialCapacity() const { return materialCapacity_; }
+    [[nodiscard]] uint32_t     getObjectCapacity() const { return static_cast<uint32_t>(objectMaterials_.size()); }
+
+    // changes whenever an object may have to draw with a different pipeline, cached draws compare it
+    [[nodiscard]] uint64_t getPipelineVersion() const { return pipelineVersion_; }
+
+    [[nodiscard]] const MaterialParameters* getParameters() const { return parameters_.data(); }
+    [[nodiscard]] const uint32_t*           getObjectMaterials() const { return objectMaterials_.data(); }
+
+    // the entries changed since the previous call, count is zero when nothing changed
+    DirtyRange takeDirtyMaterials() { return takeDirtyRange(dirtyMaterials_); }
+    DirtyRange takeDirtyObjects() { return takeDirtyRange(dirtyObjects_); }
+
+private:
+    struct DirtySpan
+    {
+        uint32_t begin {UINT32_MAX};
+        uint32_t end {0};
+    };
+
+    [[nodiscard]] bool isValidMaterial(uint32_t material) const;
+    uint32_t           validateTexture(uint32_t texture) const;
+
+    static void       markDirty(DirtySpan& span, uint32_t index);
+    static DirtyRange takeDirtyRange(DirtySpan& span);
+
+    uint32_t                        materialCapacity_ {0};
+    uint32_t                        textureCapacity_ {0};
+    std::vector<MaterialParameters> parameters_;
+    std::vector<uint32_t>           objectMaterials_;
+    DirtySpan                       dirtyMaterials_ {};
+    DirtySpan                       dirtyObjects_ {};
+    uint64_t                        pipelineVersion_ {0};
+};
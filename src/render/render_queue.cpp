@@ -0,0 +1,63 @@
+#include "render/render_queue.h"
+
+#include <algorithm>
+
+namespace
+{
+constexpr uint32_t RADIX_BITS = 8;
+constexpr uint32_t RADIX_SIZE = 1U << RADIX_BITS;
+constexpr uint32_t PASS_COUNT = 64 / RADIX_BITS;
+
+// below this a comparison sort wins over eight histograms
+constexpr size_t INSERTION_SORT_LIMIT = 64;
+} // namespace
+
+void RenderQueue::sort()
+{
+    const size_t count = items_.size();
+    if (count < 2)
+        return;
+
+    if (count <= INSERTION_SORT_LIMIT)
+    {
+        std::stable_sort(items_.begin(), items_.end(), [](const RenderItem& left, const RenderItem& right) {
+            return left.sortKey < right.sortKey;
+        });
+        return;
+    }
+
+    // all histograms in one read over the keys
+    uint32_t histograms[PASS_COUNT][RADIX_SIZE] = {};
+    for (const RenderItem& item : items_)
+    {
+        for (uint32_t pass = 0; pass < PASS_COUNT; pass++)
+        {
+            histograms[pass][(item.sortKey >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1)]++;
+        }
+    }
+
+    scratch_.resize(count);
+    for (uint32_t pass = 0; pass < PASS_COUNT; pass++)
+    {
+        uint32_t*      histogram = histograms[pass];
+        const uint32_t shift     = pass * RADIX_BITS;
+
+        // every key has the same byte here, the pass would only copy
+        if (histogram[(items_[0].sortKey >> shift) & (RADIX_SIZE - 1)] == count)
+            continue;
+
+        uint32_t offset = 0;
+        for (uint32_t bucket = 0; bucket < RADIX_SIZE; bucket++)
+        {
+            const uint32_t bucketCount = histogram[bucket];
+            histogram[bucket]          = offset;
+            offset += bucketCount;
+        }
+
+        for (const RenderItem& item : items_)
+        {
+            scratch_[histogram[(item.sortKey >> shift) & (RADIX_SIZE - 1)]++] = item;
+        }
+        items_.swap(scratch_);
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One visible object waiting to be drawn. The key decides the draw order, typically pipeline and material in the high
+// bits and depth in the low ones, the object is whatever the producer uses to find its draw data again.
+struct RenderItem
+{
+    uint64_t sortKey {0};
+    uint32_t object {0};
+};
+
+// Flat list of draws a culling pass appends to directly, sorted once before recording instead of being collected into
+// per pass lists first.
+class RenderQueue {
+public:
+    void clear() { items_.clear(); }
+    void reserve(size_t count) { items_.reserve(count); }
+
+    void push(uint64_t sortKey, uint32_t object) { items_.push_back({sortKey, object}); }
+
+    // stable radix sort by key, bytes every key agrees on are skipped
+    void sort();
+
+    [[nodiscard]] bool                           isEmpty() const { return items_.empty(); }
+    [[nodiscard]] size_t                         getSize() const { return items_.size(); }
+    [[nodiscard]] const std::vector<RenderItem>& getItems() const { return items_; }
+
+private:
+    std::vector<RenderItem> items_;
+    std::vector<RenderItem> scratch_;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "render/rhi/rhi_command_list.h"
+#include "render/rhi/rhi_types.h"
+
+#include <cstdint>
+
+struct RhiBackendStatistics
+{
+    uint64_t commandCount {0};
+    uint64_t drawCount {0};
+    uint64_t redundantCommandCount {0};
+};
+
+// What the renderer frontend talks to. A backend owns the resources behind the handles and translates command lists
+// into its native command format, the frontend never sees a native object.
+class RhiBackend {
+public:
+    virtual ~RhiBackend() = default;
+
+    [[nodiscard]] virtual const char* getName() const = 0;
+
+    // initialData may be nullptr, otherwise it has to hold desc.size bytes
+    virtual RhiBufferHandle createBuffer(const RhiBufferDesc& desc, const void* initialData) = 0;
+    virtual void            destroyBuffer(RhiBufferHandle buffer)                            = 0;
+
+    // replays the packets in recording order into whatever the backend currently translates to
+    virtual void execute(const RhiCommandList& commandList) = 0;
+
+    [[nodiscard]] const RhiBackendStatistics& getStatistics() const { return statistics_; }
+    void                                      resetStatistics() { statistics_ = {}; }
+
+protected:
+    RhiBackendStatistics statistics_ {};
+};
@@ -0,0 +1,153 @@
+#include "render/rhi/rhi_command_list.h"
+
+#include <algorithm>
+#include <cstring>
+
+const char* getRhiCommandTypeName(RhiCommandType type)
+{
+    switch (type)
+    {
+        case RhiCommandType::BIND_PIPELINE:
+            return "BindPipeline";
+        case RhiCommandType::BIND_DESCRIPTOR_SET:
+            return "BindDescriptorSet";
+        case RhiCommandType::BIND_VERTEX_BUFFER:
+            return "BindVertexBuffer";
+        case RhiCommandType::BIND_INDEX_BUFFER:
+            return "BindIndexBuffer";
+        case RhiCommandType::SET_VIEWPORT:
+            return "SetViewport";
+        case RhiCommandType::SET_SCISSOR:
+            return "SetScissor";
+        case RhiCommandType::DRAW:
+            return "Draw";
+        case RhiCommandType::DRAW_INDEXED:
+            return "DrawIndexed";
+        case RhiCommandType::DRAW_INDIRECT:
+            return "DrawIndirect";
+        default:
+            return "Unknown";
+    }
+}
+
+RhiCommandList::RhiCommandList(size_t initialCapacity)
+{
+    storage_.resize((initialCapacity + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+}
+
+void RhiCommandList::reset()
+{
+    size_         = 0;
+    commandCount_ = 0;
+    drawCount_    = 0;
+}
+
+void RhiCommandList::assign(const std::byte* data, size_t size)
+{
+    if (size > getCapacity())
+    {
+        grow(size);
+    }
+
+    memcpy(storage_.data(), data, size);
+    size_         = size;
+    commandCount_ = 0;
+    drawCount_    = 0;
+    forEach([this](const RhiCommandHeader& header) {
+        commandCount_++;
+        if (header.type == RhiCommandType::DRAW || header.type == RhiCommandType::DRAW_INDEXED)
+        {
+            drawCount_++;
+        }
+        else if (header.type == RhiCommandType::DRAW_INDIRECT)
+        {
+            drawCount_ += as<RhiCmdDrawIndirect>(header).drawCount;
+        }
+    });
+}
+
+void RhiCommandList::bindPipeline(RhiPipelineHandle pipeline)
+{
+    auto& packet    = push<RhiCmdBindPipeline>();
+    packet.pipeline = pipeline;
+}
+
+void RhiCommandList::bindDescriptorSet(RhiPipelineHandle      pipeline,
+                                       uint32_t               setIndex,
+                                       RhiDescriptorSetHandle descriptorSet)
+{
+    auto& packet         = push<RhiCmdBindDescriptorSet>();
+    packet.pipeline      = pipeline;
+    packet.setIndex      = setIndex;
+    packet.descriptorSet = descriptorSet;
+}
+
+void RhiCommandList::bindVertexBuffer(uint32_t binding, RhiBufferHandle buffer, uint64_t offset)
+{
+    auto& packet   = push<RhiCmdBindVertexBuffer>();
+    packet.binding = binding;
+    packet.buffer  = buffer;
+    packet.offset  = offset;
+}
+
+void RhiCommandList::bindIndexBuffer(RhiBufferHandle buffer, RhiIndexType indexType, uint64_t offset)
+{
+    auto& packet     = push<RhiCmdBindIndexBuffer>();
+    packet.buffer    = buffer;
+    packet.indexType = indexType;
+    packet.offset    = offset;
+}
+
+void RhiCommandList::setViewport(const RhiViewport& viewport)
+{
+    auto& packet    = push<RhiCmdSetViewport>();
+    packet.viewport = viewport;
+}
+
+void RhiCommandList::setScissor(const RhiRect& scissor)
+{
+    auto& packet   = push<RhiCmdSetScissor>();
+    packet.scissor = scissor;
+}
+
+void RhiCommandList::draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+{
+    auto& packet         = push<RhiCmdDraw>();
+    packet.vertexCount   = vertexCount;
+    packet.instanceCount = instanceCount;
+    packet.firstVertex   = firstVertex;
+    packet.firstInstance = firstInstance;
+    drawCount_++;
+}
+
+void RhiCommandList::drawIndexed(uint32_t indexCount,
+                                 uint32_t instanceCount,
+                                 uint32_t firstIndex,
+                                 int32_t  vertexOffset,
+                                 uint32_t firstInstance)
+{
+    auto& packet         = push<RhiCmdDrawIndexed>();
+    packet.indexCount    = indexCount;
+    packet.instanceCount = instanceCount;
+    packet.firstIndex    = firstIndex;
+    packet.vertexOffset  = vertexOffset;
+    packet.firstInstance = firstInstance;
+    drawCount_++;
+}
+
+void RhiCommandList::drawIndirect(RhiBufferHandle buffer, uint64_t offset, uint32_t drawCount, uint32_t stride)
+{
+    auto& packet     = push<RhiCmdDrawIndirect>();
+    packet.buffer    = buffer;
+    packet.offset    = offset;
+    packet.drawCount = drawCount;
+    packet.stride    = stride;
+    drawCount_ += drawCount;
+}
+
+void RhiCommandList::grow(size_t minCapacity)
+{
+    // only happens until the list reached the size of the largest frame it records
+    const size_t capacity = std::max(minCapacity, getCapacity() * 2);
+    storage_.resize((capacity + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+}
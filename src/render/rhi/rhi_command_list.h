@@ -0,0 +1,210 @@
+#pragma once
+
+#include "render/rhi/rhi_types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+enum class RhiCommandType : uint32_t
+{
+    BIND_PIPELINE,
+    BIND_DESCRIPTOR_SET,
+    BIND_VERTEX_BUFFER,
+    BIND_INDEX_BUFFER,
+    SET_VIEWPORT,
+    SET_SCISSOR,
+    DRAW,
+    DRAW_INDEXED,
+    DRAW_INDIRECT,
+    COUNT
+};
+
+[[nodiscard]] const char* getRhiCommandTypeName(RhiCommandType type);
+
+// Every packet starts with this header, size covers the whole packet so a reader can skip commands it ignores
+struct RhiCommandHeader
+{
+    RhiCommandType type;
+    uint32_t       size;
+};
+
+struct RhiCmdBindPipeline
+{
+    static constexpr RhiCommandType TYPE = RhiCommandType::BIND_PIPELINE;
+
+    RhiCommandHeader  header;
+    RhiPipelineHandle pipeline;
+};
+
+// the pipeline only supplies the layout the set is bound against
+struct RhiCmdBindDescriptorSet
+{
+    static constexpr RhiCommandType TYPE = RhiCommandType::BIND_DESCRIPTOR_SET;
+
+    RhiCommandHeader       header;
+    RhiPipelineHandle      pipeline;
+    uint32_t               setIndex;
+    RhiDescriptorSetHandle descriptorSet;
+};
+
+struct RhiCmdBindVertexBuffer
+{
+    static constexpr RhiCommandType TYPE = RhiCommandType::BIND_VERTEX_BUFFER;
+
+    RhiCommandHeader header;
+    uint32_t         binding;
+    RhiBufferHandle  buffer;
+    uint64_t         offset;
+};
+
+struct RhiCmdBindIndexBuffer
+{
+    static constexpr RhiCommandType TYPE = RhiCommandType::BIND_INDEX_BUFFER;
+
+    RhiCommandHeader header;
+    RhiBufferHandle  buffer;
+    RhiIndexType     indexType;
+    uint64_t         offset;
+};
+
+struct RhiCmdSetViewport
+{
+    static constexpr RhiCommandType TYPE = RhiCommandType::SET_VIEWPORT;
+
+    RhiCommandHeader header;
+    RhiViewport      viewport;
+};
+
+struct RhiCmdSetScissor
+{
+    static constexpr RhiCommandType TYPE = RhiCommandType::SET_SCISSOR;
+
+    RhiCommandHeader header;
+    RhiRect          scissor;
+};
+
+struct RhiCmdDraw
+{
+    static constexpr RhiCommandType TYPE = RhiCommandType::DRAW;
+
+    RhiCommandHeader header;
+    uint32_t         vertexCount;
+    uint32_t         instanceCount;
+    uint32_t         firstVertex;
+    uint32_t         firstInstance;
+};
+
+struct RhiCmdDrawIndexed
+{
+    static constexpr RhiCommandType TYPE = RhiCommandType::DRAW_INDEXED;
+
+    RhiCommandHeader header;
+    uint32_t         indexCount;
+    uint32_t         instanceCount;
+    uint32_t         firstIndex;
+    int32_t          vertexOffset;
+    uint32_t         firstInstance;
+};
+
+// draw parameters come from the buffer, written on the gpu
+struct RhiCmdDrawIndirect
+{
+    static constexpr RhiCommandType TYPE = RhiCommandType::DRAW_INDIRECT;
+
+    RhiCommandHeader header;
+    RhiBufferHandle  buffer;
+    uint64_t         offset;
+    uint32_t         drawCount;
+    uint32_t         stride;
+};
+
+// A linear run of command packets. A list is owned by the thread recording into it, so several threads can record
+// in parallel without locks. reset() keeps the storage, once a list reached its steady state size recording does
+// not allocate anymore. Backends replay the packets in recording order.
+class RhiCommandList {
+public:
+    explicit RhiCommandList(size_t initialCapacity = 4096);
+
+    // forgets the recorded commands, keeps the memory
+    void reset();
+
+    void bindPipeline(RhiPipelineHandle pipeline);
+    void bindDescriptorSet(RhiPipelineHandle pipeline, uint32_t setIndex, RhiDescriptorSetHandle descriptorSet);
+    void bindVertexBuffer(uint32_t binding, RhiBufferHandle buffer, uint64_t offset = 0);
+    void bindIndexBuffer(RhiBufferHandle buffer, RhiIndexType indexType, uint64_t offset = 0);
+    void setViewport(const RhiViewport& viewport);
+    void setScissor(const RhiRect& scissor);
+    void draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance);
+    void drawIndexed(uint32_t indexCount,
+                     uint32_t instanceCount,
+                     uint32_t firstIndex,
+                     int32_t  vertexOffset,
+                     uint32_t firstInstance);
+    void drawIndirect(RhiBufferHandle buffer, uint64_t offset, uint32_t drawCount, uint32_t stride);
+
+    // replaces the contents with packets recorded elsewhere, e.g. loaded from a trace
+    void assign(const std::byte* data, size_t size);
+
+    [[nodiscard]] const std::byte* getData() const { return reinterpret_cast<const std::byte*>(storage_.data()); }
+    [[nodiscard]] uint32_t         getCommandCount() const { return commandCount_; }
+    [[nodiscard]] uint32_t         getDrawCount() const { return drawCount_; } // an indirect packet counts drawCount
+    [[nodiscard]] size_t           getSize() const { return size_; }
+    [[nodiscard]] bool             isEmpty() const { return commandCount_ == 0; }
+
+    // calls visitor(const RhiCommandHeader&) for every packet, use as<T>() to get at the payload
+    template<typename VISITOR>
+    void forEach(VISITOR&& visitor) const
+    {
+        const auto* bytes  = reinterpret_cast<const std::byte*>(storage_.data());
+        size_t      offset = 0;
+        while (offset < size_)
+        {
+            const auto* header = reinterpret_cast<const RhiCommandHeader*>(bytes + offset);
+            visitor(*header);
+            offset += header->size;
+        }
+    }
+
+    template<typename T>
+    static const T& as(const RhiCommandHeader& header)
+    {
+        return *reinterpret_cast<const T*>(&header);
+    }
+
+private:
+    static constexpr size_t PACKET_ALIGNMENT = alignof(uint64_t);
+
+    template<typename T>
+    T& push()
+    {
+        static_assert(std::is_trivially_copyable_v<T> && std::is_standard_layout_v<T>, "packets have to be POD");
+        static_assert(alignof(T) <= PACKET_ALIGNMENT, "packet alignment exceeds the list alignment");
+
+        constexpr size_t packetSize = (sizeof(T) + PACKET_ALIGNMENT - 1) & ~(PACKET_ALIGNMENT - 1);
+        if (size_ + packetSize > getCapacity())
+        {
+            grow(size_ + packetSize);
+        }
+
+        auto* packet        = new (reinterpret_cast<std::byte*>(storage_.data()) + size_) T {};
+        packet->header.type = T::TYPE;
+        packet->header.size = static_cast<uint32_t>(packetSize);
+
+        size_ += packetSize;
+        commandCount_++;
+
+        return *packet;
+    }
+
+    [[nodiscard]] size_t getCapacity() const { return storage_.size() * sizeof(uint64_t); }
+    void                 grow(size_t minCapacity);
+
+    // uint64_t storage keeps every packet 8 byte aligned
+    std::vector<uint64_t> storage_;
+    size_t                size_ {0};
+    uint32_t              commandCount_ {0};
+    uint32_t              drawCount_ {0};
+};
@@ -0,0 +1,438 @@
+#include "render/rhi/rhi_trace.h"
+
+#include "foundation/log/log_system.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+namespace
+{
+const uint32_t TRACE_MAGIC   = 0x54494852; // "RHIT"
+const uint32_t TRACE_VERSION = 1;
+
+// traces come from outside, every size in one is checked against these before anything is allocated for it
+const uint32_t MAX_TRACE_HANDLES     = 1U << 20U;
+const uint64_t MAX_TRACE_BUFFER_SIZE = 1ULL << 32U;
+
+// vertex count and instance count, the part of an indirect draw the backends read
+const uint64_t INDIRECT_DRAW_SIZE = sizeof(uint32_t) * 2;
+
+// the size a packet of type needs at least, 0 for types this version does not know
+size_t getMinPacketSize(RhiCommandType type)
+{
+    switch (type)
+    {
+        case RhiCommandType::BIND_PIPELINE:
+            return sizeof(RhiCmdBindPipeline);
+        case RhiCommandType::BIND_DESCRIPTOR_SET:
+            return sizeof(RhiCmdBindDescriptorSet);
+        case RhiCommandType::BIND_VERTEX_BUFFER:
+            return sizeof(RhiCmdBindVertexBuffer);
+        case RhiCommandType::BIND_INDEX_BUFFER:
+            return sizeof(RhiCmdBindIndexBuffer);
+        case RhiCommandType::SET_VIEWPORT:
+            return sizeof(RhiCmdSetViewport);
+        case RhiCommandType::SET_SCISSOR:
+            return sizeof(RhiCmdSetScissor);
+        case RhiCommandType::DRAW:
+            return sizeof(RhiCmdDraw);
+        case RhiCommandType::DRAW_INDEXED:
+            return sizeof(RhiCmdDrawIndexed);
+        case RhiCommandType::DRAW_INDIRECT:
+            return sizeof(RhiCmdDrawIndirect);
+        default:
+            return 0;
+    }
+}
+
+// remapHandles and the backends walk the packets by their sizes and read them by their types, so both have to hold
+// up before a list is kept
+bool isValidCommandList(const std::byte* bytes, size_t size)
+{
+    size_t offset = 0;
+    while (offset < size)
+    {
+        if (size - offset < sizeof(RhiCommandHeader))
+            return false;
+
+        RhiCommandHeader header {};
+        std::memcpy(&header, bytes + offset, sizeof(header));
+
+        const size_t minSize = getMinPacketSize(header.type);
+        if (minSize == 0 || header.size < minSize || header.size > size - offset ||
+            header.size % alignof(uint64_t) != 0)
+            return false;
+
+        // overlapping draws would let the draw count alone keep a backend busy
+        if (header.type == RhiCommandType::DRAW_INDIRECT)
+        {
+            RhiCmdDrawIndirect command {};
+            std::memcpy(&command, bytes + offset, sizeof(command));
+            if (command.drawCount > 1 && command.stride < INDIRECT_DRAW_SIZE)
+                return false;
+        }
+
+        offset += header.size;
+    }
+    return true;
+}
+
+// the draws of command have to lie inside the buffer as it was captured. Only called for lists that passed
+// isValidCommandList, so stride is large enough and the sum cannot overflow with bufferSize capped
+bool isValidIndirectDraw(const RhiCmdDrawIndirect& command, uint64_t bufferSize)
+{
+    if (command.drawCount == 0)
+        return true;
+    if (command.offset > bufferSize)
+        return false;
+
+    const uint64_t lastDraw = static_cast<uint64_t>(command.drawCount - 1) * command.stride;
+    return command.offset + lastDraw + INDIRECT_DRAW_SIZE <= bufferSize;
+}
+} // namespace
+
+bool RhiTraceWriter::begin(const std::string& path)
+{
+    const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+    if (!directory.empty())
+    {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+    }
+
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if (!file_.is_open())
+    {
+        LOG_WARN("Failed to open rhi trace {} for writing", path);
+        return false;
+    }
+
+    RhiTraceFileHeader header {};
+    header.magic   = TRACE_MAGIC;
+    header.version = TRACE_VERSION;
+    file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    frameCount_ = 0;
+    return true;
+}
+
+void RhiTraceWriter::end()
+{
+    file_.close();
+}
+
+void RhiTraceWriter::writeBuffer(RhiBufferHandle handle, const RhiBufferDesc& desc, const void* data)
+{
+    RhiTraceBufferChunk chunk {};
+    chunk.handle   = handle.index;
+    chunk.usage    = desc.usage;
+    chunk.size     = desc.size;
+    chunk.dataSize = data != nullptr ? desc.size : 0;
+
+    writeChunk(RhiTraceChunkType::BUFFER, &chunk, sizeof(chunk), data, static_cast<size_t>(chunk.dataSize));
+}
+
+void RhiTraceWriter::writePipeline(RhiPipelineHandle handle)
+{
+    writeChunk(RhiTraceChunkType::PIPELINE, &handle.index, sizeof(handle.index), nullptr, 0);
+}
+
+void RhiTraceWriter::writeDescriptorSet(RhiDescriptorSetHandle handle)
+{
+    writeChunk(RhiTraceChunkType::DESCRIPTOR_SET, &handle.index, sizeof(handle.index), nullptr, 0);
+}
+
+void RhiTraceWriter::beginFrame()
+{
+    writeChunk(RhiTraceChunkType::FRAME, nullptr, 0, nullptr, 0);
+    frameCount_++;
+}
+
+void RhiTraceWriter::writeCommandList(const RhiCommandList& commandList)
+{
+    if (commandList.isEmpty())
+        return;
+
+    writeChunk(RhiTraceChunkType::COMMAND_LIST, commandList.getData(), commandList.getSize(), nullptr, 0);
+}
+
+void RhiTraceWriter::writeChunk(
+    RhiTraceChunkType type, const void* payload, size_t size, const void* extra, size_t extraSize)
+{
+    RhiTraceChunkHeader header {};
+    header.type = type;
+    header.size = static_cast<uint32_t>(size + extraSize);
+
+    file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (size > 0)
+    {
+        file_.write(static_cast<const char*>(payload), static_cast<std::streamsize>(size));
+    }
+    if (extraSize > 0)
+    {
+        file_.write(static_cast<const char*>(extra), static_cast<std::streamsize>(extraSize));
+    }
+}
+
+bool RhiTraceReplayer::load(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        LOG_WARN("Failed to open rhi trace {}", path);
+        return false;
+    }
+
+    file.seekg(0, std::ios::end);
+    const auto fileSize = static_cast<uint64_t>(file.tellg());
+    file.seekg(0, std::ios::beg);
+
+    RhiTraceFileHeader fileHeader {};
+    file.read(reinterpret_cast<char*>(&fileHeader), sizeof(fileHeader));
+    if (!file || fileHeader.magic != TRACE_MAGIC || fileHeader.version != TRACE_VERSION)
+    {
+        LOG_WARN("{} is not a rhi trace of version {}", path, TRACE_VERSION);
+        return false;
+    }
+
+    buffers_.clear();
+    pipelines_.clear();
+    descriptorSets_.clear();
+    tracedFrames_.clear();
+    frames_.clear();
+
+    const auto reject = [&path](const char* reason) {
+        LOG_WARN("rhi trace {} is corrupt: {}", path, reason);
+        return false;
+    };
+
+    RhiTraceChunkHeader header {};
+    while (file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    {
+        // a chunk cannot be larger than what is left of the file, which also bounds every allocation below
+        if (header.size > fileSize - static_cast<uint64_t>(file.tellg()))
+        {
+            LOG_WARN("rhi trace {} is truncated", path);
+            return false;
+        }
+
+        switch (header.type)
+        {
+            case RhiTraceChunkType::BUFFER: {
+                RhiTraceBufferChunk chunk {};
+                if (header.size < sizeof(chunk))
+                    return reject("buffer chunk too small");
+
+                file.read(reinterpret_cast<char*>(&chunk), sizeof(chunk));
+                if (chunk.handle >= MAX_TRACE_HANDLES)
+                    return reject("buffer handle out of range");
+                if (chunk.size > MAX_TRACE_BUFFER_SIZE || chunk.dataSize > chunk.size ||
+                    chunk.dataSize != header.size - sizeof(chunk))
+                    return reject("buffer size mismatch");
+
+                buffers_.resize(std::max<size_t>(buffers_.size(), chunk.handle + 1));
+                TracedBuffer& buffer = buffers_[chunk.handle];
+                buffer.desc          = {chunk.size, chunk.usage};
+                buffer.data.resize(static_cast<size_t>(chunk.dataSize));
+                file.read(reinterpret_cast<char*>(buffer.data.data()), static_cast<std::streamsize>(chunk.dataSize));
+                break;
+            }
+            case RhiTraceChunkType::PIPELINE: {
+                uint32_t handle = 0;
+                if (header.size != sizeof(handle))
+                    return reject("pipeline chunk size mismatch");
+
+                file.read(reinterpret_cast<char*>(&handle), sizeof(handle));
+                if (handle >= MAX_TRACE_HANDLES)
+                    return reject("pipeline handle out of range");
+                pipelines_.push_back(handle);
+                break;
+            }
+            case RhiTraceChunkType::DESCRIPTOR_SET: {
+                uint32_t handle = 0;
+                if (header.size != sizeof(handle))
+                    return reject("descriptor set chunk size mismatch");
+
+                file.read(reinterpret_cast<char*>(&handle), sizeof(handle));
+                if (handle >= MAX_TRACE_HANDLES)
+                    return reject("descriptor set handle out of range");
+                descriptorSets_.push_back(handle);
+                break;
+            }
+            case RhiTraceChunkType::FRAME:
+                if (header.size != 0)
+                    return reject("frame chunk with a payload");
+
+                tracedFrames_.emplace_back();
+                break;
+            case RhiTraceChunkType::COMMAND_LIST: {
+                if (tracedFrames_.empty())
+                {
+                    tracedFrames_.emplace_back();
+                }
+
+                TracedList& list = tracedFrames_.back().emplace_back();
+                list.size        = header.size;
+                list.storage.resize((header.size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+                file.read(reinterpret_cast<char*>(list.storage.data()), header.size);
+                if (file && !isValidCommandList(reinterpret_cast<const std::byte*>(list.storage.data()), list.size))
+                    return reject("malformed command packets");
+                break;
+            }
+            default:
+                // unknown chunks from newer writers are skipped
+                file.seekg(header.size, std::ios::cur);
+                break;
+        }
+
+        if (!file)
+        {
+            LOG_WARN("rhi trace {} is truncated", path);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool RhiTraceReplayer::bind(RhiBackend& backend, const RhiTraceResourceFactory& factory)
+{
+    // checked against the captured sizes before anything is created on the backend
+    for (const auto& tracedFrame : tracedFrames_)
+    {
+        for (const auto& tracedList : tracedFrame)
+        {
+            if (!hasValidIndirectDraws(tracedList))
+            {
+                LOG_WARN("rhi trace has an indirect draw outside of its buffer");
+                return false;
+            }
+        }
+    }
+
+    // tables from captured handle to replay handle, slot 0 stays invalid
+    std::vector<RhiBufferHandle> bufferMap(buffers_.size());
+    for (size_t index = 1; index < buffers_.size(); index++)
+    {
+        const TracedBuffer& buffer = buffers_[index];
+        if (buffer.desc.size == 0)
+            continue;
+
+        bufferMap[index] = backend.createBuffer(buffer.desc, buffer.data.empty() ? nullptr : buffer.data.data());
+    }
+
+    std::vector<RhiPipelineHandle> pipelineMap;
+    for (const uint32_t handle : pipelines_)
+    {
+        pipelineMap.resize(std::max<size_t>(pipelineMap.size(), handle + 1));
+        pipelineMap[handle] = factory.createPipeline();
+    }
+
+    std::vector<RhiDescriptorSetHandle> descriptorSetMap;
+    for (const uint32_t handle : descriptorSets_)
+    {
+        descriptorSetMap.resize(std::max<size_t>(descriptorSetMap.size(), handle + 1));
+        descriptorSetMap[handle] = factory.createDescriptorSet();
+    }
+
+    frames_.clear();
+    for (auto& tracedFrame : tracedFrames_)
+    {
+        auto& frame = frames_.emplace_back();
+        for (auto& tracedList : tracedFrame)
+        {
+            remapHandles(tracedList, bufferMap, pipelineMap, descriptorSetMap);
+            frame.emplace_back(tracedList.size)
+                .assign(reinterpret_cast<const std::byte*>(tracedList.storage.data()), tracedList.size);
+        }
+    }
+
+    tracedFrames_.clear();
+    return true;
+}
+
+RhiTraceReplayStatistics RhiTraceReplayer::replay(RhiBackend& backend, uint32_t iterations) const
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    RhiTraceReplayStatistics statistics {};
+    statistics.iterations = iterations;
+
+    const auto start = Clock::now();
+    for (uint32_t iteration = 0; iteration < iterations; iteration++)
+    {
+        for (const auto& frame : frames_)
+        {
+            for (const auto& commandList : frame)
+            {
+                backend.execute(commandList);
+                statistics.commandCount += commandList.getCommandCount();
+            }
+        }
+    }
+    statistics.totalMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    return statistics;
+}
+
+bool RhiTraceReplayer::hasValidIndirectDraws(const TracedList& list) const
+{
+    const auto* bytes  = reinterpret_cast<const std::byte*>(list.storage.data());
+    size_t      offset = 0;
+    while (offset < list.size)
+    {
+        const auto* header = reinterpret_cast<const RhiCommandHeader*>(bytes + offset);
+        if (header->type == RhiCommandType::DRAW_INDIRECT)
+        {
+            const auto&    command = *reinterpret_cast<const RhiCmdDrawIndirect*>(header);
+            const uint32_t buffer  = command.buffer.index;
+            if (buffer >= buffers_.size() || !isValidIndirectDraw(command, buffers_[buffer].desc.size))
+                return false;
+        }
+        offset += header->size;
+    }
+    return true;
+}
+
+void RhiTraceReplayer::remapHandles(TracedList&                                list,
+                                    const std::vector<RhiBufferHandle>&        buffers,
+                                    const std::vector<RhiPipelineHandle>&      pipelines,
+                                    const std::vector<RhiDescriptorSetHandle>& descriptorSets)
+{
+    const auto remap = [](auto& handle, const auto& table) {
+        handle = handle.index < table.size() ? table[handle.index] : std::decay_t<decltype(handle)> {};
+    };
+
+    auto*  bytes  = reinterpret_cast<std::byte*>(list.storage.data());
+    size_t offset = 0;
+    while (offset < list.size)
+    {
+        auto* header = reinterpret_cast<RhiCommandHeader*>(bytes + offset);
+        switch (header->type)
+        {
+            case RhiCommandType::BIND_PIPELINE:
+                remap(reinterpret_cast<RhiCmdBindPipeline*>(header)->pipeline, pipelines);
+                break;
+            case RhiCommandType::BIND_DESCRIPTOR_SET: {
+                auto* command = reinterpret_cast<RhiCmdBindDescriptorSet*>(header);
+                remap(command->pipeline, pipelines);
+                remap(command->descriptorSet, descriptorSets);
+                break;
+            }
+            case RhiCommandType::BIND_VERTEX_BUFFER:
+                remap(reinterpret_cast<RhiCmdBindVertexBuffer*>(header)->buffer, buffers);
+                break;
+            case RhiCommandType::BIND_INDEX_BUFFER:
+                remap(reinterpret_cast<RhiCmdBindIndexBuffer*>(header)->buffer, buffers);
+                break;
+            case RhiCommandType::DRAW_INDIRECT:
+                remap(reinterpret_cast<RhiCmdDrawIndirect*>(header)->buffer, buffers);
+                break;
+            default:
+                break;
+        }
+        offset += header->size;
+    }
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "render/rhi/rhi_backend.h"
+#include "render/rhi/rhi_command_list.h"
+#include "render/rhi/rhi_types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+// A trace is a file header followed by chunks, every chunk is a RhiTraceChunkHeader and its payload. Command list
+// chunks hold the packets exactly as they were recorded, so capturing costs a single write per list.
+//
+// Pipelines and descriptor sets are only declared by handle, so a trace replays into backends that take the packets
+// as they are, the null backend in practice. Replaying on a vulkan device to measure the cost of the driver calls is
+// separate work, it needs their state serialized into the trace and a headless offscreen target.
+enum class RhiTraceChunkType : uint32_t
+{
+    BUFFER,
+    PIPELINE,
+    DESCRIPTOR_SET,
+    FRAME,
+    COMMAND_LIST
+};
+
+struct RhiTraceFileHeader
+{
+    uint32_t magic {0};
+    uint32_t version {0};
+};
+
+struct RhiTraceChunkHeader
+{
+    RhiTraceChunkType type;
+    uint32_t          size;
+};
+
+struct RhiTraceBufferChunk
+{
+    uint32_t handle;
+    uint32_t usage;
+    uint64_t size;
+    uint64_t dataSize; // 0 when the contents were not captured
+};
+
+class RhiTraceWriter {
+public:
+    bool begin(const std::string& path);
+    void end();
+
+    [[nodiscard]] bool     isCapturing() const { return file_.is_open(); }
+    [[nodiscard]] uint32_t getFrameCount() const { return frameCount_; }
+
+    // resources referenced by the packets, data may be nullptr
+    void writeBuffer(RhiBufferHandle handle, const RhiBufferDesc& desc, const void* data);
+    void writePipeline(RhiPipelineHandle handle);
+    void writeDescriptorSet(RhiDescriptorSetHandle handle);
+
+    void beginFrame();
+    void writeCommandList(const RhiCommandList& commandList);
+
+private:
+    void writeChunk(RhiTraceChunkType type, const void* payload, size_t size, const void* extra, size_t extraSize);
+
+    std::ofstream file_;
+    uint32_t      frameCount_ {0};
+};
+
+// pipelines and descriptor sets are only declared in a trace, the replaying side decides what they become
+struct RhiTraceResourceFactory
+{
+    std::function<RhiPipelineHandle()>      createPipeline;
+    std::function<RhiDescriptorSetHandle()> createDescriptorSet;
+};
+
+struct RhiTraceReplayStatistics
+{
+    uint32_t iterations {0};
+    uint64_t commandCount {0};
+    double   totalMs {0.0};
+};
+
+class RhiTraceReplayer {
+public:
+    bool load(const std::string& path);
+
+    // creates the traced resources on backend and rewrites every handle in the packets to the new ones, false when an
+    // indirect draw reads past the end of its buffer
+    [[nodiscard]] bool bind(RhiBackend& backend, const RhiTraceResourceFactory& factory);
+
+    // replays all frames iterations times as fast as possible
+    RhiTraceReplayStatistics replay(RhiBackend& backend, uint32_t iterations) const;
+
+    [[nodiscard]] uint32_t getFrameCount() const { return static_cast<uint32_t>(frames_.size()); }
+
+private:
+    struct TracedBuffer
+    {
+        RhiBufferHandle        handle {};
+        RhiBufferDesc          desc {};
+        std::vector<std::byte> data;
+    };
+
+    // packets as loaded, kept in uint64_t storage so they can be patched in place
+    struct TracedList
+    {
+        std::vector<uint64_t> storage;
+        size_t                size {0};
+    };
+
+    [[nodiscard]] bool hasValidIndirectDraws(const TracedList& list) const;
+
+    static void remapHandles(TracedList&                                list,
+                             const std::vector<RhiBufferHandle>&        buffers,
+                             const std::vector<RhiPipelineHandle>&      pipelines,
+                             const std::vector<RhiDescriptorSetHandle>& descriptorSets);
+
+    // indexed by the handle values of the capture
+    std::vector<TracedBuffer> buffers_;
+    std::vector<uint32_t>     pipelines_;
+    std::vector<uint32_t>     descriptorSets_;
+
+    std::vector<std::vector<TracedList>>     tracedFrames_;
+    std::vector<std::vector<RhiCommandList>> frames_;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+
+// Opaque handles into tables owned by a backend. They are plain indices so packets stay POD and can be copied
+// between threads, index 0 is reserved for the invalid handle.
+template<typename TAG>
+struct RhiHandle
+{
+    uint32_t index {0};
+
+    [[nodiscard]] bool isValid() const { return index != 0; }
+
+    bool operator==(const RhiHandle& other) const { return index == other.index; }
+    bool operator!=(const RhiHandle& other) const { return index != other.index; }
+};
+
+using RhiBufferHandle        = RhiHandle<struct RhiBufferTag>;
+using RhiPipelineHandle      = RhiHandle<struct RhiPipelineTag>;
+using RhiDescriptorSetHandle = RhiHandle<struct RhiDescriptorSetTag>;
+
+enum class RhiIndexType : uint8_t
+{
+    UINT16,
+    UINT32
+};
+
+enum RhiBufferUsage : uint32_t
+{
+    RHI_BUFFER_USAGE_VERTEX   = 1U << 0U,
+    RHI_BUFFER_USAGE_INDEX    = 1U << 1U,
+    RHI_BUFFER_USAGE_UNIFORM  = 1U << 2U,
+    RHI_BUFFER_USAGE_STORAGE  = 1U << 3U,
+    RHI_BUFFER_USAGE_INDIRECT = 1U << 4U,
+};
+
+struct RhiBufferDesc
+{
+    uint64_t size {0};
+    uint32_t usage {0};
+};
+
+struct RhiViewport
+{
+    float x {0.0F};
+    float y {0.0F};
+    float width {0.0F};
+    float height {0.0F};
+    float minDepth {0.0F};
+    float maxDepth {1.0F};
+};
+
+struct RhiRect
+{
+    int32_t  x {0};
+    int32_t  y {0};
+    uint32_t width {0};
+    uint32_t height {0};
+};
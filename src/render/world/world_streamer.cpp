@@ -0,0 +1,153 @@
+#include "render/world/world_streamer.h"
+
+#include <algorithm>
+#include <functional>
+
+void WorldStreamer::configure(const WorldStreamerSettings& settings)
+{
+    settings_              = settings;
+    settings_.unloadRadius = std::max(settings_.unloadRadius, settings_.loadRadius);
+
+    statistics_      = {};
+    loadedBytes_     = 0;
+    loadedCellCount_ = 0;
+    states_.assign(getCellCount(), CellState::UNLOADED);
+    cellBytes_.assign(getCellCount(), 0);
+    activeCells_.clear();
+}
+
+void WorldStreamer::update(const glm::vec2& focus, WorldStreamingRequests& requests)
+{
+    requests.loads.clear();
+    requests.unloads.clear();
+
+    // loading cells run to the end, once resident they unload like any other cell if the focus left them behind
+    evictable_.clear();
+    for (const uint32_t cell : activeCells_)
+    {
+        if (states_[cell] != CellState::RESIDENT)
+            continue;
+
+        const float distance = getDistance(cell, focus);
+        if (distance > settings_.unloadRadius)
+        {
+            unload(cell, requests);
+        }
+        else
+        {
+            evictable_.emplace_back(distance, cell);
+        }
+    }
+
+    // the cells overlapping the square around the load radius, clamped to the grid. The missing ones within the radius
+    // are candidates
+    const float      halfExtent = 0.5F * static_cast<float>(settings_.cellsPerSide) * settings_.cellSize;
+    const float      lastCell   = static_cast<float>(settings_.cellsPerSide - 1);
+    const glm::uvec2 first {glm::clamp(glm::floor((focus - settings_.loadRadius + halfExtent) / settings_.cellSize),
+                                       0.0F,
+                                       lastCell)};
+    const glm::uvec2 last {glm::clamp(glm::floor((focus + settings_.loadRadius + halfExtent) / settings_.cellSize),
+                                      0.0F,
+                                      lastCell)};
+
+    candidates_.clear();
+    for (uint32_t y = first.y; y <= last.y; y++)
+    {
+        for (uint32_t x = first.x; x <= last.x; x++)
+        {
+            const uint32_t cell     = y * settings_.cellsPerSide + x;
+            const float    distance = getDistance(cell, focus);
+            if (states_[cell] == CellState::UNLOADED && distance <= settings_.loadRadius)
+            {
+                candidates_.emplace_back(distance, cell);
+            }
+        }
+    }
+
+    std::sort(candidates_.begin(), candidates_.end());
+    std::sort(evictable_.begin(), evictable_.end(), std::greater<>());
+
+    // a load that came in larger than its reservation may have gone over, the farthest cells go until it fits again
+    size_t evicted = 0;
+    while (statistics_.usedBytes > settings_.memoryBudget && evicted < evictable_.size())
+    {
+        unload(evictable_[evicted++].second, requests);
+        statistics_.evictionCount++;
+    }
+
+    for (const auto& [distance, cell] : candidates_)
+    {
+        if (statistics_.loadingCellCount >= settings_.maxConcurrentLoads)
+            break;
+
+        // only cells farther than the one being loaded make room, a full budget of nearer cells stops the loads
+        const uint64_t estimate = getLoadEstimate();
+        while (statistics_.usedBytes + estimate > settings_.memoryBudget && evicted < evictable_.size() &&
+               evictable_[evicted].first > distance)
+        {
+            unload(evictable_[evicted++].second, requests);
+            statistics_.evictionCount++;
+        }
+        if (statistics_.usedBytes + estimate > settings_.memoryBudget)
+            break;
+
+        states_[cell]    = CellState::LOADING;
+        cellBytes_[cell] = estimate;
+        activeCells_.push_back(cell);
+        requests.loads.push_back(cell);
+
+        statistics_.usedBytes += estimate;
+        statistics_.loadingCellCount++;
+        statistics_.loadCount++;
+    }
+
+    if (!requests.unloads.empty())
+    {
+        std::erase_if(activeCells_, [this](uint32_t cell) { return states_[cell] == CellState::UNLOADED; });
+    }
+}
+
+void WorldStreamer::finishLoad(uint32_t cell, uint64_t bytes)
+{
+    statistics_.usedBytes = statistics_.usedBytes - cellBytes_[cell] + bytes;
+    statistics_.loadingCellCount--;
+    statistics_.residentCellCount++;
+
+    states_[cell]    = CellState::RESIDENT;
+    cellBytes_[cell] = bytes;
+
+    loadedBytes_ += bytes;
+    loadedCellCount_++;
+}
+
+glm::vec2 WorldStreamer::getCellMin(uint32_t cell) const
+{
+    const float     halfExtent = 0.5F * static_cast<float>(settings_.cellsPerSide) * settings_.cellSize;
+    const glm::vec2 coord {static_cast<float>(cell % settings_.cellsPerSide),
+                          static_cast<float>(cell / settings_.cellsPerSide)};
+    return coord * settings_.cellSize - halfExtent;
+}
+
+float WorldStreamer::getDistance(uint32_t cell, const glm::vec2& focus) const
+{
+    const glm::vec2 halfSize {0.5F * settings_.cellSize};
+    const glm::vec2 center = getCellMin(cell) + halfSize;
+    return glm::length(glm::max(glm::abs(focus - center) - halfSize, 0.0F));
+}
+
+uint64_t WorldStreamer::getLoadEstimate() const
+{
+    // the average of the cells loaded so far, generated content keeps them about the same size
+    return loadedCellCount_ > 0 ? loadedBytes_ / loadedCellCount_ : settings_.initialCellBytes;
+}
+
+void WorldStreamer::unload(uint32_t cell, WorldStreamingRequests& requests)
+{
+    statistics_.usedBytes -= cellBytes_[cell];
+    statistics_.residentCellCount--;
+    statistics_.unloadCount++;
+
+    states_[cell]    = CellState::UNLOADED;
+    cellBytes_[cell] = 0;
+    requests.unloads.push_back(cell);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+struct WorldStreamerSettings
+{
+    uint32_t cellsPerSide {64}; // the grid is centered on the origin
+    float    cellSize {4.0F};
+    float    loadRadius {10.0F};   // cells closer to the focus than this are loaded, nearest first
+    float    unloadRadius {14.0F}; // resident cells only unload beyond this, never less than the load radius
+    uint64_t memoryBudget {64ULL << 20U};    // bytes of the resident cells and the reservations of loading ones
+    uint64_t initialCellBytes {1ULL << 20U}; // reserved per loading cell until the first loads reported their size
+    uint32_t maxConcurrentLoads {4};
+};
+
+// what update decided, the caller starts the loads and drops the unloaded cells
+struct WorldStreamingRequests
+{
+    std::vector<uint32_t> loads; // nearest first
+    std::vector<uint32_t> unloads;
+};
+
+struct WorldStreamerStatistics
+{
+    uint32_t residentCellCount {0};
+    uint32_t loadingCellCount {0};
+    uint64_t usedBytes {0}; // resident cells plus the reservations of the loading ones
+    uint64_t loadCount {0};
+    uint64_t unloadCount {0};
+    uint64_t evictionCount {0}; // unloads within the unload radius that made room for a nearer cell
+};
+
+// Decides which cells of a square grid stay resident around a moving focus, the loading itself is up to the caller.
+// Cells within the load radius are requested nearest first, while resident ones are kept until the focus moved beyond
+// the larger unload radius, so moving back and forth over a cell border does not reload anything. Resident cells and
+// the estimated size of loading ones share a fixed budget, a load that does not fit evicts the farthest resident cells
+// as long as they are farther than the cell it makes room for and waits otherwise. A cell is indexed y * cellsPerSide
+// + x from the corner at the lowest coordinates.
+class WorldStreamer {
+public:
+    void configure(const WorldStreamerSettings& settings);
+
+    // replaces the requests with the cells to start and to stop loading for the focus on the xy plane
+    void update(const glm::vec2& focus, WorldStreamingRequests& requests);
+
+    // a requested cell became resident, from now on its actual size counts against the budget
+    void finishLoad(uint32_t cell, uint64_t bytes);
+
+    [[nodiscard]] glm::vec2 getCellMin(uint32_t cell) const;
+    [[nodiscard]] uint32_t  getCellCount() const { return settings_.cellsPerSide * settings_.cellsPerSide; }
+    [[nodiscard]] float     getCellSize() const { return settings_.cellSize; }
+    [[nodiscard]] bool      isLoading() const { return statistics_.loadingCellCount > 0; }
+
+    [[nodiscard]] const WorldStreamerStatistics& getStatistics() const { return statistics_; }
+
+private:
+    enum class CellState : uint8_t
+    {
+        UNLOADED,
+        LOADING,
+        RESIDENT
+    };
+
+    // zero within the cell, otherwise the distance to its closest point
+    [[nodiscard]] float    getDistance(uint32_t cell, const glm::vec2& focus) const;
+    [[nodiscard]] uint64_t getLoadEstimate() const;
+    void                   unload(uint32_t cell, WorldStreamingRequests& requests);
+
+    WorldStreamerSettings   settings_ {};
+    WorldStreamerStatistics statistics_ {};
+    std::vector<CellState>  states_;
+    std::vector<uint64_t>   cellBytes_;   // actual size of a resident cell, the reservation of a loading one
+    std::vector<uint32_t>   activeCells_; // loading and resident
+    uint64_t                loadedBytes_ {0};
+    uint64_t                loadedCellCount_ {0};
+
+    // update scratch, pairs of distance and cell
+    std::vector<std::pair<float, uint32_t>> candidates_;
+    std::vector<std::pair<float, uint32_t>> evictable_;
+};